@@ -65,4 +65,8 @@ if(DONUT_WITH_MINIZ)
     target_compile_definitions(donut_core PUBLIC DONUT_WITH_MINIZ)
 endif()
 
+if(DONUT_WITH_CPU_PROFILER)
+    target_compile_definitions(donut_core PUBLIC DONUT_WITH_CPU_PROFILER)
+endif()
+
 set_target_properties(donut_core PROPERTIES FOLDER Donut)
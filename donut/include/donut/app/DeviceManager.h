@@ -77,10 +77,15 @@ freely, subject to the following restrictions:
 #include <GLFW/glfw3native.h>
 #include <nvrhi/nvrhi.h>
 #include <donut/core/log.h>
+#include <donut/engine/FrameStatistics.h>
 
+#include <condition_variable>
 #include <list>
+#include <queue>
 #include <functional>
+#include <mutex>
 #include <optional>
+#include <thread>
 
 namespace donut::app
 {
@@ -212,8 +217,14 @@ namespace donut::app
         void AddRenderPassToBack(IRenderPass *pController);
         void RemoveRenderPass(IRenderPass *pController);
 
+        // Runs frames until the window is closed or RequestExit is called.
+        // A headless device renders into an offscreen back buffer of the requested size and format instead of a
+        // swap chain, and no window events are processed.
         void RunMessageLoop();
 
+        // Ends RunMessageLoop after the current frame: closes the window, or stops the loop of a headless device.
+        void RequestExit();
+
         // returns the size of the window in screen coordinates
         void GetWindowDimensions(int& width, int& height);
         // returns the screen coordinate to pixel coordinate scale factor
@@ -249,10 +260,39 @@ namespace donut::app
         double m_FrameTimeSum = 0.0;
         int m_NumberOfAccumulatedFrames = 0;
 
+        // Per-frame CPU timings of every rendered frame, in milliseconds
+        engine::FrameStatistics m_FrameStatistics;
+        engine::FrameStatistics::ChannelId m_FrameTimeChannel = 0;
+        engine::FrameStatistics::ChannelId m_AnimateChannel = 0;
+        engine::FrameStatistics::ChannelId m_RenderChannel = 0;
+        engine::FrameStatistics::ChannelId m_PresentChannel = 0;
+
         uint32_t m_FrameIndex = 0;
 
+        // Pipelined simulation: Animate of frame N+1 runs on m_SimulationThread while frame N is rendered.
+        // All m_Simulation* fields except the thread are protected by m_SimulationMutex.
+        bool m_RequestedPipelinedSimulation = false;
+        bool m_PipelinedSimulation = false;
+        std::thread m_SimulationThread;
+        std::mutex m_SimulationMutex;
+        std::condition_variable m_SimulationCondition;
+        bool m_SimulationRequested = false;
+        bool m_SimulationQuit = false;
+        uint32_t m_SimulationFrameIndex = 0;
+        double m_SimulationElapsedTime = 0.0;
+        double m_SimulationTime = 0.0;
+        // simulated frame that has not been rendered yet
+        std::optional<uint32_t> m_PendingRenderFrame;
+
         std::vector<nvrhi::FramebufferHandle> m_SwapChainFramebuffers;
 
+        // Headless devices: offscreen back buffer, and the queries that limit the frames in flight in place of Present
+        bool m_ExitRequested = false;
+        nvrhi::TextureHandle m_HeadlessBackBuffer;
+        nvrhi::FramebufferHandle m_HeadlessFramebuffer;
+        std::queue<nvrhi::EventQueryHandle> m_HeadlessFramesInFlight;
+        std::vector<nvrhi::EventQueryHandle> m_HeadlessQueryPool;
+
         DeviceManager();
 
         void UpdateWindowSize();
@@ -262,9 +302,19 @@ namespace donut::app
         void BackBufferResized();
 
         void Animate(double elapsedTime);
+        void AnimatePasses(double elapsedTime, bool simulationThread);
+        void CommitSimulation(uint32_t frameIndex);
         void Render();
         void UpdateAverageFrameTime(double elapsedTime);
         bool AnimateRenderPresent();
+        bool RenderPresent(uint32_t frameIndex, double elapsedTime, double animateTime);
+        bool PipelinedAnimateRenderPresent(double elapsedTime);
+        void SimulationThreadProc();
+        void KickSimulation(uint32_t frameIndex, double elapsedTime);
+        void WaitForSimulation();
+        void StopSimulationThread();
+        void CreateHeadlessBackBuffer();
+        bool PresentHeadless();
         // device-specific methods
         virtual bool CreateInstanceInternal() = 0;
         virtual bool CreateDevice() = 0;
@@ -283,10 +333,18 @@ namespace donut::app
         [[nodiscard]] double GetAverageFrameTimeSeconds() const { return m_AverageFrameTime; }
         [[nodiscard]] double GetPreviousFrameTimestamp() const { return m_PreviousFrameTimestamp; }
         void SetFrameTimeUpdateInterval(double seconds) { m_AverageTimeUpdateInterval = seconds; }
+        // Frame time, simulation (Animate), render submission and present times of every rendered frame.
+        // Applications can add their own channels, e.g. for latency values reported by the driver.
+        [[nodiscard]] engine::FrameStatistics& GetFrameStatistics() { return m_FrameStatistics; }
         [[nodiscard]] bool IsVsyncEnabled() const { return m_DeviceParams.vsyncEnabled; }
         virtual void SetVsyncEnabled(bool enabled) { m_RequestedVSync = enabled; /* will be processed later */ }
         virtual void ReportLiveObjects() {}
         void SetEnableRenderDuringWindowMovement(bool val) {m_EnableRenderDuringWindowMovement = val;} 
+        // Runs Animate of the render passes that return true from IRenderPass::AnimateOnSimulationThread
+        // on a separate thread, so that the simulation of frame N+1 overlaps rendering and presenting frame N.
+        // The change takes effect at the start of the next frame; render passes must not be added or removed while it's enabled.
+        void SetPipelinedSimulationEnabled(bool enabled) { m_RequestedPipelinedSimulation = enabled; }
+        [[nodiscard]] bool IsPipelinedSimulationEnabled() const { return m_RequestedPipelinedSimulation; }
 
         // these are public in order to be called from the GLFW callback functions
         void WindowCloseCallback() { }
@@ -364,6 +422,13 @@ namespace donut::app
         virtual bool ShouldRenderUnfocused() { return false; }
         virtual void Render(nvrhi::IFramebuffer* framebuffer) { }
         virtual void Animate(float fElapsedTimeSeconds) { }
+        // Passes returning true are animated on the simulation thread when pipelined simulation is enabled,
+        // concurrently with Render of the previous frame. Their Animate must only write simulation state,
+        // which is then published to the renderer in CommitSimulation.
+        virtual bool AnimateOnSimulationThread() { return false; }
+        // Called on the render thread after the given frame has been simulated and before it is rendered,
+        // while the simulation thread is idle. Also called in the non-pipelined mode, right after Animate.
+        virtual void CommitSimulation(uint32_t frameIndex) { }
         virtual void BackBufferResizing() { }
         virtual void BackBufferResized(const uint32_t width, const uint32_t height, const uint32_t sampleCount) { }
 
@@ -74,17 +74,32 @@ namespace donut::app
         nvrhi::TextureHandle fontTexture;
         nvrhi::SamplerHandle fontSampler;
 
+        // The geometry buffers are CPU-visible rings of c_NumFrameSlots regions, one per frame in flight.
+        // Every frame, the vertices and indices that are drawn are written directly into the next region,
+        // once the GPU has finished the frame that last used it.
+        static constexpr uint32_t c_NumFrameSlots = 3;
         nvrhi::BufferHandle vertexBuffer;
         nvrhi::BufferHandle indexBuffer;
+        size_t vertexSlotCapacity = 0; // in vertices, per region
+        size_t indexSlotCapacity = 0;  // in indices, per region
+        uint32_t frameSlot = 0;
+        nvrhi::EventQueryHandle frameSlotQueries[c_NumFrameSlots];
+        uint64_t frameIndex = 0;
 
         nvrhi::BindingLayoutHandle bindingLayout;
         nvrhi::GraphicsPipelineDesc basePSODesc;
 
         nvrhi::GraphicsPipelineHandle pso;
-        std::unordered_map<nvrhi::ITexture*, nvrhi::BindingSetHandle> bindingsCache;
 
-        std::vector<ImDrawVert> vtxBuffer;
-        std::vector<ImDrawIdx> idxBuffer;
+        // Binding sets hold references to their textures, so the ones that haven't been drawn
+        // for c_BindingSetLifetime frames are evicted to let released textures go.
+        static constexpr uint64_t c_BindingSetLifetime = 300;
+        struct CachedBindingSet
+        {
+            nvrhi::BindingSetHandle bindingSet;
+            uint64_t lastUsedFrame = 0;
+        };
+        std::unordered_map<nvrhi::ITexture*, CachedBindingSet> bindingsCache;
 
         bool init(nvrhi::DeviceHandle renderer, std::shared_ptr<engine::ShaderFactory> shaderFactory);
         bool beginFrame(float elapsedTimeSeconds);
@@ -92,12 +107,13 @@ namespace donut::app
         void backbufferResizing();
 
     private:
-        bool reallocateBuffer(nvrhi::BufferHandle& buffer, size_t requiredSize, size_t reallocateSize, bool isIndexBuffer);
+        bool reallocateBuffer(nvrhi::BufferHandle& buffer, size_t& slotCapacity, size_t requiredCount, size_t elementSize, bool isIndexBuffer);
 
         bool createFontTexture(nvrhi::ICommandList* commandList);
 
         nvrhi::IGraphicsPipeline* getPSO(nvrhi::IFramebuffer* fb);
         nvrhi::IBindingSet* getBindingSet(nvrhi::ITexture* texture);
-        bool updateGeometry(nvrhi::ICommandList* commandList);
+        bool updateGeometry(uint64_t& vertexOffset, uint64_t& indexOffset);
+        void evictBindingSets();
     };
 }
\ No newline at end of file
@@ -196,15 +196,27 @@ namespace donut::math
 
 	// Affine composition (row-vector math)
 
+	namespace scalar
+	{
+		template <typename T, int n>
+		affine<T, n> multiply(affine<T, n> const & a, affine<T, n> const & b)
+		{
+			affine<T, n> result =
+			{
+				a.m_linear * b.m_linear,
+				a.m_translation * b.m_linear + b.m_translation
+			};
+			return result;
+		}
+	}
+
 	template <typename T, int n>
 	affine<T, n> operator * (affine<T, n> const & a, affine<T, n> const & b)
 	{
-		affine<T, n> result =
-		{
-			a.m_linear * b.m_linear,
-			a.m_translation * b.m_linear + b.m_translation
-		};
-		return result;
+		if constexpr (n == 3 && simd::IsAccelerated<T>)
+			return simd::multiply(a, b);
+		else
+			return scalar::multiply(a, b);
 	}
 
 	template <typename T, int n>
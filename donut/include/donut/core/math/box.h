@@ -24,6 +24,12 @@
 
 namespace donut::math
 {
+    namespace scalar
+    {
+        template <typename T, int n>
+        box<T, n> transform(box<T, n> const & a, affine<T, n> const & transform);
+    }
+
 	// Generic axis-aligned bounding box (AABB) struct, in mins/maxs form
 	// Note: min > max (on any axis) is an empty (null) box.  All empty boxes are the same.
 	// min == max is a box containing only one point along that axis.
@@ -198,20 +204,10 @@ namespace donut::math
 
         box operator * (const affine<T, n>& transform) const
         {
-            // fast method to apply an affine transform to an AABB
-            box<T, n> result;
-            result.m_mins = transform.m_translation;
-            result.m_maxs = transform.m_translation;
-            const vector<T, n>* row = &transform.m_linear.row0;
-            for (int i = 0; i < n; i++)
-            {
-                vector<T, n> e = (&m_mins.x)[i] * *row;
-                vector<T, n> f = (&m_maxs.x)[i] * *row;
-                result.m_mins += min(e, f);
-                result.m_maxs += max(e, f);
-                ++row;
-            }
-            return result;
+            if constexpr (n == 3 && simd::IsAccelerated<T>)
+                return simd::transform(*this, transform);
+            else
+                return scalar::transform(*this, transform);
         }
 
         box operator *= (const affine<T, n>& transform) const
@@ -232,6 +228,28 @@ namespace donut::math
     };
 
 	
+    namespace scalar
+    {
+        // Fast method to apply an affine transform to an AABB, reference implementation
+        template <typename T, int n>
+        box<T, n> transform(box<T, n> const & a, affine<T, n> const & transform)
+        {
+            box<T, n> result;
+            result.m_mins = transform.m_translation;
+            result.m_maxs = transform.m_translation;
+            const vector<T, n>* row = &transform.m_linear.row0;
+            for (int i = 0; i < n; i++)
+            {
+                vector<T, n> e = (&a.m_mins.x)[i] * *row;
+                vector<T, n> f = (&a.m_maxs.x)[i] * *row;
+                result.m_mins += min(e, f);
+                result.m_maxs += max(e, f);
+                ++row;
+            }
+            return result;
+        }
+    }
+
 	// Concrete boxes for the most common types and dimensions
 
 #define DEFINE_CONCRETE_BOXES(type, name, ptype) \
@@ -564,15 +564,28 @@ namespace donut::math
 
 	// Matrix multiplication
 
+	namespace scalar
+	{
+		// Reference implementation, also used for the types that have no SIMD version
+		template <typename T, int rows, int inner, int cols>
+		matrix<T, rows, cols> multiply(matrix<T, rows, inner> const & a, matrix<T, inner, cols> const & b)
+		{
+			auto result = matrix<T, rows, cols>::zero();
+			for (int i = 0; i < rows; ++i)
+				for (int j = 0; j < cols; ++j)
+					for (int k = 0; k < inner; ++k)
+						result[i][j] += a[i][k] * b[k][j];
+			return result;
+		}
+	}
+
 	template <typename T, int rows, int inner, int cols>
 	matrix<T, rows, cols> operator * (matrix<T, rows, inner> const & a, matrix<T, inner, cols> const & b)
 	{
-		auto result = matrix<T, rows, cols>::zero();
-		for (int i = 0; i < rows; ++i)
-			for (int j = 0; j < cols; ++j)
-				for (int k = 0; k < inner; ++k)
-					result[i][j] += a[i][k] * b[k][j];
-		return result;
+		if constexpr (rows == 4 && inner == 4 && cols == 4 && simd::IsAccelerated<T>)
+			return simd::multiply(a, b);
+		else
+			return scalar::multiply(a, b);
 	}
 
 	template <typename T, int rows, int cols>
@@ -686,57 +699,69 @@ namespace donut::math
 		return oddpart * evenpart;
 	}
 
-	template <typename T, int n>
-	matrix<T, n, n> inverse(matrix<T, n, n> const & m)
+	namespace scalar
 	{
-		// Calculate inverse using Gaussian elimination
-
-		matrix<T, n, n> a = m;
-		auto b = matrix<T, n, n>::identity();
-
-		// Loop through columns
-		for (int j = 0; j < n; ++j)
+		template <typename T, int n>
+		matrix<T, n, n> inverse(matrix<T, n, n> const & m)
 		{
-			// Select pivot element: maximum magnitude in this column at or below main diagonal
-			int pivot = j;
-			for (int i = j+1; i < n; ++i)
-				if (abs(a[i][j]) > abs(a[pivot][j]))
-					pivot = i;
-			if (abs(a[pivot][j]) < epsilon)
-				return matrix<T, n, n>(NaN);
+			// Calculate inverse using Gaussian elimination
 
-			// Interchange rows to put pivot element on the diagonal,
-			// if it is not already there
-			if (pivot != j)
-			{
-				std::swap(a[j], a[pivot]);
-                std::swap(b[j], b[pivot]);
-			}
+			matrix<T, n, n> a = m;
+			auto b = matrix<T, n, n>::identity();
 
-			// Divide the whole row by the pivot element
-			if (a[j][j] != T(1))								// Skip if already equal to 1
+			// Loop through columns
+			for (int j = 0; j < n; ++j)
 			{
-				T scale = a[j][j];
-				a[j] /= scale;
-				b[j] /= scale;
-				// Now the pivot element has become 1
-			}
+				// Select pivot element: maximum magnitude in this column at or below main diagonal
+				int pivot = j;
+				for (int i = j+1; i < n; ++i)
+					if (abs(a[i][j]) > abs(a[pivot][j]))
+						pivot = i;
+				if (abs(a[pivot][j]) < epsilon)
+					return matrix<T, n, n>(NaN);
+
+				// Interchange rows to put pivot element on the diagonal,
+				// if it is not already there
+				if (pivot != j)
+				{
+					std::swap(a[j], a[pivot]);
+					std::swap(b[j], b[pivot]);
+				}
 
-			// Subtract this row from others to make the rest of column j zero
-			for (int i = 0; i < n; ++i)
-			{
-				if ((i != j) && (abs(a[i][j]) > epsilon))		// skip rows already zero
+				// Divide the whole row by the pivot element
+				if (a[j][j] != T(1))								// Skip if already equal to 1
 				{
-					T scale = -a[i][j];
-					a[i] += a[j] * scale;
-					b[i] += b[j] * scale;
+					T scale = a[j][j];
+					a[j] /= scale;
+					b[j] /= scale;
+					// Now the pivot element has become 1
+				}
+
+				// Subtract this row from others to make the rest of column j zero
+				for (int i = 0; i < n; ++i)
+				{
+					if ((i != j) && (abs(a[i][j]) > epsilon))		// skip rows already zero
+					{
+						T scale = -a[i][j];
+						a[i] += a[j] * scale;
+						b[i] += b[j] * scale;
+					}
 				}
 			}
-		}
 	
-		// At this point, a should have been transformed to the identity matrix,
-		// and b should have been transformed into the inverse of the original a.
-		return b;
+			// At this point, a should have been transformed to the identity matrix,
+			// and b should have been transformed into the inverse of the original a.
+			return b;
+		}
+	}
+
+	template <typename T, int n>
+	matrix<T, n, n> inverse(matrix<T, n, n> const & m)
+	{
+		if constexpr (n == 4 && simd::IsAccelerated<T>)
+			return simd::inverse(m);
+		else
+			return scalar::inverse(m);
 	}
 
 	// Inverse specialization for 2x2
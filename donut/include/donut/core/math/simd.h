@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Selection of the SIMD backend used by the math library for its hottest operations:
+// affine and 4x4 matrix products, 4x4 matrix inverse and AABB transforms.
+// The generic templates keep the reference implementations in the dm::scalar namespace
+// and dispatch to the dm::simd overloads declared here when the type is accelerated.
+// Define DONUT_MATH_NO_SIMD before including math.h to force the scalar code paths.
+
+#if !defined(DONUT_MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DONUT_MATH_SSE2 1
+#include <emmintrin.h>
+#else
+#define DONUT_MATH_SSE2 0
+#endif
+
+#if DONUT_MATH_SSE2 && defined(__AVX__)
+#define DONUT_MATH_AVX 1
+#include <immintrin.h>
+#else
+#define DONUT_MATH_AVX 0
+#endif
+
+#if !defined(DONUT_MATH_NO_SIMD) && !DONUT_MATH_SSE2 && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define DONUT_MATH_NEON 1
+#include <arm_neon.h>
+#else
+#define DONUT_MATH_NEON 0
+#endif
+
+// Double precision NEON is only available on AArch64
+#if DONUT_MATH_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+#define DONUT_MATH_NEON64 1
+#else
+#define DONUT_MATH_NEON64 0
+#endif
+
+namespace donut::math
+{
+	template <typename T, int rows, int cols> struct matrix;
+	template <typename T, int n> struct affine;
+	template <typename T, int n> struct box;
+
+	namespace simd
+	{
+		// True when the SIMD overloads below are implemented for the scalar type T
+		template <typename T>
+		constexpr bool IsAccelerated = false;
+
+#if DONUT_MATH_SSE2 || DONUT_MATH_NEON
+		template <>
+		constexpr bool IsAccelerated<float> = true;
+#endif
+#if DONUT_MATH_SSE2 || DONUT_MATH_NEON64
+		template <>
+		constexpr bool IsAccelerated<double> = true;
+#endif
+
+		// Name of the active backend, for logging and benchmarks
+		constexpr const char* BackendName =
+#if DONUT_MATH_AVX
+			"AVX";
+#elif DONUT_MATH_SSE2
+			"SSE2";
+#elif DONUT_MATH_NEON
+			"NEON";
+#else
+			"scalar";
+#endif
+
+		// The overloads are defined in simd_impl.h, which is included at the end of math.h.
+		// They produce the same results as their dm::scalar counterparts, except that
+		// compilers may contract the scalar code into FMA instructions on some targets,
+		// and the inverse which is only equal within rounding errors.
+
+		inline affine<float, 3> multiply(affine<float, 3> const& a, affine<float, 3> const& b);
+		inline affine<double, 3> multiply(affine<double, 3> const& a, affine<double, 3> const& b);
+
+		inline matrix<float, 4, 4> multiply(matrix<float, 4, 4> const& a, matrix<float, 4, 4> const& b);
+		inline matrix<double, 4, 4> multiply(matrix<double, 4, 4> const& a, matrix<double, 4, 4> const& b);
+
+		inline matrix<float, 4, 4> inverse(matrix<float, 4, 4> const& m);
+		inline matrix<double, 4, 4> inverse(matrix<double, 4, 4> const& m);
+
+		inline box<float, 3> transform(box<float, 3> const& a, affine<float, 3> const& transform);
+		inline box<double, 3> transform(box<double, 3> const& a, affine<double, 3> const& transform);
+	}
+}
@@ -0,0 +1,391 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Definitions of the SIMD math overloads declared in simd.h.
+// Every kernel is written once against a small 4-lane vector type, Vec4f or Vec4d,
+// and the backends only provide these vector types. The kernels perform the same
+// operations in the same order as the scalar templates, so that results match,
+// except for the 4x4 inverse that uses a faster algorithm than Gaussian elimination.
+
+namespace donut::math::simd::detail
+{
+#if DONUT_MATH_SSE2
+
+	struct Vec4f
+	{
+		__m128 v;
+
+		static Vec4f load(const float* p) { return { _mm_loadu_ps(p) }; }
+		static Vec4f load3(const float* p)
+		{
+			const __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+			return { _mm_movelh_ps(xy, _mm_load_ss(p + 2)) };
+		}
+		static Vec4f set(float x, float y, float z, float w) { return { _mm_setr_ps(x, y, z, w) }; }
+		static Vec4f splat(float a) { return { _mm_set1_ps(a) }; }
+		void store(float* p) const { _mm_storeu_ps(p, v); }
+	};
+
+	// Stores the first 3 elements of a and b into 6 consecutive floats,
+	// with wide stores that can be forwarded to the loads reading the result
+	inline void store3x2(float* p, Vec4f a, Vec4f b)
+	{
+		const __m128 ab = _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(0, 0, 2, 2));
+		_mm_storeu_ps(p, _mm_shuffle_ps(a.v, ab, _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storel_pi(reinterpret_cast<__m64*>(p + 4), _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(3, 3, 2, 1)));
+	}
+
+	inline Vec4f operator + (Vec4f a, Vec4f b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline Vec4f operator - (Vec4f a, Vec4f b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline Vec4f operator * (Vec4f a, Vec4f b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline Vec4f operator / (Vec4f a, Vec4f b) { return { _mm_div_ps(a.v, b.v) }; }
+	// Same operand order as the scalar min(a, b) = (a < b) ? a : b and max(a, b) = (a < b) ? b : a
+	inline Vec4f vmin(Vec4f a, Vec4f b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline Vec4f vmax(Vec4f a, Vec4f b) { return { _mm_max_ps(b.v, a.v) }; }
+
+#if DONUT_MATH_AVX
+
+	struct Vec4d
+	{
+		__m256d v;
+
+		static Vec4d load(const double* p) { return { _mm256_loadu_pd(p) }; }
+		static Vec4d load3(const double* p) { return { _mm256_setr_pd(p[0], p[1], p[2], 0.0) }; }
+		static Vec4d set(double x, double y, double z, double w) { return { _mm256_setr_pd(x, y, z, w) }; }
+		static Vec4d splat(double a) { return { _mm256_set1_pd(a) }; }
+		void store(double* p) const { _mm256_storeu_pd(p, v); }
+	};
+
+	inline void store3x2(double* p, Vec4d a, Vec4d b)
+	{
+		const __m128d alo = _mm256_castpd256_pd128(a.v), ahi = _mm256_extractf128_pd(a.v, 1);
+		const __m128d blo = _mm256_castpd256_pd128(b.v), bhi = _mm256_extractf128_pd(b.v, 1);
+		_mm_storeu_pd(p, alo);
+		_mm_storeu_pd(p + 2, _mm_unpacklo_pd(ahi, blo));
+		_mm_storeu_pd(p + 4, _mm_shuffle_pd(blo, bhi, 1));
+	}
+
+	inline Vec4d operator + (Vec4d a, Vec4d b) { return { _mm256_add_pd(a.v, b.v) }; }
+	inline Vec4d operator - (Vec4d a, Vec4d b) { return { _mm256_sub_pd(a.v, b.v) }; }
+	inline Vec4d operator * (Vec4d a, Vec4d b) { return { _mm256_mul_pd(a.v, b.v) }; }
+	inline Vec4d operator / (Vec4d a, Vec4d b) { return { _mm256_div_pd(a.v, b.v) }; }
+	inline Vec4d vmin(Vec4d a, Vec4d b) { return { _mm256_min_pd(a.v, b.v) }; }
+	inline Vec4d vmax(Vec4d a, Vec4d b) { return { _mm256_max_pd(b.v, a.v) }; }
+
+#else
+
+	struct Vec4d
+	{
+		__m128d lo, hi;
+
+		static Vec4d load(const double* p) { return { _mm_loadu_pd(p), _mm_loadu_pd(p + 2) }; }
+		static Vec4d load3(const double* p) { return { _mm_loadu_pd(p), _mm_load_sd(p + 2) }; }
+		static Vec4d set(double x, double y, double z, double w) { return { _mm_setr_pd(x, y), _mm_setr_pd(z, w) }; }
+		static Vec4d splat(double a) { return { _mm_set1_pd(a), _mm_set1_pd(a) }; }
+		void store(double* p) const { _mm_storeu_pd(p, lo); _mm_storeu_pd(p + 2, hi); }
+	};
+
+	inline void store3x2(double* p, Vec4d a, Vec4d b)
+	{
+		_mm_storeu_pd(p, a.lo);
+		_mm_storeu_pd(p + 2, _mm_unpacklo_pd(a.hi, b.lo));
+		_mm_storeu_pd(p + 4, _mm_shuffle_pd(b.lo, b.hi, 1));
+	}
+
+	inline Vec4d operator + (Vec4d a, Vec4d b) { return { _mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi) }; }
+	inline Vec4d operator - (Vec4d a, Vec4d b) { return { _mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi) }; }
+	inline Vec4d operator * (Vec4d a, Vec4d b) { return { _mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi) }; }
+	inline Vec4d operator / (Vec4d a, Vec4d b) { return { _mm_div_pd(a.lo, b.lo), _mm_div_pd(a.hi, b.hi) }; }
+	inline Vec4d vmin(Vec4d a, Vec4d b) { return { _mm_min_pd(a.lo, b.lo), _mm_min_pd(a.hi, b.hi) }; }
+	inline Vec4d vmax(Vec4d a, Vec4d b) { return { _mm_max_pd(b.lo, a.lo), _mm_max_pd(b.hi, a.hi) }; }
+
+#endif // DONUT_MATH_AVX
+
+#elif DONUT_MATH_NEON
+
+	struct Vec4f
+	{
+		float32x4_t v;
+
+		static Vec4f load(const float* p) { return { vld1q_f32(p) }; }
+		static Vec4f load3(const float* p) { return { vcombine_f32(vld1_f32(p), vld1_lane_f32(p + 2, vdup_n_f32(0.f), 0)) }; }
+		static Vec4f set(float x, float y, float z, float w) { const float v[4] = { x, y, z, w }; return { vld1q_f32(v) }; }
+		static Vec4f splat(float a) { return { vdupq_n_f32(a) }; }
+		void store(float* p) const { vst1q_f32(p, v); }
+	};
+
+	inline void store3x2(float* p, Vec4f a, Vec4f b)
+	{
+		vst1q_f32(p, vsetq_lane_f32(vgetq_lane_f32(b.v, 0), a.v, 3));
+		vst1_f32(p + 4, vget_low_f32(vextq_f32(b.v, b.v, 1)));
+	}
+
+	inline Vec4f operator + (Vec4f a, Vec4f b) { return { vaddq_f32(a.v, b.v) }; }
+	inline Vec4f operator - (Vec4f a, Vec4f b) { return { vsubq_f32(a.v, b.v) }; }
+	inline Vec4f operator * (Vec4f a, Vec4f b) { return { vmulq_f32(a.v, b.v) }; }
+#if DONUT_MATH_NEON64
+	inline Vec4f operator / (Vec4f a, Vec4f b) { return { vdivq_f32(a.v, b.v) }; }
+#else
+	inline Vec4f operator / (Vec4f a, Vec4f b)
+	{
+		// ARMv7 NEON has no division instruction
+		float x[4], y[4];
+		vst1q_f32(x, a.v);
+		vst1q_f32(y, b.v);
+		for (int i = 0; i < 4; i++)
+			x[i] /= y[i];
+		return { vld1q_f32(x) };
+	}
+#endif
+	// vminq/vmaxq treat NaNs and signed zeros differently from the scalar code, use compare and select
+	inline Vec4f vmin(Vec4f a, Vec4f b) { return { vbslq_f32(vcltq_f32(a.v, b.v), a.v, b.v) }; }
+	inline Vec4f vmax(Vec4f a, Vec4f b) { return { vbslq_f32(vcltq_f32(a.v, b.v), b.v, a.v) }; }
+
+#if DONUT_MATH_NEON64
+
+	struct Vec4d
+	{
+		float64x2_t lo, hi;
+
+		static Vec4d load(const double* p) { return { vld1q_f64(p), vld1q_f64(p + 2) }; }
+		static Vec4d load3(const double* p) { return { vld1q_f64(p), vld1q_lane_f64(p + 2, vdupq_n_f64(0.0), 0) }; }
+		static Vec4d set(double x, double y, double z, double w)
+		{
+			return { vcombine_f64(vdup_n_f64(x), vdup_n_f64(y)), vcombine_f64(vdup_n_f64(z), vdup_n_f64(w)) };
+		}
+		static Vec4d splat(double a) { return { vdupq_n_f64(a), vdupq_n_f64(a) }; }
+		void store(double* p) const { vst1q_f64(p, lo); vst1q_f64(p + 2, hi); }
+	};
+
+	inline void store3x2(double* p, Vec4d a, Vec4d b)
+	{
+		vst1q_f64(p, a.lo);
+		vst1q_f64(p + 2, vcombine_f64(vget_low_f64(a.hi), vget_low_f64(b.lo)));
+		vst1q_f64(p + 4, vextq_f64(b.lo, b.hi, 1));
+	}
+
+	inline Vec4d operator + (Vec4d a, Vec4d b) { return { vaddq_f64(a.lo, b.lo), vaddq_f64(a.hi, b.hi) }; }
+	inline Vec4d operator - (Vec4d a, Vec4d b) { return { vsubq_f64(a.lo, b.lo), vsubq_f64(a.hi, b.hi) }; }
+	inline Vec4d operator * (Vec4d a, Vec4d b) { return { vmulq_f64(a.lo, b.lo), vmulq_f64(a.hi, b.hi) }; }
+	inline Vec4d operator / (Vec4d a, Vec4d b) { return { vdivq_f64(a.lo, b.lo), vdivq_f64(a.hi, b.hi) }; }
+	inline Vec4d vmin(Vec4d a, Vec4d b)
+	{
+		return { vbslq_f64(vcltq_f64(a.lo, b.lo), a.lo, b.lo), vbslq_f64(vcltq_f64(a.hi, b.hi), a.hi, b.hi) };
+	}
+	inline Vec4d vmax(Vec4d a, Vec4d b)
+	{
+		return { vbslq_f64(vcltq_f64(a.lo, b.lo), b.lo, a.lo), vbslq_f64(vcltq_f64(a.hi, b.hi), b.hi, a.hi) };
+	}
+
+#endif // DONUT_MATH_NEON64
+
+#endif // DONUT_MATH_NEON
+
+	template <typename T> struct VecSelector;
+#if DONUT_MATH_SSE2 || DONUT_MATH_NEON
+	template <> struct VecSelector<float> { typedef Vec4f type; };
+#endif
+#if DONUT_MATH_SSE2 || DONUT_MATH_NEON64
+	template <> struct VecSelector<double> { typedef Vec4d type; };
+#endif
+
+	template <typename T>
+	using Vec4 = typename VecSelector<T>::type;
+
+	// Generic kernels
+
+	template <typename T>
+	affine<T, 3> multiplyAffine(affine<T, 3> const& a, affine<T, 3> const& b)
+	{
+		using V = Vec4<T>;
+		// The rows of the linear part are followed by other members of the affine,
+		// so they can be loaded as 4-element vectors whose last element is ignored
+		const V b0 = V::load(&b.m_linear.row0.x);
+		const V b1 = V::load(&b.m_linear.row1.x);
+		const V b2 = V::load(&b.m_linear.row2.x);
+
+		// Linear part: the generic matrix product accumulates into a zero matrix
+		V rows[3];
+		for (int i = 0; i < 3; i++)
+		{
+			const vector<T, 3>& row = a.m_linear[i];
+			rows[i] = V::splat(T(0)) + V::splat(row.x) * b0;
+			rows[i] = rows[i] + V::splat(row.y) * b1;
+			rows[i] = rows[i] + V::splat(row.z) * b2;
+		}
+
+		// Translation: vector-matrix product followed by the translation of b
+		const vector<T, 3>& t = a.m_translation;
+		V translation = V::splat(t.x) * b0 + V::splat(t.y) * b1;
+		translation = translation + V::splat(t.z) * b2;
+		translation = translation + V::load3(&b.m_translation.x);
+
+		// The 12 elements of the result are consecutive
+		affine<T, 3> result;
+		store3x2(&result.m_linear.row0.x, rows[0], rows[1]);
+		store3x2(&result.m_linear.row2.x, rows[2], translation);
+		return result;
+	}
+
+	template <typename T>
+	matrix<T, 4, 4> multiplyMatrix4x4(matrix<T, 4, 4> const& a, matrix<T, 4, 4> const& b)
+	{
+		using V = Vec4<T>;
+		const V b0 = V::load(b.m_data);
+		const V b1 = V::load(b.m_data + 4);
+		const V b2 = V::load(b.m_data + 8);
+		const V b3 = V::load(b.m_data + 12);
+
+		matrix<T, 4, 4> result;
+		for (int i = 0; i < 4; i++)
+		{
+			const T* row = a.m_data + i * 4;
+			V sum = V::splat(T(0)) + V::splat(row[0]) * b0;
+			sum = sum + V::splat(row[1]) * b1;
+			sum = sum + V::splat(row[2]) * b2;
+			sum = sum + V::splat(row[3]) * b3;
+			sum.store(result.m_data + i * 4);
+		}
+		return result;
+	}
+
+	template <typename T>
+	matrix<T, 4, 4> inverseMatrix4x4(matrix<T, 4, 4> const& m)
+	{
+		// Inverse through the adjugate matrix, computed with 2x2 sub-determinants.
+		// This is much faster than the Gaussian elimination of scalar::inverse because it has no branches,
+		// but it is less robust, so it's only used for well-conditioned matrices, see below.
+
+		using V = Vec4<T>;
+		auto e = [&m](int i, int j) { return m.m_data[i * 4 + j]; };
+
+		const V fac0 = V::set(e(2, 2), e(2, 2), e(1, 2), e(1, 2)) * V::set(e(3, 3), e(3, 3), e(3, 3), e(2, 3))
+			- V::set(e(3, 2), e(3, 2), e(3, 2), e(2, 2)) * V::set(e(2, 3), e(2, 3), e(1, 3), e(1, 3));
+		const V fac1 = V::set(e(2, 1), e(2, 1), e(1, 1), e(1, 1)) * V::set(e(3, 3), e(3, 3), e(3, 3), e(2, 3))
+			- V::set(e(3, 1), e(3, 1), e(3, 1), e(2, 1)) * V::set(e(2, 3), e(2, 3), e(1, 3), e(1, 3));
+		const V fac2 = V::set(e(2, 1), e(2, 1), e(1, 1), e(1, 1)) * V::set(e(3, 2), e(3, 2), e(3, 2), e(2, 2))
+			- V::set(e(3, 1), e(3, 1), e(3, 1), e(2, 1)) * V::set(e(2, 2), e(2, 2), e(1, 2), e(1, 2));
+		const V fac3 = V::set(e(2, 0), e(2, 0), e(1, 0), e(1, 0)) * V::set(e(3, 3), e(3, 3), e(3, 3), e(2, 3))
+			- V::set(e(3, 0), e(3, 0), e(3, 0), e(2, 0)) * V::set(e(2, 3), e(2, 3), e(1, 3), e(1, 3));
+		const V fac4 = V::set(e(2, 0), e(2, 0), e(1, 0), e(1, 0)) * V::set(e(3, 2), e(3, 2), e(3, 2), e(2, 2))
+			- V::set(e(3, 0), e(3, 0), e(3, 0), e(2, 0)) * V::set(e(2, 2), e(2, 2), e(1, 2), e(1, 2));
+		const V fac5 = V::set(e(2, 0), e(2, 0), e(1, 0), e(1, 0)) * V::set(e(3, 1), e(3, 1), e(3, 1), e(2, 1))
+			- V::set(e(3, 0), e(3, 0), e(3, 0), e(2, 0)) * V::set(e(2, 1), e(2, 1), e(1, 1), e(1, 1));
+
+		const V vec0 = V::set(e(1, 0), e(0, 0), e(0, 0), e(0, 0));
+		const V vec1 = V::set(e(1, 1), e(0, 1), e(0, 1), e(0, 1));
+		const V vec2 = V::set(e(1, 2), e(0, 2), e(0, 2), e(0, 2));
+		const V vec3 = V::set(e(1, 3), e(0, 3), e(0, 3), e(0, 3));
+
+		const V signA = V::set(T(1), T(-1), T(1), T(-1));
+		const V signB = V::set(T(-1), T(1), T(-1), T(1));
+
+		// Rows of the adjugate matrix
+		const V inv0 = (vec1 * fac0 - vec2 * fac1 + vec3 * fac2) * signA;
+		const V inv1 = (vec0 * fac0 - vec2 * fac3 + vec3 * fac4) * signB;
+		const V inv2 = (vec0 * fac1 - vec1 * fac3 + vec3 * fac5) * signA;
+		const V inv3 = (vec0 * fac2 - vec1 * fac4 + vec2 * fac5) * signB;
+
+		// Determinant: dot product of the first row of m with the first column of the adjugate
+		T adjugate[4][4];
+		inv0.store(adjugate[0]);
+		inv1.store(adjugate[1]);
+		inv2.store(adjugate[2]);
+		inv3.store(adjugate[3]);
+		const T determinant = (e(0, 0) * adjugate[0][0] + e(0, 1) * adjugate[1][0])
+			+ (e(0, 2) * adjugate[2][0] + e(0, 3) * adjugate[3][0]);
+
+		// Singular and nearly singular matrices are handled by the scalar code, so that they keep returning NaNs
+		// where Gaussian elimination hits a pivot below epsilon, instead of rounding noise divided by a tiny determinant.
+		// The adjugate is only used when the determinant is a sizable fraction of its Hadamard bound (the product of
+		// the row lengths), i.e. the rows are far from linearly dependent, and no row is short enough for the
+		// elimination to reach such a pivot. This holds for rigid and scaled transforms and for projections.
+		// The test is done in double precision so that the squared lengths don't overflow for float matrices.
+		double hadamardBound = 1.0;
+		double minRowLength = std::numeric_limits<double>::max();
+		for (int i = 0; i < 4; i++)
+		{
+			double rowLength = 0.0;
+			for (int j = 0; j < 4; j++)
+				rowLength += double(e(i, j)) * double(e(i, j));
+			rowLength = std::sqrt(rowLength);
+			hadamardBound *= rowLength;
+			minRowLength = std::min(minRowLength, rowLength);
+		}
+
+		constexpr double minConditioning = 1.0 / 16.0;
+		constexpr double minRowLengthAllowed = double(epsilon) * 1e4;
+		if (!(abs(determinant) >= epsilon) ||
+			!(std::abs(double(determinant)) >= hadamardBound * minConditioning) ||
+			!(minRowLength >= minRowLengthAllowed))
+			return scalar::inverse(m);
+
+		const V scale = V::splat(T(1) / determinant);
+		matrix<T, 4, 4> result;
+		(inv0 * scale).store(result.m_data);
+		(inv1 * scale).store(result.m_data + 4);
+		(inv2 * scale).store(result.m_data + 8);
+		(inv3 * scale).store(result.m_data + 12);
+		return result;
+	}
+
+	template <typename T>
+	box<T, 3> transformBox(box<T, 3> const& a, affine<T, 3> const& transform)
+	{
+		using V = Vec4<T>;
+		V mins = V::load3(&transform.m_translation.x);
+		V maxs = mins;
+
+		const vector<T, 3>* row = &transform.m_linear.row0;
+		for (int i = 0; i < 3; i++, row++)
+		{
+			const V r = V::load(&row->x); // the last element is ignored, see multiplyAffine
+			const V e = V::splat((&a.m_mins.x)[i]) * r;
+			const V f = V::splat((&a.m_maxs.x)[i]) * r;
+			mins = mins + vmin(e, f);
+			maxs = maxs + vmax(e, f);
+		}
+
+		box<T, 3> result;
+		store3x2(&result.m_mins.x, mins, maxs);
+		return result;
+	}
+}
+
+namespace donut::math::simd
+{
+#if DONUT_MATH_SSE2 || DONUT_MATH_NEON
+	inline affine<float, 3> multiply(affine<float, 3> const& a, affine<float, 3> const& b) { return detail::multiplyAffine(a, b); }
+	inline matrix<float, 4, 4> multiply(matrix<float, 4, 4> const& a, matrix<float, 4, 4> const& b) { return detail::multiplyMatrix4x4(a, b); }
+	inline matrix<float, 4, 4> inverse(matrix<float, 4, 4> const& m) { return detail::inverseMatrix4x4(m); }
+	inline box<float, 3> transform(box<float, 3> const& a, affine<float, 3> const& transform) { return detail::transformBox(a, transform); }
+#endif
+
+#if DONUT_MATH_SSE2 || DONUT_MATH_NEON64
+	inline affine<double, 3> multiply(affine<double, 3> const& a, affine<double, 3> const& b) { return detail::multiplyAffine(a, b); }
+	inline matrix<double, 4, 4> multiply(matrix<double, 4, 4> const& a, matrix<double, 4, 4> const& b) { return detail::multiplyMatrix4x4(a, b); }
+	inline matrix<double, 4, 4> inverse(matrix<double, 4, 4> const& m) { return detail::inverseMatrix4x4(m); }
+	inline box<double, 3> transform(box<double, 3> const& a, affine<double, 3> const& transform) { return detail::transformBox(a, transform); }
+#endif
+}
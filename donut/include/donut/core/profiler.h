@@ -0,0 +1,126 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*
+CPU profiler with hierarchical scopes, meant to be left in the code permanently.
+
+Scopes are placed with the DONUT_PROFILE_* macros, which compile to nothing unless
+DONUT_WITH_CPU_PROFILER is defined (CMake option of the same name). Every thread writes
+completed scopes into its own fixed-size ring buffer without taking any locks; only the
+first scope on a thread registers its buffer. When a ring is full, the oldest events are
+overwritten, so the exported trace always covers the most recent activity.
+
+Scope names must be string literals or otherwise outlive the profiler, since only
+the pointers are recorded.
+
+Example:
+
+    void Scene::Refresh(...)
+    {
+        DONUT_PROFILE_FUNCTION();
+        ...
+        {
+            DONUT_PROFILE_SCOPE("UpdateInstances");
+            ...
+        }
+    }
+
+    donut::profiler::WriteChromeTrace("cpu_trace.json");
+*/
+
+namespace donut::profiler
+{
+    struct Event
+    {
+        const char* name = nullptr;
+        uint64_t startNs = 0;
+        uint64_t endNs = 0;
+        uint32_t depth = 0;
+    };
+
+    struct ThreadEvents
+    {
+        uint32_t threadId = 0; // sequential, in the order in which threads first recorded something
+        std::string threadName;
+        std::vector<Event> events; // oldest first
+    };
+
+    // Returns the time in nanoseconds since an arbitrary point that is fixed for the lifetime of the process.
+    [[nodiscard]] uint64_t GetTimestampNs();
+
+    // Enables or disables recording at runtime. Scopes that are already open are still recorded.
+    void SetEnabled(bool enabled);
+    [[nodiscard]] bool IsEnabled();
+
+    // Sets the capacity of the rings for threads that haven't recorded any events yet.
+    void SetEventsPerThread(uint32_t count);
+
+    // Names the calling thread in the exported traces.
+    void SetThreadName(const char* name);
+
+    // Records a completed scope on the calling thread. Normally called through ScopedEvent.
+    void RecordEvent(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth);
+
+    // Copies the events currently held in all rings, skipping those that were discarded with Clear().
+    // Safe to call while other threads are recording; events overwritten during the copy are dropped.
+    void CollectEvents(std::vector<ThreadEvents>& outThreads);
+
+    // Discards all events recorded so far.
+    void Clear();
+
+    // Returns the collected events in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto.
+    [[nodiscard]] std::string GetChromeTrace();
+    bool WriteChromeTrace(const std::filesystem::path& fileName);
+
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* name);
+        ~ScopedEvent();
+
+        ScopedEvent(const ScopedEvent&) = delete;
+        ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+    private:
+        const char* m_Name;
+        uint64_t m_Start;
+    };
+}
+
+#ifdef DONUT_WITH_CPU_PROFILER
+#define DONUT_PROFILE_CONCAT_(a, b) a##b
+#define DONUT_PROFILE_CONCAT(a, b) DONUT_PROFILE_CONCAT_(a, b)
+#define DONUT_PROFILE_SCOPE(name) ::donut::profiler::ScopedEvent DONUT_PROFILE_CONCAT(donutProfileScope_, __LINE__)(name)
+#define DONUT_PROFILE_FUNCTION() DONUT_PROFILE_SCOPE(__func__)
+#define DONUT_PROFILE_THREAD_NAME(name) ::donut::profiler::SetThreadName(name)
+#else
+#define DONUT_PROFILE_SCOPE(name) ((void)0)
+#define DONUT_PROFILE_FUNCTION() ((void)0)
+#define DONUT_PROFILE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <filesystem>
+#include <vector>
+
+namespace donut::vfs
+{
+    class IFileSystem;
+}
+
+namespace donut::engine
+{
+    /*
+    CameraPath is a sequence of camera poses over time, recorded from a camera during an interactive
+    session and played back for repeatable benchmark runs. Playback is a function of time only,
+    so a fixed timestep produces the same camera on the same frames in every run.
+
+    Poses between keyframes are interpolated linearly, with the direction and up vectors renormalized.
+    Paths are stored as JSON: { "keyframes": [ { "time": t, "position": [x, y, z], "direction": [...], "up": [...] } ] }.
+    */
+    class CameraPath
+    {
+    public:
+        struct Keyframe
+        {
+            float time = 0.f;
+            dm::float3 position = 0.f;
+            dm::float3 direction = dm::float3(0.f, 0.f, 1.f);
+            dm::float3 up = dm::float3(0.f, 1.f, 0.f);
+        };
+
+        // Appends a keyframe. Keyframes must be added in increasing time order;
+        // a keyframe that is not later than the last one replaces it.
+        void AddKeyframe(const Keyframe& keyframe);
+        void Clear() { m_Keyframes.clear(); }
+
+        // Returns the interpolated pose at the given time, clamped to the ends of the path.
+        [[nodiscard]] Keyframe Sample(float time) const;
+
+        [[nodiscard]] bool IsEmpty() const { return m_Keyframes.empty(); }
+        [[nodiscard]] float GetDuration() const { return m_Keyframes.empty() ? 0.f : m_Keyframes.back().time; }
+        [[nodiscard]] const std::vector<Keyframe>& GetKeyframes() const { return m_Keyframes; }
+
+        bool Save(const std::filesystem::path& fileName) const;
+        bool Load(vfs::IFileSystem& fs, const std::filesystem::path& fileName);
+
+    private:
+        std::vector<Keyframe> m_Keyframes;
+    };
+}
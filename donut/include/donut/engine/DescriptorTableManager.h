@@ -104,5 +104,11 @@ namespace donut::engine
         DescriptorHandle CreateDescriptorHandle(nvrhi::BindingSetItem item);
         nvrhi::BindingSetItem GetDescriptor(DescriptorIndex index);
         void ReleaseDescriptor(DescriptorIndex index);
+
+        // Overwrites an allocated descriptor with a different resource, keeping the same index.
+        // Useful when a resource is recreated, e.g. a streamed texture with more mip levels,
+        // and the shaders should pick up the new version without updating the indices they use.
+        // The descriptor is written immediately, so it must not be in use by any work that the GPU hasn't finished.
+        bool ReplaceDescriptor(DescriptorIndex index, nvrhi::BindingSetItem item);
     };
 }
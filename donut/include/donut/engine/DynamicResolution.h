@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <filesystem>
+#include <vector>
+
+namespace donut::engine
+{
+    /*
+    DynamicResolutionController adjusts the render size every frame to hold a target GPU frame time,
+    within the render size bounds of the upscaler (e.g. the DLSS min/max render sizes).
+
+    The controller works on the render area, assuming that GPU time is proportional to the number of
+    pixels rendered. The measured frame times are smoothed with an exponential moving average, and the
+    logarithm of the area is driven by a PI controller in velocity form on log(target / measured).
+    Relative errors within the dead band are ignored, which keeps the resolution from oscillating around
+    the target. Because the measurements lag the changes by a few frames (the GPU profiler reads them
+    framesInFlight frames later), measurements are ignored for settleFrames frames after each change.
+
+    Replay mode makes the controller deterministic for tests and benchmarks: the frame times passed to
+    Update(...) are replaced with a prerecorded sequence, e.g. one captured with SetRecording(true).
+    */
+    class DynamicResolutionController
+    {
+    public:
+        struct Parameters
+        {
+            float targetFrameTimeMs = 16.667f;
+            float proportionalGain = 0.25f;
+            float integralGain = 0.5f;
+            float smoothing = 0.5f;     // weight of the newest sample in the moving average, (0, 1]
+            float deadBand = 0.05f;     // relative frame time error that doesn't cause a change
+            float maxScaleStep = 0.1f;  // largest relative change of the scale per update
+            uint32_t settleFrames = 4;
+        };
+
+        DynamicResolutionController();
+
+        void SetParameters(const Parameters& params) { m_Params = params; }
+        [[nodiscard]] const Parameters& GetParameters() const { return m_Params; }
+
+        // Sets the render size bounds. The scale is relative to maxSize, and the aspect ratio of maxSize is preserved.
+        void SetBounds(dm::int2 minSize, dm::int2 maxSize);
+
+        // Restarts the controller at the given scale, clearing the filter state.
+        void Reset(float scale = 1.f);
+
+        // Feeds the GPU time of one frame and returns the new render size.
+        // In replay mode, the argument is ignored and the next replayed frame time is used instead.
+        dm::int2 Update(float gpuFrameTimeMs);
+
+        [[nodiscard]] dm::int2 GetRenderSize() const;
+        [[nodiscard]] float GetScale() const { return m_Scale; }
+        [[nodiscard]] float GetMinScale() const;
+        [[nodiscard]] float GetFilteredFrameTimeMs() const { return m_FilteredMs; }
+
+        // Records the frame times passed to Update(...), before replay substitution.
+        void SetRecording(bool enabled) { m_Recording = enabled; }
+        [[nodiscard]] const std::vector<float>& GetRecordedFrameTimes() const { return m_Recorded; }
+        void ClearRecording() { m_Recorded.clear(); }
+
+        // Replays the given frame times in order. When the sequence ends, the last value is repeated.
+        // An empty sequence disables replay.
+        void SetReplay(std::vector<float> frameTimes);
+        [[nodiscard]] bool IsReplaying() const { return !m_Replay.empty(); }
+
+        // Text files with one frame time in milliseconds per line.
+        bool SaveRecording(const std::filesystem::path& fileName) const;
+        bool LoadReplay(const std::filesystem::path& fileName);
+
+    private:
+        Parameters m_Params;
+        dm::int2 m_MinSize = 1;
+        dm::int2 m_MaxSize = 1;
+
+        float m_Scale = 1.f;
+        float m_FilteredMs = 0.f;
+        float m_PreviousError = 0.f;
+        uint32_t m_SettleCounter = 0;
+        bool m_HasSamples = false;
+
+        bool m_Recording = false;
+        std::vector<float> m_Recorded;
+        std::vector<float> m_Replay;
+        size_t m_ReplayPosition = 0;
+    };
+}
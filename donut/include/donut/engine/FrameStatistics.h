@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace donut::engine
+{
+    /*
+    LatencyHistogram records non-negative integer values (e.g. microseconds) into
+    log-linear buckets, in the spirit of HdrHistogram: values below 128 are counted
+    exactly, and above that every power of two is split into 64 buckets, which bounds
+    the relative error of the reported percentiles to 1/64. Recording is O(1) and
+    the memory footprint is fixed, so every frame can be recorded for the whole run.
+    */
+    class LatencyHistogram
+    {
+    public:
+        static constexpr uint32_t SubBucketBits = 7;
+        static constexpr uint32_t SubBucketCount = 1u << SubBucketBits;
+        static constexpr uint32_t SubBucketHalfCount = SubBucketCount / 2;
+        static constexpr uint32_t BucketCount = (64 - SubBucketBits + 1) * SubBucketHalfCount + SubBucketHalfCount;
+
+        LatencyHistogram();
+
+        void RecordValue(uint64_t value);
+        void Reset();
+
+        [[nodiscard]] uint64_t GetCount() const { return m_TotalCount; }
+        [[nodiscard]] uint64_t GetMin() const { return m_TotalCount ? m_Min : 0; }
+        [[nodiscard]] uint64_t GetMax() const { return m_Max; }
+
+        // Returns the largest value that is equivalent to the value at the given percentile (0-100),
+        // clamped to the recorded range.
+        [[nodiscard]] uint64_t GetValueAtPercentile(double percentile) const;
+
+        // Bucket layout, for exporting the distribution
+        [[nodiscard]] static uint32_t GetBucketIndex(uint64_t value);
+        [[nodiscard]] static uint64_t GetBucketLowerBound(uint32_t index);
+        [[nodiscard]] static uint64_t GetBucketUpperBound(uint32_t index); // exclusive
+        [[nodiscard]] uint64_t GetBucketCount(uint32_t index) const { return m_Counts[index]; }
+
+    private:
+        std::vector<uint64_t> m_Counts;
+        uint64_t m_TotalCount = 0;
+        uint64_t m_Min = ~0ull;
+        uint64_t m_Max = 0;
+    };
+
+    /*
+    FrameStatistics keeps one histogram per named channel (frame time, simulation,
+    render submission, present, latency values reported by the driver...) together with
+    exact running moments, and reports percentiles and frame pacing for benchmark runs.
+
+    Values are recorded in milliseconds and stored with microsecond resolution.
+    Frame pacing is measured as the mean absolute difference between consecutive
+    values of a channel, which, unlike the standard deviation, is not affected by
+    slow drifts of the frame time and highlights alternating short and long frames.
+    */
+    class FrameStatistics
+    {
+    public:
+        typedef uint32_t ChannelId;
+
+        struct Summary
+        {
+            std::string name;
+            uint64_t count = 0;
+            double minMs = 0.0;
+            double meanMs = 0.0;
+            double p50Ms = 0.0;
+            double p90Ms = 0.0;
+            double p99Ms = 0.0;
+            double p999Ms = 0.0;
+            double maxMs = 0.0;
+            double stdDevMs = 0.0;
+            double pacingMs = 0.0;
+        };
+
+        // Returns the existing channel with that name, or creates a new one.
+        ChannelId GetOrCreateChannel(const std::string& name);
+
+        void RecordValue(ChannelId channel, double milliseconds);
+
+        // Clears all recorded values but keeps the channels, e.g. after a warm-up period.
+        void Reset();
+
+        [[nodiscard]] uint32_t GetNumChannels() const { return uint32_t(m_Channels.size()); }
+        [[nodiscard]] const LatencyHistogram& GetHistogram(ChannelId channel) const { return m_Channels[channel].histogram; }
+        [[nodiscard]] Summary GetSummary(ChannelId channel) const;
+
+        // Writes one row of summary statistics per channel.
+        bool WriteSummaryCsv(const std::filesystem::path& fileName) const;
+
+        // Writes the non-empty histogram buckets of all channels, one row per bucket.
+        bool WriteHistogramCsv(const std::filesystem::path& fileName) const;
+
+        // Writes the summaries of all non-empty channels as JSON, together with properties of the run:
+        // 'info' for descriptive strings (scene, settings) and 'metrics' for other numbers (memory usage).
+        // { "info": { ... }, "metrics": { ... }, "channels": [ { "name": ..., "count": ..., "p50Ms": ..., ... } ] }
+        bool WriteReportJson(const std::filesystem::path& fileName,
+            const std::vector<std::pair<std::string, std::string>>& info = {},
+            const std::vector<std::pair<std::string, double>>& metrics = {}) const;
+
+    private:
+        struct Channel
+        {
+            std::string name;
+            LatencyHistogram histogram;
+            double mean = 0.0;
+            double m2 = 0.0;
+            double lastValue = 0.0;
+            double sumAbsDelta = 0.0;
+        };
+
+        std::vector<Channel> m_Channels;
+    };
+}
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <donut/engine/MeshOptimizer.h>
+#include <donut/engine/MeshSimplifier.h>
 #include <memory>
 #include <filesystem>
 
@@ -53,9 +55,30 @@ namespace donut::engine
     protected:
         std::shared_ptr<vfs::IFileSystem> m_fs;
         std::shared_ptr<SceneTypeFactory> m_SceneTypeFactory;
+        bool m_OptimizeMeshes = false;
+        float m_OverdrawThreshold = DefaultOverdrawThreshold;
+        bool m_GenerateLods = false;
+        MeshLodParameters m_LodParameters;
         
     public:
         explicit GltfImporter(std::shared_ptr<vfs::IFileSystem> fs, std::shared_ptr<SceneTypeFactory> sceneTypeFactory);
+
+        // Reorders the triangles and vertices of the loaded meshes for vertex cache efficiency, less overdraw
+        // and vertex fetch locality, see OptimizeMeshes in <donut/engine/MeshOptimizer.h>.
+        void SetMeshOptimizationEnabled(bool enable, float overdrawThreshold = DefaultOverdrawThreshold)
+        {
+            m_OptimizeMeshes = enable;
+            m_OverdrawThreshold = overdrawThreshold;
+        }
+        [[nodiscard]] bool IsMeshOptimizationEnabled() const { return m_OptimizeMeshes; }
+
+        // Generates simplified levels of detail for the loaded meshes, see GenerateMeshLods in <donut/engine/MeshSimplifier.h>.
+        void SetLodGenerationEnabled(bool enable, const MeshLodParameters& params = MeshLodParameters())
+        {
+            m_GenerateLods = enable;
+            m_LodParameters = params;
+        }
+        [[nodiscard]] bool IsLodGenerationEnabled() const { return m_GenerateLods; }
         
         bool Load(
             const std::filesystem::path& fileName,
@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace donut::engine
+{
+    // Keeps the last N samples of a value and computes order statistics over them.
+    class TimingWindow
+    {
+    public:
+        explicit TimingWindow(uint32_t capacity = 120);
+
+        void AddSample(float value);
+        void Clear();
+
+        [[nodiscard]] uint32_t GetNumSamples() const { return uint32_t(m_Samples.size()); }
+        [[nodiscard]] uint32_t GetCapacity() const { return m_Capacity; }
+        [[nodiscard]] float GetLast() const { return m_Last; }
+        [[nodiscard]] float GetMin() const;
+        [[nodiscard]] float GetMax() const;
+        [[nodiscard]] float GetAverage() const;
+
+        // Nearest-rank percentile, percentile in [0, 100]. Returns 0 when there are no samples.
+        [[nodiscard]] float GetPercentile(float percentile) const;
+
+    private:
+        std::vector<float> m_Samples;
+        uint32_t m_Capacity;
+        uint32_t m_Next = 0;
+        float m_Last = 0.f;
+    };
+
+    /*
+    GpuProfiler measures the GPU time of render passes with timer queries.
+
+    Call BeginFrame() once per frame before recording any scopes, and wrap passes in
+    BeginScope/EndScope pairs or GpuProfilerScope objects. Scopes can be nested, but every scope
+    must begin and end on the same command list. Queries are allocated from a ring of per-frame
+    pools, and the results of a frame are read when its pool comes up for reuse, i.e.
+    framesInFlight frames later. If the GPU hasn't finished that frame yet, its results are
+    dropped instead of waiting for them, which is reported in GetNumDroppedFrames().
+
+    NVRHI timer queries only report durations, so the traces written by WriteChromeTrace lay out
+    the scopes back-to-back from the start of their parent scope or frame, not at their actual
+    GPU timestamps. Gaps between scopes are not visible.
+
+    The profiler is not thread-safe: all functions must be called from the rendering thread.
+    */
+    class GpuProfiler
+    {
+    public:
+        struct PassStats
+        {
+            std::string name;
+            uint32_t depth = 0;     // nesting level of the scope when it was first recorded
+            uint32_t numSamples = 0;
+            float lastMs = 0.f;
+            float minMs = 0.f;
+            float avgMs = 0.f;
+            float p99Ms = 0.f;
+        };
+
+        GpuProfiler(nvrhi::IDevice* device, uint32_t framesInFlight = 4, uint32_t windowSize = 120, uint32_t traceHistoryFrames = 300);
+
+        void SetEnabled(bool enabled) { m_Enabled = enabled; }
+        [[nodiscard]] bool IsEnabled() const { return m_Enabled; }
+
+        // Collects the results of the oldest pending frame and starts a new one.
+        void BeginFrame();
+
+        void BeginScope(nvrhi::ICommandList* commandList, const char* name);
+        void EndScope(nvrhi::ICommandList* commandList);
+
+        // Fills outStats with one entry per scope name, in the order in which the scopes were first seen.
+        void GetPassStats(std::vector<PassStats>& outStats) const;
+
+        // Clears the rolling windows and the trace history.
+        void ResetStats();
+
+        [[nodiscard]] uint64_t GetNumResolvedFrames() const { return m_NumResolvedFrames; }
+
+        // GPU time of the most recently resolved frame: the sum of its top-level scopes.
+        // Use GetNumResolvedFrames() to tell whether a new frame has been resolved since the last call.
+        [[nodiscard]] float GetLastFrameTimeMs() const { return m_LastFrameTimeMs; }
+        [[nodiscard]] uint64_t GetNumDroppedFrames() const { return m_NumDroppedFrames; }
+
+        // Returns the trace of the last traceHistoryFrames resolved frames in the Chrome trace event format,
+        // which can be opened in chrome://tracing or Perfetto.
+        [[nodiscard]] std::string GetChromeTrace() const;
+        bool WriteChromeTrace(const std::filesystem::path& fileName) const;
+
+    private:
+        struct ScopeRecord
+        {
+            uint32_t nameIndex = 0;
+            uint32_t depth = 0;
+            uint32_t queryIndex = 0;
+            bool closed = false;
+        };
+
+        struct FrameSlot
+        {
+            std::vector<nvrhi::TimerQueryHandle> queries;
+            std::vector<ScopeRecord> scopes;
+            uint64_t frameIndex = 0;
+            double cpuTimeUs = 0.0;
+            bool pending = false;
+        };
+
+        struct ResolvedScope
+        {
+            uint32_t nameIndex;
+            uint32_t depth;
+            float startMs;
+            float durationMs;
+        };
+
+        struct ResolvedFrame
+        {
+            uint64_t frameIndex = 0;
+            double cpuTimeUs = 0.0;
+            std::vector<ResolvedScope> scopes;
+        };
+
+        nvrhi::DeviceHandle m_Device;
+        bool m_Enabled = true;
+        bool m_FrameEnabled = false; // latched in BeginFrame so that scopes stay balanced when toggled mid-frame
+        std::chrono::steady_clock::time_point m_StartTime;
+
+        std::vector<FrameSlot> m_Frames;
+        uint32_t m_CurrentFrame = 0;
+        uint64_t m_FrameIndex = 0;
+        std::vector<uint32_t> m_ScopeStack;
+
+        std::vector<std::string> m_Names;
+        std::vector<uint32_t> m_NameDepths;
+        std::unordered_map<std::string, uint32_t> m_NameIndices;
+        std::vector<TimingWindow> m_Windows;
+        uint32_t m_WindowSize;
+
+        std::vector<ResolvedFrame> m_History;
+        uint32_t m_HistorySize;
+        uint32_t m_HistoryNext = 0;
+
+        uint64_t m_NumResolvedFrames = 0;
+        uint64_t m_NumDroppedFrames = 0;
+        float m_LastFrameTimeMs = 0.f;
+
+        void ResolveFrame(FrameSlot& frame);
+        uint32_t GetNameIndex(const char* name, uint32_t depth);
+    };
+
+    // Records a GpuProfiler scope for its lifetime. Does nothing if the profiler is null.
+    class GpuProfilerScope
+    {
+    public:
+        GpuProfilerScope(GpuProfiler* profiler, nvrhi::ICommandList* commandList, const char* name)
+            : m_Profiler(profiler)
+            , m_CommandList(commandList)
+        {
+            if (m_Profiler)
+                m_Profiler->BeginScope(m_CommandList, name);
+        }
+
+        ~GpuProfilerScope()
+        {
+            if (m_Profiler)
+                m_Profiler->EndScope(m_CommandList);
+        }
+
+        GpuProfilerScope(const GpuProfilerScope&) = delete;
+        GpuProfilerScope& operator=(const GpuProfilerScope&) = delete;
+
+    private:
+        GpuProfiler* m_Profiler;
+        nvrhi::ICommandList* m_CommandList;
+    };
+}
@@ -53,7 +53,13 @@ namespace donut::engine
     private:
         nvrhi::DeviceHandle m_Device;
         nvrhi::BindingLayoutHandle m_BindingLayout;
-        std::unordered_map<const Material*, nvrhi::BindingSetHandle> m_BindingSets;
+        struct CachedBindingSet
+        {
+            nvrhi::BindingSetHandle bindingSet;
+            uint32_t textureGeneration = 0; // LoadedTexture::replacementGeneration when the set was last validated
+        };
+
+        std::unordered_map<const Material*, CachedBindingSet> m_BindingSets;
         std::vector<MaterialResourceBinding> m_BindingDesc;
         nvrhi::TextureHandle m_FallbackTexture;
         nvrhi::SamplerHandle m_Sampler;
@@ -61,6 +67,7 @@ namespace donut::engine
         bool m_TrackLiveness;
 
         nvrhi::BindingSetHandle CreateMaterialBindingSet(const Material* material);
+        bool IsMaterialBindingSetStale(nvrhi::IBindingSet* bindingSet, const Material* material) const;
         nvrhi::BindingSetItem GetTextureBindingSetItem(uint32_t slot, const std::shared_ptr<LoadedTexture>& texture) const;
 
     public:
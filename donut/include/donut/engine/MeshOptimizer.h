@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <memory>
+#include <vector>
+
+namespace tf
+{
+    class Executor;
+}
+
+namespace donut::engine
+{
+    struct MeshInfo;
+
+    // Post-transform vertex cache efficiency of an index buffer, as measured by AnalyzeVertexCache.
+    // Statistics of several index buffers can be combined with operator+=.
+    struct VertexCacheStatistics
+    {
+        uint64_t numTriangles = 0;
+        uint64_t numVertices = 0;   // number of unique vertices referenced by the indices
+        uint64_t numTransforms = 0; // number of vertex shader invocations, i.e. cache misses
+
+        // Average Cache Miss Ratio: transforms per triangle, between 0.5 (ideal for large grids) and 3
+        [[nodiscard]] float GetACMR() const { return numTriangles ? float(numTransforms) / float(numTriangles) : 0.f; }
+        // Average Transform to Vertex Ratio: transforms per unique vertex, 1 is ideal
+        [[nodiscard]] float GetATVR() const { return numVertices ? float(numTransforms) / float(numVertices) : 0.f; }
+
+        VertexCacheStatistics& operator+=(const VertexCacheStatistics& other);
+    };
+
+    struct MeshOptimizationStatistics
+    {
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    // Default FIFO cache size used to measure the vertex cache efficiency.
+    constexpr uint32_t DefaultVertexCacheSize = 16;
+
+    // Overdraw optimization is allowed to make the ACMR worse by this factor.
+    constexpr float DefaultOverdrawThreshold = 1.05f;
+
+    // Simulates a FIFO post-transform cache of the given size on a triangle list.
+    [[nodiscard]] VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t numIndices, size_t numVertices,
+        uint32_t cacheSize = DefaultVertexCacheSize);
+
+    // Reorders the triangles to improve the vertex cache hit rate, using Forsyth's linear-speed algorithm.
+    // Triangles keep their winding. The destination must not alias the source indices.
+    void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t numIndices, size_t numVertices);
+
+    /*
+    Reorders the triangles of a cache optimized index buffer to reduce overdraw, following
+    Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+    The triangles are split into clusters at the points where the vertex cache would be
+    flushed anyway, or where the ACMR of a cluster stays within threshold times the ACMR
+    of the whole cluster. The clusters are then sorted so that the ones that face outwards
+    from the mesh center are drawn first, as they are more likely to occlude the others.
+
+    A threshold of 1 keeps the vertex cache efficiency, larger values allow smaller clusters.
+    The destination must not alias the source indices.
+    */
+    void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+        const dm::float3* positions, size_t numVertices, float threshold = DefaultOverdrawThreshold);
+
+    // Builds a vertex remap table that orders the vertices by their first use in the index buffer,
+    // which improves the locality of vertex fetches. Unreferenced vertices are moved to the end.
+    // Returns the number of referenced vertices.
+    size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t numIndices, size_t numVertices);
+
+    // Applies a remap table from OptimizeVertexFetchRemap to the indices, in place.
+    void RemapIndexBuffer(uint32_t* indices, size_t numIndices, const uint32_t* remap);
+
+    // Applies a remap table from OptimizeVertexFetchRemap to a vertex attribute stream, in place.
+    template<typename T>
+    void RemapVertexStream(T* vertices, size_t numVertices, const uint32_t* remap)
+    {
+        std::vector<T> original(vertices, vertices + numVertices);
+        for (size_t vertex = 0; vertex < numVertices; vertex++)
+            vertices[remap[vertex]] = original[vertex];
+    }
+
+    // Runs the vertex cache, overdraw and vertex fetch optimizations on every geometry of the meshes,
+    // using the CPU data of their buffer groups, and permutes all the vertex attribute streams accordingly.
+    // The geometries are processed in parallel when an executor is provided.
+    // Returns the combined vertex cache statistics of all geometries before and after the optimization.
+    MeshOptimizationStatistics OptimizeMeshes(const std::vector<std::shared_ptr<MeshInfo>>& meshes, tf::Executor* executor = nullptr,
+        float overdrawThreshold = DefaultOverdrawThreshold);
+}
@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <memory>
+#include <vector>
+
+namespace tf
+{
+    class Executor;
+}
+
+namespace donut::engine
+{
+    struct MeshInfo;
+    struct MeshGeometry;
+
+    struct MeshSimplificationParameters
+    {
+        // Number of indices to stop at, a multiple of 3
+        size_t targetIndexCount = 0;
+        // Largest allowed geometric error, relative to the radius of the mesh bounding sphere
+        float targetError = 0.02f;
+        // Weight of texture coordinate distortion in the collapse cost, relative to the geometric error.
+        // A UV change of 1 costs as much as moving a vertex by the mesh radius, times the weight.
+        float attributeWeight = 0.5f;
+    };
+
+    /*
+    Reduces the triangle count of an indexed triangle list using edge collapses driven by
+    quadric error metrics (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+    Vertices are only ever collapsed onto other existing vertices, so the simplified index buffer
+    references the same vertex data as the source, and no vertex attributes need to be generated.
+
+    Vertices on open borders are never moved. Because glTF meshes split their vertices along
+    UV and normal seams, this also keeps the seams intact. The texture coordinate change
+    caused by a collapse is added to its cost when texCoords is provided, and collapses that
+    would flip a triangle are rejected.
+
+    Writes the simplified indices into destination, which must have room for numIndices entries
+    and may alias the source indices. Returns the number of indices written; outError receives
+    the error of the result, relative to the radius of the mesh.
+    */
+    size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+        const dm::float3* positions, const dm::float2* texCoords, size_t numVertices,
+        const MeshSimplificationParameters& params, float* outError = nullptr);
+
+    struct MeshLodParameters
+    {
+        // Maximum number of levels generated in addition to the original geometry
+        uint32_t maxLods = 4;
+        // Every level aims for this fraction of the triangles of the previous level
+        float reductionRatio = 0.5f;
+        // A level is dropped if it doesn't remove at least this fraction of the previous level's triangles
+        float minReduction = 0.1f;
+        // No levels are generated from geometries with fewer triangles
+        uint32_t minTriangles = 64;
+        // Largest allowed error per level, relative to the radius of the geometry
+        float maxErrorPerLod = 0.02f;
+        float attributeWeight = 0.5f;
+    };
+
+    /*
+    Generates a chain of simplified index buffers for every geometry of the meshes, stored in
+    MeshGeometry::lods. The LOD indices are appended to the end of BufferGroup::indexData and use
+    the same vertices as the full detail geometry. Each level is simplified from the previous one,
+    and its error accumulates the errors of all previous levels, so that the errors grow monotonically.
+    Skinned meshes and buffer groups that have already been uploaded are skipped.
+    The geometries are processed in parallel when an executor is provided.
+    Returns the total number of LOD levels generated.
+    */
+    uint32_t GenerateMeshLods(const std::vector<std::shared_ptr<MeshInfo>>& meshes, tf::Executor* executor = nullptr,
+        const MeshLodParameters& params = MeshLodParameters());
+
+    /*
+    Picks the coarsest level of detail of the geometry whose error, projected to the screen,
+    stays within maxPixelError. errorToPixels converts the relative errors stored in
+    MeshGeometry::lods into pixels, i.e. it's the projected radius of the geometry in pixels.
+
+    To avoid popping back and forth when the projected size is close to a switching point,
+    levels up to currentLod are accepted with an error of up to maxPixelError * (1 + hysteresis),
+    and coarser levels have to be within maxPixelError * (1 - hysteresis).
+    */
+    [[nodiscard]] uint32_t SelectMeshLod(const MeshGeometry& geometry, float errorToPixels, uint32_t currentLod,
+        float maxPixelError, float hysteresis);
+}
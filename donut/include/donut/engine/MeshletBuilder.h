@@ -0,0 +1,77 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <donut/engine/SceneTypes.h>
+#include <memory>
+#include <vector>
+
+namespace tf
+{
+    class Executor;
+}
+
+namespace donut::engine
+{
+    // Limits that fit the mesh shader output of one thread group, see <donut/shaders/meshlet_cb.h>
+    constexpr uint32_t MaxMeshletVertices = 64;
+    constexpr uint32_t MaxMeshletTriangles = 124;
+
+    /*
+    Splits an indexed triangle list into meshlets and appends them to outMeshlets.
+    For every meshlet, outIndexData receives the vertexCount indices of its unique vertices
+    (copied from the input index buffer) followed by triangleCount words, each containing
+    three 8-bit indices into that vertex list.
+
+    Triangles are added to the current meshlet greedily, preferring the ones that share
+    the most vertices with it, which keeps the meshlets compact and the vertex reuse high.
+    The bounds and normal cones of the new meshlets are computed with ComputeMeshletBounds.
+
+    Returns false if an index is out of range, in which case nothing is added to the outputs.
+    */
+    bool BuildMeshlets(
+        const uint32_t* indices,
+        size_t numIndices,
+        const dm::float3* positions,
+        size_t numVertices,
+        std::vector<Meshlet>& outMeshlets,
+        std::vector<uint32_t>& outIndexData,
+        uint32_t maxVertices = MaxMeshletVertices,
+        uint32_t maxTriangles = MaxMeshletTriangles);
+
+    // Computes the bounding sphere and the normal cone of a meshlet from its vertex positions.
+    // The cone is disabled (coneCutoff = 1) when the triangle normals span more than a hemisphere.
+    void ComputeMeshletBounds(Meshlet& meshlet, const uint32_t* meshletIndexData, const dm::float3* positions);
+
+    // Returns true when no triangle of the meshlet can face the viewer at viewPosition.
+    // All values are in the same space, which must be related to the meshlet's object space by
+    // a rigid transform with an optional uniform scale.
+    [[nodiscard]] bool IsMeshletBackfacing(const Meshlet& meshlet, const dm::float3& viewPosition);
+
+    // Builds the meshlets for every geometry of the meshes, using the CPU index and position data
+    // of their buffer groups, and fills BufferGroup::meshlets and MeshGeometry::firstMeshlet/numMeshlets.
+    // Skinned instances, and buffer groups whose data has been released, are skipped.
+    // The meshes are processed in parallel when an executor is provided.
+    void BuildMeshletsForMeshes(const std::vector<std::shared_ptr<MeshInfo>>& meshes, tf::Executor* executor = nullptr);
+}
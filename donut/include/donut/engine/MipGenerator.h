@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tf
+{
+    class Executor;
+}
+
+namespace donut::engine
+{
+    enum class MipFilter : uint8_t
+    {
+        // Averages the source texels covered by each destination texel, weighted by coverage.
+        Box,
+
+        // Kaiser-windowed sinc, sharper than Box and with less aliasing.
+        Kaiser
+    };
+
+    struct MipGenerationParams
+    {
+        MipFilter filter = MipFilter::Box;
+
+        // Filter 8-bit RGB channels in linear space. Alpha is always filtered as linear.
+        // SRGBA8_UNORM images are always treated as sRGB regardless of this flag.
+        bool sRGB = false;
+
+        // Kaiser filter shape: half-width in destination texels and the window's alpha parameter.
+        float kaiserWidth = 3.f;
+        float kaiserAlpha = 4.f;
+
+        // Maximum number of levels in the generated chain, including the top level. 0 means the full chain down to 1x1.
+        uint32_t maxMipLevels = 0;
+
+        // When set, rows are processed in parallel tiles using this executor.
+        // Calls made from a worker thread of the same executor are processed serially to avoid blocking it.
+        tf::Executor* executor = nullptr;
+    };
+
+    struct MipLevelLayout
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        size_t dataOffset = 0;
+        size_t rowPitch = 0;
+        size_t dataSize = 0;
+    };
+
+    /*
+    CPU implementation of image resampling and mip chain generation for uncompressed 2D images.
+    It doesn't need a graphics device, so it can be used at load time on loader threads or
+    for cooking textures offline.
+
+    Supported formats are R8_UNORM, RG8_UNORM, RGBA8_UNORM, SRGBA8_UNORM, R32_FLOAT, RG32_FLOAT
+    and RGBA32_FLOAT. Unorm results are clamped and rounded, float (HDR) results are not clamped.
+    Filtering is performed on RGBA float rows using SSE2 where available.
+    */
+    class MipGenerator
+    {
+    public:
+        [[nodiscard]] static bool IsFormatSupported(nvrhi::Format format);
+
+        // Number of levels in the full mip chain for the given size, down to 1x1.
+        [[nodiscard]] static uint32_t GetFullMipChainLength(uint32_t width, uint32_t height);
+
+        // Resamples the source image into the destination image of the same format.
+        static bool ResizeImage(
+            const void* srcData, uint32_t srcWidth, uint32_t srcHeight, size_t srcRowPitch,
+            void* dstData, uint32_t dstWidth, uint32_t dstHeight, size_t dstRowPitch,
+            nvrhi::Format format, const MipGenerationParams& params);
+
+        // Builds a mip chain from the source image. Level 0 is a copy of the source; every following level
+        // is half the size of the previous one (rounded down, at least 1) and is filtered from the previous level
+        // in full float precision. The levels are tightly packed into outData.
+        static bool GenerateMipChain(
+            const void* srcData, uint32_t srcWidth, uint32_t srcHeight, size_t srcRowPitch,
+            nvrhi::Format format, const MipGenerationParams& params,
+            std::vector<uint8_t>& outData, std::vector<MipLevelLayout>& outLayout);
+    };
+}
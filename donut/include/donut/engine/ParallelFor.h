@@ -0,0 +1,59 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#ifdef DONUT_WITH_TASKFLOW
+#include <taskflow/taskflow.hpp>
+#else
+namespace tf
+{
+    class Executor;
+}
+#endif
+
+namespace donut::engine
+{
+    // Calls func(index) for every index in [0, count), spread over the workers of the executor.
+    // Runs serially without an executor, when donut is built without taskflow, or when called
+    // from one of the executor's workers, because waiting on the executor there could starve it.
+    // Include this header only from source files, it pulls in taskflow.
+    template<typename Func>
+    void ParallelFor(tf::Executor* executor, uint32_t count, const Func& func)
+    {
+#ifdef DONUT_WITH_TASKFLOW
+        if (executor && count > 1 && executor->this_worker_id() < 0)
+        {
+            tf::Taskflow taskflow;
+            taskflow.for_each_index(0u, count, 1u, [&func](uint32_t index) { func(index); });
+            executor->run(taskflow).wait();
+            return;
+        }
+#else
+        (void)executor;
+#endif
+        for (uint32_t index = 0; index < count; index++)
+            func(index);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace donut::engine
+{
+    /*
+    ReadbackQueue copies GPU resources into CPU-visible staging resources and delivers their
+    contents a few frames later, without waiting for the GPU.
+
+    Requests record a copy into the caller's command list. After executing a command list with
+    requests, pass it to OnCommandListExecuted(...), so that only the copies that have actually been
+    submitted are waited for. Call Update() once per frame: it fences the requests submitted since
+    the last update with one event query, and completes the older batches whose queries have been
+    signaled by mapping their staging resources and calling their callbacks on the calling thread.
+    The mapped data is only valid during the callback. Staging buffers and textures are returned
+    to a pool when their request completes and reused by later requests with compatible sizes.
+
+    The queue also owns a worker thread for the CPU work that follows a readback, such as image
+    encoding, see RunOnWorkerThread(...).
+
+    Requests can be recorded from multiple threads, but OnCommandListExecuted(), Update() and Flush()
+    must be called from the rendering thread.
+    */
+    class ReadbackQueue
+    {
+    public:
+        // 'data' is null if the staging resource couldn't be mapped.
+        typedef std::function<void(const void* data, size_t size)> BufferCallback;
+        typedef std::function<void(const void* data, size_t rowPitch, const nvrhi::TextureDesc& desc)> TextureCallback;
+
+        explicit ReadbackQueue(nvrhi::IDevice* device);
+        ~ReadbackQueue();
+
+        // Copies 'size' bytes of 'buffer' starting at 'offset'.
+        void RequestBuffer(nvrhi::ICommandList* commandList, nvrhi::IBuffer* buffer, uint64_t offset, uint64_t size, BufferCallback callback);
+
+        // Copies one mip level of one array slice of 'texture'. The callback receives the description
+        // of a single-subresource 2D texture of that size.
+        void RequestTexture(nvrhi::ICommandList* commandList, nvrhi::ITexture* texture, const nvrhi::TextureSlice& slice, TextureCallback callback);
+
+        // Marks the requests recorded into the command list as submitted. Call after the command list
+        // has been executed. Requests in command lists that haven't been executed are not fenced.
+        void OnCommandListExecuted(nvrhi::ICommandList* commandList);
+
+        // Fences the requests submitted since the last update and completes the finished ones.
+        void Update();
+
+        // Waits for the GPU and the worker thread, and completes all submitted requests.
+        // Use for shutdown or tests, not every frame.
+        void Flush();
+
+        // Runs the task on the worker thread of the queue, in order of submission.
+        void RunOnWorkerThread(std::function<void()> task);
+
+        [[nodiscard]] size_t GetNumPendingRequests() const;
+        [[nodiscard]] size_t GetNumPooledBuffers() const;
+        [[nodiscard]] size_t GetNumPooledTextures() const;
+
+    private:
+        struct Request
+        {
+            nvrhi::BufferHandle buffer;
+            nvrhi::StagingTextureHandle texture;
+            nvrhi::TextureDesc textureDesc;
+            uint64_t size = 0;
+            BufferCallback bufferCallback;
+            TextureCallback textureCallback;
+            nvrhi::CommandListHandle commandList; // until the command list is executed
+        };
+
+        // Requests submitted between two updates, fenced with one query
+        struct Batch
+        {
+            nvrhi::EventQueryHandle query;
+            std::vector<Request> requests;
+        };
+
+        nvrhi::DeviceHandle m_Device;
+
+        mutable std::mutex m_Mutex;
+        std::vector<Request> m_NewRequests;
+        std::vector<Request> m_SubmittedRequests;
+        std::deque<Batch> m_PendingBatches;
+        std::vector<nvrhi::BufferHandle> m_FreeBuffers;
+        std::vector<nvrhi::StagingTextureHandle> m_FreeTextures;
+        std::vector<nvrhi::EventQueryHandle> m_FreeQueries;
+
+        std::thread m_Worker;
+        std::mutex m_WorkerMutex;
+        std::condition_variable m_WorkerCondition;
+        std::deque<std::function<void()>> m_WorkerTasks;
+        bool m_WorkerBusy = false;
+        bool m_Terminate = false;
+
+        nvrhi::BufferHandle AcquireBuffer(uint64_t size);
+        nvrhi::StagingTextureHandle AcquireTexture(const nvrhi::TextureDesc& desc);
+        void CompleteRequest(Request& request);
+        void WorkerThreadProc();
+        void WaitForWorker();
+    };
+}
@@ -63,6 +63,9 @@ namespace donut::engine
         std::shared_ptr<GltfImporter> m_GltfImporter;
         std::vector<SceneImportResult> m_Models;
         bool m_EnableBindlessResources = false;
+        bool m_EnableCompactVertexFormat = false;
+        bool m_EnableMeshlets = false;
+        bool m_RetainCpuGeometry = false;
         
         nvrhi::BufferHandle m_MaterialBuffer;
         nvrhi::BufferHandle m_GeometryBuffer;
@@ -72,10 +75,15 @@ namespace donut::engine
         nvrhi::ShaderHandle m_SkinningShader;
         nvrhi::ComputePipelineHandle m_SkinningPipeline;
         nvrhi::BindingLayoutHandle m_SkinningBindingLayout;
+        nvrhi::BufferHandle m_JointBuffer;
+        std::vector<dm::float4x4> m_JointPalettes; // CPU copy of m_JointBuffer
+        tf::Executor* m_Executor = nullptr;
 
         bool m_RayTracingSupported = false;
         bool m_SceneTransformsChanged = false;
         bool m_SceneStructureChanged = false;
+        bool m_RefreshedTransformsChanged = false; // set by RefreshSceneGraphTransforms, consumed by CommitSceneGraph
+        uint32_t m_TextureReplacementGeneration = 0; // LoadedTexture::replacementGeneration seen by RefreshBuffers
 
         struct Resources; // Hide the implementation to avoid including <material_cb.h> and <bindless.h> here
         std::shared_ptr<Resources> m_Resources;
@@ -127,6 +135,12 @@ namespace donut::engine
         // Processes animations, transforms, bounding boxes etc.
         void RefreshSceneGraph(uint32_t frameIndex);
 
+        // RefreshSceneGraph split for a simulation thread, see SceneGraph::RefreshTransforms.
+        // RefreshSceneGraphTransforms can run while the previous frame renders, CommitSceneGraph runs
+        // when neither the simulation nor rendering is active and publishes the result to RefreshBuffers.
+        void RefreshSceneGraphTransforms();
+        void CommitSceneGraph(uint32_t frameIndex);
+
         // Creates missing buffers, uploads vertex buffers, instance data, materials, etc.
         void RefreshBuffers(nvrhi::ICommandList* commandList, uint32_t frameIndex);
 
@@ -139,6 +153,35 @@ namespace donut::engine
 
         static const SceneLoadingStats& GetLoadingStats();
 
+        // Makes the mesh buffers created after this call use the compact formats described by the
+        // GeometryFormat_* flags in <donut/shaders/bindless.h> wherever the data allows it.
+        // Compact buffers can only be drawn with the buffer loads path of the geometry passes,
+        // and they are not suitable as inputs for acceleration structure builds.
+        void SetCompactVertexFormatEnabled(bool enable) { m_EnableCompactVertexFormat = enable; }
+        [[nodiscard]] bool IsCompactVertexFormatEnabled() const { return m_EnableCompactVertexFormat; }
+
+        // Makes the mesh buffers created after this call include meshlets, see <donut/engine/MeshletBuilder.h>,
+        // which can be drawn with the mesh shader path of GBufferFillPass. Skinned meshes have no meshlets.
+        void SetMeshletsEnabled(bool enable) { m_EnableMeshlets = enable; }
+        [[nodiscard]] bool IsMeshletsEnabled() const { return m_EnableMeshlets; }
+
+        // Makes the mesh buffers created after this call keep their CPU copies of the positions and indices
+        // (BufferGroup::positionData and indexData) for CPU consumers such as render::OcclusionCuller.
+        // The other vertex attributes are released once they are uploaded, as usual.
+        void SetCpuGeometryRetained(bool retain) { m_RetainCpuGeometry = retain; }
+        [[nodiscard]] bool IsCpuGeometryRetained() const { return m_RetainCpuGeometry; }
+
+        // Makes the models loaded after this call go through the mesh optimization stage of GltfImporter.
+        void SetMeshOptimizationEnabled(bool enable);
+
+        // Executor for the per-frame CPU work of the scene, such as the joint palettes of skinned meshes.
+        // Without an executor, that work runs on the thread that calls Refresh.
+        void SetExecutor(tf::Executor* executor) { m_Executor = executor; }
+
+        // Makes the models loaded after this call get simplified levels of detail, see <donut/engine/MeshSimplifier.h>.
+        // The levels are selected per view by the draw strategies that have a MeshLodSelector.
+        void SetLodGenerationEnabled(bool enable);
+
         [[nodiscard]] std::shared_ptr<SceneGraph> GetSceneGraph() const { return m_SceneGraph; }
         [[nodiscard]] nvrhi::IDescriptorTable* GetDescriptorTable() const { return m_DescriptorTable ? m_DescriptorTable->GetDescriptorTable() : nullptr; }
         [[nodiscard]] nvrhi::IBuffer* GetMaterialBuffer() const { return m_MaterialBuffer; }
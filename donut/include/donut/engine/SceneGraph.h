@@ -114,12 +114,15 @@ namespace donut::engine
         friend class SceneGraph;
         std::shared_ptr<MeshInfo> m_PrototypeMesh;
         uint32_t m_LastUpdateFrameIndex = 0;
+        bool m_UpdatePending = false; // joints refreshed, m_LastUpdateFrameIndex is set when they are published
         std::shared_ptr<SceneTypeFactory> m_SceneTypeFactory;
 
     public:
         std::vector<SkinnedMeshJoint> joints;
-        nvrhi::BufferHandle jointBuffer;
+        nvrhi::BufferHandle jointBuffer; // shared by all skinned instances of a Scene
         nvrhi::BindingSetHandle skinningBindingSet;
+        uint32_t jointOffset = 0; // index of the first matrix of this instance in jointBuffer
+        uint32_t jointPaletteFrameIndex = ~0u; // value of GetLastUpdateFrameIndex() when the palette was last written
         bool skinningInitialized = false;
 
         explicit SkinnedMeshInstance(std::shared_ptr<SceneTypeFactory> sceneTypeFactory, std::shared_ptr<MeshInfo> prototypeMesh);
@@ -286,6 +289,24 @@ namespace donut::engine
         SceneContentFlags m_LeafContent = SceneContentFlags::None;
         SceneContentFlags m_SubgraphContent = SceneContentFlags::None;
 
+        // Copy of the refreshed state above that is returned by the getters, see SceneGraph::PublishTransforms.
+        // The simulation can refresh the live state for the next frame while the renderer reads this one.
+        struct Snapshot
+        {
+            dm::daffine3 localTransform = dm::daffine3::identity();
+            dm::daffine3 globalTransform = dm::daffine3::identity();
+            dm::affine3 globalTransformFloat = dm::affine3::identity();
+            dm::daffine3 prevLocalTransform = dm::daffine3::identity();
+            dm::daffine3 prevGlobalTransform = dm::daffine3::identity();
+            dm::affine3 prevGlobalTransformFloat = dm::affine3::identity();
+            dm::box3 globalBoundingBox = dm::box3::empty();
+            DirtyFlags dirty = DirtyFlags::None;
+            SceneContentFlags leafContent = SceneContentFlags::None;
+            SceneContentFlags subgraphContent = SceneContentFlags::None;
+        };
+        Snapshot m_Published;
+        bool m_PublishPending = false; // refreshed since the last PublishTransforms
+
         void UpdateLocalTransform();
         void PropagateDirtyFlags(SceneGraphNode::DirtyFlags flags);
 
@@ -297,16 +318,17 @@ namespace donut::engine
         [[nodiscard]] const dm::double3& GetScaling() const { return m_Scaling; }
         [[nodiscard]] const dm::double3& GetTranslation() const { return m_Translation; }
 
-        [[nodiscard]] const dm::daffine3& GetLocalToParentTransform() const { return m_LocalTransform; }
-        [[nodiscard]] const dm::daffine3& GetLocalToWorldTransform() const { return m_GlobalTransform; }
-        [[nodiscard]] const dm::affine3& GetLocalToWorldTransformFloat() const { return m_GlobalTransformFloat; }
-        [[nodiscard]] const dm::daffine3& GetPrevLocalToParentTransform() const { return m_PrevLocalTransform; }
-        [[nodiscard]] const dm::daffine3& GetPrevLocalToWorldTransform() const { return m_PrevGlobalTransform; }
-        [[nodiscard]] const dm::affine3& GetPrevLocalToWorldTransformFloat() const { return m_PrevGlobalTransformFloat; }
-        [[nodiscard]] const dm::box3& GetGlobalBoundingBox() const { return m_GlobalBoundingBox; }
-        [[nodiscard]] DirtyFlags GetDirtyFlags() const { return m_Dirty; }
-        [[nodiscard]] SceneContentFlags GetLeafContentFlags() const { return m_LeafContent; }
-        [[nodiscard]] SceneContentFlags GetSubgraphContentFlags() const { return m_SubgraphContent; }
+        // The transforms, bounds and flags below are the ones published by the last SceneGraph::PublishTransforms
+        [[nodiscard]] const dm::daffine3& GetLocalToParentTransform() const { return m_Published.localTransform; }
+        [[nodiscard]] const dm::daffine3& GetLocalToWorldTransform() const { return m_Published.globalTransform; }
+        [[nodiscard]] const dm::affine3& GetLocalToWorldTransformFloat() const { return m_Published.globalTransformFloat; }
+        [[nodiscard]] const dm::daffine3& GetPrevLocalToParentTransform() const { return m_Published.prevLocalTransform; }
+        [[nodiscard]] const dm::daffine3& GetPrevLocalToWorldTransform() const { return m_Published.prevGlobalTransform; }
+        [[nodiscard]] const dm::affine3& GetPrevLocalToWorldTransformFloat() const { return m_Published.prevGlobalTransformFloat; }
+        [[nodiscard]] const dm::box3& GetGlobalBoundingBox() const { return m_Published.globalBoundingBox; }
+        [[nodiscard]] DirtyFlags GetDirtyFlags() const { return m_Published.dirty; }
+        [[nodiscard]] SceneContentFlags GetLeafContentFlags() const { return m_Published.leafContent; }
+        [[nodiscard]] SceneContentFlags GetSubgraphContentFlags() const { return m_Published.subgraphContent; }
 
         [[nodiscard]] SceneGraphNode* GetParent() const { return m_Parent; }
         [[nodiscard]] SceneGraphNode* GetChild(size_t index) const { return (index < m_Children.size()) ? m_Children[index].get() : nullptr; }
@@ -445,6 +467,12 @@ namespace donut::engine
         [[nodiscard]] float GetDuration() const { return m_Duration; }
         [[nodiscard]] bool IsVald() const;
         bool Apply(float time) const;  // NOLINT(modernize-use-nodiscard)
+
+        // Apply only the node transform channels, or only the leaf and material property channels.
+        // Transforms can be animated together with SceneGraph::RefreshTransforms while a frame renders,
+        // properties are read by the renderer directly and need to be applied while it is idle.
+        bool ApplyTransforms(float time) const;  // NOLINT(modernize-use-nodiscard)
+        bool ApplyLeafProperties(float time) const;  // NOLINT(modernize-use-nodiscard)
         void AddChannel(const std::shared_ptr<SceneGraphAnimationChannel>& channel);
     };
 
@@ -529,6 +557,8 @@ namespace donut::engine
         std::vector<std::shared_ptr<SceneGraphAnimation>> m_Animations;
         std::vector<std::shared_ptr<SceneCamera>> m_Cameras;
         std::vector<std::shared_ptr<Light>> m_Lights;
+
+        void RefreshNodes();
         
     protected:
         virtual void RegisterLeaf(const std::shared_ptr<SceneGraphLeaf>& leaf);
@@ -577,7 +607,16 @@ namespace donut::engine
         // If multiple nodes within one parent have the same name matching that component of the path, only the first node will be considered.
         [[nodiscard]] std::shared_ptr<SceneGraphNode> FindNode(const std::filesystem::path& path, SceneGraphNode* context = nullptr) const;
         
+        // Updates the transforms, bounding boxes and content flags of the changed nodes and publishes them to the getters.
         void Refresh(uint32_t frameIndex);
+
+        // The two halves of Refresh, for a simulation that runs on its own thread while the previous frame renders.
+        // RefreshTransforms updates the nodes without changing what the getters return, so it can overlap rendering
+        // as long as nothing else modifies the graph. It does nothing and returns false when structure changes are
+        // pending: those rebuild the instance lists and indices, so they need Refresh while rendering is idle.
+        // PublishTransforms makes the refreshed nodes visible to the getters, and must not overlap either side.
+        bool RefreshTransforms();  // NOLINT(modernize-use-nodiscard)
+        void PublishTransforms(uint32_t frameIndex);
     };
 
     struct SceneImportResult
@@ -26,6 +26,7 @@
 #include <donut/engine/DescriptorTableManager.h>
 #include <donut/shaders/light_types.h>
 #include <nvrhi/nvrhi.h>
+#include <atomic>
 #include <memory>
 
 struct MaterialConstants;
@@ -56,6 +57,11 @@ namespace donut::engine
         DescriptorHandle bindlessDescriptor;
         std::string path;
         std::string mimeType;
+
+        // Incremented every time the 'texture' of any LoadedTexture is replaced with a new object after it has
+        // been published, e.g. by mip streaming. Binding caches compare it with the value from their last check
+        // to skip looking at every texture when nothing has been replaced.
+        inline static std::atomic<uint32_t> replacementGeneration{ 0 };
     };
 
     enum class VertexAttribute
@@ -165,6 +171,19 @@ namespace donut::engine
         uint32_t numVertexBuffers;
     };
 
+    // A small cluster of triangles of one MeshGeometry, see <donut/engine/MeshletBuilder.h>
+    struct Meshlet
+    {
+        uint32_t vertexOffset = 0;   // offset of the vertex indices in BufferGroup::meshletIndexData
+        uint32_t triangleOffset = 0; // offset of the packed triangles (3x 8-bit local indices) in BufferGroup::meshletIndexData
+        uint32_t vertexCount = 0;
+        uint32_t triangleCount = 0;
+        dm::float3 center = 0.f;     // object space bounding sphere
+        float radius = 0.f;
+        dm::float3 coneAxis = 0.f;   // normal cone: average direction of the triangle normals
+        float coneCutoff = 1.f;      // see IsMeshletBackfacing, 1 means the cone test is disabled
+    };
+
     struct BufferGroup
     {
         nvrhi::BufferHandle indexBuffer;
@@ -182,12 +201,31 @@ namespace donut::engine
         std::vector<uint32_t> tangentData;
         std::vector<dm::vector<uint16_t, 4>> jointData;
         std::vector<dm::float4> weightData;
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> meshletIndexData;
+        nvrhi::BufferHandle meshletBuffer;
+        nvrhi::BufferHandle meshletIndexBuffer;
+        uint32_t formatFlags = 0; // GeometryFormat_* flags from <donut/shaders/bindless.h>
 
+        [[nodiscard]] nvrhi::Format getIndexFormat() const;
+        [[nodiscard]] uint32_t getIndexSize() const;
+        // The compact vertex formats can only be decoded by shaders that load the vertices from raw buffers.
+        [[nodiscard]] bool isInputAssemblerCompatible() const;
+        // Size of one element of the attribute in the vertex buffer, considering the compact formats.
+        [[nodiscard]] uint32_t getVertexAttributeStride(VertexAttribute attr) const;
         [[nodiscard]] bool hasAttribute(VertexAttribute attr) const { return vertexBufferRanges[int(attr)].byteSize != 0; }
         nvrhi::BufferRange& getVertexBufferRange(VertexAttribute attr) { return vertexBufferRanges[int(attr)]; }
         [[nodiscard]] const nvrhi::BufferRange& getVertexBufferRange(VertexAttribute attr) const { return vertexBufferRanges[int(attr)]; }
     };
 
+    // A simplified version of a MeshGeometry that uses the same vertices, see <donut/engine/MeshSimplifier.h>
+    struct MeshGeometryLod
+    {
+        uint32_t indexOffsetInMesh = 0;
+        uint32_t numIndices = 0;
+        float error = 0.f; // relative to the radius of the geometry bounds
+    };
+
     struct MeshGeometry
     {
         std::shared_ptr<Material> material;
@@ -196,7 +234,14 @@ namespace donut::engine
         uint32_t vertexOffsetInMesh = 0;
         uint32_t numIndices = 0;
         uint32_t numVertices = 0;
+        uint32_t firstMeshlet = 0; // range in BufferGroup::meshlets, if the meshlets were built
+        uint32_t numMeshlets = 0;
         int globalGeometryIndex = 0;
+        std::vector<MeshGeometryLod> lods; // coarser levels of detail, level 0 is the geometry itself
+
+        [[nodiscard]] uint32_t getNumLods() const { return uint32_t(lods.size()) + 1; }
+        [[nodiscard]] uint32_t getLodIndexOffsetInMesh(uint32_t lod) const { return lod == 0 ? indexOffsetInMesh : lods[lod - 1].indexOffsetInMesh; }
+        [[nodiscard]] uint32_t getLodNumIndices(uint32_t lod) const { return lod == 0 ? numIndices : lods[lod - 1].numIndices; }
 
         virtual ~MeshGeometry() = default;
     };
@@ -216,6 +261,10 @@ namespace donut::engine
         nvrhi::rt::AccelStructHandle accelStruct; // for use by applications
         bool isSkinPrototype = false;
 
+        // Decoding parameters for GeometryFormat_CompactPositions, set by Scene when the buffers are created.
+        dm::float3 positionScale = 1.f;
+        dm::float3 positionBias = 0.f;
+
         virtual ~MeshInfo() = default;
     };
     
@@ -23,10 +23,13 @@
 #pragma once
 
 #include <donut/engine/SceneTypes.h>
+#include <donut/engine/MipGenerator.h>
+#include <donut/engine/TextureResidency.h>
 #include <donut/core/log.h>
 
 #include <nvrhi/nvrhi.h>
 #include <atomic>
+#include <functional>
 #include <filesystem>
 #include <unordered_map>
 #include <memory>
@@ -71,14 +74,38 @@ namespace donut::engine
         nvrhi::TextureDimension dimension = nvrhi::TextureDimension::Unknown;
         bool isRenderTarget = false;
         bool forceSRGB = false;
+        bool isFromFile = false; // 'path' is a file that the texture can be read from again
 
         // ArraySlice -> MipLevel -> TextureSubresourceData
         std::vector<std::vector<TextureSubresourceData>> dataLayout;
+
+        // Mip streaming state. For streamed textures, 'texture' only contains the levels starting from 'residentMip'.
+        // 'data' is retained after finalization to stream the finer mips from, until mip 0 becomes resident.
+        // Textures loaded from a file then drop it and read the file again when they need it after an eviction.
+        TextureResidencyPolicy::TextureId streamingId = TextureResidencyPolicy::InvalidTextureId;
+        uint32_t residentMip = 0;
+
+        [[nodiscard]] bool IsStreamed() const { return streamingId != TextureResidencyPolicy::InvalidTextureId; }
     };
 
     class TextureCache
     {
+    public:
+        struct MaterialUsage
+        {
+            const Material* material = nullptr;
+            float screenSizeInPixels = 0.f;
+        };
+
     protected:
+        // Bindless descriptors of streamed textures that have been recreated with a new descriptor,
+        // released once the GPU has finished the frames that could still read them, see UpdateStreaming.
+        struct RetiredDescriptorBatch
+        {
+            nvrhi::EventQueryHandle query;
+            std::vector<DescriptorHandle> descriptors;
+        };
+
         nvrhi::DeviceHandle m_Device;
         nvrhi::CommandListHandle m_CommandList;
         std::unordered_map<std::string, std::shared_ptr<TextureData>> m_LoadedTextures;
@@ -93,6 +120,8 @@ namespace donut::engine
         uint32_t m_MaxTextureSize = 0;
 
         bool m_GenerateMipmaps = true;
+        bool m_GenerateMipmapsOnCPU = false;
+        MipFilter m_CpuMipFilter = MipFilter::Box;
 
         log::Severity m_InfoLogSeverity = log::Severity::Info;
         log::Severity m_ErrorLogSeverity = log::Severity::Warning;
@@ -101,6 +130,17 @@ namespace donut::engine
         std::atomic<uint32_t> m_TexturesLoaded = 0;
         uint32_t m_TexturesFinalized = 0;
 
+        bool m_StreamingEnabled = false;
+        uint32_t m_StreamingTailSize = 64;
+        float m_StreamingMipBias = 0.f;
+        uint32_t m_StreamingFrameIndex = 0;
+        TextureResidencyPolicy m_ResidencyPolicy;
+        std::vector<std::weak_ptr<TextureData>> m_StreamedTextures; // indexed by TextureResidencyPolicy::TextureId
+        std::vector<TextureResidencyPolicy::Request> m_StreamingRequests;
+        std::vector<DescriptorHandle> m_DescriptorsToRetire; // replaced by the last UpdateStreaming
+        std::queue<RetiredDescriptorBatch> m_RetiredDescriptors;
+        std::mutex m_StreamingMutex;
+
         bool FindTextureInCache(const std::filesystem::path& path, std::shared_ptr<TextureData>& texture);
         std::shared_ptr<vfs::IBlob> ReadTextureFile(const std::filesystem::path& path) const;
 
@@ -108,13 +148,26 @@ namespace donut::engine
             const std::shared_ptr<vfs::IBlob>& fileData,
             const std::shared_ptr<TextureData>& texture,
             const std::string& extension,
-            const std::string& mimeType) const;
+            const std::string& mimeType,
+            tf::Executor* executor = nullptr) const;
+
+        // Resizes decoded images to fit m_MaxTextureSize and builds their mip chains, when the format
+        // is supported by MipGenerator. The work is split into tiles over the executor's workers,
+        // or done serially without an executor or on one of its workers, see MipGenerationParams.
+        void ProcessImageOnCPU(TextureData& texture, tf::Executor* executor) const;
 
         void FinalizeTexture(
             std::shared_ptr<TextureData> texture,
             CommonRenderPasses* passes,
             nvrhi::ICommandList* commandList);
 
+        bool IsTextureStreamable(const TextureData& texture, uint32_t& outNumTailMips) const;
+        void FinalizeStreamedTexture(const std::shared_ptr<TextureData>& texture, uint32_t numTailMips, nvrhi::ICommandList* commandList);
+        void CreateStreamedTextureMips(TextureData& texture, uint32_t firstMip, nvrhi::ICommandList* commandList);
+        bool ReloadStreamedTextureData(TextureData& texture);
+        void ReleaseRetiredDescriptors();
+        [[nodiscard]] uint32_t GetRequiredStreamingMip(const TextureData& texture, float screenSizeInPixels) const;
+
         virtual void TextureLoaded(std::shared_ptr<TextureData> texture);
         virtual std::shared_ptr<TextureData> CreateTextureData();
 
@@ -196,12 +249,58 @@ namespace donut::engine
         void LoadingFinished();
 
         // Set the maximum texture size allowed after load. Larger textures are resized to fit this constraint.
-        // Currently does not affect DDS textures.
+        // Uncompressed images are resized on the CPU when they are decoded. Currently does not affect DDS textures.
         void SetMaxTextureSize(uint32_t size);
 
         // Enables or disables automatic mip generation for loaded textures.
         void SetGenerateMipmaps(bool generateMipmaps);
 
+        // Makes the automatic mip generation happen on the CPU when the image is decoded, i.e. on the loader threads
+        // for async loads, instead of on the GPU when the texture is finalized. Mip chains generated on the CPU
+        // are filtered in linear space for sRGB textures and make the textures eligible for mip streaming.
+        void SetGenerateMipmapsOnCPU(bool enable, MipFilter filter = MipFilter::Box);
+
+        // Enables mip streaming for textures that come with a full mip chain in the file (i.e. DDS),
+        // or get one from SetGenerateMipmapsOnCPU.
+        // Streamed textures are created with only their tail mips, and the finer levels are loaded
+        // on demand based on the feedback passed to ReportTextureUsage, within the memory budget.
+        // Must be set before the textures are loaded.
+        void SetStreamingEnabled(bool enabled) { m_StreamingEnabled = enabled; }
+        [[nodiscard]] bool IsStreamingEnabled() const { return m_StreamingEnabled; }
+
+        // Sets the video memory budget for the mips of all streamed textures, in bytes. 0 means unlimited.
+        void SetStreamingMemoryBudget(uint64_t bytes);
+
+        // Mip levels whose largest dimension is this size or smaller are always resident.
+        void SetStreamingTailSize(uint32_t size) { m_StreamingTailSize = std::max(size, 1u); }
+
+        // Positive values make streaming request coarser mips than the screen size suggests.
+        void SetStreamingMipBias(float bias) { m_StreamingMipBias = bias; }
+
+        // Records that the texture covers approximately `screenSizeInPixels` pixels across on the screen
+        // in the current frame. Ignored for textures that are not streamed.
+        void ReportTextureUsage(const std::shared_ptr<LoadedTexture>& texture, float screenSizeInPixels);
+
+        // Same as ReportTextureUsage, for all textures referenced by the material.
+        void ReportMaterialUsage(const Material& material, float screenSizeInPixels);
+
+        // Same as ReportMaterialUsage for a batch of materials, e.g. everything drawn by a pass,
+        // with one lock of the streaming state instead of one per texture.
+        void ReportMaterialUsage(const std::vector<MaterialUsage>& usages);
+
+        // Applies the residency decisions for the current frame: recreates streamed textures with
+        // finer or coarser mip sets. Binding sets created after this call use the new textures.
+        // Recreated textures get new bindless descriptors, and LoadedTexture::replacementGeneration
+        // is incremented so that Scene::RefreshBuffers writes the new indices to the materials.
+        // The previous descriptors are released once the GPU has finished the frames that were
+        // submitted before the next call, because those may still read them.
+        // Call once per frame on the rendering thread, before the textures are used and before
+        // Scene::RefreshBuffers.
+        // Returns true if any textures have been recreated.
+        bool UpdateStreaming();
+
+        [[nodiscard]] const TextureResidencyPolicy& GetResidencyPolicy() const { return m_ResidencyPolicy; }
+
         // Sets the Severity of log messages about textures being loaded.
         void SetInfoLogSeverity(log::Severity value) { m_InfoLogSeverity = value; }
 
@@ -255,4 +354,21 @@ namespace donut::engine
         nvrhi::ResourceStates textureState,
         const char* fileName,
         bool saveAlphaChannel = true);
+
+    class ReadbackQueue;
+
+    // Asynchronous version of SaveTextureToFile. Records the copy of the texture's slice 0 mip level 0
+    // into the command list, which must be open and must track the texture's state. Pass the command list
+    // to ReadbackQueue::OnCommandListExecuted after executing it. The image is encoded
+    // and written on the readback queue's worker thread a few frames later, and then onComplete
+    // is called on that thread. Returns false if the file name is not supported.
+    bool SaveTextureToFileAsync(
+        nvrhi::IDevice* device,
+        CommonRenderPasses* pPasses,
+        nvrhi::ICommandList* commandList,
+        nvrhi::ITexture* texture,
+        const char* fileName,
+        ReadbackQueue& readbackQueue,
+        bool saveAlphaChannel = true,
+        std::function<void(bool success)> onComplete = nullptr);
 }
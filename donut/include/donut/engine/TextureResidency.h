@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace donut::engine
+{
+    /*
+    TextureResidencyPolicy decides which mip levels of streamed textures should be
+    resident in video memory. It doesn't touch any graphics resources: the owner
+    (normally TextureCache) registers textures with their per-mip sizes, feeds back
+    the finest mip level that was required for rendering, and applies the requests
+    returned from Update(...), confirming each with SetResidentMip(...).
+
+    Mip levels are numbered like in the graphics APIs, 0 being the finest level.
+    The "tail" mips of every texture are always resident and never evicted.
+    */
+    class TextureResidencyPolicy
+    {
+    public:
+        typedef uint32_t TextureId;
+        static constexpr TextureId InvalidTextureId = ~0u;
+
+        struct Request
+        {
+            TextureId texture = InvalidTextureId;
+            uint32_t currentMip = 0;  // finest mip level that is currently resident
+            uint32_t requestedMip = 0; // finest mip level that should be resident after the update
+
+            [[nodiscard]] bool IsEviction() const { return requestedMip > currentMip; }
+        };
+
+        // Registers a texture whose mip level i occupies mipSizes[i] bytes.
+        // Initially, only the numTailMips coarsest levels are considered resident.
+        TextureId RegisterTexture(const std::vector<uint64_t>& mipSizes, uint32_t numTailMips);
+        void UnregisterTexture(TextureId texture);
+
+        // Records that the texture has been used with the given finest mip level on the given frame.
+        // Multiple reports for the same frame are combined by taking the finest level.
+        void ReportRequiredMip(TextureId texture, uint32_t mipLevel, uint32_t frameIndex);
+
+        // Informs the policy that the texture has been (re)created with the given finest resident level.
+        void SetResidentMip(TextureId texture, uint32_t mipLevel);
+
+        // Computes the residency targets for the current frame and fills outRequests with
+        // the textures whose resident set needs to change. Evictions are always reported,
+        // while the number of promotions (streaming finer mips in) is limited by SetMaxPromotionsPerUpdate.
+        void Update(uint32_t frameIndex, std::vector<Request>& outRequests);
+
+        // Sets the video memory budget for all registered textures, in bytes. 0 means unlimited.
+        void SetMemoryBudget(uint64_t bytes) { m_MemoryBudget = bytes; }
+        [[nodiscard]] uint64_t GetMemoryBudget() const { return m_MemoryBudget; }
+
+        // Feedback older than this number of frames is ignored, and textures fall back to their tails.
+        void SetFeedbackLifetime(uint32_t frames) { m_FeedbackLifetime = frames; }
+        void SetMaxPromotionsPerUpdate(uint32_t count) { m_MaxPromotions = count; }
+
+        [[nodiscard]] bool IsTextureRegistered(TextureId texture) const { return texture < m_Textures.size() && m_Textures[texture].registered; }
+        [[nodiscard]] uint32_t GetResidentMip(TextureId texture) const;
+        [[nodiscard]] uint32_t GetTailMip(TextureId texture) const;
+        [[nodiscard]] uint64_t GetResidentMemory() const { return m_ResidentMemory; }
+        [[nodiscard]] uint64_t GetTextureMemory(TextureId texture, uint32_t finestMip) const;
+        [[nodiscard]] size_t GetNumTextures() const { return m_Textures.size() - m_FreeIds.size(); }
+
+    private:
+        struct TextureState
+        {
+            std::vector<uint64_t> mipSizes;
+            uint32_t tailMip = 0;
+            uint32_t residentMip = 0;
+            uint32_t requiredMip = 0;
+            uint32_t lastUsedFrame = 0;
+            bool used = false;
+            bool registered = false;
+        };
+
+        std::vector<TextureState> m_Textures;
+        std::vector<TextureId> m_FreeIds;
+        uint64_t m_MemoryBudget = 0;
+        uint64_t m_ResidentMemory = 0;
+        uint32_t m_FeedbackLifetime = 30;
+        uint32_t m_MaxPromotions = 8;
+
+        [[nodiscard]] uint32_t GetDesiredMip(const TextureState& state, uint32_t frameIndex) const;
+        static uint64_t GetMemory(const TextureState& state, uint32_t finestMip);
+    };
+}
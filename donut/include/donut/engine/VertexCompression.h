@@ -0,0 +1,56 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace donut::engine
+{
+    /*
+    Encoders for the compact mesh buffer formats described by the GeometryFormat_* flags in
+    <donut/shaders/bindless.h>. The matching decoders for the shaders are LoadVertexPosition,
+    LoadVertexTexCoord, LoadVertexJointWeights and LoadTriangleIndices in the same header.
+    */
+
+    // Texture coordinates are only stored as half floats when all of them are within [-MaxCompactTexCoord, MaxCompactTexCoord].
+    // Beyond that, the half float step exceeds 1/1024 and would visibly shift texels on high resolution textures.
+    constexpr float MaxCompactTexCoord = 2.f;
+
+    // Compact positions are 16-bit UNORM values relative to the bounds of their mesh.
+    // They are decoded as: position = float3(quantized.xyz) * scale + bias.
+    void GetPositionDequantization(const dm::box3& bounds, dm::float3& outScale, dm::float3& outBias);
+    [[nodiscard]] dm::vector<uint16_t, 4> QuantizePosition(const dm::float3& position, const dm::float3& scale, const dm::float3& bias);
+
+    // IEEE 754 binary16 conversions, rounding to nearest even.
+    [[nodiscard]] uint16_t FloatToHalf(float value);
+    [[nodiscard]] float HalfToFloat(uint16_t value);
+    [[nodiscard]] uint32_t PackTexCoordHalf(const dm::float2& texCoord);
+
+    // Packs 4 joint weights into RGBA8_UNORM. The weights are normalized first,
+    // and the rounding error is assigned to the largest weight so that they still sum up to 1.
+    [[nodiscard]] uint32_t PackJointWeightsUnorm8(const dm::float4& weights);
+
+    [[nodiscard]] bool CanUse16BitIndices(const uint32_t* indices, size_t count);
+    [[nodiscard]] bool CanUseCompactTexCoords(const dm::float2* texCoords, size_t count);
+}
@@ -28,14 +28,28 @@
 #include <nvrhi/nvrhi.h>
 #include <memory>
 
+namespace donut::engine
+{
+    class FramebufferFactory;
+}
+
 namespace donut::render
 {
     class PlanarShadowMap;
+    class ShadowCasterCache;
+    class InstancedOpaqueDrawStrategy;
+    class IGeometryPass;
+    class GeometryPassContext;
 
     class CascadedShadowMap : public engine::IShadowMap
     {
     private:
+        nvrhi::DeviceHandle m_Device;
         nvrhi::TextureHandle m_ShadowMapTexture;
+        nvrhi::TextureHandle m_StaticTexture;
+        std::shared_ptr<engine::FramebufferFactory> m_Framebuffer;
+        std::shared_ptr<engine::FramebufferFactory> m_StaticFramebuffer;
+        std::shared_ptr<ShadowCasterCache> m_CasterCache;
         std::vector<std::shared_ptr<PlanarShadowMap>> m_Cascades;
         std::vector<std::shared_ptr<PlanarShadowMap>> m_PerObjectShadows;
         engine::CompositeView m_CompositeView;
@@ -91,6 +105,23 @@ namespace donut::render
 
         void Clear(nvrhi::ICommandList* commandList);
 
+        // Enables caching of the static shadow casters: a second texture keeps the static casters
+        // of every cascade, and Render(...) only updates the parts reported by the caster cache.
+        void EnableStaticCaching(bool enable);
+        [[nodiscard]] bool IsStaticCachingEnabled() const { return m_CasterCache != nullptr; }
+        [[nodiscard]] const std::shared_ptr<ShadowCasterCache>& GetCasterCache() const { return m_CasterCache; }
+
+        // Renders the active cascades with the given depth pass. Call after the cascades are set up
+        // for the frame and the scene graph is refreshed. Without static caching, the shadow map is
+        // cleared and all casters are rendered. The instance filter of the draw strategy is reset.
+        void Render(
+            nvrhi::ICommandList* commandList,
+            const engine::SceneGraph& sceneGraph,
+            uint32_t frameIndex,
+            InstancedOpaqueDrawStrategy& drawStrategy,
+            IGeometryPass& depthPass,
+            GeometryPassContext& passContext);
+
         void SetLitOutOfBounds(bool litOutOfBounds);
         void SetFalloffDistance(float distance);
 		void SetNumberOfCascadesUnsafe(int cascades);
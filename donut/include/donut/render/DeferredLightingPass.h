@@ -42,6 +42,7 @@ namespace donut::engine
 namespace donut::render
 {
     class GBufferRenderTargets;
+    class LightClusteringPass;
     
     class DeferredLightingPass
     {
@@ -53,8 +54,10 @@ namespace donut::render
         nvrhi::SamplerHandle m_ShadowSamplerComparison;
         nvrhi::BufferHandle m_DeferredLightingCB;
         nvrhi::ComputePipelineHandle m_Pso;
+        nvrhi::ComputePipelineHandle m_ClusteredPso;
 
         nvrhi::BindingLayoutHandle m_BindingLayout;
+        nvrhi::BindingLayoutHandle m_ClusteredBindingLayout;
         engine::BindingCache m_BindingSets;
 
         std::shared_ptr<engine::CommonRenderPasses> m_CommonPasses;
@@ -62,7 +65,8 @@ namespace donut::render
     protected:
 
         virtual nvrhi::ShaderHandle CreateComputeShader(
-            engine::ShaderFactory& shaderFactory);
+            engine::ShaderFactory& shaderFactory,
+            bool clusteredLighting);
 
     public:
         struct Inputs
@@ -81,6 +85,10 @@ namespace donut::render
             const std::vector<std::shared_ptr<engine::Light>>* lights = nullptr;
             const std::vector<std::shared_ptr<engine::LightProbe>>* lightProbes = nullptr;
 
+            // Optional light clusters built for the same view. When provided, the lights that
+            // LightClusteringPass::IsClusteredLight accepts are taken from the clusters instead of 'lights'.
+            const LightClusteringPass* lightClusters = nullptr;
+
             dm::float3 ambientColorTop = 0.f;
             dm::float3 ambientColorBottom = 0.f;
 
@@ -65,6 +65,7 @@ namespace donut::render
 
             uint32_t positionOffset = 0;
             uint32_t texCoordOffset = 0;
+            uint32_t formatFlags = 0;
             
             Context()
             {
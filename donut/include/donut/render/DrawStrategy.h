@@ -23,17 +23,65 @@
 #pragma once
 
 #include <donut/engine/SceneGraph.h>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace donut::engine
 {
     class IView;
+    class TextureCache;
 }
 
 namespace donut::render
 {
     struct DrawItem;
+    class OcclusionCuller;
+
+    /*
+    MeshLodSelector picks the levels of detail of the drawn geometries from their projected
+    error in pixels, see SelectMeshLod in <donut/engine/MeshSimplifier.h>. Perspective views use
+    the distance to the geometry, while orthographic views such as shadow cascades select the
+    levels from the texel size alone.
+
+    The selector remembers the level of every instance and geometry in every view to apply
+    hysteresis, so a single selector should be shared by all the draw strategies that render
+    the same views, including the per-view strategies created for ParallelGeometryPasses.
+    BeginView(...) is thread-safe, but each view must be processed by one strategy at a time.
+    */
+    class MeshLodSelector
+    {
+    public:
+        struct ViewLods;
+
+        MeshLodSelector();
+        ~MeshLodSelector();
+
+        // Returns the selection state of the view, creating it on first use.
+        ViewLods* BeginView(const engine::IView& view);
+
+        [[nodiscard]] uint32_t SelectLod(ViewLods& viewLods, const engine::MeshInstance* instance,
+            const engine::MeshGeometry* geometry, const dm::box3& globalBounds) const;
+
+        // Forgets the state of all views, e.g. after the scene is reloaded.
+        void Reset();
+
+        // Largest projected error of a selected level, in pixels or shadow map texels
+        void SetMaxPixelError(float pixels) { m_MaxPixelError = pixels; }
+        [[nodiscard]] float GetMaxPixelError() const { return m_MaxPixelError; }
+
+        // Relative width of the band around the switching points where the current level is kept
+        void SetHysteresis(float hysteresis) { m_Hysteresis = hysteresis; }
+        [[nodiscard]] float GetHysteresis() const { return m_Hysteresis; }
+
+    private:
+        std::mutex m_Mutex;
+        std::unordered_map<const engine::IView*, std::unique_ptr<ViewLods>> m_Views;
+        float m_MaxPixelError = 1.f;
+        float m_Hysteresis = 0.25f;
+    };
 
     class IDrawStrategy
     {
@@ -73,7 +121,21 @@ namespace donut::render
         size_t m_ReadPtr = 0;
         size_t m_ChunkSize = 128;
 
+        std::shared_ptr<engine::TextureCache> m_TextureStreamingFeedback;
+        dm::float3 m_ViewOrigin = 0.f;
+        float m_ProjectedSizeScale = 0.f; // 0 means no feedback is produced for the current view
+        std::unordered_map<const engine::Material*, float> m_MaterialScreenSizes; // largest size of every material drawn in the view
+
+        std::shared_ptr<MeshLodSelector> m_LodSelector;
+        MeshLodSelector::ViewLods* m_ViewLods = nullptr;
+
+        std::shared_ptr<OcclusionCuller> m_OcclusionCuller;
+
+        std::function<bool(const engine::MeshInstance&)> m_InstanceFilter;
+
         void FillChunk();
+        void AccumulateTextureUsage(const DrawItem& item, const dm::box3& globalBounds);
+        void FlushTextureUsage();
 
     public:
 
@@ -85,6 +147,23 @@ namespace donut::render
 
         [[nodiscard]] size_t GetChunkSize() const { return m_ChunkSize; }
         void SetChunkSize(size_t size) { m_ChunkSize = std::max<size_t>(size, 1u); }
+
+        // When set, the strategy reports the approximate screen size of every drawn geometry
+        // to the texture cache to drive mip streaming. Only perspective views produce feedback.
+        void SetTextureStreamingFeedback(std::shared_ptr<engine::TextureCache> textureCache) { m_TextureStreamingFeedback = std::move(textureCache); }
+
+        // When set, the geometries that have simplified levels of detail are drawn with the level picked by the selector.
+        void SetLodSelector(std::shared_ptr<MeshLodSelector> lodSelector) { m_LodSelector = std::move(lodSelector); }
+
+        // When set, the culler rasterizes the occluders of every view in PrepareForView, and the nodes
+        // and geometries hidden behind them are skipped. The culler holds the state of one view,
+        // so each strategy that is used concurrently with others needs its own culler.
+        void SetOcclusionCuller(std::shared_ptr<OcclusionCuller> occlusionCuller) { m_OcclusionCuller = std::move(occlusionCuller); }
+        [[nodiscard]] const std::shared_ptr<OcclusionCuller>& GetOcclusionCuller() const { return m_OcclusionCuller; }
+
+        // When set, only the mesh instances for which the filter returns true are drawn,
+        // e.g. the static or the dynamic shadow casters, see ShadowCasterCache.
+        void SetInstanceFilter(std::function<bool(const engine::MeshInstance&)> filter) { m_InstanceFilter = std::move(filter); }
     };
 
     class TransparentDrawStrategy : public IDrawStrategy
@@ -93,6 +172,7 @@ namespace donut::render
         std::vector<DrawItem> m_InstancesToDraw;
         std::vector<const DrawItem*> m_InstancePtrsToDraw;
         size_t m_ReadPtr = 0;
+        std::shared_ptr<MeshLodSelector> m_LodSelector;
 
     public:
         bool DrawDoubleSidedMaterialsSeparately = true;
@@ -102,5 +182,7 @@ namespace donut::render
             const engine::IView& view) override;
 
         const DrawItem* GetNextItem() override;
+
+        void SetLodSelector(std::shared_ptr<MeshLodSelector> lodSelector) { m_LodSelector = std::move(lodSelector); }
     };
 }
\ No newline at end of file
@@ -55,6 +55,8 @@ namespace std
 
 namespace donut::render
 {
+    class LightClusteringPass;
+
     class ForwardShadingPass : public IGeometryPass
     {
     public:
@@ -83,6 +85,7 @@ namespace donut::render
             uint32_t texCoordOffset = 0;
             uint32_t normalOffset = 0;
             uint32_t tangentOffset = 0;
+            uint32_t formatFlags = 0;
 
             Context()
             {
@@ -100,6 +103,10 @@ namespace donut::render
             // Using Buffer SRVs is often faster.
             bool useInputAssembler = false;
 
+            // Enables clustered lighting with the clusters that the application builds with this pass
+            // for every view before rendering. Only planar views are supported in this mode.
+            std::shared_ptr<LightClusteringPass> lightClusters;
+
             uint32_t numConstantBufferVersions = 16;
         };
 
@@ -130,6 +137,7 @@ namespace donut::render
         
         std::shared_ptr<engine::CommonRenderPasses> m_CommonPasses;
         std::shared_ptr<engine::MaterialBindingCache> m_MaterialBindings;
+        std::shared_ptr<LightClusteringPass> m_LightClusters;
         
         virtual nvrhi::ShaderHandle CreateVertexShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
         virtual nvrhi::ShaderHandle CreateGeometryShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
@@ -30,16 +30,20 @@ namespace donut::engine
 {
     class CommonRenderPasses;
     class FramebufferFactory;
+    class ShaderFactory;
 }
 
 namespace donut::render
 {
+    class MipMapGenPass;
+
     class GBufferRenderTargets
     {
     protected:
         dm::uint2 m_Size = dm::uint2::zero();
         dm::uint m_SampleCount = 0;
         bool m_UseReverseProjection = false;
+        std::shared_ptr<MipMapGenPass> m_HiZPass;
 
     public:
         nvrhi::TextureHandle Depth;
@@ -50,6 +54,12 @@ namespace donut::render
 
         nvrhi::TextureHandle MotionVectors;
 
+        // Hierarchical depth: min and max of the depth buffer in RG, level 0 having a texel
+        // per 2x2 pixels. The pyramid is padded to a power of 2 so that every texel covers
+        // its whole footprint. It's created by the first BuildHiZ call, and only for
+        // single-sampled targets; until then it's null.
+        nvrhi::TextureHandle HiZ;
+
         std::shared_ptr<engine::FramebufferFactory> GBufferFramebuffer;
 
         virtual ~GBufferRenderTargets() = default;
@@ -63,6 +73,13 @@ namespace donut::render
 
         virtual void Clear(nvrhi::ICommandList* commandList);
 
+        // Reduces the current contents of Depth into HiZ, using a single-pass MipMapGenPass.
+        // Creates HiZ on the first call; does nothing for multisampled targets.
+        void BuildHiZ(nvrhi::ICommandList* commandList, const std::shared_ptr<engine::ShaderFactory>& shaderFactory);
+
+        // Size of level 0 of the HiZ pyramid for a depth buffer of the given size
+        [[nodiscard]] static dm::uint2 GetHiZSize(dm::uint2 depthSize);
+
         [[nodiscard]] dm::uint2 GetSize() const { return m_Size; }
         [[nodiscard]] dm::uint GetSampleCount() const { return m_SampleCount; }
         [[nodiscard]] bool GetUseReverseProjection() const { return m_UseReverseProjection; }
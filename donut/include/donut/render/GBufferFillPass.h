@@ -39,6 +39,8 @@ namespace donut::engine
 
 namespace donut::render
 {
+    class GpuCullingPass;
+
     class GBufferFillPass : public IGeometryPass
     {
     public:
@@ -50,16 +52,18 @@ namespace donut::render
                 bool alphaTested : 1;
                 bool frontCounterClockwise : 1;
                 bool reverseDepth : 1;
+                bool indirect : 1;
             } bits;
             uint32_t value;
 
-            static constexpr size_t Count = 1 << 5;
+            static constexpr size_t Count = 1 << 6;
         };
 
         class Context : public GeometryPassContext
         {
         public:
             nvrhi::BindingSetHandle inputBindingSet;
+            nvrhi::BindingSetHandle meshletInputBindingSet;
             PipelineKey keyTemplate;
 
             uint32_t positionOffset = 0;
@@ -67,6 +71,8 @@ namespace donut::render
             uint32_t texCoordOffset = 0;
             uint32_t normalOffset = 0;
             uint32_t tangentOffset = 0;
+            uint32_t formatFlags = 0;
+            uint32_t meshletCullFlags = 0;
 
             Context()
             {
@@ -86,6 +92,15 @@ namespace donut::render
             // Using Buffer SRVs is often faster.
             bool useInputAssembler = false;
 
+            // Draws the geometries that have meshlets (see Scene::SetMeshletsEnabled) with task and mesh shaders,
+            // culling the meshlets against the view frustum and their normal cones. Other geometries use
+            // the regular path. Ignored when the device doesn't support meshlets, or on single-pass cubemaps.
+            bool useMeshShaders = false;
+
+            // Creates the vertex shader for the draws culled on the GPU, see RenderIndirect.
+            // Requires the buffer loads path.
+            bool enableIndirectDraws = false;
+
             uint32_t stencilWriteMask = 0;
             uint32_t numConstantBufferVersions = 16;
         };
@@ -94,18 +109,25 @@ namespace donut::render
         nvrhi::DeviceHandle m_Device;
         nvrhi::InputLayoutHandle m_InputLayout;
         nvrhi::ShaderHandle m_VertexShader;
+        nvrhi::ShaderHandle m_IndirectVertexShader;
+        nvrhi::InputLayoutHandle m_IndirectInputLayout;
         nvrhi::ShaderHandle m_PixelShader;
         nvrhi::ShaderHandle m_PixelShaderAlphaTested;
         nvrhi::ShaderHandle m_GeometryShader;
+        nvrhi::ShaderHandle m_TaskShader;
+        nvrhi::ShaderHandle m_MeshShader;
         nvrhi::BindingLayoutHandle m_InputBindingLayout;
+        nvrhi::BindingLayoutHandle m_MeshletInputBindingLayout;
         nvrhi::BindingLayoutHandle m_ViewBindingLayout;
         nvrhi::BindingSetHandle m_ViewBindings;
         nvrhi::BufferHandle m_GBufferCB;
         engine::ViewType::Enum m_SupportedViewTypes = engine::ViewType::PLANAR;
         nvrhi::GraphicsPipelineHandle m_Pipelines[PipelineKey::Count];
+        nvrhi::MeshletPipelineHandle m_MeshletPipelines[PipelineKey::Count];
         std::mutex m_Mutex;
 
         std::unordered_map<const engine::BufferGroup*, nvrhi::BindingSetHandle> m_InputBindingSets;
+        std::unordered_map<const engine::BufferGroup*, nvrhi::BindingSetHandle> m_MeshletInputBindingSets;
 
         std::shared_ptr<engine::CommonRenderPasses> m_CommonPasses;
         std::shared_ptr<engine::MaterialBindingCache> m_MaterialBindings;
@@ -114,18 +136,29 @@ namespace donut::render
         bool m_EnableMotionVectors = false;
         bool m_IsDX11 = false;
         bool m_UseInputAssembler = false;
+        bool m_UseMeshShaders = false;
         uint32_t m_StencilWriteMask = 0;
         
         virtual nvrhi::ShaderHandle CreateVertexShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
+        virtual nvrhi::ShaderHandle CreateIndirectVertexShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
         virtual nvrhi::ShaderHandle CreateGeometryShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
         virtual nvrhi::ShaderHandle CreatePixelShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params, bool alphaTested);
+        virtual nvrhi::ShaderHandle CreateTaskShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
+        virtual nvrhi::ShaderHandle CreateMeshShader(engine::ShaderFactory& shaderFactory, const CreateParameters& params);
         virtual nvrhi::InputLayoutHandle CreateInputLayout(nvrhi::IShader* vertexShader, const CreateParameters& params);
+        virtual nvrhi::InputLayoutHandle CreateIndirectInputLayout(nvrhi::IShader* vertexShader);
         virtual nvrhi::BindingLayoutHandle CreateInputBindingLayout();
         virtual nvrhi::BindingSetHandle CreateInputBindingSet(const engine::BufferGroup* bufferGroup);
+        virtual nvrhi::BindingLayoutHandle CreateMeshletInputBindingLayout();
+        virtual nvrhi::BindingSetHandle CreateMeshletInputBindingSet(const engine::BufferGroup* bufferGroup);
         virtual void CreateViewBindings(nvrhi::BindingLayoutHandle& layout, nvrhi::BindingSetHandle& set, const CreateParameters& params);
         virtual std::shared_ptr<engine::MaterialBindingCache> CreateMaterialBindingCache(engine::CommonRenderPasses& commonPasses);
         virtual nvrhi::GraphicsPipelineHandle CreateGraphicsPipeline(PipelineKey key, nvrhi::IFramebuffer* sampleFramebuffer);
+        virtual nvrhi::MeshletPipelineHandle CreateMeshletPipeline(PipelineKey key, nvrhi::IFramebuffer* sampleFramebuffer);
+        void FillRenderState(PipelineKey key, nvrhi::RenderState& renderState, nvrhi::ShaderHandle& pixelShader) const;
         nvrhi::BindingSetHandle GetOrCreateInputBindingSet(const engine::BufferGroup* bufferGroup);
+        nvrhi::BindingSetHandle GetOrCreateMeshletInputBindingSet(const engine::BufferGroup* bufferGroup);
+        static bool GetMaterialPipelineKey(const engine::Material* material, PipelineKey& key);
         
     public:
         GBufferFillPass(nvrhi::IDevice* device, std::shared_ptr<engine::CommonRenderPasses> commonPasses);
@@ -135,6 +168,16 @@ namespace donut::render
             const CreateParameters& params);
 
         void ResetBindingCache();
+
+        // Draws the geometries that passed the culling in GpuCullingPass::Render for the same view,
+        // with one multi-draw indirect call per bucket. Requires CreateParameters::enableIndirectDraws.
+        void RenderIndirect(
+            nvrhi::ICommandList* commandList,
+            const engine::IView* view,
+            const engine::IView* viewPrev,
+            nvrhi::IFramebuffer* framebuffer,
+            const GpuCullingPass& cullingPass,
+            Context& context);
         
         // IGeometryPass implementation
 
@@ -143,6 +186,10 @@ namespace donut::render
         bool SetupMaterial(GeometryPassContext& context, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::GraphicsState& state) override;
         void SetupInputBuffers(GeometryPassContext& context, const engine::BufferGroup* buffers, nvrhi::GraphicsState& state) override;
         void SetPushConstants(GeometryPassContext& context, nvrhi::ICommandList* commandList, nvrhi::GraphicsState& state, nvrhi::DrawArguments& args) override;
+        [[nodiscard]] bool SupportsMeshlets(const DrawItem& item) const override;
+        bool SetupMeshletMaterial(GeometryPassContext& context, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::MeshletState& state) override;
+        void SetupMeshletInputBuffers(GeometryPassContext& context, const engine::BufferGroup* buffers, nvrhi::MeshletState& state) override;
+        void DispatchMeshlets(GeometryPassContext& context, nvrhi::ICommandList* commandList, const DrawItem& item, uint32_t instanceCount) override;
     };
 
     class MaterialIDPass : public GBufferFillPass
@@ -49,6 +49,7 @@ namespace donut::render
         const engine::BufferGroup* buffers;
         float distanceToCamera;
         nvrhi::RasterCullMode cullMode;
+        uint32_t lod = 0; // level of detail of the geometry, see MeshGeometry::lods
     };
 
     class GeometryPassContext
@@ -63,6 +64,14 @@ namespace donut::render
         virtual bool SetupMaterial(GeometryPassContext& context, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::GraphicsState& state) = 0;
         virtual void SetupInputBuffers(GeometryPassContext& context, const engine::BufferGroup* buffers, nvrhi::GraphicsState& state) = 0;
         virtual void SetPushConstants(GeometryPassContext& context, nvrhi::ICommandList* commandList, nvrhi::GraphicsState& state, nvrhi::DrawArguments& args) = 0;
+
+        // Optional mesh shader path: the items for which SupportsMeshlets returns true are drawn with the
+        // Meshlet versions of the functions above instead, and DispatchMeshlets replaces the indexed draw.
+        [[nodiscard]] virtual bool SupportsMeshlets(const DrawItem& item) const { return false; }
+        virtual bool SetupMeshletMaterial(GeometryPassContext& context, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::MeshletState& state) { return false; }
+        virtual void SetupMeshletInputBuffers(GeometryPassContext& context, const engine::BufferGroup* buffers, nvrhi::MeshletState& state) { }
+        virtual void DispatchMeshlets(GeometryPassContext& context, nvrhi::ICommandList* commandList, const DrawItem& item, uint32_t instanceCount) { }
+
         virtual ~IGeometryPass() = default;
     };
 
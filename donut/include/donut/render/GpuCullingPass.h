@@ -0,0 +1,157 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <nvrhi/nvrhi.h>
+#include <memory>
+#include <vector>
+
+namespace donut::engine
+{
+    class ShaderFactory;
+    class CommonRenderPasses;
+    class IView;
+    class MeshInstance;
+    struct BufferGroup;
+    struct Material;
+    struct MeshGeometry;
+}
+
+namespace donut::render
+{
+    // A range of indirect draws that share the pipeline state, material and vertex buffers
+    struct IndirectDrawBucket
+    {
+        const engine::Material* material = nullptr;
+        const engine::BufferGroup* buffers = nullptr;
+        nvrhi::RasterCullMode cullMode = nvrhi::RasterCullMode::Back;
+        uint32_t firstDraw = 0;
+        uint32_t maxDraws = 0; // number of candidates in the bucket
+    };
+
+    // One geometry of one mesh instance, see GpuCullingCandidate in <donut/shaders/gpu_culling_cb.h>
+    struct IndirectDrawCandidate
+    {
+        uint32_t instanceIndex = 0;
+        uint32_t bucket = 0;
+        uint32_t indexCount = 0;
+        uint32_t startIndexLocation = 0;
+        uint32_t vertexOffset = 0;
+        dm::box3 objectSpaceBounds; // empty for the geometries that are never culled
+    };
+
+    /*
+    IndirectDrawList groups the opaque and alpha tested geometries of the scene into buckets
+    that can be drawn with one multi-draw indirect call each. It doesn't touch any graphics
+    resources, see GpuCullingPass.
+
+    The candidates are sorted by bucket, and the buckets are sorted by vertex buffers and then
+    materials, so that consecutive buckets change as little state as possible. Skinned meshes
+    are never culled because their bounds are only known on the CPU, and all geometries are
+    drawn with their full level of detail.
+    */
+    class IndirectDrawList
+    {
+    public:
+        void Build(const std::vector<std::shared_ptr<engine::MeshInstance>>& meshInstances);
+        void Clear();
+
+        [[nodiscard]] const std::vector<IndirectDrawBucket>& GetBuckets() const { return m_Buckets; }
+        [[nodiscard]] const std::vector<IndirectDrawCandidate>& GetCandidates() const { return m_Candidates; }
+
+    private:
+        std::vector<IndirectDrawBucket> m_Buckets;
+        std::vector<IndirectDrawCandidate> m_Candidates;
+    };
+
+    /*
+    GpuCullingPass culls the draws of an IndirectDrawList against the view frustum and, optionally,
+    a hierarchical depth buffer on the GPU, and compacts the surviving draws of every bucket into
+    an indirect argument buffer. The draws are consumed with GBufferFillPass::RenderIndirect, so the
+    CPU cost of a frame depends on the number of buckets instead of the number of instances.
+
+    The slots of every bucket that are not used in the current frame are left as empty draws:
+    nvrhi::ICommandList::drawIndexedIndirect takes the number of draws from the CPU.
+
+    The HiZ texture is a pyramid of the minimum and maximum depth covered by every texel, where
+    level 0 has a texel per 2x2 pixels of the view, as built by GBufferRenderTargets::BuildHiZ
+    from the depth of the previous frame.
+    It is tested with the view that rendered it, so objects that become visible through camera motion
+    or disocclusion may appear one frame late.
+    */
+    class GpuCullingPass
+    {
+    private:
+        nvrhi::DeviceHandle m_Device;
+        std::shared_ptr<engine::CommonRenderPasses> m_CommonPasses;
+
+        nvrhi::ShaderHandle m_ComputeShader;
+        nvrhi::ComputePipelineHandle m_Pso;
+        nvrhi::BindingLayoutHandle m_BindingLayout;
+        nvrhi::BindingSetHandle m_BindingSet;
+        nvrhi::IBuffer* m_BoundInstanceBuffer = nullptr;
+        nvrhi::ITexture* m_BoundHiZ = nullptr;
+
+        nvrhi::BufferHandle m_ConstantBuffer;
+        nvrhi::BufferHandle m_CandidateBuffer;
+        nvrhi::BufferHandle m_DrawCountBuffer;
+        nvrhi::BufferHandle m_DrawArgumentBuffer;
+        nvrhi::BufferHandle m_DrawRecordBuffer;
+
+        IndirectDrawList m_DrawList;
+
+        void CreateBuffers(uint32_t numCandidates, uint32_t numBuckets);
+
+    protected:
+        virtual nvrhi::ShaderHandle CreateComputeShader(engine::ShaderFactory& shaderFactory);
+
+    public:
+        GpuCullingPass(nvrhi::IDevice* device, std::shared_ptr<engine::CommonRenderPasses> commonPasses);
+
+        virtual void Init(engine::ShaderFactory& shaderFactory);
+
+        // Rebuilds the draw list and uploads it. Call after the scene is loaded, and whenever
+        // mesh instances are added or removed or the materials change their domain.
+        void BuildDrawList(nvrhi::ICommandList* commandList, const std::vector<std::shared_ptr<engine::MeshInstance>>& meshInstances);
+
+        // Culls the draws for the view, using the instance buffer of the scene (Scene::GetInstanceBuffer)
+        // for the transforms. When hiZ is provided, hiZView must be the view that rendered its contents.
+        void Render(
+            nvrhi::ICommandList* commandList,
+            nvrhi::IBuffer* instanceBuffer,
+            const engine::IView& view,
+            nvrhi::ITexture* hiZ = nullptr,
+            const engine::IView* hiZView = nullptr);
+
+        [[nodiscard]] const IndirectDrawList& GetDrawList() const { return m_DrawList; }
+
+        // Resources for the geometry passes: nvrhi::DrawIndexedIndirectArguments for every draw slot,
+        // and the GpuCullingDrawRecord structures that are bound as a per-instance vertex buffer.
+        [[nodiscard]] nvrhi::IBuffer* GetDrawArgumentBuffer() const { return m_DrawArgumentBuffer; }
+        [[nodiscard]] nvrhi::IBuffer* GetDrawRecordBuffer() const { return m_DrawRecordBuffer; }
+
+        // Number of surviving draws of every bucket, as uint32_t
+        [[nodiscard]] nvrhi::IBuffer* GetDrawCountBuffer() const { return m_DrawCountBuffer; }
+    };
+}
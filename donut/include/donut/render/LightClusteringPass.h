@@ -0,0 +1,161 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <nvrhi/nvrhi.h>
+#include <memory>
+#include <vector>
+
+namespace donut::engine
+{
+    class ShaderFactory;
+    class Light;
+    class IView;
+}
+
+namespace donut::render
+{
+    /*
+    LightClusterGrid describes the froxel grid of one planar view used for clustered lighting:
+    the viewport is divided into SizeX * SizeY screen tiles, and the view depth range into SizeZ
+    slices distributed exponentially between the minimum and maximum depth. The first slice
+    starts at the camera and the last slice extends to infinity.
+
+    The grid also provides the CPU reference implementation of the light binning done on the
+    GPU by LightClusteringPass, which produces the same cluster buffer layout.
+    */
+    class LightClusterGrid
+    {
+    public:
+        // These must match the LIGHT_CLUSTER_* definitions in <donut/shaders/light_clustering_cb.h>
+        static constexpr uint32_t SizeX = 16;
+        static constexpr uint32_t SizeY = 8;
+        static constexpr uint32_t SizeZ = 24;
+        static constexpr uint32_t NumClusters = SizeX * SizeY * SizeZ;
+
+        // Every cluster occupies ClusterStride words: the light count followed by the light indices.
+        static constexpr uint32_t ClusterStride = 128;
+        static constexpr uint32_t MaxLightsPerCluster = ClusterStride - 1;
+
+        void Init(const engine::IView& view, float minDepth, float maxDepth);
+
+        // Returns the depth slice containing the given positive view space depth.
+        [[nodiscard]] uint32_t GetSlice(float viewDepth) const;
+        [[nodiscard]] float GetSliceStart(uint32_t slice) const;
+        [[nodiscard]] float GetSliceEnd(uint32_t slice) const;
+
+        // Returns the view space bounding box of a cluster.
+        [[nodiscard]] dm::box3 GetClusterBounds(dm::uint3 cluster) const;
+
+        // Returns the linear index of the cluster containing the given window space pixel position and view space depth.
+        [[nodiscard]] uint32_t GetClusterIndex(dm::float2 pixelPosition, float viewDepth) const;
+
+        // Tests a light culling sphere (see LightClusteringPass::GetLightCullingSphere) against a view space box.
+        [[nodiscard]] static bool SphereIntersectsBox(const dm::float4& sphere, const dm::box3& box);
+
+        // Bins the view space light culling spheres into clusters, writing NumClusters * ClusterStride words
+        // into outClusters. Lights are listed in ascending index order; any lights over MaxLightsPerCluster are dropped.
+        void BinLights(const std::vector<dm::float4>& viewSpaceSpheres, std::vector<uint32_t>& outClusters) const;
+
+        [[nodiscard]] const dm::affine3& GetWorldToView() const { return m_WorldToView; }
+        [[nodiscard]] const dm::float4x4& GetClipToView() const { return m_ClipToView; }
+        [[nodiscard]] dm::float2 GetViewportOrigin() const { return m_ViewportOrigin; }
+        [[nodiscard]] dm::float2 GetViewportSize() const { return m_ViewportSize; }
+        [[nodiscard]] float GetDepthSliceScale() const { return m_DepthSliceScale; }
+        [[nodiscard]] float GetDepthSliceBias() const { return m_DepthSliceBias; }
+
+    private:
+        dm::affine3 m_WorldToView = dm::affine3::identity();
+        dm::float4x4 m_ClipToView = dm::float4x4::identity();
+        dm::float2 m_ViewportOrigin = 0.f;
+        dm::float2 m_ViewportSize = 1.f;
+        float m_DepthSliceScale = 1.f;
+        float m_DepthSliceBias = 0.f;
+
+        [[nodiscard]] dm::float3 GetViewPointAtDepth(dm::float2 clipPosition, float viewDepth) const;
+    };
+
+    /*
+    LightClusteringPass uploads the lights of a scene into a structured buffer and bins them into
+    the clusters of a view with a compute shader. DeferredLightingPass and ForwardShadingPass use
+    the resulting cluster buffer to shade every pixel with only the lights that can reach it.
+
+    Only lights without shadows are clustered (see IsClusteredLight); shadowed lights are few and
+    keep going through the constant buffers of the shading passes, which also own the shadow data.
+    The clusters are built for a single planar view and must be rebuilt for every view.
+    */
+    class LightClusteringPass
+    {
+    private:
+        nvrhi::DeviceHandle m_Device;
+
+        nvrhi::ShaderHandle m_ComputeShader;
+        nvrhi::ComputePipelineHandle m_Pso;
+        nvrhi::BindingLayoutHandle m_BindingLayout;
+        nvrhi::BindingSetHandle m_BindingSet;
+
+        nvrhi::BufferHandle m_ConstantBuffer;
+        nvrhi::BufferHandle m_LightBuffer;
+        nvrhi::BufferHandle m_LightSphereBuffer;
+        nvrhi::BufferHandle m_ClusterBuffer;
+
+        LightClusterGrid m_Grid;
+        float m_MinDepth = 0.1f;
+        float m_MaxDepth = 1000.f;
+        uint32_t m_NumLights = 0;
+        bool m_OverflowReported = false;
+
+    protected:
+        virtual nvrhi::ShaderHandle CreateComputeShader(engine::ShaderFactory& shaderFactory);
+
+    public:
+        explicit LightClusteringPass(nvrhi::IDevice* device);
+
+        virtual void Init(engine::ShaderFactory& shaderFactory);
+
+        // Uploads the clustered lights from the list and bins them for the view.
+        void Render(
+            nvrhi::ICommandList* commandList,
+            const engine::IView& view,
+            const std::vector<std::shared_ptr<engine::Light>>& lights);
+
+        // Sets the depth range covered by the exponentially distributed depth slices.
+        void SetDepthRange(float minDepth, float maxDepth);
+
+        [[nodiscard]] const LightClusterGrid& GetGrid() const { return m_Grid; }
+        [[nodiscard]] uint32_t GetNumLights() const { return m_NumLights; }
+
+        // Resources to be bound by the shading passes, see <donut/shaders/light_clustering.hlsli>
+        [[nodiscard]] nvrhi::IBuffer* GetConstantBuffer() const { return m_ConstantBuffer; }
+        [[nodiscard]] nvrhi::IBuffer* GetLightBuffer() const { return m_LightBuffer; }
+        [[nodiscard]] nvrhi::IBuffer* GetClusterBuffer() const { return m_ClusterBuffer; }
+
+        // Lights with shadow maps or shadow channels are not clustered.
+        [[nodiscard]] static bool IsClusteredLight(const engine::Light& light);
+
+        // Returns the bounding sphere of the light's influence in world space: xyz = center, w = range.
+        // Directional lights and lights with infinite range return a negative w, meaning that they affect all clusters.
+        [[nodiscard]] static dm::float4 GetLightCullingSphere(const engine::Light& light);
+    };
+}
@@ -52,14 +52,28 @@ namespace donut::render
         };
 
         // note : 'texture' must have been allocated with some mip levels
+        // When 'singlePass' is set, up to 12 levels are generated with a single dispatch
+        // instead of one dispatch per group of 4 levels - see details in class implementation
         MipMapGenPass(
             nvrhi::IDevice* device,
             std::shared_ptr<engine::ShaderFactory> shaderFactory,
             nvrhi::TextureHandle texture,
-            Mode mode = Mode::MODE_MAX);
+            Mode mode = Mode::MODE_MAX,
+            bool singlePass = false);
+
+        // Single-pass reduction of 'source' into the LODs of a separate 'output' texture,
+        // where LOD 0 of 'output' is the first reduced level (e.g. a HiZ pyramid of a depth buffer).
+        // Output LOD 0 can have any size : its texels reduce 2x2 source texels each, clamped to
+        // the source extent.
+        MipMapGenPass(
+            nvrhi::IDevice* device,
+            std::shared_ptr<engine::ShaderFactory> shaderFactory,
+            nvrhi::TextureHandle source,
+            nvrhi::TextureHandle output,
+            Mode mode);
 
         // Dispatches reduction kernel : reads LOD 0 and populates
-        // LOD 1 and up
+        // LOD 1 and up (LOD 0 and up of the output texture, if separate)
         void Dispatch(nvrhi::ICommandList* commandList, int maxLOD=-1);
 
         // debug : blits mip-map levels in spiral pattern to 'target'
@@ -69,15 +83,42 @@ namespace donut::render
             nvrhi::ICommandList* commandList, 
             nvrhi::IFramebuffer* target);
 
+        // CPU reference of the reduction, for validation : computes a 'destinationSize' level
+        // where texel (x, y) reduces the texels (2x, 2y) to (2x+1, 2y+1) of 'source', clamped
+        // to 'sourceSize'. Texels have GetNumChannels(mode) floats each. The single-pass mode
+        // matches this exactly on every level; in MODE_MINMAX, both channels of the LOD 0
+        // texels are initialized from R before reducing.
+        static void ReduceReference(
+            Mode mode,
+            const float* source,
+            dm::uint2 sourceSize,
+            float* destination,
+            dm::uint2 destinationSize);
+
+        [[nodiscard]] static uint32_t GetNumChannels(Mode mode);
+
+        // Number of levels that the single-pass mode can generate, starting with a first
+        // output level of the given size and including it : the full chain, up to 12 levels,
+        // or 6 levels when the 6th is larger than the 64x64 texels reduced by the last group.
+        [[nodiscard]] static uint32_t GetMaxSinglePassLevels(dm::uint2 firstLevelSize);
+
     private:
 
         nvrhi::DeviceHandle m_Device;
         nvrhi::ShaderHandle m_Shader;
         nvrhi::TextureHandle m_Texture;
+        nvrhi::TextureHandle m_Source;
+        nvrhi::BufferHandle m_CounterBuffer;
         nvrhi::BufferHandle m_ConstantBuffer;
         nvrhi::BindingLayoutHandle m_BindingLayout;
         std::vector<nvrhi::BindingSetHandle> m_BindingSets;
         nvrhi::ComputePipelineHandle m_Pso;
+        uint32_t m_FirstOutputLevel = 1;
+        bool m_SinglePass = false;
+        bool m_CounterInitialized = false;
+
+        void CreateSinglePassResources(std::shared_ptr<engine::ShaderFactory> shaderFactory, Mode mode);
+        void DispatchSinglePass(nvrhi::ICommandList* commandList, int maxLOD);
 
         // Set of unique dummy textures - see details in class implementation
         struct NullTextures;
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <memory>
+#include <vector>
+
+namespace donut::engine
+{
+    class IView;
+    class SceneGraphNode;
+    class MeshInstance;
+}
+
+namespace donut::render
+{
+    /*
+    OcclusionCuller is a CPU occlusion culling system based on a software rasterizer.
+    Every view, it rasterizes a small set of occluders into a low resolution depth buffer,
+    and then tests the screen space bounds of other objects against that buffer.
+
+    The occluders are picked by PrepareForView(...) among the opaque meshes of the scene with the
+    largest projected size, using a simplified level of detail where the meshes have one. They are
+    rasterized from the CPU copies of the mesh data (BufferGroup::positionData and indexData), so
+    skinned meshes are never used as occluders. Scene releases those copies once the mesh buffers are
+    uploaded unless Scene::SetCpuGeometryRetained(true) is called before loading. Alternatively, the application can provide its own
+    proxy geometry through BeginView(...) and RasterizeOccluder(...).
+
+    The depth buffer stores a "closeness" value that is linear in screen space: z/w for reverse
+    depth projections and 1 - z/w for regular ones, 0 meaning nothing was rasterized. Occluders are
+    sampled at pixel centers, so objects that are only visible through gaps smaller than a pixel of
+    the culling buffer may be culled. Objects whose bounds cross the near plane are always visible.
+
+    A culler holds the state of one view at a time and must not be used by several threads concurrently.
+    */
+    class OcclusionCuller
+    {
+    public:
+        // The depth buffer is divided into blocks of BlockSize x BlockSize pixels that store
+        // the farthest occluder depth in the block, so that most tests never touch the pixels.
+        static constexpr uint32_t BlockSize = 8;
+
+        struct Statistics
+        {
+            uint32_t numOccluders = 0;
+            uint32_t numOccluderTriangles = 0;  // submitted to the rasterizer
+            uint32_t numRasterizedTriangles = 0; // after clipping and culling of empty triangles
+            uint32_t numTests = 0;
+            uint32_t numOccluded = 0;
+        };
+
+        // The resolution is rounded up to a multiple of BlockSize.
+        explicit OcclusionCuller(uint32_t width = 256, uint32_t height = 128);
+
+        void SetResolution(uint32_t width, uint32_t height);
+        [[nodiscard]] uint32_t GetWidth() const { return m_Width; }
+        [[nodiscard]] uint32_t GetHeight() const { return m_Height; }
+
+        // Selects the occluders among the opaque meshes of the scene and rasterizes them for the view.
+        void PrepareForView(const std::shared_ptr<engine::SceneGraphNode>& rootNode, const engine::IView& view);
+
+        // Clears the depth buffer and sets up the projection for the following occluders and tests.
+        void BeginView(const dm::float4x4& worldToClip, bool reverseDepth);
+
+        // Rasterizes an indexed triangle list. Indices are relative to 'positions'.
+        void RasterizeOccluder(const dm::float3* positions, const uint32_t* indices, size_t numIndices, const dm::affine3& localToWorld);
+
+        // Returns false if the box is completely hidden by the occluders or outside of the viewport.
+        [[nodiscard]] bool IsBoxVisible(const dm::box3& worldBounds);
+
+        // Maximum number of meshes and triangles rasterized as occluders by PrepareForView
+        void SetMaxOccluders(uint32_t count) { m_MaxOccluders = count; }
+        void SetMaxOccluderTriangles(uint32_t count) { m_MaxOccluderTriangles = count; }
+
+        // Meshes whose projected bounding sphere radius is smaller than this fraction of the viewport half-height are not used as occluders
+        void SetMinOccluderSize(float size) { m_MinOccluderSize = size; }
+
+        // Coarsest level of detail used for the occluders, in terms of MeshGeometryLod::error
+        void SetMaxOccluderLodError(float error) { m_MaxOccluderLodError = error; }
+
+        [[nodiscard]] const Statistics& GetStatistics() const { return m_Statistics; }
+        [[nodiscard]] const std::vector<float>& GetDepthBuffer() const { return m_Depth; }
+
+    private:
+        uint32_t m_Width = 0;
+        uint32_t m_Height = 0;
+        std::vector<float> m_Depth;
+        std::vector<float> m_BlockDepth;
+        bool m_BlockDepthValid = false;
+
+        dm::float4x4 m_WorldToClip = dm::float4x4::identity();
+        bool m_ReverseDepth = false;
+
+        uint32_t m_MaxOccluders = 32;
+        uint32_t m_MaxOccluderTriangles = 64 * 1024;
+        float m_MinOccluderSize = 0.1f;
+        float m_MaxOccluderLodError = 0.005f;
+
+        Statistics m_Statistics;
+        std::vector<dm::float4> m_ClipPositions;
+
+        void RasterizeTriangle(const dm::float4& a, const dm::float4& b, const dm::float4& c);
+        void RasterizeScreenTriangle(dm::float3 a, dm::float3 b, dm::float3 c);
+        void UpdateBlockDepth();
+        [[nodiscard]] float GetNearPlaneDistance(const dm::float4& clipPosition) const;
+        [[nodiscard]] dm::float3 ProjectToScreen(const dm::float4& clipPosition) const;
+    };
+}
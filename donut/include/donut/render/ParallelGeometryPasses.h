@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <donut/render/GeometryPasses.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace tf
+{
+    class Executor;
+}
+
+namespace donut::render
+{
+    // A contiguous range of the draw items produced for one child view of a composite view.
+    struct DrawListSlice
+    {
+        uint32_t viewIndex = 0;
+        size_t firstItem = 0;
+        size_t numItems = 0;
+    };
+
+    // Splits the draw lists of several views into slices that can be recorded independently.
+    // Every non-empty view gets at least one slice, and the rest of the maxSlices budget is distributed
+    // in proportion to the item counts, with no slice shorter than minItemsPerSlice unless its view is.
+    // Slices are returned in view order and, within each view, in draw order.
+    void SplitDrawLists(
+        const std::vector<size_t>& itemCounts,
+        uint32_t maxSlices,
+        size_t minItemsPerSlice,
+        std::vector<DrawListSlice>& outSlices);
+
+    /*
+    ParallelViewRecorder is a multi-threaded alternative to RenderCompositeView(...).
+    The draw strategy runs once for every child view, in parallel across views, and the
+    resulting draw lists are split into slices. Every slice is recorded into its own command
+    list on a worker thread, with its own draw strategy and geometry pass context instances,
+    which are obtained from the factories provided by the caller.
+
+    The command lists are kept in view and draw order and must be submitted after the commands
+    that prepare the render targets and scene buffers, which is what Submit(...) does.
+    All textures and buffers used by the pass must have a known initial state in every command
+    list, i.e. use keepInitialState or permanent states - that is the case for the scene resources
+    and the render targets created by donut.
+
+    Parallel recording is not available on D3D11, where the recorder falls back to recording
+    all views into one immediate command list on the calling thread. The application must not
+    have its own immediate command list open at that time.
+    */
+    class ParallelViewRecorder
+    {
+    public:
+        typedef std::function<std::unique_ptr<IDrawStrategy>()> DrawStrategyFactory;
+        typedef std::function<std::unique_ptr<GeometryPassContext>()> PassContextFactory;
+
+        struct Stats
+        {
+            uint32_t numViews = 0;
+            uint32_t numCommandLists = 0;
+            size_t numDrawItems = 0;
+        };
+
+        // Without an executor, or when donut is built without taskflow, the slices are recorded
+        // serially, but still into separate command lists.
+        ParallelViewRecorder(nvrhi::IDevice* device, tf::Executor* executor);
+
+        // Records the pass for all child views of compositeView. The command lists from
+        // the previous call must have been submitted or abandoned before calling this function.
+        void RenderCompositeView(
+            const engine::ICompositeView* compositeView,
+            const engine::ICompositeView* compositeViewPrev,
+            engine::FramebufferFactory& framebufferFactory,
+            const std::shared_ptr<engine::SceneGraphNode>& rootNode,
+            const DrawStrategyFactory& drawStrategyFactory,
+            IGeometryPass& pass,
+            const PassContextFactory& passContextFactory,
+            const char* passEvent = nullptr,
+            bool materialEvents = false);
+
+        // Appends the command lists recorded by the last RenderCompositeView(...) call, in submission order.
+        void GetCommandLists(std::vector<nvrhi::ICommandList*>& outCommandLists) const;
+
+        // Executes the recorded command lists on the graphics queue. If precedingCommandList is
+        // provided, it must be closed, and it is executed in the same batch before the recorded lists.
+        void Submit(nvrhi::ICommandList* precedingCommandList = nullptr);
+
+        // Slices shorter than this are not split further. Small slices make the command list overhead dominate.
+        void SetMinItemsPerSlice(size_t count) { m_MinItemsPerSlice = std::max<size_t>(count, 1); }
+        // Maximum number of slices per call, 0 means one slice per executor thread.
+        void SetMaxSlices(uint32_t count) { m_MaxSlices = count; }
+
+        [[nodiscard]] bool IsParallelRecordingSupported() const { return m_ParallelRecordingSupported; }
+        [[nodiscard]] uint32_t GetNumThreads() const;
+        [[nodiscard]] const Stats& GetStats() const { return m_Stats; }
+
+    private:
+        nvrhi::DeviceHandle m_Device;
+        tf::Executor* m_Executor = nullptr;
+        bool m_ParallelRecordingSupported = true;
+        size_t m_MinItemsPerSlice = 256;
+        uint32_t m_MaxSlices = 0;
+
+        std::vector<nvrhi::CommandListHandle> m_CommandLists;
+        uint32_t m_NumRecordedCommandLists = 0;
+        std::vector<std::vector<DrawItem>> m_ViewDrawItems;
+        std::vector<DrawListSlice> m_Slices;
+        Stats m_Stats;
+    };
+}
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <donut/core/math/math.h>
+#include <functional>
 #include <memory>
 #include <map>
 #include <nvrhi/nvrhi.h>
@@ -34,6 +35,7 @@ namespace donut::engine
     class CommonRenderPasses;
     class FramebufferFactory;
     class ICompositeView;
+    class ReadbackQueue;
 }
 
 namespace donut::render
@@ -64,5 +66,22 @@ namespace donut::render
         dm::float4 ReadFloats();
         dm::uint4 ReadUInts();
         dm::int4 ReadInts();
+
+        // Raw value of the captured pixel, interpreted according to the format of the pass.
+        struct Value
+        {
+            dm::uint4 bits = 0u;
+
+            [[nodiscard]] dm::float4 AsFloats() const;
+            [[nodiscard]] dm::uint4 AsUInts() const { return bits; }
+            [[nodiscard]] dm::int4 AsInts() const { return dm::int4(bits); }
+        };
+
+        // Captures the pixel and reads it back through the queue without waiting for the GPU.
+        // Pass the command list to ReadbackQueue::OnCommandListExecuted after executing it.
+        // The callback is called from ReadbackQueue::Update() once the copy is complete, and is not called
+        // if the readback fails. Multiple captures can be in flight at the same time.
+        void CaptureAsync(nvrhi::ICommandList* commandList, dm::uint2 pixelPosition, engine::ReadbackQueue& readbackQueue,
+            std::function<void(const Value& value)> callback);
     };
 }
\ No newline at end of file
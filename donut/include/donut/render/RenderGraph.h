@@ -0,0 +1,228 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace donut::render
+{
+    class RenderGraph;
+
+    struct RenderGraphTexture
+    {
+        uint32_t index = ~0u;
+
+        [[nodiscard]] bool IsValid() const { return index != ~0u; }
+        bool operator==(const RenderGraphTexture& other) const { return index == other.index; }
+        bool operator!=(const RenderGraphTexture& other) const { return index != other.index; }
+    };
+
+    // Placement of a transient texture in the shared transient heap, valid after RenderGraph::Compile.
+    struct RenderGraphAllocation
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t firstPass = 0; // indices of the first and last non-culled passes using the texture
+        uint32_t lastPass = 0;
+    };
+
+    struct RenderGraphBarrier
+    {
+        RenderGraphTexture texture;
+        nvrhi::ResourceStates stateBefore = nvrhi::ResourceStates::Unknown; // Unknown for the first use of imported textures
+        nvrhi::ResourceStates stateAfter = nvrhi::ResourceStates::Unknown;
+    };
+
+    struct RenderGraphStats
+    {
+        uint32_t numPasses = 0;
+        uint32_t numCulledPasses = 0;
+        uint32_t numTransientTextures = 0; // transient textures used by non-culled passes
+        uint32_t numBarrierBatches = 0;    // pass boundaries where barriers are committed
+        uint32_t numBarriers = 0;
+        uint32_t numClears = 0;            // transient textures cleared by the graph before their first use
+
+        // Memory of the transient textures if each had its own allocation, and the size of the shared heap.
+        uint64_t transientMemoryWithoutAliasing = 0;
+        uint64_t transientMemoryWithAliasing = 0;
+
+        [[nodiscard]] uint64_t GetTransientMemorySaved() const { return transientMemoryWithoutAliasing - transientMemoryWithAliasing; }
+    };
+
+    class RenderGraphPassBuilder
+    {
+    public:
+        RenderGraphPassBuilder(RenderGraph& graph, uint32_t passIndex) : m_Graph(graph), m_PassIndex(passIndex) { }
+
+        // The pass reads the texture contents, e.g. as a shader resource.
+        RenderGraphPassBuilder& Read(RenderGraphTexture texture, nvrhi::ResourceStates state = nvrhi::ResourceStates::ShaderResource);
+
+        // The pass overwrites the texture, and its previous contents are not needed.
+        RenderGraphPassBuilder& Write(RenderGraphTexture texture, nvrhi::ResourceStates state = nvrhi::ResourceStates::RenderTarget);
+
+        // The pass both reads and writes the texture in the same state, e.g. depth testing or blending.
+        RenderGraphPassBuilder& Modify(RenderGraphTexture texture, nvrhi::ResourceStates state = nvrhi::ResourceStates::RenderTarget);
+
+        // Passes with side effects are never culled, even if none of their outputs are used.
+        RenderGraphPassBuilder& SetSideEffects(bool value = true);
+
+        [[nodiscard]] uint32_t GetPassIndex() const { return m_PassIndex; }
+
+    private:
+        RenderGraph& m_Graph;
+        uint32_t m_PassIndex;
+    };
+
+    /*
+    RenderGraph is a frame-level scheduler for passes that declare which textures they read and write.
+    The graph is rebuilt every frame: Reset, declare textures and passes, Compile, Execute.
+
+    Compilation culls the passes that don't contribute to any imported texture or side effect,
+    computes the lifetimes of transient textures, places transient textures with non-overlapping
+    lifetimes at overlapping offsets in one heap, and precomputes the state transitions for every
+    pass, so that they are committed as one batch at each pass boundary. All of that works without
+    a device, which is useful for testing and for estimating the memory footprint of a frame.
+
+    With a device that supports virtual resources, the transient textures are placed into a heap that
+    is retained between frames along with the textures themselves, as long as the layout stays the same.
+    Without that support, every transient texture gets its own allocation and nothing is aliased.
+
+    Contents of transient textures are undefined on their first use in a frame, so the first pass
+    that accesses a transient texture must Write it. Textures that have a clear value are cleared
+    by the graph before that pass. So are all render targets and depth buffers placed in the shared
+    heap, because the graphics APIs require aliased render targets to be initialized with a clear
+    before they are rendered to; those without a clear value are cleared to zero.
+    */
+    class RenderGraph
+    {
+    public:
+        typedef std::function<void(nvrhi::ICommandList* commandList, const RenderGraph& graph)> ExecuteFunction;
+
+        // Removes all passes and textures declared for the previous frame. Allocated memory is retained.
+        void Reset();
+
+        // Declares an external texture. Writes into imported textures are considered observable outputs.
+        // If finalState is not Unknown, the texture is transitioned into that state after the last pass.
+        RenderGraphTexture ImportTexture(nvrhi::ITexture* texture, nvrhi::ResourceStates finalState = nvrhi::ResourceStates::Unknown);
+
+        // Declares a transient texture whose memory is managed by the graph.
+        RenderGraphTexture CreateTexture(const nvrhi::TextureDesc& desc);
+
+        // Adds a pass that runs 'execute' when the graph is executed. Passes run in the order they were added.
+        RenderGraphPassBuilder AddPass(const std::string& name, ExecuteFunction execute);
+
+        // Culls the passes, plans the barriers and places the transient textures. When the device is provided,
+        // the transient textures are also allocated, and the graph can be executed.
+        bool Compile(nvrhi::IDevice* device);
+
+        // Records the non-culled passes with their barriers into the command list, which must be open.
+        void Execute(nvrhi::ICommandList* commandList);
+
+        // Records a single pass with its clears and barriers, for applications that interleave the passes with
+        // work that isn't declared to the graph. Passes must be executed in the order they were added.
+        // Culled passes are skipped, and the final barriers are only recorded by Execute.
+        void ExecutePass(nvrhi::ICommandList* commandList, uint32_t passIndex);
+
+        // Returns the texture object for a declared texture. Transient textures are only available after Compile with a device.
+        [[nodiscard]] nvrhi::ITexture* GetTexture(RenderGraphTexture texture) const;
+        [[nodiscard]] const nvrhi::TextureDesc& GetTextureDesc(RenderGraphTexture texture) const;
+
+        [[nodiscard]] const RenderGraphStats& GetStats() const { return m_Stats; }
+        [[nodiscard]] uint32_t GetNumPasses() const { return uint32_t(m_Passes.size()); }
+        [[nodiscard]] const std::string& GetPassName(uint32_t passIndex) const { return m_Passes[passIndex].name; }
+        [[nodiscard]] bool IsPassCulled(uint32_t passIndex) const { return m_Passes[passIndex].culled; }
+        [[nodiscard]] const std::vector<RenderGraphBarrier>& GetPassBarriers(uint32_t passIndex) const { return m_Passes[passIndex].barriers; }
+        [[nodiscard]] const std::vector<RenderGraphBarrier>& GetFinalBarriers() const { return m_FinalBarriers; }
+
+        // Returns nullptr for imported textures and for transient textures not used by any non-culled pass.
+        [[nodiscard]] const RenderGraphAllocation* GetTransientAllocation(RenderGraphTexture texture) const;
+
+        // Size and alignment that a texture would need without a device to query them from.
+        [[nodiscard]] static nvrhi::MemoryRequirements EstimateTextureMemoryRequirements(const nvrhi::TextureDesc& desc);
+
+    private:
+        friend class RenderGraphPassBuilder;
+
+        enum class AccessType : uint8_t
+        {
+            Read,
+            Write,
+            Modify
+        };
+
+        struct TextureAccess
+        {
+            RenderGraphTexture texture;
+            nvrhi::ResourceStates state = nvrhi::ResourceStates::Unknown;
+            AccessType type = AccessType::Read;
+        };
+
+        struct Pass
+        {
+            std::string name;
+            ExecuteFunction execute;
+            std::vector<TextureAccess> accesses;
+            std::vector<RenderGraphBarrier> barriers;
+            std::vector<RenderGraphTexture> texturesToClear;
+            bool sideEffects = false;
+            bool culled = false;
+        };
+
+        struct Texture
+        {
+            nvrhi::TextureDesc desc;
+            nvrhi::TextureHandle texture;
+            nvrhi::ResourceStates finalState = nvrhi::ResourceStates::Unknown;
+            RenderGraphAllocation allocation;
+            bool imported = false;
+            bool used = false;
+        };
+
+        // Transient textures that have been allocated on the device, retained between frames.
+        struct PhysicalTexture
+        {
+            nvrhi::TextureHandle texture;
+            uint64_t offset = 0;
+            bool usedThisFrame = false;
+        };
+
+        std::vector<Pass> m_Passes;
+        std::vector<Texture> m_Textures;
+        std::vector<RenderGraphBarrier> m_FinalBarriers;
+        RenderGraphStats m_Stats;
+        bool m_Compiled = false;
+
+        nvrhi::HeapHandle m_Heap;
+        std::vector<PhysicalTexture> m_PhysicalTextures;
+
+        void AddAccess(uint32_t passIndex, RenderGraphTexture texture, nvrhi::ResourceStates state, AccessType type);
+        void CullPasses();
+        void ComputeLifetimes(bool aliasingSupported);
+        void PlanBarriers();
+        void PlaceTransientTextures(nvrhi::IDevice* device, bool aliasingSupported);
+        bool AllocateTransientTextures(nvrhi::IDevice* device, bool aliasingSupported);
+    };
+}
@@ -0,0 +1,98 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace donut::engine
+{
+    class IView;
+    class MeshInstance;
+    class SceneGraph;
+}
+
+namespace donut::render
+{
+    /*
+    ShadowCasterCache decides which parts of a set of shadow map views need to be rendered on
+    a frame, so that the static shadow casters are only rendered when the views or the static
+    geometry change. It doesn't touch any graphics resources, see CascadedShadowMap::Render.
+
+    Mesh instances are dynamic when the transform of their node, as reported by the dirty flags
+    of the scene graph, or their skin has changed within the last GetDynamicFrames() frames,
+    and static otherwise. Every view keeps a static layer with the static casters that intersect
+    its frustum. The layer is re-rendered when the view projection or the set of static casters
+    in the frustum changes, which includes casters that start or stop moving, and the dynamic
+    casters are drawn on top of a copy of the static layer.
+    */
+    class ShadowCasterCache
+    {
+    public:
+        struct ViewUpdate
+        {
+            bool renderStatic = false;      // the static layer is out of date and must be re-rendered
+            bool renderDynamic = false;     // the view must be restored from the static layer, then the dynamic casters drawn
+            bool hasDynamicCasters = false; // some dynamic casters intersect the view
+        };
+
+        // Classifies the casters and computes the updates of the views for the current frame.
+        // Call once per frame after SceneGraph::Refresh, with the views set up for the frame.
+        // The caller is expected to render every update it receives.
+        void Update(const engine::SceneGraph& sceneGraph, const std::vector<const engine::IView*>& views, uint32_t frameIndex);
+
+        [[nodiscard]] const ViewUpdate& GetViewUpdate(size_t view) const;
+        [[nodiscard]] bool IsInstanceDynamic(const engine::MeshInstance& instance) const;
+
+        // Forces all static layers to be re-rendered, e.g. after the materials or the shadow map resources change.
+        void Invalidate();
+
+        void SetDynamicFrames(uint32_t frames) { m_DynamicFrames = std::max(frames, 1u); }
+        [[nodiscard]] uint32_t GetDynamicFrames() const { return m_DynamicFrames; }
+
+    private:
+        struct InstanceState
+        {
+            uint32_t lastMovedFrame = 0;
+            uint32_t lastSeenFrame = 0;
+            bool moved = false;
+        };
+
+        struct ViewState
+        {
+            dm::float4x4 viewProjection = dm::float4x4::zero();
+            uint64_t staticCasters = 0;
+            bool valid = false;
+            bool hadDynamicCasters = false;
+            ViewUpdate update;
+        };
+
+        std::unordered_map<const engine::MeshInstance*, InstanceState> m_Instances;
+        std::vector<ViewState> m_Views;
+        uint32_t m_FrameIndex = 0;
+        uint32_t m_DynamicFrames = 30;
+    };
+}
@@ -25,6 +25,13 @@
 
 #include "material_cb.h"
 
+// Vertex and index formats used by a BufferGroup, see Scene::SetCompactVertexFormatEnabled.
+// When a flag is not set, the corresponding stream uses the full precision format.
+static const uint GeometryFormat_CompactPositions     = 0x01; // RGBA16_UNORM relative to the mesh bounds instead of RGB32_FLOAT
+static const uint GeometryFormat_CompactTexCoords     = 0x02; // RG16_FLOAT instead of RG32_FLOAT
+static const uint GeometryFormat_CompactJointWeights  = 0x04; // RGBA8_UNORM instead of RGBA32_FLOAT
+static const uint GeometryFormat_Indices16            = 0x08; // R16_UINT instead of R32_UINT
+
 struct GeometryData
 {
     uint numIndices;
@@ -41,6 +48,12 @@ struct GeometryData
     uint normalOffset;
     uint tangentOffset;
     uint materialIndex;
+
+    float3 positionScale;  // dequantization of compact positions, see LoadVertexPosition
+    uint formatFlags;      // GeometryFormat_*
+
+    float3 positionBias;
+    uint padding;
 };
 
 
@@ -57,6 +70,11 @@ struct InstanceData
 
     float3x4 transform;
     float3x4 prevTransform;
+
+    float3 positionScale;            // dequantization of compact positions, copied from the mesh
+    uint padding1;
+    float3 positionBias;
+    uint padding2;
 };
 
 #ifndef __cplusplus
@@ -67,10 +85,13 @@ static const uint c_SizeOfTexcoord = 8;
 static const uint c_SizeOfNormal = 4;
 static const uint c_SizeOfJointIndices = 8;
 static const uint c_SizeOfJointWeights = 16;
+static const uint c_SizeOfCompactPosition = 8;
+static const uint c_SizeOfCompactTexcoord = 4;
+static const uint c_SizeOfCompactJointWeights = 4;
 
 // Define the sizes of these structures because FXC doesn't support sizeof(x)
-static const uint c_SizeOfGeometryData = 3*16;
-static const uint c_SizeOfInstanceData = 7*16;
+static const uint c_SizeOfGeometryData = 5*16;
+static const uint c_SizeOfInstanceData = 9*16;
 static const uint c_SizeOfMaterialConstants = 7*16;
 
 GeometryData LoadGeometryData(ByteAddressBuffer buffer, uint offset)
@@ -78,6 +99,8 @@ GeometryData LoadGeometryData(ByteAddressBuffer buffer, uint offset)
     uint4 a = buffer.Load4(offset + 16 * 0);
     uint4 b = buffer.Load4(offset + 16 * 1);
     uint4 c = buffer.Load4(offset + 16 * 2);
+    uint4 d = buffer.Load4(offset + 16 * 3);
+    uint4 e = buffer.Load4(offset + 16 * 4);
 
     GeometryData ret;
     ret.numIndices = a.x;
@@ -92,6 +115,10 @@ GeometryData LoadGeometryData(ByteAddressBuffer buffer, uint offset)
     ret.normalOffset = c.y;
     ret.tangentOffset = c.z;
     ret.materialIndex = c.w;
+    ret.positionScale = asfloat(d.xyz);
+    ret.formatFlags = d.w;
+    ret.positionBias = asfloat(e.xyz);
+    ret.padding = e.w;
     return ret;
 }
 
@@ -104,6 +131,8 @@ InstanceData LoadInstanceData(ByteAddressBuffer buffer, uint offset)
     uint4 e = buffer.Load4(offset + 16 * 4);
     uint4 f = buffer.Load4(offset + 16 * 5);
     uint4 g = buffer.Load4(offset + 16 * 6);
+    uint4 h = buffer.Load4(offset + 16 * 7);
+    uint4 i = buffer.Load4(offset + 16 * 8);
 
     InstanceData ret;
     ret.padding = a.x;
@@ -112,6 +141,10 @@ InstanceData LoadInstanceData(ByteAddressBuffer buffer, uint offset)
     ret.numGeometries = a.w;
     ret.transform = float3x4(asfloat(b), asfloat(c), asfloat(d));
     ret.prevTransform = float3x4(asfloat(e), asfloat(f), asfloat(g));
+    ret.positionScale = asfloat(h.xyz);
+    ret.padding1 = h.w;
+    ret.positionBias = asfloat(i.xyz);
+    ret.padding2 = i.w;
     return ret;
 }
 
@@ -151,6 +184,61 @@ MaterialConstants LoadMaterialConstants(ByteAddressBuffer buffer, uint offset)
     return ret;   
 }
 
+// Vertex stream decoders for the GeometryFormat_* flags.
+// 'offset' is the byte offset of the stream in the vertex buffer, 'vertex' is the vertex index.
+
+float3 LoadVertexPosition(ByteAddressBuffer buffer, uint offset, uint vertex, uint formatFlags, float3 scale, float3 bias)
+{
+    if (formatFlags & GeometryFormat_CompactPositions)
+    {
+        uint2 packed = buffer.Load2(offset + vertex * c_SizeOfCompactPosition);
+        float3 quantized = float3(packed.x & 0xffff, packed.x >> 16, packed.y & 0xffff);
+        return quantized * scale + bias;
+    }
+
+    return asfloat(buffer.Load3(offset + vertex * c_SizeOfPosition));
+}
+
+float2 LoadVertexTexCoord(ByteAddressBuffer buffer, uint offset, uint vertex, uint formatFlags)
+{
+    if (formatFlags & GeometryFormat_CompactTexCoords)
+    {
+        uint packed = buffer.Load(offset + vertex * c_SizeOfCompactTexcoord);
+        return f16tof32(uint2(packed & 0xffff, packed >> 16));
+    }
+
+    return asfloat(buffer.Load2(offset + vertex * c_SizeOfTexcoord));
+}
+
+float4 LoadVertexJointWeights(ByteAddressBuffer buffer, uint offset, uint vertex, uint formatFlags)
+{
+    if (formatFlags & GeometryFormat_CompactJointWeights)
+    {
+        uint packed = buffer.Load(offset + vertex * c_SizeOfCompactJointWeights);
+        return float4(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff, packed >> 24) / 255.0;
+    }
+
+    return asfloat(buffer.Load4(offset + vertex * c_SizeOfJointWeights));
+}
+
+// Loads the indices of a triangle from an index buffer that is bound as a raw buffer.
+// 'offset' is the byte offset of the first index of the geometry.
+uint3 LoadTriangleIndices(ByteAddressBuffer buffer, uint offset, uint triangle, uint formatFlags)
+{
+    if (formatFlags & GeometryFormat_Indices16)
+    {
+        // Raw buffer loads must be 4-byte aligned, so load the enclosing 8 bytes and pick the right half
+        uint address = offset + triangle * 6;
+        uint alignedAddress = address & ~3u;
+        uint2 packed = buffer.Load2(alignedAddress);
+        if (address != alignedAddress)
+            return uint3(packed.x >> 16, packed.y & 0xffff, packed.y >> 16);
+        return uint3(packed.x & 0xffff, packed.x >> 16, packed.y & 0xffff);
+    }
+
+    return buffer.Load3(offset + triangle * c_SizeOfTriangleIndices);
+}
+
 #endif
 
 #endif // BINDLESS_H_
\ No newline at end of file
@@ -48,6 +48,7 @@ struct DepthPushConstants
     uint        startVertexLocation;
     uint        positionOffset;
     uint        texCoordOffset;
+    uint        formatFlags;
 };
 
 #endif // DEPTH_CB_H
\ No newline at end of file
@@ -58,6 +58,9 @@
 #define FORWARD_BINDING_SHADOW_MAP_SAMPLER 1
 #define FORWARD_BINDING_LIGHT_PROBE_SAMPLER 2
 #define FORWARD_BINDING_ENVIRONMENT_BRDF_SAMPLER 3
+#define FORWARD_BINDING_LIGHT_CLUSTER_CONSTANTS 4
+#define FORWARD_BINDING_CLUSTERED_LIGHTS 24
+#define FORWARD_BINDING_LIGHT_CLUSTERS 25
 
 
 struct ForwardShadingViewConstants
@@ -89,6 +92,7 @@ struct ForwardPushConstants
     uint        texCoordOffset;
     uint        normalOffset;
     uint        tangentOffset;
+    uint        formatFlags;
 };
 
 #endif // FORWARD_CB_H
\ No newline at end of file
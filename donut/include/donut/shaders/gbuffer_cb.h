@@ -39,6 +39,8 @@
 #define GBUFFER_BINDING_PUSH_CONSTANTS 1
 #define GBUFFER_BINDING_INSTANCE_BUFFER 10
 #define GBUFFER_BINDING_VERTEX_BUFFER 11
+#define GBUFFER_BINDING_MESHLET_BUFFER 12
+#define GBUFFER_BINDING_MESHLET_INDEX_BUFFER 13
 
 #define GBUFFER_SPACE_VIEW 2
 #define GBUFFER_BINDING_VIEW_CONSTANTS 2
@@ -59,6 +61,22 @@ struct GBufferPushConstants
     uint        texCoordOffset;
     uint        normalOffset;
     uint        tangentOffset;
+    uint        formatFlags;
+};
+
+struct GBufferMeshletPushConstants
+{
+    uint        startInstanceLocation;
+    uint        startVertexLocation;
+    uint        positionOffset;
+    uint        prevPositionOffset;
+    uint        texCoordOffset;
+    uint        normalOffset;
+    uint        tangentOffset;
+    uint        formatFlags;
+    uint        firstMeshlet;
+    uint        numMeshlets;
+    uint        cullFlags; // MeshletCullFlag_* from meshlet_cb.h
 };
 
 #endif // GBUFFER_CB_H
\ No newline at end of file
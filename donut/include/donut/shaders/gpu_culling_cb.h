@@ -0,0 +1,81 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GPU_CULLING_CB_H
+#define GPU_CULLING_CB_H
+
+#define GPU_CULLING_GROUP_SIZE 64
+
+// GpuCullingConstants::flags
+#define GPU_CULLING_FLAG_REVERSE_DEPTH  0x01
+#define GPU_CULLING_FLAG_HIZ            0x02
+
+// GpuCullingCandidate::flags
+#define GPU_CULLING_CANDIDATE_NO_CULLING 0x01 // bounds are not known, e.g. for skinned meshes
+
+// Size of the nvrhi::DrawIndexedIndirectArguments and GpuCullingDrawRecord structures
+#define GPU_CULLING_DRAW_ARGUMENTS_SIZE 20
+#define GPU_CULLING_DRAW_RECORD_SIZE 8
+
+// One geometry of one mesh instance that is drawn if it passes the culling tests
+struct GpuCullingCandidate
+{
+    uint        instanceIndex;      // in the scene instance buffer
+    uint        bucketIndex;
+    uint        firstDraw;          // first draw slot of the bucket in the argument buffer
+    uint        flags;              // GPU_CULLING_CANDIDATE_*
+
+    uint        indexCount;
+    uint        startIndexLocation;
+    uint        vertexOffset;       // added to the indices by the vertex shader
+    uint        padding;
+
+    float3      boundsMin;          // object space
+    uint        padding1;
+    float3      boundsMax;
+    uint        padding2;
+};
+
+// Written for every surviving draw, read by the vertex shader as a per-instance vertex attribute
+struct GpuCullingDrawRecord
+{
+    uint        instanceIndex;
+    uint        vertexOffset;
+};
+
+struct GpuCullingConstants
+{
+    float4x4    matHiZWorldToClip;  // projection of the view that produced the HiZ pyramid
+
+    float4      frustumPlanes[6];   // world space, dot(normal, p) > distance is outside
+
+    float2      hizSize;            // size of the view in texels of the finest HiZ level
+    uint        hizMipLevels;
+    uint        numCandidates;
+
+    uint        flags;              // GPU_CULLING_FLAG_*
+    uint        padding0;
+    uint        padding1;
+    uint        padding2;
+};
+
+#endif // GPU_CULLING_CB_H
@@ -0,0 +1,42 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef LIGHT_CLUSTERING_HLSLI
+#define LIGHT_CLUSTERING_HLSLI
+
+#include "light_clustering_cb.h"
+
+// Returns the offset of the cluster containing the given window space pixel position
+// and world space surface position in the cluster buffer built by LightClusteringPass.
+// The word at that offset is the light count, followed by the light indices.
+uint GetLightClusterOffset(LightClusterConstants clusters, float2 pixelPosition, float3 surfaceWorldPos)
+{
+    float viewDepth = mul(float4(surfaceWorldPos, 1), clusters.matWorldToView).z;
+    float slice = floor(log2(max(viewDepth, 1e-6)) * clusters.depthSliceScale + clusters.depthSliceBias);
+    float2 tile = floor((pixelPosition - clusters.viewportOrigin) * clusters.pixelToTile);
+
+    uint3 cluster = uint3(clamp(float3(tile, slice), 0, float3(LIGHT_CLUSTER_GRID_X, LIGHT_CLUSTER_GRID_Y, LIGHT_CLUSTER_GRID_Z) - 1));
+
+    return ((cluster.z * LIGHT_CLUSTER_GRID_Y + cluster.y) * LIGHT_CLUSTER_GRID_X + cluster.x) * LIGHT_CLUSTER_STRIDE;
+}
+
+#endif // LIGHT_CLUSTERING_HLSLI
@@ -0,0 +1,56 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef LIGHT_CLUSTERING_CB_H
+#define LIGHT_CLUSTERING_CB_H
+
+// Size of the cluster grid of one view: tiles in X and Y, exponential depth slices in Z.
+// Must match donut::render::LightClusterGrid.
+#define LIGHT_CLUSTER_GRID_X 16
+#define LIGHT_CLUSTER_GRID_Y 8
+#define LIGHT_CLUSTER_GRID_Z 24
+
+// Every cluster occupies LIGHT_CLUSTER_STRIDE words of the cluster buffer:
+// the number of lights followed by up to LIGHT_CLUSTER_MAX_LIGHTS light indices.
+#define LIGHT_CLUSTER_STRIDE 128
+#define LIGHT_CLUSTER_MAX_LIGHTS (LIGHT_CLUSTER_STRIDE - 1)
+
+// Maximum number of lights in the light buffer shared by all clusters
+#define LIGHT_CLUSTERING_MAX_LIGHTS 4096
+
+#define LIGHT_CLUSTERING_GROUP_SIZE 64
+
+struct LightClusterConstants
+{
+    float4x4    matWorldToView;
+    float4x4    matClipToView;
+
+    float2      viewportOrigin;
+    float2      pixelToTile;        // LIGHT_CLUSTER_GRID_XY / viewportSize
+
+    float       depthSliceScale;    // slice = log2(viewDepth) * depthSliceScale + depthSliceBias
+    float       depthSliceBias;
+    uint        numLights;
+    uint        padding;
+};
+
+#endif // LIGHT_CLUSTERING_CB_H
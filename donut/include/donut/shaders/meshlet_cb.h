@@ -0,0 +1,59 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef MESHLET_CB_H
+#define MESHLET_CB_H
+
+// Limits of one meshlet, matching donut::engine::MaxMeshletVertices/MaxMeshletTriangles
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// Number of meshlets culled by one task (amplification) shader thread group,
+// and the number of threads of the mesh shader processing one meshlet
+#define MESHLET_TASK_GROUP_SIZE 32
+#define MESHLET_MESH_GROUP_SIZE 32
+
+static const uint MeshletCullFlag_Frustum = 0x01;
+static const uint MeshletCullFlag_Cone = 0x02;
+
+// GPU version of donut::engine::Meshlet, stored in BufferGroup::meshletBuffer.
+// The offsets point into BufferGroup::meshletIndexBuffer, in 32-bit words.
+struct MeshletData
+{
+    float3      center;
+    float       radius;
+    float3      coneAxis;
+    float       coneCutoff;
+    uint        vertexOffset;
+    uint        triangleOffset;
+    uint        vertexCount;
+    uint        triangleCount;
+};
+
+// Passed from the task shader to the mesh shader groups it launches, one per visible meshlet
+struct MeshletPayload
+{
+    uint        instanceOffset; // relative to startInstanceLocation
+    uint        meshletIndices[MESHLET_TASK_GROUP_SIZE];
+};
+
+#endif // MESHLET_CB_H
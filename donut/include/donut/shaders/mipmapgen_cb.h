@@ -32,6 +32,13 @@
 //     (uint)(std::ceil(std::log2f(16384)/NUM_LODS)) = 4
 #define MAX_PASSES 4
 
+// Single-pass mode : every group of SPD_GROUP_SIZE threads reduces a tile of
+// SPD_TILE_SIZE^2 texels of the first output level and the 5 levels below it,
+// then the last group to finish reduces the remaining levels.
+#define SPD_GROUP_SIZE 256
+#define SPD_TILE_SIZE 32
+#define SPD_MAX_LODS 12
+
 #define MODE_COLOR  0
 #define MODE_MIN    1
 #define MODE_MAX    2
@@ -44,4 +51,13 @@ struct MipmmapGenConstants
     uint padding[2];
 };
 
+struct MipMapGenSinglePassConstants
+{
+    uint2 sourceSize;
+    uint2 firstLevelSize;
+    uint numLODs;
+    uint numWorkGroups;
+    uint padding[2];
+};
+
 #endif // MIPMAP_GEN_CB_H
\ No newline at end of file
@@ -49,6 +49,13 @@ struct SkinningConstants
     uint outputTangentOffset;
     uint outputTexCoord1Offset;
     uint outputTexCoord2Offset;
+    uint inputFormatFlags; // GeometryFormat_* flags of the prototype mesh buffers
+
+    float3 inputPositionScale;
+    uint jointOffset; // in bytes
+
+    float3 inputPositionBias;
+    uint padding2;
 };
 
 #endif // SKINNING_CB_H
\ No newline at end of file
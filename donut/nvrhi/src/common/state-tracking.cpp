@@ -24,6 +24,9 @@
 
 #include <nvrhi/utils.h>
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
 #include <sstream>
 
 namespace nvrhi
@@ -48,6 +51,73 @@ namespace nvrhi
         return mipLevel + arraySlice * desc.mipLevels;
     }
 
+    namespace
+    {
+        // Hands out the smallest free indices first so that the per-command-list state arrays stay compact.
+        class TrackerIndexAllocator
+        {
+        public:
+            uint32_t allocate()
+            {
+                std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+                if (m_FreeIndices.empty())
+                    return m_NextIndex++;
+
+                std::pop_heap(m_FreeIndices.begin(), m_FreeIndices.end(), std::greater<uint32_t>());
+                uint32_t index = m_FreeIndices.back();
+                m_FreeIndices.pop_back();
+                return index;
+            }
+
+            void release(uint32_t index)
+            {
+                std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+                m_FreeIndices.push_back(index);
+                std::push_heap(m_FreeIndices.begin(), m_FreeIndices.end(), std::greater<uint32_t>());
+            }
+
+        private:
+            std::mutex m_Mutex;
+            std::vector<uint32_t> m_FreeIndices;
+            uint32_t m_NextIndex = 0;
+        };
+
+        // The allocators are intentionally leaked: resources may be released from static destructors.
+        TrackerIndexAllocator& getTextureIndexAllocator()
+        {
+            static TrackerIndexAllocator* allocator = new TrackerIndexAllocator();
+            return *allocator;
+        }
+
+        TrackerIndexAllocator& getBufferIndexAllocator()
+        {
+            static TrackerIndexAllocator* allocator = new TrackerIndexAllocator();
+            return *allocator;
+        }
+    }
+
+    BufferStateExtension::BufferStateExtension(const BufferDesc& desc)
+        : descRef(desc)
+        , trackerIndex(getBufferIndexAllocator().allocate())
+    { }
+
+    BufferStateExtension::~BufferStateExtension()
+    {
+        getBufferIndexAllocator().release(trackerIndex);
+    }
+
+    TextureStateExtension::TextureStateExtension(const TextureDesc& desc)
+        : descRef(desc)
+        , trackerIndex(getTextureIndexAllocator().allocate())
+    { }
+
+    TextureStateExtension::~TextureStateExtension()
+    {
+        getTextureIndexAllocator().release(trackerIndex);
+    }
+
     void CommandListResourceStateTracker::setEnableUavBarriersForTexture(TextureStateExtension* texture, bool enableBarriers)
     {
         TextureState* tracking = getTextureStateTracking(texture, true);
@@ -75,19 +145,20 @@ namespace nvrhi
         if (subresources.isEntireTexture(desc))
         {
             tracking->state = stateBits;
-            tracking->subresourceStates.clear();
+            tracking->trackSubresources = false;
         }
         else
         {
-            tracking->subresourceStates.resize(desc.mipLevels * desc.arraySize, tracking->state);
-            tracking->state = ResourceStates::Unknown;
+            ResourceStates* subresourceStates = tracking->trackSubresources
+                ? getSubresourceStates(tracking)
+                : expandSubresourceStates(tracking);
 
             for (MipLevel mipLevel = subresources.baseMipLevel; mipLevel < subresources.baseMipLevel + subresources.numMipLevels; mipLevel++)
             {
                 for (ArraySlice arraySlice = subresources.baseArraySlice; arraySlice < subresources.baseArraySlice + subresources.numArraySlices; arraySlice++)
                 {
                     uint32_t subresource = calcSubresource(mipLevel, arraySlice, desc);
-                    tracking->subresourceStates[subresource] = stateBits;
+                    subresourceStates[subresource] = stateBits;
                 }
             }
         }
@@ -139,8 +210,11 @@ namespace nvrhi
         if (!tracking)
             return ResourceStates::Unknown;
 
+        if (!tracking->trackSubresources)
+            return tracking->state;
+
         uint32_t subresource = calcSubresource(mipLevel, arraySlice, texture->descRef);
-        return tracking->subresourceStates[subresource];
+        return getSubresourceStates(tracking)[subresource];
     }
 
     ResourceStates CommandListResourceStateTracker::getBufferState(BufferStateExtension* buffer)
@@ -165,7 +239,7 @@ namespace nvrhi
 
         TextureState* tracking = getTextureStateTracking(texture, true);
         
-        if (subresources.isEntireTexture(texture->descRef) && tracking->subresourceStates.empty())
+        if (subresources.isEntireTexture(texture->descRef) && !tracking->trackSubresources)
         {
             // We're requiring state for the entire texture, and it's been tracked as entire texture too
 
@@ -196,7 +270,8 @@ namespace nvrhi
 
             // Make sure that we're tracking the texture on subresource level
             bool stateExpanded = false;
-            if (tracking->subresourceStates.empty())
+            ResourceStates* subresourceStates;
+            if (!tracking->trackSubresources)
             {
                 if (tracking->state == ResourceStates::Unknown)
                 {
@@ -207,10 +282,13 @@ namespace nvrhi
                     m_MessageCallback->message(MessageSeverity::Error, ss.str().c_str());
                 }
 
-                tracking->subresourceStates.resize(texture->descRef.mipLevels * texture->descRef.arraySize, tracking->state);
-                tracking->state = ResourceStates::Unknown;
+                subresourceStates = expandSubresourceStates(tracking);
                 stateExpanded = true;
             }
+            else
+            {
+                subresourceStates = getSubresourceStates(tracking);
+            }
             
             bool anyUavBarrier = false;
 
@@ -220,7 +298,7 @@ namespace nvrhi
                 {
                     uint32_t subresourceIndex = calcSubresource(mipLevel, arraySlice, texture->descRef);
 
-                    auto priorState = tracking->subresourceStates[subresourceIndex];
+                    auto priorState = subresourceStates[subresourceIndex];
 
                     if (priorState == ResourceStates::Unknown && !stateExpanded)
                     {
@@ -248,7 +326,7 @@ namespace nvrhi
                         m_TextureBarriers.push_back(barrier);
                     }
 
-                    tracking->subresourceStates[subresourceIndex] = state;
+                    subresourceStates[subresourceIndex] = state;
 
                     if (uavNecessary && !transitionNecessary)
                     {
@@ -328,12 +406,16 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepBufferInitialStates()
     {
-        for (auto& [buffer, tracking] : m_BufferStates)
+        // Slots of tracked resources are not moved by requireBufferState, so the references stay valid
+        for (uint32_t index : m_TrackedBuffers)
         {
+            const BufferState& tracking = m_BufferStates[index];
+            BufferStateExtension* buffer = tracking.buffer;
+
             if (buffer->descRef.keepInitialState && 
                 !buffer->permanentState &&
                 !buffer->descRef.isVolatile &&
-                !tracking->permanentTransition)
+                !tracking.permanentTransition)
             {
                 requireBufferState(buffer, buffer->descRef.initialState);
             }
@@ -342,11 +424,14 @@ namespace nvrhi
 
     void CommandListResourceStateTracker::keepTextureInitialStates()
     {
-        for (auto& [texture, tracking] : m_TextureStates)
+        for (uint32_t index : m_TrackedTextures)
         {
+            const TextureState& tracking = m_TextureStates[index];
+            TextureStateExtension* texture = tracking.texture;
+
             if (texture->descRef.keepInitialState && 
                 !texture->permanentState && 
-                !tracking->permanentTransition)
+                !tracking.permanentTransition)
             {
                 requireTextureState(texture, AllSubresources, texture->descRef.initialState);
             }
@@ -385,63 +470,116 @@ namespace nvrhi
         }
         m_PermanentBufferStates.clear();
 
-        for (const auto& [texture, stateTracking] : m_TextureStates)
+        for (uint32_t index : m_TrackedTextures)
         {
+            TextureStateExtension* texture = m_TextureStates[index].texture;
             if (texture->descRef.keepInitialState && !texture->stateInitialized)
                 texture->stateInitialized = true;
         }
 
-        m_TextureStates.clear();
-        m_BufferStates.clear();
+        // Invalidate all slots without touching them. On the (theoretical) wraparound, reset the slots
+        // so that stale generation numbers cannot match the new ones.
+        ++m_Generation;
+        if (m_Generation == 0)
+        {
+            m_TextureStates.assign(m_TextureStates.size(), TextureState());
+            m_BufferStates.assign(m_BufferStates.size(), BufferState());
+            m_Generation = 1;
+        }
+
+        m_TrackedTextures.clear();
+        m_TrackedBuffers.clear();
+        m_SubresourceStates.clear();
     }
 
     TextureState* CommandListResourceStateTracker::getTextureStateTracking(TextureStateExtension* texture, bool allowCreate)
     {
-        auto it = m_TextureStates.find(texture);
+        const uint32_t index = texture->trackerIndex;
 
-        if (it != m_TextureStates.end())
+        if (index < m_TextureStates.size())
         {
-            return it->second.get();
+            TextureState& slot = m_TextureStates[index];
+            if (slot.generation == m_Generation && slot.texture == texture)
+                return &slot;
         }
 
         if (!allowCreate)
             return nullptr;
-        
-        std::unique_ptr<TextureState> trackingRef = std::make_unique<TextureState>();
 
-        TextureState* tracking = trackingRef.get();
-        m_TextureStates.insert(std::make_pair(texture, std::move(trackingRef)));
+        if (index >= m_TextureStates.size())
+            m_TextureStates.resize(index + 1);
+
+        TextureState& tracking = m_TextureStates[index];
+
+        // The slot may still belong to a destroyed texture whose index has been reused within this command list
+        if (tracking.generation != m_Generation)
+            m_TrackedTextures.push_back(index);
+
+        tracking = TextureState();
+        tracking.texture = texture;
+        tracking.generation = m_Generation;
         
         if (texture->descRef.keepInitialState)
         {
-            tracking->state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
+            tracking.state = texture->stateInitialized ? texture->descRef.initialState : ResourceStates::Common;
         }
 
-        return tracking;
+        return &tracking;
     }
 
     BufferState* CommandListResourceStateTracker::getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate)
     {
-        auto it = m_BufferStates.find(buffer);
+        const uint32_t index = buffer->trackerIndex;
 
-        if (it != m_BufferStates.end())
+        if (index < m_BufferStates.size())
         {
-            return it->second.get();
+            BufferState& slot = m_BufferStates[index];
+            if (slot.generation == m_Generation && slot.buffer == buffer)
+                return &slot;
         }
 
         if (!allowCreate)
             return nullptr;
 
-        std::unique_ptr<BufferState> trackingRef = std::make_unique<BufferState>();
+        if (index >= m_BufferStates.size())
+            m_BufferStates.resize(index + 1);
 
-        BufferState* tracking = trackingRef.get();
-        m_BufferStates.insert(std::make_pair(buffer, std::move(trackingRef)));
+        BufferState& tracking = m_BufferStates[index];
+
+        if (tracking.generation != m_Generation)
+            m_TrackedBuffers.push_back(index);
+
+        tracking = BufferState();
+        tracking.buffer = buffer;
+        tracking.generation = m_Generation;
                                                    
         if (buffer->descRef.keepInitialState)
         {
-            tracking->state = buffer->descRef.initialState;
+            tracking.state = buffer->descRef.initialState;
+        }
+
+        return &tracking;
+    }
+
+    ResourceStates* CommandListResourceStateTracker::expandSubresourceStates(TextureState* tracking)
+    {
+        const TextureDesc& desc = tracking->texture->descRef;
+        const uint32_t numSubresources = desc.mipLevels * desc.arraySize;
+
+        // A texture that goes back to whole-resource tracking keeps its range for the rest of the command list
+        if (tracking->subresourceOffset == ~0u)
+        {
+            tracking->subresourceOffset = uint32_t(m_SubresourceStates.size());
+            m_SubresourceStates.resize(m_SubresourceStates.size() + numSubresources);
         }
 
-        return tracking;
+        ResourceStates* subresourceStates = getSubresourceStates(tracking);
+        std::fill(subresourceStates, subresourceStates + numSubresources, tracking->state);
+
+        tracking->state = ResourceStates::Unknown;
+        tracking->trackSubresources = true;
+
+        return subresourceStates;
     }
-} // namespace nvrhi
\ No newline at end of file
+
+} // namespace nvrhi
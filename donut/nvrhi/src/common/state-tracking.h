@@ -25,6 +25,7 @@
 #include <nvrhi/nvrhi.h>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace nvrhi
 {
@@ -33,9 +34,15 @@ namespace nvrhi
         const BufferDesc& descRef;
         ResourceStates permanentState = ResourceStates::Unknown;
 
-        explicit BufferStateExtension(const BufferDesc& desc)
-            : descRef(desc)
-        { }
+        // Dense index among all live buffers, used to find the buffer's state slot in command lists.
+        // Indices of destroyed buffers are reused.
+        const uint32_t trackerIndex;
+
+        explicit BufferStateExtension(const BufferDesc& desc);
+        ~BufferStateExtension();
+
+        BufferStateExtension(const BufferStateExtension&) = delete;
+        BufferStateExtension& operator=(const BufferStateExtension&) = delete;
     };
 
     struct TextureStateExtension
@@ -45,14 +52,27 @@ namespace nvrhi
         bool stateInitialized = false;
         bool isSamplerFeedback = false;
 
-        explicit TextureStateExtension(const TextureDesc& desc)
-            : descRef(desc)
-        { }
+        // Dense index among all live textures, see BufferStateExtension::trackerIndex
+        const uint32_t trackerIndex;
+
+        explicit TextureStateExtension(const TextureDesc& desc);
+        ~TextureStateExtension();
+
+        TextureStateExtension(const TextureStateExtension&) = delete;
+        TextureStateExtension& operator=(const TextureStateExtension&) = delete;
     };
 
     struct TextureState
     {
-        std::vector<ResourceStates> subresourceStates;
+        // The texture that owns this slot, valid only if generation matches the tracker's generation.
+        TextureStateExtension* texture = nullptr;
+        uint32_t generation = 0;
+
+        // Offset of (mipLevels * arraySize) per-subresource states in the tracker's subresource arena,
+        // allocated on first use. The states are only meaningful if trackSubresources is true.
+        uint32_t subresourceOffset = ~0u;
+        bool trackSubresources = false;
+
         ResourceStates state = ResourceStates::Unknown;
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
@@ -61,6 +81,10 @@ namespace nvrhi
 
     struct BufferState
     {
+        // The buffer that owns this slot, valid only if generation matches the tracker's generation.
+        BufferStateExtension* buffer = nullptr;
+        uint32_t generation = 0;
+
         ResourceStates state = ResourceStates::Unknown;
         bool enableUavBarriers = true;
         bool firstUavBarrierPlaced = false;
@@ -121,8 +145,18 @@ namespace nvrhi
     private:
         IMessageCallback* m_MessageCallback;
 
-        std::unordered_map<TextureStateExtension*, std::unique_ptr<TextureState>> m_TextureStates;
-        std::unordered_map<BufferStateExtension*, std::unique_ptr<BufferState>> m_BufferStates;
+        // State slots indexed by the resources' trackerIndex. The arrays are never shrunk, and the slots
+        // are invalidated at once by incrementing m_Generation when the command list is submitted.
+        std::vector<TextureState> m_TextureStates;
+        std::vector<BufferState> m_BufferStates;
+        uint32_t m_Generation = 1;
+
+        // Indices of the slots that are in use in the current generation, in the order of first use.
+        std::vector<uint32_t> m_TrackedTextures;
+        std::vector<uint32_t> m_TrackedBuffers;
+
+        // Storage for the per-subresource states of all textures, reset on submission.
+        std::vector<ResourceStates> m_SubresourceStates;
 
         // Deferred transitions of textures and buffers to permanent states.
         // They are executed only when the command list is executed, not when the app calls setPermanentTextureState or setPermanentBufferState.
@@ -134,6 +168,10 @@ namespace nvrhi
 
         TextureState* getTextureStateTracking(TextureStateExtension* texture, bool allowCreate);
         BufferState* getBufferStateTracking(BufferStateExtension* buffer, bool allowCreate);
+
+        // Switches the texture to per-subresource tracking, filling all subresources with its current state
+        ResourceStates* expandSubresourceStates(TextureState* tracking);
+        ResourceStates* getSubresourceStates(const TextureState* tracking) { return m_SubresourceStates.data() + tracking->subresourceOffset; }
     };
 
     bool verifyPermanentResourceState(ResourceStates permanentState, ResourceStates requiredState, bool isTexture, const std::string& debugName, IMessageCallback* messageCallback);
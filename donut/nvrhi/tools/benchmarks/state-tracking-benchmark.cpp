@@ -0,0 +1,220 @@
+/*
+* Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+/*
+Synthetic benchmark for CommandListResourceStateTracker. It replays a stream of state requests
+that resembles the draw path of a renderer: every "draw" requires a few shader resources from a
+large pool with a hot subset, some vertex and index buffers, and a render target; some passes write
+individual mip levels of a texture. Barriers are consumed after each draw like commitBarriers() does.
+
+Usage: nvrhi-bench-state-tracking [commandLists] [drawsPerCommandList]
+*/
+
+#include "../../src/common/state-tracking.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace nvrhi;
+
+namespace
+{
+    class NullMessageCallback : public IMessageCallback
+    {
+    public:
+        void message(MessageSeverity severity, const char* messageText) override
+        {
+            if (severity >= MessageSeverity::Error)
+                fprintf(stderr, "%s\n", messageText);
+        }
+    };
+
+    struct FakeTexture
+    {
+        TextureDesc desc;
+        std::unique_ptr<TextureStateExtension> extension;
+
+        explicit FakeTexture(const TextureDesc& _desc)
+            : desc(_desc)
+            , extension(std::make_unique<TextureStateExtension>(desc))
+        { }
+    };
+
+    struct FakeBuffer
+    {
+        BufferDesc desc;
+        std::unique_ptr<BufferStateExtension> extension;
+
+        explicit FakeBuffer(const BufferDesc& _desc)
+            : desc(_desc)
+            , extension(std::make_unique<BufferStateExtension>(desc))
+        { }
+    };
+
+    struct Request
+    {
+        enum class Type : uint8_t { Texture, TextureMip, Buffer, Commit };
+
+        Type type;
+        uint32_t resource;
+        uint32_t mipLevel;
+        ResourceStates state;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t numCommandLists = argc > 1 ? uint32_t(atoi(argv[1])) : 200;
+    const uint32_t drawsPerCommandList = argc > 2 ? uint32_t(atoi(argv[2])) : 2000;
+
+    constexpr uint32_t numMaterialTextures = 4000;
+    constexpr uint32_t numRenderTargets = 16;
+    constexpr uint32_t numBuffers = 1000;
+    constexpr uint32_t hotSetSize = 300;
+
+    std::vector<FakeTexture> textures;
+    textures.reserve(numMaterialTextures + numRenderTargets);
+    std::vector<FakeBuffer> buffers;
+    buffers.reserve(numBuffers);
+
+    for (uint32_t i = 0; i < numMaterialTextures; i++)
+    {
+        TextureDesc desc;
+        desc.width = desc.height = 1024;
+        desc.mipLevels = 11;
+        desc.initialState = ResourceStates::ShaderResource;
+        desc.keepInitialState = true;
+        textures.emplace_back(desc);
+    }
+
+    for (uint32_t i = 0; i < numRenderTargets; i++)
+    {
+        TextureDesc desc;
+        desc.width = desc.height = 2048;
+        desc.mipLevels = 12;
+        desc.isRenderTarget = true;
+        desc.isUAV = true;
+        desc.initialState = ResourceStates::ShaderResource;
+        desc.keepInitialState = true;
+        textures.emplace_back(desc);
+    }
+
+    for (uint32_t i = 0; i < numBuffers; i++)
+    {
+        BufferDesc desc;
+        desc.byteSize = 1024 * 1024;
+        desc.initialState = ResourceStates::ShaderResource;
+        desc.keepInitialState = true;
+        buffers.emplace_back(desc);
+    }
+
+    // Generate the request stream upfront so that the timing only includes the tracker
+    std::mt19937 rng(1);
+    auto pickTexture = [&rng]()
+    {
+        // 90% of the accesses go to the hot set
+        if (rng() % 10 != 0)
+            return uint32_t(rng() % hotSetSize);
+        return uint32_t(rng() % numMaterialTextures);
+    };
+
+    std::vector<Request> stream;
+    for (uint32_t draw = 0; draw < drawsPerCommandList; draw++)
+    {
+        const uint32_t renderTarget = numMaterialTextures + (draw / 256) % numRenderTargets;
+
+        if (draw % 512 == 511)
+        {
+            // A mip generation pass: read mip N-1, write mip N
+            const uint32_t target = numMaterialTextures + (draw / 512) % numRenderTargets;
+            for (uint32_t mip = 1; mip < 12; mip++)
+            {
+                stream.push_back({ Request::Type::TextureMip, target, mip - 1, ResourceStates::ShaderResource });
+                stream.push_back({ Request::Type::TextureMip, target, mip, ResourceStates::UnorderedAccess });
+                stream.push_back({ Request::Type::Commit, 0, 0, ResourceStates::Unknown });
+            }
+        }
+
+        stream.push_back({ Request::Type::Texture, renderTarget, 0, ResourceStates::RenderTarget });
+        for (int i = 0; i < 4; i++)
+            stream.push_back({ Request::Type::Texture, pickTexture(), 0, ResourceStates::ShaderResource });
+
+        const uint32_t buffer = uint32_t(rng() % numBuffers);
+        stream.push_back({ Request::Type::Buffer, buffer, 0, ResourceStates::IndexBuffer });
+        stream.push_back({ Request::Type::Buffer, buffer, 0, ResourceStates::VertexBuffer });
+        stream.push_back({ Request::Type::Buffer, uint32_t(rng() % numBuffers), 0, ResourceStates::ShaderResource });
+        stream.push_back({ Request::Type::Commit, 0, 0, ResourceStates::Unknown });
+    }
+
+    NullMessageCallback messageCallback;
+    CommandListResourceStateTracker tracker(&messageCallback);
+
+    size_t numRequests = 0;
+    size_t numBarriers = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t commandList = 0; commandList < numCommandLists; commandList++)
+    {
+        for (const Request& request : stream)
+        {
+            switch (request.type)
+            {
+            case Request::Type::Texture:
+                tracker.requireTextureState(textures[request.resource].extension.get(), AllSubresources, request.state);
+                ++numRequests;
+                break;
+            case Request::Type::TextureMip:
+                tracker.requireTextureState(textures[request.resource].extension.get(), TextureSubresourceSet(request.mipLevel, 1, 0, 1), request.state);
+                ++numRequests;
+                break;
+            case Request::Type::Buffer:
+                tracker.requireBufferState(buffers[request.resource].extension.get(), request.state);
+                ++numRequests;
+                break;
+            case Request::Type::Commit:
+                numBarriers += tracker.getTextureBarriers().size() + tracker.getBufferBarriers().size();
+                tracker.clearBarriers();
+                break;
+            }
+        }
+
+        tracker.keepBufferInitialStates();
+        tracker.keepTextureInitialStates();
+        numBarriers += tracker.getTextureBarriers().size() + tracker.getBufferBarriers().size();
+        tracker.clearBarriers();
+        tracker.commandListSubmitted();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    printf("%u command lists, %zu state requests, %zu barriers\n", numCommandLists, numRequests, numBarriers);
+    printf("Total: %.2f ms, %.1f ns per request\n", seconds * 1e3, seconds * 1e9 / double(numRequests));
+
+    return 0;
+}
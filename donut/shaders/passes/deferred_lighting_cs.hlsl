@@ -27,6 +27,10 @@
 #include <donut/shaders/shadows.hlsli>
 #include <donut/shaders/deferred_lighting_cb.h>
 
+#if CLUSTERED_LIGHTING
+#include <donut/shaders/light_clustering.hlsli>
+#endif
+
 cbuffer c_Deferred : register(b0)
 {
     DeferredLightingConstants g_Deferred;
@@ -55,6 +59,16 @@ Texture2D t_AmbientOcclusion : register(t17);
 
 RWTexture2D<float4> u_Output : register(u0);
 
+#if CLUSTERED_LIGHTING
+cbuffer c_LightClusters : register(b1)
+{
+    LightClusterConstants g_LightClusters;
+};
+
+StructuredBuffer<LightConstants> t_ClusteredLights : register(t18);
+StructuredBuffer<uint> t_LightClusters : register(t19);
+#endif
+
 float GetRandom(float2 pos)
 {
     int x = int(pos.x) & 3;
@@ -143,6 +157,24 @@ void main(int2 i_globalIdx : SV_DispatchThreadID)
         specularTerm += (shadow.x * specularRadiance) * light.color;
     }
 
+#if CLUSTERED_LIGHTING
+    // Clustered lights have no shadows, see LightClusteringPass::IsClusteredLight
+    uint clusterOffset = GetLightClusterOffset(g_LightClusters, float2(pixelPosition) + 0.5, surfaceWorldPos);
+    uint numClusterLights = t_LightClusters[clusterOffset];
+
+    [loop]
+    for (uint nClusterLight = 0; nClusterLight < numClusterLights; nClusterLight++)
+    {
+        LightConstants light = t_ClusteredLights[t_LightClusters[clusterOffset + 1 + nClusterLight]];
+
+        float3 diffuseRadiance, specularRadiance;
+        ShadeSurface(light, surfaceMaterial, surfaceWorldPos, viewIncident, diffuseRadiance, specularRadiance);
+
+        diffuseTerm += diffuseRadiance * light.color;
+        specularTerm += specularRadiance * light.color;
+    }
+#endif
+
     float ambientOcclusion = 1;
     if (g_Deferred.enableAmbientOcclusion != 0)
     {
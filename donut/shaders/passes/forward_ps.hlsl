@@ -46,6 +46,9 @@
 #include <donut/shaders/lighting.hlsli>
 #include <donut/shaders/shadows.hlsli>
 #include <donut/shaders/binding_helpers.hlsli>
+#if CLUSTERED_LIGHTING
+#include <donut/shaders/light_clustering.hlsli>
+#endif
 
 DECLARE_CBUFFER(ForwardShadingViewConstants, g_ForwardView, FORWARD_BINDING_VIEW_CONSTANTS,         FORWARD_SPACE_VIEW);
 DECLARE_CBUFFER(ForwardShadingLightConstants, g_ForwardLight, FORWARD_BINDING_LIGHT_CONSTANTS,      FORWARD_SPACE_SHADING);
@@ -59,6 +62,13 @@ SamplerState s_ShadowSampler          : REGISTER_SAMPLER(FORWARD_BINDING_SHADOW_
 SamplerState s_LightProbeSampler      : REGISTER_SAMPLER(FORWARD_BINDING_LIGHT_PROBE_SAMPLER,       FORWARD_SPACE_SHADING);
 SamplerState s_BrdfSampler            : REGISTER_SAMPLER(FORWARD_BINDING_ENVIRONMENT_BRDF_SAMPLER,  FORWARD_SPACE_SHADING);
 
+#if CLUSTERED_LIGHTING
+DECLARE_CBUFFER(LightClusterConstants, g_LightClusters, FORWARD_BINDING_LIGHT_CLUSTER_CONSTANTS,    FORWARD_SPACE_SHADING);
+
+StructuredBuffer<LightConstants> t_ClusteredLights : REGISTER_SRV(FORWARD_BINDING_CLUSTERED_LIGHTS, FORWARD_SPACE_SHADING);
+StructuredBuffer<uint> t_LightClusters             : REGISTER_SRV(FORWARD_BINDING_LIGHT_CLUSTERS,   FORWARD_SPACE_SHADING);
+#endif
+
 float3 GetIncidentVector(float4 directionOrPosition, float3 surfacePos)
 {
     if (directionOrPosition.w > 0)
@@ -138,6 +148,24 @@ void main(
         specularTerm += (shadow.x * specularRadiance) * light.color;
     }
 
+#if CLUSTERED_LIGHTING
+    // Clustered lights have no shadows, see LightClusteringPass::IsClusteredLight
+    uint clusterOffset = GetLightClusterOffset(g_LightClusters, i_position.xy, surfaceWorldPos);
+    uint numClusterLights = t_LightClusters[clusterOffset];
+
+    [loop]
+    for (uint nClusterLight = 0; nClusterLight < numClusterLights; nClusterLight++)
+    {
+        LightConstants light = t_ClusteredLights[t_LightClusters[clusterOffset + 1 + nClusterLight]];
+
+        float3 diffuseRadiance, specularRadiance;
+        ShadeSurface(light, surfaceMaterial, surfaceWorldPos, viewIncident, diffuseRadiance, specularRadiance);
+
+        diffuseTerm += diffuseRadiance * light.color;
+        specularTerm += specularRadiance * light.color;
+    }
+#endif
+
     float NdotV = saturate(-dot(surfaceMaterial.shadingNormal, viewIncident));
 
     if(g_ForwardLight.numLightProbes > 0)
@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma pack_matrix(row_major)
+
+#include <donut/shaders/bindless.h>
+#include <donut/shaders/gbuffer_cb.h>
+#include <donut/shaders/meshlet_cb.h>
+#include <donut/shaders/binding_helpers.hlsli>
+
+DECLARE_CBUFFER(GBufferFillConstants, c_GBuffer, GBUFFER_BINDING_VIEW_CONSTANTS, GBUFFER_SPACE_VIEW);
+
+StructuredBuffer<InstanceData> t_Instances : REGISTER_SRV(GBUFFER_BINDING_INSTANCE_BUFFER, GBUFFER_SPACE_INPUT);
+StructuredBuffer<MeshletData> t_Meshlets : REGISTER_SRV(GBUFFER_BINDING_MESHLET_BUFFER, GBUFFER_SPACE_INPUT);
+
+DECLARE_PUSH_CONSTANTS(GBufferMeshletPushConstants, g_Push, GBUFFER_BINDING_PUSH_CONSTANTS, GBUFFER_SPACE_INPUT);
+
+groupshared MeshletPayload s_Payload;
+groupshared uint s_VisibleMeshlets;
+
+bool IsMeshletVisible(MeshletData meshlet, InstanceData instance)
+{
+    const float3 axisX = instance.transform._m00_m10_m20;
+    const float3 axisY = instance.transform._m01_m11_m21;
+    const float3 axisZ = instance.transform._m02_m12_m22;
+    const float3 scaleSquared = float3(dot(axisX, axisX), dot(axisY, axisY), dot(axisZ, axisZ));
+    const float maxScaleSquared = max(scaleSquared.x, max(scaleSquared.y, scaleSquared.z));
+
+    const float3 center = mul(instance.transform, float4(meshlet.center, 1.0)).xyz;
+    const float radius = meshlet.radius * sqrt(maxScaleSquared);
+
+    if (g_Push.cullFlags & MeshletCullFlag_Frustum)
+    {
+        // Side planes of the view frustum, extracted from the columns of the world-to-clip matrix.
+        // The near and far planes rarely reject anything in a G-buffer pass, so they are not tested.
+        const float4x4 worldToClip = c_GBuffer.view.matWorldToClip;
+        const float4 columnX = worldToClip._m00_m10_m20_m30;
+        const float4 columnY = worldToClip._m01_m11_m21_m31;
+        const float4 columnW = worldToClip._m03_m13_m23_m33;
+        const float4 planes[4] = { columnW + columnX, columnW - columnX, columnW + columnY, columnW - columnY };
+
+        [unroll]
+        for (uint i = 0; i < 4; i++)
+        {
+            if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz))
+                return false;
+        }
+    }
+
+    if ((g_Push.cullFlags & MeshletCullFlag_Cone) && meshlet.coneCutoff < 1.0)
+    {
+        // The cone stays valid only under uniform scaling, allow for a ~1% difference between the axes
+        const float minScaleSquared = min(scaleSquared.x, min(scaleSquared.y, scaleSquared.z));
+        if (maxScaleSquared <= minScaleSquared * 1.02)
+        {
+            // Transform the axis with the cofactor matrix, which also handles mirroring transforms
+            const float3 coneAxis = normalize(
+                meshlet.coneAxis.x * cross(axisY, axisZ) +
+                meshlet.coneAxis.y * cross(axisZ, axisX) +
+                meshlet.coneAxis.z * cross(axisX, axisY));
+
+            const float4 camera = c_GBuffer.view.cameraDirectionOrPosition;
+            if (camera.w > 0)
+            {
+                const float3 toCenter = center - camera.xyz;
+                if (dot(toCenter, coneAxis) >= meshlet.coneCutoff * length(toCenter) + radius)
+                    return false;
+            }
+            else if (dot(camera.xyz, coneAxis) >= meshlet.coneCutoff)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Each thread tests one meshlet of one instance, and the visible ones are compacted into the payload.
+// The Y dimension of the dispatch enumerates the instances drawn with the same geometry.
+[numthreads(MESHLET_TASK_GROUP_SIZE, 1, 1)]
+void main(
+    uint i_threadIndex : SV_GroupIndex,
+    uint3 i_groupId : SV_GroupID)
+{
+    if (i_threadIndex == 0)
+    {
+        s_VisibleMeshlets = 0;
+        s_Payload.instanceOffset = i_groupId.y;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint meshletIndex = i_groupId.x * MESHLET_TASK_GROUP_SIZE + i_threadIndex;
+
+    if (meshletIndex < g_Push.numMeshlets)
+    {
+        const MeshletData meshlet = t_Meshlets[g_Push.firstMeshlet + meshletIndex];
+        const InstanceData instance = t_Instances[g_Push.startInstanceLocation + i_groupId.y];
+
+        if (IsMeshletVisible(meshlet, instance))
+        {
+            uint slot;
+            InterlockedAdd(s_VisibleMeshlets, 1, slot);
+            s_Payload.meshletIndices[slot] = g_Push.firstMeshlet + meshletIndex;
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    DispatchMesh(s_VisibleMeshlets, 1, 1, s_Payload);
+}
@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma pack_matrix(row_major)
+
+#include <donut/shaders/bindless.h>
+#include <donut/shaders/gbuffer_cb.h>
+#include <donut/shaders/meshlet_cb.h>
+#include <donut/shaders/binding_helpers.hlsli>
+#include <donut/shaders/packing.hlsli>
+
+DECLARE_CBUFFER(GBufferFillConstants, c_GBuffer, GBUFFER_BINDING_VIEW_CONSTANTS, GBUFFER_SPACE_VIEW);
+
+StructuredBuffer<InstanceData> t_Instances : REGISTER_SRV(GBUFFER_BINDING_INSTANCE_BUFFER, GBUFFER_SPACE_INPUT);
+ByteAddressBuffer t_Vertices : REGISTER_SRV(GBUFFER_BINDING_VERTEX_BUFFER, GBUFFER_SPACE_INPUT);
+StructuredBuffer<MeshletData> t_Meshlets : REGISTER_SRV(GBUFFER_BINDING_MESHLET_BUFFER, GBUFFER_SPACE_INPUT);
+ByteAddressBuffer t_MeshletIndices : REGISTER_SRV(GBUFFER_BINDING_MESHLET_INDEX_BUFFER, GBUFFER_SPACE_INPUT);
+
+DECLARE_PUSH_CONSTANTS(GBufferMeshletPushConstants, g_Push, GBUFFER_BINDING_PUSH_CONSTANTS, GBUFFER_SPACE_INPUT);
+
+// Same outputs as gbuffer_vs, with the SceneVertex fields flattened
+struct MeshletVertex
+{
+    float4 position : SV_Position;
+    float3 pos : POS;
+    float3 prevPos : PREV_POS;
+    float2 texCoord : TEXCOORD;
+    centroid float3 normal : NORMAL;
+    centroid float4 tangent : TANGENT;
+    nointerpolation uint instance : INSTANCE;
+};
+
+MeshletVertex LoadMeshletVertex(uint vertex, InstanceData instance)
+{
+    float3 pos = LoadVertexPosition(t_Vertices, g_Push.positionOffset, vertex, g_Push.formatFlags, instance.positionScale, instance.positionBias);
+    float3 prevPos = LoadVertexPosition(t_Vertices, g_Push.prevPositionOffset, vertex, g_Push.formatFlags, instance.positionScale, instance.positionBias);
+    float2 texCoord = LoadVertexTexCoord(t_Vertices, g_Push.texCoordOffset, vertex, g_Push.formatFlags);
+    uint packedNormal = t_Vertices.Load(g_Push.normalOffset + vertex * c_SizeOfNormal);
+    uint packedTangent = t_Vertices.Load(g_Push.tangentOffset + vertex * c_SizeOfNormal);
+    float3 normal = Unpack_RGB8_SNORM(packedNormal);
+    float4 tangent = Unpack_RGBA8_SNORM(packedTangent);
+
+    MeshletVertex o;
+    o.pos = mul(instance.transform, float4(pos, 1.0)).xyz;
+    o.texCoord = texCoord;
+    o.normal = mul(instance.transform, float4(normal, 0)).xyz;
+    o.tangent.xyz = mul(instance.transform, float4(tangent.xyz, 0)).xyz;
+    o.tangent.w = tangent.w;
+#if MOTION_VECTORS
+    o.prevPos = mul(instance.prevTransform, float4(prevPos, 1.0)).xyz;
+#else
+    o.prevPos = o.pos;
+#endif
+    o.position = mul(float4(o.pos, 1.0), c_GBuffer.view.matWorldToClip);
+    o.instance = 0;
+
+    return o;
+}
+
+// One thread group per visible meshlet. The group is kept at 32 threads to stay within
+// the limits of all mesh shader implementations, so each thread handles several vertices and triangles.
+[numthreads(MESHLET_MESH_GROUP_SIZE, 1, 1)]
+[outputtopology("triangle")]
+void main(
+    uint i_threadIndex : SV_GroupIndex,
+    uint3 i_groupId : SV_GroupID,
+    in payload MeshletPayload i_payload,
+    out vertices MeshletVertex o_vertices[MESHLET_MAX_VERTICES],
+    out indices uint3 o_triangles[MESHLET_MAX_TRIANGLES])
+{
+    const MeshletData meshlet = t_Meshlets[i_payload.meshletIndices[i_groupId.x]];
+    const InstanceData instance = t_Instances[g_Push.startInstanceLocation + i_payload.instanceOffset];
+
+    SetMeshOutputCounts(meshlet.vertexCount, meshlet.triangleCount);
+
+    for (uint vertex = i_threadIndex; vertex < meshlet.vertexCount; vertex += MESHLET_MESH_GROUP_SIZE)
+    {
+        uint vertexIndex = t_MeshletIndices.Load((meshlet.vertexOffset + vertex) * 4);
+
+        MeshletVertex o = LoadMeshletVertex(g_Push.startVertexLocation + vertexIndex, instance);
+        o.instance = i_payload.instanceOffset;
+        o_vertices[vertex] = o;
+    }
+
+    for (uint primitive = i_threadIndex; primitive < meshlet.triangleCount; primitive += MESHLET_MESH_GROUP_SIZE)
+    {
+        uint packedTriangle = t_MeshletIndices.Load((meshlet.triangleOffset + primitive) * 4);
+        o_triangles[primitive] = uint3(packedTriangle & 0xff, (packedTriangle >> 8) & 0xff, (packedTriangle >> 16) & 0xff);
+    }
+}
@@ -81,32 +81,21 @@ ByteAddressBuffer t_Vertices : REGISTER_SRV(GBUFFER_BINDING_VERTEX_BUFFER, GBUFF
 
 DECLARE_PUSH_CONSTANTS(GBufferPushConstants, g_Push, GBUFFER_BINDING_PUSH_CONSTANTS, GBUFFER_SPACE_INPUT);
 
-// Version of the vertex shader that uses buffer loads to read vertex attributes and transforms.
-void buffer_loads(
-    in uint i_vertex : SV_VertexID,
-	in uint i_instance : SV_InstanceID,
-    out float4 o_position : SV_Position,
-    out SceneVertex o_vtx,
-#if MOTION_VECTORS
-    out float3 o_prevWorldPos : PREV_WORLD_POS,
-#endif
-    out uint o_instance : INSTANCE
-)
+void LoadAndTransformVertex(
+    uint i_instance,
+    uint i_vertex,
+    out float4 o_position,
+    out SceneVertex o_vtx)
 {
-    o_instance = i_instance;
-
-    i_instance += g_Push.startInstanceLocation;
-    i_vertex += g_Push.startVertexLocation;
-
 #ifdef TARGET_D3D11
     const InstanceData instance = LoadInstanceData(t_Instances, i_instance * c_SizeOfInstanceData);
 #else
     const InstanceData instance = t_Instances[i_instance];
 #endif
 
-    float3 pos = asfloat(t_Vertices.Load3(g_Push.positionOffset + i_vertex * c_SizeOfPosition));
-    float3 prevPos = asfloat(t_Vertices.Load3(g_Push.prevPositionOffset + i_vertex * c_SizeOfPosition));
-    float2 texCoord = asfloat(t_Vertices.Load2(g_Push.texCoordOffset + i_vertex * c_SizeOfTexcoord));
+    float3 pos = LoadVertexPosition(t_Vertices, g_Push.positionOffset, i_vertex, g_Push.formatFlags, instance.positionScale, instance.positionBias);
+    float3 prevPos = LoadVertexPosition(t_Vertices, g_Push.prevPositionOffset, i_vertex, g_Push.formatFlags, instance.positionScale, instance.positionBias);
+    float2 texCoord = LoadVertexTexCoord(t_Vertices, g_Push.texCoordOffset, i_vertex, g_Push.formatFlags);
     uint packedNormal = t_Vertices.Load(g_Push.normalOffset + i_vertex * c_SizeOfNormal);
     uint packedTangent = t_Vertices.Load(g_Push.tangentOffset + i_vertex * c_SizeOfNormal);
     float3 normal = Unpack_RGB8_SNORM(packedNormal);
@@ -125,5 +114,41 @@ void buffer_loads(
 
     float4 worldPos = float4(o_vtx.pos, 1.0);
     o_position = mul(worldPos, c_GBuffer.view.matWorldToClip);
+}
+
+// Version of the vertex shader that uses buffer loads to read vertex attributes and transforms.
+void buffer_loads(
+    in uint i_vertex : SV_VertexID,
+	in uint i_instance : SV_InstanceID,
+    out float4 o_position : SV_Position,
+    out SceneVertex o_vtx,
+#if MOTION_VECTORS
+    out float3 o_prevWorldPos : PREV_WORLD_POS,
+#endif
+    out uint o_instance : INSTANCE
+)
+{
+    o_instance = i_instance;
+
+    LoadAndTransformVertex(i_instance + g_Push.startInstanceLocation, i_vertex + g_Push.startVertexLocation, o_position, o_vtx);
+}
+
+// Version of the buffer loads shader for the indirect draws produced by GpuCullingPass.
+// Push constants cannot change between the draws of one indirect call, so the instance and the first vertex
+// come from the draw record, which is bound as a per-instance vertex buffer: the input assembler applies
+// the StartInstanceLocation of every draw to it, unlike SV_InstanceID.
+void indirect(
+    in uint i_vertex : SV_VertexID,
+    in uint2 i_draw : DRAW,
+    out float4 o_position : SV_Position,
+    out SceneVertex o_vtx,
+#if MOTION_VECTORS
+    out float3 o_prevWorldPos : PREV_WORLD_POS,
+#endif
+    out uint o_instance : INSTANCE
+)
+{
+    o_instance = i_draw.x;
 
+    LoadAndTransformVertex(i_draw.x, i_vertex + i_draw.y, o_position, o_vtx);
 }
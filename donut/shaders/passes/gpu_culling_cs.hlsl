@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma pack_matrix(row_major)
+
+#include <donut/shaders/bindless.h>
+#include <donut/shaders/gpu_culling_cb.h>
+
+cbuffer c_GpuCulling : register(b0)
+{
+    GpuCullingConstants g_Culling;
+};
+
+StructuredBuffer<GpuCullingCandidate> t_Candidates : register(t0);
+ByteAddressBuffer t_Instances : register(t1);
+
+// Minimum and maximum depth of the pixels covered by every texel, see GBufferRenderTargets::BuildHiZ
+Texture2D<float2> t_HiZ : register(t2);
+
+RWStructuredBuffer<uint> u_DrawCounts : register(u0);
+RWByteAddressBuffer u_DrawArguments : register(u1);
+RWByteAddressBuffer u_DrawRecords : register(u2);
+
+bool IsBoxInFrustum(float3 center, float3 extent)
+{
+    [unroll]
+    for (uint plane = 0; plane < 6; plane++)
+    {
+        float4 equation = g_Culling.frustumPlanes[plane];
+        float distance = dot(equation.xyz, center) - equation.w - dot(abs(equation.xyz), extent);
+        if (distance > 0)
+            return false;
+    }
+
+    return true;
+}
+
+// Converts device depth into a value that grows towards the camera for both depth conventions
+float GetCloseness(float depth, bool reverseDepth)
+{
+    return reverseDepth ? depth : 1.0 - depth;
+}
+
+bool IsBoxOccluded(float3 center, float3 extent)
+{
+    const bool reverseDepth = (g_Culling.flags & GPU_CULLING_FLAG_REVERSE_DEPTH) != 0;
+
+    float2 uvMin = 1.0;
+    float2 uvMax = 0.0;
+    float nearest = 0.0;
+
+    [unroll]
+    for (uint corner = 0; corner < 8; corner++)
+    {
+        float3 offset = float3((corner & 1) ? 1 : -1, (corner & 2) ? 1 : -1, (corner & 4) ? 1 : -1);
+        float4 clipPos = mul(float4(center + extent * offset, 1.0), g_Culling.matHiZWorldToClip);
+
+        // Boxes that cross the near plane are never occluded
+        float nearPlaneDistance = reverseDepth ? clipPos.w - clipPos.z : clipPos.z;
+        if (nearPlaneDistance < 0 || clipPos.w <= 0)
+            return false;
+
+        float3 ndc = clipPos.xyz / clipPos.w;
+        float2 uv = ndc.xy * float2(0.5, -0.5) + 0.5;
+        uvMin = min(uvMin, uv);
+        uvMax = max(uvMax, uv);
+        nearest = max(nearest, GetCloseness(ndc.z, reverseDepth));
+    }
+
+    uvMin = saturate(uvMin);
+    uvMax = saturate(uvMax);
+    if (any(uvMin >= uvMax))
+        return false;
+
+    // Pick the level where the box covers at most 2x2 texels
+    float2 size = (uvMax - uvMin) * g_Culling.hizSize;
+    uint mip = uint(clamp(ceil(log2(max(max(size.x, size.y), 1.0))), 0.0, float(g_Culling.hizMipLevels - 1)));
+
+    // The texels of level 'mip' cover 2^(mip+1) pixels of the view, and the pyramid can extend past the view
+    float2 mipScale = g_Culling.hizSize / float(1u << mip);
+    uint2 mipSize;
+    uint mipLevels;
+    t_HiZ.GetDimensions(mip, mipSize.x, mipSize.y, mipLevels);
+
+    int2 p0 = min(int2(uvMin * mipScale), int2(mipSize) - 1);
+    int2 p1 = min(int2(uvMax * mipScale), int2(mipSize) - 1);
+    if (any(p1 - p0 > 1))
+        return false;
+
+    float2 d00 = t_HiZ.Load(int3(p0.x, p0.y, mip));
+    float2 d10 = t_HiZ.Load(int3(p1.x, p0.y, mip));
+    float2 d01 = t_HiZ.Load(int3(p0.x, p1.y, mip));
+    float2 d11 = t_HiZ.Load(int3(p1.x, p1.y, mip));
+
+    float farthest = reverseDepth
+        ? min(min(d00.x, d10.x), min(d01.x, d11.x))
+        : max(max(d00.y, d10.y), max(d01.y, d11.y));
+
+    return nearest < GetCloseness(farthest, reverseDepth);
+}
+
+[numthreads(GPU_CULLING_GROUP_SIZE, 1, 1)]
+void main(uint candidateIndex : SV_DispatchThreadID)
+{
+    if (candidateIndex >= g_Culling.numCandidates)
+        return;
+
+    GpuCullingCandidate candidate = t_Candidates[candidateIndex];
+
+    if ((candidate.flags & GPU_CULLING_CANDIDATE_NO_CULLING) == 0)
+    {
+        InstanceData instance = LoadInstanceData(t_Instances, candidate.instanceIndex * c_SizeOfInstanceData);
+
+        float3 localCenter = (candidate.boundsMin + candidate.boundsMax) * 0.5;
+        float3 localExtent = (candidate.boundsMax - candidate.boundsMin) * 0.5;
+        float3 center = mul(instance.transform, float4(localCenter, 1.0));
+        float3 extent = mul(abs((float3x3)instance.transform), localExtent);
+
+        if (!IsBoxInFrustum(center, extent))
+            return;
+
+        if ((g_Culling.flags & GPU_CULLING_FLAG_HIZ) != 0 && IsBoxOccluded(center, extent))
+            return;
+    }
+
+    // Append the draw to its bucket, the unused slots at the end of the bucket stay cleared to empty draws
+    uint slot;
+    InterlockedAdd(u_DrawCounts[candidate.bucketIndex], 1, slot);
+    uint draw = candidate.firstDraw + slot;
+
+    u_DrawArguments.Store4(draw * GPU_CULLING_DRAW_ARGUMENTS_SIZE, uint4(candidate.indexCount, 1, candidate.startIndexLocation, 0));
+    u_DrawArguments.Store(draw * GPU_CULLING_DRAW_ARGUMENTS_SIZE + 16, draw);
+    u_DrawRecords.Store2(draw * GPU_CULLING_DRAW_RECORD_SIZE, uint2(candidate.instanceIndex, candidate.vertexOffset));
+}
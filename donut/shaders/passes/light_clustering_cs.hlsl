@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma pack_matrix(row_major)
+
+#include <donut/shaders/light_clustering_cb.h>
+
+cbuffer c_LightClusters : register(b0)
+{
+    LightClusterConstants g_LightClusters;
+};
+
+// View space light culling spheres, see LightClusteringPass::GetLightCullingSphere
+StructuredBuffer<float4> t_LightSpheres : register(t0);
+RWStructuredBuffer<uint> u_LightClusters : register(u0);
+
+groupshared float4 s_LightSpheres[LIGHT_CLUSTERING_GROUP_SIZE];
+
+// Far end of the last depth slice, matches c_LastSliceEndDepth in LightClusteringPass.cpp
+static const float c_LastSliceEndDepth = 1e20;
+
+float GetSliceStart(uint slice)
+{
+    if (slice == 0)
+        return 0;
+
+    return exp2((float(slice) - g_LightClusters.depthSliceBias) / g_LightClusters.depthSliceScale);
+}
+
+float GetSliceEnd(uint slice)
+{
+    if (slice >= LIGHT_CLUSTER_GRID_Z - 1)
+        return c_LastSliceEndDepth;
+
+    return exp2((float(slice + 1) - g_LightClusters.depthSliceBias) / g_LightClusters.depthSliceScale);
+}
+
+float3 GetViewPointAtDepth(float2 clipPosition, float viewDepth)
+{
+    float4 a = mul(float4(clipPosition, 0.25, 1), g_LightClusters.matClipToView);
+    float4 b = mul(float4(clipPosition, 0.75, 1), g_LightClusters.matClipToView);
+    a.xyz /= a.w;
+    b.xyz /= b.w;
+
+    return lerp(a.xyz, b.xyz, (viewDepth - a.z) / (b.z - a.z));
+}
+
+bool SphereIntersectsBox(float4 sphere, float3 boundsMin, float3 boundsMax)
+{
+    if (sphere.w < 0)
+        return true;
+
+    float3 distance = max(max(boundsMin - sphere.xyz, sphere.xyz - boundsMax), 0);
+    return dot(distance, distance) <= sphere.w * sphere.w;
+}
+
+[numthreads(LIGHT_CLUSTERING_GROUP_SIZE, 1, 1)]
+void main(uint i_globalIdx : SV_DispatchThreadID, uint i_threadIdx : SV_GroupThreadID)
+{
+    uint3 cluster = uint3(
+        i_globalIdx % LIGHT_CLUSTER_GRID_X,
+        (i_globalIdx / LIGHT_CLUSTER_GRID_X) % LIGHT_CLUSTER_GRID_Y,
+        i_globalIdx / (LIGHT_CLUSTER_GRID_X * LIGHT_CLUSTER_GRID_Y));
+
+    float2 clipMin = float2(float(cluster.x) / LIGHT_CLUSTER_GRID_X * 2 - 1, 1 - float(cluster.y + 1) / LIGHT_CLUSTER_GRID_Y * 2);
+    float2 clipMax = float2(float(cluster.x + 1) / LIGHT_CLUSTER_GRID_X * 2 - 1, 1 - float(cluster.y) / LIGHT_CLUSTER_GRID_Y * 2);
+    float depths[2] = { GetSliceStart(cluster.z), GetSliceEnd(cluster.z) };
+
+    float3 boundsMin = 1e38;
+    float3 boundsMax = -1e38;
+
+    [unroll]
+    for (uint depth = 0; depth < 2; depth++)
+    {
+        float3 corners[4] = {
+            GetViewPointAtDepth(float2(clipMin.x, clipMin.y), depths[depth]),
+            GetViewPointAtDepth(float2(clipMax.x, clipMin.y), depths[depth]),
+            GetViewPointAtDepth(float2(clipMin.x, clipMax.y), depths[depth]),
+            GetViewPointAtDepth(float2(clipMax.x, clipMax.y), depths[depth])
+        };
+
+        [unroll]
+        for (uint corner = 0; corner < 4; corner++)
+        {
+            boundsMin = min(boundsMin, corners[corner]);
+            boundsMax = max(boundsMax, corners[corner]);
+        }
+    }
+
+    uint clusterOffset = i_globalIdx * LIGHT_CLUSTER_STRIDE;
+    uint numLights = 0;
+
+    // Every thread group walks through the lights in batches, one light per thread loaded into shared memory
+    for (uint firstLight = 0; firstLight < g_LightClusters.numLights; firstLight += LIGHT_CLUSTERING_GROUP_SIZE)
+    {
+        uint lightIndex = firstLight + i_threadIdx;
+        if (lightIndex < g_LightClusters.numLights)
+            s_LightSpheres[i_threadIdx] = t_LightSpheres[lightIndex];
+
+        GroupMemoryBarrierWithGroupSync();
+
+        uint batchSize = min(LIGHT_CLUSTERING_GROUP_SIZE, g_LightClusters.numLights - firstLight);
+
+        [loop]
+        for (uint batchIndex = 0; batchIndex < batchSize; batchIndex++)
+        {
+            if (numLights < LIGHT_CLUSTER_MAX_LIGHTS && SphereIntersectsBox(s_LightSpheres[batchIndex], boundsMin, boundsMax))
+            {
+                u_LightClusters[clusterOffset + 1 + numLights] = firstLight + batchIndex;
+                ++numLights;
+            }
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    u_LightClusters[clusterOffset] = numLights;
+}
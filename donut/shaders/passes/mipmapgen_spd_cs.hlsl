@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/shaders/mipmapgen_cb.h>
+
+// Single-pass variant of mipmapgen_cs.hlsl : every group reduces a tile of the first
+// 6 output levels, and the last group to finish, found with a global atomic counter,
+// reduces the remaining levels from the 6th one. The loads are clamped to the extent
+// of every level, which is what MipMapGenPass::ReduceReference implements on the CPU.
+
+#if MODE == MODE_COLOR
+    #define VALUE_TYPE float4
+    VALUE_TYPE reduce(VALUE_TYPE a, VALUE_TYPE b)
+    {
+        return lerp(a, b, 0.5);
+    }
+#elif MODE == MODE_MINMAX
+    #define VALUE_TYPE float2
+    VALUE_TYPE reduce(VALUE_TYPE a, VALUE_TYPE b)
+    {
+        return float2(min(a.x, b.x), max(a.y, b.y));
+    }
+#else
+    #define VALUE_TYPE float
+    VALUE_TYPE reduce(VALUE_TYPE a, VALUE_TYPE b)
+    {
+    #if MODE == MODE_MIN
+        return min(a, b);
+    #elif MODE == MODE_MAX
+        return max(a, b);
+    #endif
+    }
+#endif
+
+VALUE_TYPE reduce(VALUE_TYPE a, VALUE_TYPE b, VALUE_TYPE c, VALUE_TYPE d)
+{
+    return reduce(reduce(a, b), reduce(c, d));
+}
+
+cbuffer c_MipMapgen : register(b0)
+{
+    MipMapGenSinglePassConstants g_MipMapGen;
+};
+
+Texture2D<VALUE_TYPE> t_input : register(t0);
+
+// The output levels are read back by the last group, so the writes of the other groups
+// must bypass the incoherent caches. See mipmapgen_cs.hlsl about the unsized array on Vulkan.
+#ifdef TARGET_VULKAN
+globallycoherent RWTexture2D<VALUE_TYPE> u_output[] : register(u0);
+#else
+globallycoherent RWTexture2D<VALUE_TYPE> u_output[SPD_MAX_LODS] : register(u0);
+#endif
+globallycoherent RWByteAddressBuffer u_counter : register(u12); // SPD_MAX_LODS
+
+groupshared VALUE_TYPE s_ReductionData[SPD_TILE_SIZE][SPD_TILE_SIZE];
+groupshared uint s_IsLastGroup;
+
+// Size of an output level, 1 being the first one
+uint2 GetLevelSize(uint level)
+{
+    return max(g_MipMapGen.firstLevelSize >> (level - 1), 1);
+}
+
+VALUE_TYPE LoadInput(uint2 pos, uint baseLevel)
+{
+    if (baseLevel == 0)
+    {
+        VALUE_TYPE value = t_input[min(pos, g_MipMapGen.sourceSize - 1)];
+#if MODE == MODE_MINMAX
+        value.y = value.x;
+#endif
+        return value;
+    }
+
+    return u_output[baseLevel - 1][min(pos, GetLevelSize(baseLevel) - 1)];
+}
+
+// Clamps a texel position relative to the tile of the group to the extent of the level.
+// Tiles that are entirely outside of the level keep their own texels, which are never stored.
+uint2 ClampToLevel(uint2 local, uint2 tileOrigin, uint2 levelSize)
+{
+    return min(local, max(levelSize - 1, tileOrigin) - tileOrigin);
+}
+
+// Reduces the levels (baseLevel + 1) to (baseLevel + 6) of one tile, starting with
+// SPD_TILE_SIZE^2 texels of the first level that are loaded from the base level.
+void DownsampleTile(uint2 tile, uint threadIndex, uint baseLevel)
+{
+    const uint firstLevel = baseLevel + 1;
+    const uint2 firstLevelSize = GetLevelSize(firstLevel);
+
+    [unroll]
+    for (uint i = 0; i < (SPD_TILE_SIZE * SPD_TILE_SIZE) / SPD_GROUP_SIZE; i++)
+    {
+        uint index = threadIndex + i * SPD_GROUP_SIZE;
+        uint2 local = uint2(index % SPD_TILE_SIZE, index / SPD_TILE_SIZE);
+        uint2 pos = tile * SPD_TILE_SIZE + local;
+
+        VALUE_TYPE value = reduce(
+            LoadInput(pos * 2 + uint2(0, 0), baseLevel),
+            LoadInput(pos * 2 + uint2(1, 0), baseLevel),
+            LoadInput(pos * 2 + uint2(0, 1), baseLevel),
+            LoadInput(pos * 2 + uint2(1, 1), baseLevel));
+
+        if (all(pos < firstLevelSize))
+            u_output[firstLevel - 1][pos] = value;
+
+        s_ReductionData[local.y][local.x] = value;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint level = firstLevel + 1; level <= baseLevel + 6; level++)
+    {
+        if (level > g_MipMapGen.numLODs)
+            break;
+
+        uint outTileSize = uint(SPD_TILE_SIZE) >> (level - firstLevel);
+        uint2 inOrigin = tile * (outTileSize * 2);
+        uint2 inSize = GetLevelSize(level - 1);
+
+        uint2 local = uint2(threadIndex % outTileSize, threadIndex / outTileSize);
+        bool active = threadIndex < outTileSize * outTileSize;
+
+        VALUE_TYPE value = (VALUE_TYPE)0;
+        if (active)
+        {
+            uint2 p0 = ClampToLevel(local * 2 + uint2(0, 0), inOrigin, inSize);
+            uint2 p1 = ClampToLevel(local * 2 + uint2(1, 1), inOrigin, inSize);
+
+            value = reduce(
+                s_ReductionData[p0.y][p0.x],
+                s_ReductionData[p0.y][p1.x],
+                s_ReductionData[p1.y][p0.x],
+                s_ReductionData[p1.y][p1.x]);
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (active)
+        {
+            s_ReductionData[local.y][local.x] = value;
+
+            uint2 pos = tile * outTileSize + local;
+            if (all(pos < GetLevelSize(level)))
+                u_output[level - 1][pos] = value;
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+[numthreads(SPD_GROUP_SIZE, 1, 1)]
+void main(
+    uint2 groupIdx : SV_GroupID,
+    uint threadIndex : SV_GroupIndex)
+{
+    DownsampleTile(groupIdx, threadIndex, 0);
+
+    if (g_MipMapGen.numLODs <= 6)
+        return;
+
+    // Make the 6th level of this tile visible to the other groups before counting it as done
+    DeviceMemoryBarrierWithGroupSync();
+
+    if (threadIndex == 0)
+    {
+        uint finishedGroups;
+        u_counter.InterlockedAdd(0, 1, finishedGroups);
+        s_IsLastGroup = (finishedGroups == g_MipMapGen.numWorkGroups - 1) ? 1 : 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (s_IsLastGroup == 0)
+        return;
+
+    // Reset the counter for the next dispatch
+    if (threadIndex == 0)
+        u_counter.Store(0, 0);
+
+    DownsampleTile(uint2(0, 0), threadIndex, 6);
+}
@@ -40,7 +40,8 @@ void main(in uint i_globalIdx : SV_DispatchThreadID)
 	if (i_globalIdx >= g_Const.numVertices)
 		return;
 
-	float3 position = asfloat(t_VertexBuffer.Load3(i_globalIdx * c_SizeOfPosition + g_Const.inputPositionOffset));
+	float3 position = LoadVertexPosition(t_VertexBuffer, g_Const.inputPositionOffset, i_globalIdx, g_Const.inputFormatFlags,
+		g_Const.inputPositionScale, g_Const.inputPositionBias);
 	float4 normal = 0;
 	float4 tangent = 0;
 	float2 texCoord1 = 0;
@@ -53,16 +54,16 @@ void main(in uint i_globalIdx : SV_DispatchThreadID)
 		tangent = Unpack_RGBA8_SNORM(t_VertexBuffer.Load(i_globalIdx * c_SizeOfNormal + g_Const.inputTangentOffset));
 
 	if (g_Const.flags & SkinningFlag_TexCoord1)
-		texCoord1 = asfloat(t_VertexBuffer.Load2(i_globalIdx * c_SizeOfTexcoord + g_Const.inputTexCoord1Offset));
+		texCoord1 = LoadVertexTexCoord(t_VertexBuffer, g_Const.inputTexCoord1Offset, i_globalIdx, g_Const.inputFormatFlags);
 
 	if (g_Const.flags & SkinningFlag_TexCoord2)
-		texCoord2 = asfloat(t_VertexBuffer.Load2(i_globalIdx * c_SizeOfTexcoord + g_Const.inputTexCoord2Offset));
+		texCoord2 = LoadVertexTexCoord(t_VertexBuffer, g_Const.inputTexCoord2Offset, i_globalIdx, g_Const.inputFormatFlags);
 
 	uint2 jointIndicesPacked = t_VertexBuffer.Load2(i_globalIdx * c_SizeOfJointIndices + g_Const.inputJointIndexOffset);
 	uint4 jointIndices = uint4(
 		jointIndicesPacked.x & 0xffff, jointIndicesPacked.x >> 16,
 		jointIndicesPacked.y & 0xffff, jointIndicesPacked.y >> 16);
-	float4 jointWeights = asfloat(t_VertexBuffer.Load4(i_globalIdx * c_SizeOfJointWeights + g_Const.inputJointWeightOffset));
+	float4 jointWeights = LoadVertexJointWeights(t_VertexBuffer, g_Const.inputJointWeightOffset, i_globalIdx, g_Const.inputFormatFlags);
 
 	float4x4 jointMatrix = 0;
 	[unroll]
@@ -70,12 +71,12 @@ void main(in uint i_globalIdx : SV_DispatchThreadID)
 	{
 		if (jointWeights[i] > 0)
 		{
-			uint index = jointIndices[i];
+			uint offset = jointIndices[i] * 64 + g_Const.jointOffset;
 			float4x4 currentMatrix;
-			currentMatrix[0] = asfloat(t_JointMatrices.Load4(index * 64 + 0));
-			currentMatrix[1] = asfloat(t_JointMatrices.Load4(index * 64 + 16));
-			currentMatrix[2] = asfloat(t_JointMatrices.Load4(index * 64 + 32));
-			currentMatrix[3] = asfloat(t_JointMatrices.Load4(index * 64 + 48));
+			currentMatrix[0] = asfloat(t_JointMatrices.Load4(offset + 0));
+			currentMatrix[1] = asfloat(t_JointMatrices.Load4(offset + 16));
+			currentMatrix[2] = asfloat(t_JointMatrices.Load4(offset + 32));
+			currentMatrix[3] = asfloat(t_JointMatrices.Load4(offset + 48));
 			jointMatrix += currentMatrix * jointWeights[i];
 		}
 	}
@@ -50,6 +50,7 @@ freely, subject to the following restrictions:
 #include <donut/app/DeviceManager.h>
 #include <donut/core/math/math.h>
 #include <donut/core/log.h>
+#include <donut/core/profiler.h>
 #include <nvrhi/utils.h>
 
 #include <cstdio>
@@ -219,11 +220,12 @@ bool DeviceManager::CreateInstance(const InstanceParameters& params)
 
     static_cast<InstanceParameters&>(m_DeviceParams) = params;
 
-    if (!params.headlessDevice)
-    {
-        if (!glfwInit())
-            return false;
-    }
+    // Headless devices use GLFW only for its timer and joysticks, which work on the null platform without a display
+    if (params.headlessDevice)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+
+    if (!glfwInit())
+        return false;
 
 #if DONUT_WITH_AFTERMATH
     if (params.enableAftermath)
@@ -244,7 +246,60 @@ bool DeviceManager::CreateHeadlessDevice(const DeviceCreationParameters& params)
     if (!CreateInstance(m_DeviceParams))
         return false;
 
-    return CreateDevice();
+    if (!CreateDevice())
+        return false;
+
+    CreateHeadlessBackBuffer();
+    m_windowVisible = true;
+    return true;
+}
+
+void DeviceManager::CreateHeadlessBackBuffer()
+{
+    nvrhi::TextureDesc textureDesc;
+    textureDesc.width = m_DeviceParams.backBufferWidth;
+    textureDesc.height = m_DeviceParams.backBufferHeight;
+    textureDesc.format = m_DeviceParams.swapChainFormat;
+    textureDesc.sampleCount = m_DeviceParams.swapChainSampleCount;
+    textureDesc.sampleQuality = m_DeviceParams.swapChainSampleQuality;
+    textureDesc.isRenderTarget = true;
+    textureDesc.initialState = nvrhi::ResourceStates::Present;
+    textureDesc.keepInitialState = true;
+    textureDesc.debugName = "HeadlessBackBuffer";
+    m_HeadlessBackBuffer = GetDevice()->createTexture(textureDesc);
+
+    m_HeadlessFramebuffer = GetDevice()->createFramebuffer(
+        nvrhi::FramebufferDesc().addColorAttachment(m_HeadlessBackBuffer));
+}
+
+bool DeviceManager::PresentHeadless()
+{
+    // Nothing is presented: keep the CPU at most maxFramesInFlight frames ahead of the GPU, like a swap chain would
+    while (m_HeadlessFramesInFlight.size() >= m_DeviceParams.maxFramesInFlight)
+    {
+        auto query = m_HeadlessFramesInFlight.front();
+        m_HeadlessFramesInFlight.pop();
+
+        GetDevice()->waitEventQuery(query);
+
+        m_HeadlessQueryPool.push_back(query);
+    }
+
+    nvrhi::EventQueryHandle query;
+    if (!m_HeadlessQueryPool.empty())
+    {
+        query = m_HeadlessQueryPool.back();
+        m_HeadlessQueryPool.pop_back();
+    }
+    else
+    {
+        query = GetDevice()->createEventQuery();
+    }
+
+    GetDevice()->resetEventQuery(query);
+    GetDevice()->setEventQuery(query, nvrhi::CommandQueue::Graphics);
+    m_HeadlessFramesInFlight.push(query);
+    return true;
 }
 
 bool DeviceManager::CreateWindowDeviceAndSwapChain(const DeviceCreationParameters& params, const char *windowTitle)
@@ -426,16 +481,46 @@ void DeviceManager::BackBufferResized()
 
 void DeviceManager::Animate(double elapsedTime)
 {
+    DONUT_PROFILE_SCOPE("DeviceManager::Animate");
+
     for(auto it : m_vRenderPasses)
     {
         it->Animate(float(elapsedTime));
+    }
+}
+
+void DeviceManager::AnimatePasses(double elapsedTime, bool simulationThread)
+{
+    DONUT_PROFILE_SCOPE("DeviceManager::Animate");
+
+    for(auto it : m_vRenderPasses)
+    {
+        if (it->AnimateOnSimulationThread() == simulationThread)
+            it->Animate(float(elapsedTime));
+    }
+}
+
+void DeviceManager::CommitSimulation(uint32_t frameIndex)
+{
+    DONUT_PROFILE_SCOPE("DeviceManager::CommitSimulation");
+
+    for(auto it : m_vRenderPasses)
+    {
+        it->CommitSimulation(frameIndex);
+    }
+
+    // Latewarp camera data is derived from the committed simulation state
+    for(auto it : m_vRenderPasses)
+    {
         it->SetLatewarpOptions();
     }
 }
 
 void DeviceManager::Render()
 {    
-    nvrhi::IFramebuffer* framebuffer = m_SwapChainFramebuffers[GetCurrentBackBufferIndex()];
+    DONUT_PROFILE_SCOPE("DeviceManager::Render");
+
+    nvrhi::IFramebuffer* framebuffer = GetCurrentFramebuffer();
 
     for (auto it : m_vRenderPasses)
     {
@@ -472,14 +557,25 @@ void DeviceManager::RunMessageLoop()
 {
     m_PreviousFrameTimestamp = glfwGetTime();
 
+    DONUT_PROFILE_THREAD_NAME("Main");
+
 #if DONUT_WITH_AFTERMATH
     bool dumpingCrash = false;
 #endif
-    while(!glfwWindowShouldClose(m_Window))
+    m_ExitRequested = false;
+    while(m_Window ? !glfwWindowShouldClose(m_Window) : !m_ExitRequested)
     {
+        // Input and window events may modify the simulation state, so they are processed
+        // only after the pipelined simulation of the previous frame has completed.
+        WaitForSimulation();
+
         if (m_callbacks.beforeFrame) m_callbacks.beforeFrame(*this, m_FrameIndex);
-        glfwPollEvents();
-        UpdateWindowSize();
+        if (m_Window)
+        {
+            DONUT_PROFILE_SCOPE("PollEvents");
+            glfwPollEvents();
+            UpdateWindowSize();
+        }
         bool presentSuccess = AnimateRenderPresent();
         if (!presentSuccess)
         {
@@ -490,6 +586,8 @@ void DeviceManager::RunMessageLoop()
         }
     }
 
+    StopSimulationThread();
+
     bool waitSuccess = GetDevice()->waitForIdle();
 #if DONUT_WITH_AFTERMATH
     dumpingCrash |= !waitSuccess;
@@ -499,52 +597,75 @@ void DeviceManager::RunMessageLoop()
 #endif
 }
 
+void DeviceManager::RequestExit()
+{
+    m_ExitRequested = true;
+
+    if (m_Window)
+        glfwSetWindowShouldClose(m_Window, GLFW_TRUE);
+}
+
 bool DeviceManager::AnimateRenderPresent()
 {
+    DONUT_PROFILE_SCOPE("Frame");
+
     double curTime = glfwGetTime();
     double elapsedTime = curTime - m_PreviousFrameTimestamp;
 
+    WaitForSimulation();
+
 	JoyStickManager::Singleton().EraseDisconnectedJoysticks();
 	JoyStickManager::Singleton().UpdateAllJoysticks(m_vRenderPasses);
 
-    if (m_windowVisible && (m_windowIsInFocus || ShouldRenderUnfocused()))
+    if (m_PipelinedSimulation != m_RequestedPipelinedSimulation)
     {
-        if (m_callbacks.beforeAnimate) m_callbacks.beforeAnimate(*this, m_FrameIndex);
-        Animate(elapsedTime);
-        if (m_callbacks.afterAnimate) m_callbacks.afterAnimate(*this, m_FrameIndex);
+        // A frame that has been simulated but not rendered yet is dropped when switching modes
+        m_PipelinedSimulation = m_RequestedPipelinedSimulation;
+        m_PendingRenderFrame.reset();
+    }
 
-        // normal rendering           : A0    R0 P0 A1 R1 P1
-        // m_SkipRenderOnFirstFrame on: A0 A1 R0 P0 A2 R1 P1
-        // m_SkipRenderOnFirstFrame simulates multi-threaded rendering frame indices, m_FrameIndex becomes the simulation index
-        // while the local variable below becomes the render/present index, which will be different only if m_SkipRenderOnFirstFrame is set
-        if (m_FrameIndex > 0 || !m_SkipRenderOnFirstFrame)
+    if (m_windowVisible && (m_windowIsInFocus || ShouldRenderUnfocused()))
+    {
+        if (m_PipelinedSimulation)
+        {
+            if (!PipelinedAnimateRenderPresent(elapsedTime))
+                return false;
+        }
+        else
         {
-            if (BeginFrame())
+            if (m_callbacks.beforeAnimate) m_callbacks.beforeAnimate(*this, m_FrameIndex);
+            double animateStart = glfwGetTime();
+            Animate(elapsedTime);
+            double animateTime = glfwGetTime() - animateStart;
+            if (m_callbacks.afterAnimate) m_callbacks.afterAnimate(*this, m_FrameIndex);
+
+            CommitSimulation(m_FrameIndex);
+
+            // normal rendering           : A0    R0 P0 A1 R1 P1
+            // m_SkipRenderOnFirstFrame on: A0 A1 R0 P0 A2 R1 P1
+            // m_SkipRenderOnFirstFrame simulates multi-threaded rendering frame indices, m_FrameIndex becomes the simulation index
+            // while the local variable below becomes the render/present index, which will be different only if m_SkipRenderOnFirstFrame is set
+            if (m_FrameIndex > 0 || !m_SkipRenderOnFirstFrame)
             {
-                // first time entering this loop, m_FrameIndex is 1 for m_SkipRenderOnFirstFrame, 0 otherwise;
+                // first time entering this branch, m_FrameIndex is 1 for m_SkipRenderOnFirstFrame, 0 otherwise;
                 uint32_t frameIndex = m_FrameIndex;
                 if (m_SkipRenderOnFirstFrame)
                 {
                     frameIndex--;
                 }
 
-                if (m_callbacks.beforeRender) m_callbacks.beforeRender(*this, frameIndex);
-                Render();
-                if (m_callbacks.afterRender) m_callbacks.afterRender(*this, frameIndex);
-                if (m_callbacks.beforePresent) m_callbacks.beforePresent(*this, frameIndex);
-                bool presentSuccess = Present();
-                if (m_callbacks.afterPresent) m_callbacks.afterPresent(*this, frameIndex);
-                if (!presentSuccess)
-                {
+                if (!RenderPresent(frameIndex, elapsedTime, animateTime))
                     return false;
-                }
             }
         }
     }
 
     std::this_thread::sleep_for(std::chrono::milliseconds(0));
 
-    GetDevice()->runGarbageCollection();
+    {
+        DONUT_PROFILE_SCOPE("RunGarbageCollection");
+        GetDevice()->runGarbageCollection();
+    }
 
     UpdateAverageFrameTime(elapsedTime);
     m_PreviousFrameTimestamp = curTime;
@@ -553,6 +674,147 @@ bool DeviceManager::AnimateRenderPresent()
     return true;
 }
 
+// pipelined simulation: S0 | S1 R0 P0 | S2 R1 P1 | ...
+// Sn runs on the simulation thread and overlaps with the rendering and presentation of the previous frame,
+// so m_FrameIndex is the simulation index, like with m_SkipRenderOnFirstFrame, and the render index trails it by one.
+bool DeviceManager::PipelinedAnimateRenderPresent(double elapsedTime)
+{
+    std::optional<uint32_t> renderFrame = m_PendingRenderFrame;
+    double animateTime = 0.0;
+
+    if (renderFrame.has_value())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SimulationMutex);
+            animateTime = m_SimulationTime;
+        }
+
+        AnimatePasses(elapsedTime, false);
+        CommitSimulation(*renderFrame);
+    }
+
+    KickSimulation(m_FrameIndex, elapsedTime);
+    m_PendingRenderFrame = m_FrameIndex;
+
+    if (renderFrame.has_value())
+        return RenderPresent(*renderFrame, elapsedTime, animateTime);
+
+    return true;
+}
+
+bool DeviceManager::RenderPresent(uint32_t frameIndex, double elapsedTime, double animateTime)
+{
+    bool frameBegun = true;
+    if (!m_DeviceParams.headlessDevice)
+    {
+        DONUT_PROFILE_SCOPE("BeginFrame");
+        frameBegun = BeginFrame();
+    }
+
+    if (!frameBegun)
+        return true;
+
+    if (m_callbacks.beforeRender) m_callbacks.beforeRender(*this, frameIndex);
+    double renderStart = glfwGetTime();
+    Render();
+    double renderTime = glfwGetTime() - renderStart;
+    if (m_callbacks.afterRender) m_callbacks.afterRender(*this, frameIndex);
+    if (m_callbacks.beforePresent) m_callbacks.beforePresent(*this, frameIndex);
+    bool presentSuccess;
+    double presentStart = glfwGetTime();
+    {
+        DONUT_PROFILE_SCOPE("Present");
+        presentSuccess = m_DeviceParams.headlessDevice ? PresentHeadless() : Present();
+    }
+    double presentTime = glfwGetTime() - presentStart;
+    if (m_callbacks.afterPresent) m_callbacks.afterPresent(*this, frameIndex);
+    if (!presentSuccess)
+    {
+        return false;
+    }
+
+    m_FrameStatistics.RecordValue(m_FrameTimeChannel, elapsedTime * 1e3);
+    m_FrameStatistics.RecordValue(m_AnimateChannel, animateTime * 1e3);
+    m_FrameStatistics.RecordValue(m_RenderChannel, renderTime * 1e3);
+    m_FrameStatistics.RecordValue(m_PresentChannel, presentTime * 1e3);
+
+    return true;
+}
+
+void DeviceManager::SimulationThreadProc()
+{
+    DONUT_PROFILE_THREAD_NAME("Simulation");
+
+    std::unique_lock<std::mutex> lock(m_SimulationMutex);
+
+    while (true)
+    {
+        m_SimulationCondition.wait(lock, [this]() { return m_SimulationRequested || m_SimulationQuit; });
+
+        if (m_SimulationQuit)
+            break;
+
+        uint32_t frameIndex = m_SimulationFrameIndex;
+        double elapsedTime = m_SimulationElapsedTime;
+        lock.unlock();
+
+        if (m_callbacks.beforeAnimate) m_callbacks.beforeAnimate(*this, frameIndex);
+        double animateStart = glfwGetTime();
+        AnimatePasses(elapsedTime, true);
+        double animateTime = glfwGetTime() - animateStart;
+        if (m_callbacks.afterAnimate) m_callbacks.afterAnimate(*this, frameIndex);
+
+        lock.lock();
+        m_SimulationTime = animateTime;
+        m_SimulationRequested = false;
+        m_SimulationCondition.notify_all();
+    }
+}
+
+void DeviceManager::KickSimulation(uint32_t frameIndex, double elapsedTime)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_SimulationMutex);
+        assert(!m_SimulationRequested);
+        m_SimulationFrameIndex = frameIndex;
+        m_SimulationElapsedTime = elapsedTime;
+        m_SimulationRequested = true;
+        m_SimulationQuit = false;
+    }
+
+    if (!m_SimulationThread.joinable())
+        m_SimulationThread = std::thread(&DeviceManager::SimulationThreadProc, this);
+
+    m_SimulationCondition.notify_all();
+}
+
+void DeviceManager::WaitForSimulation()
+{
+    if (!m_SimulationThread.joinable())
+        return;
+
+    DONUT_PROFILE_SCOPE("WaitForSimulation");
+
+    std::unique_lock<std::mutex> lock(m_SimulationMutex);
+    m_SimulationCondition.wait(lock, [this]() { return !m_SimulationRequested; });
+}
+
+void DeviceManager::StopSimulationThread()
+{
+    if (!m_SimulationThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_SimulationMutex);
+        m_SimulationQuit = true;
+    }
+    m_SimulationCondition.notify_all();
+    m_SimulationThread.join();
+
+    m_SimulationRequested = false;
+    m_PendingRenderFrame.reset();
+}
+
 void DeviceManager::GetWindowDimensions(int& width, int& height)
 {
     width = m_DeviceParams.backBufferWidth;
@@ -569,6 +831,10 @@ donut::app::DeviceManager::DeviceManager()
     : m_AftermathCrashDumper(*this)
 #endif
 {
+    m_FrameTimeChannel = m_FrameStatistics.GetOrCreateChannel("FrameTime");
+    m_AnimateChannel = m_FrameStatistics.GetOrCreateChannel("Simulation");
+    m_RenderChannel = m_FrameStatistics.GetOrCreateChannel("RenderSubmit");
+    m_PresentChannel = m_FrameStatistics.GetOrCreateChannel("Present");
 }
 
 void DeviceManager::UpdateWindowSize()
@@ -627,6 +893,8 @@ void DeviceManager::WindowPosCallback(int x, int y)
     {
         if (m_callbacks.beforeFrame) m_callbacks.beforeFrame(*this, m_FrameIndex);
         AnimateRenderPresent();
+        // the remaining events of this poll may modify the simulation state
+        WaitForSimulation();
     }
 }
 
@@ -783,7 +1051,13 @@ void JoyStickManager::UpdateJoystick(int j, const std::list<IRenderPass*>& passe
 
 void DeviceManager::Shutdown()
 {
+    StopSimulationThread();
+
     m_SwapChainFramebuffers.clear();
+    m_HeadlessFramebuffer = nullptr;
+    m_HeadlessBackBuffer = nullptr;
+    m_HeadlessFramesInFlight = {};
+    m_HeadlessQueryPool.clear();
 
     DestroyDeviceAndSwapChain();
 
@@ -800,11 +1074,17 @@ void DeviceManager::Shutdown()
 
 nvrhi::IFramebuffer* donut::app::DeviceManager::GetCurrentFramebuffer()
 {
+    if (m_DeviceParams.headlessDevice)
+        return m_HeadlessFramebuffer;
+
     return GetFramebuffer(GetCurrentBackBufferIndex());
 }
 
 nvrhi::IFramebuffer* donut::app::DeviceManager::GetFramebuffer(uint32_t index)
 {
+    if (m_DeviceParams.headlessDevice)
+        return m_HeadlessFramebuffer;
+
     if (index < m_SwapChainFramebuffers.size())
         return m_SwapChainFramebuffers[index];
 
@@ -45,6 +45,7 @@ SOFTWARE.
 */
 
 #include <stddef.h>
+#include <algorithm>
 
 #include <imgui.h>
 
@@ -205,12 +206,15 @@ bool ImGui_NVRHI::init(nvrhi::DeviceHandle renderer, std::shared_ptr<ShaderFacto
     return true;
 }
 
-bool ImGui_NVRHI::reallocateBuffer(nvrhi::BufferHandle& buffer, size_t requiredSize, size_t reallocateSize, const bool indexBuffer)
+bool ImGui_NVRHI::reallocateBuffer(nvrhi::BufferHandle& buffer, size_t& slotCapacity, size_t requiredCount, size_t elementSize, const bool indexBuffer)
 {
-    if (buffer == nullptr || size_t(buffer->getDesc().byteSize) < requiredSize)
+    if (buffer == nullptr || slotCapacity < requiredCount)
     {
+        // Grow geometrically so that a UI that keeps growing doesn't recreate the buffers every frame
+        size_t newCapacity = std::max(std::max(requiredCount, slotCapacity * 2), size_t(5000));
+
         nvrhi::BufferDesc desc;
-        desc.byteSize = uint32_t(reallocateSize);
+        desc.byteSize = uint64_t(newCapacity * elementSize * c_NumFrameSlots);
         desc.structStride = 0;
         desc.debugName = indexBuffer ? "ImGui index buffer" : "ImGui vertex buffer";
         desc.canHaveUAVs = false;
@@ -218,15 +222,17 @@ bool ImGui_NVRHI::reallocateBuffer(nvrhi::BufferHandle& buffer, size_t requiredS
         desc.isIndexBuffer = indexBuffer;
         desc.isDrawIndirectArgs = false;
         desc.isVolatile = false;
-        desc.initialState = indexBuffer ? nvrhi::ResourceStates::IndexBuffer : nvrhi::ResourceStates::VertexBuffer;
-        desc.keepInitialState = true;
+        desc.cpuAccess = nvrhi::CpuAccessMode::Write;
 
         buffer = renderer->createBuffer(desc);
 
         if (!buffer)
         {
+            slotCapacity = 0;
             return false;
         }
+
+        slotCapacity = newCapacity;
     }
 
     return true;
@@ -259,7 +265,8 @@ nvrhi::IBindingSet* ImGui_NVRHI::getBindingSet(nvrhi::ITexture* texture)
     auto iter = bindingsCache.find(texture);
     if (iter != bindingsCache.end())
     {
-        return iter->second;
+        iter->second.lastUsedFrame = frameIndex;
+        return iter->second.bindingSet;
     }
 
     nvrhi::BindingSetDesc desc;
@@ -274,37 +281,69 @@ nvrhi::IBindingSet* ImGui_NVRHI::getBindingSet(nvrhi::ITexture* texture)
     binding = renderer->createBindingSet(desc, bindingLayout);
     assert(binding);
 
-    bindingsCache[texture] = binding;
+    CachedBindingSet& entry = bindingsCache[texture];
+    entry.bindingSet = binding;
+    entry.lastUsedFrame = frameIndex;
     return binding;
 }
 
-bool ImGui_NVRHI::updateGeometry(nvrhi::ICommandList* commandList)
+void ImGui_NVRHI::evictBindingSets()
+{
+    for (auto iter = bindingsCache.begin(); iter != bindingsCache.end(); )
+    {
+        if (frameIndex - iter->second.lastUsedFrame > c_BindingSetLifetime)
+            iter = bindingsCache.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+bool ImGui_NVRHI::updateGeometry(uint64_t& vertexOffset, uint64_t& indexOffset)
 {
     ImDrawData *drawData = ImGui::GetDrawData();
 
+    size_t vertexCount = size_t(drawData->TotalVtxCount);
+    size_t indexCount = size_t(drawData->TotalIdxCount);
+
     // create/resize vertex and index buffers if needed
-    if (!reallocateBuffer(vertexBuffer, 
-        drawData->TotalVtxCount * sizeof(ImDrawVert), 
-        (drawData->TotalVtxCount + 5000) * sizeof(ImDrawVert), 
-        false))
+    if (!reallocateBuffer(vertexBuffer, vertexSlotCapacity, vertexCount, sizeof(ImDrawVert), false))
     {
         return false;
     }
 
-    if (!reallocateBuffer(indexBuffer,
-        drawData->TotalIdxCount * sizeof(ImDrawIdx),
-        (drawData->TotalIdxCount + 5000) * sizeof(ImDrawIdx),
-        true))
+    if (!reallocateBuffer(indexBuffer, indexSlotCapacity, indexCount, sizeof(ImDrawIdx), true))
     {
         return false;
     }
 
-    vtxBuffer.resize(vertexBuffer->getDesc().byteSize / sizeof(ImDrawVert));
-    idxBuffer.resize(indexBuffer->getDesc().byteSize / sizeof(ImDrawIdx));
+    frameSlot = (frameSlot + 1) % c_NumFrameSlots;
+    vertexOffset = uint64_t(frameSlot * vertexSlotCapacity * sizeof(ImDrawVert));
+    indexOffset = uint64_t(frameSlot * indexSlotCapacity * sizeof(ImDrawIdx));
+
+    if (vertexCount == 0 || indexCount == 0)
+    {
+        return true;
+    }
+
+    // The region was last used c_NumFrameSlots frames ago, so this normally doesn't wait
+    if (frameSlotQueries[frameSlot])
+        renderer->waitEventQuery(frameSlotQueries[frameSlot]);
+
+    uint8_t* vtxMapped = static_cast<uint8_t*>(renderer->mapBuffer(vertexBuffer, nvrhi::CpuAccessMode::Write));
+    uint8_t* idxMapped = static_cast<uint8_t*>(renderer->mapBuffer(indexBuffer, nvrhi::CpuAccessMode::Write));
+
+    if (!vtxMapped || !idxMapped)
+    {
+        if (vtxMapped)
+            renderer->unmapBuffer(vertexBuffer);
+        if (idxMapped)
+            renderer->unmapBuffer(indexBuffer);
+        return false;
+    }
 
-    // copy and convert all vertices into a single contiguous buffer
-    ImDrawVert *vtxDst = &vtxBuffer[0];
-    ImDrawIdx *idxDst = &idxBuffer[0];
+    // copy all vertices and indices that are drawn into the region, contiguously
+    ImDrawVert *vtxDst = reinterpret_cast<ImDrawVert*>(vtxMapped + vertexOffset);
+    ImDrawIdx *idxDst = reinterpret_cast<ImDrawIdx*>(idxMapped + indexOffset);
 
     for(int n = 0; n < drawData->CmdListsCount; n++)
     {
@@ -317,8 +356,8 @@ bool ImGui_NVRHI::updateGeometry(nvrhi::ICommandList* commandList)
         idxDst += cmdList->IdxBuffer.Size;
     }
     
-    commandList->writeBuffer(vertexBuffer, &vtxBuffer[0], vertexBuffer->getDesc().byteSize);
-    commandList->writeBuffer(indexBuffer, &idxBuffer[0], indexBuffer->getDesc().byteSize);
+    renderer->unmapBuffer(vertexBuffer);
+    renderer->unmapBuffer(indexBuffer);
 
     return true;
 }
@@ -331,7 +370,11 @@ bool ImGui_NVRHI::render(nvrhi::IFramebuffer* framebuffer)
     m_commandList->open();
     m_commandList->beginMarker("ImGUI");
 
-    if (!updateGeometry(m_commandList))
+    ++frameIndex;
+
+    uint64_t vertexOffset = 0;
+    uint64_t indexOffset = 0;
+    if (!updateGeometry(vertexOffset, indexOffset))
     {
         return false;
     }
@@ -356,12 +399,12 @@ bool ImGui_NVRHI::render(nvrhi::IFramebuffer* framebuffer)
     nvrhi::VertexBufferBinding vbufBinding;
     vbufBinding.buffer = vertexBuffer;
     vbufBinding.slot = 0;
-    vbufBinding.offset = 0;
+    vbufBinding.offset = vertexOffset;
     drawState.vertexBuffers.push_back(vbufBinding);
 
     drawState.indexBuffer.buffer = indexBuffer;
     drawState.indexBuffer.format = (sizeof(ImDrawIdx) == 2 ? nvrhi::Format::R16_UINT : nvrhi::Format::R32_UINT);
-    drawState.indexBuffer.offset = 0;
+    drawState.indexBuffer.offset = uint32_t(indexOffset);
 
     // render command lists
     int vtxOffset = 0;
@@ -405,6 +448,16 @@ bool ImGui_NVRHI::render(nvrhi::IFramebuffer* framebuffer)
     m_commandList->close();
     renderer->executeCommandList(m_commandList);
 
+    // Marks when the GPU is done with the region of the geometry buffers used by this frame
+    nvrhi::EventQueryHandle& query = frameSlotQueries[frameSlot];
+    if (query)
+        renderer->resetEventQuery(query);
+    else
+        query = renderer->createEventQuery();
+    renderer->setEventQuery(query, nvrhi::CommandQueue::Graphics);
+
+    evictBindingSets();
+
     return true;
 }
 
@@ -0,0 +1,265 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/core/profiler.h>
+#include <donut/core/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+using namespace donut::profiler;
+
+namespace
+{
+    // Single-producer ring: only the owning thread writes events and advances 'head',
+    // readers copy a range and then discard whatever the writer may have overwritten meanwhile.
+    struct ThreadBuffer
+    {
+        std::vector<Event> events;
+        std::atomic<uint64_t> head = 0; // total number of events ever written
+        uint64_t readStart = 0;         // events before this index were discarded by Clear(), guarded by the registry mutex
+        uint32_t threadId = 0;
+        std::string threadName;         // guarded by the registry mutex
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+        std::atomic<bool> enabled = true;
+        std::atomic<uint32_t> eventsPerThread = 16384;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    Registry& GetRegistry()
+    {
+        // Never destroyed, so that threads which outlive static destruction can still record safely
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+
+    thread_local std::shared_ptr<ThreadBuffer> t_Buffer;
+    thread_local uint32_t t_Depth = 0;
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        if (!t_Buffer)
+        {
+            Registry& registry = GetRegistry();
+            auto buffer = std::make_shared<ThreadBuffer>();
+            buffer->events.resize(std::max(registry.eventsPerThread.load(std::memory_order_relaxed), 1u));
+
+            std::lock_guard<std::mutex> lockGuard(registry.mutex);
+            buffer->threadId = uint32_t(registry.threads.size()) + 1;
+            buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+            registry.threads.push_back(buffer);
+            t_Buffer = std::move(buffer);
+        }
+
+        return *t_Buffer;
+    }
+
+    void WriteJsonString(std::ostream& stream, const char* value)
+    {
+        stream << '"';
+        for (const char* c = value; *c; c++)
+        {
+            switch (*c)
+            {
+            case '"': stream << "\\\""; break;
+            case '\\': stream << "\\\\"; break;
+            case '\n': stream << "\\n"; break;
+            case '\t': stream << "\\t"; break;
+            default:
+                if (uint8_t(*c) < 0x20)
+                {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", uint8_t(*c));
+                    stream << buf;
+                }
+                else
+                    stream << *c;
+            }
+        }
+        stream << '"';
+    }
+}
+
+uint64_t donut::profiler::GetTimestampNs()
+{
+    auto elapsed = std::chrono::steady_clock::now() - GetRegistry().epoch;
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void donut::profiler::SetEnabled(bool enabled)
+{
+    GetRegistry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool donut::profiler::IsEnabled()
+{
+    return GetRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+void donut::profiler::SetEventsPerThread(uint32_t count)
+{
+    GetRegistry().eventsPerThread.store(count, std::memory_order_relaxed);
+}
+
+void donut::profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lockGuard(GetRegistry().mutex);
+    buffer.threadName = name;
+}
+
+void donut::profiler::RecordEvent(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    Event& event = buffer.events[head % buffer.events.size()];
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = endNs;
+    event.depth = depth;
+
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void donut::profiler::CollectEvents(std::vector<ThreadEvents>& outThreads)
+{
+    outThreads.clear();
+
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lockGuard(registry.mutex);
+
+    for (const auto& buffer : registry.threads)
+    {
+        const uint64_t capacity = buffer->events.size();
+        const uint64_t headBefore = buffer->head.load(std::memory_order_acquire);
+        const uint64_t first = std::max(buffer->readStart, headBefore > capacity ? headBefore - capacity : 0);
+
+        ThreadEvents& thread = outThreads.emplace_back();
+        thread.threadId = buffer->threadId;
+        thread.threadName = buffer->threadName;
+        thread.events.reserve(size_t(headBefore - first));
+        for (uint64_t index = first; index < headBefore; index++)
+            thread.events.push_back(buffer->events[index % capacity]);
+
+        // The owner may have wrapped around while we were copying: drop the slots it could have reused,
+        // including the one for the event that it may be writing right now
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t headAfter = buffer->head.load(std::memory_order_relaxed);
+        if (headAfter + 1 - first > capacity)
+        {
+            size_t overwritten = size_t(std::min(headAfter + 1 - capacity - first, headBefore - first));
+            thread.events.erase(thread.events.begin(), thread.events.begin() + overwritten);
+        }
+    }
+}
+
+void donut::profiler::Clear()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lockGuard(registry.mutex);
+
+    for (const auto& buffer : registry.threads)
+        buffer->readStart = buffer->head.load(std::memory_order_acquire);
+}
+
+std::string donut::profiler::GetChromeTrace()
+{
+    std::vector<ThreadEvents> threads;
+    CollectEvents(threads);
+
+    std::ostringstream stream;
+    stream.precision(3);
+    stream << std::fixed;
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}}";
+
+    for (const ThreadEvents& thread : threads)
+    {
+        stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.threadId << ",\"args\":{\"name\":";
+        WriteJsonString(stream, thread.threadName.c_str());
+        stream << "}}";
+
+        for (const Event& event : thread.events)
+        {
+            stream << ",\n{\"name\":";
+            WriteJsonString(stream, event.name);
+            stream << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadId
+                << ",\"ts\":" << double(event.startNs) * 1e-3
+                << ",\"dur\":" << double(event.endNs - event.startNs) * 1e-3
+                << ",\"args\":{\"depth\":" << event.depth << "}}";
+        }
+    }
+
+    stream << "\n]}\n";
+    return stream.str();
+}
+
+bool donut::profiler::WriteChromeTrace(const std::filesystem::path& fileName)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file.is_open())
+    {
+        log::error("Profiler: cannot open '%s' for writing", fileName.generic_string().c_str());
+        return false;
+    }
+
+    file << GetChromeTrace();
+    return file.good();
+}
+
+ScopedEvent::ScopedEvent(const char* name)
+    : m_Name(name)
+    , m_Start(0)
+{
+    if (!IsEnabled())
+    {
+        m_Name = nullptr;
+        return;
+    }
+
+    ++t_Depth;
+    m_Start = GetTimestampNs();
+}
+
+ScopedEvent::~ScopedEvent()
+{
+    if (!m_Name)
+        return;
+
+    uint64_t end = GetTimestampNs();
+    --t_Depth;
+    RecordEvent(m_Name, m_Start, end, t_Depth);
+}
@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/CameraPath.h>
+#include <donut/core/json.h>
+#include <donut/core/log.h>
+
+#include <json/writer.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+using namespace donut::math;
+using namespace donut::engine;
+
+void CameraPath::AddKeyframe(const Keyframe& keyframe)
+{
+    if (!m_Keyframes.empty() && keyframe.time <= m_Keyframes.back().time)
+        m_Keyframes.back() = keyframe;
+    else
+        m_Keyframes.push_back(keyframe);
+}
+
+CameraPath::Keyframe CameraPath::Sample(float time) const
+{
+    if (m_Keyframes.empty())
+        return Keyframe();
+
+    if (time <= m_Keyframes.front().time)
+        return m_Keyframes.front();
+
+    if (time >= m_Keyframes.back().time)
+        return m_Keyframes.back();
+
+    // First keyframe that is later than 'time'; the one before it is not later
+    auto next = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), time,
+        [](float t, const Keyframe& keyframe) { return t < keyframe.time; });
+    auto prev = next - 1;
+
+    float t = (time - prev->time) / (next->time - prev->time);
+
+    Keyframe result;
+    result.time = time;
+    result.position = lerp(prev->position, next->position, t);
+
+    // Nearly opposite directions would interpolate through zero, keep the previous one in that case
+    float3 direction = lerp(prev->direction, next->direction, t);
+    result.direction = lengthSquared(direction) > 1e-8f ? normalize(direction) : prev->direction;
+    float3 up = lerp(prev->up, next->up, t);
+    result.up = lengthSquared(up) > 1e-8f ? normalize(up) : prev->up;
+
+    return result;
+}
+
+bool CameraPath::Save(const std::filesystem::path& fileName) const
+{
+    Json::Value root(Json::objectValue);
+    Json::Value& keyframes = root["keyframes"];
+    keyframes = Json::Value(Json::arrayValue);
+
+    for (const Keyframe& keyframe : m_Keyframes)
+    {
+        Json::Value node(Json::objectValue);
+        node["time"] << keyframe.time;
+        node["position"] << keyframe.position;
+        node["direction"] << keyframe.direction;
+        node["up"] << keyframe.up;
+        keyframes.append(node);
+    }
+
+    std::ofstream file(fileName);
+    if (!file.is_open())
+    {
+        log::error("CameraPath: cannot open '%s' for writing", fileName.generic_string().c_str());
+        return false;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    builder["precision"] = 9; // round-trips floats exactly
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root, &file);
+
+    return file.good();
+}
+
+bool CameraPath::Load(vfs::IFileSystem& fs, const std::filesystem::path& fileName)
+{
+    Json::Value root;
+    if (!json::LoadFromFile(fs, fileName, root))
+        return false;
+
+    const Json::Value& keyframes = root["keyframes"];
+    if (!keyframes.isArray())
+    {
+        log::error("CameraPath: '%s' has no keyframes", fileName.generic_string().c_str());
+        return false;
+    }
+
+    m_Keyframes.clear();
+    for (const Json::Value& node : keyframes)
+    {
+        Keyframe keyframe;
+        node["time"] >> keyframe.time;
+        node["position"] >> keyframe.position;
+        node["direction"] >> keyframe.direction;
+        node["up"] >> keyframe.up;
+        AddKeyframe(keyframe);
+    }
+
+    return true;
+}
@@ -134,6 +134,31 @@ void donut::engine::DescriptorTableManager::ReleaseDescriptor(DescriptorIndex in
     m_SearchStart = std::min(m_SearchStart, index);
 }
 
+bool donut::engine::DescriptorTableManager::ReplaceDescriptor(DescriptorIndex index, nvrhi::BindingSetItem item)
+{
+    if (index < 0 || size_t(index) >= m_Descriptors.size() || !m_AllocatedDescriptors[index])
+        return false;
+
+    nvrhi::BindingSetItem& descriptor = m_Descriptors[index];
+
+    const auto indexMapEntry = m_DescriptorIndexMap.find(descriptor);
+    if (indexMapEntry != m_DescriptorIndexMap.end() && indexMapEntry->second == index)
+        m_DescriptorIndexMap.erase(indexMapEntry);
+
+    if (item.resourceHandle)
+        item.resourceHandle->AddRef();
+
+    if (descriptor.resourceHandle)
+        descriptor.resourceHandle->Release();
+
+    item.slot = index;
+    descriptor = item;
+    m_DescriptorIndexMap[item] = index;
+    m_Device->writeDescriptorTable(m_DescriptorTable, item);
+
+    return true;
+}
+
 donut::engine::DescriptorTableManager::~DescriptorTableManager()
 {
     for (auto& descriptor : m_Descriptors)
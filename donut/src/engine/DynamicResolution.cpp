@@ -0,0 +1,162 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/DynamicResolution.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+using namespace donut::math;
+using namespace donut::engine;
+
+DynamicResolutionController::DynamicResolutionController()
+{
+    Reset();
+}
+
+void DynamicResolutionController::SetBounds(int2 minSize, int2 maxSize)
+{
+    m_MaxSize = max(maxSize, int2(1));
+    m_MinSize = clamp(minSize, int2(1), m_MaxSize);
+    m_Scale = clamp(m_Scale, GetMinScale(), 1.f);
+}
+
+float DynamicResolutionController::GetMinScale() const
+{
+    // The smallest scale at which both dimensions stay within the bounds
+    return std::max(float(m_MinSize.x) / float(m_MaxSize.x), float(m_MinSize.y) / float(m_MaxSize.y));
+}
+
+void DynamicResolutionController::Reset(float scale)
+{
+    m_Scale = clamp(scale, GetMinScale(), 1.f);
+    m_FilteredMs = 0.f;
+    m_PreviousError = 0.f;
+    m_SettleCounter = 0;
+    m_HasSamples = false;
+    m_ReplayPosition = 0;
+}
+
+int2 DynamicResolutionController::GetRenderSize() const
+{
+    int2 size = int2(round(float2(m_MaxSize) * m_Scale));
+    return clamp(size, m_MinSize, m_MaxSize);
+}
+
+int2 DynamicResolutionController::Update(float gpuFrameTimeMs)
+{
+    if (m_Recording)
+        m_Recorded.push_back(gpuFrameTimeMs);
+
+    if (!m_Replay.empty())
+    {
+        gpuFrameTimeMs = m_Replay[std::min(m_ReplayPosition, m_Replay.size() - 1)];
+        ++m_ReplayPosition;
+    }
+
+    if (!(gpuFrameTimeMs > 0.f) || !(m_Params.targetFrameTimeMs > 0.f))
+        return GetRenderSize();
+
+    // Frames rendered before the last change are not representative of the current scale
+    if (m_SettleCounter > 0)
+    {
+        --m_SettleCounter;
+        return GetRenderSize();
+    }
+
+    if (m_HasSamples)
+    {
+        float smoothing = clamp(m_Params.smoothing, 0.01f, 1.f);
+        m_FilteredMs = lerp(m_FilteredMs, gpuFrameTimeMs, smoothing);
+    }
+    else
+    {
+        m_FilteredMs = gpuFrameTimeMs;
+        m_HasSamples = true;
+    }
+
+    // Positive error means headroom: the area can grow by target/measured
+    float error = std::log(m_Params.targetFrameTimeMs / m_FilteredMs);
+    if (std::abs(error) < std::log1p(m_Params.deadBand))
+        error = 0.f;
+
+    float areaStep = m_Params.proportionalGain * (error - m_PreviousError) + m_Params.integralGain * error;
+    m_PreviousError = error;
+
+    // Area goes with the square of the scale
+    float maxStep = std::log1p(m_Params.maxScaleStep);
+    float scaleStep = clamp(areaStep * 0.5f, -maxStep, maxStep);
+
+    int2 oldSize = GetRenderSize();
+    m_Scale = clamp(m_Scale * std::exp(scaleStep), GetMinScale(), 1.f);
+    int2 newSize = GetRenderSize();
+
+    if (any(newSize != oldSize))
+    {
+        // The filtered time reflects the old size; restart the average from the next valid sample
+        m_SettleCounter = m_Params.settleFrames;
+        m_HasSamples = false;
+        m_PreviousError = 0.f;
+    }
+
+    return newSize;
+}
+
+void DynamicResolutionController::SetReplay(std::vector<float> frameTimes)
+{
+    m_Replay = std::move(frameTimes);
+    m_ReplayPosition = 0;
+}
+
+bool DynamicResolutionController::SaveRecording(const std::filesystem::path& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file.is_open())
+        return false;
+
+    // Enough digits to read back the exact values, so that replays are bit-exact
+    file.precision(std::numeric_limits<float>::max_digits10);
+    for (float value : m_Recorded)
+        file << value << '\n';
+
+    return file.good();
+}
+
+bool DynamicResolutionController::LoadReplay(const std::filesystem::path& fileName)
+{
+    std::ifstream file(fileName);
+    if (!file.is_open())
+        return false;
+
+    std::vector<float> frameTimes;
+    float value;
+    while (file >> value)
+        frameTimes.push_back(value);
+
+    if (!file.eof())
+        return false;
+
+    SetReplay(std::move(frameTimes));
+    return true;
+}
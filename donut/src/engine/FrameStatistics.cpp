@@ -0,0 +1,280 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/FrameStatistics.h>
+#include <donut/core/log.h>
+
+#include <json/writer.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+
+using namespace donut::engine;
+
+LatencyHistogram::LatencyHistogram()
+    : m_Counts(BucketCount, 0)
+{
+}
+
+uint32_t LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+    // Values with the top bit below SubBucketBits map 1:1, larger ones drop 'shift' low bits
+    uint32_t shift = 0;
+    while (shift + SubBucketBits < 64 && (value >> (shift + SubBucketBits)) != 0)
+        ++shift;
+
+    return shift * SubBucketHalfCount + uint32_t(value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketLowerBound(uint32_t index)
+{
+    if (index < SubBucketCount)
+        return index;
+
+    uint32_t shift = index / SubBucketHalfCount - 1;
+    uint64_t subBucket = index - shift * SubBucketHalfCount;
+    return subBucket << shift;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(uint32_t index)
+{
+    if (index < SubBucketCount)
+        return index + 1;
+
+    uint32_t shift = index / SubBucketHalfCount - 1;
+    uint64_t subBucket = index - shift * SubBucketHalfCount;
+    if (subBucket + 1 == SubBucketCount && shift + SubBucketBits == 64)
+        return ~0ull; // the last bucket ends at 2^64
+
+    return (subBucket + 1) << shift;
+}
+
+void LatencyHistogram::RecordValue(uint64_t value)
+{
+    ++m_Counts[GetBucketIndex(value)];
+    ++m_TotalCount;
+    m_Min = std::min(m_Min, value);
+    m_Max = std::max(m_Max, value);
+}
+
+void LatencyHistogram::Reset()
+{
+    std::fill(m_Counts.begin(), m_Counts.end(), 0);
+    m_TotalCount = 0;
+    m_Min = ~0ull;
+    m_Max = 0;
+}
+
+uint64_t LatencyHistogram::GetValueAtPercentile(double percentile) const
+{
+    if (m_TotalCount == 0)
+        return 0;
+
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    // Round the rank like HdrHistogram does, so that e.g. p99.9 of 1000 samples isn't pushed
+    // to the maximum by the representation error of 99.9
+    uint64_t rank = uint64_t(percentile / 100.0 * double(m_TotalCount) + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, m_TotalCount);
+
+    uint64_t cumulative = 0;
+    for (uint32_t index = 0; index < BucketCount; index++)
+    {
+        cumulative += m_Counts[index];
+        if (cumulative >= rank)
+            return std::clamp(GetBucketUpperBound(index) - 1, m_Min, m_Max);
+    }
+
+    return m_Max;
+}
+
+FrameStatistics::ChannelId FrameStatistics::GetOrCreateChannel(const std::string& name)
+{
+    for (size_t index = 0; index < m_Channels.size(); index++)
+    {
+        if (m_Channels[index].name == name)
+            return ChannelId(index);
+    }
+
+    m_Channels.emplace_back().name = name;
+    return ChannelId(m_Channels.size() - 1);
+}
+
+void FrameStatistics::RecordValue(ChannelId channel, double milliseconds)
+{
+    Channel& ch = m_Channels[channel];
+    milliseconds = std::max(milliseconds, 0.0);
+
+    ch.histogram.RecordValue(uint64_t(std::llround(milliseconds * 1000.0)));
+
+    // Welford's running variance
+    uint64_t count = ch.histogram.GetCount();
+    double delta = milliseconds - ch.mean;
+    ch.mean += delta / double(count);
+    ch.m2 += delta * (milliseconds - ch.mean);
+
+    if (count > 1)
+        ch.sumAbsDelta += std::abs(milliseconds - ch.lastValue);
+    ch.lastValue = milliseconds;
+}
+
+void FrameStatistics::Reset()
+{
+    for (Channel& ch : m_Channels)
+    {
+        ch.histogram.Reset();
+        ch.mean = 0.0;
+        ch.m2 = 0.0;
+        ch.lastValue = 0.0;
+        ch.sumAbsDelta = 0.0;
+    }
+}
+
+FrameStatistics::Summary FrameStatistics::GetSummary(ChannelId channel) const
+{
+    const Channel& ch = m_Channels[channel];
+    const LatencyHistogram& histogram = ch.histogram;
+
+    auto toMs = [](uint64_t us) { return double(us) * 1e-3; };
+
+    Summary summary;
+    summary.name = ch.name;
+    summary.count = histogram.GetCount();
+    if (summary.count == 0)
+        return summary;
+
+    summary.minMs = toMs(histogram.GetMin());
+    summary.meanMs = ch.mean;
+    summary.p50Ms = toMs(histogram.GetValueAtPercentile(50.0));
+    summary.p90Ms = toMs(histogram.GetValueAtPercentile(90.0));
+    summary.p99Ms = toMs(histogram.GetValueAtPercentile(99.0));
+    summary.p999Ms = toMs(histogram.GetValueAtPercentile(99.9));
+    summary.maxMs = toMs(histogram.GetMax());
+    summary.stdDevMs = summary.count > 1 ? std::sqrt(ch.m2 / double(summary.count - 1)) : 0.0;
+    summary.pacingMs = summary.count > 1 ? ch.sumAbsDelta / double(summary.count - 1) : 0.0;
+    return summary;
+}
+
+bool FrameStatistics::WriteSummaryCsv(const std::filesystem::path& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file.is_open())
+    {
+        log::error("FrameStatistics: cannot open '%s' for writing", fileName.generic_string().c_str());
+        return false;
+    }
+
+    file << "channel,count,min_ms,mean_ms,p50_ms,p90_ms,p99_ms,p99.9_ms,max_ms,stddev_ms,pacing_ms\n";
+    file.precision(3);
+    file << std::fixed;
+
+    for (ChannelId channel = 0; channel < GetNumChannels(); channel++)
+    {
+        Summary s = GetSummary(channel);
+        file << s.name << ',' << s.count << ',' << s.minMs << ',' << s.meanMs << ',' << s.p50Ms << ',' << s.p90Ms << ','
+            << s.p99Ms << ',' << s.p999Ms << ',' << s.maxMs << ',' << s.stdDevMs << ',' << s.pacingMs << '\n';
+    }
+
+    return file.good();
+}
+
+bool FrameStatistics::WriteHistogramCsv(const std::filesystem::path& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file.is_open())
+    {
+        log::error("FrameStatistics: cannot open '%s' for writing", fileName.generic_string().c_str());
+        return false;
+    }
+
+    file << "channel,lower_us,upper_us,count\n";
+
+    for (const Channel& ch : m_Channels)
+    {
+        for (uint32_t index = 0; index < LatencyHistogram::BucketCount; index++)
+        {
+            uint64_t count = ch.histogram.GetBucketCount(index);
+            if (count == 0)
+                continue;
+
+            file << ch.name << ',' << LatencyHistogram::GetBucketLowerBound(index) << ','
+                << LatencyHistogram::GetBucketUpperBound(index) << ',' << count << '\n';
+        }
+    }
+
+    return file.good();
+}
+
+bool FrameStatistics::WriteReportJson(const std::filesystem::path& fileName,
+    const std::vector<std::pair<std::string, std::string>>& info,
+    const std::vector<std::pair<std::string, double>>& metrics) const
+{
+    Json::Value root(Json::objectValue);
+
+    Json::Value& infoNode = root["info"];
+    infoNode = Json::Value(Json::objectValue);
+    for (const auto& [name, value] : info)
+        infoNode[name] = value;
+
+    Json::Value& metricsNode = root["metrics"];
+    metricsNode = Json::Value(Json::objectValue);
+    for (const auto& [name, value] : metrics)
+        metricsNode[name] = value;
+
+    Json::Value& channelsNode = root["channels"];
+    channelsNode = Json::Value(Json::arrayValue);
+    for (ChannelId channel = 0; channel < GetNumChannels(); channel++)
+    {
+        Summary s = GetSummary(channel);
+        if (s.count == 0)
+            continue;
+
+        Json::Value node(Json::objectValue);
+        node["name"] = s.name;
+        node["count"] = Json::UInt64(s.count);
+        node["minMs"] = s.minMs;
+        node["meanMs"] = s.meanMs;
+        node["p50Ms"] = s.p50Ms;
+        node["p90Ms"] = s.p90Ms;
+        node["p99Ms"] = s.p99Ms;
+        node["p999Ms"] = s.p999Ms;
+        node["maxMs"] = s.maxMs;
+        node["stdDevMs"] = s.stdDevMs;
+        node["pacingMs"] = s.pacingMs;
+        channelsNode.append(node);
+    }
+
+    std::ofstream file(fileName);
+    if (!file.is_open())
+    {
+        log::error("FrameStatistics: cannot open '%s' for writing", fileName.generic_string().c_str());
+        return false;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root, &file);
+    file << '\n';
+
+    return file.good();
+}
@@ -28,6 +28,7 @@
 #include <donut/engine/SceneGraph.h>
 #include <donut/core/vfs/VFS.h>
 #include <donut/core/log.h>
+#include <donut/core/profiler.h>
 
 #include "nvrhi/common/misc.h"
 
@@ -215,6 +216,8 @@ bool GltfImporter::Load(
     tf::Executor* executor,
     SceneImportResult& result) const
 {
+    DONUT_PROFILE_SCOPE("GltfImporter::Load");
+
     // Set this to 'true' if you need to fix broken tangents in a model.
     // Patched buffers will be saved alongside the gltf file, named like "<scene-name>.buffer<N>.bin"
     constexpr bool c_ForceRebuildTangents = false;
@@ -920,6 +923,22 @@ bool GltfImporter::Load(
         }
     }
 
+    if (m_OptimizeMeshes)
+    {
+        MeshOptimizationStatistics optimizationStats = OptimizeMeshes(meshes, executor, m_OverdrawThreshold);
+
+        log::info("Optimized the meshes of '%s': ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", normalizedFileName.c_str(),
+            optimizationStats.before.GetACMR(), optimizationStats.after.GetACMR(),
+            optimizationStats.before.GetATVR(), optimizationStats.after.GetATVR());
+    }
+
+    if (m_GenerateLods)
+    {
+        uint32_t numLods = GenerateMeshLods(meshes, executor, m_LodParameters);
+
+        log::info("Generated %u levels of detail for the meshes of '%s'", numLods, normalizedFileName.c_str());
+    }
+
     std::unordered_map<const cgltf_camera*, std::shared_ptr<SceneCamera>> cameraMap;
     for (size_t camera_idx = 0; camera_idx < objects->cameras_count; camera_idx++)
     {
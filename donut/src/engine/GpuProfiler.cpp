@@ -0,0 +1,340 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <donut/engine/GpuProfiler.h>
+#include <donut/core/log.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+using namespace donut::engine;
+
+TimingWindow::TimingWindow(uint32_t capacity)
+    : m_Capacity(std::max(capacity, 1u))
+{
+    m_Samples.reserve(m_Capacity);
+}
+
+void TimingWindow::AddSample(float value)
+{
+    if (m_Samples.size() < m_Capacity)
+        m_Samples.push_back(value);
+    else
+        m_Samples[m_Next] = value;
+
+    m_Next = (m_Next + 1) % m_Capacity;
+    m_Last = value;
+}
+
+void TimingWindow::Clear()
+{
+    m_Samples.clear();
+    m_Next = 0;
+    m_Last = 0.f;
+}
+
+float TimingWindow::GetMin() const
+{
+    if (m_Samples.empty())
+        return 0.f;
+    return *std::min_element(m_Samples.begin(), m_Samples.end());
+}
+
+float TimingWindow::GetMax() const
+{
+    if (m_Samples.empty())
+        return 0.f;
+    return *std::max_element(m_Samples.begin(), m_Samples.end());
+}
+
+float TimingWindow::GetAverage() const
+{
+    if (m_Samples.empty())
+        return 0.f;
+    return float(std::accumulate(m_Samples.begin(), m_Samples.end(), 0.0) / double(m_Samples.size()));
+}
+
+float TimingWindow::GetPercentile(float percentile) const
+{
+    if (m_Samples.empty())
+        return 0.f;
+
+    // Nearest rank: the smallest sample such that at least percentile% of the samples are less or equal to it
+    const size_t count = m_Samples.size();
+    size_t rank = size_t(std::ceil(double(std::clamp(percentile, 0.f, 100.f)) * 0.01 * double(count)));
+    rank = std::clamp<size_t>(rank, 1, count);
+
+    std::vector<float> sorted = m_Samples;
+    std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.end());
+    return sorted[rank - 1];
+}
+
+GpuProfiler::GpuProfiler(nvrhi::IDevice* device, uint32_t framesInFlight, uint32_t windowSize, uint32_t traceHistoryFrames)
+    : m_Device(device)
+    , m_StartTime(std::chrono::steady_clock::now())
+    , m_WindowSize(windowSize)
+    , m_HistorySize(traceHistoryFrames)
+{
+    // One more slot than the frames in flight, so that the slot being reused has been submitted long enough ago
+    m_Frames.resize(std::max(framesInFlight, 1u) + 1);
+    m_CurrentFrame = uint32_t(m_Frames.size()) - 1;
+}
+
+void GpuProfiler::BeginFrame()
+{
+    if (!m_ScopeStack.empty())
+    {
+        log::warning("GpuProfiler: %d scope(s) not closed at the end of the frame", int(m_ScopeStack.size()));
+        m_ScopeStack.clear();
+    }
+
+    m_CurrentFrame = (m_CurrentFrame + 1) % uint32_t(m_Frames.size());
+    FrameSlot& frame = m_Frames[m_CurrentFrame];
+
+    if (frame.pending)
+        ResolveFrame(frame);
+
+    m_FrameEnabled = m_Enabled;
+
+    frame.scopes.clear();
+    frame.frameIndex = m_FrameIndex++;
+    frame.cpuTimeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_StartTime).count();
+    frame.pending = m_FrameEnabled;
+}
+
+void GpuProfiler::ResolveFrame(FrameSlot& frame)
+{
+    frame.pending = false;
+
+    bool complete = true;
+    for (const ScopeRecord& scope : frame.scopes)
+    {
+        if (!scope.closed || !m_Device->pollTimerQuery(frame.queries[scope.queryIndex]))
+        {
+            complete = false;
+            break;
+        }
+    }
+
+    if (!complete)
+    {
+        // Never wait for the GPU here. The queries may still be in flight, so they can't be reset
+        // and reused: let them go and create new ones when needed.
+        frame.queries.clear();
+        ++m_NumDroppedFrames;
+        return;
+    }
+
+    ResolvedFrame resolved;
+    resolved.frameIndex = frame.frameIndex;
+    resolved.cpuTimeUs = frame.cpuTimeUs;
+    resolved.scopes.reserve(frame.scopes.size());
+
+    // Scopes are stored in the order of BeginScope calls, so every scope comes after its parent.
+    // Children are laid out from the parent's start, siblings one after another.
+    std::vector<float> cursors;
+    float frameTimeMs = 0.f;
+
+    for (const ScopeRecord& scope : frame.scopes)
+    {
+        nvrhi::ITimerQuery* query = frame.queries[scope.queryIndex];
+        float durationMs = m_Device->getTimerQueryTime(query) * 1000.f;
+        m_Device->resetTimerQuery(query);
+
+        if (cursors.size() < scope.depth + 2)
+            cursors.resize(scope.depth + 2, 0.f);
+
+        ResolvedScope& item = resolved.scopes.emplace_back();
+        item.nameIndex = scope.nameIndex;
+        item.depth = scope.depth;
+        item.startMs = cursors[scope.depth];
+        item.durationMs = durationMs;
+
+        cursors[scope.depth] += durationMs;
+        cursors[scope.depth + 1] = item.startMs;
+
+        m_Windows[scope.nameIndex].AddSample(durationMs);
+
+        if (scope.depth == 0)
+            frameTimeMs += durationMs;
+    }
+
+    m_LastFrameTimeMs = frameTimeMs;
+    ++m_NumResolvedFrames;
+
+    if (m_HistorySize == 0)
+        return;
+
+    if (m_History.size() < m_HistorySize)
+        m_History.push_back(std::move(resolved));
+    else
+        m_History[m_HistoryNext] = std::move(resolved);
+
+    m_HistoryNext = (m_HistoryNext + 1) % m_HistorySize;
+}
+
+uint32_t GpuProfiler::GetNameIndex(const char* name, uint32_t depth)
+{
+    auto it = m_NameIndices.find(name);
+    if (it != m_NameIndices.end())
+        return it->second;
+
+    uint32_t index = uint32_t(m_Names.size());
+    m_Names.push_back(name);
+    m_NameDepths.push_back(depth);
+    m_Windows.emplace_back(m_WindowSize);
+    m_NameIndices[name] = index;
+    return index;
+}
+
+void GpuProfiler::BeginScope(nvrhi::ICommandList* commandList, const char* name)
+{
+    if (!m_FrameEnabled)
+        return;
+
+    FrameSlot& frame = m_Frames[m_CurrentFrame];
+
+    ScopeRecord scope;
+    scope.depth = uint32_t(m_ScopeStack.size());
+    scope.nameIndex = GetNameIndex(name, scope.depth);
+    scope.queryIndex = uint32_t(frame.scopes.size());
+
+    if (frame.queries.size() <= scope.queryIndex)
+        frame.queries.push_back(m_Device->createTimerQuery());
+
+    commandList->beginTimerQuery(frame.queries[scope.queryIndex]);
+
+    m_ScopeStack.push_back(uint32_t(frame.scopes.size()));
+    frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::EndScope(nvrhi::ICommandList* commandList)
+{
+    if (!m_FrameEnabled || m_ScopeStack.empty())
+        return;
+
+    FrameSlot& frame = m_Frames[m_CurrentFrame];
+    ScopeRecord& scope = frame.scopes[m_ScopeStack.back()];
+    m_ScopeStack.pop_back();
+
+    commandList->endTimerQuery(frame.queries[scope.queryIndex]);
+    scope.closed = true;
+}
+
+void GpuProfiler::GetPassStats(std::vector<PassStats>& outStats) const
+{
+    outStats.clear();
+    outStats.reserve(m_Names.size());
+
+    for (size_t index = 0; index < m_Names.size(); index++)
+    {
+        const TimingWindow& window = m_Windows[index];
+
+        PassStats& stats = outStats.emplace_back();
+        stats.name = m_Names[index];
+        stats.depth = m_NameDepths[index];
+        stats.numSamples = window.GetNumSamples();
+        stats.lastMs = window.GetLast();
+        stats.minMs = window.GetMin();
+        stats.avgMs = window.GetAverage();
+        stats.p99Ms = window.GetPercentile(99.f);
+    }
+}
+
+void GpuProfiler::ResetStats()
+{
+    for (TimingWindow& window : m_Windows)
+        window.Clear();
+
+    m_History.clear();
+    m_HistoryNext = 0;
+}
+
+static void WriteJsonString(std::ostream& stream, const std::string& value)
+{
+    stream << '"';
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '"': stream << "\\\""; break;
+        case '\\': stream << "\\\\"; break;
+        case '\n': stream << "\\n"; break;
+        case '\t': stream << "\\t"; break;
+        default:
+            if (uint8_t(c) < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", uint8_t(c));
+                stream << buf;
+            }
+            else
+                stream << c;
+        }
+    }
+    stream << '"';
+}
+
+std::string GpuProfiler::GetChromeTrace() const
+{
+    std::ostringstream stream;
+    stream.precision(3);
+    stream << std::fixed;
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+    // Walk the history ring from the oldest frame
+    for (size_t i = 0; i < m_History.size(); i++)
+    {
+        const ResolvedFrame& frame = m_History[(m_HistoryNext + i) % m_History.size()];
+
+        for (const ResolvedScope& scope : frame.scopes)
+        {
+            stream << ",\n{\"name\":";
+            WriteJsonString(stream, m_Names[scope.nameIndex]);
+            stream << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+                << ",\"ts\":" << frame.cpuTimeUs + double(scope.startMs) * 1000.0
+                << ",\"dur\":" << double(scope.durationMs) * 1000.0
+                << ",\"args\":{\"frame\":" << frame.frameIndex << "}}";
+        }
+    }
+
+    stream << "\n]}\n";
+    return stream.str();
+}
+
+bool GpuProfiler::WriteChromeTrace(const std::filesystem::path& fileName) const
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file.is_open())
+    {
+        log::error("GpuProfiler: cannot open '%s' for writing", fileName.generic_string().c_str());
+        return false;
+    }
+
+    file << GetChromeTrace();
+    return file.good();
+}
@@ -87,14 +87,28 @@ nvrhi::IBindingSet* donut::engine::MaterialBindingCache::GetMaterialBindingSet(c
 {
     std::lock_guard<std::mutex> lockGuard(m_Mutex);
 
-    nvrhi::BindingSetHandle& bindingSet = m_BindingSets[material];
+    CachedBindingSet& entry = m_BindingSets[material];
 
-    if (bindingSet)
-        return bindingSet;
+    // Textures can be recreated after the binding set has been created, e.g. by mip streaming.
+    // Only look at the textures of the material when some texture has been replaced since the last check.
+    // The generation is read first, so that a replacement that happens during the check is seen next time.
+    const uint32_t textureGeneration = LoadedTexture::replacementGeneration.load();
+    if (entry.bindingSet)
+    {
+        if (entry.textureGeneration == textureGeneration)
+            return entry.bindingSet;
+
+        if (!IsMaterialBindingSetStale(entry.bindingSet, material))
+        {
+            entry.textureGeneration = textureGeneration;
+            return entry.bindingSet;
+        }
+    }
 
-    bindingSet = CreateMaterialBindingSet(material);
+    entry.bindingSet = CreateMaterialBindingSet(material);
+    entry.textureGeneration = textureGeneration;
 
-    return bindingSet;
+    return entry.bindingSet;
 }
 
 void donut::engine::MaterialBindingCache::Clear()
@@ -104,6 +118,41 @@ void donut::engine::MaterialBindingCache::Clear()
     m_BindingSets.clear();
 }
 
+static const std::shared_ptr<LoadedTexture>* GetMaterialTexture(const Material* material, MaterialResource resource)
+{
+    switch (resource)
+    {
+    case MaterialResource::DiffuseTexture: return &material->baseOrDiffuseTexture;
+    case MaterialResource::SpecularTexture: return &material->metalRoughOrSpecularTexture;
+    case MaterialResource::NormalTexture: return &material->normalTexture;
+    case MaterialResource::EmissiveTexture: return &material->emissiveTexture;
+    case MaterialResource::OcclusionTexture: return &material->occlusionTexture;
+    case MaterialResource::TransmissionTexture: return &material->transmissionTexture;
+    case MaterialResource::OpacityTexture: return &material->opacityTexture;
+    default: return nullptr;
+    }
+}
+
+bool MaterialBindingCache::IsMaterialBindingSetStale(nvrhi::IBindingSet* bindingSet, const Material* material) const
+{
+    const nvrhi::BindingSetDesc* desc = bindingSet->getDesc();
+    if (!desc || desc->bindings.size() != m_BindingDesc.size())
+        return false;
+
+    for (size_t index = 0; index < m_BindingDesc.size(); index++)
+    {
+        const std::shared_ptr<LoadedTexture>* texture = GetMaterialTexture(material, m_BindingDesc[index].resource);
+        if (!texture)
+            continue;
+
+        nvrhi::BindingSetItem expected = GetTextureBindingSetItem(m_BindingDesc[index].slot, *texture);
+        if (desc->bindings[index].resourceHandle != expected.resourceHandle)
+            return true;
+    }
+
+    return false;
+}
+
 nvrhi::BindingSetItem MaterialBindingCache::GetTextureBindingSetItem(uint32_t slot, const std::shared_ptr<LoadedTexture>& texture) const
 {
     return nvrhi::BindingSetItem::Texture_SRV(slot, texture && texture->texture ? texture->texture.Get() : m_FallbackTexture.Get());
@@ -0,0 +1,505 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MeshOptimizer.h>
+#include <donut/engine/ParallelFor.h>
+#include <donut/engine/SceneTypes.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace donut::math;
+using namespace donut::engine;
+
+VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& other)
+{
+    numTriangles += other.numTriangles;
+    numVertices += other.numVertices;
+    numTransforms += other.numTransforms;
+    return *this;
+}
+
+namespace
+{
+    // FIFO cache simulation based on timestamps: a vertex is in the cache if it was
+    // transformed less than cacheSize transforms ago. Flush() invalidates all entries.
+    class FifoCacheSimulator
+    {
+    public:
+        FifoCacheSimulator(size_t numVertices, uint32_t cacheSize)
+            : m_Timestamps(numVertices, 0)
+            , m_CacheSize(cacheSize)
+            , m_Timestamp(cacheSize + 1)
+        { }
+
+        // Returns the number of cache misses for one triangle
+        uint32_t AddTriangle(const uint32_t* triangle)
+        {
+            uint32_t misses = 0;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const uint32_t vertex = triangle[corner];
+                if (m_Timestamp - m_Timestamps[vertex] > m_CacheSize)
+                {
+                    m_Timestamps[vertex] = m_Timestamp++;
+                    ++misses;
+                }
+            }
+            return misses;
+        }
+
+        void Flush()
+        {
+            m_Timestamp += m_CacheSize + 1;
+        }
+
+    private:
+        std::vector<uint32_t> m_Timestamps;
+        uint32_t m_CacheSize;
+        uint32_t m_Timestamp;
+    };
+
+    // Vertex scoring from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    constexpr uint32_t c_ForsythCacheSize = 32;
+    constexpr uint32_t c_ForsythMaxValence = 32;
+
+    struct ForsythScoreTables
+    {
+        float cachePosition[c_ForsythCacheSize];
+        float valence[c_ForsythMaxValence + 1];
+
+        ForsythScoreTables()
+        {
+            for (uint32_t position = 0; position < c_ForsythCacheSize; position++)
+            {
+                // The last triangle's vertices get a fixed score so that the next triangle doesn't simply reuse them
+                cachePosition[position] = position < 3
+                    ? 0.75f
+                    : std::pow(1.f - float(position - 3) / float(c_ForsythCacheSize - 3), 1.5f);
+            }
+
+            // Prefer vertices with few remaining triangles, to get rid of them and avoid isolated triangles
+            valence[0] = 0.f;
+            for (uint32_t count = 1; count <= c_ForsythMaxValence; count++)
+                valence[count] = 2.f / std::sqrt(float(count));
+        }
+
+        [[nodiscard]] float GetVertexScore(int position, uint32_t liveTriangles) const
+        {
+            if (liveTriangles == 0)
+                return -1.f;
+
+            float score = position < 0 ? 0.f : cachePosition[position];
+            return score + valence[std::min(liveTriangles, c_ForsythMaxValence)];
+        }
+    };
+}
+
+VertexCacheStatistics donut::engine::AnalyzeVertexCache(const uint32_t* indices, size_t numIndices, size_t numVertices, uint32_t cacheSize)
+{
+    VertexCacheStatistics stats;
+    const size_t numTriangles = numIndices / 3;
+    stats.numTriangles = numTriangles;
+
+    FifoCacheSimulator cache(numVertices, cacheSize);
+    std::vector<bool> referenced(numVertices, false);
+
+    for (size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        stats.numTransforms += cache.AddTriangle(indices + triangle * 3);
+
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t vertex = indices[triangle * 3 + corner];
+            if (!referenced[vertex])
+            {
+                referenced[vertex] = true;
+                ++stats.numVertices;
+            }
+        }
+    }
+
+    return stats;
+}
+
+void donut::engine::OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t numIndices, size_t numVertices)
+{
+    assert(destination != indices);
+
+    static const ForsythScoreTables scoreTables;
+
+    const size_t numTriangles = numIndices / 3;
+
+    // Vertex to triangle adjacency. The first liveTriangles[v] entries of each list are the triangles not emitted yet.
+    std::vector<uint32_t> liveTriangles(numVertices, 0);
+    for (size_t i = 0; i < numTriangles * 3; i++)
+        ++liveTriangles[indices[i]];
+
+    std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+
+    std::vector<uint32_t> adjacency(numTriangles * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < numTriangles * 3; i++)
+            adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    std::vector<int> cachePositions(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+        vertexScores[vertex] = scoreTables.GetVertexScore(-1, liveTriangles[vertex]);
+
+    std::vector<float> triangleScores(numTriangles);
+    for (size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        const uint32_t* corners = indices + triangle * 3;
+        triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    }
+
+    std::vector<bool> emitted(numTriangles, false);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(c_ForsythCacheSize + 3);
+    newCache.reserve(c_ForsythCacheSize + 3);
+
+    size_t nextInputTriangle = 0;
+    size_t bestTriangle = numTriangles;
+
+    for (size_t outputTriangle = 0; outputTriangle < numTriangles; outputTriangle++)
+    {
+        // Dead end: nothing in the cache has triangles left, continue in the input order
+        if (bestTriangle == numTriangles)
+        {
+            while (emitted[nextInputTriangle])
+                ++nextInputTriangle;
+            bestTriangle = nextInputTriangle;
+        }
+
+        const uint32_t* corners = indices + bestTriangle * 3;
+        std::copy(corners, corners + 3, destination + outputTriangle * 3);
+        emitted[bestTriangle] = true;
+
+        newCache.clear();
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t vertex = corners[corner];
+
+            // Remove the triangle from the live list of the vertex; the list is
+            // shortened once per corner, so degenerate triangles are handled too
+            uint32_t* begin = adjacency.data() + adjacencyOffsets[vertex];
+            uint32_t* end = begin + liveTriangles[vertex];
+            uint32_t* found = std::find(begin, end, uint32_t(bestTriangle));
+            if (found != end)
+            {
+                *found = *(end - 1);
+                --liveTriangles[vertex];
+            }
+
+            if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+                newCache.push_back(vertex);
+        }
+
+        const size_t numTriangleVertices = newCache.size();
+        for (uint32_t vertex : cache)
+        {
+            const auto triangleVerticesEnd = newCache.begin() + numTriangleVertices;
+            if (std::find(newCache.begin(), triangleVerticesEnd, vertex) == triangleVerticesEnd)
+                newCache.push_back(vertex);
+        }
+
+        // Update the scores of the vertices whose cache position or valence changed, including the evicted ones
+        for (size_t position = 0; position < newCache.size(); position++)
+        {
+            const uint32_t vertex = newCache[position];
+            cachePositions[vertex] = position < c_ForsythCacheSize ? int(position) : -1;
+
+            const float score = scoreTables.GetVertexScore(cachePositions[vertex], liveTriangles[vertex]);
+            const float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            for (uint32_t i = 0; i < liveTriangles[vertex]; i++)
+                triangleScores[adjacency[adjacencyOffsets[vertex] + i]] += delta;
+        }
+
+        if (newCache.size() > c_ForsythCacheSize)
+            newCache.resize(c_ForsythCacheSize);
+        std::swap(cache, newCache);
+
+        // Only the triangles that use cached vertices can have a high score
+        bestTriangle = numTriangles;
+        float bestScore = -1.f;
+        for (uint32_t vertex : cache)
+        {
+            for (uint32_t i = 0; i < liveTriangles[vertex]; i++)
+            {
+                const uint32_t triangle = adjacency[adjacencyOffsets[vertex] + i];
+                if (triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    bestTriangle = triangle;
+                }
+            }
+        }
+    }
+
+    // Pass through an incomplete trailing triangle, if any
+    std::copy(indices + numTriangles * 3, indices + numIndices, destination + numTriangles * 3);
+}
+
+void donut::engine::OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+    const float3* positions, size_t numVertices, float threshold)
+{
+    assert(destination != indices);
+
+    const size_t numTriangles = numIndices / 3;
+    std::copy(indices + numTriangles * 3, indices + numIndices, destination + numTriangles * 3);
+
+    if (numTriangles == 0)
+        return;
+
+    FifoCacheSimulator cache(numVertices, DefaultVertexCacheSize);
+
+    // Hard boundaries: the triangles where the cache is effectively flushed (all vertices miss)
+    std::vector<uint32_t> hardClusters;
+    for (size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        if (cache.AddTriangle(indices + triangle * 3) == 3 || triangle == 0)
+            hardClusters.push_back(uint32_t(triangle));
+    }
+    hardClusters.push_back(uint32_t(numTriangles));
+
+    // Soft boundaries: split the hard clusters wherever the local ACMR is close enough to the cluster's ACMR
+    std::vector<uint32_t> clusters;
+    for (size_t hardCluster = 0; hardCluster + 1 < hardClusters.size(); hardCluster++)
+    {
+        const uint32_t start = hardClusters[hardCluster];
+        const uint32_t end = hardClusters[hardCluster + 1];
+
+        cache.Flush();
+        uint32_t clusterMisses = 0;
+        for (uint32_t triangle = start; triangle < end; triangle++)
+            clusterMisses += cache.AddTriangle(indices + triangle * 3);
+
+        const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+        cache.Flush();
+        clusters.push_back(start);
+        uint32_t softStart = start;
+        uint32_t softMisses = 0;
+
+        for (uint32_t triangle = start; triangle < end; triangle++)
+        {
+            softMisses += cache.AddTriangle(indices + triangle * 3);
+
+            if (triangle + 1 < end && float(softMisses) / float(triangle + 1 - softStart) <= clusterThreshold)
+            {
+                clusters.push_back(triangle + 1);
+                softStart = triangle + 1;
+                softMisses = 0;
+                cache.Flush();
+            }
+        }
+    }
+    clusters.push_back(uint32_t(numTriangles));
+
+    const size_t numClusters = clusters.size() - 1;
+
+    float3 meshCentroid = 0.f;
+    {
+        std::vector<bool> referenced(numVertices, false);
+        size_t count = 0;
+        for (size_t i = 0; i < numTriangles * 3; i++)
+        {
+            if (!referenced[indices[i]])
+            {
+                referenced[indices[i]] = true;
+                meshCentroid += positions[indices[i]];
+                ++count;
+            }
+        }
+        meshCentroid /= float(count);
+    }
+
+    // Clusters that face away from the mesh center are on the outside and are likely to occlude the others
+    std::vector<float> sortKeys(numClusters);
+    for (size_t cluster = 0; cluster < numClusters; cluster++)
+    {
+        float3 centroid = 0.f;
+        float3 normal = 0.f;
+        float area = 0.f;
+
+        for (uint32_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++)
+        {
+            const float3& p0 = positions[indices[triangle * 3 + 0]];
+            const float3& p1 = positions[indices[triangle * 3 + 1]];
+            const float3& p2 = positions[indices[triangle * 3 + 2]];
+
+            const float3 triangleNormal = cross(p1 - p0, p2 - p0);
+            const float triangleArea = length(triangleNormal);
+
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.f);
+            normal += triangleNormal;
+            area += triangleArea;
+        }
+
+        const float normalLength = length(normal);
+        if (area > 0.f && normalLength > 0.f)
+            sortKeys[cluster] = dot(centroid / area - meshCentroid, normal / normalLength);
+        else
+            sortKeys[cluster] = -std::numeric_limits<float>::infinity();
+    }
+
+    std::vector<uint32_t> order(numClusters);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    uint32_t* output = destination;
+    for (uint32_t cluster : order)
+    {
+        output = std::copy(indices + clusters[cluster] * 3, indices + clusters[cluster + 1] * 3, output);
+    }
+}
+
+size_t donut::engine::OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t numIndices, size_t numVertices)
+{
+    std::fill(remap, remap + numVertices, ~0u);
+
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < numIndices; i++)
+    {
+        uint32_t& target = remap[indices[i]];
+        if (target == ~0u)
+            target = nextVertex++;
+    }
+
+    const size_t numReferenced = nextVertex;
+
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+    {
+        if (remap[vertex] == ~0u)
+            remap[vertex] = nextVertex++;
+    }
+
+    return numReferenced;
+}
+
+void donut::engine::RemapIndexBuffer(uint32_t* indices, size_t numIndices, const uint32_t* remap)
+{
+    for (size_t i = 0; i < numIndices; i++)
+        indices[i] = remap[indices[i]];
+}
+
+template<typename T>
+static void RemapVertexRange(std::vector<T>& stream, size_t firstVertex, size_t numVertices, const uint32_t* remap)
+{
+    if (stream.size() >= firstVertex + numVertices)
+        RemapVertexStream(stream.data() + firstVertex, numVertices, remap);
+}
+
+MeshOptimizationStatistics donut::engine::OptimizeMeshes(const std::vector<std::shared_ptr<MeshInfo>>& meshes, tf::Executor* executor,
+    float overdrawThreshold)
+{
+    struct GeometryRange
+    {
+        BufferGroup* buffers;
+        size_t firstIndex;
+        size_t firstVertex;
+        size_t numIndices;
+        size_t numVertices;
+    };
+
+    std::vector<GeometryRange> geometries;
+    for (const auto& mesh : meshes)
+    {
+        if (!mesh || mesh->skinPrototype || !mesh->buffers)
+            continue;
+
+        BufferGroup& buffers = *mesh->buffers;
+        if (buffers.indexBuffer || buffers.vertexBuffer)
+            continue;
+
+        for (const auto& geometry : mesh->geometries)
+        {
+            GeometryRange range;
+            range.buffers = &buffers;
+            range.firstIndex = size_t(mesh->indexOffset) + geometry->indexOffsetInMesh;
+            range.firstVertex = size_t(mesh->vertexOffset) + geometry->vertexOffsetInMesh;
+            range.numIndices = geometry->numIndices;
+            range.numVertices = geometry->numVertices;
+
+            if (range.numIndices < 3 ||
+                range.firstIndex + range.numIndices > buffers.indexData.size() ||
+                range.firstVertex + range.numVertices > buffers.positionData.size())
+                continue;
+
+            const uint32_t* indices = buffers.indexData.data() + range.firstIndex;
+            if (std::any_of(indices, indices + range.numIndices, [&range](uint32_t index) { return index >= range.numVertices; }))
+                continue;
+
+            geometries.push_back(range);
+        }
+    }
+
+    std::vector<MeshOptimizationStatistics> results(geometries.size());
+
+    ParallelFor(executor, uint32_t(geometries.size()), [&geometries, &results, overdrawThreshold](uint32_t index)
+    {
+        const GeometryRange& range = geometries[index];
+        BufferGroup& buffers = *range.buffers;
+        uint32_t* indices = buffers.indexData.data() + range.firstIndex;
+        const float3* positions = buffers.positionData.data() + range.firstVertex;
+
+        results[index].before = AnalyzeVertexCache(indices, range.numIndices, range.numVertices);
+
+        std::vector<uint32_t> cacheOptimized(range.numIndices);
+        OptimizeVertexCache(cacheOptimized.data(), indices, range.numIndices, range.numVertices);
+        OptimizeOverdraw(indices, cacheOptimized.data(), range.numIndices, positions, range.numVertices, overdrawThreshold);
+
+        std::vector<uint32_t> remap(range.numVertices);
+        OptimizeVertexFetchRemap(remap.data(), indices, range.numIndices, range.numVertices);
+        RemapIndexBuffer(indices, range.numIndices, remap.data());
+
+        RemapVertexRange(buffers.positionData, range.firstVertex, range.numVertices, remap.data());
+        RemapVertexRange(buffers.texcoord1Data, range.firstVertex, range.numVertices, remap.data());
+        RemapVertexRange(buffers.texcoord2Data, range.firstVertex, range.numVertices, remap.data());
+        RemapVertexRange(buffers.normalData, range.firstVertex, range.numVertices, remap.data());
+        RemapVertexRange(buffers.tangentData, range.firstVertex, range.numVertices, remap.data());
+        RemapVertexRange(buffers.jointData, range.firstVertex, range.numVertices, remap.data());
+        RemapVertexRange(buffers.weightData, range.firstVertex, range.numVertices, remap.data());
+
+        results[index].after = AnalyzeVertexCache(indices, range.numIndices, range.numVertices);
+    });
+
+    MeshOptimizationStatistics total;
+    for (const MeshOptimizationStatistics& result : results)
+    {
+        total.before += result.before;
+        total.after += result.after;
+    }
+
+    return total;
+}
@@ -0,0 +1,519 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MeshSimplifier.h>
+#include <donut/engine/MeshOptimizer.h>
+#include <donut/engine/ParallelFor.h>
+#include <donut/engine/SceneTypes.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace donut::math;
+using namespace donut::engine;
+
+namespace
+{
+    // Sum of squared distances to a set of planes, weighted by the areas of the triangles
+    // that defined them. Evaluate() returns the weighted mean, which has units of distance squared.
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        void AddPlane(const double n[3], double d, double w)
+        {
+            a00 += w * n[0] * n[0]; a01 += w * n[0] * n[1]; a02 += w * n[0] * n[2];
+            a11 += w * n[1] * n[1]; a12 += w * n[1] * n[2]; a22 += w * n[2] * n[2];
+            b0 += w * n[0] * d; b1 += w * n[1] * d; b2 += w * n[2] * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        Quadric& operator+=(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02;
+            a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+            return *this;
+        }
+
+        [[nodiscard]] double Evaluate(const float3& p) const
+        {
+            if (weight <= 0)
+                return 0;
+
+            const double x = p.x, y = p.y, z = p.z;
+            double error = a00 * x * x + a11 * y * y + a22 * z * z
+                + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2 * (b0 * x + b1 * y + b2 * z)
+                + c;
+            return std::max(error, 0.0) / weight;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float cost;
+    };
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const float3* positions, const float2* texCoords, size_t numVertices, float attributeWeight)
+            : m_Positions(positions)
+            , m_TexCoords(texCoords)
+            , m_NumVertices(numVertices)
+            , m_Quadrics(numVertices)
+            , m_Locked(numVertices, false)
+            , m_Remap(numVertices)
+            , m_Touched(numVertices, 0)
+            , m_Marks(numVertices, 0)
+        {
+            box3 bounds = box3::empty();
+            for (size_t vertex = 0; vertex < numVertices; vertex++)
+                bounds |= positions[vertex];
+            m_Radius = bounds.isempty() ? 0.f : length(bounds.diagonal()) * 0.5f;
+            m_AttributeScale = double(attributeWeight) * double(m_Radius) * double(m_Radius);
+
+            for (size_t vertex = 0; vertex < numVertices; vertex++)
+                m_Remap[vertex] = uint32_t(vertex);
+        }
+
+        [[nodiscard]] float GetRadius() const { return m_Radius; }
+
+        void Initialize(const std::vector<uint32_t>& indices)
+        {
+            for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+            {
+                const uint32_t* corners = indices.data() + triangle;
+                const float3 p0 = m_Positions[corners[0]];
+                const float3 e1 = m_Positions[corners[1]] - p0;
+                const float3 e2 = m_Positions[corners[2]] - p0;
+                const float3 normal = cross(e1, e2);
+                const float doubleArea = length(normal);
+                if (doubleArea <= 0.f)
+                    continue;
+
+                double n[3] = { normal.x / doubleArea, normal.y / doubleArea, normal.z / doubleArea };
+                double d = -(n[0] * p0.x + n[1] * p0.y + n[2] * p0.z);
+                for (uint32_t corner = 0; corner < 3; corner++)
+                    m_Quadrics[corners[corner]].AddPlane(n, d, doubleArea * 0.5);
+            }
+
+            // Lock the vertices of all edges that are not shared by exactly two triangles:
+            // open borders, UV and normal seams (where the vertices are split), and non-manifold edges.
+            std::vector<uint64_t> edges;
+            edges.reserve(indices.size());
+            for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t a = indices[triangle + corner];
+                    uint32_t b = indices[triangle + (corner + 1) % 3];
+                    edges.push_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+
+            for (size_t first = 0; first < edges.size(); )
+            {
+                size_t last = first + 1;
+                while (last < edges.size() && edges[last] == edges[first])
+                    ++last;
+
+                if (last - first != 2)
+                {
+                    m_Locked[uint32_t(edges[first] >> 32)] = true;
+                    m_Locked[uint32_t(edges[first])] = true;
+                }
+
+                first = last;
+            }
+        }
+
+        // Runs one pass of non-overlapping collapses in the order of increasing cost.
+        // Returns false if no collapse could be made.
+        bool RunPass(std::vector<uint32_t>& indices, size_t targetIndexCount, double maxCost, double& resultCost)
+        {
+            BuildAdjacency(indices);
+
+            std::vector<Collapse> collapses;
+            collapses.reserve(indices.size());
+            for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t a = indices[triangle + corner];
+                    uint32_t b = indices[triangle + (corner + 1) % 3];
+
+                    // Interior edges appear once in each direction, use one of them for both collapses
+                    if (a > b)
+                        continue;
+
+                    if (!m_Locked[a])
+                        collapses.push_back(Collapse{ a, b, GetCost(a, b) });
+                    if (!m_Locked[b])
+                        collapses.push_back(Collapse{ b, a, GetCost(b, a) });
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+            ++m_PassIndex;
+            const size_t trianglesToRemove = (indices.size() - targetIndexCount) / 3;
+            size_t removedTriangles = 0;
+            bool collapsed = false;
+
+            for (const Collapse& collapse : collapses)
+            {
+                if (collapse.cost > maxCost)
+                    break;
+
+                if (m_Touched[collapse.from] == m_PassIndex || m_Touched[collapse.to] == m_PassIndex)
+                    continue;
+
+                uint32_t sharedTriangles = 0;
+                if (!IsCollapseValid(collapse.from, collapse.to, sharedTriangles))
+                    continue;
+
+                m_Remap[collapse.from] = collapse.to;
+                m_Quadrics[collapse.to] += m_Quadrics[collapse.from];
+                TouchNeighborhood(collapse.from);
+                TouchNeighborhood(collapse.to);
+
+                resultCost = std::max(resultCost, double(collapse.cost));
+                removedTriangles += sharedTriangles;
+                collapsed = true;
+
+                if (removedTriangles >= trianglesToRemove)
+                    break;
+            }
+
+            if (!collapsed)
+                return false;
+
+            size_t writeIndex = 0;
+            for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+            {
+                uint32_t a = m_Remap[indices[triangle + 0]];
+                uint32_t b = m_Remap[indices[triangle + 1]];
+                uint32_t c = m_Remap[indices[triangle + 2]];
+                if (a == b || b == c || c == a)
+                    continue;
+
+                indices[writeIndex++] = a;
+                indices[writeIndex++] = b;
+                indices[writeIndex++] = c;
+            }
+            indices.resize(writeIndex);
+
+            return true;
+        }
+
+    private:
+        const float3* m_Positions;
+        const float2* m_TexCoords;
+        size_t m_NumVertices;
+        float m_Radius = 0.f;
+        double m_AttributeScale = 0.0;
+
+        std::vector<Quadric> m_Quadrics;
+        std::vector<bool> m_Locked;
+        std::vector<uint32_t> m_Remap;
+        std::vector<uint32_t> m_Touched;
+        std::vector<uint32_t> m_Marks;
+        uint32_t m_PassIndex = 0;
+        uint32_t m_MarkIndex = 0;
+
+        // Triangles adjacent to every vertex, in the compressed sparse row format
+        std::vector<uint32_t> m_TriangleOffsets;
+        std::vector<uint32_t> m_VertexTriangles;
+        const uint32_t* m_Indices = nullptr;
+
+        [[nodiscard]] float GetCost(uint32_t from, uint32_t to) const
+        {
+            Quadric quadric = m_Quadrics[from];
+            quadric += m_Quadrics[to];
+            double cost = quadric.Evaluate(m_Positions[to]);
+
+            if (m_TexCoords)
+            {
+                float2 delta = m_TexCoords[from] - m_TexCoords[to];
+                cost += m_AttributeScale * double(dot(delta, delta));
+            }
+
+            return float(cost);
+        }
+
+        void BuildAdjacency(const std::vector<uint32_t>& indices)
+        {
+            m_Indices = indices.data();
+            m_TriangleOffsets.assign(m_NumVertices + 1, 0);
+            for (uint32_t index : indices)
+                ++m_TriangleOffsets[index + 1];
+            for (size_t vertex = 0; vertex < m_NumVertices; vertex++)
+                m_TriangleOffsets[vertex + 1] += m_TriangleOffsets[vertex];
+
+            m_VertexTriangles.resize(indices.size());
+            std::vector<uint32_t> writeOffsets(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+            for (size_t index = 0; index < indices.size(); index++)
+                m_VertexTriangles[writeOffsets[indices[index]]++] = uint32_t(index / 3);
+        }
+
+        void TouchNeighborhood(uint32_t vertex)
+        {
+            for (uint32_t offset = m_TriangleOffsets[vertex]; offset < m_TriangleOffsets[vertex + 1]; offset++)
+            {
+                const uint32_t* corners = m_Indices + m_VertexTriangles[offset] * 3;
+                for (uint32_t corner = 0; corner < 3; corner++)
+                    m_Touched[corners[corner]] = m_PassIndex;
+            }
+        }
+
+        bool IsCollapseValid(uint32_t from, uint32_t to, uint32_t& sharedTriangles)
+        {
+            // Link condition: the only vertices connected to both ends of the edge must be the
+            // apexes of the triangles that share it, otherwise the collapse creates non-manifold geometry.
+            ++m_MarkIndex;
+            sharedTriangles = 0;
+            for (uint32_t offset = m_TriangleOffsets[from]; offset < m_TriangleOffsets[from + 1]; offset++)
+            {
+                const uint32_t* corners = m_Indices + m_VertexTriangles[offset] * 3;
+                if (corners[0] == to || corners[1] == to || corners[2] == to)
+                    ++sharedTriangles;
+                for (uint32_t corner = 0; corner < 3; corner++)
+                    m_Marks[corners[corner]] = m_MarkIndex;
+            }
+
+            uint32_t commonNeighbors = 0;
+            ++m_MarkIndex;
+            for (uint32_t offset = m_TriangleOffsets[to]; offset < m_TriangleOffsets[to + 1]; offset++)
+            {
+                const uint32_t* corners = m_Indices + m_VertexTriangles[offset] * 3;
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t vertex = corners[corner];
+                    if (vertex == from || vertex == to)
+                        continue;
+
+                    // Marked by the loop over 'from', and not yet counted
+                    if (m_Marks[vertex] == m_MarkIndex - 1)
+                    {
+                        m_Marks[vertex] = m_MarkIndex;
+                        ++commonNeighbors;
+                    }
+                }
+            }
+
+            if (sharedTriangles == 0 || commonNeighbors != sharedTriangles)
+                return false;
+
+            // Reject collapses that flip or nearly degenerate the remaining triangles around 'from'
+            const float3 target = m_Positions[to];
+            for (uint32_t offset = m_TriangleOffsets[from]; offset < m_TriangleOffsets[from + 1]; offset++)
+            {
+                const uint32_t* corners = m_Indices + m_VertexTriangles[offset] * 3;
+                if (corners[0] == to || corners[1] == to || corners[2] == to)
+                    continue;
+
+                float3 p[3];
+                float3 q[3];
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    p[corner] = m_Positions[corners[corner]];
+                    q[corner] = (corners[corner] == from) ? target : p[corner];
+                }
+
+                float3 before = cross(p[1] - p[0], p[2] - p[0]);
+                float3 after = cross(q[1] - q[0], q[2] - q[0]);
+                if (dot(before, after) <= 0.25f * length(before) * length(after))
+                    return false;
+            }
+
+            return true;
+        }
+    };
+}
+
+size_t donut::engine::SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t numIndices,
+    const float3* positions, const float2* texCoords, size_t numVertices,
+    const MeshSimplificationParameters& params, float* outError)
+{
+    assert(numIndices % 3 == 0);
+
+    std::vector<uint32_t> result(indices, indices + numIndices);
+    Simplifier simplifier(positions, texCoords, numVertices, params.attributeWeight);
+    simplifier.Initialize(result);
+
+    const double maxError = double(params.targetError) * double(simplifier.GetRadius());
+    const double maxCost = maxError * maxError;
+    double resultCost = 0.0;
+
+    while (result.size() > params.targetIndexCount)
+    {
+        if (!simplifier.RunPass(result, params.targetIndexCount, maxCost, resultCost))
+            break;
+    }
+
+    std::copy(result.begin(), result.end(), destination);
+
+    if (outError)
+    {
+        float radius = simplifier.GetRadius();
+        *outError = radius > 0.f ? float(std::sqrt(resultCost)) / radius : 0.f;
+    }
+
+    return result.size();
+}
+
+uint32_t donut::engine::GenerateMeshLods(const std::vector<std::shared_ptr<MeshInfo>>& meshes, tf::Executor* executor,
+    const MeshLodParameters& params)
+{
+    struct GeometryLods
+    {
+        MeshInfo* mesh;
+        MeshGeometry* geometry;
+        size_t firstIndex;
+        size_t firstVertex;
+        std::vector<std::vector<uint32_t>> indices;
+        std::vector<float> errors;
+    };
+
+    std::vector<GeometryLods> geometries;
+    for (const auto& mesh : meshes)
+    {
+        if (!mesh || mesh->skinPrototype || !mesh->buffers)
+            continue;
+
+        const BufferGroup& buffers = *mesh->buffers;
+        if (buffers.indexBuffer || buffers.vertexBuffer)
+            continue;
+
+        for (const auto& geometry : mesh->geometries)
+        {
+            GeometryLods item;
+            item.mesh = mesh.get();
+            item.geometry = geometry.get();
+            item.firstIndex = size_t(mesh->indexOffset) + geometry->indexOffsetInMesh;
+            item.firstVertex = size_t(mesh->vertexOffset) + geometry->vertexOffsetInMesh;
+
+            if (!geometry->lods.empty() || geometry->numIndices / 3 < params.minTriangles ||
+                item.firstIndex + geometry->numIndices > buffers.indexData.size() ||
+                item.firstVertex + geometry->numVertices > buffers.positionData.size())
+                continue;
+
+            const uint32_t* indices = buffers.indexData.data() + item.firstIndex;
+            const uint32_t numVertices = geometry->numVertices;
+            if (std::any_of(indices, indices + geometry->numIndices, [numVertices](uint32_t index) { return index >= numVertices; }))
+                continue;
+
+            geometries.push_back(std::move(item));
+        }
+    }
+
+    ParallelFor(executor, uint32_t(geometries.size()), [&geometries, &params](uint32_t index)
+    {
+        GeometryLods& item = geometries[index];
+        const BufferGroup& buffers = *item.mesh->buffers;
+        const size_t numVertices = item.geometry->numVertices;
+        const float3* positions = buffers.positionData.data() + item.firstVertex;
+        const float2* texCoords = (buffers.texcoord1Data.size() >= item.firstVertex + numVertices)
+            ? buffers.texcoord1Data.data() + item.firstVertex
+            : nullptr;
+
+        const uint32_t* sourceIndices = buffers.indexData.data() + item.firstIndex;
+        std::vector<uint32_t> current(sourceIndices, sourceIndices + item.geometry->numIndices);
+        float totalError = 0.f;
+
+        for (uint32_t lod = 0; lod < params.maxLods; lod++)
+        {
+            const size_t numTriangles = current.size() / 3;
+            if (numTriangles < params.minTriangles)
+                break;
+
+            MeshSimplificationParameters simplification;
+            simplification.targetIndexCount = size_t(float(numTriangles) * params.reductionRatio) * 3;
+            simplification.targetError = params.maxErrorPerLod;
+            simplification.attributeWeight = params.attributeWeight;
+
+            std::vector<uint32_t> simplified(current.size());
+            float error = 0.f;
+            size_t numIndices = SimplifyMesh(simplified.data(), current.data(), current.size(),
+                positions, texCoords, numVertices, simplification, &error);
+
+            if (numIndices == 0 || float(numIndices) > float(current.size()) * (1.f - params.minReduction))
+                break;
+
+            simplified.resize(numIndices);
+            totalError += error;
+
+            std::vector<uint32_t> optimized(numIndices);
+            OptimizeVertexCache(optimized.data(), simplified.data(), numIndices, numVertices);
+
+            item.indices.push_back(std::move(optimized));
+            item.errors.push_back(totalError);
+            current = std::move(simplified);
+        }
+    });
+
+    uint32_t totalLods = 0;
+    for (GeometryLods& item : geometries)
+    {
+        BufferGroup& buffers = *item.mesh->buffers;
+
+        for (size_t lod = 0; lod < item.indices.size(); lod++)
+        {
+            MeshGeometryLod geometryLod;
+            geometryLod.indexOffsetInMesh = uint32_t(buffers.indexData.size() - item.mesh->indexOffset);
+            geometryLod.numIndices = uint32_t(item.indices[lod].size());
+            geometryLod.error = item.errors[lod];
+            item.geometry->lods.push_back(geometryLod);
+
+            buffers.indexData.insert(buffers.indexData.end(), item.indices[lod].begin(), item.indices[lod].end());
+        }
+
+        totalLods += uint32_t(item.indices.size());
+    }
+
+    return totalLods;
+}
+
+uint32_t donut::engine::SelectMeshLod(const MeshGeometry& geometry, float errorToPixels, uint32_t currentLod,
+    float maxPixelError, float hysteresis)
+{
+    for (uint32_t lod = uint32_t(geometry.lods.size()); lod > 0; lod--)
+    {
+        float threshold = maxPixelError * ((lod <= currentLod) ? 1.f + hysteresis : 1.f - hysteresis);
+        if (geometry.lods[lod - 1].error * errorToPixels <= threshold)
+            return lod;
+    }
+
+    return 0;
+}
@@ -0,0 +1,356 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MeshletBuilder.h>
+#include <donut/engine/ParallelFor.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace donut::math;
+using namespace donut::engine;
+
+bool donut::engine::BuildMeshlets(
+    const uint32_t* indices,
+    size_t numIndices,
+    const float3* positions,
+    size_t numVertices,
+    std::vector<Meshlet>& outMeshlets,
+    std::vector<uint32_t>& outIndexData,
+    uint32_t maxVertices,
+    uint32_t maxTriangles)
+{
+    assert(maxVertices >= 3 && maxVertices <= 256);
+    assert(maxTriangles >= 1);
+
+    const size_t numTriangles = numIndices / 3;
+
+    for (size_t i = 0; i < numTriangles * 3; i++)
+    {
+        if (indices[i] >= numVertices)
+            return false;
+    }
+
+    // Vertex to triangle adjacency, in the compressed sparse row form
+    std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+    for (size_t i = 0; i < numTriangles * 3; i++)
+        ++adjacencyOffsets[indices[i] + 1];
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+        adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+
+    std::vector<uint32_t> adjacency(numTriangles * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < numTriangles * 3; i++)
+            adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    std::vector<bool> emitted(numTriangles, false);
+    std::vector<int> localIndices(numVertices, -1);
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint32_t> meshletTriangles;
+    meshletVertices.reserve(maxVertices);
+    meshletTriangles.reserve(maxTriangles);
+
+    auto countNewVertices = [indices, &localIndices](size_t triangle)
+    {
+        const uint32_t a = indices[triangle * 3 + 0];
+        const uint32_t b = indices[triangle * 3 + 1];
+        const uint32_t c = indices[triangle * 3 + 2];
+        uint32_t count = 0;
+        if (localIndices[a] < 0) ++count;
+        if (localIndices[b] < 0 && b != a) ++count;
+        if (localIndices[c] < 0 && c != a && c != b) ++count;
+        return count;
+    };
+
+    auto flushMeshlet = [&]()
+    {
+        if (meshletTriangles.empty())
+            return;
+
+        Meshlet meshlet;
+        meshlet.vertexOffset = uint32_t(outIndexData.size());
+        meshlet.vertexCount = uint32_t(meshletVertices.size());
+        outIndexData.insert(outIndexData.end(), meshletVertices.begin(), meshletVertices.end());
+        meshlet.triangleOffset = uint32_t(outIndexData.size());
+        meshlet.triangleCount = uint32_t(meshletTriangles.size());
+        outIndexData.insert(outIndexData.end(), meshletTriangles.begin(), meshletTriangles.end());
+
+        ComputeMeshletBounds(meshlet, outIndexData.data(), positions);
+        outMeshlets.push_back(meshlet);
+
+        for (uint32_t vertex : meshletVertices)
+            localIndices[vertex] = -1;
+        meshletVertices.clear();
+        meshletTriangles.clear();
+    };
+
+    size_t nextSeed = 0;
+
+    for (size_t emittedCount = 0; emittedCount < numTriangles; emittedCount++)
+    {
+        // Pick the unused triangle that adds the fewest vertices to the current meshlet.
+        // Looking only at the triangles around the meshlet's vertices keeps the meshlet spatially coherent.
+        size_t best = numTriangles;
+        uint32_t bestNewVertices = 4;
+
+        for (uint32_t vertex : meshletVertices)
+        {
+            for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++)
+            {
+                const uint32_t triangle = adjacency[i];
+                if (emitted[triangle])
+                    continue;
+
+                const uint32_t newVertices = countNewVertices(triangle);
+                if (newVertices < bestNewVertices || (newVertices == bestNewVertices && triangle < best))
+                {
+                    best = triangle;
+                    bestNewVertices = newVertices;
+                }
+            }
+        }
+
+        // Nothing connected to the meshlet is left, continue with the next triangle in the index order
+        if (best == numTriangles)
+        {
+            while (emitted[nextSeed])
+                ++nextSeed;
+            best = nextSeed;
+            bestNewVertices = countNewVertices(best);
+        }
+
+        if (meshletVertices.size() + bestNewVertices > maxVertices || meshletTriangles.size() >= maxTriangles)
+            flushMeshlet();
+
+        uint32_t packedTriangle = 0;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t vertex = indices[best * 3 + corner];
+            if (localIndices[vertex] < 0)
+            {
+                localIndices[vertex] = int(meshletVertices.size());
+                meshletVertices.push_back(vertex);
+            }
+            packedTriangle |= uint32_t(localIndices[vertex]) << (corner * 8);
+        }
+
+        meshletTriangles.push_back(packedTriangle);
+        emitted[best] = true;
+    }
+
+    flushMeshlet();
+
+    return true;
+}
+
+void donut::engine::ComputeMeshletBounds(Meshlet& meshlet, const uint32_t* meshletIndexData, const float3* positions)
+{
+    const uint32_t* vertexIndices = meshletIndexData + meshlet.vertexOffset;
+    const uint32_t* triangles = meshletIndexData + meshlet.triangleOffset;
+
+    meshlet.center = 0.f;
+    meshlet.radius = 0.f;
+    meshlet.coneAxis = 0.f;
+    meshlet.coneCutoff = 1.f;
+
+    if (meshlet.vertexCount == 0)
+        return;
+
+    // Ritter's bounding sphere: start from two distant points, then grow the sphere to include the outliers
+    auto findFarthest = [&](const float3& from)
+    {
+        float3 farthest = from;
+        float maxDistance = -1.f;
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            const float3& p = positions[vertexIndices[i]];
+            float distance = lengthSquared(p - from);
+            if (distance > maxDistance)
+            {
+                maxDistance = distance;
+                farthest = p;
+            }
+        }
+        return farthest;
+    };
+
+    const float3 a = findFarthest(positions[vertexIndices[0]]);
+    const float3 b = findFarthest(a);
+    float3 center = (a + b) * 0.5f;
+    float radius = length(b - a) * 0.5f;
+
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        const float3& p = positions[vertexIndices[i]];
+        float distance = length(p - center);
+        if (distance > radius)
+        {
+            float newRadius = (radius + distance) * 0.5f;
+            center += (p - center) * ((newRadius - radius) / distance);
+            radius = newRadius;
+        }
+    }
+
+    // Absorb the rounding errors so that the sphere is guaranteed to contain all vertices
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+        radius = std::max(radius, length(positions[vertexIndices[i]] - center));
+
+    meshlet.center = center;
+    meshlet.radius = radius;
+
+    // Normal cone: the axis is the average of the unit triangle normals, and the spread is the
+    // largest angle between the axis and a normal. Degenerate triangles don't contribute.
+    auto getTriangleNormal = [&](uint32_t triangle, float3& normal)
+    {
+        const uint32_t packed = triangles[triangle];
+        const float3& p0 = positions[vertexIndices[packed & 0xff]];
+        const float3& p1 = positions[vertexIndices[(packed >> 8) & 0xff]];
+        const float3& p2 = positions[vertexIndices[(packed >> 16) & 0xff]];
+        normal = cross(p1 - p0, p2 - p0);
+        float normalLength = length(normal);
+        if (!(normalLength > 0.f) || !std::isfinite(normalLength))
+            return false;
+        normal /= normalLength;
+        return true;
+    };
+
+    float3 normalSum = 0.f;
+    uint32_t validTriangles = 0;
+    for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+    {
+        float3 normal;
+        if (getTriangleNormal(triangle, normal))
+        {
+            normalSum += normal;
+            ++validTriangles;
+        }
+    }
+
+    const float axisLength = length(normalSum);
+    if (validTriangles == 0 || !(axisLength > 0.f))
+        return;
+
+    const float3 axis = normalSum / axisLength;
+    float minDot = 1.f;
+    for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+    {
+        float3 normal;
+        if (getTriangleNormal(triangle, normal))
+            minDot = std::min(minDot, dot(normal, axis));
+    }
+
+    meshlet.coneAxis = axis;
+
+    // Cones wider than a hemisphere can never be entirely backfacing
+    if (minDot <= 0.f)
+        return;
+
+    meshlet.coneCutoff = std::sqrt(std::max(0.f, 1.f - minDot * minDot));
+}
+
+bool donut::engine::IsMeshletBackfacing(const Meshlet& meshlet, const float3& viewPosition)
+{
+    if (meshlet.coneCutoff >= 1.f)
+        return false;
+
+    const float3 toCenter = meshlet.center - viewPosition;
+    return dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * length(toCenter) + meshlet.radius;
+}
+
+void donut::engine::BuildMeshletsForMeshes(const std::vector<std::shared_ptr<MeshInfo>>& meshes, tf::Executor* executor)
+{
+    std::vector<MeshInfo*> eligibleMeshes;
+    for (const auto& mesh : meshes)
+    {
+        if (!mesh || mesh->skinPrototype || !mesh->buffers)
+            continue;
+
+        const BufferGroup& buffers = *mesh->buffers;
+        if (!buffers.meshlets.empty() || buffers.meshletBuffer || buffers.indexData.empty() || buffers.positionData.empty())
+            continue;
+
+        eligibleMeshes.push_back(mesh.get());
+    }
+
+    struct MeshMeshlets
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> indexData;
+        std::vector<uint32_t> geometryMeshletCounts;
+    };
+
+    std::vector<MeshMeshlets> results(eligibleMeshes.size());
+
+    ParallelFor(executor, uint32_t(eligibleMeshes.size()), [&eligibleMeshes, &results](uint32_t index)
+    {
+        const MeshInfo& mesh = *eligibleMeshes[index];
+        const BufferGroup& buffers = *mesh.buffers;
+        MeshMeshlets& result = results[index];
+
+        for (const auto& geometry : mesh.geometries)
+        {
+            const size_t firstIndex = size_t(mesh.indexOffset) + geometry->indexOffsetInMesh;
+            const size_t firstVertex = size_t(mesh.vertexOffset) + geometry->vertexOffsetInMesh;
+            const size_t meshletsBefore = result.meshlets.size();
+
+            if (firstIndex + geometry->numIndices <= buffers.indexData.size() &&
+                firstVertex + geometry->numVertices <= buffers.positionData.size())
+            {
+                BuildMeshlets(buffers.indexData.data() + firstIndex, geometry->numIndices,
+                    buffers.positionData.data() + firstVertex, geometry->numVertices,
+                    result.meshlets, result.indexData);
+            }
+
+            result.geometryMeshletCounts.push_back(uint32_t(result.meshlets.size() - meshletsBefore));
+        }
+    });
+
+    for (size_t index = 0; index < eligibleMeshes.size(); index++)
+    {
+        MeshInfo& mesh = *eligibleMeshes[index];
+        BufferGroup& buffers = *mesh.buffers;
+        const MeshMeshlets& result = results[index];
+
+        const uint32_t meshletBase = uint32_t(buffers.meshlets.size());
+        const uint32_t indexDataBase = uint32_t(buffers.meshletIndexData.size());
+
+        for (Meshlet meshlet : result.meshlets)
+        {
+            meshlet.vertexOffset += indexDataBase;
+            meshlet.triangleOffset += indexDataBase;
+            buffers.meshlets.push_back(meshlet);
+        }
+        buffers.meshletIndexData.insert(buffers.meshletIndexData.end(), result.indexData.begin(), result.indexData.end());
+
+        uint32_t firstMeshlet = meshletBase;
+        for (size_t geometryIndex = 0; geometryIndex < mesh.geometries.size(); geometryIndex++)
+        {
+            MeshGeometry& geometry = *mesh.geometries[geometryIndex];
+            geometry.firstMeshlet = firstMeshlet;
+            geometry.numMeshlets = result.geometryMeshletCounts[geometryIndex];
+            firstMeshlet += geometry.numMeshlets;
+        }
+    }
+}
@@ -0,0 +1,659 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MipGenerator.h>
+#include <donut/engine/ParallelFor.h>
+#include <donut/core/math/math.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DONUT_MIPGEN_SSE2 1
+#include <emmintrin.h>
+#else
+#define DONUT_MIPGEN_SSE2 0
+#endif
+
+using namespace donut::engine;
+
+namespace
+{
+    // All filtering happens on rows of RGBA float pixels.
+    constexpr uint32_t c_WorkChannels = 4;
+
+    // Number of destination rows processed by one task.
+    constexpr uint32_t c_RowsPerTile = 32;
+
+    struct PixelFormatDesc
+    {
+        uint32_t channels = 0;
+        uint32_t bytesPerChannel = 0;
+        bool isFloat = false;
+        bool sRGB = false;
+
+        [[nodiscard]] size_t BytesPerPixel() const { return size_t(channels) * bytesPerChannel; }
+    };
+
+    bool GetPixelFormatDesc(nvrhi::Format format, bool sRGB, PixelFormatDesc& desc)
+    {
+        switch (format)
+        {
+        case nvrhi::Format::R8_UNORM:     desc = { 1, 1, false, false }; return true;
+        case nvrhi::Format::RG8_UNORM:    desc = { 2, 1, false, false }; return true;
+        case nvrhi::Format::RGBA8_UNORM:  desc = { 4, 1, false, sRGB }; return true;
+        case nvrhi::Format::SRGBA8_UNORM: desc = { 4, 1, false, true }; return true;
+        case nvrhi::Format::R32_FLOAT:    desc = { 1, 4, true, false }; return true;
+        case nvrhi::Format::RG32_FLOAT:   desc = { 2, 4, true, false }; return true;
+        case nvrhi::Format::RGBA32_FLOAT: desc = { 4, 4, true, false }; return true;
+        default: return false;
+        }
+    }
+
+    struct SrgbTables
+    {
+        // sRGB byte -> linear float
+        float decode[256];
+
+        // Linear value quantized to 16 bits -> sRGB byte. The quantization error is well below
+        // the distance between the linear values of adjacent sRGB codes, even near black.
+        uint8_t encode[65536];
+
+        SrgbTables()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                float c = float(i) / 255.f;
+                decode[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (int i = 0; i < 65536; i++)
+            {
+                float l = float(i) / 65535.f;
+                float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+                encode[i] = uint8_t(std::clamp(c * 255.f + 0.5f, 0.f, 255.f));
+            }
+        }
+    };
+
+    const SrgbTables& GetSrgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    // Filter weights for one dimension: each destination texel reads 'count' consecutive
+    // source texels starting at 'first', with weights stored at 'weightOffset'.
+    struct FilterContributor
+    {
+        uint32_t first = 0;
+        uint32_t count = 0;
+        size_t weightOffset = 0;
+    };
+
+    struct FilterKernel
+    {
+        std::vector<FilterContributor> contributors;
+        std::vector<float> weights;
+    };
+
+    float Sinc(float x)
+    {
+        if (std::abs(x) < 1e-4f)
+            return 1.f;
+        x *= donut::math::PI_f;
+        return std::sin(x) / x;
+    }
+
+    // Zeroth order modified Bessel function of the first kind
+    float BesselI0(float x)
+    {
+        float sum = 1.f;
+        float term = 1.f;
+        float y = x * x * 0.25f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; k++)
+        {
+            term *= y / float(k * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    void BuildFilterKernel(uint32_t srcSize, uint32_t dstSize, const MipGenerationParams& params, FilterKernel& kernel)
+    {
+        kernel.contributors.resize(dstSize);
+        kernel.weights.clear();
+
+        const float scale = float(srcSize) / float(dstSize);
+        const float filterScale = std::max(scale, 1.f);
+        const float kaiserRadius = std::max(params.kaiserWidth, 0.5f) * filterScale;
+        const float kaiserNorm = 1.f / BesselI0(params.kaiserAlpha);
+
+        std::vector<float> taps;
+
+        for (uint32_t x = 0; x < dstSize; x++)
+        {
+            int tapBegin, tapEnd;
+            float center = 0.f, lo = 0.f, hi = 0.f;
+
+            if (params.filter == MipFilter::Box)
+            {
+                lo = float(x) * scale;
+                hi = float(x + 1) * scale;
+                tapBegin = int(std::floor(lo));
+                tapEnd = std::max(int(std::ceil(hi)), tapBegin + 1);
+            }
+            else
+            {
+                center = (float(x) + 0.5f) * scale - 0.5f;
+                tapBegin = int(std::ceil(center - kaiserRadius));
+                tapEnd = int(std::floor(center + kaiserRadius)) + 1;
+            }
+
+            // Clamp-to-edge addressing: weights of taps outside of the image go to the edge texels.
+            uint32_t first = uint32_t(std::clamp(tapBegin, 0, int(srcSize) - 1));
+            uint32_t last = uint32_t(std::clamp(tapEnd - 1, 0, int(srcSize) - 1));
+            taps.assign(last - first + 1, 0.f);
+
+            float sum = 0.f;
+            for (int i = tapBegin; i < tapEnd; i++)
+            {
+                float w;
+                if (params.filter == MipFilter::Box)
+                {
+                    w = std::min(hi, float(i + 1)) - std::max(lo, float(i));
+                }
+                else
+                {
+                    float t = (float(i) - center) / filterScale;
+                    float k = (float(i) - center) / kaiserRadius;
+                    w = Sinc(t) * BesselI0(params.kaiserAlpha * std::sqrt(std::max(0.f, 1.f - k * k))) * kaiserNorm;
+                }
+
+                if (w == 0.f)
+                    continue;
+
+                taps[uint32_t(std::clamp(i, 0, int(srcSize) - 1)) - first] += w;
+                sum += w;
+            }
+
+            if (sum == 0.f)
+            {
+                // Degenerate kernel, fall back to point sampling
+                taps.assign(1, 1.f);
+                sum = 1.f;
+            }
+
+            FilterContributor& contributor = kernel.contributors[x];
+            contributor.first = first;
+            contributor.count = uint32_t(taps.size());
+            contributor.weightOffset = kernel.weights.size();
+
+            for (float w : taps)
+                kernel.weights.push_back(w / sum);
+        }
+    }
+
+    // Describes an image that is read row by row: either encoded pixels in one of the supported formats,
+    // or linear RGBA float pixels from a previous pass.
+    struct ImageSource
+    {
+        const uint8_t* data = nullptr;
+        size_t rowPitch = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        PixelFormatDesc format;
+        const float* linearData = nullptr;
+    };
+
+    // Returns a pointer to the row in the RGBA float working format, decoding it into 'scratch' if necessary.
+    const float* GetSourceRow(const ImageSource& src, uint32_t y, float* scratch)
+    {
+        if (src.linearData)
+            return src.linearData + size_t(y) * src.width * c_WorkChannels;
+
+        const uint8_t* row = src.data + size_t(y) * src.rowPitch;
+        const uint32_t channels = src.format.channels;
+        float* out = scratch;
+
+        if (src.format.isFloat && channels == c_WorkChannels)
+            return reinterpret_cast<const float*>(row);
+
+        if (src.format.isFloat)
+        {
+            const float* in = reinterpret_cast<const float*>(row);
+            for (uint32_t x = 0; x < src.width; x++, in += channels, out += c_WorkChannels)
+            {
+                out[0] = in[0];
+                out[1] = channels > 1 ? in[1] : 0.f;
+                out[2] = channels > 2 ? in[2] : 0.f;
+                out[3] = channels > 3 ? in[3] : 1.f;
+            }
+        }
+        else if (src.format.sRGB)
+        {
+            const float* decode = GetSrgbTables().decode;
+            for (uint32_t x = 0; x < src.width; x++, row += 4, out += c_WorkChannels)
+            {
+                out[0] = decode[row[0]];
+                out[1] = decode[row[1]];
+                out[2] = decode[row[2]];
+                out[3] = float(row[3]) * (1.f / 255.f);
+            }
+        }
+#if DONUT_MIPGEN_SSE2
+        else if (channels == 4)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 scale = _mm_set1_ps(1.f / 255.f);
+            for (uint32_t x = 0; x < src.width; x++, row += 4, out += c_WorkChannels)
+            {
+                int packed;
+                memcpy(&packed, row, 4);
+                __m128i i32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+                _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(i32), scale));
+            }
+        }
+#endif
+        else
+        {
+            for (uint32_t x = 0; x < src.width; x++, row += channels, out += c_WorkChannels)
+            {
+                out[0] = float(row[0]) * (1.f / 255.f);
+                out[1] = channels > 1 ? float(row[1]) * (1.f / 255.f) : 0.f;
+                out[2] = channels > 2 ? float(row[2]) * (1.f / 255.f) : 0.f;
+                out[3] = channels > 3 ? float(row[3]) * (1.f / 255.f) : 1.f;
+            }
+        }
+
+        return scratch;
+    }
+
+    void FilterRowHorizontal(const float* src, float* dst, const FilterKernel& kernel)
+    {
+        const float* weights = kernel.weights.data();
+
+        for (const FilterContributor& contributor : kernel.contributors)
+        {
+            const float* in = src + size_t(contributor.first) * c_WorkChannels;
+            const float* w = weights + contributor.weightOffset;
+#if DONUT_MIPGEN_SSE2
+            __m128 acc = _mm_mul_ps(_mm_loadu_ps(in), _mm_set1_ps(w[0]));
+            for (uint32_t i = 1; i < contributor.count; i++)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(in + i * c_WorkChannels), _mm_set1_ps(w[i])));
+            _mm_storeu_ps(dst, acc);
+#else
+            float acc[c_WorkChannels] = {};
+            for (uint32_t i = 0; i < contributor.count; i++)
+                for (uint32_t c = 0; c < c_WorkChannels; c++)
+                    acc[c] += in[i * c_WorkChannels + c] * w[i];
+            memcpy(dst, acc, sizeof(acc));
+#endif
+            dst += c_WorkChannels;
+        }
+    }
+
+    // dst[i] = a[i] * weightA + b[i] * weightB, for rows of 'count' floats (a multiple of 4).
+    // Vertical filtering consumes the source rows in pairs, which halves the number of passes over the destination row.
+    void BlendRows(float* dst, const float* a, float weightA, const float* b, float weightB, size_t count)
+    {
+        size_t i = 0;
+#if DONUT_MIPGEN_SSE2
+        const __m128 wa = _mm_set1_ps(weightA);
+        const __m128 wb = _mm_set1_ps(weightB);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), wa), _mm_mul_ps(_mm_loadu_ps(b + i), wb));
+            __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i + 4), wa), _mm_mul_ps(_mm_loadu_ps(b + i + 4), wb));
+            _mm_storeu_ps(dst + i, x);
+            _mm_storeu_ps(dst + i + 4, y);
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = a[i] * weightA + b[i] * weightB;
+    }
+
+    // dst[i] += a[i] * weightA + b[i] * weightB
+    void AccumulateRows(float* dst, const float* a, float weightA, const float* b, float weightB, size_t count)
+    {
+        size_t i = 0;
+#if DONUT_MIPGEN_SSE2
+        const __m128 wa = _mm_set1_ps(weightA);
+        const __m128 wb = _mm_set1_ps(weightB);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), wa), _mm_mul_ps(_mm_loadu_ps(b + i), wb));
+            __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i + 4), wa), _mm_mul_ps(_mm_loadu_ps(b + i + 4), wb));
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), x));
+            _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_loadu_ps(dst + i + 4), y));
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] += a[i] * weightA + b[i] * weightB;
+    }
+
+    void EncodeRow(const float* src, uint8_t* dst, uint32_t width, const PixelFormatDesc& format)
+    {
+        const uint32_t channels = format.channels;
+
+        if (format.isFloat)
+        {
+            float* out = reinterpret_cast<float*>(dst);
+            for (uint32_t x = 0; x < width; x++, src += c_WorkChannels, out += channels)
+                for (uint32_t c = 0; c < channels; c++)
+                    out[c] = src[c];
+        }
+        else if (format.sRGB)
+        {
+            const uint8_t* encode = GetSrgbTables().encode;
+#if DONUT_MIPGEN_SSE2
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.f);
+            const __m128 scale = _mm_setr_ps(65535.f, 65535.f, 65535.f, 255.f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            for (uint32_t x = 0; x < width; x++, src += c_WorkChannels, dst += 4)
+            {
+                __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), zero), one);
+                alignas(16) int32_t indices[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half)));
+                dst[0] = encode[indices[0]];
+                dst[1] = encode[indices[1]];
+                dst[2] = encode[indices[2]];
+                dst[3] = uint8_t(indices[3]);
+            }
+#else
+            for (uint32_t x = 0; x < width; x++, src += c_WorkChannels, dst += 4)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                    dst[c] = encode[int(std::clamp(src[c], 0.f, 1.f) * 65535.f + 0.5f)];
+                dst[3] = uint8_t(std::clamp(src[3], 0.f, 1.f) * 255.f + 0.5f);
+            }
+#endif
+        }
+#if DONUT_MIPGEN_SSE2
+        else if (channels == 4)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.f);
+            const __m128 scale = _mm_set1_ps(255.f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            for (uint32_t x = 0; x < width; x++, src += c_WorkChannels, dst += 4)
+            {
+                __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), zero), one);
+                __m128i i32 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+                __m128i i16 = _mm_packs_epi32(i32, i32);
+                int packed = _mm_cvtsi128_si32(_mm_packus_epi16(i16, i16));
+                memcpy(dst, &packed, 4);
+            }
+        }
+#endif
+        else
+        {
+            for (uint32_t x = 0; x < width; x++, src += c_WorkChannels, dst += channels)
+                for (uint32_t c = 0; c < channels; c++)
+                    dst[c] = uint8_t(std::clamp(src[c], 0.f, 1.f) * 255.f + 0.5f);
+        }
+    }
+
+    // Fast path for the common case of box filtering with an exact 2:1 ratio in both dimensions:
+    // every destination texel is the average of a 2x2 source block.
+    void DownsampleBox2x(const ImageSource& src, uint32_t dstWidth, uint32_t dstHeight, tf::Executor* executor,
+        float* outLinear, uint8_t* outEncoded, size_t outRowPitch, const PixelFormatDesc& outFormat)
+    {
+        const size_t dstRowFloats = size_t(dstWidth) * c_WorkChannels;
+        const uint32_t numTiles = (dstHeight + c_RowsPerTile - 1) / c_RowsPerTile;
+
+        ParallelFor(executor, numTiles, [&](uint32_t tile)
+        {
+            const uint32_t rowBegin = tile * c_RowsPerTile;
+            const uint32_t rowEnd = std::min(rowBegin + c_RowsPerTile, dstHeight);
+
+            static thread_local std::vector<float> scratch;
+            static thread_local std::vector<float> accumulator;
+            scratch.resize(std::max(scratch.size(), size_t(src.width) * c_WorkChannels * 2));
+            accumulator.resize(std::max(accumulator.size(), dstRowFloats));
+
+            for (uint32_t y = rowBegin; y < rowEnd; y++)
+            {
+                const float* row0 = GetSourceRow(src, y * 2, scratch.data());
+                const float* row1 = GetSourceRow(src, y * 2 + 1, scratch.data() + size_t(src.width) * c_WorkChannels);
+                float* dstRow = outLinear ? outLinear + size_t(y) * dstRowFloats : accumulator.data();
+
+                for (uint32_t x = 0; x < dstWidth; x++)
+                {
+                    const size_t offset = size_t(x) * 2 * c_WorkChannels;
+#if DONUT_MIPGEN_SSE2
+                    __m128 sum = _mm_add_ps(
+                        _mm_add_ps(_mm_loadu_ps(row0 + offset), _mm_loadu_ps(row0 + offset + c_WorkChannels)),
+                        _mm_add_ps(_mm_loadu_ps(row1 + offset), _mm_loadu_ps(row1 + offset + c_WorkChannels)));
+                    _mm_storeu_ps(dstRow + x * c_WorkChannels, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+                    for (uint32_t c = 0; c < c_WorkChannels; c++)
+                    {
+                        dstRow[x * c_WorkChannels + c] = 0.25f * (row0[offset + c] + row0[offset + c_WorkChannels + c]
+                            + row1[offset + c] + row1[offset + c_WorkChannels + c]);
+                    }
+#endif
+                }
+
+                if (outEncoded)
+                    EncodeRow(dstRow, outEncoded + size_t(y) * outRowPitch, dstWidth, outFormat);
+            }
+        });
+    }
+
+    // Resamples the source into a dstWidth x dstHeight image, writing the linear RGBA float result into 'outLinear'
+    // and/or the encoded result into 'outEncoded'. Each tile of destination rows filters the source rows it needs
+    // horizontally into a private buffer and then filters that buffer vertically, so the tiles are independent.
+    void Resample(const ImageSource& src, uint32_t dstWidth, uint32_t dstHeight, const MipGenerationParams& params,
+        float* outLinear, uint8_t* outEncoded, size_t outRowPitch, const PixelFormatDesc& outFormat)
+    {
+        if (params.filter == MipFilter::Box && src.width == dstWidth * 2 && src.height == dstHeight * 2)
+        {
+            DownsampleBox2x(src, dstWidth, dstHeight, params.executor, outLinear, outEncoded, outRowPitch, outFormat);
+            return;
+        }
+
+        FilterKernel kernelX, kernelY;
+        BuildFilterKernel(src.width, dstWidth, params, kernelX);
+        BuildFilterKernel(src.height, dstHeight, params, kernelY);
+
+        const size_t dstRowFloats = size_t(dstWidth) * c_WorkChannels;
+        const uint32_t numTiles = (dstHeight + c_RowsPerTile - 1) / c_RowsPerTile;
+
+        ParallelFor(params.executor, numTiles, [&](uint32_t tile)
+        {
+            const uint32_t rowBegin = tile * c_RowsPerTile;
+            const uint32_t rowEnd = std::min(rowBegin + c_RowsPerTile, dstHeight);
+
+            uint32_t srcRowBegin = src.height;
+            uint32_t srcRowEnd = 0;
+            for (uint32_t y = rowBegin; y < rowEnd; y++)
+            {
+                const FilterContributor& contributor = kernelY.contributors[y];
+                srcRowBegin = std::min(srcRowBegin, contributor.first);
+                srcRowEnd = std::max(srcRowEnd, contributor.first + contributor.count);
+            }
+
+            // Per-thread buffers are reused between tiles and calls, every element is written before it's read.
+            static thread_local std::vector<float> scratch;
+            static thread_local std::vector<float> horizontal;
+            static thread_local std::vector<float> accumulator;
+            scratch.resize(std::max(scratch.size(), size_t(src.width) * c_WorkChannels));
+            horizontal.resize(std::max(horizontal.size(), size_t(srcRowEnd - srcRowBegin) * dstRowFloats));
+            accumulator.resize(std::max(accumulator.size(), dstRowFloats));
+
+            for (uint32_t y = srcRowBegin; y < srcRowEnd; y++)
+            {
+                const float* srcRow = GetSourceRow(src, y, scratch.data());
+                FilterRowHorizontal(srcRow, horizontal.data() + size_t(y - srcRowBegin) * dstRowFloats, kernelX);
+            }
+
+            for (uint32_t y = rowBegin; y < rowEnd; y++)
+            {
+                float* dstRow = outLinear ? outLinear + size_t(y) * dstRowFloats : accumulator.data();
+
+                const FilterContributor& contributor = kernelY.contributors[y];
+                const float* weights = kernelY.weights.data() + contributor.weightOffset;
+                auto getRow = [&](uint32_t i)
+                {
+                    // Odd tap counts are padded with a zero-weight tap that re-reads the first row
+                    i = (i < contributor.count) ? i : 0;
+                    return horizontal.data() + size_t(contributor.first + i - srcRowBegin) * dstRowFloats;
+                };
+                auto getWeight = [&](uint32_t i) { return (i < contributor.count) ? weights[i] : 0.f; };
+
+                BlendRows(dstRow, getRow(0), getWeight(0), getRow(1), getWeight(1), dstRowFloats);
+                for (uint32_t i = 2; i < contributor.count; i += 2)
+                    AccumulateRows(dstRow, getRow(i), getWeight(i), getRow(i + 1), getWeight(i + 1), dstRowFloats);
+
+                if (outEncoded)
+                    EncodeRow(dstRow, outEncoded + size_t(y) * outRowPitch, dstWidth, outFormat);
+            }
+        });
+    }
+}
+
+bool MipGenerator::IsFormatSupported(nvrhi::Format format)
+{
+    PixelFormatDesc desc;
+    return GetPixelFormatDesc(format, false, desc);
+}
+
+uint32_t MipGenerator::GetFullMipChainLength(uint32_t width, uint32_t height)
+{
+    uint32_t size = std::max(std::max(width, height), 1u);
+    uint32_t levels = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        ++levels;
+    }
+    return levels;
+}
+
+bool MipGenerator::ResizeImage(
+    const void* srcData, uint32_t srcWidth, uint32_t srcHeight, size_t srcRowPitch,
+    void* dstData, uint32_t dstWidth, uint32_t dstHeight, size_t dstRowPitch,
+    nvrhi::Format format, const MipGenerationParams& params)
+{
+    ImageSource src;
+    if (!GetPixelFormatDesc(format, params.sRGB, src.format))
+        return false;
+
+    if (!srcData || !dstData || srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0)
+        return false;
+
+    src.data = static_cast<const uint8_t*>(srcData);
+    src.rowPitch = srcRowPitch;
+    src.width = srcWidth;
+    src.height = srcHeight;
+
+    Resample(src, dstWidth, dstHeight, params, nullptr, static_cast<uint8_t*>(dstData), dstRowPitch, src.format);
+
+    return true;
+}
+
+bool MipGenerator::GenerateMipChain(
+    const void* srcData, uint32_t srcWidth, uint32_t srcHeight, size_t srcRowPitch,
+    nvrhi::Format format, const MipGenerationParams& params,
+    std::vector<uint8_t>& outData, std::vector<MipLevelLayout>& outLayout)
+{
+    PixelFormatDesc formatDesc;
+    if (!GetPixelFormatDesc(format, params.sRGB, formatDesc))
+        return false;
+
+    if (!srcData || srcWidth == 0 || srcHeight == 0)
+        return false;
+
+    uint32_t mipLevels = GetFullMipChainLength(srcWidth, srcHeight);
+    if (params.maxMipLevels != 0)
+        mipLevels = std::min(mipLevels, params.maxMipLevels);
+
+    const size_t bytesPerPixel = formatDesc.BytesPerPixel();
+
+    outLayout.resize(mipLevels);
+    size_t totalSize = 0;
+    for (uint32_t mipLevel = 0; mipLevel < mipLevels; mipLevel++)
+    {
+        MipLevelLayout& layout = outLayout[mipLevel];
+        layout.width = std::max(srcWidth >> mipLevel, 1u);
+        layout.height = std::max(srcHeight >> mipLevel, 1u);
+        layout.rowPitch = layout.width * bytesPerPixel;
+        layout.dataSize = layout.rowPitch * layout.height;
+        layout.dataOffset = totalSize;
+        totalSize += layout.dataSize;
+    }
+
+    outData.resize(totalSize);
+
+    const uint8_t* srcBytes = static_cast<const uint8_t*>(srcData);
+    for (uint32_t y = 0; y < srcHeight; y++)
+        memcpy(outData.data() + y * outLayout[0].rowPitch, srcBytes + y * srcRowPitch, outLayout[0].rowPitch);
+
+    // The first filtered level reads the encoded source, the following ones read the linear result of the previous level.
+    // The linear levels are kept in one uninitialized allocation to avoid clearing memory that is about to be overwritten.
+    size_t linearSize = 0;
+    for (uint32_t mipLevel = 1; mipLevel + 1 < mipLevels; mipLevel++)
+        linearSize += size_t(outLayout[mipLevel].width) * outLayout[mipLevel].height * c_WorkChannels;
+
+    std::unique_ptr<float[]> linearData(linearSize ? new float[linearSize] : nullptr);
+    const float* previousLevel = nullptr;
+    float* currentLevel = linearData.get();
+
+    for (uint32_t mipLevel = 1; mipLevel < mipLevels; mipLevel++)
+    {
+        const MipLevelLayout& srcLayout = outLayout[mipLevel - 1];
+        const MipLevelLayout& dstLayout = outLayout[mipLevel];
+
+        ImageSource src;
+        src.width = srcLayout.width;
+        src.height = srcLayout.height;
+        src.format = formatDesc;
+        if (mipLevel == 1)
+        {
+            src.data = srcBytes;
+            src.rowPitch = srcRowPitch;
+        }
+        else
+        {
+            src.linearData = previousLevel;
+        }
+
+        const bool keepLinear = mipLevel + 1 < mipLevels;
+
+        Resample(src, dstLayout.width, dstLayout.height, params,
+            keepLinear ? currentLevel : nullptr,
+            outData.data() + dstLayout.dataOffset, dstLayout.rowPitch, formatDesc);
+
+        if (keepLinear)
+        {
+            previousLevel = currentLevel;
+            currentLevel += size_t(dstLayout.width) * dstLayout.height * c_WorkChannels;
+        }
+    }
+
+    return true;
+}
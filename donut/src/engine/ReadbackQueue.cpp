@@ -0,0 +1,304 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/ReadbackQueue.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace donut::engine;
+
+ReadbackQueue::ReadbackQueue(nvrhi::IDevice* device)
+    : m_Device(device)
+{
+    m_Worker = std::thread(&ReadbackQueue::WorkerThreadProc, this);
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WorkerMutex);
+        m_Terminate = true;
+    }
+    m_WorkerCondition.notify_all();
+    m_Worker.join();
+}
+
+nvrhi::BufferHandle ReadbackQueue::AcquireBuffer(uint64_t size)
+{
+    // Pick the smallest pooled buffer that fits
+    auto best = m_FreeBuffers.end();
+    for (auto it = m_FreeBuffers.begin(); it != m_FreeBuffers.end(); ++it)
+    {
+        uint64_t byteSize = (*it)->getDesc().byteSize;
+        if (byteSize >= size && (best == m_FreeBuffers.end() || byteSize < (*best)->getDesc().byteSize))
+            best = it;
+    }
+
+    if (best != m_FreeBuffers.end())
+    {
+        nvrhi::BufferHandle buffer = *best;
+        m_FreeBuffers.erase(best);
+        return buffer;
+    }
+
+    // Round up the sizes so that similar requests can share buffers
+    nvrhi::BufferDesc desc;
+    desc.byteSize = std::max<uint64_t>((size + 255) & ~uint64_t(255), 256);
+    desc.cpuAccess = nvrhi::CpuAccessMode::Read;
+    desc.initialState = nvrhi::ResourceStates::CopyDest;
+    desc.keepInitialState = true;
+    desc.debugName = "ReadbackQueue/Buffer";
+    return m_Device->createBuffer(desc);
+}
+
+nvrhi::StagingTextureHandle ReadbackQueue::AcquireTexture(const nvrhi::TextureDesc& desc)
+{
+    for (auto it = m_FreeTextures.begin(); it != m_FreeTextures.end(); ++it)
+    {
+        const nvrhi::TextureDesc& pooledDesc = (*it)->getDesc();
+        if (pooledDesc.width == desc.width && pooledDesc.height == desc.height && pooledDesc.format == desc.format)
+        {
+            nvrhi::StagingTextureHandle texture = *it;
+            m_FreeTextures.erase(it);
+            return texture;
+        }
+    }
+
+    return m_Device->createStagingTexture(desc, nvrhi::CpuAccessMode::Read);
+}
+
+void ReadbackQueue::RequestBuffer(nvrhi::ICommandList* commandList, nvrhi::IBuffer* buffer, uint64_t offset, uint64_t size, BufferCallback callback)
+{
+    assert(buffer);
+    assert(offset + size <= buffer->getDesc().byteSize);
+
+    Request request;
+    request.size = size;
+    request.bufferCallback = std::move(callback);
+    request.commandList = commandList;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        request.buffer = AcquireBuffer(size);
+    }
+
+    commandList->copyBuffer(request.buffer, 0, buffer, offset, size);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_NewRequests.push_back(std::move(request));
+}
+
+void ReadbackQueue::RequestTexture(nvrhi::ICommandList* commandList, nvrhi::ITexture* texture, const nvrhi::TextureSlice& slice, TextureCallback callback)
+{
+    assert(texture);
+
+    const nvrhi::TextureDesc& textureDesc = texture->getDesc();
+    nvrhi::TextureSlice resolvedSlice = slice.resolve(textureDesc);
+
+    Request request;
+    request.textureDesc.width = resolvedSlice.width;
+    request.textureDesc.height = resolvedSlice.height;
+    request.textureDesc.format = textureDesc.format;
+    request.textureDesc.dimension = nvrhi::TextureDimension::Texture2D;
+    request.textureDesc.debugName = "ReadbackQueue/Texture";
+    request.textureCallback = std::move(callback);
+    request.commandList = commandList;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        request.texture = AcquireTexture(request.textureDesc);
+    }
+
+    commandList->copyTexture(request.texture, nvrhi::TextureSlice(), texture, resolvedSlice);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_NewRequests.push_back(std::move(request));
+}
+
+void ReadbackQueue::CompleteRequest(Request& request)
+{
+    if (request.buffer)
+    {
+        const void* data = m_Device->mapBuffer(request.buffer, nvrhi::CpuAccessMode::Read);
+        if (request.bufferCallback)
+            request.bufferCallback(data, data ? size_t(request.size) : 0);
+        if (data)
+            m_Device->unmapBuffer(request.buffer);
+    }
+    else
+    {
+        size_t rowPitch = 0;
+        const void* data = m_Device->mapStagingTexture(request.texture, nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Read, &rowPitch);
+        if (request.textureCallback)
+            request.textureCallback(data, rowPitch, request.textureDesc);
+        if (data)
+            m_Device->unmapStagingTexture(request.texture);
+    }
+}
+
+void ReadbackQueue::OnCommandListExecuted(nvrhi::ICommandList* commandList)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // The other requests stay in order, they are fenced when their own command lists are executed
+    std::vector<Request> notExecuted;
+    for (Request& request : m_NewRequests)
+    {
+        if (request.commandList == commandList)
+        {
+            request.commandList = nullptr;
+            m_SubmittedRequests.push_back(std::move(request));
+        }
+        else
+            notExecuted.push_back(std::move(request));
+    }
+    m_NewRequests = std::move(notExecuted);
+}
+
+void ReadbackQueue::Update()
+{
+    std::vector<Request> completedRequests;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // The query is signaled when all the work submitted so far, including the copies, is done
+        if (!m_SubmittedRequests.empty())
+        {
+            Batch batch;
+            if (!m_FreeQueries.empty())
+            {
+                batch.query = m_FreeQueries.back();
+                m_FreeQueries.pop_back();
+                m_Device->resetEventQuery(batch.query);
+            }
+            else
+            {
+                batch.query = m_Device->createEventQuery();
+            }
+
+            m_Device->setEventQuery(batch.query, nvrhi::CommandQueue::Graphics);
+            batch.requests = std::move(m_SubmittedRequests);
+            m_SubmittedRequests.clear();
+            m_PendingBatches.push_back(std::move(batch));
+        }
+
+        // Batches complete in submission order
+        while (!m_PendingBatches.empty() && m_Device->pollEventQuery(m_PendingBatches.front().query))
+        {
+            Batch& batch = m_PendingBatches.front();
+            for (Request& request : batch.requests)
+                completedRequests.push_back(std::move(request));
+            m_FreeQueries.push_back(batch.query);
+            m_PendingBatches.pop_front();
+        }
+    }
+
+    // Run the callbacks without the lock so that they can record new requests
+    for (Request& request : completedRequests)
+    {
+        CompleteRequest(request);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (request.buffer)
+            m_FreeBuffers.push_back(request.buffer);
+        else
+            m_FreeTextures.push_back(request.texture);
+    }
+}
+
+void ReadbackQueue::Flush()
+{
+    m_Device->waitForIdle();
+    Update();
+
+#ifndef NDEBUG
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        assert(m_SubmittedRequests.empty() && m_PendingBatches.empty());
+    }
+#endif
+
+    WaitForWorker();
+}
+
+size_t ReadbackQueue::GetNumPendingRequests() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    size_t result = m_NewRequests.size() + m_SubmittedRequests.size();
+    for (const Batch& batch : m_PendingBatches)
+        result += batch.requests.size();
+    return result;
+}
+
+size_t ReadbackQueue::GetNumPooledBuffers() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_FreeBuffers.size();
+}
+
+size_t ReadbackQueue::GetNumPooledTextures() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_FreeTextures.size();
+}
+
+void ReadbackQueue::RunOnWorkerThread(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WorkerMutex);
+        m_WorkerTasks.push_back(std::move(task));
+    }
+    m_WorkerCondition.notify_all();
+}
+
+void ReadbackQueue::WaitForWorker()
+{
+    std::unique_lock<std::mutex> lock(m_WorkerMutex);
+    m_WorkerCondition.wait(lock, [this]() { return m_WorkerTasks.empty() && !m_WorkerBusy; });
+}
+
+void ReadbackQueue::WorkerThreadProc()
+{
+    std::unique_lock<std::mutex> lock(m_WorkerMutex);
+
+    while (true)
+    {
+        m_WorkerCondition.wait(lock, [this]() { return m_Terminate || !m_WorkerTasks.empty(); });
+
+        // Finish the queued tasks before terminating, they may be writing files
+        if (m_WorkerTasks.empty())
+            return;
+
+        std::function<void()> task = std::move(m_WorkerTasks.front());
+        m_WorkerTasks.pop_front();
+        m_WorkerBusy = true;
+
+        lock.unlock();
+        task();
+        lock.lock();
+
+        m_WorkerBusy = false;
+        m_WorkerCondition.notify_all();
+    }
+}
@@ -36,11 +36,16 @@ this software is released into the Public Domain.
 
 #include <donut/engine/Scene.h>
 #include <donut/engine/GltfImporter.h>
+#include <donut/engine/VertexCompression.h>
+#include <donut/engine/MeshletBuilder.h>
+#include <donut/engine/ParallelFor.h>
 #include <donut/core/json.h>
 #include <donut/core/log.h>
+#include <donut/core/profiler.h>
 #include <donut/core/string_utils.h>
 #include <nvrhi/common/misc.h>
 #include <json/value.h>
+#include <cstring>
 
 #include "donut/engine/ShaderFactory.h"
 
@@ -57,14 +62,11 @@ this software is released into the Public Domain.
 #endif
 
 
-#ifdef DONUT_WITH_TASKFLOW
-#include <taskflow/taskflow.hpp>
-#endif
-
 using namespace donut::math;
 #include <donut/shaders/material_cb.h>
 #include <donut/shaders/skinning_cb.h>
 #include <donut/shaders/bindless.h>
+#include <donut/shaders/meshlet_cb.h>
 
 using namespace donut::vfs;
 using namespace donut::engine;
@@ -141,6 +143,8 @@ bool Scene::Load(const std::filesystem::path& jsonFileName)
 
 bool Scene::LoadWithExecutor(const std::filesystem::path& sceneFileName, tf::Executor* executor)
 {
+    DONUT_PROFILE_SCOPE("Scene::Load");
+
 #ifndef DONUT_WITH_TASKFLOW
     assert(!executor);
 #endif
@@ -209,6 +213,7 @@ void Scene::LoadModelAsync(
     {
         executor->async([this, index, executor, fileName]()
             {
+                DONUT_PROFILE_SCOPE("Scene::LoadModel");
                 SceneImportResult result;
                 m_GltfImporter->Load(fileName, *m_TextureCache, g_LoadingStats, executor, result);
                 ++g_LoadingStats.ObjectsLoaded;
@@ -633,14 +638,40 @@ void Scene::FinishedLoading(uint32_t frameIndex)
 }
 
 void Scene::RefreshSceneGraph(uint32_t frameIndex)
+{
+    RefreshSceneGraphTransforms();
+    CommitSceneGraph(frameIndex);
+}
+
+void Scene::RefreshSceneGraphTransforms()
+{
+    bool transformsChanged = m_SceneGraph->HasPendingTransformChanges();
+    if (m_SceneGraph->RefreshTransforms())
+        m_RefreshedTransformsChanged |= transformsChanged;
+}
+
+void Scene::CommitSceneGraph(uint32_t frameIndex)
 {
     m_SceneStructureChanged = m_SceneGraph->HasPendingStructureChanges();
-    m_SceneTransformsChanged = m_SceneGraph->HasPendingTransformChanges();
-    m_SceneGraph->Refresh(frameIndex);
+    m_SceneTransformsChanged = m_RefreshedTransformsChanged;
+    m_RefreshedTransformsChanged = false;
+
+    if (m_SceneStructureChanged)
+    {
+        // RefreshSceneGraphTransforms leaves structure changes to this point
+        m_SceneTransformsChanged |= m_SceneGraph->HasPendingTransformChanges();
+        m_SceneGraph->Refresh(frameIndex);
+    }
+    else
+    {
+        m_SceneGraph->PublishTransforms(frameIndex);
+    }
 }
 
 void Scene::RefreshBuffers(nvrhi::ICommandList* commandList, uint32_t frameIndex)
 {
+    DONUT_PROFILE_SCOPE("Scene::RefreshBuffers");
+
     bool materialsChanged = false;
 
     if (m_SceneStructureChanged)
@@ -671,10 +702,22 @@ void Scene::RefreshBuffers(nvrhi::ICommandList* commandList, uint32_t frameIndex
         arraysAllocated = true;
     }
 
+    // Textures replaced by mip streaming come with new bindless descriptors, see TextureCache::UpdateStreaming
+    const uint32_t textureGeneration = LoadedTexture::replacementGeneration.load();
+    const bool texturesReplaced = textureGeneration != m_TextureReplacementGeneration;
+    m_TextureReplacementGeneration = textureGeneration;
+
     for (const auto& material : m_SceneGraph->GetMaterials())
     {
         if (material->dirty || m_SceneStructureChanged || arraysAllocated)
             UpdateMaterial(material);
+        else if (texturesReplaced)
+        {
+            const MaterialConstants previousConstants = m_Resources->materialData[material->materialID];
+            UpdateMaterial(material);
+            if (memcmp(&previousConstants, &m_Resources->materialData[material->materialID], sizeof(MaterialConstants)) != 0)
+                material->dirty = true;
+        }
 
         if (!material->materialConstants)
         {
@@ -725,11 +768,31 @@ void Scene::RefreshBuffers(nvrhi::ICommandList* commandList, uint32_t frameIndex
     UpdateSkinnedMeshes(commandList, frameIndex);
 }
 
+// Fills the skinning matrices of an instance. The joint transforms relative to the instance node are
+// computed in double precision, which keeps them accurate for characters far from the origin.
+static void ComputeJointPalette(const SkinnedMeshInstance& skinnedInstance, float4x4* palette)
+{
+    daffine3 worldToRoot = inverse(skinnedInstance.GetNode()->GetLocalToWorldTransform());
+
+    for (size_t i = 0; i < skinnedInstance.joints.size(); i++)
+    {
+        const SkinnedMeshJoint& joint = skinnedInstance.joints[i];
+        auto jointNode = joint.node.lock();
+
+        affine3 jointTransform = affine3(jointNode->GetLocalToWorldTransform() * worldToRoot);
+        palette[i] = joint.inverseBindMatrix * affineToHomogeneous(jointTransform); // uses the dm::simd 4x4 product
+    }
+}
+
 void Scene::UpdateSkinnedMeshes(nvrhi::ICommandList* commandList, uint32_t frameIndex)
 {
-    bool skinningMarkerPlaced = false;
+    DONUT_PROFILE_SCOPE("Scene::UpdateSkinnedMeshes");
+
+    std::vector<SkinnedMeshInstance*> activeInstances;
+    std::vector<SkinnedMeshInstance*> changedInstances;
+    uint32_t firstChangedJoint = ~0u;
+    uint32_t lastChangedJoint = 0;
 
-    std::vector<dm::float4x4> jointMatrices;
     for (const auto& skinnedInstance : m_SceneGraph->GetSkinnedMeshInstances())
     {
         // Only process the groups that were updated on this or previous frame.
@@ -737,29 +800,41 @@ void Scene::UpdateSkinnedMeshes(nvrhi::ICommandList* commandList, uint32_t frame
         if (skinnedInstance->GetLastUpdateFrameIndex() + 1 < frameIndex)
             continue;
 
-        if (!skinningMarkerPlaced)
+        activeInstances.push_back(skinnedInstance.get());
+
+        // The palette of an instance that was updated on the previous frame is still in the joint buffer
+        if (skinnedInstance->jointPaletteFrameIndex != skinnedInstance->GetLastUpdateFrameIndex())
         {
-            commandList->beginMarker("Skinning");
-            skinningMarkerPlaced = true;
+            changedInstances.push_back(skinnedInstance.get());
+            firstChangedJoint = std::min(firstChangedJoint, skinnedInstance->jointOffset);
+            lastChangedJoint = std::max(lastChangedJoint, skinnedInstance->jointOffset + uint32_t(skinnedInstance->joints.size()));
         }
+    }
 
-        const auto& groupName = skinnedInstance->GetName();
-        if (!groupName.empty())
-            commandList->beginMarker(groupName.c_str());
+    if (activeInstances.empty())
+        return;
 
-        jointMatrices.resize(skinnedInstance->joints.size());
-        dm::daffine3 worldToRoot = inverse(skinnedInstance->GetNode()->GetLocalToWorldTransform());
+    ParallelFor(m_Executor, uint32_t(changedInstances.size()), [this, &changedInstances](uint32_t index)
+    {
+        SkinnedMeshInstance& skinnedInstance = *changedInstances[index];
+        ComputeJointPalette(skinnedInstance, m_JointPalettes.data() + skinnedInstance.jointOffset);
+        skinnedInstance.jointPaletteFrameIndex = skinnedInstance.GetLastUpdateFrameIndex();
+    });
 
-        for (size_t i = 0; i < skinnedInstance->joints.size(); i++)
-        {
-            auto jointNode = skinnedInstance->joints[i].node.lock();
+    // All palettes live in one buffer, upload the range that covers the changed ones at once
+    if (lastChangedJoint > firstChangedJoint)
+    {
+        commandList->writeBuffer(m_JointBuffer, m_JointPalettes.data() + firstChangedJoint,
+            (lastChangedJoint - firstChangedJoint) * sizeof(float4x4), firstChangedJoint * sizeof(float4x4));
+    }
 
-            dm::float4x4 jointMatrix = dm::affineToHomogeneous(dm::affine3(jointNode->GetLocalToWorldTransform() * worldToRoot));
-            jointMatrix = skinnedInstance->joints[i].inverseBindMatrix * jointMatrix;
-            jointMatrices[i] = jointMatrix;
-        }
+    commandList->beginMarker("Skinning");
 
-        commandList->writeBuffer(skinnedInstance->jointBuffer, jointMatrices.data(), jointMatrices.size() * sizeof(float4x4));
+    for (SkinnedMeshInstance* skinnedInstance : activeInstances)
+    {
+        const auto& groupName = skinnedInstance->GetName();
+        if (!groupName.empty())
+            commandList->beginMarker(groupName.c_str());
 
         nvrhi::ComputeState state;
         state.pipeline = m_SkinningPipeline;
@@ -781,13 +856,23 @@ void Scene::UpdateSkinnedMeshes(nvrhi::ICommandList* commandList, uint32_t frame
         if (!skinnedInstance->skinningInitialized) constants.flags |= SkinningFlag_FirstFrame;
         skinnedInstance->skinningInitialized = true;
 
-        constants.inputPositionOffset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::Position).byteOffset + vertexOffset * sizeof(float3));
-        constants.inputNormalOffset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::Normal).byteOffset + vertexOffset * sizeof(uint32_t));
-        constants.inputTangentOffset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::Tangent).byteOffset + vertexOffset * sizeof(uint32_t));
-        constants.inputTexCoord1Offset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset + vertexOffset * sizeof(float2));
-        constants.inputTexCoord2Offset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::TexCoord2).byteOffset + vertexOffset * sizeof(float2));
-        constants.inputJointIndexOffset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::JointIndices).byteOffset + vertexOffset * sizeof(uint2));
-        constants.inputJointWeightOffset = uint32_t(prototypeBuffers->getVertexBufferRange(VertexAttribute::JointWeights).byteOffset + vertexOffset * sizeof(float4));
+        constants.inputFormatFlags = prototypeBuffers->formatFlags;
+        constants.inputPositionScale = skinnedInstance->GetPrototypeMesh()->positionScale;
+        constants.jointOffset = skinnedInstance->jointOffset * uint32_t(sizeof(float4x4));
+        constants.inputPositionBias = skinnedInstance->GetPrototypeMesh()->positionBias;
+
+        auto getInputOffset = [&prototypeBuffers, vertexOffset](VertexAttribute attr)
+        {
+            return uint32_t(prototypeBuffers->getVertexBufferRange(attr).byteOffset + vertexOffset * prototypeBuffers->getVertexAttributeStride(attr));
+        };
+
+        constants.inputPositionOffset = getInputOffset(VertexAttribute::Position);
+        constants.inputNormalOffset = getInputOffset(VertexAttribute::Normal);
+        constants.inputTangentOffset = getInputOffset(VertexAttribute::Tangent);
+        constants.inputTexCoord1Offset = getInputOffset(VertexAttribute::TexCoord1);
+        constants.inputTexCoord2Offset = getInputOffset(VertexAttribute::TexCoord2);
+        constants.inputJointIndexOffset = getInputOffset(VertexAttribute::JointIndices);
+        constants.inputJointWeightOffset = getInputOffset(VertexAttribute::JointWeights);
         constants.outputPositionOffset = uint32_t(skinnedBuffers->getVertexBufferRange(VertexAttribute::Position).byteOffset);
         constants.outputPrevPositionOffset = uint32_t(skinnedBuffers->getVertexBufferRange(VertexAttribute::PrevPosition).byteOffset);
         constants.outputNormalOffset = uint32_t(skinnedBuffers->getVertexBufferRange(VertexAttribute::Normal).byteOffset);
@@ -802,10 +887,7 @@ void Scene::UpdateSkinnedMeshes(nvrhi::ICommandList* commandList, uint32_t frame
             commandList->endMarker();
     }
 
-    if (skinningMarkerPlaced)
-    {
-        commandList->endMarker();
-    }
+    commandList->endMarker();
 }
 
 void Scene::Refresh(nvrhi::ICommandList* commandList, uint32_t frameIndex)
@@ -843,8 +925,70 @@ inline void AppendBufferRange(nvrhi::BufferRange& range, size_t size, uint64_t&
     currentBufferSize += range.byteSize;
 }
 
+static uint32_t ChooseCompactFormats(const BufferGroup& buffers)
+{
+    uint32_t formatFlags = 0;
+
+    if (!buffers.indexData.empty() && CanUse16BitIndices(buffers.indexData.data(), buffers.indexData.size()))
+        formatFlags |= GeometryFormat_Indices16;
+
+    if (!buffers.positionData.empty())
+        formatFlags |= GeometryFormat_CompactPositions;
+
+    // Both UV sets share the flag, so they have to fit into half floats together
+    if ((!buffers.texcoord1Data.empty() || !buffers.texcoord2Data.empty()) &&
+        CanUseCompactTexCoords(buffers.texcoord1Data.data(), buffers.texcoord1Data.size()) &&
+        CanUseCompactTexCoords(buffers.texcoord2Data.data(), buffers.texcoord2Data.size()))
+        formatFlags |= GeometryFormat_CompactTexCoords;
+
+    if (!buffers.weightData.empty())
+        formatFlags |= GeometryFormat_CompactJointWeights;
+
+    return formatFlags;
+}
+
+void Scene::SetMeshOptimizationEnabled(bool enable)
+{
+    m_GltfImporter->SetMeshOptimizationEnabled(enable);
+}
+
+void Scene::SetLodGenerationEnabled(bool enable)
+{
+    m_GltfImporter->SetLodGenerationEnabled(enable);
+}
+
 void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
 {
+    DONUT_PROFILE_SCOPE("Scene::CreateMeshBuffers");
+
+    // Compact positions are quantized relative to the bounds of each mesh,
+    // so find all meshes that share a buffer group before encoding it.
+    std::unordered_map<const BufferGroup*, std::vector<MeshInfo*>> meshesPerBufferGroup;
+    if (m_EnableCompactVertexFormat)
+    {
+        for (const auto& mesh : m_SceneGraph->GetMeshes())
+        {
+            if (mesh->buffers && !mesh->buffers->vertexBuffer)
+                meshesPerBufferGroup[mesh->buffers.get()].push_back(mesh.get());
+        }
+    }
+
+    // Meshlets are built from the CPU copies of the index and position data, which are released below
+    if (m_EnableMeshlets)
+    {
+        std::vector<std::shared_ptr<MeshInfo>> meshes;
+        for (const auto& mesh : m_SceneGraph->GetMeshes())
+            meshes.push_back(mesh);
+        std::sort(meshes.begin(), meshes.end(), [](const auto& a, const auto& b) { return a->globalMeshIndex < b->globalMeshIndex; });
+
+#ifdef DONUT_WITH_TASKFLOW
+        tf::Executor executor;
+        BuildMeshletsForMeshes(meshes, &executor);
+#else
+        BuildMeshletsForMeshes(meshes);
+#endif
+    }
+
     for (const auto& mesh : m_SceneGraph->GetMeshes())
     {
         auto buffers = mesh->buffers;
@@ -852,15 +996,31 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
         if (!buffers)
             continue;
 
+        if (m_EnableCompactVertexFormat && !buffers->indexBuffer && !buffers->vertexBuffer)
+            buffers->formatFlags = ChooseCompactFormats(*buffers);
+
         if (!buffers->indexData.empty() && !buffers->indexBuffer)
         {
+            std::vector<uint16_t> indexData16;
+            const void* indexData = buffers->indexData.data();
+            size_t indexDataSize = buffers->indexData.size() * sizeof(uint32_t);
+
+            if (buffers->formatFlags & GeometryFormat_Indices16)
+            {
+                // Pad the buffer to a multiple of 4 bytes to keep it usable as a raw buffer
+                indexData16.resize((buffers->indexData.size() + 1) & ~size_t(1), 0);
+                std::copy(buffers->indexData.begin(), buffers->indexData.end(), indexData16.begin());
+                indexData = indexData16.data();
+                indexDataSize = indexData16.size() * sizeof(uint16_t);
+            }
+
             nvrhi::BufferDesc bufferDesc;
             bufferDesc.isIndexBuffer = true;
-            bufferDesc.byteSize = buffers->indexData.size() * sizeof(uint32_t);
+            bufferDesc.byteSize = indexDataSize;
             bufferDesc.debugName = "IndexBuffer";
             bufferDesc.canHaveTypedViews = true;
             bufferDesc.canHaveRawViews = true;
-            bufferDesc.format = nvrhi::Format::R32_UINT;
+            bufferDesc.format = buffers->getIndexFormat();
             bufferDesc.isAccelStructBuildInput = m_RayTracingSupported;
 
             buffers->indexBuffer = m_Device->createBuffer(bufferDesc);
@@ -873,8 +1033,9 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
 
             commandList->beginTrackingBufferState(buffers->indexBuffer, nvrhi::ResourceStates::Common);
 
-            commandList->writeBuffer(buffers->indexBuffer, buffers->indexData.data(), buffers->indexData.size() * sizeof(uint32_t));
-            std::vector<uint32_t>().swap(buffers->indexData);
+            commandList->writeBuffer(buffers->indexBuffer, indexData, indexDataSize);
+            if (!m_RetainCpuGeometry)
+                std::vector<uint32_t>().swap(buffers->indexData);
 
             nvrhi::ResourceStates state = nvrhi::ResourceStates::IndexBuffer | nvrhi::ResourceStates::ShaderResource;
 
@@ -885,6 +1046,44 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
             commandList->commitBarriers();
         }
 
+        if (!buffers->meshlets.empty() && !buffers->meshletBuffer)
+        {
+            std::vector<MeshletData> meshletData(buffers->meshlets.size());
+            for (size_t i = 0; i < buffers->meshlets.size(); i++)
+            {
+                const Meshlet& meshlet = buffers->meshlets[i];
+                MeshletData& data = meshletData[i];
+                data.center = meshlet.center;
+                data.radius = meshlet.radius;
+                data.coneAxis = meshlet.coneAxis;
+                data.coneCutoff = meshlet.coneCutoff;
+                data.vertexOffset = meshlet.vertexOffset;
+                data.triangleOffset = meshlet.triangleOffset;
+                data.vertexCount = meshlet.vertexCount;
+                data.triangleCount = meshlet.triangleCount;
+            }
+
+            nvrhi::BufferDesc bufferDesc;
+            bufferDesc.byteSize = meshletData.size() * sizeof(MeshletData);
+            bufferDesc.structStride = sizeof(MeshletData);
+            bufferDesc.debugName = "MeshletBuffer";
+            bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+            bufferDesc.keepInitialState = true;
+            buffers->meshletBuffer = m_Device->createBuffer(bufferDesc);
+
+            bufferDesc.byteSize = buffers->meshletIndexData.size() * sizeof(uint32_t);
+            bufferDesc.structStride = 0;
+            bufferDesc.canHaveRawViews = true;
+            bufferDesc.debugName = "MeshletIndexBuffer";
+            buffers->meshletIndexBuffer = m_Device->createBuffer(bufferDesc);
+
+            commandList->writeBuffer(buffers->meshletBuffer, meshletData.data(), meshletData.size() * sizeof(MeshletData));
+            commandList->writeBuffer(buffers->meshletIndexBuffer, buffers->meshletIndexData.data(), bufferDesc.byteSize);
+
+            std::vector<Meshlet>().swap(buffers->meshlets);
+            std::vector<uint32_t>().swap(buffers->meshletIndexData);
+        }
+
         if (!buffers->vertexBuffer)
         {
             nvrhi::BufferDesc bufferDesc;
@@ -897,8 +1096,8 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
 
             if (!buffers->positionData.empty())
             {
-                AppendBufferRange(buffers->getVertexBufferRange(VertexAttribute::Position), 
-                    buffers->positionData.size() * sizeof(buffers->positionData[0]), bufferDesc.byteSize);
+                AppendBufferRange(buffers->getVertexBufferRange(VertexAttribute::Position),
+                    buffers->positionData.size() * buffers->getVertexAttributeStride(VertexAttribute::Position), bufferDesc.byteSize);
             }
 
             if (!buffers->normalData.empty())
@@ -916,19 +1115,19 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
             if (!buffers->texcoord1Data.empty())
             {
                 AppendBufferRange(buffers->getVertexBufferRange(VertexAttribute::TexCoord1),
-                    buffers->texcoord1Data.size() * sizeof(buffers->texcoord1Data[0]), bufferDesc.byteSize);
+                    buffers->texcoord1Data.size() * buffers->getVertexAttributeStride(VertexAttribute::TexCoord1), bufferDesc.byteSize);
             }
 
             if (!buffers->texcoord2Data.empty())
             {
                 AppendBufferRange(buffers->getVertexBufferRange(VertexAttribute::TexCoord2),
-                    buffers->texcoord2Data.size() * sizeof(buffers->texcoord2Data[0]), bufferDesc.byteSize);
+                    buffers->texcoord2Data.size() * buffers->getVertexAttributeStride(VertexAttribute::TexCoord2), bufferDesc.byteSize);
             }
 
             if (!buffers->weightData.empty())
             {
                 AppendBufferRange(buffers->getVertexBufferRange(VertexAttribute::JointWeights),
-                    buffers->weightData.size() * sizeof(buffers->weightData[0]), bufferDesc.byteSize);
+                    buffers->weightData.size() * buffers->getVertexAttributeStride(VertexAttribute::JointWeights), bufferDesc.byteSize);
             }
 
             if (!buffers->jointData.empty())
@@ -949,8 +1148,27 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
             if (!buffers->positionData.empty())
             {
                 const auto& range = buffers->getVertexBufferRange(VertexAttribute::Position);
-                commandList->writeBuffer(buffers->vertexBuffer, buffers->positionData.data(), range.byteSize, range.byteOffset);
-                std::vector<float3>().swap(buffers->positionData);
+                if (buffers->formatFlags & GeometryFormat_CompactPositions)
+                {
+                    // Vertices that don't belong to any known mesh stay at zero
+                    std::vector<vector<uint16_t, 4>> compactPositions(buffers->positionData.size(), vector<uint16_t, 4>::zero());
+                    for (MeshInfo* groupMesh : meshesPerBufferGroup[buffers.get()])
+                    {
+                        GetPositionDequantization(groupMesh->objectSpaceBounds, groupMesh->positionScale, groupMesh->positionBias);
+
+                        uint32_t lastVertex = std::min(groupMesh->vertexOffset + groupMesh->totalVertices, uint32_t(compactPositions.size()));
+                        for (uint32_t vertex = groupMesh->vertexOffset; vertex < lastVertex; vertex++)
+                        {
+                            compactPositions[vertex] = QuantizePosition(buffers->positionData[vertex],
+                                groupMesh->positionScale, groupMesh->positionBias);
+                        }
+                    }
+                    commandList->writeBuffer(buffers->vertexBuffer, compactPositions.data(), range.byteSize, range.byteOffset);
+                }
+                else
+                    commandList->writeBuffer(buffers->vertexBuffer, buffers->positionData.data(), range.byteSize, range.byteOffset);
+                if (!m_RetainCpuGeometry)
+                    std::vector<float3>().swap(buffers->positionData);
             }
 
             if (!buffers->normalData.empty())
@@ -970,21 +1188,42 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
             if (!buffers->texcoord1Data.empty())
             {
                 const auto& range = buffers->getVertexBufferRange(VertexAttribute::TexCoord1);
-                commandList->writeBuffer(buffers->vertexBuffer, buffers->texcoord1Data.data(), range.byteSize, range.byteOffset);
+                if (buffers->formatFlags & GeometryFormat_CompactTexCoords)
+                {
+                    std::vector<uint32_t> compactTexCoords(buffers->texcoord1Data.size());
+                    std::transform(buffers->texcoord1Data.begin(), buffers->texcoord1Data.end(), compactTexCoords.begin(), PackTexCoordHalf);
+                    commandList->writeBuffer(buffers->vertexBuffer, compactTexCoords.data(), range.byteSize, range.byteOffset);
+                }
+                else
+                    commandList->writeBuffer(buffers->vertexBuffer, buffers->texcoord1Data.data(), range.byteSize, range.byteOffset);
                 std::vector<float2>().swap(buffers->texcoord1Data);
             }
 
             if (!buffers->texcoord2Data.empty())
             {
                 const auto& range = buffers->getVertexBufferRange(VertexAttribute::TexCoord2);
-                commandList->writeBuffer(buffers->vertexBuffer, buffers->texcoord2Data.data(), range.byteSize, range.byteOffset);
+                if (buffers->formatFlags & GeometryFormat_CompactTexCoords)
+                {
+                    std::vector<uint32_t> compactTexCoords(buffers->texcoord2Data.size());
+                    std::transform(buffers->texcoord2Data.begin(), buffers->texcoord2Data.end(), compactTexCoords.begin(), PackTexCoordHalf);
+                    commandList->writeBuffer(buffers->vertexBuffer, compactTexCoords.data(), range.byteSize, range.byteOffset);
+                }
+                else
+                    commandList->writeBuffer(buffers->vertexBuffer, buffers->texcoord2Data.data(), range.byteSize, range.byteOffset);
                 std::vector<float2>().swap(buffers->texcoord2Data);
             }
 
             if (!buffers->weightData.empty())
             {
                 const auto& range = buffers->getVertexBufferRange(VertexAttribute::JointWeights);
-                commandList->writeBuffer(buffers->vertexBuffer, buffers->weightData.data(), range.byteSize, range.byteOffset);
+                if (buffers->formatFlags & GeometryFormat_CompactJointWeights)
+                {
+                    std::vector<uint32_t> compactWeights(buffers->weightData.size());
+                    std::transform(buffers->weightData.begin(), buffers->weightData.end(), compactWeights.begin(), PackJointWeightsUnorm8);
+                    commandList->writeBuffer(buffers->vertexBuffer, compactWeights.data(), range.byteSize, range.byteOffset);
+                }
+                else
+                    commandList->writeBuffer(buffers->vertexBuffer, buffers->weightData.data(), range.byteSize, range.byteOffset);
                 std::vector<float4>().swap(buffers->weightData);
             }
 
@@ -1005,6 +1244,30 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
         }
     }
 
+    // The joint palettes of all skinned instances share one buffer, so that they can be uploaded with one write.
+    // Offsets change when instances are added or removed, so all palettes are recomputed in that case.
+    uint32_t totalJoints = 0;
+    for (const auto& skinnedInstance : m_SceneGraph->GetSkinnedMeshInstances())
+    {
+        skinnedInstance->jointOffset = totalJoints;
+        skinnedInstance->jointPaletteFrameIndex = ~0u;
+        totalJoints += uint32_t(skinnedInstance->joints.size());
+    }
+
+    m_JointPalettes.resize(totalJoints);
+
+    if (totalJoints > 0 && (!m_JointBuffer || m_JointBuffer->getDesc().byteSize < sizeof(float4x4) * totalJoints))
+    {
+        nvrhi::BufferDesc jointBufferDesc;
+        jointBufferDesc.debugName = "JointBuffer";
+        jointBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        jointBufferDesc.keepInitialState = true;
+        jointBufferDesc.canHaveRawViews = true;
+        // Leave some room for instances that are added later
+        jointBufferDesc.byteSize = sizeof(float4x4) * (totalJoints + totalJoints / 2);
+        m_JointBuffer = m_Device->createBuffer(jointBufferDesc);
+    }
+
     for (const auto& skinnedInstance : m_SceneGraph->GetSkinnedMeshInstances())
     {
         const auto& skinnedMesh = skinnedInstance->GetMesh();
@@ -1018,6 +1281,9 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
             skinnedMesh->buffers->indexBuffer = skinnedInstance->GetPrototypeMesh()->buffers->indexBuffer;
             skinnedMesh->buffers->indexBufferDescriptor = skinnedInstance->GetPrototypeMesh()->buffers->indexBufferDescriptor;
 
+            // The skinned vertices are always written in the full precision formats, only the indices are shared
+            skinnedMesh->buffers->formatFlags = skinnedInstance->GetPrototypeMesh()->buffers->formatFlags & GeometryFormat_Indices16;
+
             const auto& prototypeBuffers = skinnedInstance->GetPrototypeMesh()->buffers;
             const auto& skinnedBuffers = skinnedMesh->buffers;
 
@@ -1074,15 +1340,10 @@ void Scene::CreateMeshBuffers(nvrhi::ICommandList* commandList)
             }
         }
 
-        if (!skinnedInstance->jointBuffer)
+        if (skinnedInstance->jointBuffer != m_JointBuffer)
         {
-            nvrhi::BufferDesc jointBufferDesc;
-            jointBufferDesc.debugName = "JointBuffer";
-            jointBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            jointBufferDesc.keepInitialState = true;
-            jointBufferDesc.canHaveRawViews = true;
-            jointBufferDesc.byteSize = sizeof(dm::float4x4) * skinnedInstance->joints.size();
-            skinnedInstance->jointBuffer = m_Device->createBuffer(jointBufferDesc);
+            skinnedInstance->jointBuffer = m_JointBuffer;
+            skinnedInstance->skinningBindingSet = nullptr;
         }
 
         if (!skinnedInstance->skinningBindingSet)
@@ -1193,25 +1454,29 @@ void Scene::UpdateGeometry(const std::shared_ptr<MeshInfo>& mesh)
         uint32_t indexOffset = mesh->indexOffset + geometry->indexOffsetInMesh;
         uint32_t vertexOffset = mesh->vertexOffset + geometry->vertexOffsetInMesh;
 
+        auto getVertexOffset = [&mesh, vertexOffset](VertexAttribute attr)
+        {
+            return mesh->buffers->hasAttribute(attr)
+                ? uint32_t(vertexOffset * mesh->buffers->getVertexAttributeStride(attr) + mesh->buffers->getVertexBufferRange(attr).byteOffset) : ~0u;
+        };
+
         GeometryData& gdata = m_Resources->geometryData[geometry->globalGeometryIndex];
         gdata.numIndices = geometry->numIndices;
         gdata.numVertices = geometry->numVertices;
         gdata.indexBufferIndex = mesh->buffers->indexBufferDescriptor ? mesh->buffers->indexBufferDescriptor->Get() : -1;
-        gdata.indexOffset = indexOffset * sizeof(uint32_t);
+        gdata.indexOffset = indexOffset * mesh->buffers->getIndexSize();
         gdata.vertexBufferIndex = mesh->buffers->vertexBufferDescriptor ? mesh->buffers->vertexBufferDescriptor->Get() : -1;
-        gdata.positionOffset = mesh->buffers->hasAttribute(VertexAttribute::Position)
-            ? uint32_t(vertexOffset * sizeof(float3) + mesh->buffers->getVertexBufferRange(VertexAttribute::Position).byteOffset) : ~0u;
-        gdata.prevPositionOffset = mesh->buffers->hasAttribute(VertexAttribute::PrevPosition)
-            ? uint32_t(vertexOffset * sizeof(float3) + mesh->buffers->getVertexBufferRange(VertexAttribute::PrevPosition).byteOffset) : ~0u;
-        gdata.texCoord1Offset = mesh->buffers->hasAttribute(VertexAttribute::TexCoord1)
-            ? uint32_t(vertexOffset * sizeof(float2) + mesh->buffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset) : ~0u;
-        gdata.texCoord2Offset = mesh->buffers->hasAttribute(VertexAttribute::TexCoord2)
-            ? uint32_t(vertexOffset * sizeof(float2) + mesh->buffers->getVertexBufferRange(VertexAttribute::TexCoord2).byteOffset) : ~0u;
-        gdata.normalOffset = mesh->buffers->hasAttribute(VertexAttribute::Normal)
-            ? uint32_t(vertexOffset * sizeof(uint32_t) + mesh->buffers->getVertexBufferRange(VertexAttribute::Normal).byteOffset) : ~0u;
-        gdata.tangentOffset = mesh->buffers->hasAttribute(VertexAttribute::Tangent)
-            ? uint32_t(vertexOffset * sizeof(uint32_t) + mesh->buffers->getVertexBufferRange(VertexAttribute::Tangent).byteOffset) : ~0u;
+        gdata.positionOffset = getVertexOffset(VertexAttribute::Position);
+        gdata.prevPositionOffset = getVertexOffset(VertexAttribute::PrevPosition);
+        gdata.texCoord1Offset = getVertexOffset(VertexAttribute::TexCoord1);
+        gdata.texCoord2Offset = getVertexOffset(VertexAttribute::TexCoord2);
+        gdata.normalOffset = getVertexOffset(VertexAttribute::Normal);
+        gdata.tangentOffset = getVertexOffset(VertexAttribute::Tangent);
         gdata.materialIndex = geometry->material ? geometry->material->materialID : ~0u;
+        gdata.positionScale = mesh->positionScale;
+        gdata.formatFlags = mesh->buffers->formatFlags;
+        gdata.positionBias = mesh->positionBias;
+        gdata.padding = 0u;
     }
 }
 
@@ -1230,4 +1495,8 @@ void Scene::UpdateInstance(const std::shared_ptr<MeshInstance>& instance)
     idata.firstGeometryIndex = mesh->geometries[0]->globalGeometryIndex;
     idata.numGeometries = uint32_t(mesh->geometries.size());
     idata.padding = 0u;
+    idata.positionScale = mesh->positionScale;
+    idata.positionBias = mesh->positionBias;
+    idata.padding1 = 0u;
+    idata.padding2 = 0u;
 }
@@ -23,6 +23,7 @@
 #include <donut/engine/SceneGraph.h>
 #include <donut/core/log.h>
 #include <donut/core/json.h>
+#include <donut/core/profiler.h>
 #include <sstream>
 
 using namespace donut::engine;
@@ -505,6 +506,32 @@ bool SceneGraphAnimation::Apply(float time) const
     return success;
 }
 
+bool SceneGraphAnimation::ApplyTransforms(float time) const
+{
+    bool success = true;
+
+    for (const auto& channel : m_Channels)
+    {
+        if (channel->GetAttribute() != AnimationAttribute::LeafProperty)
+            success = channel->Apply(time) && success;
+    }
+
+    return success;
+}
+
+bool SceneGraphAnimation::ApplyLeafProperties(float time) const
+{
+    bool success = true;
+
+    for (const auto& channel : m_Channels)
+    {
+        if (channel->GetAttribute() == AnimationAttribute::LeafProperty)
+            success = channel->Apply(time) && success;
+    }
+
+    return success;
+}
+
 bool SceneGraphAnimation::IsVald() const
 {
     for (const auto& channel : m_Channels)
@@ -950,8 +977,10 @@ std::shared_ptr<SceneGraphNode> SceneGraph::FindNode(const std::filesystem::path
     return current->shared_from_this();
 }
 
-void SceneGraph::Refresh(uint32_t frameIndex)
+void SceneGraph::RefreshNodes()
 {
+    DONUT_PROFILE_SCOPE("SceneGraph::RefreshNodes");
+
     struct StackItem
     {
         bool supergraphTransformUpdated = false;
@@ -969,6 +998,8 @@ void SceneGraph::Refresh(uint32_t frameIndex)
         auto current = walker.Get();
         auto parent = current->m_Parent;
 
+        current->m_PublishPending = true;
+
         // save the current local/global transforms as previous
         current->m_PrevLocalTransform = current->m_LocalTransform;
         current->m_PrevGlobalTransform = current->m_GlobalTransform;
@@ -1018,7 +1049,7 @@ void SceneGraph::Refresh(uint32_t frameIndex)
             current->m_SubgraphContent = current->m_LeafContent;
         }
 
-        // store the update frame number for skinned groups
+        // flag skinned groups for an update frame number, stored when the transforms are published
         if (auto meshReference = dynamic_cast<SkinnedMeshReference*>(current->m_Leaf.get()))
         {
             if ((current->m_Dirty & SceneGraphNode::DirtyFlags::LocalTransform) != 0)
@@ -1026,7 +1057,7 @@ void SceneGraph::Refresh(uint32_t frameIndex)
                 auto instance = meshReference->m_Instance.lock();
                 if (instance)
                 {
-                    instance->m_LastUpdateFrameIndex = frameIndex;
+                    instance->m_UpdatePending = true;
                 }
             }
         }
@@ -1128,6 +1159,64 @@ void SceneGraph::Refresh(uint32_t frameIndex)
     }
 }
 
+bool SceneGraph::RefreshTransforms()
+{
+    // Structure changes rebuild the instance and geometry indices that the renderer reads
+    if (HasPendingStructureChanges())
+        return false;
+
+    RefreshNodes();
+    return true;
+}
+
+void SceneGraph::PublishTransforms(uint32_t frameIndex)
+{
+    DONUT_PROFILE_SCOPE("SceneGraph::PublishTransforms");
+
+    // Only the nodes visited by RefreshNodes have changed, and their ancestors were visited as well
+    SceneGraphWalker walker(m_Root.get());
+    while (walker)
+    {
+        auto current = walker.Get();
+        bool refreshed = current->m_PublishPending;
+
+        if (refreshed)
+        {
+            SceneGraphNode::Snapshot& published = current->m_Published;
+            published.localTransform = current->m_LocalTransform;
+            published.globalTransform = current->m_GlobalTransform;
+            published.globalTransformFloat = current->m_GlobalTransformFloat;
+            published.prevLocalTransform = current->m_PrevLocalTransform;
+            published.prevGlobalTransform = current->m_PrevGlobalTransform;
+            published.prevGlobalTransformFloat = current->m_PrevGlobalTransformFloat;
+            published.globalBoundingBox = current->m_GlobalBoundingBox;
+            published.dirty = current->m_Dirty;
+            published.leafContent = current->m_LeafContent;
+            published.subgraphContent = current->m_SubgraphContent;
+            current->m_PublishPending = false;
+        }
+
+        walker.Next(refreshed);
+    }
+
+    for (const auto& instance : m_SkinnedMeshInstances)
+    {
+        if (instance->m_UpdatePending)
+        {
+            instance->m_LastUpdateFrameIndex = frameIndex;
+            instance->m_UpdatePending = false;
+        }
+    }
+}
+
+void SceneGraph::Refresh(uint32_t frameIndex)
+{
+    DONUT_PROFILE_SCOPE("SceneGraph::Refresh");
+
+    RefreshNodes();
+    PublishTransforms(frameIndex);
+}
+
 std::shared_ptr<SceneGraphLeaf> SceneTypeFactory::CreateLeaf(const std::string& type)
 {
     if (type == "DirectionalLight")
@@ -361,6 +361,44 @@ nvrhi::VertexAttributeDesc donut::engine::GetVertexAttributeDesc(VertexAttribute
     return result;
 }
 
+nvrhi::Format BufferGroup::getIndexFormat() const
+{
+    return (formatFlags & GeometryFormat_Indices16) ? nvrhi::Format::R16_UINT : nvrhi::Format::R32_UINT;
+}
+
+uint32_t BufferGroup::getIndexSize() const
+{
+    return (formatFlags & GeometryFormat_Indices16) ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+bool BufferGroup::isInputAssemblerCompatible() const
+{
+    return (formatFlags & ~GeometryFormat_Indices16) == 0;
+}
+
+uint32_t BufferGroup::getVertexAttributeStride(VertexAttribute attr) const
+{
+    switch (attr)
+    {
+    case VertexAttribute::Position:
+    case VertexAttribute::PrevPosition:
+        return (formatFlags & GeometryFormat_CompactPositions) ? sizeof(dm::vector<uint16_t, 4>) : sizeof(float3);
+    case VertexAttribute::TexCoord1:
+    case VertexAttribute::TexCoord2:
+        return (formatFlags & GeometryFormat_CompactTexCoords) ? sizeof(uint32_t) : sizeof(float2);
+    case VertexAttribute::Normal:
+    case VertexAttribute::Tangent:
+        return sizeof(uint32_t);
+    case VertexAttribute::JointIndices:
+        return sizeof(dm::vector<uint16_t, 4>);
+    case VertexAttribute::JointWeights:
+        return (formatFlags & GeometryFormat_CompactJointWeights) ? sizeof(uint32_t) : sizeof(float4);
+    default:
+        assert(!"unknown attribute");
+        return 0;
+    }
+}
+
 const char* donut::engine::MaterialDomainToString(MaterialDomain domain)
 {
     switch (domain)
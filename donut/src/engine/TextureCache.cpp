@@ -48,10 +48,12 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <donut/engine/TextureCache.h>
 
 #include <donut/engine/CommonRenderPasses.h>
+#include <donut/engine/ReadbackQueue.h>
 #include <donut/engine/ConsoleObjects.h>
 #include <donut/engine/DDSFile.h>
 #include <donut/core/vfs/VFS.h>
 #include <donut/core/log.h>
+#include <donut/core/profiler.h>
 
 #ifdef DONUT_WITH_TASKFLOW
 #include <taskflow/taskflow.hpp>
@@ -126,6 +128,27 @@ public:
     }
 };
 
+class VectorBlob : public IBlob
+{
+private:
+    std::vector<uint8_t> m_data;
+
+public:
+    VectorBlob(std::vector<uint8_t>&& data) : m_data(std::move(data))
+    {
+    }
+
+    virtual const void* data() const override
+    {
+        return m_data.data();
+    }
+
+    virtual size_t size() const override
+    {
+        return m_data.size();
+    }
+};
+
 
 TextureCache::TextureCache(
     nvrhi::IDevice* device,
@@ -157,6 +180,12 @@ void TextureCache::SetGenerateMipmaps(bool generateMipmaps)
     m_GenerateMipmaps = generateMipmaps;
 }
 
+void TextureCache::SetGenerateMipmapsOnCPU(bool enable, MipFilter filter)
+{
+    m_GenerateMipmapsOnCPU = enable;
+    m_CpuMipFilter = filter;
+}
+
 bool TextureCache::FindTextureInCache(const std::filesystem::path& path, std::shared_ptr<TextureData>& texture)
 {
     std::lock_guard<std::shared_mutex> guard(m_LoadedTexturesMutex);
@@ -183,6 +212,8 @@ bool TextureCache::FindTextureInCache(const std::filesystem::path& path, std::sh
 
 std::shared_ptr<IBlob> TextureCache::ReadTextureFile(const std::filesystem::path& path) const
 {
+    DONUT_PROFILE_SCOPE("TextureCache::ReadTextureFile");
+
     auto fileData = m_fs->readFile(path);
 
     if (!fileData)
@@ -200,8 +231,11 @@ bool TextureCache::FillTextureData(
     const std::shared_ptr<vfs::IBlob>& fileData,
     const std::shared_ptr<TextureData>& texture,
     const std::string& extension,
-    const std::string& mimeType) const
+    const std::string& mimeType,
+    tf::Executor* executor) const
 {
+    DONUT_PROFILE_SCOPE("TextureCache::FillTextureData");
+
     if (extension == ".dds" || extension == ".DDS" || mimeType == "image/vnd-ms.dds")
     {
         texture->data = fileData;
@@ -241,8 +275,6 @@ bool TextureCache::FillTextureData(
             texture->dataLayout[0][0].dataOffset = 0;
             texture->dataLayout[0][0].rowPitch = static_cast<size_t>(width * bytesPerPixel);
             texture->dataLayout[0][0].dataSize = static_cast<size_t>(width * height * bytesPerPixel);
-
-            return true;
         }
         else
         {
@@ -338,9 +370,91 @@ bool TextureCache::FillTextureData(
         }
     }
 
+    if (texture->isRenderTarget)
+        ProcessImageOnCPU(*texture, executor);
+
     return true;
 }
 
+void TextureCache::ProcessImageOnCPU(TextureData& texture, tf::Executor* executor) const
+{
+    DONUT_PROFILE_SCOPE("TextureCache::ProcessImageOnCPU");
+
+    if (texture.dimension != nvrhi::TextureDimension::Texture2D || texture.arraySize != 1 || texture.mipLevels != 1 ||
+        !MipGenerator::IsFormatSupported(texture.format))
+        return;
+
+    MipGenerationParams params;
+    params.filter = m_CpuMipFilter;
+    params.executor = executor;
+
+    if (m_MaxTextureSize > 0 && std::max(texture.width, texture.height) > m_MaxTextureSize)
+    {
+        uint32_t scaledWidth, scaledHeight;
+        if (texture.width >= texture.height)
+        {
+            scaledHeight = std::max(texture.height * m_MaxTextureSize / texture.width, 1u);
+            scaledWidth = m_MaxTextureSize;
+        }
+        else
+        {
+            scaledWidth = std::max(texture.width * m_MaxTextureSize / texture.height, 1u);
+            scaledHeight = m_MaxTextureSize;
+        }
+
+        const size_t bytesPerPixel = nvrhi::getFormatInfo(texture.format).bytesPerBlock;
+        const size_t rowPitch = scaledWidth * bytesPerPixel;
+        const size_t dataSize = rowPitch * scaledHeight;
+        std::vector<uint8_t> scaledData(dataSize);
+
+        const TextureSubresourceData& layout = texture.dataLayout[0][0];
+        if (MipGenerator::ResizeImage(
+            static_cast<const uint8_t*>(texture.data->data()) + layout.dataOffset, texture.width, texture.height, layout.rowPitch,
+            scaledData.data(), scaledWidth, scaledHeight, rowPitch, texture.format, params))
+        {
+            texture.data = std::make_shared<VectorBlob>(std::move(scaledData));
+            texture.width = scaledWidth;
+            texture.height = scaledHeight;
+            texture.dataLayout[0][0].dataOffset = 0;
+            texture.dataLayout[0][0].rowPitch = rowPitch;
+            texture.dataLayout[0][0].dataSize = dataSize;
+        }
+        else
+        {
+            // Keep the original image, it's still valid, just larger than requested
+            log::message(m_ErrorLogSeverity, "Couldn't resize texture '%s' from %ux%u to %ux%u, keeping the original size",
+                texture.path.c_str(), texture.width, texture.height, scaledWidth, scaledHeight);
+        }
+    }
+
+    if (!m_GenerateMipmaps || !m_GenerateMipmapsOnCPU)
+        return;
+
+    std::vector<uint8_t> mipData;
+    std::vector<MipLevelLayout> mipLayout;
+    const TextureSubresourceData& layout = texture.dataLayout[0][0];
+    if (!MipGenerator::GenerateMipChain(
+        static_cast<const uint8_t*>(texture.data->data()) + layout.dataOffset, texture.width, texture.height, layout.rowPitch,
+        texture.format, params, mipData, mipLayout))
+        return;
+
+    texture.data = std::make_shared<VectorBlob>(std::move(mipData));
+
+    texture.mipLevels = uint32_t(mipLayout.size());
+    texture.dataLayout[0].resize(texture.mipLevels);
+    for (uint32_t mipLevel = 0; mipLevel < texture.mipLevels; mipLevel++)
+    {
+        TextureSubresourceData& subresource = texture.dataLayout[0][mipLevel];
+        subresource.dataOffset = mipLayout[mipLevel].dataOffset;
+        subresource.rowPitch = mipLayout[mipLevel].rowPitch;
+        subresource.depthPitch = 0;
+        subresource.dataSize = mipLayout[mipLevel].dataSize;
+    }
+
+    // The texture has its full mip chain now, no need to generate mips with blits on the GPU
+    texture.isRenderTarget = false;
+}
+
 uint GetMipLevelsNum(uint width, uint height)
 {
     uint size = std::min(width, height);
@@ -354,9 +468,18 @@ void TextureCache::FinalizeTexture(
     CommonRenderPasses* passes,
     nvrhi::ICommandList* commandList)
 {
+    DONUT_PROFILE_SCOPE("TextureCache::FinalizeTexture");
+
     assert(texture->data);
     assert(commandList);
 
+    uint32_t numTailMips = 0;
+    if (m_StreamingEnabled && IsTextureStreamable(*texture, numTailMips))
+    {
+        FinalizeStreamedTexture(texture, numTailMips, commandList);
+        return;
+    }
+
     uint originalWidth = texture->width;
     uint originalHeight = texture->height;
 
@@ -486,6 +609,280 @@ void TextureCache::FinalizeTexture(
     ++m_TexturesFinalized;
 }
 
+bool TextureCache::IsTextureStreamable(const TextureData& texture, uint32_t& outNumTailMips) const
+{
+    if (texture.dimension != nvrhi::TextureDimension::Texture2D || texture.arraySize != 1 || texture.mipLevels <= 1)
+        return false;
+
+    if (m_MaxTextureSize > 0 && std::max(texture.width, texture.height) > m_MaxTextureSize)
+        return false;
+
+    outNumTailMips = 0;
+    for (uint32_t mipLevel = 0; mipLevel < texture.mipLevels; mipLevel++)
+    {
+        if (std::max(texture.width >> mipLevel, texture.height >> mipLevel) <= m_StreamingTailSize)
+            ++outNumTailMips;
+    }
+
+    outNumTailMips = std::max(outNumTailMips, 1u);
+
+    if (outNumTailMips >= texture.mipLevels)
+        return false; // the whole texture is a tail, nothing to stream
+
+    // Block-compressed textures can only be created with top-level sizes that are a multiple of the block size,
+    // so every level that can become the top level of a streamed texture must satisfy that.
+    const nvrhi::FormatInfo& formatInfo = nvrhi::getFormatInfo(texture.format);
+    if (formatInfo.blockSize > 1)
+    {
+        for (uint32_t mipLevel = 0; mipLevel <= texture.mipLevels - outNumTailMips; mipLevel++)
+        {
+            if ((texture.width >> mipLevel) % formatInfo.blockSize != 0 || (texture.height >> mipLevel) % formatInfo.blockSize != 0)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void TextureCache::FinalizeStreamedTexture(
+    const std::shared_ptr<TextureData>& texture,
+    uint32_t numTailMips,
+    nvrhi::ICommandList* commandList)
+{
+    std::vector<uint64_t> mipSizes(texture->mipLevels);
+    for (uint32_t mipLevel = 0; mipLevel < texture->mipLevels; mipLevel++)
+        mipSizes[mipLevel] = texture->dataLayout[0][mipLevel].dataSize;
+
+    std::lock_guard<std::mutex> guard(m_StreamingMutex);
+
+    TextureResidencyPolicy::TextureId id = m_ResidencyPolicy.RegisterTexture(mipSizes, numTailMips);
+    if (m_StreamedTextures.size() <= id)
+        m_StreamedTextures.resize(id + 1);
+    m_StreamedTextures[id] = texture;
+
+    texture->streamingId = id;
+
+    CreateStreamedTextureMips(*texture, m_ResidencyPolicy.GetTailMip(id), commandList);
+
+    ++m_TexturesFinalized;
+}
+
+void TextureCache::CreateStreamedTextureMips(TextureData& texture, uint32_t firstMip, nvrhi::ICommandList* commandList)
+{
+    assert(firstMip < texture.mipLevels);
+    assert(texture.data || (texture.texture && firstMip >= texture.residentMip));
+
+    // Streamed textures return to the shader resource state after every command list instead of having
+    // a permanent state, so that coarser versions can be copied from them when the file data is gone
+    nvrhi::TextureDesc textureDesc;
+    textureDesc.format = texture.format;
+    textureDesc.width = std::max(texture.width >> firstMip, 1u);
+    textureDesc.height = std::max(texture.height >> firstMip, 1u);
+    textureDesc.mipLevels = texture.mipLevels - firstMip;
+    textureDesc.dimension = texture.dimension;
+    textureDesc.debugName = texture.path;
+    textureDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+    textureDesc.keepInitialState = true;
+    nvrhi::TextureHandle newTexture = m_Device->createTexture(textureDesc);
+
+    for (uint32_t mipLevel = 0; mipLevel < textureDesc.mipLevels; mipLevel++)
+    {
+        if (texture.data)
+        {
+            const char* dataPointer = static_cast<const char*>(texture.data->data());
+            const TextureSubresourceData& layout = texture.dataLayout[0][firstMip + mipLevel];
+
+            commandList->writeTexture(newTexture, 0, mipLevel, dataPointer + layout.dataOffset,
+                layout.rowPitch, layout.depthPitch);
+        }
+        else
+        {
+            commandList->copyTexture(newTexture, nvrhi::TextureSlice().setMipLevel(mipLevel),
+                texture.texture, nvrhi::TextureSlice().setMipLevel(firstMip - texture.residentMip + mipLevel));
+        }
+    }
+
+    // The previous version of the texture is kept alive by NVRHI until the GPU is done with it
+    const bool replaced = texture.texture != nullptr;
+    texture.texture = newTexture;
+    texture.residentMip = firstMip;
+
+    // Everything that can be streamed in is resident now, so the file can be read again if it's ever needed.
+    // Textures that come from memory have nothing to read and keep their data.
+    if (firstMip == 0 && texture.isFromFile)
+        texture.data = nullptr;
+
+    if (m_DescriptorTable)
+    {
+        // The descriptor of a recreated texture may be in use by the frames in flight, so the new texture
+        // gets a new descriptor, and the old one is released by UpdateStreaming when those frames are finished.
+        if (texture.bindlessDescriptor.IsValid())
+            m_DescriptorsToRetire.push_back(std::move(texture.bindlessDescriptor));
+
+        texture.bindlessDescriptor = m_DescriptorTable->CreateDescriptorHandle(nvrhi::BindingSetItem::Texture_SRV(0, newTexture));
+    }
+
+    if (replaced)
+        ++LoadedTexture::replacementGeneration;
+}
+
+bool TextureCache::ReloadStreamedTextureData(TextureData& texture)
+{
+    DONUT_PROFILE_SCOPE("TextureCache::ReloadStreamedTextureData");
+
+    // Decode the file into a temporary object and take its data if it still matches the texture
+    std::shared_ptr<TextureData> reloaded = CreateTextureData();
+    reloaded->forceSRGB = texture.forceSRGB;
+    reloaded->path = texture.path;
+    reloaded->isFromFile = true;
+
+    const std::filesystem::path path = texture.path;
+    std::shared_ptr<IBlob> fileData = ReadTextureFile(path);
+    if (!fileData || !FillTextureData(fileData, reloaded, path.extension().generic_string(), ""))
+        return false;
+
+    if (reloaded->format != texture.format || reloaded->width != texture.width || reloaded->height != texture.height ||
+        reloaded->mipLevels != texture.mipLevels)
+    {
+        log::message(m_ErrorLogSeverity, "Texture file '%s' has changed since it was loaded, can't stream it", texture.path.c_str());
+        return false;
+    }
+
+    texture.data = std::move(reloaded->data);
+    texture.dataLayout = std::move(reloaded->dataLayout);
+    return true;
+}
+
+void TextureCache::ReleaseRetiredDescriptors()
+{
+    while (!m_RetiredDescriptors.empty() && m_Device->pollEventQuery(m_RetiredDescriptors.front().query))
+        m_RetiredDescriptors.pop();
+
+    // The descriptors replaced by the previous update could be read by the frames submitted up to now,
+    // which have used the new descriptors since Scene::RefreshBuffers saw the replacement
+    if (!m_DescriptorsToRetire.empty())
+    {
+        RetiredDescriptorBatch batch;
+        batch.query = m_Device->createEventQuery();
+        batch.descriptors = std::move(m_DescriptorsToRetire);
+        m_DescriptorsToRetire.clear();
+        m_Device->setEventQuery(batch.query, nvrhi::CommandQueue::Graphics);
+        m_RetiredDescriptors.push(std::move(batch));
+    }
+}
+
+uint32_t TextureCache::GetRequiredStreamingMip(const TextureData& texture, float screenSizeInPixels) const
+{
+    // Pick the level whose size matches the screen size of the object, assuming that the texture is mapped over it once
+    float textureSize = float(std::max(texture.width, texture.height));
+    float mipLevel = std::log2(textureSize / std::max(screenSizeInPixels, 1.f)) + m_StreamingMipBias;
+    return uint32_t(std::clamp(std::floor(mipLevel), 0.f, float(texture.mipLevels - 1)));
+}
+
+void TextureCache::SetStreamingMemoryBudget(uint64_t bytes)
+{
+    std::lock_guard<std::mutex> guard(m_StreamingMutex);
+
+    m_ResidencyPolicy.SetMemoryBudget(bytes);
+}
+
+void TextureCache::ReportTextureUsage(const std::shared_ptr<LoadedTexture>& _texture, float screenSizeInPixels)
+{
+    TextureData* texture = static_cast<TextureData*>(_texture.get());
+
+    if (!texture || !texture->IsStreamed())
+        return;
+
+    uint32_t requiredMip = GetRequiredStreamingMip(*texture, screenSizeInPixels);
+
+    std::lock_guard<std::mutex> guard(m_StreamingMutex);
+
+    m_ResidencyPolicy.ReportRequiredMip(texture->streamingId, requiredMip, m_StreamingFrameIndex);
+}
+
+void TextureCache::ReportMaterialUsage(const Material& material, float screenSizeInPixels)
+{
+    ReportTextureUsage(material.baseOrDiffuseTexture, screenSizeInPixels);
+    ReportTextureUsage(material.metalRoughOrSpecularTexture, screenSizeInPixels);
+    ReportTextureUsage(material.normalTexture, screenSizeInPixels);
+    ReportTextureUsage(material.emissiveTexture, screenSizeInPixels);
+    ReportTextureUsage(material.occlusionTexture, screenSizeInPixels);
+    ReportTextureUsage(material.transmissionTexture, screenSizeInPixels);
+    ReportTextureUsage(material.opacityTexture, screenSizeInPixels);
+}
+
+void TextureCache::ReportMaterialUsage(const std::vector<MaterialUsage>& usages)
+{
+    std::lock_guard<std::mutex> guard(m_StreamingMutex);
+
+    for (const MaterialUsage& usage : usages)
+    {
+        for (const std::shared_ptr<LoadedTexture>* _texture : { &usage.material->baseOrDiffuseTexture, &usage.material->metalRoughOrSpecularTexture,
+            &usage.material->normalTexture, &usage.material->emissiveTexture, &usage.material->occlusionTexture,
+            &usage.material->transmissionTexture, &usage.material->opacityTexture })
+        {
+            const TextureData* texture = static_cast<const TextureData*>(_texture->get());
+            if (texture && texture->IsStreamed())
+            {
+                m_ResidencyPolicy.ReportRequiredMip(texture->streamingId,
+                    GetRequiredStreamingMip(*texture, usage.screenSizeInPixels), m_StreamingFrameIndex);
+            }
+        }
+    }
+}
+
+bool TextureCache::UpdateStreaming()
+{
+    DONUT_PROFILE_SCOPE("TextureCache::UpdateStreaming");
+
+    std::lock_guard<std::mutex> guard(m_StreamingMutex);
+
+    ReleaseRetiredDescriptors();
+
+    // Forget about the textures that have been released since the last update
+    for (size_t id = 0; id < m_StreamedTextures.size(); id++)
+    {
+        auto textureId = TextureResidencyPolicy::TextureId(id);
+        if (m_StreamedTextures[id].expired() && m_ResidencyPolicy.IsTextureRegistered(textureId))
+            m_ResidencyPolicy.UnregisterTexture(textureId);
+    }
+
+    m_ResidencyPolicy.Update(m_StreamingFrameIndex, m_StreamingRequests);
+    ++m_StreamingFrameIndex;
+
+    if (m_StreamingRequests.empty())
+        return false;
+
+    if (!m_CommandList)
+    {
+        m_CommandList = m_Device->createCommandList();
+    }
+
+    m_CommandList->open();
+
+    for (const TextureResidencyPolicy::Request& request : m_StreamingRequests)
+    {
+        std::shared_ptr<TextureData> texture = m_StreamedTextures[request.texture].lock();
+        if (!texture)
+            continue;
+
+        // Coarser mips are copied from the current texture, finer ones need the file data
+        if (!texture->data && request.requestedMip < texture->residentMip && !ReloadStreamedTextureData(*texture))
+            continue;
+
+        CreateStreamedTextureMips(*texture, request.requestedMip, m_CommandList);
+        m_ResidencyPolicy.SetResidentMip(request.texture, request.requestedMip);
+
+        log::message(m_InfoLogSeverity, "Streamed %s to mip %d (was %d)", texture->path.c_str(),
+            request.requestedMip, request.currentMip);
+    }
+
+    m_CommandList->close();
+    m_Device->executeCommandList(m_CommandList);
+
+    return true;
+}
+
 void TextureCache::TextureLoaded(std::shared_ptr<TextureData> texture)
 {
     std::lock_guard<std::mutex> guard(m_TexturesToFinalizeMutex);
@@ -511,6 +908,7 @@ std::shared_ptr<LoadedTexture> TextureCache::LoadTextureFromFile(
 
     texture->forceSRGB = sRGB;
     texture->path = path.generic_string();
+    texture->isFromFile = true;
 
     auto fileData = ReadTextureFile(path);
     if (fileData)
@@ -539,6 +937,7 @@ std::shared_ptr<LoadedTexture> TextureCache::LoadTextureFromFileDeferred(
 
     texture->forceSRGB = sRGB;
     texture->path = path.generic_string();
+    texture->isFromFile = true;
 
     auto fileData = ReadTextureFile(path);
     if (fileData)
@@ -571,13 +970,16 @@ std::shared_ptr<LoadedTexture> TextureCache::LoadTextureFromFileAsync(
 
     texture->forceSRGB = sRGB;
     texture->path = path.generic_string();
+    texture->isFromFile = true;
 
-    executor.async([this, texture, path]()
+    executor.async([this, texture, path, &executor]()
     {
+        DONUT_PROFILE_SCOPE("TextureCache::LoadTextureFromFileAsync");
+
         auto fileData = ReadTextureFile(path);
         if (fileData)
         {
-            if (FillTextureData(fileData, texture, path.extension().generic_string(), ""))
+            if (FillTextureData(fileData, texture, path.extension().generic_string(), "", &executor))
             {
                 TextureLoaded(texture);
 
@@ -606,9 +1008,11 @@ std::shared_ptr<LoadedTexture> TextureCache::LoadTextureFromMemoryAsync(
     texture->path = name;
     texture->mimeType = mimeType;
 
-    executor.async([this, texture, data, mimeType]()
+    executor.async([this, texture, data, mimeType, &executor]()
         {
-            if (FillTextureData(data, texture, "", mimeType))
+            DONUT_PROFILE_SCOPE("TextureCache::LoadTextureFromMemoryAsync");
+
+            if (FillTextureData(data, texture, "", mimeType, &executor))
             {
                 TextureLoaded(texture);
 
@@ -685,6 +1089,8 @@ std::shared_ptr<TextureData> TextureCache::GetLoadedTexture(std::filesystem::pat
 
 bool TextureCache::ProcessRenderingThreadCommands(CommonRenderPasses& passes, float timeLimitMilliseconds)
 {
+    DONUT_PROFILE_SCOPE("TextureCache::ProcessRenderingThreadCommands");
+
     using namespace std::chrono;
 
     time_point<high_resolution_clock> startTime = high_resolution_clock::now();
@@ -750,6 +1156,106 @@ void TextureCache::SetMaxTextureSize(uint32_t size)
 
 namespace donut::engine
 {
+    namespace
+    {
+        enum class ImageFileFormat { Unknown, BMP, PNG, JPG, TGA };
+
+        ImageFileFormat GetImageFileFormat(const char* fileName)
+        {
+            // Find the file's extension
+            char const* ext = strrchr(fileName, '.');
+
+            if (!ext)
+                return ImageFileFormat::Unknown; // No extension fond in the file name
+
+            if (strcasecmp(ext, ".bmp") == 0)
+                return ImageFileFormat::BMP;
+            if (strcasecmp(ext, ".png") == 0)
+                return ImageFileFormat::PNG;
+            if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)
+                return ImageFileFormat::JPG;
+            if (strcasecmp(ext, ".tga") == 0)
+                return ImageFileFormat::TGA;
+
+            return ImageFileFormat::Unknown;
+        }
+
+        // Copies mapped RGBA8 data into a densely packed buffer with the given number of channels, for stb_image.
+        void PackImageRows(uint8_t const* pData, size_t rowPitch, uint32_t width, uint32_t height, int channels, uint8_t* dstData)
+        {
+            for (uint32_t row = 0; row < height; ++row)
+            {
+                uint8_t* dstRow = dstData + size_t(row) * width * channels;
+                uint8_t const* srcRow = pData + row * rowPitch;
+
+                if (channels == 4)
+                {
+                    // Simple row copy
+                    memcpy(dstRow, srcRow, width * channels);
+                }
+                else
+                {
+                    // Convert 4 channels to 3
+                    for (uint32_t col = 0; col < width; ++col)
+                    {
+                        dstRow[0] = srcRow[0];
+                        dstRow[1] = srcRow[1];
+                        dstRow[2] = srcRow[2];
+                        dstRow += 3;
+                        srcRow += 4;
+                    }
+                }
+            }
+        }
+
+        bool WriteImageFile(const char* fileName, ImageFileFormat format, uint32_t width, uint32_t height, int channels, uint8_t const* pData)
+        {
+            switch(format)
+            {
+                case ImageFileFormat::BMP: 
+                    return stbi_write_bmp(fileName, int(width), int(height), channels, pData) != 0;
+                case ImageFileFormat::PNG: 
+                    return stbi_write_png(fileName, int(width), int(height), channels, pData, width * channels) != 0;
+                case ImageFileFormat::JPG: 
+                    return stbi_write_jpg(fileName, int(width), int(height), channels, pData, /* quality = */ 99) != 0;
+                case ImageFileFormat::TGA: 
+                    return stbi_write_tga(fileName, int(width), int(height), channels, pData) != 0;
+                default:
+                    return false;
+            }
+        }
+
+        // Returns the texture to copy from: either the source texture itself if it's RGBA8,
+        // or a temporary SRGBA8 texture that the source has been blitted into.
+        nvrhi::TextureHandle GetRGBA8Texture(
+            nvrhi::IDevice* device,
+            CommonRenderPasses* pPasses,
+            nvrhi::ICommandList* commandList,
+            nvrhi::ITexture* texture)
+        {
+            nvrhi::TextureDesc desc = texture->getDesc();
+
+            switch (desc.format)
+            {
+            case nvrhi::Format::RGBA8_UNORM:
+            case nvrhi::Format::SRGBA8_UNORM:
+                return texture;
+            default: {
+                desc.format = nvrhi::Format::SRGBA8_UNORM;
+                desc.isRenderTarget = true;
+                desc.initialState = nvrhi::ResourceStates::RenderTarget;
+                desc.keepInitialState = true;
+
+                nvrhi::TextureHandle tempTexture = device->createTexture(desc);
+                nvrhi::FramebufferHandle tempFramebuffer = device->createFramebuffer(nvrhi::FramebufferDesc().addColorAttachment(tempTexture));
+
+                pPasses->BlitTexture(commandList, tempFramebuffer, texture);
+                return tempTexture;
+            }
+            }
+        }
+    }
+
     bool SaveTextureToFile(
         nvrhi::IDevice* device,
         CommonRenderPasses* pPasses,
@@ -761,32 +1267,14 @@ namespace donut::engine
         if (!fileName)
             return false;
 
-        // Find the file's extension
-        char const* ext = strrchr(fileName, '.');
-
-        if (!ext)
-            return false; // No extension fond in the file name
-
         // Determine the image format from the extension
-        enum { BMP, PNG, JPG, TGA } destFormat;
-        if (strcasecmp(ext, ".bmp") == 0)
-            destFormat = BMP;
-        else if (strcasecmp(ext, ".png") == 0)
-            destFormat = PNG;
-        else if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)
-            destFormat = JPG;
-        else if (strcasecmp(ext, ".tga") == 0)
-            destFormat = TGA;
-        else
+        ImageFileFormat destFormat = GetImageFileFormat(fileName);
+        if (destFormat == ImageFileFormat::Unknown)
             return false; // Unknown file type
         
-        if (destFormat == JPG)
+        if (destFormat == ImageFileFormat::JPG)
             saveAlphaChannel = false;
 
-        nvrhi::TextureDesc desc = texture->getDesc();
-        nvrhi::TextureHandle tempTexture;
-        nvrhi::FramebufferHandle tempFramebuffer;
-
         nvrhi::CommandListHandle commandList = device->createCommandList();
         commandList->open();
 
@@ -796,23 +1284,8 @@ namespace donut::engine
         }
 
         // If the source texture format is not RGBA8, create a temporary texture and blit into it to convert
-        switch (desc.format)
-        {
-        case nvrhi::Format::RGBA8_UNORM:
-        case nvrhi::Format::SRGBA8_UNORM:
-            tempTexture = texture;
-            break;
-        default:
-            desc.format = nvrhi::Format::SRGBA8_UNORM;
-            desc.isRenderTarget = true;
-            desc.initialState = nvrhi::ResourceStates::RenderTarget;
-            desc.keepInitialState = true;
-
-            tempTexture = device->createTexture(desc);
-            tempFramebuffer = device->createFramebuffer(nvrhi::FramebufferDesc().addColorAttachment(tempTexture));
-            
-            pPasses->BlitTexture(commandList, tempFramebuffer, texture);
-        }
+        nvrhi::TextureHandle tempTexture = GetRGBA8Texture(device, pPasses, commandList, texture);
+        const nvrhi::TextureDesc& desc = tempTexture->getDesc();
 
         // Create a staging texture to access the data from the CPU, copy the data into it
         nvrhi::StagingTextureHandle stagingTexture = device->createStagingTexture(desc, nvrhi::CpuAccessMode::Read);
@@ -835,76 +1308,84 @@ namespace donut::engine
         if (!pData)
             return false;
 
-        uint8_t* newData = nullptr;
+        std::vector<uint8_t> newData;
         int channels = saveAlphaChannel ? 4 : 3;
 
         // If the mapped data is not laid out in a densely packed format with the right number of channels,
         // create a temporary buffer and move the data into the right layout for stb_image.
         if (rowPitch != desc.width * channels)
         {
-            newData = new uint8_t[desc.width * desc.height * channels];
+            newData.resize(size_t(desc.width) * desc.height * channels);
+            PackImageRows(pData, rowPitch, desc.width, desc.height, channels, newData.data());
+            pData = newData.data();
+        }
 
-            for (uint32_t row = 0; row < desc.height; ++row)
-            {
-                uint8_t* dstRow = newData + row * desc.width * channels;
-                uint8_t const* srcRow = pData + row * rowPitch;
+        // Write the output image
+        bool writeSuccess = WriteImageFile(fileName, destFormat, desc.width, desc.height, channels, pData);
 
-                if (channels == 4)
-                {
-                    // Simple row copy
-                    memcpy(dstRow, srcRow, desc.width * channels);
-                }
-                else
+        device->unmapStagingTexture(stagingTexture);
+
+        return writeSuccess;
+    }
+
+    bool SaveTextureToFileAsync(
+        nvrhi::IDevice* device,
+        CommonRenderPasses* pPasses,
+        nvrhi::ICommandList* commandList,
+        nvrhi::ITexture* texture,
+        const char* fileName,
+        ReadbackQueue& readbackQueue,
+        bool saveAlphaChannel,
+        std::function<void(bool success)> onComplete)
+    {
+        if (!fileName)
+            return false;
+
+        ImageFileFormat destFormat = GetImageFileFormat(fileName);
+        if (destFormat == ImageFileFormat::Unknown)
+            return false;
+
+        if (destFormat == ImageFileFormat::JPG)
+            saveAlphaChannel = false;
+
+        // The temporary texture is kept alive by the callback until the copy is complete
+        nvrhi::TextureHandle tempTexture = GetRGBA8Texture(device, pPasses, commandList, texture);
+        int channels = saveAlphaChannel ? 4 : 3;
+
+        readbackQueue.RequestTexture(commandList, tempTexture, nvrhi::TextureSlice(),
+            [tempTexture, &readbackQueue, fileName = std::string(fileName), destFormat, channels, onComplete = std::move(onComplete)]
+            (const void* data, size_t rowPitch, const nvrhi::TextureDesc& desc)
+            {
+                if (!data)
                 {
-                    // Convert 4 channels to 3
-                    for (uint32_t col = 0; col < desc.width; ++col)
-                    {
-                        dstRow[0] = srcRow[0];
-                        dstRow[1] = srcRow[1];
-                        dstRow[2] = srcRow[2];
-                        dstRow += 3;
-                        srcRow += 4;
-                    }
+                    if (onComplete)
+                        onComplete(false);
+                    return;
                 }
-            }
 
-            pData = newData;
-        }
+                // Only repack the rows here while the staging texture is mapped, and leave the slow part - encoding - to the worker
+                auto packedData = std::make_shared<std::vector<uint8_t>>(size_t(desc.width) * desc.height * channels);
+                PackImageRows(static_cast<uint8_t const*>(data), rowPitch, desc.width, desc.height, channels, packedData->data());
 
-        // Write the output image
-        bool writeSuccess = false;
-        switch(destFormat)
-        {
-            case BMP: 
-                writeSuccess = stbi_write_bmp(fileName, int(desc.width), int(desc.height), channels, pData) != 0;
-                break;
-            case PNG: 
-                writeSuccess = stbi_write_png(fileName, int(desc.width), int(desc.height), channels, pData, desc.width * channels) != 0;
-                break;
-            case JPG: 
-                writeSuccess = stbi_write_jpg(fileName, int(desc.width), int(desc.height), channels, pData, /* quality = */ 99) != 0;
-                break;
-            case TGA: 
-                writeSuccess = stbi_write_tga(fileName, int(desc.width), int(desc.height), channels, pData) != 0;
-                break;
-        }
-        
-        if (newData)
-        {
-            delete[] newData;
-            newData = nullptr;
-        }
+                readbackQueue.RunOnWorkerThread([packedData, fileName, destFormat, channels, width = desc.width, height = desc.height, onComplete]()
+                {
+                    bool writeSuccess = WriteImageFile(fileName.c_str(), destFormat, width, height, channels, packedData->data());
+                    if (!writeSuccess)
+                        log::warning("Couldn't write image file '%s'", fileName.c_str());
 
-        device->unmapStagingTexture(stagingTexture);
+                    if (onComplete)
+                        onComplete(writeSuccess);
+                });
+            });
 
-        return writeSuccess;
+        return true;
     }
 
     bool TextureCache::IsTextureLoaded(const std::shared_ptr<LoadedTexture>& _texture)
     {
         TextureData* texture = static_cast<TextureData*>(_texture.get());
 
-        return texture && texture->data;
+        return texture && texture->data && !texture->IsStreamed();
     }
 
     bool TextureCache::IsTextureFinalized(const std::shared_ptr<LoadedTexture>& texture)
@@ -0,0 +1,236 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/TextureResidency.h>
+
+#include <algorithm>
+#include <cassert>
+#include <queue>
+
+using namespace donut::engine;
+
+TextureResidencyPolicy::TextureId TextureResidencyPolicy::RegisterTexture(const std::vector<uint64_t>& mipSizes, uint32_t numTailMips)
+{
+    assert(!mipSizes.empty());
+
+    TextureId id;
+    if (!m_FreeIds.empty())
+    {
+        id = m_FreeIds.back();
+        m_FreeIds.pop_back();
+    }
+    else
+    {
+        id = TextureId(m_Textures.size());
+        m_Textures.emplace_back();
+    }
+
+    uint32_t mipLevels = uint32_t(mipSizes.size());
+    numTailMips = std::clamp(numTailMips, 1u, mipLevels);
+
+    TextureState& state = m_Textures[id];
+    state = TextureState();
+    state.mipSizes = mipSizes;
+    state.tailMip = mipLevels - numTailMips;
+    state.residentMip = state.tailMip;
+    state.requiredMip = state.tailMip;
+    state.registered = true;
+
+    m_ResidentMemory += GetMemory(state, state.residentMip);
+
+    return id;
+}
+
+void TextureResidencyPolicy::UnregisterTexture(TextureId texture)
+{
+    if (texture >= m_Textures.size() || !m_Textures[texture].registered)
+        return;
+
+    TextureState& state = m_Textures[texture];
+    m_ResidentMemory -= GetMemory(state, state.residentMip);
+    state = TextureState();
+    m_FreeIds.push_back(texture);
+}
+
+void TextureResidencyPolicy::ReportRequiredMip(TextureId texture, uint32_t mipLevel, uint32_t frameIndex)
+{
+    if (texture >= m_Textures.size() || !m_Textures[texture].registered)
+        return;
+
+    TextureState& state = m_Textures[texture];
+    mipLevel = std::min(mipLevel, state.tailMip);
+
+    if (!state.used || state.lastUsedFrame != frameIndex)
+        state.requiredMip = mipLevel;
+    else
+        state.requiredMip = std::min(state.requiredMip, mipLevel);
+
+    state.lastUsedFrame = frameIndex;
+    state.used = true;
+}
+
+void TextureResidencyPolicy::SetResidentMip(TextureId texture, uint32_t mipLevel)
+{
+    if (texture >= m_Textures.size() || !m_Textures[texture].registered)
+        return;
+
+    TextureState& state = m_Textures[texture];
+    mipLevel = std::min(mipLevel, state.tailMip);
+
+    m_ResidentMemory -= GetMemory(state, state.residentMip);
+    state.residentMip = mipLevel;
+    m_ResidentMemory += GetMemory(state, state.residentMip);
+}
+
+uint32_t TextureResidencyPolicy::GetResidentMip(TextureId texture) const
+{
+    assert(texture < m_Textures.size());
+    return m_Textures[texture].residentMip;
+}
+
+uint32_t TextureResidencyPolicy::GetTailMip(TextureId texture) const
+{
+    assert(texture < m_Textures.size());
+    return m_Textures[texture].tailMip;
+}
+
+uint64_t TextureResidencyPolicy::GetTextureMemory(TextureId texture, uint32_t finestMip) const
+{
+    assert(texture < m_Textures.size());
+    return GetMemory(m_Textures[texture], finestMip);
+}
+
+uint64_t TextureResidencyPolicy::GetMemory(const TextureState& state, uint32_t finestMip)
+{
+    uint64_t size = 0;
+    for (size_t mip = finestMip; mip < state.mipSizes.size(); mip++)
+        size += state.mipSizes[mip];
+    return size;
+}
+
+uint32_t TextureResidencyPolicy::GetDesiredMip(const TextureState& state, uint32_t frameIndex) const
+{
+    if (!state.used || frameIndex - state.lastUsedFrame > m_FeedbackLifetime)
+        return state.tailMip;
+
+    return state.requiredMip;
+}
+
+void TextureResidencyPolicy::Update(uint32_t frameIndex, std::vector<Request>& outRequests)
+{
+    outRequests.clear();
+
+    std::vector<uint32_t> targetMips(m_Textures.size(), 0);
+    uint64_t totalMemory = 0;
+
+    for (size_t id = 0; id < m_Textures.size(); id++)
+    {
+        const TextureState& state = m_Textures[id];
+        if (!state.registered)
+            continue;
+
+        targetMips[id] = GetDesiredMip(state, frameIndex);
+        totalMemory += GetMemory(state, targetMips[id]);
+    }
+
+    if (m_MemoryBudget != 0 && totalMemory > m_MemoryBudget)
+    {
+        // Drop the finest level of the least recently used texture, one level at a time,
+        // preferring the largest levels among textures used on the same frame.
+        struct Candidate
+        {
+            uint32_t age;
+            uint64_t size;
+            TextureId id;
+
+            bool operator<(const Candidate& other) const
+            {
+                if (age != other.age)
+                    return age < other.age;
+                return size < other.size;
+            }
+        };
+
+        std::priority_queue<Candidate> candidates;
+
+        auto getAge = [this, frameIndex](const TextureState& state)
+        {
+            return state.used ? frameIndex - state.lastUsedFrame : ~0u;
+        };
+
+        for (size_t id = 0; id < m_Textures.size(); id++)
+        {
+            const TextureState& state = m_Textures[id];
+            if (state.registered && targetMips[id] < state.tailMip)
+                candidates.push(Candidate{ getAge(state), state.mipSizes[targetMips[id]], TextureId(id) });
+        }
+
+        while (totalMemory > m_MemoryBudget && !candidates.empty())
+        {
+            Candidate candidate = candidates.top();
+            candidates.pop();
+
+            const TextureState& state = m_Textures[candidate.id];
+            uint32_t& targetMip = targetMips[candidate.id];
+
+            totalMemory -= state.mipSizes[targetMip];
+            ++targetMip;
+
+            if (targetMip < state.tailMip)
+                candidates.push(Candidate{ candidate.age, state.mipSizes[targetMip], candidate.id });
+        }
+    }
+
+    std::vector<Request> promotions;
+
+    for (size_t id = 0; id < m_Textures.size(); id++)
+    {
+        const TextureState& state = m_Textures[id];
+        if (!state.registered || targetMips[id] == state.residentMip)
+            continue;
+
+        Request request;
+        request.texture = TextureId(id);
+        request.currentMip = state.residentMip;
+        request.requestedMip = targetMips[id];
+
+        if (request.IsEviction())
+            outRequests.push_back(request);
+        else
+            promotions.push_back(request);
+    }
+
+    // Stream in the most recently used textures first, and among those, the ones that are the most blurry.
+    std::sort(promotions.begin(), promotions.end(), [this](const Request& a, const Request& b)
+    {
+        const TextureState& stateA = m_Textures[a.texture];
+        const TextureState& stateB = m_Textures[b.texture];
+        if (stateA.lastUsedFrame != stateB.lastUsedFrame)
+            return int32_t(stateA.lastUsedFrame - stateB.lastUsedFrame) > 0;
+        return (a.currentMip - a.requestedMip) > (b.currentMip - b.requestedMip);
+    });
+
+    if (m_MaxPromotions != 0 && promotions.size() > m_MaxPromotions)
+        promotions.resize(m_MaxPromotions);
+
+    outRequests.insert(outRequests.end(), promotions.begin(), promotions.end());
+}
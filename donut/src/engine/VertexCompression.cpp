@@ -0,0 +1,179 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/VertexCompression.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace donut::math;
+using namespace donut::engine;
+
+void donut::engine::GetPositionDequantization(const box3& bounds, float3& outScale, float3& outBias)
+{
+    if (bounds.isempty() || !all(isfinite(bounds.m_mins)) || !all(isfinite(bounds.m_maxs)))
+    {
+        outScale = 0.f;
+        outBias = 0.f;
+        return;
+    }
+
+    outScale = bounds.diagonal() * (1.f / 65535.f);
+    outBias = bounds.m_mins;
+}
+
+vector<uint16_t, 4> donut::engine::QuantizePosition(const float3& position, const float3& scale, const float3& bias)
+{
+    vector<uint16_t, 4> result = { 0, 0, 0, 0 };
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (scale[axis] <= 0.f)
+            continue;
+
+        float quantized = std::round((position[axis] - bias[axis]) / scale[axis]);
+        result[axis] = uint16_t(std::clamp(quantized, 0.f, 65535.f));
+    }
+
+    return result;
+}
+
+uint16_t donut::engine::FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // Inf and NaN
+    if (exponent == 0xff)
+        return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+    int32_t halfExponent = int32_t(exponent) - 127 + 15;
+
+    if (halfExponent >= 0x1f)
+        return uint16_t(sign | 0x7c00);
+
+    if (halfExponent <= 0)
+    {
+        // Subnormal half, or too small and flushed to zero
+        if (halfExponent < -10)
+            return uint16_t(sign);
+
+        mantissa |= 0x800000;
+        uint32_t shift = uint32_t(14 - halfExponent);
+        uint32_t halfMantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+            ++halfMantissa;
+
+        return uint16_t(sign | halfMantissa);
+    }
+
+    // A carry out of the mantissa correctly increments the exponent, up to infinity
+    uint32_t half = sign | (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+
+    return uint16_t(half);
+}
+
+float donut::engine::HalfToFloat(uint16_t value)
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    if (exponent == 0)
+    {
+        float result = float(mantissa) * (1.f / 16777216.f);
+        return sign ? -result : result;
+    }
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+uint32_t donut::engine::PackTexCoordHalf(const float2& texCoord)
+{
+    return uint32_t(FloatToHalf(texCoord.x)) | (uint32_t(FloatToHalf(texCoord.y)) << 16);
+}
+
+uint32_t donut::engine::PackJointWeightsUnorm8(const float4& weights)
+{
+    float4 clamped = max(weights, float4(0.f));
+    float sum = clamped.x + clamped.y + clamped.z + clamped.w;
+    if (sum <= 0.f)
+        return 0;
+
+    clamped /= sum;
+
+    int quantized[4];
+    int total = 0;
+    int largest = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        quantized[i] = int(std::round(clamped[i] * 255.f));
+        total += quantized[i];
+        if (clamped[i] > clamped[largest])
+            largest = i;
+    }
+
+    quantized[largest] = std::clamp(quantized[largest] + 255 - total, 0, 255);
+
+    return uint32_t(quantized[0]) | (uint32_t(quantized[1]) << 8) | (uint32_t(quantized[2]) << 16) | (uint32_t(quantized[3]) << 24);
+}
+
+bool donut::engine::CanUse16BitIndices(const uint32_t* indices, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (indices[i] > 0xffff)
+            return false;
+    }
+
+    return true;
+}
+
+bool donut::engine::CanUseCompactTexCoords(const float2* texCoords, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const float2& texCoord = texCoords[i];
+        if (!(std::abs(texCoord.x) <= MaxCompactTexCoord && std::abs(texCoord.y) <= MaxCompactTexCoord))
+            return false;
+    }
+
+    return true;
+}
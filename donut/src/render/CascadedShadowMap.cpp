@@ -24,6 +24,8 @@
 #include <donut/render/DepthPass.h>
 #include <donut/render/DrawStrategy.h>
 #include <donut/render/PlanarShadowMap.h>
+#include <donut/render/ShadowCasterCache.h>
+#include <donut/engine/FramebufferFactory.h>
 
 using namespace donut::math;
 using namespace donut::engine;
@@ -36,6 +38,7 @@ CascadedShadowMap::CascadedShadowMap(
     int numPerObjectShadows,
     nvrhi::Format format,
     bool isUAV)
+    : m_Device(device)
 {
     assert(numCascades > 0);
     assert(numCascades <= 4);
@@ -57,6 +60,9 @@ CascadedShadowMap::CascadedShadowMap(
 	desc.isUAV = isUAV;
     m_ShadowMapTexture = device->createTexture(desc);
 
+    m_Framebuffer = std::make_shared<FramebufferFactory>(device);
+    m_Framebuffer->DepthTarget = m_ShadowMapTexture;
+
     nvrhi::Viewport cascadeViewport = nvrhi::Viewport(float(resolution), float(resolution));
 
     for (int cascade = 0; cascade < numCascades; cascade++)
@@ -409,3 +415,89 @@ void CascadedShadowMap::Clear(nvrhi::ICommandList* commandList)
 
     commandList->clearDepthStencilTexture(m_ShadowMapTexture, nvrhi::AllSubresources, true, 1.f, depthFormatInfo.hasStencil, 0);
 }
+
+void CascadedShadowMap::EnableStaticCaching(bool enable)
+{
+    if (enable == IsStaticCachingEnabled())
+        return;
+
+    if (!enable)
+    {
+        m_CasterCache = nullptr;
+        m_StaticFramebuffer = nullptr;
+        m_StaticTexture = nullptr;
+        return;
+    }
+
+    nvrhi::TextureDesc desc = m_ShadowMapTexture->getDesc();
+    desc.debugName = "StaticShadowMap";
+    desc.isUAV = false;
+    m_StaticTexture = m_Device->createTexture(desc);
+
+    m_StaticFramebuffer = std::make_shared<FramebufferFactory>(m_Device);
+    m_StaticFramebuffer->DepthTarget = m_StaticTexture;
+
+    m_CasterCache = std::make_shared<ShadowCasterCache>();
+}
+
+void CascadedShadowMap::Render(
+    nvrhi::ICommandList* commandList,
+    const SceneGraph& sceneGraph,
+    uint32_t frameIndex,
+    InstancedOpaqueDrawStrategy& drawStrategy,
+    IGeometryPass& depthPass,
+    GeometryPassContext& passContext)
+{
+    if (!m_CasterCache)
+    {
+        Clear(commandList);
+
+        drawStrategy.SetInstanceFilter(nullptr);
+        for (int cascade = 0; cascade < m_NumberOfCascades; cascade++)
+        {
+            const PlanarView& view = *m_Cascades[cascade]->GetPlanarView();
+            drawStrategy.PrepareForView(sceneGraph.GetRootNode(), view);
+            RenderView(commandList, &view, nullptr, m_Framebuffer->GetFramebuffer(view), drawStrategy, depthPass, passContext);
+        }
+        return;
+    }
+
+    std::vector<const IView*> views;
+    for (int cascade = 0; cascade < m_NumberOfCascades; cascade++)
+        views.push_back(m_Cascades[cascade]->GetPlanarView().get());
+
+    m_CasterCache->Update(sceneGraph, views, frameIndex);
+
+    const ShadowCasterCache& casterCache = *m_CasterCache;
+    const nvrhi::FormatInfo& depthFormatInfo = nvrhi::getFormatInfo(m_ShadowMapTexture->getDesc().format);
+
+    for (int cascade = 0; cascade < m_NumberOfCascades; cascade++)
+    {
+        const ShadowCasterCache::ViewUpdate& update = casterCache.GetViewUpdate(cascade);
+        const PlanarView& view = *m_Cascades[cascade]->GetPlanarView();
+
+        if (update.renderStatic)
+        {
+            commandList->clearDepthStencilTexture(m_StaticTexture, nvrhi::TextureSubresourceSet(0, 1, cascade, 1), true, 1.f, depthFormatInfo.hasStencil, 0);
+
+            drawStrategy.SetInstanceFilter([&casterCache](const MeshInstance& instance) { return !casterCache.IsInstanceDynamic(instance); });
+            drawStrategy.PrepareForView(sceneGraph.GetRootNode(), view);
+            RenderView(commandList, &view, nullptr, m_StaticFramebuffer->GetFramebuffer(view), drawStrategy, depthPass, passContext);
+        }
+
+        if (update.renderDynamic)
+        {
+            const nvrhi::TextureSlice slice = nvrhi::TextureSlice().setArraySlice(cascade);
+            commandList->copyTexture(m_ShadowMapTexture, slice, m_StaticTexture, slice);
+
+            if (update.hasDynamicCasters)
+            {
+                drawStrategy.SetInstanceFilter([&casterCache](const MeshInstance& instance) { return casterCache.IsInstanceDynamic(instance); });
+                drawStrategy.PrepareForView(sceneGraph.GetRootNode(), view);
+                RenderView(commandList, &view, nullptr, m_Framebuffer->GetFramebuffer(view), drawStrategy, depthPass, passContext);
+            }
+        }
+    }
+
+    drawStrategy.SetInstanceFilter(nullptr);
+}
@@ -23,6 +23,7 @@
 #include <donut/render/DeferredLightingPass.h>
 #include <donut/render/DrawStrategy.h>
 #include <donut/render/GBuffer.h>
+#include <donut/render/LightClusteringPass.h>
 #include <donut/engine/FramebufferFactory.h>
 #include <donut/engine/ShaderFactory.h>
 #include <donut/engine/ShadowMap.h>
@@ -113,16 +114,29 @@ void donut::render::DeferredLightingPass::Init(const std::shared_ptr<engine::Sha
         m_BindingLayout = m_Device->createBindingLayout(layoutDesc);
         
         nvrhi::ComputePipelineDesc pipelineDesc;
-        pipelineDesc.CS = CreateComputeShader(*shaderFactory);
+        pipelineDesc.CS = CreateComputeShader(*shaderFactory, false);
         pipelineDesc.bindingLayouts = { m_BindingLayout };
         
         m_Pso = m_Device->createComputePipeline(pipelineDesc);
+
+        layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::ConstantBuffer(1));
+        layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(18));
+        layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(19));
+        m_ClusteredBindingLayout = m_Device->createBindingLayout(layoutDesc);
+
+        pipelineDesc.CS = CreateComputeShader(*shaderFactory, true);
+        pipelineDesc.bindingLayouts = { m_ClusteredBindingLayout };
+
+        m_ClusteredPso = m_Device->createComputePipeline(pipelineDesc);
     }
 }
 
-nvrhi::ShaderHandle DeferredLightingPass::CreateComputeShader(ShaderFactory& shaderFactory)
+nvrhi::ShaderHandle DeferredLightingPass::CreateComputeShader(ShaderFactory& shaderFactory, bool clusteredLighting)
 {
-    return shaderFactory.CreateAutoShader("donut/passes/deferred_lighting_cs.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_deferred_lighting_cs), nullptr, nvrhi::ShaderType::Compute);
+    std::vector<ShaderMacro> macros;
+    macros.push_back(ShaderMacro("CLUSTERED_LIGHTING", clusteredLighting ? "1" : "0"));
+
+    return shaderFactory.CreateAutoShader("donut/passes/deferred_lighting_cs.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_deferred_lighting_cs), &macros, nvrhi::ShaderType::Compute);
 }
 
 void DeferredLightingPass::Render(
@@ -160,6 +174,9 @@ void DeferredLightingPass::Render(
     {
         for (const auto& light : *inputs.lights)
         {
+            if (inputs.lightClusters && LightClusteringPass::IsClusteredLight(*light))
+                continue;
+
             if (light->shadowMap)
             {
                 if (!shadowMapTexture)
@@ -283,13 +300,25 @@ void DeferredLightingPass::Render(
             nvrhi::BindingSetItem::Sampler(3, m_CommonPasses->m_LinearClampSampler)
         };
 
-        nvrhi::BindingSetHandle bindingSet = m_BindingSets.GetOrCreateBindingSet(bindingSetDesc, m_BindingLayout);
+        nvrhi::IBindingLayout* bindingLayout = m_BindingLayout;
+        nvrhi::IComputePipeline* pipeline = m_Pso;
+
+        if (inputs.lightClusters)
+        {
+            bindingSetDesc.bindings.push_back(nvrhi::BindingSetItem::ConstantBuffer(1, inputs.lightClusters->GetConstantBuffer()));
+            bindingSetDesc.bindings.push_back(nvrhi::BindingSetItem::StructuredBuffer_SRV(18, inputs.lightClusters->GetLightBuffer()));
+            bindingSetDesc.bindings.push_back(nvrhi::BindingSetItem::StructuredBuffer_SRV(19, inputs.lightClusters->GetClusterBuffer()));
+            bindingLayout = m_ClusteredBindingLayout;
+            pipeline = m_ClusteredPso;
+        }
+
+        nvrhi::BindingSetHandle bindingSet = m_BindingSets.GetOrCreateBindingSet(bindingSetDesc, bindingLayout);
     
         view->FillPlanarViewConstants(deferredConstants.view);
         commandList->writeBuffer(m_DeferredLightingCB, &deferredConstants, sizeof(deferredConstants));
 
         nvrhi::ComputeState state;
-        state.pipeline = m_Pso;
+        state.pipeline = pipeline;
         state.bindings = { bindingSet };
         commandList->setComputeState(state);
 
@@ -232,6 +232,9 @@ nvrhi::BindingSetHandle DepthPass::CreateInputBindingSet(const BufferGroup* buff
 
 nvrhi::BindingSetHandle DepthPass::GetOrCreateInputBindingSet(const BufferGroup* bufferGroup)
 {
+    // Contexts may be used on several threads at once, see ParallelViewRecorder
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
     auto it = m_InputBindingSets.find(bufferGroup);
     if (it == m_InputBindingSets.end())
     {
@@ -259,6 +262,7 @@ void DepthPass::SetPushConstants(
     constants.startVertexLocation = args.startVertexLocation;
     constants.positionOffset = context.positionOffset;
     constants.texCoordOffset = context.texCoordOffset;
+    constants.formatFlags = context.formatFlags;
 
     commandList->setPushConstants(&constants, sizeof(constants));
 
@@ -344,10 +348,12 @@ void DepthPass::SetupInputBuffers(GeometryPassContext& abstractContext, const en
 {
     auto& context = static_cast<Context&>(abstractContext);
 
-    state.indexBuffer = { buffers->indexBuffer, nvrhi::Format::R32_UINT, 0 };
+    state.indexBuffer = { buffers->indexBuffer, buffers->getIndexFormat(), 0 };
 
     if (m_UseInputAssembler)
     {
+        assert(buffers->isInputAssemblerCompatible());
+
         state.vertexBuffers = {
             { buffers->vertexBuffer, 0, buffers->getVertexBufferRange(VertexAttribute::Position).byteOffset },
             { buffers->vertexBuffer, 1, buffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset },
@@ -359,5 +365,6 @@ void DepthPass::SetupInputBuffers(GeometryPassContext& abstractContext, const en
         context.inputBindingSet = GetOrCreateInputBindingSet(buffers);
         context.positionOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Position).byteOffset);
         context.texCoordOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset);
+        context.formatFlags = buffers->formatFlags;
     }
 }
@@ -22,8 +22,12 @@
 
 #include <donut/render/DrawStrategy.h>
 #include <donut/render/GeometryPasses.h>
+#include <donut/render/OcclusionCuller.h>
+#include <donut/engine/MeshSimplifier.h>
 #include <donut/engine/SceneGraph.h>
+#include <donut/engine/TextureCache.h>
 #include <donut/engine/View.h>
+#include <donut/core/profiler.h>
 
 using namespace donut::math;
 using namespace donut::engine;
@@ -47,6 +51,103 @@ void PassthroughDrawStrategy::SetData(const DrawItem* data, size_t count)
     m_Count = count;
 }
 
+struct MeshLodSelector::ViewLods
+{
+    struct Key
+    {
+        const MeshInstance* instance;
+        const MeshGeometry* geometry;
+
+        bool operator==(const Key& other) const { return instance == other.instance && geometry == other.geometry; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            size_t hash = std::hash<const void*>()(key.instance);
+            return hash ^ (std::hash<const void*>()(key.geometry) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+        }
+    };
+
+    struct Entry
+    {
+        uint32_t lod = 0;
+        uint32_t lastUsed = 0;
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    float3 viewOrigin = 0.f;
+    float projectedSizeScale = 0.f;
+    bool orthographic = false;
+    uint32_t generation = 0;
+};
+
+// Selection state of the geometries that haven't been drawn in the view for this many
+// BeginView calls is discarded, checked every EntryLifetime calls.
+static constexpr uint32_t EntryLifetime = 64;
+
+MeshLodSelector::MeshLodSelector() = default;
+MeshLodSelector::~MeshLodSelector() = default;
+
+MeshLodSelector::ViewLods* MeshLodSelector::BeginView(const IView& view)
+{
+    ViewLods* viewLods;
+    {
+        std::lock_guard lockGuard(m_Mutex);
+        std::unique_ptr<ViewLods>& entry = m_Views[&view];
+        if (!entry)
+            entry = std::make_unique<ViewLods>();
+        viewLods = entry.get();
+    }
+
+    ++viewLods->generation;
+    if (viewLods->generation % EntryLifetime == 0)
+    {
+        for (auto it = viewLods->entries.begin(); it != viewLods->entries.end(); )
+        {
+            if (viewLods->generation - it->second.lastUsed > EntryLifetime)
+                it = viewLods->entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // Number of pixels covered by an object of unit size at unit distance, or just unit size for orthographic views
+    nvrhi::Rect viewExtent = view.GetViewExtent();
+    float4x4 projection = view.GetProjectionMatrix(false);
+    viewLods->projectedSizeScale = 0.5f * float(viewExtent.height()) * projection[1][1];
+    viewLods->orthographic = view.IsOrthographicProjection();
+    viewLods->viewOrigin = view.GetViewOrigin();
+
+    return viewLods;
+}
+
+uint32_t MeshLodSelector::SelectLod(ViewLods& viewLods, const MeshInstance* instance, const MeshGeometry* geometry, const box3& globalBounds) const
+{
+    if (geometry->lods.empty())
+        return 0;
+
+    float radius = length(globalBounds.diagonal()) * 0.5f;
+    float errorToPixels = radius * viewLods.projectedSizeScale;
+    if (!viewLods.orthographic)
+    {
+        float distance = std::max(length(globalBounds.center() - viewLods.viewOrigin), radius);
+        errorToPixels = distance > 0.f ? errorToPixels / distance : 0.f;
+    }
+
+    ViewLods::Entry& entry = viewLods.entries[ViewLods::Key{ instance, geometry }];
+    entry.lod = SelectMeshLod(*geometry, errorToPixels, entry.lod, m_MaxPixelError, m_Hysteresis);
+    entry.lastUsed = viewLods.generation;
+    return entry.lod;
+}
+
+void MeshLodSelector::Reset()
+{
+    std::lock_guard lockGuard(m_Mutex);
+    m_Views.clear();
+}
+
 static int CompareDrawItemsOpaque(const DrawItem* a, const DrawItem* b)
 {
     if (a->material != b->material)
@@ -58,11 +159,17 @@ static int CompareDrawItemsOpaque(const DrawItem* a, const DrawItem* b)
     if (a->mesh != b->mesh)
         return a->mesh < b->mesh;
 
+    // Keep the instances that use the same level together, so that they can be drawn with one call
+    if (a->lod != b->lod)
+        return a->lod < b->lod;
+
     return a->instance < b->instance;
 }
 
 void InstancedOpaqueDrawStrategy::FillChunk()
 {
+    DONUT_PROFILE_SCOPE("InstancedOpaqueDrawStrategy::FillChunk");
+
     m_InstanceChunk.resize(m_ChunkSize);
 
     DrawItem* writePtr = m_InstanceChunk.data();
@@ -77,12 +184,13 @@ void InstancedOpaqueDrawStrategy::FillChunk()
         bool nodeVisible = false;
         if (subgraphContentRelevant)
         {
-            nodeVisible = m_ViewFrustum.intersectsWith(m_Walker->GetGlobalBoundingBox());
+            const box3& nodeBounds = m_Walker->GetGlobalBoundingBox();
+            nodeVisible = m_ViewFrustum.intersectsWith(nodeBounds) && (!m_OcclusionCuller || m_OcclusionCuller->IsBoxVisible(nodeBounds));
 
             if (nodeVisible && nodeContentsRelevant)
             {
                 auto meshInstance = dynamic_cast<MeshInstance*>(m_Walker->GetLeaf().get());
-                if (meshInstance)
+                if (meshInstance && (!m_InstanceFilter || m_InstanceFilter(*meshInstance)))
                 {
                     const engine::MeshInfo* mesh = meshInstance->GetMesh().get();
 
@@ -99,11 +207,14 @@ void InstancedOpaqueDrawStrategy::FillChunk()
                         if (domain != MaterialDomain::Opaque && domain != MaterialDomain::AlphaTested)
                             continue;
                         
+                        dm::box3 geometryGlobalBoundingBox = m_Walker->GetGlobalBoundingBox();
                         if (mesh->geometries.size() > 1 && !mesh->skinPrototype)
                         {
-                            dm::box3 geometryGlobalBoundingBox = geometry->objectSpaceBounds * m_Walker->GetLocalToWorldTransformFloat();
+                            geometryGlobalBoundingBox = geometry->objectSpaceBounds * m_Walker->GetLocalToWorldTransformFloat();
                             if (!m_ViewFrustum.intersectsWith(geometryGlobalBoundingBox))
                                 continue;
+                            if (m_OcclusionCuller && !m_OcclusionCuller->IsBoxVisible(geometryGlobalBoundingBox))
+                                continue;
                         }
 
                         DrawItem& item = *writePtr;
@@ -114,6 +225,10 @@ void InstancedOpaqueDrawStrategy::FillChunk()
                         item.buffers = item.mesh->buffers.get();
                         item.cullMode = (item.material->doubleSided) ? nvrhi::RasterCullMode::None : nvrhi::RasterCullMode::Back;
                         item.distanceToCamera = 0; // don't care
+                        item.lod = m_ViewLods ? m_LodSelector->SelectLod(*m_ViewLods, meshInstance, item.geometry, geometryGlobalBoundingBox) : 0;
+
+                        if (m_ProjectedSizeScale > 0.f)
+                            AccumulateTextureUsage(item, geometryGlobalBoundingBox);
                         
                         ++writePtr;
                         ++itemCount;
@@ -125,6 +240,9 @@ void InstancedOpaqueDrawStrategy::FillChunk()
         m_Walker.Next(nodeVisible);
     }
 
+    if (!m_Walker)
+        FlushTextureUsage();
+
     m_InstanceChunk.resize(itemCount);
     m_InstancePtrChunk.resize(itemCount);
 
@@ -141,12 +259,63 @@ void InstancedOpaqueDrawStrategy::FillChunk()
     m_ReadPtr = 0;
 }
 
+void InstancedOpaqueDrawStrategy::AccumulateTextureUsage(const DrawItem& item, const dm::box3& globalBounds)
+{
+    // Estimate the screen size of the geometry from its bounding sphere
+    float radius = length(globalBounds.diagonal()) * 0.5f;
+    float distance = std::max(length(globalBounds.center() - m_ViewOrigin), radius);
+    if (distance <= 0.f)
+        return;
+
+    float screenSize = 2.f * radius * m_ProjectedSizeScale / distance;
+    float& materialScreenSize = m_MaterialScreenSizes[item.material];
+    materialScreenSize = std::max(materialScreenSize, screenSize);
+}
+
+void InstancedOpaqueDrawStrategy::FlushTextureUsage()
+{
+    if (m_MaterialScreenSizes.empty() || !m_TextureStreamingFeedback)
+    {
+        m_MaterialScreenSizes.clear();
+        return;
+    }
+
+    // Report the whole view at once, only the largest size of every material matters for the mip selection
+    std::vector<engine::TextureCache::MaterialUsage> usages;
+    usages.reserve(m_MaterialScreenSizes.size());
+    for (const auto& [material, screenSize] : m_MaterialScreenSizes)
+        usages.push_back(engine::TextureCache::MaterialUsage{ material, screenSize });
+
+    m_TextureStreamingFeedback->ReportMaterialUsage(usages);
+    m_MaterialScreenSizes.clear();
+}
+
 void donut::render::InstancedOpaqueDrawStrategy::PrepareForView(const std::shared_ptr<engine::SceneGraphNode>& rootNode, const engine::IView& view)
 {
     m_Walker = SceneGraphWalker(rootNode.get());
     m_ViewFrustum = view.GetViewFrustum();
     m_InstanceChunk.clear();
     m_ReadPtr = 0;
+    m_ViewLods = m_LodSelector ? m_LodSelector->BeginView(view) : nullptr;
+
+    if (m_OcclusionCuller)
+    {
+        DONUT_PROFILE_SCOPE("InstancedOpaqueDrawStrategy::PrepareOccluders");
+        m_OcclusionCuller->PrepareForView(rootNode, view);
+    }
+
+    // Usage from a view that hasn't been drawn to the end
+    FlushTextureUsage();
+
+    m_ProjectedSizeScale = 0.f;
+    if (m_TextureStreamingFeedback && !view.IsOrthographicProjection())
+    {
+        // Number of pixels covered by an object of unit size at unit distance
+        nvrhi::Rect viewExtent = view.GetViewExtent();
+        float4x4 projection = view.GetProjectionMatrix(false);
+        m_ProjectedSizeScale = 0.5f * float(viewExtent.height()) * projection[1][1];
+        m_ViewOrigin = view.GetViewOrigin();
+    }
 }
 
 const DrawItem* InstancedOpaqueDrawStrategy::GetNextItem()
@@ -178,6 +347,7 @@ void TransparentDrawStrategy::PrepareForView(const std::shared_ptr<engine::Scene
 
     float3 viewOrigin = view.GetViewOrigin();
     auto viewFrustum = view.GetViewFrustum();
+    MeshLodSelector::ViewLods* viewLods = m_LodSelector ? m_LodSelector->BeginView(view) : nullptr;
 
     SceneGraphWalker walker(rootNode.get());
     while (walker)
@@ -222,6 +392,7 @@ void TransparentDrawStrategy::PrepareForView(const std::shared_ptr<engine::Scene
                         item.material = geometry->material.get();
                         item.buffers = mesh->buffers.get();
                         item.distanceToCamera = length(geometryGlobalBoundingBox.center() - viewOrigin);
+                        item.lod = viewLods ? m_LodSelector->SelectLod(*viewLods, meshInstance, item.geometry, geometryGlobalBoundingBox) : 0;
                         if (material->doubleSided)
                         {
                             if (DrawDoubleSidedMaterialsSeparately)
@@ -22,6 +22,7 @@
 
 #include <donut/render/ForwardShadingPass.h>
 #include <donut/render/DrawStrategy.h>
+#include <donut/render/LightClusteringPass.h>
 #include <donut/engine/FramebufferFactory.h>
 #include <donut/engine/ShaderFactory.h>
 #include <donut/engine/ShadowMap.h>
@@ -72,6 +73,7 @@ ForwardShadingPass::ForwardShadingPass(
 void ForwardShadingPass::Init(ShaderFactory& shaderFactory, const CreateParameters& params)
 {
     m_UseInputAssembler = params.useInputAssembler;
+    m_LightClusters = params.lightClusters;
 
     m_SupportedViewTypes = ViewType::PLANAR;
     if (params.singlePassCubemap)
@@ -147,6 +149,7 @@ nvrhi::ShaderHandle ForwardShadingPass::CreatePixelShader(ShaderFactory& shaderF
 {
     std::vector<ShaderMacro> Macros;
     Macros.push_back(ShaderMacro("TRANSMISSIVE_MATERIAL", transmissiveMaterial ? "1" : "0"));
+    Macros.push_back(ShaderMacro("CLUSTERED_LIGHTING", params.lightClusters ? "1" : "0"));
 
     return shaderFactory.CreateAutoShader("donut/passes/forward_ps.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_forward_ps), &Macros, nvrhi::ShaderType::Pixel);
 }
@@ -208,6 +211,14 @@ nvrhi::BindingLayoutHandle ForwardShadingPass::CreateShadingBindingLayout()
         .addItem(nvrhi::BindingLayoutItem::Sampler(FORWARD_BINDING_LIGHT_PROBE_SAMPLER))
         .addItem(nvrhi::BindingLayoutItem::Sampler(FORWARD_BINDING_ENVIRONMENT_BRDF_SAMPLER));
 
+    if (m_LightClusters)
+    {
+        bindingLayoutDesc
+            .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(FORWARD_BINDING_LIGHT_CLUSTER_CONSTANTS))
+            .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(FORWARD_BINDING_CLUSTERED_LIGHTS))
+            .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(FORWARD_BINDING_LIGHT_CLUSTERS));
+    }
+
     return m_Device->createBindingLayout(bindingLayoutDesc);
 }
 
@@ -234,6 +245,17 @@ nvrhi::BindingSetHandle ForwardShadingPass::CreateShadingBindingSet(nvrhi::IText
         .addItem(nvrhi::BindingSetItem::Sampler(FORWARD_BINDING_ENVIRONMENT_BRDF_SAMPLER,
             m_CommonPasses->m_LinearClampSampler));
 
+    if (m_LightClusters)
+    {
+        bindingSetDesc
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_LIGHT_CLUSTER_CONSTANTS,
+                m_LightClusters->GetConstantBuffer()))
+            .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(FORWARD_BINDING_CLUSTERED_LIGHTS,
+                m_LightClusters->GetLightBuffer()))
+            .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(FORWARD_BINDING_LIGHT_CLUSTERS,
+                m_LightClusters->GetClusterBuffer()));
+    }
+
     return m_Device->createBindingSet(bindingSetDesc, m_ShadingBindingLayout);
 }
 
@@ -408,9 +430,13 @@ void ForwardShadingPass::PrepareLights(
 
     int numShadows = 0;
 
-    for (int nLight = 0; nLight < std::min(static_cast<int>(lights.size()), FORWARD_MAX_LIGHTS); nLight++)
+    for (const auto& light : lights)
     {
-        const auto& light = lights[nLight];
+        if (m_LightClusters && LightClusteringPass::IsClusteredLight(*light))
+            continue;
+
+        if (constants.numLights >= FORWARD_MAX_LIGHTS)
+            break;
 
         LightConstants& lightConstants = constants.lights[constants.numLights];
         light->FillLightConstants(lightConstants);
@@ -513,10 +539,12 @@ void ForwardShadingPass::SetupInputBuffers(GeometryPassContext& abstractContext,
 {
     auto& context = static_cast<Context&>(abstractContext);
     
-    state.indexBuffer = { buffers->indexBuffer, nvrhi::Format::R32_UINT, 0 };
+    state.indexBuffer = { buffers->indexBuffer, buffers->getIndexFormat(), 0 };
     
     if (m_UseInputAssembler)
     {
+        assert(buffers->isInputAssemblerCompatible());
+
         state.vertexBuffers = {
             { buffers->vertexBuffer, 0, buffers->getVertexBufferRange(VertexAttribute::Position).byteOffset },
             { buffers->vertexBuffer, 1, buffers->getVertexBufferRange(VertexAttribute::PrevPosition).byteOffset },
@@ -533,6 +561,7 @@ void ForwardShadingPass::SetupInputBuffers(GeometryPassContext& abstractContext,
         context.texCoordOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset);
         context.normalOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Normal).byteOffset);
         context.tangentOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Tangent).byteOffset);
+        context.formatFlags = buffers->formatFlags;
     }
 }
 
@@ -568,6 +597,9 @@ nvrhi::BindingSetHandle ForwardShadingPass::CreateInputBindingSet(const BufferGr
 
 nvrhi::BindingSetHandle ForwardShadingPass::GetOrCreateInputBindingSet(const BufferGroup* bufferGroup)
 {
+    // Contexts may be used on several threads at once, see ParallelViewRecorder
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
     auto it = m_InputBindingSets.find(bufferGroup);
     if (it == m_InputBindingSets.end())
     {
@@ -597,6 +629,7 @@ void ForwardShadingPass::SetPushConstants(
     constants.texCoordOffset = context.texCoordOffset;
     constants.normalOffset = context.normalOffset;
     constants.tangentOffset = context.tangentOffset;
+    constants.formatFlags = context.formatFlags;
 
     commandList->setPushConstants(&constants, sizeof(constants));
 
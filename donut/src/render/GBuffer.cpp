@@ -21,6 +21,7 @@
 */
 
 #include <donut/render/GBuffer.h>
+#include <donut/render/MipMapGenPass.h>
 #include <donut/engine/CommonRenderPasses.h>
 #include <donut/engine/FramebufferFactory.h>
 #include <nvrhi/utils.h>
@@ -110,6 +111,10 @@ void GBufferRenderTargets::Init(
 
     GBufferFramebuffer->DepthTarget = Depth;
 
+    // HiZ is created by the first BuildHiZ call, so that renderers not using it don't pay for it
+    HiZ = nullptr;
+    m_HiZPass = nullptr;
+
     m_Size = size;
     m_SampleCount = sampleCount;
     m_UseReverseProjection = useReverseProjection;
@@ -127,3 +132,43 @@ void GBufferRenderTargets::Clear(nvrhi::ICommandList* commandList)
     commandList->clearTextureFloat(GBufferEmissive, nvrhi::AllSubresources, nvrhi::Color(0.f));
     commandList->clearTextureFloat(MotionVectors, nvrhi::AllSubresources, nvrhi::Color(0.f));
 }
+
+void GBufferRenderTargets::BuildHiZ(nvrhi::ICommandList* commandList, const std::shared_ptr<ShaderFactory>& shaderFactory)
+{
+    if (m_SampleCount != 1)
+        return;
+
+    if (!HiZ)
+    {
+        uint2 hiZSize = GetHiZSize(m_Size);
+
+        nvrhi::TextureDesc hiZDesc;
+        hiZDesc.width = hiZSize.x;
+        hiZDesc.height = hiZSize.y;
+        hiZDesc.mipLevels = MipMapGenPass::GetMaxSinglePassLevels(hiZSize);
+        hiZDesc.format = nvrhi::Format::RG32_FLOAT;
+        hiZDesc.isUAV = true;
+        hiZDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        hiZDesc.keepInitialState = true;
+        hiZDesc.debugName = "GBufferHiZ";
+        HiZ = commandList->getDevice()->createTexture(hiZDesc);
+    }
+
+    if (!m_HiZPass)
+        m_HiZPass = std::make_shared<MipMapGenPass>(commandList->getDevice(), shaderFactory, Depth, HiZ, MipMapGenPass::MODE_MINMAX);
+
+    m_HiZPass->Dispatch(commandList);
+}
+
+uint2 GBufferRenderTargets::GetHiZSize(uint2 depthSize)
+{
+    auto halfPowerOfTwo = [](uint size)
+    {
+        uint result = 1;
+        while (result * 2 < size)
+            result *= 2;
+        return result;
+    };
+
+    return uint2(halfPowerOfTwo(depthSize.x), halfPowerOfTwo(depthSize.y));
+}
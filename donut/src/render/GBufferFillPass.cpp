@@ -22,6 +22,7 @@
 
 #include <donut/render/GBufferFillPass.h>
 #include <donut/render/DrawStrategy.h>
+#include <donut/render/GpuCullingPass.h>
 #include <donut/engine/FramebufferFactory.h>
 #include <donut/engine/ShaderFactory.h>
 #include <donut/engine/ShadowMap.h>
@@ -38,26 +39,34 @@
 #include "compiled_shaders/passes/gbuffer_ps.dxbc.h"
 #include "compiled_shaders/passes/gbuffer_vs_input_assembler.dxbc.h"
 #include "compiled_shaders/passes/gbuffer_vs_buffer_loads.dxbc.h"
+#include "compiled_shaders/passes/gbuffer_vs_indirect.dxbc.h"
 #include "compiled_shaders/passes/material_id_ps.dxbc.h"
 #endif
 #if DONUT_WITH_DX12
 #include "compiled_shaders/passes/cubemap_gs.dxil.h"
 #include "compiled_shaders/passes/gbuffer_ps.dxil.h"
+#include "compiled_shaders/passes/gbuffer_as.dxil.h"
+#include "compiled_shaders/passes/gbuffer_ms.dxil.h"
 #include "compiled_shaders/passes/gbuffer_vs_input_assembler.dxil.h"
 #include "compiled_shaders/passes/gbuffer_vs_buffer_loads.dxil.h"
+#include "compiled_shaders/passes/gbuffer_vs_indirect.dxil.h"
 #include "compiled_shaders/passes/material_id_ps.dxil.h"
 #endif
 #if DONUT_WITH_VULKAN
 #include "compiled_shaders/passes/cubemap_gs.spirv.h"
 #include "compiled_shaders/passes/gbuffer_ps.spirv.h"
+#include "compiled_shaders/passes/gbuffer_as.spirv.h"
+#include "compiled_shaders/passes/gbuffer_ms.spirv.h"
 #include "compiled_shaders/passes/gbuffer_vs_input_assembler.spirv.h"
 #include "compiled_shaders/passes/gbuffer_vs_buffer_loads.spirv.h"
+#include "compiled_shaders/passes/gbuffer_vs_indirect.spirv.h"
 #include "compiled_shaders/passes/material_id_ps.spirv.h"
 #endif
 #endif
 
 using namespace donut::math;
 #include <donut/shaders/gbuffer_cb.h>
+#include <donut/shaders/meshlet_cb.h>
 
 using namespace donut::engine;
 using namespace donut::render;
@@ -80,10 +89,34 @@ void GBufferFillPass::Init(ShaderFactory& shaderFactory, const CreateParameters&
     
     m_VertexShader = CreateVertexShader(shaderFactory, params);
     m_InputLayout = CreateInputLayout(m_VertexShader, params);
+
+    if (params.enableIndirectDraws)
+    {
+        assert(!params.useInputAssembler);
+        m_IndirectVertexShader = CreateIndirectVertexShader(shaderFactory, params);
+        m_IndirectInputLayout = CreateIndirectInputLayout(m_IndirectVertexShader);
+    }
+
     m_GeometryShader = CreateGeometryShader(shaderFactory, params);
     m_PixelShader = CreatePixelShader(shaderFactory, params, false);
     m_PixelShaderAlphaTested = CreatePixelShader(shaderFactory, params, true);
 
+    m_UseMeshShaders = params.useMeshShaders
+        && !params.enableSinglePassCubemap
+        && m_Device->queryFeatureSupport(nvrhi::Feature::Meshlets);
+
+    if (m_UseMeshShaders)
+    {
+        m_TaskShader = CreateTaskShader(shaderFactory, params);
+        m_MeshShader = CreateMeshShader(shaderFactory, params);
+
+        if (!m_TaskShader || !m_MeshShader)
+        {
+            log::warning("GBufferFillPass: failed to create the meshlet shaders, using the vertex shader path only");
+            m_UseMeshShaders = false;
+        }
+    }
+
     if (params.materialBindings)
         m_MaterialBindings = params.materialBindings;
     else
@@ -98,12 +131,16 @@ void GBufferFillPass::Init(ShaderFactory& shaderFactory, const CreateParameters&
     m_StencilWriteMask = params.stencilWriteMask;
 
     m_InputBindingLayout = CreateInputBindingLayout();
+
+    if (m_UseMeshShaders)
+        m_MeshletInputBindingLayout = CreateMeshletInputBindingLayout();
 }
 
 void GBufferFillPass::ResetBindingCache()
 {
     m_MaterialBindings->Clear();
     m_InputBindingSets.clear();
+    m_MeshletInputBindingSets.clear();
 }
 
 nvrhi::ShaderHandle GBufferFillPass::CreateVertexShader(ShaderFactory& shaderFactory, const CreateParameters& params)
@@ -125,6 +162,15 @@ nvrhi::ShaderHandle GBufferFillPass::CreateVertexShader(ShaderFactory& shaderFac
     }
 }
 
+nvrhi::ShaderHandle GBufferFillPass::CreateIndirectVertexShader(ShaderFactory& shaderFactory, const CreateParameters& params)
+{
+    std::vector<ShaderMacro> VertexShaderMacros;
+    VertexShaderMacros.push_back(ShaderMacro("MOTION_VECTORS", params.enableMotionVectors ? "1" : "0"));
+
+    return shaderFactory.CreateAutoShader("donut/passes/gbuffer_vs.hlsl", "indirect",
+        DONUT_MAKE_PLATFORM_SHADER(g_gbuffer_vs_indirect), &VertexShaderMacros, nvrhi::ShaderType::Vertex);
+}
+
 nvrhi::ShaderHandle GBufferFillPass::CreateGeometryShader(ShaderFactory& shaderFactory, const CreateParameters& params)
 {
 
@@ -162,6 +208,21 @@ nvrhi::ShaderHandle GBufferFillPass::CreatePixelShader(ShaderFactory& shaderFact
     return shaderFactory.CreateAutoShader("donut/passes/gbuffer_ps.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_gbuffer_ps), &PixelShaderMacros, nvrhi::ShaderType::Pixel);
 }
 
+nvrhi::ShaderHandle GBufferFillPass::CreateTaskShader(ShaderFactory& shaderFactory, const CreateParameters& params)
+{
+    return shaderFactory.CreateAutoShader("donut/passes/gbuffer_as.hlsl", "main",
+        StaticShader(), DONUT_MAKE_DXIL_SHADER(g_gbuffer_as_dxil), DONUT_MAKE_SPIRV_SHADER(g_gbuffer_as_spirv), nullptr, nvrhi::ShaderType::Amplification);
+}
+
+nvrhi::ShaderHandle GBufferFillPass::CreateMeshShader(ShaderFactory& shaderFactory, const CreateParameters& params)
+{
+    std::vector<ShaderMacro> MeshShaderMacros;
+    MeshShaderMacros.push_back(ShaderMacro("MOTION_VECTORS", params.enableMotionVectors ? "1" : "0"));
+
+    return shaderFactory.CreateAutoShader("donut/passes/gbuffer_ms.hlsl", "main",
+        StaticShader(), DONUT_MAKE_DXIL_SHADER(g_gbuffer_ms_dxil), DONUT_MAKE_SPIRV_SHADER(g_gbuffer_ms_spirv), &MeshShaderMacros, nvrhi::ShaderType::Mesh);
+}
+
 nvrhi::InputLayoutHandle GBufferFillPass::CreateInputLayout(nvrhi::IShader* vertexShader, const CreateParameters& params)
 {
     if (params.useInputAssembler)
@@ -186,10 +247,23 @@ nvrhi::InputLayoutHandle GBufferFillPass::CreateInputLayout(nvrhi::IShader* vert
     return nullptr;
 }
 
+nvrhi::InputLayoutHandle GBufferFillPass::CreateIndirectInputLayout(nvrhi::IShader* vertexShader)
+{
+    // GpuCullingDrawRecord, see gpu_culling_cb.h
+    nvrhi::VertexAttributeDesc drawRecordDesc = nvrhi::VertexAttributeDesc()
+        .setName("DRAW")
+        .setFormat(nvrhi::Format::RG32_UINT)
+        .setBufferIndex(0)
+        .setElementStride(sizeof(uint32_t) * 2)
+        .setIsInstanced(true);
+
+    return m_Device->createInputLayout(&drawRecordDesc, 1, vertexShader);
+}
+
 void GBufferFillPass::CreateViewBindings(nvrhi::BindingLayoutHandle& layout, nvrhi::BindingSetHandle& set, const CreateParameters& params)
 {
     auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
-        .setVisibility(nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel)
+        .setVisibility(m_UseMeshShaders ? nvrhi::ShaderType::All : nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel)
         .setRegisterSpace(m_IsDX11 ? 0 : GBUFFER_SPACE_VIEW)
         .setRegisterSpaceIsDescriptorSet(!m_IsDX11)
         .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(GBUFFER_BINDING_VIEW_CONSTANTS))
@@ -206,21 +280,14 @@ void GBufferFillPass::CreateViewBindings(nvrhi::BindingLayoutHandle& layout, nvr
     set = m_Device->createBindingSet(bindingSetDesc, layout);
 }
 
-nvrhi::GraphicsPipelineHandle GBufferFillPass::CreateGraphicsPipeline(PipelineKey key, nvrhi::IFramebuffer* sampleFramebuffer)
+void GBufferFillPass::FillRenderState(PipelineKey key, nvrhi::RenderState& renderState, nvrhi::ShaderHandle& pixelShader) const
 {
-    nvrhi::GraphicsPipelineDesc pipelineDesc;
-    pipelineDesc.inputLayout = m_InputLayout;
-    pipelineDesc.VS = m_VertexShader;
-    pipelineDesc.GS = m_GeometryShader;
-    pipelineDesc.renderState.rasterState
+    renderState.rasterState
         .setFrontCounterClockwise(key.bits.frontCounterClockwise)
         .setCullMode(key.bits.cullMode);
-    pipelineDesc.renderState.blendState.disableAlphaToCoverage();
-    pipelineDesc.bindingLayouts = { m_MaterialBindings->GetLayout(), m_ViewBindingLayout };
-    if (!m_UseInputAssembler)
-        pipelineDesc.bindingLayouts.push_back(m_InputBindingLayout);
+    renderState.blendState.disableAlphaToCoverage();
 
-    pipelineDesc.renderState.depthStencilState
+    renderState.depthStencilState
         .setDepthWriteEnable(m_EnableDepthWrite)
         .setDepthFunc(key.bits.reverseDepth
             ? nvrhi::ComparisonFunc::GreaterOrEqual
@@ -228,7 +295,7 @@ nvrhi::GraphicsPipelineHandle GBufferFillPass::CreateGraphicsPipeline(PipelineKe
         
     if (m_StencilWriteMask)
     {
-        pipelineDesc.renderState.depthStencilState
+        renderState.depthStencilState
             .enableStencil()
             .setStencilReadMask(0)
             .setStencilWriteMask(uint8_t(m_StencilWriteMask))
@@ -239,26 +306,51 @@ nvrhi::GraphicsPipelineHandle GBufferFillPass::CreateGraphicsPipeline(PipelineKe
 
     if (key.bits.alphaTested)
     {
-        pipelineDesc.renderState.rasterState.setCullNone();
+        renderState.rasterState.setCullNone();
 
         if (m_PixelShaderAlphaTested)
         {
-            pipelineDesc.PS = m_PixelShaderAlphaTested;
+            pixelShader = m_PixelShaderAlphaTested;
         }
         else
         {
-            pipelineDesc.PS = m_PixelShader;
-            pipelineDesc.renderState.blendState.alphaToCoverageEnable = true;
+            pixelShader = m_PixelShader;
+            renderState.blendState.alphaToCoverageEnable = true;
         }
     }
     else
     {
-        pipelineDesc.PS = m_PixelShader;
+        pixelShader = m_PixelShader;
     }
+}
+
+nvrhi::GraphicsPipelineHandle GBufferFillPass::CreateGraphicsPipeline(PipelineKey key, nvrhi::IFramebuffer* sampleFramebuffer)
+{
+    nvrhi::GraphicsPipelineDesc pipelineDesc;
+    pipelineDesc.inputLayout = key.bits.indirect ? m_IndirectInputLayout : m_InputLayout;
+    pipelineDesc.VS = key.bits.indirect ? m_IndirectVertexShader : m_VertexShader;
+    pipelineDesc.GS = m_GeometryShader;
+    pipelineDesc.bindingLayouts = { m_MaterialBindings->GetLayout(), m_ViewBindingLayout };
+    if (!m_UseInputAssembler)
+        pipelineDesc.bindingLayouts.push_back(m_InputBindingLayout);
+
+    FillRenderState(key, pipelineDesc.renderState, pipelineDesc.PS);
 
     return m_Device->createGraphicsPipeline(pipelineDesc, sampleFramebuffer);
 }
 
+nvrhi::MeshletPipelineHandle GBufferFillPass::CreateMeshletPipeline(PipelineKey key, nvrhi::IFramebuffer* sampleFramebuffer)
+{
+    nvrhi::MeshletPipelineDesc pipelineDesc;
+    pipelineDesc.AS = m_TaskShader;
+    pipelineDesc.MS = m_MeshShader;
+    pipelineDesc.bindingLayouts = { m_MaterialBindings->GetLayout(), m_ViewBindingLayout, m_MeshletInputBindingLayout };
+
+    FillRenderState(key, pipelineDesc.renderState, pipelineDesc.PS);
+
+    return m_Device->createMeshletPipeline(pipelineDesc, sampleFramebuffer);
+}
+
 std::shared_ptr<MaterialBindingCache> GBufferFillPass::CreateMaterialBindingCache(CommonRenderPasses& commonPasses)
 {
     std::vector<MaterialResourceBinding> materialBindings = {
@@ -301,13 +393,8 @@ void GBufferFillPass::SetupView(GeometryPassContext& abstractContext, nvrhi::ICo
     context.keyTemplate.bits.reverseDepth = view->IsReverseDepth();
 }
 
-bool GBufferFillPass::SetupMaterial(GeometryPassContext& abstractContext, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::GraphicsState& state)
+bool GBufferFillPass::GetMaterialPipelineKey(const engine::Material* material, PipelineKey& key)
 {
-    auto& context = static_cast<Context&>(abstractContext);
-    
-    PipelineKey key = context.keyTemplate;
-    key.bits.cullMode = cullMode;
-
     switch (material->domain)
     {
     case MaterialDomain::Opaque:
@@ -316,13 +403,24 @@ bool GBufferFillPass::SetupMaterial(GeometryPassContext& abstractContext, const
     case MaterialDomain::TransmissiveAlphaTested:
     case MaterialDomain::TransmissiveAlphaBlended:
         key.bits.alphaTested = false;
-        break;
+        return true;
     case MaterialDomain::AlphaTested:
         key.bits.alphaTested = true;
-        break;
+        return true;
     default:
         return false;
     }
+}
+
+bool GBufferFillPass::SetupMaterial(GeometryPassContext& abstractContext, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::GraphicsState& state)
+{
+    auto& context = static_cast<Context&>(abstractContext);
+    
+    PipelineKey key = context.keyTemplate;
+    key.bits.cullMode = cullMode;
+
+    if (!GetMaterialPipelineKey(material, key))
+        return false;
 
     nvrhi::IBindingSet* materialBindingSet = m_MaterialBindings->GetMaterialBindingSet(material);
 
@@ -357,10 +455,12 @@ void GBufferFillPass::SetupInputBuffers(GeometryPassContext& abstractContext, co
 {
     auto& context = static_cast<Context&>(abstractContext);
 
-    state.indexBuffer = { buffers->indexBuffer, nvrhi::Format::R32_UINT, 0 };
+    state.indexBuffer = { buffers->indexBuffer, buffers->getIndexFormat(), 0 };
 
     if (m_UseInputAssembler)
     {
+        assert(buffers->isInputAssemblerCompatible());
+
         state.vertexBuffers = {
             { buffers->vertexBuffer, 0, buffers->getVertexBufferRange(VertexAttribute::Position).byteOffset },
             { buffers->vertexBuffer, 1, buffers->getVertexBufferRange(VertexAttribute::PrevPosition).byteOffset },
@@ -378,6 +478,7 @@ void GBufferFillPass::SetupInputBuffers(GeometryPassContext& abstractContext, co
         context.texCoordOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset);
         context.normalOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Normal).byteOffset);
         context.tangentOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Tangent).byteOffset);
+        context.formatFlags = buffers->formatFlags;
     }
 }
 
@@ -413,6 +514,9 @@ nvrhi::BindingSetHandle GBufferFillPass::CreateInputBindingSet(const BufferGroup
 
 nvrhi::BindingSetHandle GBufferFillPass::GetOrCreateInputBindingSet(const BufferGroup* bufferGroup)
 {
+    // Contexts may be used on several threads at once, see ParallelViewRecorder
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
     auto it = m_InputBindingSets.find(bufferGroup);
     if (it == m_InputBindingSets.end())
     {
@@ -443,6 +547,7 @@ void GBufferFillPass::SetPushConstants(
     constants.texCoordOffset = context.texCoordOffset;
     constants.normalOffset = context.normalOffset;
     constants.tangentOffset = context.tangentOffset;
+    constants.formatFlags = context.formatFlags;
 
     commandList->setPushConstants(&constants, sizeof(constants));
 
@@ -450,6 +555,186 @@ void GBufferFillPass::SetPushConstants(
     args.startVertexLocation = 0;
 }
 
+void GBufferFillPass::RenderIndirect(
+    nvrhi::ICommandList* commandList,
+    const IView* view,
+    const IView* viewPrev,
+    nvrhi::IFramebuffer* framebuffer,
+    const GpuCullingPass& cullingPass,
+    Context& context)
+{
+    assert(m_IndirectVertexShader);
+
+    const std::vector<IndirectDrawBucket>& buckets = cullingPass.GetDrawList().GetBuckets();
+    if (buckets.empty())
+        return;
+
+    SetupView(context, commandList, view, viewPrev);
+    context.keyTemplate.bits.indirect = true;
+
+    nvrhi::GraphicsState graphicsState;
+    graphicsState.framebuffer = framebuffer;
+    graphicsState.viewport = view->GetViewportState();
+    graphicsState.shadingRateState = view->GetVariableRateShadingState();
+    graphicsState.indirectParams = cullingPass.GetDrawArgumentBuffer();
+
+    const BufferGroup* lastBuffers = nullptr;
+
+    for (const IndirectDrawBucket& bucket : buckets)
+    {
+        if (bucket.buffers != lastBuffers)
+        {
+            SetupInputBuffers(context, bucket.buffers, graphicsState);
+            lastBuffers = bucket.buffers;
+        }
+
+        if (!SetupMaterial(context, bucket.material, bucket.cullMode, graphicsState))
+            continue;
+
+        graphicsState.vertexBuffers = { { cullingPass.GetDrawRecordBuffer(), 0, 0 } };
+        commandList->setGraphicsState(graphicsState);
+
+        // The instance and the first vertex of every draw come from the draw record
+        GBufferPushConstants constants = {};
+        constants.positionOffset = context.positionOffset;
+        constants.prevPositionOffset = context.prevPositionOffset;
+        constants.texCoordOffset = context.texCoordOffset;
+        constants.normalOffset = context.normalOffset;
+        constants.tangentOffset = context.tangentOffset;
+        constants.formatFlags = context.formatFlags;
+        commandList->setPushConstants(&constants, sizeof(constants));
+
+        commandList->drawIndexedIndirect(uint32_t(bucket.firstDraw * sizeof(nvrhi::DrawIndexedIndirectArguments)), bucket.maxDraws);
+    }
+
+    context.keyTemplate.bits.indirect = false;
+}
+
+bool GBufferFillPass::SupportsMeshlets(const DrawItem& item) const
+{
+    // Meshlets are only built for the full detail geometry
+    return m_UseMeshShaders && item.lod == 0 && item.geometry->numMeshlets > 0 && item.buffers->meshletBuffer;
+}
+
+bool GBufferFillPass::SetupMeshletMaterial(GeometryPassContext& abstractContext, const engine::Material* material, nvrhi::RasterCullMode cullMode, nvrhi::MeshletState& state)
+{
+    auto& context = static_cast<Context&>(abstractContext);
+
+    PipelineKey key = context.keyTemplate;
+    key.bits.cullMode = cullMode;
+
+    if (!GetMaterialPipelineKey(material, key))
+        return false;
+
+    nvrhi::IBindingSet* materialBindingSet = m_MaterialBindings->GetMaterialBindingSet(material);
+
+    if (!materialBindingSet)
+        return false;
+
+    nvrhi::MeshletPipelineHandle& pipeline = m_MeshletPipelines[key.value];
+
+    if (!pipeline)
+    {
+        std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+        if (!pipeline)
+            pipeline = CreateMeshletPipeline(key, state.framebuffer);
+
+        if (!pipeline)
+            return false;
+    }
+
+    assert(pipeline->getFramebufferInfo() == state.framebuffer->getFramebufferInfo());
+
+    state.pipeline = pipeline;
+    state.bindings = { materialBindingSet, m_ViewBindings, context.meshletInputBindingSet };
+
+    // The normal cones only tell which meshlets are entirely backfacing, which is useless without backface culling
+    context.meshletCullFlags = MeshletCullFlag_Frustum;
+    if (cullMode == nvrhi::RasterCullMode::Back && !key.bits.alphaTested)
+        context.meshletCullFlags |= MeshletCullFlag_Cone;
+
+    return true;
+}
+
+void GBufferFillPass::SetupMeshletInputBuffers(GeometryPassContext& abstractContext, const engine::BufferGroup* buffers, nvrhi::MeshletState& state)
+{
+    auto& context = static_cast<Context&>(abstractContext);
+
+    context.meshletInputBindingSet = GetOrCreateMeshletInputBindingSet(buffers);
+    context.positionOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Position).byteOffset);
+    context.prevPositionOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::PrevPosition).byteOffset);
+    context.texCoordOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::TexCoord1).byteOffset);
+    context.normalOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Normal).byteOffset);
+    context.tangentOffset = uint32_t(buffers->getVertexBufferRange(VertexAttribute::Tangent).byteOffset);
+    context.formatFlags = buffers->formatFlags;
+}
+
+nvrhi::BindingLayoutHandle GBufferFillPass::CreateMeshletInputBindingLayout()
+{
+    // The pixel shaders read startInstanceLocation, which is at the same offset as in GBufferPushConstants
+    auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Amplification | nvrhi::ShaderType::Mesh | nvrhi::ShaderType::Pixel)
+        .setRegisterSpace(GBUFFER_SPACE_INPUT)
+        .setRegisterSpaceIsDescriptorSet(true)
+        .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(GBUFFER_BINDING_INSTANCE_BUFFER))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(GBUFFER_BINDING_VERTEX_BUFFER))
+        .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(GBUFFER_BINDING_MESHLET_BUFFER))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(GBUFFER_BINDING_MESHLET_INDEX_BUFFER))
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(GBUFFER_BINDING_PUSH_CONSTANTS, sizeof(GBufferMeshletPushConstants)));
+
+    return m_Device->createBindingLayout(bindingLayoutDesc);
+}
+
+nvrhi::BindingSetHandle GBufferFillPass::CreateMeshletInputBindingSet(const BufferGroup* bufferGroup)
+{
+    auto bindingSetDesc = nvrhi::BindingSetDesc()
+        .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(GBUFFER_BINDING_INSTANCE_BUFFER, bufferGroup->instanceBuffer))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(GBUFFER_BINDING_VERTEX_BUFFER, bufferGroup->vertexBuffer))
+        .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(GBUFFER_BINDING_MESHLET_BUFFER, bufferGroup->meshletBuffer))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(GBUFFER_BINDING_MESHLET_INDEX_BUFFER, bufferGroup->meshletIndexBuffer))
+        .addItem(nvrhi::BindingSetItem::PushConstants(GBUFFER_BINDING_PUSH_CONSTANTS, sizeof(GBufferMeshletPushConstants)));
+
+    return m_Device->createBindingSet(bindingSetDesc, m_MeshletInputBindingLayout);
+}
+
+nvrhi::BindingSetHandle GBufferFillPass::GetOrCreateMeshletInputBindingSet(const BufferGroup* bufferGroup)
+{
+    std::lock_guard<std::mutex> lockGuard(m_Mutex);
+
+    auto it = m_MeshletInputBindingSets.find(bufferGroup);
+    if (it == m_MeshletInputBindingSets.end())
+    {
+        auto bindingSet = CreateMeshletInputBindingSet(bufferGroup);
+        m_MeshletInputBindingSets[bufferGroup] = bindingSet;
+        return bindingSet;
+    }
+
+    return it->second;
+}
+
+void GBufferFillPass::DispatchMeshlets(GeometryPassContext& abstractContext, nvrhi::ICommandList* commandList, const DrawItem& item, uint32_t instanceCount)
+{
+    auto& context = static_cast<Context&>(abstractContext);
+
+    GBufferMeshletPushConstants constants;
+    constants.startInstanceLocation = item.instance->GetInstanceIndex();
+    constants.startVertexLocation = item.mesh->vertexOffset + item.geometry->vertexOffsetInMesh;
+    constants.positionOffset = context.positionOffset;
+    constants.prevPositionOffset = context.prevPositionOffset;
+    constants.texCoordOffset = context.texCoordOffset;
+    constants.normalOffset = context.normalOffset;
+    constants.tangentOffset = context.tangentOffset;
+    constants.formatFlags = context.formatFlags;
+    constants.firstMeshlet = item.geometry->firstMeshlet;
+    constants.numMeshlets = item.geometry->numMeshlets;
+    constants.cullFlags = context.meshletCullFlags;
+
+    commandList->setPushConstants(&constants, sizeof(constants));
+
+    commandList->dispatchMesh(dm::div_ceil(item.geometry->numMeshlets, MESHLET_TASK_GROUP_SIZE), instanceCount);
+}
+
 void MaterialIDPass::Init(
     engine::ShaderFactory& shaderFactory,
     const CreateParameters& params)
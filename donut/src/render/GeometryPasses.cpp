@@ -24,6 +24,7 @@
 #include <donut/engine/SceneGraph.h>
 #include <donut/engine/FramebufferFactory.h>
 #include <donut/render/DrawStrategy.h>
+#include <donut/core/profiler.h>
 
 using namespace donut::math;
 using namespace donut::engine;
@@ -39,14 +40,18 @@ void donut::render::RenderView(
     GeometryPassContext& passContext,
     bool materialEvents)
 {
+    DONUT_PROFILE_SCOPE("RenderView");
+
     pass.SetupView(passContext, commandList, view, viewPrev);
 
     const Material* lastMaterial = nullptr;
     const BufferGroup* lastBuffers = nullptr;
     nvrhi::RasterCullMode lastCullMode = nvrhi::RasterCullMode::Back;
+    bool lastUseMeshlets = false;
 
     bool drawMaterial = true;
     bool stateValid = false;
+    bool meshletStateValid = false;
 
     const Material* eventMaterial = nullptr;
 
@@ -55,14 +60,18 @@ void donut::render::RenderView(
     graphicsState.viewport = view->GetViewportState();
     graphicsState.shadingRateState = view->GetVariableRateShadingState();
 
+    nvrhi::MeshletState meshletState;
+    meshletState.framebuffer = framebuffer;
+    meshletState.viewport = view->GetViewportState();
+
     nvrhi::DrawArguments currentDraw;
     currentDraw.instanceCount = 0;
 
-    auto flushDraw = [commandList, materialEvents, &graphicsState, &currentDraw, &eventMaterial, &pass, &passContext](const Material* material)
-    {
-        if (currentDraw.instanceCount == 0)
-            return;
+    DrawItem currentMeshletItem{};
+    uint32_t currentMeshletInstances = 0;
 
+    auto setMaterialEvent = [commandList, materialEvents, &eventMaterial](const Material* material)
+    {
         if (materialEvents && material != eventMaterial)
         {
             if (eventMaterial)
@@ -78,75 +87,132 @@ void donut::render::RenderView(
                 eventMaterial = material;
             }
         }
+    };
+
+    auto flushDraw = [commandList, &graphicsState, &currentDraw, &setMaterialEvent, &pass, &passContext](const Material* material)
+    {
+        if (currentDraw.instanceCount == 0)
+            return;
+
+        setMaterialEvent(material);
 
         pass.SetPushConstants(passContext, commandList, graphicsState, currentDraw);
 
         commandList->drawIndexed(currentDraw);
         currentDraw.instanceCount = 0;
     };
+
+    auto flushMeshlets = [commandList, &currentMeshletItem, &currentMeshletInstances, &setMaterialEvent, &pass, &passContext]()
+    {
+        if (currentMeshletInstances == 0)
+            return;
+
+        setMaterialEvent(currentMeshletItem.material);
+
+        pass.DispatchMeshlets(passContext, commandList, currentMeshletItem, currentMeshletInstances);
+        currentMeshletInstances = 0;
+    };
     
     while (const DrawItem* item = drawStrategy.GetNextItem())
     {
         if (item->material == nullptr)
             continue;
 
-
-        bool newBuffers = item->buffers != lastBuffers;
-        bool newMaterial = item->material != lastMaterial || item->cullMode != lastCullMode;
+        bool useMeshlets = pass.SupportsMeshlets(*item);
+        bool newPath = useMeshlets != lastUseMeshlets;
+        bool newBuffers = item->buffers != lastBuffers || newPath;
+        bool newMaterial = item->material != lastMaterial || item->cullMode != lastCullMode || newPath;
 
         if (newBuffers || newMaterial)
         {
             flushDraw(lastMaterial);
+            flushMeshlets();
         }
 
         if (newBuffers)
         {
-            pass.SetupInputBuffers(passContext, item->buffers, graphicsState);
+            if (useMeshlets)
+                pass.SetupMeshletInputBuffers(passContext, item->buffers, meshletState);
+            else
+                pass.SetupInputBuffers(passContext, item->buffers, graphicsState);
 
             lastBuffers = item->buffers;
             stateValid = false;
+            meshletStateValid = false;
         }
 
         if (newMaterial)
         {
-            drawMaterial = pass.SetupMaterial(passContext, item->material, item->cullMode, graphicsState);
+            if (useMeshlets)
+                drawMaterial = pass.SetupMeshletMaterial(passContext, item->material, item->cullMode, meshletState);
+            else
+                drawMaterial = pass.SetupMaterial(passContext, item->material, item->cullMode, graphicsState);
 
             lastMaterial = item->material;
             lastCullMode = item->cullMode;
             stateValid = false;
+            meshletStateValid = false;
         }
 
-        if (drawMaterial)
+        lastUseMeshlets = useMeshlets;
+
+        if (!drawMaterial)
+            continue;
+
+        if (useMeshlets)
         {
-            if (!stateValid)
+            if (!meshletStateValid)
             {
-                commandList->setGraphicsState(graphicsState);
-                stateValid = true;
+                commandList->setMeshletState(meshletState);
+                meshletStateValid = true;
             }
 
-            nvrhi::DrawArguments args;
-            args.vertexCount = item->geometry->numIndices;
-            args.instanceCount = 1;
-            args.startVertexLocation = item->mesh->vertexOffset + item->geometry->vertexOffsetInMesh;
-            args.startIndexLocation = item->mesh->indexOffset + item->geometry->indexOffsetInMesh;
-            args.startInstanceLocation = item->instance->GetInstanceIndex();
-
-            if (currentDraw.instanceCount > 0 && 
-                currentDraw.startIndexLocation == args.startIndexLocation && 
-                currentDraw.startInstanceLocation + currentDraw.instanceCount == args.startInstanceLocation)
+            if (currentMeshletInstances > 0 &&
+                currentMeshletItem.geometry == item->geometry &&
+                currentMeshletItem.instance->GetInstanceIndex() + currentMeshletInstances == item->instance->GetInstanceIndex())
             {
-                currentDraw.instanceCount += 1;
+                currentMeshletInstances += 1;
             }
             else
             {
-                flushDraw(item->material);
+                flushMeshlets();
 
-                currentDraw = args;
+                currentMeshletItem = *item;
+                currentMeshletInstances = 1;
             }
+
+            continue;
+        }
+
+        if (!stateValid)
+        {
+            commandList->setGraphicsState(graphicsState);
+            stateValid = true;
+        }
+
+        nvrhi::DrawArguments args;
+        args.vertexCount = item->geometry->getLodNumIndices(item->lod);
+        args.instanceCount = 1;
+        args.startVertexLocation = item->mesh->vertexOffset + item->geometry->vertexOffsetInMesh;
+        args.startIndexLocation = item->mesh->indexOffset + item->geometry->getLodIndexOffsetInMesh(item->lod);
+        args.startInstanceLocation = item->instance->GetInstanceIndex();
+
+        if (currentDraw.instanceCount > 0 && 
+            currentDraw.startIndexLocation == args.startIndexLocation && 
+            currentDraw.startInstanceLocation + currentDraw.instanceCount == args.startInstanceLocation)
+        {
+            currentDraw.instanceCount += 1;
+        }
+        else
+        {
+            flushDraw(item->material);
+
+            currentDraw = args;
         }
     }
 
     flushDraw(lastMaterial);
+    flushMeshlets();
 
     if (materialEvents && eventMaterial)
         commandList->endMarker();
@@ -0,0 +1,307 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/GpuCullingPass.h>
+#include <donut/engine/CommonRenderPasses.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/ShaderFactory.h>
+#include <donut/engine/View.h>
+#include <nvrhi/utils.h>
+#include <algorithm>
+
+#if DONUT_WITH_STATIC_SHADERS
+#if DONUT_WITH_DX11
+#include "compiled_shaders/passes/gpu_culling_cs.dxbc.h"
+#endif
+#if DONUT_WITH_DX12
+#include "compiled_shaders/passes/gpu_culling_cs.dxil.h"
+#endif
+#if DONUT_WITH_VULKAN
+#include "compiled_shaders/passes/gpu_culling_cs.spirv.h"
+#endif
+#endif
+
+using namespace donut::math;
+#include <donut/shaders/gpu_culling_cb.h>
+
+using namespace donut::engine;
+using namespace donut::render;
+
+static_assert(sizeof(nvrhi::DrawIndexedIndirectArguments) == GPU_CULLING_DRAW_ARGUMENTS_SIZE);
+static_assert(sizeof(GpuCullingDrawRecord) == GPU_CULLING_DRAW_RECORD_SIZE);
+
+void IndirectDrawList::Clear()
+{
+    m_Buckets.clear();
+    m_Candidates.clear();
+}
+
+void IndirectDrawList::Build(const std::vector<std::shared_ptr<MeshInstance>>& meshInstances)
+{
+    Clear();
+
+    struct Entry
+    {
+        IndirectDrawBucket key;
+        IndirectDrawCandidate candidate;
+    };
+    std::vector<Entry> entries;
+
+    for (const auto& instance : meshInstances)
+    {
+        const MeshInfo* mesh = instance->GetMesh().get();
+        if (!mesh || !mesh->buffers || instance->GetInstanceIndex() < 0)
+            continue;
+
+        // The bounds of skinned meshes change every frame and are not in the instance buffer
+        const bool cullable = !mesh->skinPrototype;
+
+        for (const auto& geometry : mesh->geometries)
+        {
+            const Material* material = geometry->material.get();
+            if (!material || (material->domain != MaterialDomain::Opaque && material->domain != MaterialDomain::AlphaTested))
+                continue;
+
+            Entry& entry = entries.emplace_back();
+            entry.key.material = material;
+            entry.key.buffers = mesh->buffers.get();
+            entry.key.cullMode = material->doubleSided ? nvrhi::RasterCullMode::None : nvrhi::RasterCullMode::Back;
+            entry.candidate.instanceIndex = uint32_t(instance->GetInstanceIndex());
+            entry.candidate.indexCount = geometry->numIndices;
+            entry.candidate.startIndexLocation = mesh->indexOffset + geometry->indexOffsetInMesh;
+            entry.candidate.vertexOffset = mesh->vertexOffset + geometry->vertexOffsetInMesh;
+            entry.candidate.objectSpaceBounds = cullable ? geometry->objectSpaceBounds : box3::empty();
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+    {
+        if (a.key.buffers != b.key.buffers)
+            return a.key.buffers < b.key.buffers;
+        if (a.key.material != b.key.material)
+            return a.key.material < b.key.material;
+        return a.key.cullMode < b.key.cullMode;
+    });
+
+    m_Candidates.reserve(entries.size());
+
+    for (Entry& entry : entries)
+    {
+        if (m_Buckets.empty() ||
+            m_Buckets.back().buffers != entry.key.buffers ||
+            m_Buckets.back().material != entry.key.material ||
+            m_Buckets.back().cullMode != entry.key.cullMode)
+        {
+            IndirectDrawBucket& bucket = m_Buckets.emplace_back(entry.key);
+            bucket.firstDraw = uint32_t(m_Candidates.size());
+            bucket.maxDraws = 0;
+        }
+
+        ++m_Buckets.back().maxDraws;
+        entry.candidate.bucket = uint32_t(m_Buckets.size() - 1);
+        m_Candidates.push_back(entry.candidate);
+    }
+}
+
+GpuCullingPass::GpuCullingPass(nvrhi::IDevice* device, std::shared_ptr<CommonRenderPasses> commonPasses)
+    : m_Device(device)
+    , m_CommonPasses(std::move(commonPasses))
+{
+}
+
+void GpuCullingPass::Init(ShaderFactory& shaderFactory)
+{
+    m_ComputeShader = CreateComputeShader(shaderFactory);
+
+    m_ConstantBuffer = m_Device->createBuffer(nvrhi::utils::CreateStaticConstantBufferDesc(
+        sizeof(GpuCullingConstants), "GpuCullingConstants")
+        .setInitialState(nvrhi::ResourceStates::ConstantBuffer)
+        .setKeepInitialState(true));
+
+    nvrhi::BindingLayoutDesc layoutDesc;
+    layoutDesc.visibility = nvrhi::ShaderType::Compute;
+    layoutDesc.bindings = {
+        nvrhi::BindingLayoutItem::ConstantBuffer(0),
+        nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
+        nvrhi::BindingLayoutItem::RawBuffer_SRV(1),
+        nvrhi::BindingLayoutItem::Texture_SRV(2),
+        nvrhi::BindingLayoutItem::StructuredBuffer_UAV(0),
+        nvrhi::BindingLayoutItem::RawBuffer_UAV(1),
+        nvrhi::BindingLayoutItem::RawBuffer_UAV(2)
+    };
+    m_BindingLayout = m_Device->createBindingLayout(layoutDesc);
+
+    nvrhi::ComputePipelineDesc pipelineDesc;
+    pipelineDesc.CS = m_ComputeShader;
+    pipelineDesc.bindingLayouts = { m_BindingLayout };
+    m_Pso = m_Device->createComputePipeline(pipelineDesc);
+}
+
+nvrhi::ShaderHandle GpuCullingPass::CreateComputeShader(ShaderFactory& shaderFactory)
+{
+    return shaderFactory.CreateAutoShader("donut/passes/gpu_culling_cs.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_gpu_culling_cs), nullptr, nvrhi::ShaderType::Compute);
+}
+
+void GpuCullingPass::CreateBuffers(uint32_t numCandidates, uint32_t numBuckets)
+{
+    if (m_CandidateBuffer && m_CandidateBuffer->getDesc().byteSize >= numCandidates * sizeof(GpuCullingCandidate) &&
+        m_DrawCountBuffer->getDesc().byteSize >= numBuckets * sizeof(uint32_t))
+        return;
+
+    nvrhi::BufferDesc bufferDesc;
+    bufferDesc.byteSize = numCandidates * sizeof(GpuCullingCandidate);
+    bufferDesc.structStride = sizeof(GpuCullingCandidate);
+    bufferDesc.debugName = "GpuCullingCandidates";
+    bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+    bufferDesc.keepInitialState = true;
+    m_CandidateBuffer = m_Device->createBuffer(bufferDesc);
+
+    bufferDesc = nvrhi::BufferDesc();
+    bufferDesc.byteSize = numBuckets * sizeof(uint32_t);
+    bufferDesc.structStride = sizeof(uint32_t);
+    bufferDesc.canHaveUAVs = true;
+    bufferDesc.debugName = "GpuCullingDrawCounts";
+    bufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+    bufferDesc.keepInitialState = true;
+    m_DrawCountBuffer = m_Device->createBuffer(bufferDesc);
+
+    bufferDesc = nvrhi::BufferDesc();
+    bufferDesc.byteSize = numCandidates * sizeof(nvrhi::DrawIndexedIndirectArguments);
+    bufferDesc.canHaveUAVs = true;
+    bufferDesc.canHaveRawViews = true;
+    bufferDesc.isDrawIndirectArgs = true;
+    bufferDesc.debugName = "GpuCullingDrawArguments";
+    bufferDesc.initialState = nvrhi::ResourceStates::IndirectArgument;
+    bufferDesc.keepInitialState = true;
+    m_DrawArgumentBuffer = m_Device->createBuffer(bufferDesc);
+
+    bufferDesc = nvrhi::BufferDesc();
+    bufferDesc.byteSize = numCandidates * sizeof(GpuCullingDrawRecord);
+    bufferDesc.canHaveUAVs = true;
+    bufferDesc.canHaveRawViews = true;
+    bufferDesc.isVertexBuffer = true;
+    bufferDesc.debugName = "GpuCullingDrawRecords";
+    bufferDesc.initialState = nvrhi::ResourceStates::VertexBuffer;
+    bufferDesc.keepInitialState = true;
+    m_DrawRecordBuffer = m_Device->createBuffer(bufferDesc);
+
+    m_BindingSet = nullptr;
+}
+
+void GpuCullingPass::BuildDrawList(nvrhi::ICommandList* commandList, const std::vector<std::shared_ptr<MeshInstance>>& meshInstances)
+{
+    m_DrawList.Build(meshInstances);
+
+    const std::vector<IndirectDrawCandidate>& candidates = m_DrawList.GetCandidates();
+    const std::vector<IndirectDrawBucket>& buckets = m_DrawList.GetBuckets();
+    if (candidates.empty())
+        return;
+
+    CreateBuffers(uint32_t(candidates.size()), uint32_t(buckets.size()));
+
+    std::vector<GpuCullingCandidate> gpuCandidates(candidates.size());
+    for (size_t index = 0; index < candidates.size(); index++)
+    {
+        const IndirectDrawCandidate& candidate = candidates[index];
+        GpuCullingCandidate& gpuCandidate = gpuCandidates[index];
+        gpuCandidate = {};
+        gpuCandidate.instanceIndex = candidate.instanceIndex;
+        gpuCandidate.bucketIndex = candidate.bucket;
+        gpuCandidate.firstDraw = buckets[candidate.bucket].firstDraw;
+        gpuCandidate.flags = candidate.objectSpaceBounds.isempty() ? GPU_CULLING_CANDIDATE_NO_CULLING : 0;
+        gpuCandidate.indexCount = candidate.indexCount;
+        gpuCandidate.startIndexLocation = candidate.startIndexLocation;
+        gpuCandidate.vertexOffset = candidate.vertexOffset;
+        gpuCandidate.boundsMin = candidate.objectSpaceBounds.m_mins;
+        gpuCandidate.boundsMax = candidate.objectSpaceBounds.m_maxs;
+    }
+
+    commandList->writeBuffer(m_CandidateBuffer, gpuCandidates.data(), gpuCandidates.size() * sizeof(GpuCullingCandidate));
+}
+
+void GpuCullingPass::Render(
+    nvrhi::ICommandList* commandList,
+    nvrhi::IBuffer* instanceBuffer,
+    const IView& view,
+    nvrhi::ITexture* hiZ,
+    const IView* hiZView)
+{
+    const uint32_t numCandidates = uint32_t(m_DrawList.GetCandidates().size());
+    if (numCandidates == 0)
+        return;
+
+    assert(!hiZ || hiZView);
+
+    nvrhi::ITexture* hiZBinding = hiZ ? hiZ : m_CommonPasses->m_BlackTexture.Get();
+
+    if (!m_BindingSet || m_BoundInstanceBuffer != instanceBuffer || m_BoundHiZ != hiZBinding)
+    {
+        nvrhi::BindingSetDesc bindingSetDesc;
+        bindingSetDesc.bindings = {
+            nvrhi::BindingSetItem::ConstantBuffer(0, m_ConstantBuffer),
+            nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_CandidateBuffer),
+            nvrhi::BindingSetItem::RawBuffer_SRV(1, instanceBuffer),
+            nvrhi::BindingSetItem::Texture_SRV(2, hiZBinding).setSubresources(nvrhi::AllSubresources),
+            nvrhi::BindingSetItem::StructuredBuffer_UAV(0, m_DrawCountBuffer),
+            nvrhi::BindingSetItem::RawBuffer_UAV(1, m_DrawArgumentBuffer),
+            nvrhi::BindingSetItem::RawBuffer_UAV(2, m_DrawRecordBuffer)
+        };
+        m_BindingSet = m_Device->createBindingSet(bindingSetDesc, m_BindingLayout);
+        m_BoundInstanceBuffer = instanceBuffer;
+        m_BoundHiZ = hiZBinding;
+    }
+
+    GpuCullingConstants constants = {};
+    constants.numCandidates = numCandidates;
+
+    const frustum viewFrustum = view.GetViewFrustum();
+    for (int plane = 0; plane < frustum::PLANES_COUNT; plane++)
+        constants.frustumPlanes[plane] = float4(viewFrustum.planes[plane].normal, viewFrustum.planes[plane].distance);
+
+    if (hiZ)
+    {
+        const nvrhi::TextureDesc& hiZDesc = hiZ->getDesc();
+        const nvrhi::Rect hiZExtent = hiZView->GetViewExtent();
+        constants.matHiZWorldToClip = hiZView->GetViewProjectionMatrix(true);
+        constants.hizSize = float2(float(hiZExtent.width()), float(hiZExtent.height())) * 0.5f;
+        constants.hizMipLevels = hiZDesc.mipLevels;
+        constants.flags |= GPU_CULLING_FLAG_HIZ;
+        if (hiZView->IsReverseDepth())
+            constants.flags |= GPU_CULLING_FLAG_REVERSE_DEPTH;
+    }
+
+    commandList->beginMarker("GpuCulling");
+
+    commandList->writeBuffer(m_ConstantBuffer, &constants, sizeof(constants));
+
+    // Empty draws in the unused slots of every bucket
+    commandList->clearBufferUInt(m_DrawCountBuffer, 0);
+    commandList->clearBufferUInt(m_DrawArgumentBuffer, 0);
+
+    nvrhi::ComputeState state;
+    state.pipeline = m_Pso;
+    state.bindings = { m_BindingSet };
+    commandList->setComputeState(state);
+    commandList->dispatch(div_ceil(numCandidates, GPU_CULLING_GROUP_SIZE));
+
+    commandList->endMarker();
+}
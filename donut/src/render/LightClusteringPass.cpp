@@ -0,0 +1,324 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/LightClusteringPass.h>
+#include <donut/engine/ShaderFactory.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+#include <donut/core/log.h>
+#include <nvrhi/utils.h>
+#include <cmath>
+
+#if DONUT_WITH_STATIC_SHADERS
+#if DONUT_WITH_DX11
+#include "compiled_shaders/passes/light_clustering_cs.dxbc.h"
+#endif
+#if DONUT_WITH_DX12
+#include "compiled_shaders/passes/light_clustering_cs.dxil.h"
+#endif
+#if DONUT_WITH_VULKAN
+#include "compiled_shaders/passes/light_clustering_cs.spirv.h"
+#endif
+#endif
+
+using namespace donut::math;
+#include <donut/shaders/light_cb.h>
+#include <donut/shaders/light_clustering_cb.h>
+
+using namespace donut::engine;
+using namespace donut::render;
+
+static_assert(LightClusterGrid::SizeX == LIGHT_CLUSTER_GRID_X);
+static_assert(LightClusterGrid::SizeY == LIGHT_CLUSTER_GRID_Y);
+static_assert(LightClusterGrid::SizeZ == LIGHT_CLUSTER_GRID_Z);
+static_assert(LightClusterGrid::ClusterStride == LIGHT_CLUSTER_STRIDE);
+static_assert(LightClusterGrid::MaxLightsPerCluster == LIGHT_CLUSTER_MAX_LIGHTS);
+static_assert(LightClusterGrid::NumClusters % LIGHT_CLUSTERING_GROUP_SIZE == 0);
+
+// View depth used as the far end of the last slice, which is unbounded.
+// Must match the value in light_clustering_cs.hlsl
+static constexpr float c_LastSliceEndDepth = 1e20f;
+
+void LightClusterGrid::Init(const IView& view, float minDepth, float maxDepth)
+{
+    assert(minDepth > 0.f);
+    assert(maxDepth > minDepth);
+
+    m_WorldToView = view.GetViewMatrix();
+    m_ClipToView = view.GetInverseProjectionMatrix(true);
+
+    nvrhi::ViewportState viewportState = view.GetViewportState();
+    const nvrhi::Viewport& viewport = viewportState.viewports[0];
+    m_ViewportOrigin = float2(viewport.minX, viewport.minY);
+    m_ViewportSize = float2(viewport.width(), viewport.height());
+
+    m_DepthSliceScale = float(SizeZ) / std::log2(maxDepth / minDepth);
+    m_DepthSliceBias = -std::log2(minDepth) * m_DepthSliceScale;
+}
+
+uint32_t LightClusterGrid::GetSlice(float viewDepth) const
+{
+    float slice = std::floor(std::log2(std::max(viewDepth, 1e-6f)) * m_DepthSliceScale + m_DepthSliceBias);
+    return uint32_t(clamp(slice, 0.f, float(SizeZ - 1)));
+}
+
+float LightClusterGrid::GetSliceStart(uint32_t slice) const
+{
+    if (slice == 0)
+        return 0.f;
+
+    return std::exp2((float(slice) - m_DepthSliceBias) / m_DepthSliceScale);
+}
+
+float LightClusterGrid::GetSliceEnd(uint32_t slice) const
+{
+    if (slice >= SizeZ - 1)
+        return c_LastSliceEndDepth;
+
+    return std::exp2((float(slice + 1) - m_DepthSliceBias) / m_DepthSliceScale);
+}
+
+float3 LightClusterGrid::GetViewPointAtDepth(float2 clipPosition, float viewDepth) const
+{
+    // Unproject two points on the pixel ray at finite clip depths, which works for regular,
+    // reverse and infinite projections, and find the point on the ray at the requested depth.
+    float4 a = float4(clipPosition, 0.25f, 1.f) * m_ClipToView;
+    float4 b = float4(clipPosition, 0.75f, 1.f) * m_ClipToView;
+    float3 pointA = a.xyz() / a.w;
+    float3 pointB = b.xyz() / b.w;
+
+    return lerp(pointA, pointB, (viewDepth - pointA.z) / (pointB.z - pointA.z));
+}
+
+box3 LightClusterGrid::GetClusterBounds(uint3 cluster) const
+{
+    float2 clipMin = float2(float(cluster.x) / float(SizeX) * 2.f - 1.f, 1.f - float(cluster.y + 1) / float(SizeY) * 2.f);
+    float2 clipMax = float2(float(cluster.x + 1) / float(SizeX) * 2.f - 1.f, 1.f - float(cluster.y) / float(SizeY) * 2.f);
+    float depths[2] = { GetSliceStart(cluster.z), GetSliceEnd(cluster.z) };
+
+    box3 bounds = box3::empty();
+    for (float depth : depths)
+    {
+        bounds |= GetViewPointAtDepth(float2(clipMin.x, clipMin.y), depth);
+        bounds |= GetViewPointAtDepth(float2(clipMax.x, clipMin.y), depth);
+        bounds |= GetViewPointAtDepth(float2(clipMin.x, clipMax.y), depth);
+        bounds |= GetViewPointAtDepth(float2(clipMax.x, clipMax.y), depth);
+    }
+    return bounds;
+}
+
+uint32_t LightClusterGrid::GetClusterIndex(float2 pixelPosition, float viewDepth) const
+{
+    float2 tile = (pixelPosition - m_ViewportOrigin) * float2(float(SizeX), float(SizeY)) / m_ViewportSize;
+    uint32_t x = uint32_t(clamp(std::floor(tile.x), 0.f, float(SizeX - 1)));
+    uint32_t y = uint32_t(clamp(std::floor(tile.y), 0.f, float(SizeY - 1)));
+    uint32_t z = GetSlice(viewDepth);
+
+    return (z * SizeY + y) * SizeX + x;
+}
+
+bool LightClusterGrid::SphereIntersectsBox(const float4& sphere, const box3& box)
+{
+    if (sphere.w < 0.f)
+        return true;
+
+    float3 center = sphere.xyz();
+    float3 distance = max(max(box.m_mins - center, center - box.m_maxs), float3(0.f));
+    return dot(distance, distance) <= sphere.w * sphere.w;
+}
+
+void LightClusterGrid::BinLights(const std::vector<float4>& viewSpaceSpheres, std::vector<uint32_t>& outClusters) const
+{
+    outClusters.assign(size_t(NumClusters) * ClusterStride, 0);
+
+    for (uint32_t clusterIndex = 0; clusterIndex < NumClusters; clusterIndex++)
+    {
+        uint3 cluster = uint3(clusterIndex % SizeX, (clusterIndex / SizeX) % SizeY, clusterIndex / (SizeX * SizeY));
+        box3 bounds = GetClusterBounds(cluster);
+
+        uint32_t* clusterLights = outClusters.data() + size_t(clusterIndex) * ClusterStride;
+        uint32_t numLights = 0;
+
+        for (size_t lightIndex = 0; lightIndex < viewSpaceSpheres.size(); lightIndex++)
+        {
+            if (numLights < MaxLightsPerCluster && SphereIntersectsBox(viewSpaceSpheres[lightIndex], bounds))
+            {
+                clusterLights[1 + numLights] = uint32_t(lightIndex);
+                ++numLights;
+            }
+        }
+
+        clusterLights[0] = numLights;
+    }
+}
+
+static float4 GetLightCullingSphere(const LightConstants& lightConstants)
+{
+    if (lightConstants.lightType == LightType_Directional || lightConstants.angularSizeOrInvRange <= 0.f)
+        return float4(lightConstants.position, -1.f);
+
+    return float4(lightConstants.position, 1.f / lightConstants.angularSizeOrInvRange);
+}
+
+LightClusteringPass::LightClusteringPass(nvrhi::IDevice* device)
+    : m_Device(device)
+{
+}
+
+void LightClusteringPass::Init(ShaderFactory& shaderFactory)
+{
+    m_ComputeShader = CreateComputeShader(shaderFactory);
+
+    m_ConstantBuffer = m_Device->createBuffer(nvrhi::utils::CreateStaticConstantBufferDesc(
+        sizeof(LightClusterConstants), "LightClusterConstants")
+        .setInitialState(nvrhi::ResourceStates::ConstantBuffer)
+        .setKeepInitialState(true));
+
+    nvrhi::BufferDesc bufferDesc;
+    bufferDesc.byteSize = sizeof(LightConstants) * LIGHT_CLUSTERING_MAX_LIGHTS;
+    bufferDesc.structStride = sizeof(LightConstants);
+    bufferDesc.debugName = "ClusteredLights";
+    bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+    bufferDesc.keepInitialState = true;
+    m_LightBuffer = m_Device->createBuffer(bufferDesc);
+
+    bufferDesc.byteSize = sizeof(float4) * LIGHT_CLUSTERING_MAX_LIGHTS;
+    bufferDesc.structStride = sizeof(float4);
+    bufferDesc.debugName = "ClusteredLightSpheres";
+    m_LightSphereBuffer = m_Device->createBuffer(bufferDesc);
+
+    bufferDesc.byteSize = sizeof(uint32_t) * LightClusterGrid::NumClusters * LightClusterGrid::ClusterStride;
+    bufferDesc.structStride = sizeof(uint32_t);
+    bufferDesc.canHaveUAVs = true;
+    bufferDesc.debugName = "LightClusters";
+    m_ClusterBuffer = m_Device->createBuffer(bufferDesc);
+
+    nvrhi::BindingLayoutDesc layoutDesc;
+    layoutDesc.visibility = nvrhi::ShaderType::Compute;
+    layoutDesc.bindings = {
+        nvrhi::BindingLayoutItem::ConstantBuffer(0),
+        nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
+        nvrhi::BindingLayoutItem::StructuredBuffer_UAV(0)
+    };
+    m_BindingLayout = m_Device->createBindingLayout(layoutDesc);
+
+    nvrhi::BindingSetDesc bindingSetDesc;
+    bindingSetDesc.bindings = {
+        nvrhi::BindingSetItem::ConstantBuffer(0, m_ConstantBuffer),
+        nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_LightSphereBuffer),
+        nvrhi::BindingSetItem::StructuredBuffer_UAV(0, m_ClusterBuffer)
+    };
+    m_BindingSet = m_Device->createBindingSet(bindingSetDesc, m_BindingLayout);
+
+    nvrhi::ComputePipelineDesc pipelineDesc;
+    pipelineDesc.CS = m_ComputeShader;
+    pipelineDesc.bindingLayouts = { m_BindingLayout };
+    m_Pso = m_Device->createComputePipeline(pipelineDesc);
+}
+
+nvrhi::ShaderHandle LightClusteringPass::CreateComputeShader(ShaderFactory& shaderFactory)
+{
+    return shaderFactory.CreateAutoShader("donut/passes/light_clustering_cs.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_light_clustering_cs), nullptr, nvrhi::ShaderType::Compute);
+}
+
+void LightClusteringPass::SetDepthRange(float minDepth, float maxDepth)
+{
+    m_MinDepth = minDepth;
+    m_MaxDepth = maxDepth;
+}
+
+bool LightClusteringPass::IsClusteredLight(const Light& light)
+{
+    return !light.shadowMap && light.shadowChannel < 0;
+}
+
+float4 LightClusteringPass::GetLightCullingSphere(const Light& light)
+{
+    LightConstants lightConstants = {};
+    light.FillLightConstants(lightConstants);
+    return ::GetLightCullingSphere(lightConstants);
+}
+
+void LightClusteringPass::Render(
+    nvrhi::ICommandList* commandList,
+    const IView& view,
+    const std::vector<std::shared_ptr<Light>>& lights)
+{
+    m_Grid.Init(view, m_MinDepth, m_MaxDepth);
+
+    std::vector<LightConstants> lightConstants;
+    std::vector<float4> lightSpheres;
+    lightConstants.reserve(lights.size());
+    lightSpheres.reserve(lights.size());
+
+    for (const auto& light : lights)
+    {
+        if (!IsClusteredLight(*light))
+            continue;
+
+        if (lightConstants.size() >= LIGHT_CLUSTERING_MAX_LIGHTS)
+        {
+            if (!m_OverflowReported)
+            {
+                log::warning("Maximum number of clustered lights (%d) exceeded in LightClusteringPass",
+                    LIGHT_CLUSTERING_MAX_LIGHTS);
+                m_OverflowReported = true;
+            }
+            break;
+        }
+
+        LightConstants& constants = lightConstants.emplace_back();
+        light->FillLightConstants(constants);
+
+        // The spheres are binned in view space, which saves transforming them for every cluster on the GPU
+        float4 sphere = ::GetLightCullingSphere(constants);
+        lightSpheres.push_back(float4(m_Grid.GetWorldToView().transformPoint(sphere.xyz()), sphere.w));
+    }
+
+    m_NumLights = uint32_t(lightConstants.size());
+
+    LightClusterConstants clusterConstants = {};
+    clusterConstants.matWorldToView = affineToHomogeneous(m_Grid.GetWorldToView());
+    clusterConstants.matClipToView = m_Grid.GetClipToView();
+    clusterConstants.viewportOrigin = m_Grid.GetViewportOrigin();
+    clusterConstants.pixelToTile = float2(float(LIGHT_CLUSTER_GRID_X), float(LIGHT_CLUSTER_GRID_Y)) / m_Grid.GetViewportSize();
+    clusterConstants.depthSliceScale = m_Grid.GetDepthSliceScale();
+    clusterConstants.depthSliceBias = m_Grid.GetDepthSliceBias();
+    clusterConstants.numLights = m_NumLights;
+
+    commandList->beginMarker("LightClustering");
+
+    commandList->writeBuffer(m_ConstantBuffer, &clusterConstants, sizeof(clusterConstants));
+    if (m_NumLights > 0)
+    {
+        commandList->writeBuffer(m_LightBuffer, lightConstants.data(), lightConstants.size() * sizeof(LightConstants));
+        commandList->writeBuffer(m_LightSphereBuffer, lightSpheres.data(), lightSpheres.size() * sizeof(float4));
+    }
+
+    nvrhi::ComputeState state;
+    state.pipeline = m_Pso;
+    state.bindings = { m_BindingSet };
+    commandList->setComputeState(state);
+    commandList->dispatch(LightClusterGrid::NumClusters / LIGHT_CLUSTERING_GROUP_SIZE);
+
+    commandList->endMarker();
+}
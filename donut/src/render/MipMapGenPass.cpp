@@ -27,18 +27,22 @@
 #if DONUT_WITH_STATIC_SHADERS
 #if DONUT_WITH_DX11
 #include "compiled_shaders/passes/mipmapgen_cs.dxbc.h"
+#include "compiled_shaders/passes/mipmapgen_spd_cs.dxbc.h"
 #endif
 #if DONUT_WITH_DX12
 #include "compiled_shaders/passes/mipmapgen_cs.dxil.h"
+#include "compiled_shaders/passes/mipmapgen_spd_cs.dxil.h"
 #endif
 #if DONUT_WITH_VULKAN
 #include "compiled_shaders/passes/mipmapgen_cs.spirv.h"
+#include "compiled_shaders/passes/mipmapgen_spd_cs.spirv.h"
 #endif
 #endif
 
 using namespace donut::math;
 #include <donut/shaders/mipmapgen_cb.h>
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>
 
@@ -53,6 +57,12 @@ using namespace donut::render;
 // The set of NullTextures is shared by all the MipMapGen compute pass 
 // instances and ownership is thread-safe.
 //
+// In single-pass mode, all the levels are bound at once (up to SPD_MAX_LODS).
+// Every group reduces a tile of 6 levels, then increments a global atomic
+// counter : the last group to finish reduces the remaining levels from the
+// 6th one. This removes the barriers between the dispatches of the regular mode,
+// which leave most of the GPU idle on the small levels.
+//
 
 static nvrhi::TextureHandle createNullTexture(nvrhi::DeviceHandle device)
 {
@@ -74,7 +84,7 @@ static nvrhi::TextureHandle createNullTexture(nvrhi::DeviceHandle device)
 
 struct MipMapGenPass::NullTextures {
 
-    nvrhi::TextureHandle lod[NUM_LODS];
+    nvrhi::TextureHandle lod[SPD_MAX_LODS];
 
     static std::shared_ptr<NullTextures> get(nvrhi::DeviceHandle device)
     {
@@ -87,7 +97,7 @@ struct MipMapGenPass::NullTextures {
         if (!result)
         {
             result = std::make_shared<NullTextures>();
-            for (int i = 0; i < NUM_LODS; ++i)
+            for (int i = 0; i < SPD_MAX_LODS; ++i)
                 result->lod[i] = createNullTexture(device);
             _nullTextures = result;
         }
@@ -99,9 +109,11 @@ MipMapGenPass::MipMapGenPass(
     nvrhi::IDevice* device,
     std::shared_ptr<ShaderFactory> shaderFactory,
     nvrhi::TextureHandle input, 
-    Mode mode)
+    Mode mode,
+    bool singlePass)
     : m_Device(device)
     , m_Texture(input)
+    , m_Source(input)
     , m_BindingSets(MAX_PASSES)
     , m_BindingCache(device)
 {
@@ -109,6 +121,12 @@ MipMapGenPass::MipMapGenPass(
 
     m_NullTextures = NullTextures::get(m_Device);
 
+    if (singlePass)
+    {
+        CreateSinglePassResources(shaderFactory, mode);
+        return;
+    }
+
     uint nmipLevels = m_Texture->getDesc().mipLevels;
 
     // Shader
@@ -169,10 +187,140 @@ MipMapGenPass::MipMapGenPass(
     m_Pso = device->createComputePipeline(computePipelineDesc);
 }
 
+MipMapGenPass::MipMapGenPass(
+    nvrhi::IDevice* device,
+    std::shared_ptr<ShaderFactory> shaderFactory,
+    nvrhi::TextureHandle source,
+    nvrhi::TextureHandle output,
+    Mode mode)
+    : m_Device(device)
+    , m_Texture(output)
+    , m_Source(source)
+    , m_FirstOutputLevel(0)
+    , m_BindingCache(device)
+{
+    assert(m_Source);
+    assert(m_Texture);
+
+    m_NullTextures = NullTextures::get(m_Device);
+
+    CreateSinglePassResources(shaderFactory, mode);
+}
+
+void MipMapGenPass::CreateSinglePassResources(std::shared_ptr<ShaderFactory> shaderFactory, Mode mode)
+{
+    assert(mode >= 0 && mode <= MODE_MINMAX);
+
+    m_SinglePass = true;
+
+    const nvrhi::TextureDesc& textureDesc = m_Texture->getDesc();
+    uint2 firstLevelSize = uint2(
+        std::max(textureDesc.width >> m_FirstOutputLevel, 1u),
+        std::max(textureDesc.height >> m_FirstOutputLevel, 1u));
+    uint numLODs = std::min(textureDesc.mipLevels - m_FirstOutputLevel, GetMaxSinglePassLevels(firstLevelSize));
+    assert(numLODs > 0);
+
+    std::vector<ShaderMacro> macros = { {"MODE", std::to_string(mode)} };
+    m_Shader = shaderFactory->CreateAutoShader(
+        "donut/passes/mipmapgen_spd_cs.hlsl", "main", DONUT_MAKE_PLATFORM_SHADER(g_mipmapgen_spd_cs), &macros, nvrhi::ShaderType::Compute);
+
+    nvrhi::BufferDesc constantBufferDesc;
+    constantBufferDesc.byteSize = sizeof(MipMapGenSinglePassConstants);
+    constantBufferDesc.isConstantBuffer = true;
+    constantBufferDesc.isVolatile = true;
+    constantBufferDesc.debugName = "MipMapGenPass/Constants";
+    constantBufferDesc.maxVersions = c_MaxRenderPassConstantBufferVersions;
+    m_ConstantBuffer = m_Device->createBuffer(constantBufferDesc);
+
+    nvrhi::BufferDesc counterBufferDesc;
+    counterBufferDesc.byteSize = sizeof(uint32_t);
+    counterBufferDesc.canHaveUAVs = true;
+    counterBufferDesc.canHaveRawViews = true;
+    counterBufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+    counterBufferDesc.keepInitialState = true;
+    counterBufferDesc.debugName = "MipMapGenPass/Counter";
+    m_CounterBuffer = m_Device->createBuffer(counterBufferDesc);
+
+    nvrhi::BindingLayoutDesc layoutDesc;
+    layoutDesc.visibility = nvrhi::ShaderType::Compute;
+    layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::VolatileConstantBuffer(0));
+    layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::Texture_SRV(0));
+    for (uint level = 1; level <= SPD_MAX_LODS; ++level)
+    {
+        layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::Texture_UAV(level - 1));
+    }
+    layoutDesc.bindings.push_back(nvrhi::BindingLayoutItem::RawBuffer_UAV(SPD_MAX_LODS));
+    m_BindingLayout = m_Device->createBindingLayout(layoutDesc);
+
+    nvrhi::BindingSetDesc setDesc;
+    setDesc.bindings.push_back(nvrhi::BindingSetItem::ConstantBuffer(0, m_ConstantBuffer));
+    setDesc.bindings.push_back(nvrhi::BindingSetItem::Texture_SRV(0, m_Source, nvrhi::Format::UNKNOWN, nvrhi::TextureSubresourceSet(0, 1, 0, 1)));
+    for (uint level = 1; level <= SPD_MAX_LODS; ++level)
+    {
+        if (level <= numLODs)
+            setDesc.bindings.push_back(nvrhi::BindingSetItem::Texture_UAV(level - 1, m_Texture, nvrhi::Format::UNKNOWN, nvrhi::TextureSubresourceSet(m_FirstOutputLevel + level - 1, 1, 0, 1)));
+        else
+            setDesc.bindings.push_back(nvrhi::BindingSetItem::Texture_UAV(level - 1, m_NullTextures->lod[level - 1]));
+    }
+    setDesc.bindings.push_back(nvrhi::BindingSetItem::RawBuffer_UAV(SPD_MAX_LODS, m_CounterBuffer));
+    m_BindingSets = { m_Device->createBindingSet(setDesc, m_BindingLayout) };
+
+    nvrhi::ComputePipelineDesc computePipelineDesc;
+    computePipelineDesc.CS = m_Shader;
+    computePipelineDesc.bindingLayouts = { m_BindingLayout };
+
+    m_Pso = m_Device->createComputePipeline(computePipelineDesc);
+}
+
+void MipMapGenPass::DispatchSinglePass(nvrhi::ICommandList* commandList, int maxLOD)
+{
+    const nvrhi::TextureDesc& sourceDesc = m_Source->getDesc();
+    const nvrhi::TextureDesc& textureDesc = m_Texture->getDesc();
+
+    MipMapGenSinglePassConstants constants = {};
+    constants.sourceSize = uint2(sourceDesc.width, sourceDesc.height);
+    constants.firstLevelSize = uint2(
+        std::max(textureDesc.width >> m_FirstOutputLevel, 1u),
+        std::max(textureDesc.height >> m_FirstOutputLevel, 1u));
+
+    uint numLODs = std::min(textureDesc.mipLevels - m_FirstOutputLevel, GetMaxSinglePassLevels(constants.firstLevelSize));
+    if (maxLOD >= 0 && uint(maxLOD) < m_FirstOutputLevel + numLODs)
+        numLODs = uint(maxLOD) + 1 - m_FirstOutputLevel;
+    if (numLODs == 0)
+        return;
+
+    constants.numLODs = numLODs;
+
+    uint2 groups = (constants.firstLevelSize + uint(SPD_TILE_SIZE - 1)) / uint(SPD_TILE_SIZE);
+    constants.numWorkGroups = groups.x * groups.y;
+    commandList->writeBuffer(m_ConstantBuffer, &constants, sizeof(constants));
+
+    // The shader resets the counter when it's done, so it only needs to be cleared once
+    if (!m_CounterInitialized)
+    {
+        commandList->clearBufferUInt(m_CounterBuffer, 0);
+        m_CounterInitialized = true;
+    }
+
+    nvrhi::ComputeState state;
+    state.pipeline = m_Pso;
+    state.bindings = { m_BindingSets[0] };
+    commandList->setComputeState(state);
+    commandList->dispatch(groups.x, groups.y);
+}
+
 void MipMapGenPass::Dispatch(nvrhi::ICommandList* commandList, int maxLOD) 
 {
     assert(m_Texture);
 
+    if (m_SinglePass)
+    {
+        commandList->beginMarker("MipMapGen::DispatchSinglePass");
+        DispatchSinglePass(commandList, maxLOD);
+        commandList->endMarker(); // "MipMapGen::DispatchSinglePass"
+        return;
+    }
+
     commandList->beginMarker("MipMapGen::Dispatch");
 
     uint nmipLevels = m_Texture->getDesc().mipLevels;
@@ -217,12 +365,12 @@ void MipMapGenPass::Display(std::shared_ptr<donut::engine::CommonRenderPasses> c
     float2 size = { m_Texture->getDesc().width / 2.f, m_Texture->getDesc().height / 2.f };
     float2 corner = { 10.f, uint(viewport.maxY) - 10.f };
  
-    for (uint level = 0; level < m_Texture->getDesc().mipLevels-1; ++level)
+    for (uint level = 0; level < m_Texture->getDesc().mipLevels - m_FirstOutputLevel; ++level)
     {
         BlitParameters blitParams;
         blitParams.targetFramebuffer = target;
         blitParams.sourceTexture = m_Texture;
-        blitParams.sourceMip = level + 1;
+        blitParams.sourceMip = level + m_FirstOutputLevel;
         blitParams.targetViewport = nvrhi::Viewport(
             corner.x,
             corner.x + size.x,
@@ -243,4 +391,80 @@ void MipMapGenPass::Display(std::shared_ptr<donut::engine::CommonRenderPasses> c
         size = { size.x / 2.f, size.y / 2.f };
     }
     commandList->endMarker(); // "MipMapGen::Display"
-}
\ No newline at end of file
+}
+
+uint32_t MipMapGenPass::GetNumChannels(Mode mode)
+{
+    switch (mode)
+    {
+    case MODE_COLOR: return 4;
+    case MODE_MINMAX: return 2;
+    default: return 1;
+    }
+}
+
+uint32_t MipMapGenPass::GetMaxSinglePassLevels(uint2 firstLevelSize)
+{
+    uint largest = std::max(firstLevelSize.x, firstLevelSize.y);
+
+    uint levels = 1;
+    while ((largest >> levels) != 0)
+        ++levels;
+
+    // The last group reduces the levels after the 6th one from a single tile
+    if (levels > 6 && (largest >> 5) > SPD_TILE_SIZE * 2)
+        return 6;
+
+    return std::min(levels, uint(SPD_MAX_LODS));
+}
+
+void MipMapGenPass::ReduceReference(
+    Mode mode,
+    const float* source,
+    uint2 sourceSize,
+    float* destination,
+    uint2 destinationSize)
+{
+    assert(source && destination);
+    assert(all(sourceSize > 0u));
+
+    const uint channels = GetNumChannels(mode);
+
+    // Same order of operations as reduce(a, b, c, d) in the shaders
+    auto reduce = [mode](uint channel, float a, float b)
+    {
+        switch (mode)
+        {
+        case MODE_COLOR: return a + (b - a) * 0.5f;
+        case MODE_MIN: return std::min(a, b);
+        case MODE_MAX: return std::max(a, b);
+        case MODE_MINMAX: return channel == 0 ? std::min(a, b) : std::max(a, b);
+        }
+        return a;
+    };
+
+    for (uint y = 0; y < destinationSize.y; ++y)
+    {
+        uint y0 = std::min(y * 2 + 0, sourceSize.y - 1);
+        uint y1 = std::min(y * 2 + 1, sourceSize.y - 1);
+
+        for (uint x = 0; x < destinationSize.x; ++x)
+        {
+            uint x0 = std::min(x * 2 + 0, sourceSize.x - 1);
+            uint x1 = std::min(x * 2 + 1, sourceSize.x - 1);
+
+            const float* a = source + (y0 * sourceSize.x + x0) * channels;
+            const float* b = source + (y0 * sourceSize.x + x1) * channels;
+            const float* c = source + (y1 * sourceSize.x + x0) * channels;
+            const float* d = source + (y1 * sourceSize.x + x1) * channels;
+            float* result = destination + (y * destinationSize.x + x) * channels;
+
+            for (uint channel = 0; channel < channels; ++channel)
+            {
+                result[channel] = reduce(channel,
+                    reduce(channel, a[channel], b[channel]),
+                    reduce(channel, c[channel], d[channel]));
+            }
+        }
+    }
+}
@@ -0,0 +1,459 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/OcclusionCuller.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+namespace
+{
+    // 4-wide float vectors for the rasterizer, using the same backend selection as the math library, see <donut/core/math/simd.h>
+#if DONUT_MATH_SSE2
+
+    struct Lanes
+    {
+        __m128 v;
+    };
+
+    inline Lanes Splat(float a) { return { _mm_set1_ps(a) }; }
+    inline Lanes Load(const float* p) { return { _mm_loadu_ps(p) }; }
+    inline void Store(float* p, Lanes a) { _mm_storeu_ps(p, a.v); }
+    inline Lanes operator + (Lanes a, Lanes b) { return { _mm_add_ps(a.v, b.v) }; }
+    inline Lanes operator * (Lanes a, Lanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+    inline Lanes Min(Lanes a, Lanes b) { return { _mm_min_ps(a.v, b.v) }; }
+    inline Lanes Max(Lanes a, Lanes b) { return { _mm_max_ps(a.v, b.v) }; }
+    // Returns 'value' in the lanes where 'mask' is not negative, and 0 in the other lanes
+    inline Lanes SelectNonNegative(Lanes mask, Lanes value) { return { _mm_and_ps(_mm_cmpge_ps(mask.v, _mm_setzero_ps()), value.v) }; }
+
+#elif DONUT_MATH_NEON
+
+    struct Lanes
+    {
+        float32x4_t v;
+    };
+
+    inline Lanes Splat(float a) { return { vdupq_n_f32(a) }; }
+    inline Lanes Load(const float* p) { return { vld1q_f32(p) }; }
+    inline void Store(float* p, Lanes a) { vst1q_f32(p, a.v); }
+    inline Lanes operator + (Lanes a, Lanes b) { return { vaddq_f32(a.v, b.v) }; }
+    inline Lanes operator * (Lanes a, Lanes b) { return { vmulq_f32(a.v, b.v) }; }
+    inline Lanes Min(Lanes a, Lanes b) { return { vminq_f32(a.v, b.v) }; }
+    inline Lanes Max(Lanes a, Lanes b) { return { vmaxq_f32(a.v, b.v) }; }
+    inline Lanes SelectNonNegative(Lanes mask, Lanes value)
+    {
+        return { vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(mask.v, vdupq_n_f32(0.f)), vreinterpretq_u32_f32(value.v))) };
+    }
+
+#else
+
+    struct Lanes
+    {
+        float v[4];
+    };
+
+    inline Lanes Splat(float a) { return { { a, a, a, a } }; }
+    inline Lanes Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void Store(float* p, Lanes a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+    inline Lanes operator + (Lanes a, Lanes b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+    inline Lanes operator * (Lanes a, Lanes b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+    inline Lanes Min(Lanes a, Lanes b) { for (int i = 0; i < 4; i++) a.v[i] = std::min(a.v[i], b.v[i]); return a; }
+    inline Lanes Max(Lanes a, Lanes b) { for (int i = 0; i < 4; i++) a.v[i] = std::max(a.v[i], b.v[i]); return a; }
+    inline Lanes SelectNonNegative(Lanes mask, Lanes value) { for (int i = 0; i < 4; i++) value.v[i] = mask.v[i] >= 0.f ? value.v[i] : 0.f; return value; }
+
+#endif
+
+    inline float HorizontalMin(Lanes a)
+    {
+        float v[4];
+        Store(v, a);
+        return std::min(std::min(v[0], v[1]), std::min(v[2], v[3]));
+    }
+
+    // Offsets of the pixel centers processed by the lanes, relative to the first pixel
+    const float c_LaneOffsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+
+    // Relative depth difference under which an occluder doesn't hide a box,
+    // so that occluders don't cull themselves or coplanar geometry.
+    constexpr float c_DepthBias = 1e-3f;
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+{
+    SetResolution(width, height);
+}
+
+void OcclusionCuller::SetResolution(uint32_t width, uint32_t height)
+{
+    m_Width = std::max((width + BlockSize - 1) / BlockSize * BlockSize, BlockSize);
+    m_Height = std::max((height + BlockSize - 1) / BlockSize * BlockSize, BlockSize);
+    m_Depth.assign(size_t(m_Width) * m_Height, 0.f);
+    m_BlockDepth.assign(size_t(m_Width / BlockSize) * (m_Height / BlockSize), 0.f);
+    m_BlockDepthValid = true;
+}
+
+void OcclusionCuller::BeginView(const float4x4& worldToClip, bool reverseDepth)
+{
+    m_WorldToClip = worldToClip;
+    m_ReverseDepth = reverseDepth;
+    m_Statistics = Statistics();
+
+    std::fill(m_Depth.begin(), m_Depth.end(), 0.f);
+    std::fill(m_BlockDepth.begin(), m_BlockDepth.end(), 0.f);
+    m_BlockDepthValid = true;
+}
+
+float OcclusionCuller::GetNearPlaneDistance(const float4& clipPosition) const
+{
+    return m_ReverseDepth ? clipPosition.w - clipPosition.z : clipPosition.z;
+}
+
+float3 OcclusionCuller::ProjectToScreen(const float4& clipPosition) const
+{
+    float invW = 1.f / clipPosition.w;
+    float depth = clipPosition.z * invW;
+
+    return float3(
+        (clipPosition.x * invW * 0.5f + 0.5f) * float(m_Width),
+        (0.5f - clipPosition.y * invW * 0.5f) * float(m_Height),
+        m_ReverseDepth ? depth : 1.f - depth);
+}
+
+void OcclusionCuller::RasterizeOccluder(const float3* positions, const uint32_t* indices, size_t numIndices, const affine3& localToWorld)
+{
+    if (numIndices < 3)
+        return;
+
+    uint32_t numVertices = *std::max_element(indices, indices + numIndices) + 1;
+    float4x4 localToClip = affineToHomogeneous(localToWorld) * m_WorldToClip;
+
+    m_ClipPositions.resize(numVertices);
+    for (uint32_t vertex = 0; vertex < numVertices; vertex++)
+        m_ClipPositions[vertex] = float4(positions[vertex], 1.f) * localToClip;
+
+    for (size_t index = 0; index + 2 < numIndices; index += 3)
+    {
+        RasterizeTriangle(
+            m_ClipPositions[indices[index]],
+            m_ClipPositions[indices[index + 1]],
+            m_ClipPositions[indices[index + 2]]);
+    }
+
+    m_Statistics.numOccluderTriangles += uint32_t(numIndices / 3);
+    m_BlockDepthValid = false;
+}
+
+void OcclusionCuller::RasterizeTriangle(const float4& a, const float4& b, const float4& c)
+{
+    // Reject the triangles that are entirely outside one of the side planes
+    if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+        (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w))
+        return;
+
+    const float4 vertices[3] = { a, b, c };
+    const float distances[3] = { GetNearPlaneDistance(a), GetNearPlaneDistance(b), GetNearPlaneDistance(c) };
+
+    if (distances[0] >= 0.f && distances[1] >= 0.f && distances[2] >= 0.f)
+    {
+        RasterizeScreenTriangle(ProjectToScreen(a), ProjectToScreen(b), ProjectToScreen(c));
+        return;
+    }
+
+    // Clip against the near plane, which produces a triangle or a quad
+    float3 clipped[4];
+    int numClipped = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        int j = (i + 1) % 3;
+        if (distances[i] >= 0.f)
+            clipped[numClipped++] = ProjectToScreen(vertices[i]);
+
+        if ((distances[i] >= 0.f) != (distances[j] >= 0.f))
+        {
+            float t = distances[i] / (distances[i] - distances[j]);
+            clipped[numClipped++] = ProjectToScreen(lerp(vertices[i], vertices[j], t));
+        }
+    }
+
+    if (numClipped >= 3)
+        RasterizeScreenTriangle(clipped[0], clipped[1], clipped[2]);
+    if (numClipped == 4)
+        RasterizeScreenTriangle(clipped[0], clipped[2], clipped[3]);
+}
+
+void OcclusionCuller::RasterizeScreenTriangle(float3 v0, float3 v1, float3 v2)
+{
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (!(std::abs(area) > 1e-8f))
+        return;
+
+    // Occluders hide the geometry behind them from both sides
+    if (area < 0.f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    // Pixels whose centers are inside the bounding rectangle, with the first column aligned to the lane count
+    float minX = std::ceil(std::min(std::min(v0.x, v1.x), v2.x) - 0.5f);
+    float maxX = std::floor(std::max(std::max(v0.x, v1.x), v2.x) - 0.5f);
+    float minY = std::ceil(std::min(std::min(v0.y, v1.y), v2.y) - 0.5f);
+    float maxY = std::floor(std::max(std::max(v0.y, v1.y), v2.y) - 0.5f);
+    if (!(minX <= maxX && minY <= maxY) || maxX < 0.f || maxY < 0.f || minX >= float(m_Width) || minY >= float(m_Height))
+        return;
+
+    int x0 = int(std::max(minX, 0.f)) & ~3;
+    int x1 = int(std::min(maxX, float(m_Width - 1)));
+    int y0 = int(std::max(minY, 0.f));
+    int y1 = int(std::min(maxY, float(m_Height - 1)));
+
+    ++m_Statistics.numRasterizedTriangles;
+
+    // Edge functions E(x, y) = A * x + B * y + C, not negative inside the triangle
+    const float3 edgeStart[3] = { v0, v1, v2 };
+    const float3 edgeEnd[3] = { v1, v2, v0 };
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (int edge = 0; edge < 3; edge++)
+    {
+        edgeA[edge] = edgeStart[edge].y - edgeEnd[edge].y;
+        edgeB[edge] = edgeEnd[edge].x - edgeStart[edge].x;
+        edgeC[edge] = -(edgeA[edge] * edgeStart[edge].x + edgeB[edge] * edgeStart[edge].y);
+    }
+
+    // Depth plane
+    float depthDx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+    float depthDy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+
+    const Lanes laneX = Splat(float(x0)) + Load(c_LaneOffsets);
+    const Lanes stepE0 = Splat(edgeA[0] * 4.f);
+    const Lanes stepE1 = Splat(edgeA[1] * 4.f);
+    const Lanes stepE2 = Splat(edgeA[2] * 4.f);
+    const Lanes stepDepth = Splat(depthDx * 4.f);
+
+    for (int y = y0; y <= y1; y++)
+    {
+        float pixelY = float(y) + 0.5f;
+
+        Lanes e0 = Splat(edgeA[0]) * laneX + Splat(edgeB[0] * pixelY + edgeC[0]);
+        Lanes e1 = Splat(edgeA[1]) * laneX + Splat(edgeB[1] * pixelY + edgeC[1]);
+        Lanes e2 = Splat(edgeA[2]) * laneX + Splat(edgeB[2] * pixelY + edgeC[2]);
+        Lanes depth = Splat(depthDx) * (laneX + Splat(-v0.x)) + Splat(v0.z + depthDy * (pixelY - v0.y));
+
+        float* row = m_Depth.data() + size_t(y) * m_Width;
+
+        // The width is a multiple of the lane count, so the last group never crosses the end of the row
+        for (int x = x0; x <= x1; x += 4)
+        {
+            Lanes inside = Min(Min(e0, e1), e2);
+            Store(row + x, Max(Load(row + x), SelectNonNegative(inside, depth)));
+
+            e0 = e0 + stepE0;
+            e1 = e1 + stepE1;
+            e2 = e2 + stepE2;
+            depth = depth + stepDepth;
+        }
+    }
+}
+
+void OcclusionCuller::UpdateBlockDepth()
+{
+    uint32_t blocksX = m_Width / BlockSize;
+    uint32_t blocksY = m_Height / BlockSize;
+
+    for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+        {
+            Lanes farthest = Splat(FLT_MAX);
+            for (uint32_t y = 0; y < BlockSize; y++)
+            {
+                const float* row = m_Depth.data() + size_t(blockY * BlockSize + y) * m_Width + blockX * BlockSize;
+                for (uint32_t x = 0; x < BlockSize; x += 4)
+                    farthest = Min(farthest, Load(row + x));
+            }
+            m_BlockDepth[blockY * blocksX + blockX] = HorizontalMin(farthest);
+        }
+    }
+
+    m_BlockDepthValid = true;
+}
+
+bool OcclusionCuller::IsBoxVisible(const box3& worldBounds)
+{
+    ++m_Statistics.numTests;
+
+    float2 screenMin = FLT_MAX;
+    float2 screenMax = -FLT_MAX;
+    float nearestDepth = -FLT_MAX;
+
+    for (int corner = 0; corner < 8; corner++)
+    {
+        float4 clipPosition = float4(worldBounds.getCorner(corner), 1.f) * m_WorldToClip;
+
+        // Boxes that cross the near plane are always visible
+        if (GetNearPlaneDistance(clipPosition) < 0.f)
+            return true;
+
+        float3 screenPosition = ProjectToScreen(clipPosition);
+        screenMin = min(screenMin, screenPosition.xy());
+        screenMax = max(screenMax, screenPosition.xy());
+        nearestDepth = std::max(nearestDepth, screenPosition.z);
+    }
+
+    if (screenMax.x <= 0.f || screenMax.y <= 0.f || screenMin.x >= float(m_Width) || screenMin.y >= float(m_Height))
+        return false;
+
+    if (!m_BlockDepthValid)
+        UpdateBlockDepth();
+
+    // All the pixels touched by the screen rectangle must be covered by a closer occluder
+    uint32_t x0 = uint32_t(std::max(std::floor(screenMin.x), 0.f));
+    uint32_t y0 = uint32_t(std::max(std::floor(screenMin.y), 0.f));
+    uint32_t x1 = uint32_t(std::min(std::ceil(screenMax.x), float(m_Width))) - 1;
+    uint32_t y1 = uint32_t(std::min(std::ceil(screenMax.y), float(m_Height))) - 1;
+    float threshold = nearestDepth + std::abs(nearestDepth) * c_DepthBias;
+
+    uint32_t blocksX = m_Width / BlockSize;
+
+    for (uint32_t blockY = y0 / BlockSize; blockY <= y1 / BlockSize; blockY++)
+    {
+        for (uint32_t blockX = x0 / BlockSize; blockX <= x1 / BlockSize; blockX++)
+        {
+            if (m_BlockDepth[blockY * blocksX + blockX] > threshold)
+                continue;
+
+            uint32_t startX = std::max(x0, blockX * BlockSize);
+            uint32_t endX = std::min(x1, blockX * BlockSize + BlockSize - 1);
+            uint32_t startY = std::max(y0, blockY * BlockSize);
+            uint32_t endY = std::min(y1, blockY * BlockSize + BlockSize - 1);
+
+            for (uint32_t y = startY; y <= endY; y++)
+            {
+                const float* row = m_Depth.data() + size_t(y) * m_Width;
+                for (uint32_t x = startX; x <= endX; x++)
+                {
+                    if (row[x] <= threshold)
+                        return true;
+                }
+            }
+        }
+    }
+
+    ++m_Statistics.numOccluded;
+    return false;
+}
+
+void OcclusionCuller::PrepareForView(const std::shared_ptr<SceneGraphNode>& rootNode, const IView& view)
+{
+    BeginView(view.GetViewProjectionMatrix(true), view.IsReverseDepth());
+
+    struct Candidate
+    {
+        MeshInstance* instance;
+        float size;
+    };
+    std::vector<Candidate> candidates;
+
+    const frustum viewFrustum = view.GetViewFrustum();
+    const float3 viewOrigin = view.GetViewOrigin();
+    const bool orthographic = view.IsOrthographicProjection();
+    const float projectionScale = view.GetProjectionMatrix(false)[1][1];
+
+    SceneGraphWalker walker(rootNode.get());
+    while (walker)
+    {
+        bool subgraphContentRelevant = (walker->GetSubgraphContentFlags() & SceneContentFlags::OpaqueMeshes) != 0;
+        bool nodeContentsRelevant = (walker->GetLeafContentFlags() & SceneContentFlags::OpaqueMeshes) != 0;
+
+        bool nodeVisible = false;
+        if (subgraphContentRelevant)
+        {
+            const box3& bounds = walker->GetGlobalBoundingBox();
+            nodeVisible = viewFrustum.intersectsWith(bounds);
+
+            auto meshInstance = (nodeVisible && nodeContentsRelevant) ? dynamic_cast<MeshInstance*>(walker->GetLeaf().get()) : nullptr;
+            if (meshInstance)
+            {
+                const MeshInfo* mesh = meshInstance->GetMesh().get();
+                bool hasCpuData = mesh->buffers && !mesh->buffers->positionData.empty() && !mesh->buffers->indexData.empty();
+
+                if (hasCpuData && !mesh->skinPrototype)
+                {
+                    // Radius of the bounding sphere relative to the viewport half-height
+                    float radius = length(bounds.diagonal()) * 0.5f;
+                    float size = radius * projectionScale;
+                    if (!orthographic)
+                        size /= std::max(length(bounds.center() - viewOrigin), radius);
+
+                    if (size >= m_MinOccluderSize)
+                        candidates.push_back(Candidate{ meshInstance, size });
+                }
+            }
+        }
+
+        walker.Next(nodeVisible);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.size > b.size; });
+    if (candidates.size() > m_MaxOccluders)
+        candidates.resize(m_MaxOccluders);
+
+    for (const Candidate& candidate : candidates)
+    {
+        const MeshInfo* mesh = candidate.instance->GetMesh().get();
+        const affine3& localToWorld = candidate.instance->GetNode()->GetLocalToWorldTransformFloat();
+        bool rasterized = false;
+
+        for (const auto& geometry : mesh->geometries)
+        {
+            // Alpha tested materials have holes
+            if (geometry->material && geometry->material->domain != MaterialDomain::Opaque)
+                continue;
+
+            uint32_t lod = geometry->getNumLods() - 1;
+            while (lod > 0 && geometry->lods[lod - 1].error > m_MaxOccluderLodError)
+                --lod;
+
+            uint32_t numIndices = geometry->getLodNumIndices(lod);
+            if (m_Statistics.numOccluderTriangles + numIndices / 3 > m_MaxOccluderTriangles)
+                continue;
+
+            RasterizeOccluder(
+                mesh->buffers->positionData.data() + mesh->vertexOffset + geometry->vertexOffsetInMesh,
+                mesh->buffers->indexData.data() + mesh->indexOffset + geometry->getLodIndexOffsetInMesh(lod),
+                numIndices,
+                localToWorld);
+
+            rasterized = true;
+        }
+
+        if (rasterized)
+            ++m_Statistics.numOccluders;
+    }
+}
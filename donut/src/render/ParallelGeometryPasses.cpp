@@ -0,0 +1,257 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+#include <donut/render/ParallelGeometryPasses.h>
+#include <donut/render/DrawStrategy.h>
+#include <donut/engine/FramebufferFactory.h>
+#include <donut/engine/ParallelFor.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/core/profiler.h>
+
+#include <cassert>
+
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+void donut::render::SplitDrawLists(
+    const std::vector<size_t>& itemCounts,
+    uint32_t maxSlices,
+    size_t minItemsPerSlice,
+    std::vector<DrawListSlice>& outSlices)
+{
+    outSlices.clear();
+    minItemsPerSlice = std::max<size_t>(minItemsPerSlice, 1);
+
+    std::vector<uint32_t> slicesPerView(itemCounts.size(), 0);
+    uint32_t numSlices = 0;
+
+    for (size_t viewIndex = 0; viewIndex < itemCounts.size(); viewIndex++)
+    {
+        if (itemCounts[viewIndex] > 0)
+        {
+            slicesPerView[viewIndex] = 1;
+            ++numSlices;
+        }
+    }
+
+    // Give the remaining slices one by one to the view whose slices are currently the longest,
+    // as long as the new slices would not become shorter than the minimum.
+    while (numSlices < maxSlices)
+    {
+        size_t bestView = itemCounts.size();
+        size_t bestLength = 0;
+
+        for (size_t viewIndex = 0; viewIndex < itemCounts.size(); viewIndex++)
+        {
+            uint32_t slices = slicesPerView[viewIndex];
+            if (slices == 0 || itemCounts[viewIndex] / (slices + 1) < minItemsPerSlice)
+                continue;
+
+            size_t length = itemCounts[viewIndex] / slices;
+            if (length > bestLength)
+            {
+                bestLength = length;
+                bestView = viewIndex;
+            }
+        }
+
+        if (bestView == itemCounts.size())
+            break;
+
+        ++slicesPerView[bestView];
+        ++numSlices;
+    }
+
+    for (size_t viewIndex = 0; viewIndex < itemCounts.size(); viewIndex++)
+    {
+        const size_t count = itemCounts[viewIndex];
+        const uint32_t slices = slicesPerView[viewIndex];
+
+        for (uint32_t slice = 0; slice < slices; slice++)
+        {
+            DrawListSlice& item = outSlices.emplace_back();
+            item.viewIndex = uint32_t(viewIndex);
+            item.firstItem = count * slice / slices;
+            item.numItems = count * (slice + 1) / slices - item.firstItem;
+        }
+    }
+}
+
+ParallelViewRecorder::ParallelViewRecorder(nvrhi::IDevice* device, tf::Executor* executor)
+    : m_Device(device)
+    , m_Executor(executor)
+{
+    // NVRHI records D3D11 command lists directly into the immediate context, so there is nothing to parallelize.
+    m_ParallelRecordingSupported = device->getGraphicsAPI() != nvrhi::GraphicsAPI::D3D11;
+}
+
+uint32_t ParallelViewRecorder::GetNumThreads() const
+{
+#ifdef DONUT_WITH_TASKFLOW
+    if (m_Executor && m_ParallelRecordingSupported)
+        return uint32_t(m_Executor->num_workers());
+#endif
+    return 1;
+}
+
+void ParallelViewRecorder::RenderCompositeView(
+    const ICompositeView* compositeView,
+    const ICompositeView* compositeViewPrev,
+    FramebufferFactory& framebufferFactory,
+    const std::shared_ptr<SceneGraphNode>& rootNode,
+    const DrawStrategyFactory& drawStrategyFactory,
+    IGeometryPass& pass,
+    const PassContextFactory& passContextFactory,
+    const char* passEvent,
+    bool materialEvents)
+{
+    const ViewType::Enum supportedViewTypes = pass.GetSupportedViewTypes();
+    const uint32_t numViews = compositeView->GetNumChildViews(supportedViewTypes);
+
+    if (compositeViewPrev)
+    {
+        // the views must have the same topology
+        assert(numViews == compositeViewPrev->GetNumChildViews(supportedViewTypes));
+    }
+
+    m_Stats = Stats();
+    m_Stats.numViews = numViews;
+    m_NumRecordedCommandLists = 0;
+
+    auto getCommandList = [this](uint32_t index)
+    {
+        while (m_CommandLists.size() <= index)
+        {
+            // Non-immediate lists can stay open while the application records into its own immediate list.
+            // D3D11 only supports immediate lists, and there is only ever one of them in use.
+            m_CommandLists.push_back(m_Device->createCommandList(nvrhi::CommandListParameters()
+                .setEnableImmediateExecution(!m_ParallelRecordingSupported)));
+        }
+        return m_CommandLists[index].Get();
+    };
+
+    if (!m_ParallelRecordingSupported)
+    {
+        nvrhi::ICommandList* commandList = getCommandList(0);
+        std::unique_ptr<IDrawStrategy> drawStrategy = drawStrategyFactory();
+        std::unique_ptr<GeometryPassContext> passContext = passContextFactory();
+
+        commandList->open();
+        donut::render::RenderCompositeView(commandList, compositeView, compositeViewPrev, framebufferFactory,
+            rootNode, *drawStrategy, pass, *passContext, passEvent, materialEvents);
+        commandList->close();
+
+        m_NumRecordedCommandLists = 1;
+        m_Stats.numCommandLists = 1;
+        return;
+    }
+
+    // Framebuffer factories are not thread-safe, so resolve the framebuffers upfront.
+    std::vector<nvrhi::IFramebuffer*> framebuffers(numViews);
+    for (uint32_t viewIndex = 0; viewIndex < numViews; viewIndex++)
+        framebuffers[viewIndex] = framebufferFactory.GetFramebuffer(*compositeView->GetChildView(supportedViewTypes, viewIndex));
+
+    // Run the draw strategy for every view. The items are copied because strategies
+    // only guarantee that the returned pointers are valid until the next GetNextItem() call.
+    if (m_ViewDrawItems.size() < numViews)
+        m_ViewDrawItems.resize(numViews);
+
+    ParallelFor(m_Executor, numViews, [this, compositeView, supportedViewTypes, &rootNode, &drawStrategyFactory](uint32_t viewIndex)
+    {
+        DONUT_PROFILE_SCOPE("ParallelViewRecorder::CollectDrawItems");
+
+        const IView* view = compositeView->GetChildView(supportedViewTypes, viewIndex);
+        assert(view != nullptr);
+
+        std::unique_ptr<IDrawStrategy> drawStrategy = drawStrategyFactory();
+        drawStrategy->PrepareForView(rootNode, *view);
+
+        std::vector<DrawItem>& items = m_ViewDrawItems[viewIndex];
+        items.clear();
+        while (const DrawItem* item = drawStrategy->GetNextItem())
+            items.push_back(*item);
+    });
+
+    std::vector<size_t> itemCounts(numViews);
+    for (uint32_t viewIndex = 0; viewIndex < numViews; viewIndex++)
+    {
+        itemCounts[viewIndex] = m_ViewDrawItems[viewIndex].size();
+        m_Stats.numDrawItems += itemCounts[viewIndex];
+    }
+
+    const uint32_t maxSlices = m_MaxSlices ? m_MaxSlices : GetNumThreads();
+    SplitDrawLists(itemCounts, maxSlices, m_MinItemsPerSlice, m_Slices);
+
+    const uint32_t numSlices = uint32_t(m_Slices.size());
+    for (uint32_t sliceIndex = 0; sliceIndex < numSlices; sliceIndex++)
+        getCommandList(sliceIndex);
+
+    ParallelFor(m_Executor, numSlices, [&](uint32_t sliceIndex)
+    {
+        DONUT_PROFILE_SCOPE("ParallelViewRecorder::RecordSlice");
+
+        const DrawListSlice& slice = m_Slices[sliceIndex];
+        const IView* view = compositeView->GetChildView(supportedViewTypes, slice.viewIndex);
+        const IView* viewPrev = compositeViewPrev ? compositeViewPrev->GetChildView(supportedViewTypes, slice.viewIndex) : nullptr;
+
+        PassthroughDrawStrategy drawStrategy;
+        drawStrategy.SetData(m_ViewDrawItems[slice.viewIndex].data() + slice.firstItem, slice.numItems);
+
+        std::unique_ptr<GeometryPassContext> passContext = passContextFactory();
+
+        nvrhi::ICommandList* commandList = m_CommandLists[sliceIndex];
+        commandList->open();
+
+        if (passEvent)
+            commandList->beginMarker(passEvent);
+
+        RenderView(commandList, view, viewPrev, framebuffers[slice.viewIndex], drawStrategy, pass, *passContext, materialEvents);
+
+        if (passEvent)
+            commandList->endMarker();
+
+        commandList->close();
+    });
+
+    m_NumRecordedCommandLists = numSlices;
+    m_Stats.numCommandLists = numSlices;
+}
+
+void ParallelViewRecorder::GetCommandLists(std::vector<nvrhi::ICommandList*>& outCommandLists) const
+{
+    for (uint32_t index = 0; index < m_NumRecordedCommandLists; index++)
+        outCommandLists.push_back(m_CommandLists[index]);
+}
+
+void ParallelViewRecorder::Submit(nvrhi::ICommandList* precedingCommandList)
+{
+    std::vector<nvrhi::ICommandList*> commandLists;
+    if (precedingCommandList)
+        commandLists.push_back(precedingCommandList);
+
+    GetCommandLists(commandLists);
+
+    if (!commandLists.empty())
+        m_Device->executeCommandLists(commandLists.data(), commandLists.size());
+
+    m_NumRecordedCommandLists = 0;
+}
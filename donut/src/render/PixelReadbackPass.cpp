@@ -23,6 +23,8 @@
 #include <donut/render/PixelReadbackPass.h>
 #include <donut/engine/ShaderFactory.h>
 #include <donut/engine/CommonRenderPasses.h>
+#include <donut/engine/ReadbackQueue.h>
+#include <cstring>
 
 #if DONUT_WITH_STATIC_SHADERS
 #if DONUT_WITH_DX11
@@ -129,6 +131,41 @@ void PixelReadbackPass::Capture(nvrhi::ICommandList* commandList, dm::uint2 pixe
     commandList->copyBuffer(m_ReadbackBuffer, 0, m_IntermediateBuffer, 0, m_ReadbackBuffer->getDesc().byteSize);
 }
 
+void PixelReadbackPass::CaptureAsync(nvrhi::ICommandList* commandList, dm::uint2 pixelPosition, ReadbackQueue& readbackQueue,
+    std::function<void(const Value& value)> callback)
+{
+    PixelReadbackConstants constants = {};
+    constants.pixelPosition = dm::int2(pixelPosition);
+    commandList->writeBuffer(m_ConstantBuffer, &constants, sizeof(constants));
+
+    nvrhi::ComputeState state;
+    state.pipeline = m_Pipeline;
+    state.bindings = { m_BindingSet };
+    commandList->setComputeState(state);
+    commandList->dispatch(1, 1, 1);
+
+    // The queue copies the intermediate buffer into its own staging buffer, so the next capture
+    // can overwrite the intermediate buffer without waiting for this one to complete.
+    readbackQueue.RequestBuffer(commandList, m_IntermediateBuffer, 0, m_IntermediateBuffer->getDesc().byteSize,
+        [callback = std::move(callback)](const void* data, size_t size)
+        {
+            if (!data || size < sizeof(uint4) || !callback)
+                return;
+
+            Value value;
+            memcpy(&value.bits, data, sizeof(uint4));
+            callback(value);
+        });
+}
+
+dm::float4 PixelReadbackPass::Value::AsFloats() const
+{
+    float4 values;
+    for (int i = 0; i < 4; i++)
+        memcpy(&values[i], &bits[i], sizeof(float));
+    return values;
+}
+
 dm::float4 PixelReadbackPass::ReadFloats()
 {
     void* pData = m_Device->mapBuffer(m_ReadbackBuffer, nvrhi::CpuAccessMode::Read);
@@ -0,0 +1,589 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/RenderGraph.h>
+#include <donut/core/log.h>
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace donut::render;
+
+static bool TextureDescsMatch(const nvrhi::TextureDesc& a, const nvrhi::TextureDesc& b)
+{
+    return a.width == b.width
+        && a.height == b.height
+        && a.depth == b.depth
+        && a.arraySize == b.arraySize
+        && a.mipLevels == b.mipLevels
+        && a.sampleCount == b.sampleCount
+        && a.sampleQuality == b.sampleQuality
+        && a.format == b.format
+        && a.dimension == b.dimension
+        && a.isShaderResource == b.isShaderResource
+        && a.isRenderTarget == b.isRenderTarget
+        && a.isUAV == b.isUAV
+        && a.isTypeless == b.isTypeless
+        && a.isShadingRateSurface == b.isShadingRateSurface
+        && a.isVirtual == b.isVirtual
+        && a.useClearValue == b.useClearValue
+        && (!a.useClearValue || a.clearValue == b.clearValue)
+        && a.initialState == b.initialState
+        && a.keepInitialState == b.keepInitialState;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Read(RenderGraphTexture texture, nvrhi::ResourceStates state)
+{
+    m_Graph.AddAccess(m_PassIndex, texture, state, RenderGraph::AccessType::Read);
+    return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Write(RenderGraphTexture texture, nvrhi::ResourceStates state)
+{
+    m_Graph.AddAccess(m_PassIndex, texture, state, RenderGraph::AccessType::Write);
+    return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Modify(RenderGraphTexture texture, nvrhi::ResourceStates state)
+{
+    m_Graph.AddAccess(m_PassIndex, texture, state, RenderGraph::AccessType::Modify);
+    return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::SetSideEffects(bool value)
+{
+    m_Graph.m_Passes[m_PassIndex].sideEffects = value;
+    return *this;
+}
+
+void RenderGraph::Reset()
+{
+    m_Passes.clear();
+    m_Textures.clear();
+    m_FinalBarriers.clear();
+    m_Stats = RenderGraphStats();
+    m_Compiled = false;
+}
+
+RenderGraphTexture RenderGraph::ImportTexture(nvrhi::ITexture* texture, nvrhi::ResourceStates finalState)
+{
+    assert(texture);
+
+    Texture& entry = m_Textures.emplace_back();
+    entry.desc = texture->getDesc();
+    entry.texture = texture;
+    entry.finalState = finalState;
+    entry.imported = true;
+
+    return RenderGraphTexture{ uint32_t(m_Textures.size() - 1) };
+}
+
+RenderGraphTexture RenderGraph::CreateTexture(const nvrhi::TextureDesc& desc)
+{
+    Texture& entry = m_Textures.emplace_back();
+    entry.desc = desc;
+
+    return RenderGraphTexture{ uint32_t(m_Textures.size() - 1) };
+}
+
+RenderGraphPassBuilder RenderGraph::AddPass(const std::string& name, ExecuteFunction execute)
+{
+    Pass& pass = m_Passes.emplace_back();
+    pass.name = name;
+    pass.execute = std::move(execute);
+
+    return RenderGraphPassBuilder(*this, uint32_t(m_Passes.size() - 1));
+}
+
+void RenderGraph::AddAccess(uint32_t passIndex, RenderGraphTexture texture, nvrhi::ResourceStates state, AccessType type)
+{
+    assert(texture.index < m_Textures.size());
+
+    Pass& pass = m_Passes[passIndex];
+
+    for (TextureAccess& access : pass.accesses)
+    {
+        if (access.texture != texture)
+            continue;
+
+        if (access.state != state)
+        {
+            log::error("Render graph pass '%s' accesses texture '%s' in different states",
+                pass.name.c_str(), m_Textures[texture.index].desc.debugName.c_str());
+            return;
+        }
+
+        if (access.type != type)
+            access.type = AccessType::Modify;
+
+        return;
+    }
+
+    TextureAccess& access = pass.accesses.emplace_back();
+    access.texture = texture;
+    access.state = state;
+    access.type = type;
+}
+
+nvrhi::ITexture* RenderGraph::GetTexture(RenderGraphTexture texture) const
+{
+    assert(texture.index < m_Textures.size());
+    return m_Textures[texture.index].texture;
+}
+
+const nvrhi::TextureDesc& RenderGraph::GetTextureDesc(RenderGraphTexture texture) const
+{
+    assert(texture.index < m_Textures.size());
+    return m_Textures[texture.index].desc;
+}
+
+const RenderGraphAllocation* RenderGraph::GetTransientAllocation(RenderGraphTexture texture) const
+{
+    assert(texture.index < m_Textures.size());
+    const Texture& entry = m_Textures[texture.index];
+    if (entry.imported || !entry.used)
+        return nullptr;
+
+    return &entry.allocation;
+}
+
+nvrhi::MemoryRequirements RenderGraph::EstimateTextureMemoryRequirements(const nvrhi::TextureDesc& desc)
+{
+    const nvrhi::FormatInfo& formatInfo = nvrhi::getFormatInfo(desc.format);
+    const uint32_t blockSize = std::max<uint32_t>(formatInfo.blockSize, 1);
+    const bool is3D = desc.dimension == nvrhi::TextureDimension::Texture3D;
+
+    uint64_t size = 0;
+    for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+    {
+        uint64_t width = std::max(desc.width >> mipLevel, 1u);
+        uint64_t height = std::max(desc.height >> mipLevel, 1u);
+        uint64_t depth = is3D ? std::max(desc.depth >> mipLevel, 1u) : 1;
+        size += ((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize) * depth * formatInfo.bytesPerBlock;
+    }
+
+    size *= std::max(desc.arraySize, 1u) * std::max(desc.sampleCount, 1u);
+
+    // Typical placement alignment for render targets in D3D12 and Vulkan
+    nvrhi::MemoryRequirements requirements;
+    requirements.alignment = desc.sampleCount > 1 ? 4 * 1024 * 1024 : 64 * 1024;
+    requirements.size = nvrhi::align(size, requirements.alignment);
+    return requirements;
+}
+
+void RenderGraph::CullPasses()
+{
+    // Walk the passes backwards, tracking which textures have contents that are still going to be read.
+    // A pass is needed if it writes an imported texture or a texture that a later needed pass reads.
+    std::vector<bool> contentsNeeded(m_Textures.size(), false);
+
+    for (size_t passIndex = m_Passes.size(); passIndex-- > 0; )
+    {
+        Pass& pass = m_Passes[passIndex];
+
+        bool needed = pass.sideEffects;
+        for (const TextureAccess& access : pass.accesses)
+        {
+            if (access.type != AccessType::Read && (m_Textures[access.texture.index].imported || contentsNeeded[access.texture.index]))
+                needed = true;
+        }
+
+        pass.culled = !needed;
+        if (!needed)
+            continue;
+
+        for (const TextureAccess& access : pass.accesses)
+            contentsNeeded[access.texture.index] = (access.type != AccessType::Write);
+    }
+}
+
+void RenderGraph::ComputeLifetimes(bool aliasingSupported)
+{
+    for (uint32_t passIndex = 0; passIndex < uint32_t(m_Passes.size()); passIndex++)
+    {
+        Pass& pass = m_Passes[passIndex];
+        if (pass.culled)
+            continue;
+
+        for (const TextureAccess& access : pass.accesses)
+        {
+            Texture& texture = m_Textures[access.texture.index];
+
+            if (!texture.used && !texture.imported)
+            {
+                texture.allocation.firstPass = passIndex;
+
+                if (access.type != AccessType::Write)
+                {
+                    log::warning("Render graph pass '%s' reads transient texture '%s' before it's written",
+                        pass.name.c_str(), texture.desc.debugName.c_str());
+                }
+
+                // Aliased render targets must be initialized before use, the pass may only draw into a part of them
+                if (texture.desc.useClearValue || (aliasingSupported && texture.desc.isRenderTarget))
+                {
+                    pass.texturesToClear.push_back(access.texture);
+                    ++m_Stats.numClears;
+                }
+            }
+
+            texture.used = true;
+            texture.allocation.lastPass = passIndex;
+        }
+    }
+}
+
+void RenderGraph::PlanBarriers()
+{
+    std::vector<nvrhi::ResourceStates> currentStates(m_Textures.size(), nvrhi::ResourceStates::Unknown);
+
+    for (Pass& pass : m_Passes)
+    {
+        if (pass.culled)
+            continue;
+
+        for (const TextureAccess& access : pass.accesses)
+        {
+            const Texture& texture = m_Textures[access.texture.index];
+            nvrhi::ResourceStates& currentState = currentStates[access.texture.index];
+
+            // Transient textures are created in the state of their first use, see AllocateTransientTextures.
+            if (currentState == nvrhi::ResourceStates::Unknown && !texture.imported)
+                currentState = access.state;
+
+            if (currentState != access.state)
+            {
+                pass.barriers.push_back(RenderGraphBarrier{ access.texture, currentState, access.state });
+                currentState = access.state;
+            }
+        }
+
+        if (!pass.barriers.empty())
+        {
+            ++m_Stats.numBarrierBatches;
+            m_Stats.numBarriers += uint32_t(pass.barriers.size());
+        }
+    }
+
+    for (uint32_t index = 0; index < uint32_t(m_Textures.size()); index++)
+    {
+        const Texture& texture = m_Textures[index];
+        if (texture.imported && texture.used && texture.finalState != nvrhi::ResourceStates::Unknown &&
+            texture.finalState != currentStates[index])
+        {
+            m_FinalBarriers.push_back(RenderGraphBarrier{ RenderGraphTexture{ index }, currentStates[index], texture.finalState });
+        }
+    }
+
+    if (!m_FinalBarriers.empty())
+    {
+        ++m_Stats.numBarrierBatches;
+        m_Stats.numBarriers += uint32_t(m_FinalBarriers.size());
+    }
+}
+
+void RenderGraph::PlaceTransientTextures(nvrhi::IDevice* device, bool aliasingSupported)
+{
+    std::vector<uint32_t> transients;
+    std::vector<nvrhi::MemoryRequirements> requirements(m_Textures.size());
+
+    for (uint32_t index = 0; index < uint32_t(m_Textures.size()); index++)
+    {
+        Texture& texture = m_Textures[index];
+        if (texture.imported || !texture.used)
+            continue;
+
+        // The state of the first use becomes the initial state of the texture.
+        // The command lists begin tracking it in that state and return it there when they are closed.
+        for (const TextureAccess& access : m_Passes[texture.allocation.firstPass].accesses)
+        {
+            if (access.texture.index == index)
+                texture.desc.initialState = access.state;
+        }
+        texture.desc.keepInitialState = true;
+        texture.desc.isVirtual = device && aliasingSupported;
+
+        if (texture.desc.isVirtual)
+        {
+            // Look for a retained texture with the same properties first, to avoid creating a new object just to query its size.
+            nvrhi::TextureHandle candidate;
+            for (const PhysicalTexture& physical : m_PhysicalTextures)
+            {
+                if (TextureDescsMatch(physical.texture->getDesc(), texture.desc))
+                {
+                    candidate = physical.texture;
+                    break;
+                }
+            }
+
+            if (!candidate)
+            {
+                candidate = device->createTexture(texture.desc);
+                texture.texture = candidate;
+            }
+
+            requirements[index] = device->getTextureMemoryRequirements(candidate);
+        }
+        else
+        {
+            requirements[index] = EstimateTextureMemoryRequirements(texture.desc);
+        }
+
+        texture.allocation.size = requirements[index].size;
+        m_Stats.transientMemoryWithoutAliasing += requirements[index].size;
+        ++m_Stats.numTransientTextures;
+        transients.push_back(index);
+    }
+
+    if (!aliasingSupported)
+    {
+        uint64_t offset = 0;
+        for (uint32_t index : transients)
+        {
+            m_Textures[index].allocation.offset = offset;
+            offset += m_Textures[index].allocation.size;
+        }
+        m_Stats.transientMemoryWithAliasing = offset;
+        return;
+    }
+
+    // Greedy placement, largest textures first: each texture goes to the lowest offset where it doesn't
+    // overlap any already placed texture whose lifetime intersects its own.
+    std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b)
+    {
+        const RenderGraphAllocation& allocA = m_Textures[a].allocation;
+        const RenderGraphAllocation& allocB = m_Textures[b].allocation;
+        if (allocA.size != allocB.size)
+            return allocA.size > allocB.size;
+        return allocA.firstPass < allocB.firstPass;
+    });
+
+    std::vector<const RenderGraphAllocation*> placed;
+    std::vector<const RenderGraphAllocation*> conflicts;
+    uint64_t heapSize = 0;
+
+    for (uint32_t index : transients)
+    {
+        RenderGraphAllocation& allocation = m_Textures[index].allocation;
+        const uint64_t alignment = std::max<uint64_t>(requirements[index].alignment, 1);
+
+        conflicts.clear();
+        for (const RenderGraphAllocation* other : placed)
+        {
+            if (other->firstPass <= allocation.lastPass && allocation.firstPass <= other->lastPass)
+                conflicts.push_back(other);
+        }
+
+        std::sort(conflicts.begin(), conflicts.end(), [](const RenderGraphAllocation* a, const RenderGraphAllocation* b)
+        {
+            return a->offset < b->offset;
+        });
+
+        uint64_t offset = 0;
+        for (const RenderGraphAllocation* other : conflicts)
+        {
+            if (offset + allocation.size <= other->offset)
+                break;
+
+            offset = std::max(offset, nvrhi::align(other->offset + other->size, alignment));
+        }
+
+        allocation.offset = offset;
+        heapSize = std::max(heapSize, offset + allocation.size);
+        placed.push_back(&allocation);
+    }
+
+    m_Stats.transientMemoryWithAliasing = heapSize;
+}
+
+bool RenderGraph::AllocateTransientTextures(nvrhi::IDevice* device, bool aliasingSupported)
+{
+    if (aliasingSupported && m_Stats.transientMemoryWithAliasing > 0 &&
+        (!m_Heap || m_Heap->getDesc().capacity < m_Stats.transientMemoryWithAliasing))
+    {
+        // The retained textures are bound to the old heap, so they can't be used anymore.
+        m_PhysicalTextures.clear();
+
+        nvrhi::HeapDesc heapDesc;
+        heapDesc.type = nvrhi::HeapType::DeviceLocal;
+        heapDesc.capacity = m_Stats.transientMemoryWithAliasing;
+        heapDesc.debugName = "RenderGraphTransientHeap";
+        m_Heap = device->createHeap(heapDesc);
+
+        if (!m_Heap)
+        {
+            log::error("Failed to create the render graph transient heap (%llu bytes)",
+                (unsigned long long)m_Stats.transientMemoryWithAliasing);
+            return false;
+        }
+    }
+
+    for (PhysicalTexture& physical : m_PhysicalTextures)
+        physical.usedThisFrame = false;
+
+    for (Texture& texture : m_Textures)
+    {
+        if (texture.imported || !texture.used)
+            continue;
+
+        const uint64_t offset = aliasingSupported ? texture.allocation.offset : 0;
+
+        auto it = std::find_if(m_PhysicalTextures.begin(), m_PhysicalTextures.end(), [&texture, offset](const PhysicalTexture& physical)
+        {
+            return !physical.usedThisFrame && physical.offset == offset && TextureDescsMatch(physical.texture->getDesc(), texture.desc);
+        });
+
+        if (it != m_PhysicalTextures.end())
+        {
+            texture.texture = it->texture;
+            it->usedThisFrame = true;
+            continue;
+        }
+
+        // Virtual textures can only be bound once, so don't reuse a candidate that was created for another offset.
+        if (!texture.texture || !aliasingSupported)
+            texture.texture = device->createTexture(texture.desc);
+
+        if (!texture.texture)
+        {
+            log::error("Failed to create render graph texture '%s'", texture.desc.debugName.c_str());
+            return false;
+        }
+
+        if (aliasingSupported && !device->bindTextureMemory(texture.texture, m_Heap, offset))
+        {
+            log::error("Failed to bind memory for render graph texture '%s'", texture.desc.debugName.c_str());
+            return false;
+        }
+
+        PhysicalTexture& physical = m_PhysicalTextures.emplace_back();
+        physical.texture = texture.texture;
+        physical.offset = offset;
+        physical.usedThisFrame = true;
+    }
+
+    // Release the textures that weren't needed by this frame's graph
+    m_PhysicalTextures.erase(std::remove_if(m_PhysicalTextures.begin(), m_PhysicalTextures.end(),
+        [](const PhysicalTexture& physical) { return !physical.usedThisFrame; }), m_PhysicalTextures.end());
+
+    return true;
+}
+
+bool RenderGraph::Compile(nvrhi::IDevice* device)
+{
+    for (Pass& pass : m_Passes)
+    {
+        pass.barriers.clear();
+        pass.texturesToClear.clear();
+    }
+    for (Texture& texture : m_Textures)
+    {
+        texture.used = false;
+        texture.allocation = RenderGraphAllocation();
+        if (!texture.imported)
+            texture.texture = nullptr;
+    }
+    m_FinalBarriers.clear();
+    m_Stats = RenderGraphStats();
+
+    // Planning without a device assumes that the textures can be aliased
+    const bool aliasingSupported = !device || device->queryFeatureSupport(nvrhi::Feature::VirtualResources);
+
+    CullPasses();
+    ComputeLifetimes(aliasingSupported);
+    PlanBarriers();
+    PlaceTransientTextures(device, aliasingSupported);
+
+    m_Stats.numPasses = uint32_t(m_Passes.size());
+    for (const Pass& pass : m_Passes)
+    {
+        if (pass.culled)
+            ++m_Stats.numCulledPasses;
+    }
+
+    m_Compiled = device ? AllocateTransientTextures(device, aliasingSupported) : false;
+
+    return !device || m_Compiled;
+}
+
+void RenderGraph::Execute(nvrhi::ICommandList* commandList)
+{
+    if (!m_Compiled)
+    {
+        log::error("RenderGraph::Execute called without a successful Compile with a device");
+        return;
+    }
+
+    for (uint32_t passIndex = 0; passIndex < uint32_t(m_Passes.size()); passIndex++)
+        ExecutePass(commandList, passIndex);
+
+    if (!m_FinalBarriers.empty())
+    {
+        for (const RenderGraphBarrier& barrier : m_FinalBarriers)
+            commandList->setTextureState(m_Textures[barrier.texture.index].texture, nvrhi::AllSubresources, barrier.stateAfter);
+        commandList->commitBarriers();
+    }
+}
+
+void RenderGraph::ExecutePass(nvrhi::ICommandList* commandList, uint32_t passIndex)
+{
+    if (!m_Compiled)
+    {
+        log::error("RenderGraph::ExecutePass called without a successful Compile with a device");
+        return;
+    }
+
+    assert(passIndex < m_Passes.size());
+    const Pass& pass = m_Passes[passIndex];
+    if (pass.culled)
+        return;
+
+    commandList->beginMarker(pass.name.c_str());
+
+    for (RenderGraphTexture handle : pass.texturesToClear)
+    {
+        const Texture& texture = m_Textures[handle.index];
+        const nvrhi::FormatInfo& formatInfo = nvrhi::getFormatInfo(texture.desc.format);
+
+        if (formatInfo.hasDepth || formatInfo.hasStencil)
+        {
+            commandList->clearDepthStencilTexture(texture.texture, nvrhi::AllSubresources,
+                formatInfo.hasDepth, texture.desc.clearValue.r, formatInfo.hasStencil, uint8_t(texture.desc.clearValue.g));
+        }
+        else
+        {
+            commandList->clearTextureFloat(texture.texture, nvrhi::AllSubresources, texture.desc.clearValue);
+        }
+    }
+
+    // Put all transitions for the pass into one batch. Requesting the states that the textures
+    // are already in is free, and it covers the textures whose states were changed by the clears above.
+    for (const TextureAccess& access : pass.accesses)
+        commandList->setTextureState(m_Textures[access.texture.index].texture, nvrhi::AllSubresources, access.state);
+    commandList->commitBarriers();
+
+    if (pass.execute)
+        pass.execute(commandList, *this);
+
+    commandList->endMarker();
+}
@@ -0,0 +1,143 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/ShadowCasterCache.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+
+#include <cassert>
+
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+void ShadowCasterCache::Update(const SceneGraph& sceneGraph, const std::vector<const IView*>& views, uint32_t frameIndex)
+{
+    m_FrameIndex = frameIndex;
+
+    struct Caster
+    {
+        const MeshInstance* instance;
+        const box3* bounds;
+        bool dynamic;
+    };
+
+    std::vector<Caster> casters;
+    casters.reserve(sceneGraph.GetMeshInstances().size());
+
+    const auto relevantContentFlags = SceneContentFlags::OpaqueMeshes | SceneContentFlags::AlphaTestedMeshes;
+
+    for (const auto& instance : sceneGraph.GetMeshInstances())
+    {
+        const SceneGraphNode* node = instance->GetNode();
+        if (!node || (node->GetLeafContentFlags() & relevantContentFlags) == 0)
+            continue;
+
+        // After SceneGraph::Refresh, PrevTransform marks the nodes whose global transform has just changed
+        bool moved = (node->GetDirtyFlags() & SceneGraphNode::DirtyFlags::PrevTransform) != 0;
+        if (auto skinnedInstance = dynamic_cast<const SkinnedMeshInstance*>(instance.get()))
+            moved |= skinnedInstance->GetLastUpdateFrameIndex() == frameIndex;
+
+        auto [it, inserted] = m_Instances.try_emplace(instance.get());
+        InstanceState& state = it->second;
+
+        // The first transform of new instances is not a movement
+        if (moved && !inserted)
+        {
+            state.lastMovedFrame = frameIndex;
+            state.moved = true;
+        }
+        state.lastSeenFrame = frameIndex;
+
+        casters.push_back(Caster{ instance.get(), &node->GetGlobalBoundingBox(), IsInstanceDynamic(*instance) });
+    }
+
+    // Forget the instances that were removed from the scene
+    for (auto it = m_Instances.begin(); it != m_Instances.end(); )
+    {
+        if (it->second.lastSeenFrame != frameIndex)
+            it = m_Instances.erase(it);
+        else
+            ++it;
+    }
+
+    m_Views.resize(views.size());
+
+    for (size_t viewIndex = 0; viewIndex < views.size(); viewIndex++)
+    {
+        const IView* view = views[viewIndex];
+        ViewState& state = m_Views[viewIndex];
+
+        const frustum viewFrustum = view->GetViewFrustum();
+        const float4x4 viewProjection = view->GetViewProjectionMatrix(false);
+
+        // FNV-1a over the static casters in the frustum, in the stable order of the scene graph
+        uint64_t staticCasters = 14695981039346656037ull;
+        bool hasDynamicCasters = false;
+
+        for (const Caster& caster : casters)
+        {
+            if (!viewFrustum.intersectsWith(*caster.bounds))
+                continue;
+
+            if (caster.dynamic)
+            {
+                hasDynamicCasters = true;
+                continue;
+            }
+
+            staticCasters = (staticCasters ^ uint64_t(reinterpret_cast<uintptr_t>(caster.instance))) * 1099511628211ull;
+        }
+
+        bool staticChanged = !state.valid || any(state.viewProjection != viewProjection) || state.staticCasters != staticCasters;
+
+        state.update.renderStatic = staticChanged;
+        state.update.renderDynamic = staticChanged || hasDynamicCasters || state.hadDynamicCasters;
+        state.update.hasDynamicCasters = hasDynamicCasters;
+
+        state.viewProjection = viewProjection;
+        state.staticCasters = staticCasters;
+        state.hadDynamicCasters = hasDynamicCasters;
+        state.valid = true;
+    }
+}
+
+const ShadowCasterCache::ViewUpdate& ShadowCasterCache::GetViewUpdate(size_t view) const
+{
+    assert(view < m_Views.size());
+    return m_Views[view].update;
+}
+
+bool ShadowCasterCache::IsInstanceDynamic(const MeshInstance& instance) const
+{
+    auto it = m_Instances.find(&instance);
+    if (it == m_Instances.end() || !it->second.moved)
+        return false;
+
+    return m_FrameIndex - it->second.lastMovedFrame < m_DynamicFrames;
+}
+
+void ShadowCasterCache::Invalidate()
+{
+    for (ViewState& state : m_Views)
+        state.valid = false;
+}
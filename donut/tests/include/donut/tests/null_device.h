@@ -0,0 +1,276 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace donut::tests
+{
+	// Buffer of NullDevice. Every buffer keeps its contents in system memory,
+	// so that writeBuffer, copyBuffer and mapBuffer behave like they do on a real device.
+	class NullBuffer : public nvrhi::RefCounter<nvrhi::IBuffer>
+	{
+	public:
+		nvrhi::BufferDesc desc;
+		std::vector<uint8_t> data;
+
+		explicit NullBuffer(const nvrhi::BufferDesc& d) : desc(d), data(size_t(d.byteSize)) { }
+		[[nodiscard]] const nvrhi::BufferDesc& getDesc() const override { return desc; }
+	};
+
+	class NullTexture : public nvrhi::RefCounter<nvrhi::ITexture>
+	{
+	public:
+		nvrhi::TextureDesc desc;
+
+		explicit NullTexture(const nvrhi::TextureDesc& d) : desc(d) { }
+		[[nodiscard]] const nvrhi::TextureDesc& getDesc() const override { return desc; }
+		nvrhi::Object getNativeView(nvrhi::ObjectType, nvrhi::Format, nvrhi::TextureSubresourceSet, nvrhi::TextureDimension, bool) override { return nullptr; }
+	};
+
+	class NullHeap : public nvrhi::RefCounter<nvrhi::IHeap>
+	{
+	public:
+		nvrhi::HeapDesc desc;
+
+		explicit NullHeap(const nvrhi::HeapDesc& d) : desc(d) { }
+		const nvrhi::HeapDesc& getDesc() override { return desc; }
+	};
+
+	class NullEventQuery : public nvrhi::RefCounter<nvrhi::IEventQuery> { };
+
+	class NullBindingLayout : public nvrhi::RefCounter<nvrhi::IBindingLayout>
+	{
+	public:
+		nvrhi::BindingLayoutDesc desc;
+
+		explicit NullBindingLayout(const nvrhi::BindingLayoutDesc& d) : desc(d) { }
+		[[nodiscard]] const nvrhi::BindingLayoutDesc* getDesc() const override { return &desc; }
+		[[nodiscard]] const nvrhi::BindlessLayoutDesc* getBindlessDesc() const override { return nullptr; }
+	};
+
+	class NullBindingSet : public nvrhi::RefCounter<nvrhi::IBindingSet>
+	{
+	public:
+		nvrhi::BindingSetDesc desc;
+		nvrhi::BindingLayoutHandle layout;
+
+		NullBindingSet(const nvrhi::BindingSetDesc& d, nvrhi::IBindingLayout* l) : desc(d), layout(l) { }
+		[[nodiscard]] const nvrhi::BindingSetDesc* getDesc() const override { return &desc; }
+		[[nodiscard]] nvrhi::IBindingLayout* getLayout() const override { return layout; }
+	};
+
+	// Command list of NullDevice: buffer writes and copies are executed immediately, everything else is ignored.
+	// Tests can derive from it to record the commands they are interested in.
+	class NullCommandList : public nvrhi::RefCounter<nvrhi::ICommandList>
+	{
+	public:
+		nvrhi::IDevice* device;
+		nvrhi::CommandListParameters parameters;
+
+		NullCommandList(nvrhi::IDevice* d, const nvrhi::CommandListParameters& params) : device(d), parameters(params) { }
+
+		void open() override { }
+		void close() override { }
+		void clearState() override { }
+		void clearTextureFloat(nvrhi::ITexture*, nvrhi::TextureSubresourceSet, const nvrhi::Color&) override { }
+		void clearDepthStencilTexture(nvrhi::ITexture*, nvrhi::TextureSubresourceSet, bool, float, bool, uint8_t) override { }
+		void clearTextureUInt(nvrhi::ITexture*, nvrhi::TextureSubresourceSet, uint32_t) override { }
+		void copyTexture(nvrhi::ITexture*, const nvrhi::TextureSlice&, nvrhi::ITexture*, const nvrhi::TextureSlice&) override { }
+		void copyTexture(nvrhi::IStagingTexture*, const nvrhi::TextureSlice&, nvrhi::ITexture*, const nvrhi::TextureSlice&) override { }
+		void copyTexture(nvrhi::ITexture*, const nvrhi::TextureSlice&, nvrhi::IStagingTexture*, const nvrhi::TextureSlice&) override { }
+		void writeTexture(nvrhi::ITexture*, uint32_t, uint32_t, const void*, size_t, size_t) override { }
+		void resolveTexture(nvrhi::ITexture*, const nvrhi::TextureSubresourceSet&, nvrhi::ITexture*, const nvrhi::TextureSubresourceSet&) override { }
+
+		void writeBuffer(nvrhi::IBuffer* b, const void* data, size_t dataSize, uint64_t destOffsetBytes) override
+		{
+			auto buffer = static_cast<NullBuffer*>(b);
+			if (destOffsetBytes + dataSize <= buffer->data.size())
+				memcpy(buffer->data.data() + destOffsetBytes, data, dataSize);
+			else
+				std::abort();
+		}
+
+		void clearBufferUInt(nvrhi::IBuffer* b, uint32_t clearValue) override
+		{
+			auto buffer = static_cast<NullBuffer*>(b);
+			for (size_t offset = 0; offset + sizeof(uint32_t) <= buffer->data.size(); offset += sizeof(uint32_t))
+				memcpy(buffer->data.data() + offset, &clearValue, sizeof(uint32_t));
+		}
+
+		void copyBuffer(nvrhi::IBuffer* dest, uint64_t destOffsetBytes, nvrhi::IBuffer* src, uint64_t srcOffsetBytes, uint64_t dataSizeBytes) override
+		{
+			auto destBuffer = static_cast<NullBuffer*>(dest);
+			auto srcBuffer = static_cast<NullBuffer*>(src);
+			if (destOffsetBytes + dataSizeBytes <= destBuffer->data.size() && srcOffsetBytes + dataSizeBytes <= srcBuffer->data.size())
+				memmove(destBuffer->data.data() + destOffsetBytes, srcBuffer->data.data() + srcOffsetBytes, size_t(dataSizeBytes));
+			else
+				std::abort();
+		}
+
+		void setPushConstants(const void*, size_t) override { }
+		void setGraphicsState(const nvrhi::GraphicsState&) override { }
+		void draw(const nvrhi::DrawArguments&) override { }
+		void drawIndexed(const nvrhi::DrawArguments&) override { }
+		void drawIndirect(uint32_t, uint32_t) override { }
+		void drawIndexedIndirect(uint32_t, uint32_t) override { }
+		void setComputeState(const nvrhi::ComputeState&) override { }
+		void dispatch(uint32_t, uint32_t, uint32_t) override { }
+		void dispatchIndirect(uint32_t) override { }
+		void setMeshletState(const nvrhi::MeshletState&) override { }
+		void dispatchMesh(uint32_t, uint32_t, uint32_t) override { }
+		void setRayTracingState(const nvrhi::rt::State&) override { }
+		void dispatchRays(const nvrhi::rt::DispatchRaysArguments&) override { }
+		void buildOpacityMicromap(nvrhi::rt::IOpacityMicromap*, const nvrhi::rt::OpacityMicromapDesc&) override { }
+		void buildBottomLevelAccelStruct(nvrhi::rt::IAccelStruct*, const nvrhi::rt::GeometryDesc*, size_t, nvrhi::rt::AccelStructBuildFlags) override { }
+		void compactBottomLevelAccelStructs() override { }
+		void buildTopLevelAccelStruct(nvrhi::rt::IAccelStruct*, const nvrhi::rt::InstanceDesc*, size_t, nvrhi::rt::AccelStructBuildFlags) override { }
+		void buildTopLevelAccelStructFromBuffer(nvrhi::rt::IAccelStruct*, nvrhi::IBuffer*, uint64_t, size_t, nvrhi::rt::AccelStructBuildFlags) override { }
+		void beginTimerQuery(nvrhi::ITimerQuery*) override { }
+		void endTimerQuery(nvrhi::ITimerQuery*) override { }
+		void beginMarker(const char*) override { }
+		void endMarker() override { }
+		void setEnableAutomaticBarriers(bool) override { }
+		void setResourceStatesForBindingSet(nvrhi::IBindingSet*) override { }
+		void setEnableUavBarriersForTexture(nvrhi::ITexture*, bool) override { }
+		void setEnableUavBarriersForBuffer(nvrhi::IBuffer*, bool) override { }
+		void beginTrackingTextureState(nvrhi::ITexture*, nvrhi::TextureSubresourceSet, nvrhi::ResourceStates) override { }
+		void beginTrackingBufferState(nvrhi::IBuffer*, nvrhi::ResourceStates) override { }
+		void setTextureState(nvrhi::ITexture*, nvrhi::TextureSubresourceSet, nvrhi::ResourceStates) override { }
+		void setBufferState(nvrhi::IBuffer*, nvrhi::ResourceStates) override { }
+		void setAccelStructState(nvrhi::rt::IAccelStruct*, nvrhi::ResourceStates) override { }
+		void setPermanentTextureState(nvrhi::ITexture*, nvrhi::ResourceStates) override { }
+		void setPermanentBufferState(nvrhi::IBuffer*, nvrhi::ResourceStates) override { }
+		void commitBarriers() override { }
+		nvrhi::ResourceStates getTextureSubresourceState(nvrhi::ITexture*, nvrhi::ArraySlice, nvrhi::MipLevel) override { return nvrhi::ResourceStates::Common; }
+		nvrhi::ResourceStates getBufferState(nvrhi::IBuffer*) override { return nvrhi::ResourceStates::Common; }
+		nvrhi::IDevice* getDevice() override { return device; }
+		const nvrhi::CommandListParameters& getDesc() override { return parameters; }
+	};
+
+	/*
+	NullDevice is an nvrhi device without a GPU, for tests of the engine code that creates and fills resources.
+	It creates buffers, textures, heaps, binding layouts and sets, event queries and command lists;
+	the other object types are not supported and their creation functions return nullptr, which is enough
+	for code that only stores them, such as pipelines built from shaders that the tests cannot compile.
+	Command lists execute synchronously, so every event query is signaled as soon as it is set.
+	Optional features, such as VirtualResources, are reported as supported when they are listed in supportedFeatures.
+	*/
+	class NullDevice : public nvrhi::RefCounter<nvrhi::IDevice>
+	{
+	public:
+		std::vector<nvrhi::Feature> supportedFeatures;
+
+		nvrhi::HeapHandle createHeap(const nvrhi::HeapDesc& d) override { return nvrhi::HeapHandle::Create(new NullHeap(d)); }
+		nvrhi::TextureHandle createTexture(const nvrhi::TextureDesc& d) override { return nvrhi::TextureHandle::Create(new NullTexture(d)); }
+
+		nvrhi::MemoryRequirements getTextureMemoryRequirements(nvrhi::ITexture* texture) override
+		{
+			const nvrhi::TextureDesc& desc = texture->getDesc();
+			const nvrhi::FormatInfo& formatInfo = nvrhi::getFormatInfo(desc.format);
+
+			nvrhi::MemoryRequirements requirements;
+			requirements.alignment = 64 * 1024;
+			for (uint32_t mipLevel = 0; mipLevel < desc.mipLevels; mipLevel++)
+			{
+				uint64_t blocksX = (std::max(desc.width >> mipLevel, 1u) + formatInfo.blockSize - 1) / formatInfo.blockSize;
+				uint64_t blocksY = (std::max(desc.height >> mipLevel, 1u) + formatInfo.blockSize - 1) / formatInfo.blockSize;
+				requirements.size += blocksX * blocksY * std::max(desc.depth >> mipLevel, 1u) * desc.arraySize * formatInfo.bytesPerBlock;
+			}
+			requirements.size = (requirements.size + requirements.alignment - 1) & ~(requirements.alignment - 1);
+			return requirements;
+		}
+
+		bool bindTextureMemory(nvrhi::ITexture*, nvrhi::IHeap*, uint64_t) override { return true; }
+		nvrhi::TextureHandle createHandleForNativeTexture(nvrhi::ObjectType, nvrhi::Object, const nvrhi::TextureDesc&) override { return nullptr; }
+		nvrhi::StagingTextureHandle createStagingTexture(const nvrhi::TextureDesc&, nvrhi::CpuAccessMode) override { return nullptr; }
+		void* mapStagingTexture(nvrhi::IStagingTexture*, const nvrhi::TextureSlice&, nvrhi::CpuAccessMode, size_t*) override { return nullptr; }
+		void unmapStagingTexture(nvrhi::IStagingTexture*) override { }
+		void getTextureTiling(nvrhi::ITexture*, uint32_t*, nvrhi::PackedMipDesc*, nvrhi::TileShape*, uint32_t*, nvrhi::SubresourceTiling*) override { }
+		void updateTextureTileMappings(nvrhi::ITexture*, const nvrhi::TextureTilesMapping*, uint32_t, nvrhi::CommandQueue) override { }
+		nvrhi::BufferHandle createBuffer(const nvrhi::BufferDesc& d) override { return nvrhi::BufferHandle::Create(new NullBuffer(d)); }
+		void* mapBuffer(nvrhi::IBuffer* buffer, nvrhi::CpuAccessMode) override { return static_cast<NullBuffer*>(buffer)->data.data(); }
+		void unmapBuffer(nvrhi::IBuffer*) override { }
+		nvrhi::MemoryRequirements getBufferMemoryRequirements(nvrhi::IBuffer*) override { return nvrhi::MemoryRequirements(); }
+		bool bindBufferMemory(nvrhi::IBuffer*, nvrhi::IHeap*, uint64_t) override { return false; }
+		nvrhi::BufferHandle createHandleForNativeBuffer(nvrhi::ObjectType, nvrhi::Object, const nvrhi::BufferDesc&) override { return nullptr; }
+		nvrhi::ShaderHandle createShader(const nvrhi::ShaderDesc&, const void*, size_t) override { return nullptr; }
+		nvrhi::ShaderHandle createShaderSpecialization(nvrhi::IShader*, const nvrhi::ShaderSpecialization*, uint32_t) override { return nullptr; }
+		nvrhi::ShaderLibraryHandle createShaderLibrary(const void*, size_t) override { return nullptr; }
+		nvrhi::SamplerHandle createSampler(const nvrhi::SamplerDesc&) override { return nullptr; }
+		nvrhi::InputLayoutHandle createInputLayout(const nvrhi::VertexAttributeDesc*, uint32_t, nvrhi::IShader*) override { return nullptr; }
+		nvrhi::EventQueryHandle createEventQuery() override { return nvrhi::EventQueryHandle::Create(new NullEventQuery()); }
+		void setEventQuery(nvrhi::IEventQuery*, nvrhi::CommandQueue) override { }
+		bool pollEventQuery(nvrhi::IEventQuery*) override { return true; }
+		void waitEventQuery(nvrhi::IEventQuery*) override { }
+		void resetEventQuery(nvrhi::IEventQuery*) override { }
+		nvrhi::TimerQueryHandle createTimerQuery() override { return nullptr; }
+		bool pollTimerQuery(nvrhi::ITimerQuery*) override { return true; }
+		float getTimerQueryTime(nvrhi::ITimerQuery*) override { return 0.f; }
+		void resetTimerQuery(nvrhi::ITimerQuery*) override { }
+		nvrhi::GraphicsAPI getGraphicsAPI() override { return nvrhi::GraphicsAPI::VULKAN; }
+		nvrhi::FramebufferHandle createFramebuffer(const nvrhi::FramebufferDesc&) override { return nullptr; }
+		nvrhi::GraphicsPipelineHandle createGraphicsPipeline(const nvrhi::GraphicsPipelineDesc&, nvrhi::IFramebuffer*) override { return nullptr; }
+		nvrhi::ComputePipelineHandle createComputePipeline(const nvrhi::ComputePipelineDesc&) override { return nullptr; }
+		nvrhi::MeshletPipelineHandle createMeshletPipeline(const nvrhi::MeshletPipelineDesc&, nvrhi::IFramebuffer*) override { return nullptr; }
+		nvrhi::rt::PipelineHandle createRayTracingPipeline(const nvrhi::rt::PipelineDesc&) override { return nullptr; }
+		nvrhi::BindingLayoutHandle createBindingLayout(const nvrhi::BindingLayoutDesc& d) override { return nvrhi::BindingLayoutHandle::Create(new NullBindingLayout(d)); }
+		nvrhi::BindingLayoutHandle createBindlessLayout(const nvrhi::BindlessLayoutDesc&) override { return nullptr; }
+		nvrhi::BindingSetHandle createBindingSet(const nvrhi::BindingSetDesc& d, nvrhi::IBindingLayout* layout) override { return nvrhi::BindingSetHandle::Create(new NullBindingSet(d, layout)); }
+		nvrhi::DescriptorTableHandle createDescriptorTable(nvrhi::IBindingLayout*) override { return nullptr; }
+		void resizeDescriptorTable(nvrhi::IDescriptorTable*, uint32_t, bool) override { }
+		bool writeDescriptorTable(nvrhi::IDescriptorTable*, const nvrhi::BindingSetItem&) override { return false; }
+		nvrhi::rt::OpacityMicromapHandle createOpacityMicromap(const nvrhi::rt::OpacityMicromapDesc&) override { return nullptr; }
+		nvrhi::rt::AccelStructHandle createAccelStruct(const nvrhi::rt::AccelStructDesc&) override { return nullptr; }
+		nvrhi::MemoryRequirements getAccelStructMemoryRequirements(nvrhi::rt::IAccelStruct*) override { return nvrhi::MemoryRequirements(); }
+		bool bindAccelStructMemory(nvrhi::rt::IAccelStruct*, nvrhi::IHeap*, uint64_t) override { return false; }
+
+		nvrhi::CommandListHandle createCommandList(const nvrhi::CommandListParameters& params) override
+		{
+			return nvrhi::CommandListHandle::Create(new NullCommandList(this, params));
+		}
+
+		uint64_t executeCommandLists(nvrhi::ICommandList* const*, size_t, nvrhi::CommandQueue) override { return ++m_LastInstance; }
+		void queueWaitForCommandList(nvrhi::CommandQueue, nvrhi::CommandQueue, uint64_t) override { }
+		bool waitForIdle() override { return true; }
+		void runGarbageCollection() override { }
+		bool queryFeatureSupport(nvrhi::Feature feature, void*, size_t) override
+		{
+			return std::find(supportedFeatures.begin(), supportedFeatures.end(), feature) != supportedFeatures.end();
+		}
+
+		nvrhi::FormatSupport queryFormatSupport(nvrhi::Format) override { return nvrhi::FormatSupport::None; }
+		nvrhi::Object getNativeQueue(nvrhi::ObjectType, nvrhi::CommandQueue) override { return nullptr; }
+		nvrhi::IMessageCallback* getMessageCallback() override { return nullptr; }
+		bool isAftermathEnabled() override { return false; }
+		nvrhi::AftermathCrashDumpHelper& getAftermathCrashDumpHelper() override { std::abort(); }
+
+	private:
+		uint64_t m_LastInstance = 0;
+	};
+}
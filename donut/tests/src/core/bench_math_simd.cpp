@@ -0,0 +1,209 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Compares the SIMD implementations of the hottest donut::math operations with the scalar
+// reference templates they replace, and checks that both produce the same results.
+// This is a benchmark, not a test: it is built with the tests but not registered with CTest.
+// Usage: bench_math_simd [batch size] [iterations]
+
+#include <donut/core/math/math.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace donut::math;
+
+static double MeasureMilliseconds(int iterations, const std::function<void()>& func)
+{
+	func(); // warm up
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+		func();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count() / double(iterations);
+}
+
+// Largest difference between two objects made of consecutive T elements,
+// relative to the largest element of the reference object
+template <typename T, typename Object>
+static double MaxDifference(const Object& a, const Object& reference)
+{
+	const T* pa = reinterpret_cast<const T*>(&a);
+	const T* pb = reinterpret_cast<const T*>(&reference);
+	const size_t count = sizeof(Object) / sizeof(T);
+
+	double magnitude = 1.0;
+	for (size_t i = 0; i < count; i++)
+		magnitude = std::max(magnitude, std::abs(double(pb[i])));
+
+	double result = 0.0;
+	for (size_t i = 0; i < count; i++)
+		result = std::max(result, std::abs(double(pa[i]) - double(pb[i])) / magnitude);
+	return result;
+}
+
+static bool g_Failed = false;
+
+// Runs both implementations over the inputs, prints their timings in nanoseconds per operation,
+// and reports an error if the results differ by more than the tolerance.
+template <typename T, typename Input, typename ScalarFunc, typename SimdFunc>
+static void Compare(const char* name, int iterations, const std::vector<Input>& inputs, double tolerance,
+	ScalarFunc scalarFunc, SimdFunc simdFunc)
+{
+	typedef decltype(scalarFunc(inputs[0])) Output;
+	std::vector<Output> scalarResults(inputs.size());
+	std::vector<Output> simdResults(inputs.size());
+
+	double scalarTime = MeasureMilliseconds(iterations, [&]() {
+		for (size_t i = 0; i < inputs.size(); i++)
+			scalarResults[i] = scalarFunc(inputs[i]); });
+
+	double simdTime = MeasureMilliseconds(iterations, [&]() {
+		for (size_t i = 0; i < inputs.size(); i++)
+			simdResults[i] = simdFunc(inputs[i]); });
+
+	double difference = 0.0;
+	for (size_t i = 0; i < inputs.size(); i++)
+		difference = std::max(difference, MaxDifference<T>(simdResults[i], scalarResults[i]));
+
+	const double toNanoseconds = 1e6 / double(inputs.size());
+	printf("  %-28s scalar %7.2f ns, simd %7.2f ns, speedup %5.2fx, max difference %.3g%s\n",
+		name, scalarTime * toNanoseconds, simdTime * toNanoseconds, scalarTime / simdTime, difference,
+		difference > tolerance ? "  MISMATCH" : "");
+
+	if (difference > tolerance)
+		g_Failed = true;
+}
+
+template <typename T>
+struct Inputs
+{
+	std::vector<std::pair<affine<T, 3>, affine<T, 3>>> affinePairs;
+	std::vector<std::pair<matrix<T, 4, 4>, matrix<T, 4, 4>>> matrixPairs;
+	std::vector<matrix<T, 4, 4>> matrices;
+	std::vector<std::pair<box<T, 3>, affine<T, 3>>> boxes;
+
+	Inputs(size_t count)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+		auto next = [&]() { return T(distribution(random)); };
+
+		auto randomAffine = [&]()
+		{
+			affine<T, 3> result;
+			T* data = reinterpret_cast<T*>(&result);
+			for (int i = 0; i < 12; i++)
+				data[i] = next() * (i < 9 ? T(2) : T(100));
+			return result;
+		};
+
+		auto randomMatrix = [&]()
+		{
+			matrix<T, 4, 4> result;
+			for (int i = 0; i < 16; i++)
+				result.m_data[i] = next() * T(4);
+			return result;
+		};
+
+		// Well conditioned matrices, like the transforms that are inverted in practice
+		auto randomInvertibleMatrix = [&]()
+		{
+			matrix<T, 4, 4> result = randomMatrix();
+			for (int i = 0; i < 4; i++)
+				result[i][i] += result[i][i] < T(0) ? T(-8) : T(8);
+			return result;
+		};
+
+		for (size_t i = 0; i < count; i++)
+		{
+			affinePairs.push_back({ randomAffine(), randomAffine() });
+			matrixPairs.push_back({ randomMatrix(), randomMatrix() });
+			matrices.push_back(randomInvertibleMatrix());
+
+			vector<T, 3> a(next(), next(), next()), b(next(), next(), next());
+			boxes.push_back({ box<T, 3>(min(a, b) * T(10), max(a, b) * T(10)), randomAffine() });
+		}
+	}
+};
+
+template <typename T>
+static void RunBenchmarks(const char* typeName, size_t count, int iterations)
+{
+	typedef std::pair<affine<T, 3>, affine<T, 3>> AffinePair;
+	typedef std::pair<matrix<T, 4, 4>, matrix<T, 4, 4>> MatrixPair;
+	typedef std::pair<box<T, 3>, affine<T, 3>> BoxTransform;
+
+	Inputs<T> inputs(count);
+
+	// Results are expected to match exactly, except when the compiler contracts the scalar code into FMAs.
+	// The inverse uses a different algorithm, and the scalar one treats elements below epsilon as zeros,
+	// so their results are only expected to be close.
+	const double tolerance = std::is_same_v<T, float> ? 1e-5 : 1e-12;
+	const double inverseTolerance = 1e-5;
+
+	printf("%s, %zu operations per batch, average of %d batches:\n", typeName, count, iterations);
+
+	Compare<T>("affine3 * affine3", iterations, inputs.affinePairs, tolerance,
+		[](const AffinePair& p) { return scalar::multiply(p.first, p.second); },
+		[](const AffinePair& p) { return p.first * p.second; });
+
+	Compare<T>("4x4 * 4x4", iterations, inputs.matrixPairs, tolerance,
+		[](const MatrixPair& p) { return scalar::multiply(p.first, p.second); },
+		[](const MatrixPair& p) { return p.first * p.second; });
+
+	Compare<T>("inverse(4x4)", iterations, inputs.matrices, inverseTolerance,
+		[](const matrix<T, 4, 4>& m) { return scalar::inverse(m); },
+		[](const matrix<T, 4, 4>& m) { return inverse(m); });
+
+	Compare<T>("box3 * affine3", iterations, inputs.boxes, tolerance,
+		[](const BoxTransform& p) { return scalar::transform(p.first, p.second); },
+		[](const BoxTransform& p) { return p.first * p.second; });
+
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? size_t(atoi(argv[1])) : 4096;
+	int iterations = argc > 2 ? atoi(argv[2]) : 100;
+
+	printf("donut::math SIMD backend: %s\n", simd::BackendName);
+
+	RunBenchmarks<float>("float", count, iterations);
+	RunBenchmarks<double>("double", count, iterations);
+
+	if (g_Failed)
+	{
+		fprintf(stderr, "The SIMD results don't match the scalar implementation.\n");
+		return 1;
+	}
+
+	return 0;
+}
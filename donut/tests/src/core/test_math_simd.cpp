@@ -0,0 +1,240 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/core/math/math.h>
+
+#include <donut/tests/utils.h>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace donut::math;
+
+// The SIMD overloads are checked against the scalar templates in dm::scalar that they replace.
+// When the SIMD backend is disabled, both sides are the same code and the test is trivial.
+
+// Largest difference between two objects made of consecutive T elements,
+// relative to the largest element of the reference object
+template <typename T, typename Object>
+static double MaxDifference(const Object& a, const Object& reference)
+{
+	const T* pa = reinterpret_cast<const T*>(&a);
+	const T* pb = reinterpret_cast<const T*>(&reference);
+	const size_t count = sizeof(Object) / sizeof(T);
+
+	double magnitude = 1.0;
+	for (size_t i = 0; i < count; i++)
+		magnitude = std::max(magnitude, std::abs(double(pb[i])));
+
+	double result = 0.0;
+	for (size_t i = 0; i < count; i++)
+		result = std::max(result, std::abs(double(pa[i]) - double(pb[i])) / magnitude);
+	return result;
+}
+
+template <typename T>
+static bool IsNaN(const matrix<T, 4, 4>& m)
+{
+	for (int i = 0; i < 16; i++)
+		if (std::isnan(m.m_data[i]))
+			return true;
+	return false;
+}
+
+template <typename T>
+static bool IsIdentical(const matrix<T, 4, 4>& a, const matrix<T, 4, 4>& b)
+{
+	// Bitwise, so that NaNs compare equal
+	return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+template <typename T>
+struct RandomInputs
+{
+	std::mt19937 random{ 1 };
+	std::uniform_real_distribution<double> distribution{ -1.0, 1.0 };
+
+	T next() { return T(distribution(random)); }
+
+	affine<T, 3> nextAffine()
+	{
+		affine<T, 3> result;
+		T* data = reinterpret_cast<T*>(&result);
+		for (int i = 0; i < 12; i++)
+			data[i] = next() * (i < 9 ? T(2) : T(100));
+		return result;
+	}
+
+	matrix<T, 4, 4> nextMatrix()
+	{
+		matrix<T, 4, 4> result;
+		for (int i = 0; i < 16; i++)
+			result.m_data[i] = next() * T(4);
+		return result;
+	}
+
+	box<T, 3> nextBox()
+	{
+		vector<T, 3> a(next(), next(), next()), b(next(), next(), next());
+		return box<T, 3>(min(a, b) * T(10), max(a, b) * T(10));
+	}
+};
+
+template <typename T>
+static double Tolerance()
+{
+	// Results are expected to match exactly, except when the compiler contracts the scalar code into FMAs
+	return std::is_same_v<T, float> ? 1e-5 : 1e-12;
+}
+
+template <typename T>
+void test_products_and_box_transform()
+{
+	RandomInputs<T> inputs;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		affine<T, 3> a = inputs.nextAffine();
+		affine<T, 3> b = inputs.nextAffine();
+		CHECK(MaxDifference<T>(a * b, scalar::multiply(a, b)) <= Tolerance<T>());
+
+		matrix<T, 4, 4> c = inputs.nextMatrix();
+		matrix<T, 4, 4> d = inputs.nextMatrix();
+		CHECK(MaxDifference<T>(c * d, scalar::multiply(c, d)) <= Tolerance<T>());
+
+		box<T, 3> e = inputs.nextBox();
+		CHECK(MaxDifference<T>(e * a, scalar::transform(e, a)) <= Tolerance<T>());
+	}
+
+	// Empty boxes overflow to infinities, check that both implementations agree on the result
+	affine<T, 3> transform = inputs.nextAffine();
+	box<T, 3> empty = box<T, 3>::empty();
+	CHECK((empty * transform).isempty() == scalar::transform(empty, transform).isempty());
+}
+
+template <typename T>
+void test_inverse()
+{
+	RandomInputs<T> inputs;
+
+	// Arbitrary matrices: the adjugate and Gaussian elimination give close results,
+	// and the ones that are too ill-conditioned for the adjugate take the scalar path.
+	// The inverse is a different algorithm, so it's compared with a looser tolerance.
+	const double inverseTolerance = 1e-4;
+	for (int i = 0; i < 1000; i++)
+	{
+		matrix<T, 4, 4> m = inputs.nextMatrix();
+		matrix<T, 4, 4> simdInverse = inverse(m);
+		matrix<T, 4, 4> scalarInverse = scalar::inverse(m);
+		CHECK(IsNaN(simdInverse) == IsNaN(scalarInverse));
+		if (!IsNaN(scalarInverse))
+			CHECK(MaxDifference<T>(simdInverse, scalarInverse) <= inverseTolerance);
+	}
+
+	// Typical transforms: rigid with a large translation, non-uniformly scaled, and a perspective projection
+	const affine<T, 3> rigid = rotation(normalize(vector<T, 3>(T(1), T(2), T(3))), T(0.7)) * translation(vector<T, 3>(T(1000), T(-250), T(40)));
+	const affine<T, 3> scaled = scaling(vector<T, 3>(T(0.01), T(5), T(200))) * rigid;
+	const matrix<T, 4, 4> projection(
+		T(1.2), T(0), T(0), T(0),
+		T(0), T(2.1), T(0), T(0),
+		T(0), T(0), T(0), T(1),
+		T(0), T(0), T(0.1), T(0));
+
+	for (const matrix<T, 4, 4>& m : { affineToHomogeneous(rigid), affineToHomogeneous(scaled), projection })
+	{
+		matrix<T, 4, 4> simdInverse = inverse(m);
+		CHECK(!IsNaN(simdInverse));
+		CHECK(MaxDifference<T>(simdInverse, scalar::inverse(m)) <= inverseTolerance);
+	}
+
+	// Singular and nearly singular matrices must behave exactly like the scalar implementation,
+	// including the NaNs it returns when elimination reaches a pivot below epsilon
+	std::vector<matrix<T, 4, 4>> singular;
+
+	singular.push_back(matrix<T, 4, 4>::zero());
+
+	for (int row = 0; row < 4; row++)
+	{
+		matrix<T, 4, 4> m = inputs.nextMatrix();
+		m[row] = vector<T, 4>::zero();
+		singular.push_back(m);
+	}
+
+	for (int i = 0; i < 100; i++)
+	{
+		// Duplicate row, row that's a combination of two others, and a rank 1 matrix,
+		// at scales where rounding noise makes the computed determinant exceed epsilon
+		const T scale = T(1) + T(i);
+
+		matrix<T, 4, 4> m = inputs.nextMatrix() * scale;
+		m[3] = m[1];
+		singular.push_back(m);
+
+		m = inputs.nextMatrix() * scale;
+		m[2] = m[0] * T(0.3) + m[1] * T(1.7);
+		singular.push_back(m);
+
+		vector<T, 4> u(inputs.next(), inputs.next(), inputs.next(), inputs.next());
+		vector<T, 4> v(inputs.next(), inputs.next(), inputs.next(), inputs.next());
+		m = matrix<T, 4, 4>::zero();
+		for (int row = 0; row < 4; row++)
+			m[row] = v * u[row] * scale;
+		singular.push_back(m);
+	}
+
+	// Tiny scales: with one element below epsilon the scalar code returns NaNs even though the
+	// determinant is large, and with a uniformly small scale it doesn't although the determinant is tiny
+	singular.push_back(diagonal(vector<T, 4>(T(1e-7), T(1e3), T(1e3), T(1e3))));
+	singular.push_back(diagonal(vector<T, 4>(T(2e-6), T(1), T(1), T(1))));
+	singular.push_back(diagonal(vector<T, 4>(T(0.01))));
+	singular.push_back(affineToHomogeneous(scaling(vector<T, 3>(T(1e-7), T(1), T(1)))));
+
+	// Nearly singular: a singular matrix with a small perturbation
+	for (int i = 0; i < 100; i++)
+	{
+		matrix<T, 4, 4> m = inputs.nextMatrix();
+		m[3] = m[0] + m[1] + vector<T, 4>(inputs.next(), inputs.next(), inputs.next(), inputs.next()) * T(1e-4);
+		singular.push_back(m);
+	}
+
+	for (const matrix<T, 4, 4>& m : singular)
+		CHECK(IsIdentical(inverse(m), scalar::inverse(m)));
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_products_and_box_transform<float>();
+		test_products_and_box_transform<double>();
+		test_inverse<float>();
+		test_inverse<double>();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
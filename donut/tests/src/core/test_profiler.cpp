@@ -0,0 +1,136 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/core/profiler.h>
+#include <donut/tests/utils.h>
+
+#include <cstring>
+#include <thread>
+
+using namespace donut;
+
+static const profiler::ThreadEvents* FindThread(const std::vector<profiler::ThreadEvents>& threads, const char* name)
+{
+	for (const auto& thread : threads)
+	{
+		if (thread.threadName == name)
+			return &thread;
+	}
+	return nullptr;
+}
+
+void test_nested_scopes()
+{
+	profiler::SetThreadName("main");
+	profiler::Clear();
+
+	{
+		profiler::ScopedEvent outer("Outer");
+		{
+			profiler::ScopedEvent inner("Inner");
+		}
+	}
+
+	std::vector<profiler::ThreadEvents> threads;
+	profiler::CollectEvents(threads);
+
+	const profiler::ThreadEvents* thread = FindThread(threads, "main");
+	CHECK(thread != nullptr);
+	CHECK(thread->events.size() == 2);
+
+	// Scopes are recorded when they end, so the inner one comes first
+	const profiler::Event& inner = thread->events[0];
+	const profiler::Event& outer = thread->events[1];
+	CHECK(strcmp(inner.name, "Inner") == 0);
+	CHECK(strcmp(outer.name, "Outer") == 0);
+	CHECK(inner.depth == 1);
+	CHECK(outer.depth == 0);
+	CHECK(outer.startNs <= inner.startNs);
+	CHECK(inner.endNs <= outer.endNs);
+}
+
+void test_disabled()
+{
+	profiler::Clear();
+	profiler::SetEnabled(false);
+	{
+		profiler::ScopedEvent scope("Disabled");
+	}
+	profiler::SetEnabled(true);
+
+	std::vector<profiler::ThreadEvents> threads;
+	profiler::CollectEvents(threads);
+	CHECK(FindThread(threads, "main")->events.empty());
+}
+
+void test_ring_wraparound()
+{
+	profiler::SetEventsPerThread(16);
+
+	std::thread worker([]()
+	{
+		profiler::SetThreadName("worker");
+		for (uint64_t i = 0; i < 40; i++)
+			profiler::RecordEvent("Event", i, i + 1, 0);
+	});
+	worker.join();
+
+	std::vector<profiler::ThreadEvents> threads;
+	profiler::CollectEvents(threads);
+
+	// Only the most recent events survive, oldest first
+	const profiler::ThreadEvents* thread = FindThread(threads, "worker");
+	CHECK(thread != nullptr);
+	CHECK(thread->events.size() == 15);
+	CHECK(thread->events.front().startNs == 25);
+	CHECK(thread->events.back().startNs == 39);
+	CHECK(thread->threadId != FindThread(threads, "main")->threadId);
+}
+
+void test_chrome_trace()
+{
+	profiler::Clear();
+	profiler::RecordEvent("Quoted \"name\"", 1000, 3500, 0);
+
+	std::string trace = profiler::GetChromeTrace();
+	CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+	CHECK(trace.find("\"name\":\"Quoted \\\"name\\\"\"") != std::string::npos);
+	CHECK(trace.find("\"ts\":1.000,\"dur\":2.500") != std::string::npos);
+	CHECK(trace.find("\"args\":{\"name\":\"worker\"}") != std::string::npos);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_nested_scopes();
+		test_disabled();
+		test_ring_wraparound();
+		test_chrome_trace();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Compares the CPU mip chain generator with stb_image_resize2 building the same chain level by level.
+// This is a benchmark, not a test: it is built with the tests but not registered with CTest.
+// Usage: bench_mip_generator [image size] [iterations]
+
+#include <donut/engine/MipGenerator.h>
+
+#ifdef DONUT_WITH_TASKFLOW
+#include <taskflow/taskflow.hpp>
+#endif
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize2.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+using namespace donut::engine;
+
+static double MeasureMilliseconds(int iterations, const std::function<void()>& func)
+{
+	func(); // warm up
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+		func();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count() / double(iterations);
+}
+
+static void BuildChainWithStb(const std::vector<uint8_t>& image, uint32_t size, bool hdr, std::vector<uint8_t>& data)
+{
+	const size_t bytesPerPixel = hdr ? 16 : 4;
+	uint32_t levels = MipGenerator::GetFullMipChainLength(size, size);
+
+	size_t totalSize = 0;
+	for (uint32_t mip = 0; mip < levels; mip++)
+		totalSize += size_t(size >> mip) * (size >> mip) * bytesPerPixel;
+	data.resize(totalSize);
+
+	memcpy(data.data(), image.data(), image.size());
+
+	size_t srcOffset = 0;
+	size_t dstOffset = image.size();
+	for (uint32_t mip = 1; mip < levels; mip++)
+	{
+		int srcSize = int(size >> (mip - 1));
+		int dstSize = int(size >> mip);
+
+		stbir_resize(data.data() + srcOffset, srcSize, srcSize, int(srcSize * bytesPerPixel),
+			data.data() + dstOffset, dstSize, dstSize, int(dstSize * bytesPerPixel),
+			STBIR_RGBA_NO_AW, hdr ? STBIR_TYPE_FLOAT : STBIR_TYPE_UINT8_SRGB, STBIR_EDGE_CLAMP, STBIR_FILTER_BOX);
+
+		srcOffset = dstOffset;
+		dstOffset += size_t(dstSize) * dstSize * bytesPerPixel;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t size = argc > 1 ? uint32_t(atoi(argv[1])) : 2048;
+	int iterations = argc > 2 ? atoi(argv[2]) : 5;
+
+	std::vector<uint8_t> image8(size_t(size) * size * 4);
+	for (size_t i = 0; i < image8.size(); i++)
+		image8[i] = uint8_t((i * 7919) >> 5);
+
+	std::vector<uint8_t> imageF(size_t(size) * size * 16);
+	float* floats = reinterpret_cast<float*>(imageF.data());
+	for (size_t i = 0; i < imageF.size() / 4; i++)
+		floats[i] = float((i * 7919) & 0xffff) / 1024.f;
+
+	std::vector<uint8_t> data;
+	std::vector<MipLevelLayout> layout;
+
+	MipGenerationParams params;
+	params.sRGB = true;
+
+	printf("Full mip chain of a %ux%u RGBA image, average of %d iterations:\n", size, size, iterations);
+
+	printf("  sRGB8 box,   stb_image_resize2:  %8.2f ms\n", MeasureMilliseconds(iterations, [&]() {
+		BuildChainWithStb(image8, size, false, data); }));
+
+	printf("  sRGB8 box,   MipGenerator:       %8.2f ms\n", MeasureMilliseconds(iterations, [&]() {
+		MipGenerator::GenerateMipChain(image8.data(), size, size, size * 4, nvrhi::Format::RGBA8_UNORM, params, data, layout); }));
+
+	params.filter = MipFilter::Kaiser;
+	printf("  sRGB8 Kaiser, MipGenerator:      %8.2f ms\n", MeasureMilliseconds(iterations, [&]() {
+		MipGenerator::GenerateMipChain(image8.data(), size, size, size * 4, nvrhi::Format::RGBA8_UNORM, params, data, layout); }));
+	params.filter = MipFilter::Box;
+
+	printf("  RGBA32F box, stb_image_resize2:  %8.2f ms\n", MeasureMilliseconds(iterations, [&]() {
+		BuildChainWithStb(imageF, size, true, data); }));
+
+	printf("  RGBA32F box, MipGenerator:       %8.2f ms\n", MeasureMilliseconds(iterations, [&]() {
+		MipGenerator::GenerateMipChain(imageF.data(), size, size, size * 16, nvrhi::Format::RGBA32_FLOAT, params, data, layout); }));
+
+#ifdef DONUT_WITH_TASKFLOW
+	tf::Executor executor;
+	params.executor = &executor;
+
+	printf("  sRGB8 box,   MipGenerator, %2zu threads: %8.2f ms\n", executor.num_workers(), MeasureMilliseconds(iterations, [&]() {
+		MipGenerator::GenerateMipChain(image8.data(), size, size, size * 4, nvrhi::Format::RGBA8_UNORM, params, data, layout); }));
+
+	printf("  RGBA32F box, MipGenerator, %2zu threads: %8.2f ms\n", executor.num_workers(), MeasureMilliseconds(iterations, [&]() {
+		MipGenerator::GenerateMipChain(imageF.data(), size, size, size * 16, nvrhi::Format::RGBA32_FLOAT, params, data, layout); }));
+#endif
+
+	return 0;
+}
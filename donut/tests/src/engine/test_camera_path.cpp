@@ -0,0 +1,124 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <donut/engine/CameraPath.h>
+#include <donut/core/vfs/VFS.h>
+#include <donut/tests/utils.h>
+
+#include <cmath>
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+static bool Near(float3 a, float3 b)
+{
+	return length(a - b) < 1e-5f;
+}
+
+void test_sampling()
+{
+	CameraPath path;
+	CHECK(path.IsEmpty());
+	CHECK(path.GetDuration() == 0.f);
+
+	CameraPath::Keyframe a;
+	a.time = 0.f;
+	a.position = float3(0.f, 0.f, 0.f);
+	a.direction = float3(1.f, 0.f, 0.f);
+	path.AddKeyframe(a);
+
+	CameraPath::Keyframe b;
+	b.time = 2.f;
+	b.position = float3(4.f, 2.f, 0.f);
+	b.direction = float3(0.f, 0.f, 1.f);
+	path.AddKeyframe(b);
+
+	CHECK(path.GetDuration() == 2.f);
+
+	CameraPath::Keyframe mid = path.Sample(1.f);
+	CHECK(Near(mid.position, float3(2.f, 1.f, 0.f)));
+	CHECK(Near(mid.direction, normalize(float3(1.f, 0.f, 1.f))));
+	CHECK(Near(mid.up, float3(0.f, 1.f, 0.f)));
+
+	// Clamped at both ends
+	CHECK(Near(path.Sample(-1.f).position, a.position));
+	CHECK(Near(path.Sample(10.f).position, b.position));
+
+	// A keyframe that is not later than the last one replaces it
+	b.position = float3(8.f, 0.f, 0.f);
+	path.AddKeyframe(b);
+	CHECK(path.GetKeyframes().size() == 2);
+	CHECK(Near(path.Sample(2.f).position, float3(8.f, 0.f, 0.f)));
+}
+
+void test_save_load()
+{
+	CameraPath path;
+	for (int i = 0; i < 100; i++)
+	{
+		CameraPath::Keyframe keyframe;
+		keyframe.time = float(i) / 60.f;
+		keyframe.position = float3(std::sin(float(i) * 0.1f), 1.7f, float(i) * 0.3f);
+		keyframe.direction = normalize(float3(std::cos(float(i) * 0.05f), -0.1f, 1.f));
+		path.AddKeyframe(keyframe);
+	}
+
+	std::filesystem::path fileName = std::filesystem::temp_directory_path() / "donut_test_camera_path.json";
+	CHECK(path.Save(fileName));
+
+	vfs::NativeFileSystem fs;
+	CameraPath loaded;
+	CHECK(loaded.Load(fs, fileName));
+	std::filesystem::remove(fileName);
+
+	// Playback of the loaded path is bit-exact, so that benchmark runs see identical frames
+	CHECK(loaded.GetKeyframes().size() == path.GetKeyframes().size());
+	for (int frame = 0; frame < 120; frame++)
+	{
+		float time = float(frame) * (1.f / 72.f);
+		CameraPath::Keyframe original = path.Sample(time);
+		CameraPath::Keyframe replayed = loaded.Sample(time);
+		CHECK(all(original.position == replayed.position));
+		CHECK(all(original.direction == replayed.direction));
+		CHECK(all(original.up == replayed.up));
+	}
+
+	CHECK(!loaded.Load(fs, fileName));
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_sampling();
+		test_save_load();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
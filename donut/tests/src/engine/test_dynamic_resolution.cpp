@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <donut/engine/DynamicResolution.h>
+#include <donut/tests/utils.h>
+
+#include <cmath>
+#include <cstdio>
+#include <deque>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+// Simulates a GPU whose frame time is proportional to the rendered area plus a fixed cost,
+// with the measurements arriving 'latency' frames late like they do from GpuProfiler.
+struct SimulatedGpu
+{
+	float fullResolutionMs;
+	float fixedMs;
+	int2 maxSize;
+	std::deque<float> inFlight;
+	uint32_t latency = 3;
+
+	float Render(int2 size)
+	{
+		float area = float(size.x * size.y) / float(maxSize.x * maxSize.y);
+		inFlight.push_back(fixedMs + fullResolutionMs * area);
+		if (inFlight.size() <= latency)
+			return 0.f; // no measurement yet
+		float measured = inFlight.front();
+		inFlight.pop_front();
+		return measured;
+	}
+};
+
+static float RunSimulation(DynamicResolutionController& controller, SimulatedGpu& gpu, int frames, int2* outSize = nullptr, int* outChanges = nullptr, int changesFromFrame = 0)
+{
+	int2 size = controller.GetRenderSize();
+	float lastMs = 0.f;
+	int changes = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		lastMs = gpu.Render(size);
+		int2 newSize = controller.Update(lastMs);
+		if (frame >= changesFromFrame && any(newSize != size))
+			++changes;
+		size = newSize;
+	}
+	if (outSize)
+		*outSize = size;
+	if (outChanges)
+		*outChanges = changes;
+	return lastMs;
+}
+
+void test_bounds()
+{
+	DynamicResolutionController controller;
+	controller.SetBounds(int2(960, 540), int2(1920, 1080));
+
+	CHECK(controller.GetMinScale() == 0.5f);
+	CHECK(all(controller.GetRenderSize() == int2(1920, 1080)));
+
+	controller.Reset(0.1f);
+	CHECK(all(controller.GetRenderSize() == int2(960, 540)));
+
+	// Invalid measurements don't change anything
+	controller.Reset(0.75f);
+	CHECK(all(controller.Update(0.f) == int2(1440, 810)));
+	CHECK(all(controller.Update(-1.f) == int2(1440, 810)));
+}
+
+void test_convergence()
+{
+	DynamicResolutionController controller;
+	controller.SetBounds(int2(640, 360), int2(1920, 1080));
+
+	DynamicResolutionController::Parameters params;
+	params.targetFrameTimeMs = 10.f;
+	controller.SetParameters(params);
+
+	// 20 ms at full resolution: the target is reached at about 45% of the area
+	SimulatedGpu gpu{ 18.f, 2.f, int2(1920, 1080) };
+
+	int2 size;
+	int changes = 0;
+	float ms = RunSimulation(controller, gpu, 300, &size, &changes, 200);
+
+	CHECK(std::abs(ms - params.targetFrameTimeMs) <= params.targetFrameTimeMs * params.deadBand * 1.5f);
+	CHECK(size.x < 1920 && size.x > 640);
+
+	// The dead band keeps the size stable once converged
+	CHECK(changes == 0);
+
+	// The load drops: the resolution goes back up
+	gpu.fullResolutionMs = 6.f;
+	RunSimulation(controller, gpu, 300, &size);
+	CHECK(all(size == int2(1920, 1080)));
+}
+
+void test_saturation()
+{
+	DynamicResolutionController controller;
+	controller.SetBounds(int2(960, 540), int2(1920, 1080));
+
+	DynamicResolutionController::Parameters params;
+	params.targetFrameTimeMs = 5.f;
+	controller.SetParameters(params);
+
+	// Can't reach the target even at the minimum size
+	SimulatedGpu gpu{ 40.f, 2.f, int2(1920, 1080) };
+
+	int2 size;
+	RunSimulation(controller, gpu, 200, &size);
+	CHECK(all(size == int2(960, 540)));
+	CHECK(controller.GetScale() == controller.GetMinScale());
+}
+
+void test_step_limit()
+{
+	DynamicResolutionController controller;
+	controller.SetBounds(int2(100, 100), int2(1000, 1000));
+
+	DynamicResolutionController::Parameters params;
+	params.targetFrameTimeMs = 10.f;
+	params.maxScaleStep = 0.1f;
+	params.settleFrames = 0;
+	controller.SetParameters(params);
+
+	// A 10x overload only reduces the scale by the maximum step
+	controller.Update(100.f);
+	CHECK(std::abs(controller.GetScale() - 1.f / 1.1f) < 1e-4f);
+}
+
+void test_replay()
+{
+	DynamicResolutionController::Parameters params;
+	params.targetFrameTimeMs = 10.f;
+
+	DynamicResolutionController recorder;
+	recorder.SetBounds(int2(640, 360), int2(1920, 1080));
+	recorder.SetParameters(params);
+	recorder.SetRecording(true);
+
+	SimulatedGpu gpu{ 18.f, 2.f, int2(1920, 1080) };
+
+	std::vector<int2> recordedSizes;
+	int2 size = recorder.GetRenderSize();
+	for (int frame = 0; frame < 100; frame++)
+	{
+		size = recorder.Update(gpu.Render(size));
+		recordedSizes.push_back(size);
+	}
+
+	CHECK(recorder.GetRecordedFrameTimes().size() == 100);
+
+	// Replaying the recorded frame times ignores the live input and reproduces the same sizes
+	DynamicResolutionController player;
+	player.SetBounds(int2(640, 360), int2(1920, 1080));
+	player.SetParameters(params);
+	player.SetReplay(recorder.GetRecordedFrameTimes());
+	CHECK(player.IsReplaying());
+
+	for (int frame = 0; frame < 100; frame++)
+	{
+		int2 replayedSize = player.Update(1000.f);
+		CHECK(all(replayedSize == recordedSizes[frame]));
+	}
+
+	// Through a file as well
+	std::filesystem::path fileName = std::filesystem::temp_directory_path() / "donut_test_dynamic_resolution.txt";
+	CHECK(recorder.SaveRecording(fileName));
+
+	DynamicResolutionController filePlayer;
+	filePlayer.SetBounds(int2(640, 360), int2(1920, 1080));
+	filePlayer.SetParameters(params);
+	CHECK(filePlayer.LoadReplay(fileName));
+	std::filesystem::remove(fileName);
+
+	for (int frame = 0; frame < 100; frame++)
+	{
+		int2 replayedSize = filePlayer.Update(0.f);
+		CHECK(all(replayedSize == recordedSizes[frame]));
+	}
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_bounds();
+		test_convergence();
+		test_saturation();
+		test_step_limit();
+		test_replay();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/FrameStatistics.h>
+#include <donut/core/json.h>
+#include <donut/core/vfs/VFS.h>
+#include <donut/tests/utils.h>
+
+#include <cmath>
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::engine;
+
+void test_bucket_layout()
+{
+	// Exact below the sub-bucket count
+	for (uint64_t value = 0; value < LatencyHistogram::SubBucketCount; value++)
+	{
+		CHECK(LatencyHistogram::GetBucketIndex(value) == value);
+		CHECK(LatencyHistogram::GetBucketLowerBound(uint32_t(value)) == value);
+	}
+
+	// Buckets are contiguous and every value falls into its bucket
+	for (uint32_t index = 0; index + 1 < LatencyHistogram::BucketCount; index++)
+	{
+		uint64_t lower = LatencyHistogram::GetBucketLowerBound(index);
+		uint64_t upper = LatencyHistogram::GetBucketUpperBound(index);
+		CHECK(upper > lower);
+		CHECK(LatencyHistogram::GetBucketLowerBound(index + 1) == upper);
+		CHECK(LatencyHistogram::GetBucketIndex(lower) == index);
+		CHECK(LatencyHistogram::GetBucketIndex(upper - 1) == index);
+	}
+
+	CHECK(LatencyHistogram::GetBucketIndex(~0ull) == LatencyHistogram::BucketCount - 1);
+
+	// Relative bucket width stays within 1/64
+	for (uint64_t value : { 1000ull, 16667ull, 33333ull, 1000000ull })
+	{
+		uint32_t index = LatencyHistogram::GetBucketIndex(value);
+		uint64_t width = LatencyHistogram::GetBucketUpperBound(index) - LatencyHistogram::GetBucketLowerBound(index);
+		CHECK(double(width) / double(value) <= 1.0 / 64.0);
+	}
+}
+
+void test_percentiles()
+{
+	LatencyHistogram histogram;
+	CHECK(histogram.GetValueAtPercentile(50.0) == 0);
+
+	for (uint64_t value = 1; value <= 100; value++)
+		histogram.RecordValue(value);
+
+	CHECK(histogram.GetCount() == 100);
+	CHECK(histogram.GetMin() == 1);
+	CHECK(histogram.GetMax() == 100);
+	CHECK(histogram.GetValueAtPercentile(50.0) == 50);
+	CHECK(histogram.GetValueAtPercentile(90.0) == 90);
+	CHECK(histogram.GetValueAtPercentile(99.0) == 99);
+	CHECK(histogram.GetValueAtPercentile(100.0) == 100);
+	CHECK(histogram.GetValueAtPercentile(0.0) == 1);
+
+	// One hitch in a thousand frames shows up in p99.9 only
+	LatencyHistogram frames;
+	for (int i = 0; i < 999; i++)
+		frames.RecordValue(16667);
+	frames.RecordValue(50000);
+
+	uint64_t p99 = frames.GetValueAtPercentile(99.0);
+	uint64_t p999 = frames.GetValueAtPercentile(99.9);
+	uint64_t p9999 = frames.GetValueAtPercentile(99.99);
+	CHECK(p99 >= 16667 && p99 < 16667 + 16667 / 64);
+	CHECK(p999 == p99);
+	CHECK(p9999 == 50000);
+
+	frames.Reset();
+	CHECK(frames.GetCount() == 0);
+	CHECK(frames.GetMax() == 0);
+}
+
+void test_frame_statistics()
+{
+	FrameStatistics stats;
+	FrameStatistics::ChannelId frameTime = stats.GetOrCreateChannel("FrameTime");
+	FrameStatistics::ChannelId present = stats.GetOrCreateChannel("Present");
+	CHECK(stats.GetOrCreateChannel("FrameTime") == frameTime);
+	CHECK(present != frameTime);
+
+	// Alternating 10/20 ms frames: same mean as steady 15 ms, but 10 ms pacing error
+	for (int i = 0; i < 100; i++)
+		stats.RecordValue(frameTime, (i & 1) ? 20.0 : 10.0);
+
+	FrameStatistics::Summary summary = stats.GetSummary(frameTime);
+	CHECK(summary.count == 100);
+	CHECK(std::abs(summary.meanMs - 15.0) < 1e-9);
+	CHECK(summary.minMs == 10.0);
+	CHECK(summary.maxMs == 20.0);
+	CHECK(std::abs(summary.pacingMs - 10.0) < 1e-9);
+	CHECK(std::abs(summary.stdDevMs - 5.025) < 1e-3);
+
+	CHECK(stats.GetSummary(present).count == 0);
+
+	stats.Reset();
+	CHECK(stats.GetNumChannels() == 2);
+	CHECK(stats.GetSummary(frameTime).count == 0);
+}
+
+void test_report_json()
+{
+	FrameStatistics stats;
+	FrameStatistics::ChannelId frameTime = stats.GetOrCreateChannel("FrameTime");
+	stats.GetOrCreateChannel("Empty");
+
+	for (int i = 1; i <= 100; i++)
+		stats.RecordValue(frameTime, double(i));
+
+	std::filesystem::path fileName = std::filesystem::temp_directory_path() / "donut_test_frame_statistics.json";
+	CHECK(stats.WriteReportJson(fileName, { { "scene", "test \"scene\"" } }, { { "textureMemoryBytes", 1048576.0 } }));
+
+	vfs::NativeFileSystem fs;
+	Json::Value root;
+	CHECK(json::LoadFromFile(fs, fileName, root));
+	std::filesystem::remove(fileName);
+
+	CHECK(root["info"]["scene"].asString() == "test \"scene\"");
+	CHECK(root["metrics"]["textureMemoryBytes"].asDouble() == 1048576.0);
+
+	// Empty channels are skipped
+	CHECK(root["channels"].size() == 1);
+	const Json::Value& channel = root["channels"][0];
+	CHECK(channel["name"].asString() == "FrameTime");
+	CHECK(channel["count"].asUInt64() == 100);
+	CHECK(channel["p50Ms"].asDouble() == stats.GetSummary(frameTime).p50Ms);
+	CHECK(channel["p99Ms"].asDouble() == stats.GetSummary(frameTime).p99Ms);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_bucket_layout();
+		test_percentiles();
+		test_frame_statistics();
+		test_report_json();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
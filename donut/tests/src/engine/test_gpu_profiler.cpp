@@ -0,0 +1,104 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <donut/engine/GpuProfiler.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::engine;
+
+void test_empty_window()
+{
+	TimingWindow window(8);
+	CHECK(window.GetNumSamples() == 0);
+	CHECK(window.GetMin() == 0.f);
+	CHECK(window.GetAverage() == 0.f);
+	CHECK(window.GetPercentile(99.f) == 0.f);
+}
+
+void test_window_statistics()
+{
+	TimingWindow window(100);
+	for (int i = 1; i <= 100; i++)
+		window.AddSample(float(i));
+
+	CHECK(window.GetNumSamples() == 100);
+	CHECK(window.GetLast() == 100.f);
+	CHECK(window.GetMin() == 1.f);
+	CHECK(window.GetMax() == 100.f);
+	CHECK(window.GetAverage() == 50.5f);
+	CHECK(window.GetPercentile(50.f) == 50.f);
+	CHECK(window.GetPercentile(99.f) == 99.f);
+	CHECK(window.GetPercentile(100.f) == 100.f);
+	CHECK(window.GetPercentile(0.f) == 1.f);
+
+	// A single spike is visible in p99 but barely moves the average
+	TimingWindow spiky(100);
+	for (int i = 0; i < 99; i++)
+		spiky.AddSample(1.f);
+	spiky.AddSample(20.f);
+	CHECK(spiky.GetPercentile(99.f) == 1.f);
+	CHECK(spiky.GetPercentile(99.5f) == 20.f);
+	CHECK(spiky.GetAverage() < 1.2f);
+}
+
+void test_window_rolling()
+{
+	TimingWindow window(4);
+	for (int i = 0; i < 4; i++)
+		window.AddSample(10.f);
+
+	// Old samples are replaced once the window is full
+	for (int i = 0; i < 4; i++)
+		window.AddSample(2.f);
+
+	CHECK(window.GetNumSamples() == 4);
+	CHECK(window.GetMax() == 2.f);
+	CHECK(window.GetAverage() == 2.f);
+
+	window.AddSample(6.f);
+	CHECK(window.GetMax() == 6.f);
+	CHECK(window.GetLast() == 6.f);
+	CHECK(window.GetNumSamples() == 4);
+
+	window.Clear();
+	CHECK(window.GetNumSamples() == 0);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_empty_window();
+		test_window_statistics();
+		test_window_rolling();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
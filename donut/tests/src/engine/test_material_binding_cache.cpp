@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MaterialBindingCache.h>
+#include <donut/tests/null_device.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::engine;
+
+static nvrhi::IResource* GetBoundResource(nvrhi::IBindingSet* bindingSet, uint32_t index)
+{
+	return bindingSet->getDesc()->bindings[index].resourceHandle;
+}
+
+void test_texture_replacement()
+{
+	nvrhi::RefCountPtr<tests::NullDevice> device = nvrhi::RefCountPtr<tests::NullDevice>::Create(new tests::NullDevice());
+
+	nvrhi::TextureDesc textureDesc;
+	textureDesc.width = 64;
+	textureDesc.height = 64;
+	nvrhi::TextureHandle fallback = device->createTexture(textureDesc);
+
+	std::vector<MaterialResourceBinding> bindings = {
+		{ MaterialResource::DiffuseTexture, 0 },
+		{ MaterialResource::NormalTexture, 1 }
+	};
+	MaterialBindingCache cache(device, nvrhi::ShaderType::Pixel, 0, false, bindings, nullptr, fallback);
+
+	auto diffuse = std::make_shared<LoadedTexture>();
+	diffuse->texture = device->createTexture(textureDesc);
+
+	Material material;
+	material.baseOrDiffuseTexture = diffuse;
+
+	nvrhi::BindingSetHandle bindingSet = cache.GetMaterialBindingSet(&material);
+	CHECK(bindingSet);
+	CHECK(GetBoundResource(bindingSet, 0) == diffuse->texture.Get());
+	CHECK(GetBoundResource(bindingSet, 1) == fallback.Get());
+	CHECK(cache.GetMaterialBindingSet(&material) == bindingSet);
+
+	// The textures of the material are only compared when some texture has been replaced,
+	// which whoever replaces it announces with LoadedTexture::replacementGeneration
+	nvrhi::TextureHandle previousTexture = diffuse->texture;
+	diffuse->texture = device->createTexture(textureDesc);
+	CHECK(cache.GetMaterialBindingSet(&material) == bindingSet);
+
+	++LoadedTexture::replacementGeneration;
+	nvrhi::IBindingSet* newBindingSet = cache.GetMaterialBindingSet(&material);
+	CHECK(newBindingSet != bindingSet);
+	CHECK(GetBoundResource(newBindingSet, 0) == diffuse->texture.Get());
+
+	// Replacements of other textures don't invalidate the set
+	++LoadedTexture::replacementGeneration;
+	CHECK(cache.GetMaterialBindingSet(&material) == newBindingSet);
+	CHECK(cache.GetMaterialBindingSet(&material) == newBindingSet);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_texture_replacement();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,257 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MeshOptimizer.h>
+#include <donut/engine/SceneTypes.h>
+#include <donut/tests/utils.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+// A grid of size x size quads with the triangles in a random order
+static void make_shuffled_grid(int size, std::vector<float3>& positions, std::vector<uint32_t>& indices)
+{
+	for (int y = 0; y <= size; y++)
+		for (int x = 0; x <= size; x++)
+			positions.push_back(float3(float(x), float(y), 0.f));
+
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			uint32_t v00 = uint32_t(y * (size + 1) + x);
+			uint32_t v10 = v00 + 1;
+			uint32_t v01 = v00 + uint32_t(size + 1);
+			uint32_t v11 = v01 + 1;
+			triangles.push_back({ v00, v10, v11 });
+			triangles.push_back({ v00, v11, v01 });
+		}
+	}
+
+	std::mt19937 rng(1234);
+	std::shuffle(triangles.begin(), triangles.end(), rng);
+
+	for (const auto& triangle : triangles)
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+}
+
+// Returns the triangles as sorted lists of positions, rotated to start with the smallest position to keep the winding
+static std::vector<std::array<float, 9>> get_triangle_set(const std::vector<uint32_t>& indices, const float3* positions)
+{
+	std::vector<std::array<float, 9>> result;
+	for (size_t t = 0; t < indices.size() / 3; t++)
+	{
+		std::array<std::array<float, 3>, 3> corners;
+		for (size_t corner = 0; corner < 3; corner++)
+		{
+			const float3& p = positions[indices[t * 3 + corner]];
+			corners[corner] = { p.x, p.y, p.z };
+		}
+
+		size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+
+		std::array<float, 9> key;
+		for (size_t corner = 0; corner < 3; corner++)
+			std::copy(corners[(first + corner) % 3].begin(), corners[(first + corner) % 3].end(), key.begin() + corner * 3);
+		result.push_back(key);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+void test_analyze_vertex_cache()
+{
+	// Two triangles sharing an edge: 4 transforms for 2 triangles and 4 vertices
+	const std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+	VertexCacheStatistics stats = AnalyzeVertexCache(indices.data(), indices.size(), 4);
+	CHECK(stats.numTriangles == 2);
+	CHECK(stats.numVertices == 4);
+	CHECK(stats.numTransforms == 4);
+	CHECK(stats.GetACMR() == 2.f);
+	CHECK(stats.GetATVR() == 1.f);
+
+	// With a cache of 3 entries, reusing vertex 0 after 4 other vertices is a miss
+	const std::vector<uint32_t> farReuse = { 0, 1, 2, 3, 4, 5, 0, 4, 5 };
+	stats = AnalyzeVertexCache(farReuse.data(), farReuse.size(), 6, 3);
+	CHECK(stats.numTransforms == 7);
+
+	VertexCacheStatistics sum;
+	sum += stats;
+	sum += stats;
+	CHECK(sum.numTransforms == 14 && sum.numTriangles == 6);
+}
+
+void test_vertex_cache_optimization()
+{
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_shuffled_grid(32, positions, indices);
+
+	std::vector<uint32_t> optimized(indices.size());
+	OptimizeVertexCache(optimized.data(), indices.data(), indices.size(), positions.size());
+
+	CHECK(get_triangle_set(optimized, positions.data()) == get_triangle_set(indices, positions.data()));
+
+	float before = AnalyzeVertexCache(indices.data(), indices.size(), positions.size()).GetACMR();
+	float after = AnalyzeVertexCache(optimized.data(), optimized.size(), positions.size()).GetACMR();
+	CHECK(before > 2.f);
+	CHECK(after < 0.8f);
+
+	// Overdraw optimization keeps the triangles, and the ACMR within the threshold
+	std::vector<uint32_t> reordered(indices.size());
+	OptimizeOverdraw(reordered.data(), optimized.data(), optimized.size(), positions.data(), positions.size(), 1.05f);
+	CHECK(get_triangle_set(reordered, positions.data()) == get_triangle_set(indices, positions.data()));
+	float afterOverdraw = AnalyzeVertexCache(reordered.data(), reordered.size(), positions.size()).GetACMR();
+	CHECK(afterOverdraw < after * 1.2f);
+}
+
+void test_overdraw_ordering()
+{
+	// Two separate quads: an inner one facing the center and an outer one facing away.
+	// The outer one should be drawn first.
+	const std::vector<float3> positions = {
+		float3(-1.f, -1.f, -1.f), float3(-1.f, 1.f, -1.f), float3(1.f, 1.f, -1.f), float3(1.f, -1.f, -1.f),
+		float3(-1.f, -1.f, 3.f), float3(1.f, -1.f, 3.f), float3(1.f, 1.f, 3.f), float3(-1.f, 1.f, 3.f)
+	};
+	const std::vector<uint32_t> indices = {
+		0, 2, 1, 0, 3, 2, // z = -1, facing +Z (towards the center at z = 1)
+		4, 5, 6, 4, 6, 7  // z = 3, facing +Z (away from the center)
+	};
+
+	std::vector<uint32_t> reordered(indices.size());
+	OptimizeOverdraw(reordered.data(), indices.data(), indices.size(), positions.data(), positions.size(), 1.05f);
+	CHECK(reordered[0] >= 4 && reordered[1] >= 4 && reordered[2] >= 4);
+	CHECK(reordered[9] < 4 && reordered[10] < 4 && reordered[11] < 4);
+}
+
+void test_vertex_fetch_remap()
+{
+	const std::vector<uint32_t> indices = { 3, 1, 4, 4, 1, 0 };
+	std::vector<uint32_t> remap(6);
+	size_t referenced = OptimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), remap.size());
+	CHECK(referenced == 4);
+	CHECK(remap[3] == 0 && remap[1] == 1 && remap[4] == 2 && remap[0] == 3);
+	// Unreferenced vertices keep their relative order at the end
+	CHECK(remap[2] == 4 && remap[5] == 5);
+
+	std::vector<uint32_t> remapped = indices;
+	RemapIndexBuffer(remapped.data(), remapped.size(), remap.data());
+	CHECK((remapped == std::vector<uint32_t>{ 0, 1, 2, 2, 1, 3 }));
+
+	std::vector<int> stream = { 10, 11, 12, 13, 14, 15 };
+	RemapVertexStream(stream.data(), stream.size(), remap.data());
+	CHECK((stream == std::vector<int>{ 13, 11, 14, 10, 12, 15 }));
+}
+
+void test_optimize_meshes()
+{
+	auto buffers = std::make_shared<BufferGroup>();
+	auto mesh = std::make_shared<MeshInfo>();
+	mesh->buffers = buffers;
+
+	// Two geometries with their own vertex ranges, and a texture coordinate stream that tags every vertex
+	for (int geometryIndex = 0; geometryIndex < 2; geometryIndex++)
+	{
+		std::vector<float3> positions;
+		std::vector<uint32_t> indices;
+		make_shuffled_grid(16 + geometryIndex * 4, positions, indices);
+
+		auto geometry = std::make_shared<MeshGeometry>();
+		geometry->indexOffsetInMesh = uint32_t(buffers->indexData.size());
+		geometry->vertexOffsetInMesh = uint32_t(buffers->positionData.size());
+		geometry->numIndices = uint32_t(indices.size());
+		geometry->numVertices = uint32_t(positions.size());
+		mesh->geometries.push_back(geometry);
+
+		for (const float3& p : positions)
+		{
+			buffers->positionData.push_back(p + float3(0.f, 0.f, float(geometryIndex)));
+			buffers->texcoord1Data.push_back(p.xy() * 2.f);
+		}
+		buffers->indexData.insert(buffers->indexData.end(), indices.begin(), indices.end());
+	}
+
+	std::vector<std::vector<std::array<float, 9>>> trianglesBefore;
+	for (const auto& geometry : mesh->geometries)
+	{
+		std::vector<uint32_t> indices(buffers->indexData.begin() + geometry->indexOffsetInMesh,
+			buffers->indexData.begin() + geometry->indexOffsetInMesh + geometry->numIndices);
+		trianglesBefore.push_back(get_triangle_set(indices, buffers->positionData.data() + geometry->vertexOffsetInMesh));
+	}
+
+	MeshOptimizationStatistics stats = OptimizeMeshes({ mesh });
+	CHECK(stats.before.numTriangles == stats.after.numTriangles);
+	CHECK(stats.after.GetACMR() < stats.before.GetACMR());
+	CHECK(stats.after.GetATVR() < stats.before.GetATVR());
+
+	for (size_t geometryIndex = 0; geometryIndex < mesh->geometries.size(); geometryIndex++)
+	{
+		const auto& geometry = mesh->geometries[geometryIndex];
+		std::vector<uint32_t> indices(buffers->indexData.begin() + geometry->indexOffsetInMesh,
+			buffers->indexData.begin() + geometry->indexOffsetInMesh + geometry->numIndices);
+		CHECK(get_triangle_set(indices, buffers->positionData.data() + geometry->vertexOffsetInMesh) == trianglesBefore[geometryIndex]);
+
+		// Vertices are ordered by first use
+		CHECK(indices[0] == 0);
+		uint32_t maxSeen = 0;
+		for (uint32_t index : indices)
+		{
+			CHECK(index <= maxSeen + 1);
+			maxSeen = std::max(maxSeen, index);
+		}
+
+		// The other streams were permuted together with the positions
+		for (uint32_t vertex = 0; vertex < geometry->numVertices; vertex++)
+		{
+			const float3& p = buffers->positionData[geometry->vertexOffsetInMesh + vertex];
+			const float2& uv = buffers->texcoord1Data[geometry->vertexOffsetInMesh + vertex];
+			CHECK(p.z == float(geometryIndex));
+			CHECK(uv.x == p.x * 2.f && uv.y == p.y * 2.f);
+		}
+	}
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_analyze_vertex_cache();
+		test_vertex_cache_optimization();
+		test_overdraw_ordering();
+		test_vertex_fetch_remap();
+		test_optimize_meshes();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,343 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MeshSimplifier.h>
+#include <donut/engine/SceneTypes.h>
+#include <donut/tests/utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+// A flat grid of size x size quads in the XY plane, facing +Z
+static void make_grid(int size, std::vector<float3>& positions, std::vector<uint32_t>& indices)
+{
+	for (int y = 0; y <= size; y++)
+		for (int x = 0; x <= size; x++)
+			positions.push_back(float3(float(x), float(y), 0.f));
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			uint32_t v00 = uint32_t(y * (size + 1) + x);
+			uint32_t v10 = v00 + 1;
+			uint32_t v01 = v00 + uint32_t(size + 1);
+			uint32_t v11 = v01 + 1;
+			indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+		}
+	}
+}
+
+// A closed unit sphere with shared poles and no seams
+static void make_sphere(int rings, int segments, std::vector<float3>& positions, std::vector<uint32_t>& indices)
+{
+	positions.push_back(float3(0.f, 0.f, 1.f));
+	for (int ring = 1; ring < rings; ring++)
+	{
+		float theta = PI_f * float(ring) / float(rings);
+		for (int segment = 0; segment < segments; segment++)
+		{
+			float phi = 2.f * PI_f * float(segment) / float(segments);
+			positions.push_back(float3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta)));
+		}
+	}
+	positions.push_back(float3(0.f, 0.f, -1.f));
+
+	auto vertex = [segments](int ring, int segment) { return uint32_t(1 + (ring - 1) * segments + (segment % segments)); };
+	const uint32_t southPole = uint32_t(positions.size() - 1);
+
+	for (int segment = 0; segment < segments; segment++)
+	{
+		indices.insert(indices.end(), { 0u, vertex(1, segment), vertex(1, segment + 1) });
+		indices.insert(indices.end(), { southPole, vertex(rings - 1, segment + 1), vertex(rings - 1, segment) });
+	}
+
+	for (int ring = 1; ring < rings - 1; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			uint32_t a = vertex(ring, segment);
+			uint32_t b = vertex(ring, segment + 1);
+			uint32_t c = vertex(ring + 1, segment);
+			uint32_t d = vertex(ring + 1, segment + 1);
+			indices.insert(indices.end(), { a, c, d, a, d, b });
+		}
+	}
+}
+
+static float3 triangle_normal(const uint32_t* corners, const float3* positions)
+{
+	return cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+}
+
+// Every edge of a closed manifold mesh is shared by exactly two triangles, once in each direction
+static bool is_closed_manifold(const std::vector<uint32_t>& indices)
+{
+	std::map<std::pair<uint32_t, uint32_t>, int> edges;
+	for (size_t t = 0; t < indices.size(); t += 3)
+		for (size_t corner = 0; corner < 3; corner++)
+			++edges[{ indices[t + corner], indices[t + (corner + 1) % 3] }];
+
+	for (const auto& [edge, count] : edges)
+	{
+		if (count != 1 || edges.find({ edge.second, edge.first }) == edges.end())
+			return false;
+	}
+	return true;
+}
+
+void test_simplify_flat_grid()
+{
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_grid(16, positions, indices);
+
+	MeshSimplificationParameters params;
+	params.targetIndexCount = indices.size() / 4;
+
+	std::vector<uint32_t> result(indices.size());
+	float error = 1.f;
+	size_t numIndices = SimplifyMesh(result.data(), indices.data(), indices.size(), positions.data(), nullptr, positions.size(), params, &error);
+	result.resize(numIndices);
+
+	CHECK(numIndices % 3 == 0);
+	CHECK(numIndices <= indices.size() / 2);
+	CHECK(error < 1e-4f);
+
+	// The plane is covered without flipped triangles, and the area is preserved
+	float area = 0.f;
+	for (size_t t = 0; t < result.size(); t += 3)
+	{
+		float3 normal = triangle_normal(result.data() + t, positions.data());
+		CHECK(normal.z > 0.f);
+		area += normal.z * 0.5f;
+	}
+	CHECK(fabsf(area - 256.f) < 1e-3f);
+
+	// Border vertices are locked
+	for (uint32_t vertex = 0; vertex < positions.size(); vertex++)
+	{
+		const float3& p = positions[vertex];
+		bool border = p.x == 0.f || p.y == 0.f || p.x == 16.f || p.y == 16.f;
+		if (border)
+			CHECK(std::find(result.begin(), result.end(), vertex) != result.end());
+	}
+}
+
+void test_simplify_error_limit()
+{
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_sphere(24, 48, positions, indices);
+	CHECK(is_closed_manifold(indices));
+
+	MeshSimplificationParameters params;
+	params.targetIndexCount = 0;
+	params.targetError = 0.002f;
+
+	std::vector<uint32_t> strict(indices.size());
+	float strictError = 0.f;
+	size_t strictCount = SimplifyMesh(strict.data(), indices.data(), indices.size(), positions.data(), nullptr, positions.size(), params, &strictError);
+	strict.resize(strictCount);
+
+	params.targetError = 0.05f;
+	std::vector<uint32_t> loose(indices.size());
+	float looseError = 0.f;
+	size_t looseCount = SimplifyMesh(loose.data(), indices.data(), indices.size(), positions.data(), nullptr, positions.size(), params, &looseError);
+	loose.resize(looseCount);
+
+	CHECK(strictError <= 0.002f);
+	CHECK(looseError <= 0.05f);
+	CHECK(looseCount < strictCount);
+	CHECK(looseCount < indices.size() / 4);
+	CHECK(is_closed_manifold(strict));
+	CHECK(is_closed_manifold(loose));
+
+	// All triangles keep facing outwards
+	for (size_t t = 0; t < loose.size(); t += 3)
+	{
+		float3 normal = triangle_normal(loose.data() + t, positions.data());
+		float3 center = (positions[loose[t]] + positions[loose[t + 1]] + positions[loose[t + 2]]) / 3.f;
+		CHECK(dot(normal, center) > 0.f);
+	}
+}
+
+void test_simplify_attributes()
+{
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_grid(16, positions, indices);
+
+	// Texture coordinates that vary a lot more than the positions make collapses expensive
+	std::vector<float2> texCoords;
+	for (const float3& p : positions)
+		texCoords.push_back(float2(p.x * p.x, p.y) * 0.25f);
+
+	MeshSimplificationParameters params;
+	params.targetIndexCount = 0;
+	params.targetError = 0.01f;
+
+	std::vector<uint32_t> result(indices.size());
+	size_t withoutAttributes = SimplifyMesh(result.data(), indices.data(), indices.size(), positions.data(), nullptr, positions.size(), params);
+	size_t withAttributes = SimplifyMesh(result.data(), indices.data(), indices.size(), positions.data(), texCoords.data(), positions.size(), params);
+
+	CHECK(withoutAttributes < indices.size());
+	CHECK(withAttributes > withoutAttributes);
+
+	params.attributeWeight = 0.f;
+	size_t zeroWeight = SimplifyMesh(result.data(), indices.data(), indices.size(), positions.data(), texCoords.data(), positions.size(), params);
+	CHECK(zeroWeight == withoutAttributes);
+}
+
+void test_generate_mesh_lods()
+{
+	auto buffers = std::make_shared<BufferGroup>();
+	auto mesh = std::make_shared<MeshInfo>();
+	mesh->buffers = buffers;
+
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_sphere(32, 64, positions, indices);
+
+	auto geometry = std::make_shared<MeshGeometry>();
+	geometry->numIndices = uint32_t(indices.size());
+	geometry->numVertices = uint32_t(positions.size());
+	mesh->geometries.push_back(geometry);
+	mesh->totalIndices = geometry->numIndices;
+	mesh->totalVertices = geometry->numVertices;
+
+	buffers->positionData = positions;
+	buffers->indexData = indices;
+
+	// A small geometry that is left alone
+	auto smallGeometry = std::make_shared<MeshGeometry>();
+	smallGeometry->indexOffsetInMesh = uint32_t(buffers->indexData.size());
+	smallGeometry->vertexOffsetInMesh = uint32_t(buffers->positionData.size());
+	smallGeometry->numIndices = 3;
+	smallGeometry->numVertices = 3;
+	mesh->geometries.push_back(smallGeometry);
+	buffers->positionData.insert(buffers->positionData.end(), { float3(0.f), float3(1.f, 0.f, 0.f), float3(0.f, 1.f, 0.f) });
+	buffers->indexData.insert(buffers->indexData.end(), { 0u, 1u, 2u });
+
+	MeshLodParameters params;
+	params.maxErrorPerLod = 0.05f;
+	uint32_t numLods = GenerateMeshLods({ mesh }, nullptr, params);
+
+	CHECK(numLods > 1);
+	CHECK(numLods <= params.maxLods);
+	CHECK(geometry->getNumLods() == numLods + 1);
+	CHECK(smallGeometry->lods.empty());
+
+	// Levels get coarser and the errors accumulate
+	for (uint32_t lod = 1; lod < geometry->getNumLods(); lod++)
+	{
+		CHECK(geometry->getLodNumIndices(lod) < geometry->getLodNumIndices(lod - 1));
+		CHECK(geometry->getLodNumIndices(lod) % 3 == 0);
+		CHECK(geometry->lods[lod - 1].error > 0.f);
+		if (lod > 1)
+			CHECK(geometry->lods[lod - 1].error >= geometry->lods[lod - 2].error);
+
+		uint32_t offset = geometry->getLodIndexOffsetInMesh(lod);
+		CHECK(offset >= mesh->totalIndices + 3);
+		CHECK(offset + geometry->getLodNumIndices(lod) <= buffers->indexData.size());
+
+		std::vector<uint32_t> lodIndices(buffers->indexData.begin() + offset, buffers->indexData.begin() + offset + geometry->getLodNumIndices(lod));
+		CHECK(is_closed_manifold(lodIndices));
+		for (uint32_t index : lodIndices)
+			CHECK(index < geometry->numVertices);
+	}
+
+	// The original geometries are unchanged
+	CHECK(std::equal(indices.begin(), indices.end(), buffers->indexData.begin()));
+
+	// Running again doesn't generate duplicate levels
+	CHECK(GenerateMeshLods({ mesh }, nullptr, params) == 0);
+}
+
+void test_select_mesh_lod()
+{
+	MeshGeometry geometry;
+	CHECK(SelectMeshLod(geometry, 1000.f, 0, 1.f, 0.2f) == 0);
+
+	for (float error : { 0.01f, 0.02f, 0.04f })
+	{
+		MeshGeometryLod lod;
+		lod.error = error;
+		geometry.lods.push_back(lod);
+	}
+
+	// Far away, everything is within the error limit
+	CHECK(SelectMeshLod(geometry, 10.f, 0, 1.f, 0.2f) == 3);
+
+	// Close up, the full detail geometry is needed
+	CHECK(SelectMeshLod(geometry, 200.f, 3, 1.f, 0.2f) == 0);
+
+	// Projected errors of 1, 2, 4 pixels: level 1 is at the switching point
+	CHECK(SelectMeshLod(geometry, 100.f, 0, 1.f, 0.2f) == 0);
+	CHECK(SelectMeshLod(geometry, 100.f, 1, 1.f, 0.2f) == 1);
+	CHECK(SelectMeshLod(geometry, 100.f, 2, 1.f, 0.2f) == 1);
+	CHECK(SelectMeshLod(geometry, 100.f, 0, 1.f, 0.f) == 1);
+
+	// Moving away slowly, the level changes only after passing the hysteresis band
+	uint32_t current = 0;
+	float errorToPixels = 130.f;
+	std::vector<uint32_t> history;
+	while (errorToPixels > 10.f)
+	{
+		uint32_t lod = SelectMeshLod(geometry, errorToPixels, current, 1.f, 0.2f);
+		CHECK(lod >= current);
+		if (lod != current)
+			history.push_back(lod);
+		current = lod;
+		errorToPixels -= 1.f;
+	}
+	CHECK((history == std::vector<uint32_t>{ 1, 2, 3 }));
+
+	// And back in, also with a delay
+	CHECK(SelectMeshLod(geometry, 1.1f / 0.04f, 3, 1.f, 0.2f) == 3);
+	CHECK(SelectMeshLod(geometry, 1.3f / 0.04f, 3, 1.f, 0.2f) == 2);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_simplify_flat_grid();
+		test_simplify_error_limit();
+		test_simplify_attributes();
+		test_generate_mesh_lods();
+		test_select_mesh_lod();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,258 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MeshletBuilder.h>
+#include <donut/tests/utils.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+// A grid of size x size quads in the XY plane, facing +Z with counter-clockwise triangles
+static void make_grid(int size, std::vector<float3>& positions, std::vector<uint32_t>& indices)
+{
+	for (int y = 0; y <= size; y++)
+		for (int x = 0; x <= size; x++)
+			positions.push_back(float3(float(x), float(y), 0.f));
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			uint32_t v00 = uint32_t(y * (size + 1) + x);
+			uint32_t v10 = v00 + 1;
+			uint32_t v01 = v00 + uint32_t(size + 1);
+			uint32_t v11 = v01 + 1;
+			indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+		}
+	}
+}
+
+static uint32_t get_triangle_vertex(const Meshlet& meshlet, const std::vector<uint32_t>& indexData, uint32_t triangle, uint32_t corner)
+{
+	uint32_t local = (indexData[meshlet.triangleOffset + triangle] >> (corner * 8)) & 0xff;
+	CHECK(local < meshlet.vertexCount);
+	return indexData[meshlet.vertexOffset + local];
+}
+
+void test_meshlet_limits_and_coverage()
+{
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_grid(20, positions, indices);
+
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> indexData;
+	CHECK(BuildMeshlets(indices.data(), indices.size(), positions.data(), positions.size(), meshlets, indexData));
+	CHECK(!meshlets.empty());
+
+	// Every triangle must appear exactly once, with the same vertices and winding
+	std::vector<int> triangleUses(indices.size() / 3, 0);
+	size_t totalTriangles = 0;
+	size_t totalVertices = 0;
+
+	for (const Meshlet& meshlet : meshlets)
+	{
+		CHECK(meshlet.vertexCount > 0 && meshlet.vertexCount <= MaxMeshletVertices);
+		CHECK(meshlet.triangleCount > 0 && meshlet.triangleCount <= MaxMeshletTriangles);
+		totalTriangles += meshlet.triangleCount;
+		totalVertices += meshlet.vertexCount;
+
+		for (uint32_t vertex = 0; vertex < meshlet.vertexCount; vertex++)
+		{
+			const float3& p = positions[indexData[meshlet.vertexOffset + vertex]];
+			CHECK(length(p - meshlet.center) <= meshlet.radius * 1.0001f);
+		}
+
+		for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+		{
+			uint32_t a = get_triangle_vertex(meshlet, indexData, triangle, 0);
+			uint32_t b = get_triangle_vertex(meshlet, indexData, triangle, 1);
+			uint32_t c = get_triangle_vertex(meshlet, indexData, triangle, 2);
+
+			bool found = false;
+			for (size_t t = 0; t < triangleUses.size(); t++)
+			{
+				if (indices[t * 3] == a && indices[t * 3 + 1] == b && indices[t * 3 + 2] == c)
+				{
+					++triangleUses[t];
+					found = true;
+					break;
+				}
+			}
+			CHECK(found);
+		}
+	}
+
+	CHECK(totalTriangles == indices.size() / 3);
+	for (int uses : triangleUses)
+		CHECK(uses == 1);
+
+	// A regular grid should be split into compact clusters with good vertex reuse
+	CHECK(double(totalVertices) / double(totalTriangles) < 0.9);
+
+	// Smaller limits are respected too
+	meshlets.clear();
+	indexData.clear();
+	CHECK(BuildMeshlets(indices.data(), indices.size(), positions.data(), positions.size(), meshlets, indexData, 16, 20));
+	for (const Meshlet& meshlet : meshlets)
+	{
+		CHECK(meshlet.vertexCount <= 16);
+		CHECK(meshlet.triangleCount <= 20);
+	}
+
+	// Out of range indices are rejected
+	meshlets.clear();
+	indexData.clear();
+	indices.back() = uint32_t(positions.size());
+	CHECK(!BuildMeshlets(indices.data(), indices.size(), positions.data(), positions.size(), meshlets, indexData));
+	CHECK(meshlets.empty() && indexData.empty());
+}
+
+void test_meshlet_cone_culling()
+{
+	std::vector<float3> positions;
+	std::vector<uint32_t> indices;
+	make_grid(4, positions, indices);
+
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> indexData;
+	CHECK(BuildMeshlets(indices.data(), indices.size(), positions.data(), positions.size(), meshlets, indexData));
+	CHECK(meshlets.size() == 1);
+
+	const Meshlet& plane = meshlets[0];
+	CHECK(std::abs(plane.coneAxis.z - 1.f) < 1e-5f);
+	CHECK(plane.coneCutoff < 1e-3f);
+	CHECK(std::abs(plane.center.x - 2.f) < 1e-4f && std::abs(plane.center.y - 2.f) < 1e-4f);
+
+	// The plane faces +Z: it is visible from above and culled from below, unless the viewer is close to its bounds
+	CHECK(!IsMeshletBackfacing(plane, float3(2.f, 2.f, 10.f)));
+	CHECK(IsMeshletBackfacing(plane, float3(2.f, 2.f, -10.f)));
+	CHECK(!IsMeshletBackfacing(plane, float3(2.f, 2.f, -1.f)));
+	CHECK(!IsMeshletBackfacing(plane, float3(100.f, 2.f, -0.1f)));
+
+	// A closed box has normals in all directions, so the cone test must be disabled
+	const std::vector<float3> boxPositions = {
+		float3(0.f, 0.f, 0.f), float3(1.f, 0.f, 0.f), float3(1.f, 1.f, 0.f), float3(0.f, 1.f, 0.f),
+		float3(0.f, 0.f, 1.f), float3(1.f, 0.f, 1.f), float3(1.f, 1.f, 1.f), float3(0.f, 1.f, 1.f)
+	};
+	const std::vector<uint32_t> boxIndices = {
+		0, 2, 1, 0, 3, 2, // -Z
+		4, 5, 6, 4, 6, 7, // +Z
+		0, 1, 5, 0, 5, 4, // -Y
+		3, 7, 6, 3, 6, 2, // +Y
+		0, 4, 7, 0, 7, 3, // -X
+		1, 2, 6, 1, 6, 5  // +X
+	};
+
+	meshlets.clear();
+	indexData.clear();
+	CHECK(BuildMeshlets(boxIndices.data(), boxIndices.size(), boxPositions.data(), boxPositions.size(), meshlets, indexData));
+	CHECK(meshlets.size() == 1);
+	CHECK(meshlets[0].vertexCount == 8);
+	CHECK(meshlets[0].coneCutoff == 1.f);
+	CHECK(std::abs(meshlets[0].radius - std::sqrt(3.f) * 0.5f) < 1e-4f);
+	CHECK(!IsMeshletBackfacing(meshlets[0], float3(0.5f, 0.5f, -10.f)));
+
+	// Degenerate triangles don't produce a cone
+	const std::vector<uint32_t> degenerateIndices = { 0, 1, 1, 2, 2, 2 };
+	meshlets.clear();
+	indexData.clear();
+	CHECK(BuildMeshlets(degenerateIndices.data(), degenerateIndices.size(), boxPositions.data(), boxPositions.size(), meshlets, indexData));
+	CHECK(meshlets.size() == 1);
+	CHECK(meshlets[0].coneCutoff == 1.f);
+}
+
+void test_meshlets_for_meshes()
+{
+	auto buffers = std::make_shared<BufferGroup>();
+	std::vector<uint32_t> gridIndices;
+	make_grid(12, buffers->positionData, gridIndices);
+
+	// Two meshes with one and two geometries sharing the same buffer group
+	std::vector<std::shared_ptr<MeshInfo>> meshes;
+	for (int meshIndex = 0; meshIndex < 2; meshIndex++)
+	{
+		auto mesh = std::make_shared<MeshInfo>();
+		mesh->buffers = buffers;
+		mesh->indexOffset = uint32_t(buffers->indexData.size());
+		mesh->vertexOffset = 0;
+
+		for (int geometryIndex = 0; geometryIndex <= meshIndex; geometryIndex++)
+		{
+			auto geometry = std::make_shared<MeshGeometry>();
+			geometry->indexOffsetInMesh = uint32_t(buffers->indexData.size()) - mesh->indexOffset;
+			geometry->numIndices = uint32_t(gridIndices.size());
+			geometry->numVertices = uint32_t(buffers->positionData.size());
+			buffers->indexData.insert(buffers->indexData.end(), gridIndices.begin(), gridIndices.end());
+			mesh->geometries.push_back(geometry);
+		}
+		meshes.push_back(mesh);
+	}
+
+	BuildMeshletsForMeshes(meshes);
+
+	uint32_t expectedFirst = 0;
+	for (const auto& mesh : meshes)
+	{
+		for (const auto& geometry : mesh->geometries)
+		{
+			CHECK(geometry->firstMeshlet == expectedFirst);
+			CHECK(geometry->numMeshlets > 0);
+
+			uint32_t triangles = 0;
+			for (uint32_t i = 0; i < geometry->numMeshlets; i++)
+				triangles += buffers->meshlets[geometry->firstMeshlet + i].triangleCount;
+			CHECK(triangles == geometry->numIndices / 3);
+
+			expectedFirst += geometry->numMeshlets;
+		}
+	}
+	CHECK(expectedFirst == buffers->meshlets.size());
+
+	const Meshlet& last = buffers->meshlets.back();
+	CHECK(last.triangleOffset + last.triangleCount == buffers->meshletIndexData.size());
+
+	// Building again is a no-op
+	BuildMeshletsForMeshes(meshes);
+	CHECK(expectedFirst == buffers->meshlets.size());
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_meshlet_limits_and_coverage();
+		test_meshlet_cone_culling();
+		test_meshlets_for_meshes();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
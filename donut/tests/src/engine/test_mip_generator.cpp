@@ -0,0 +1,198 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/MipGenerator.h>
+#include <donut/tests/utils.h>
+
+#ifdef DONUT_WITH_TASKFLOW
+#include <taskflow/taskflow.hpp>
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace donut;
+using namespace donut::engine;
+
+void test_chain_layout()
+{
+	CHECK(MipGenerator::GetFullMipChainLength(1, 1) == 1);
+	CHECK(MipGenerator::GetFullMipChainLength(256, 256) == 9);
+	CHECK(MipGenerator::GetFullMipChainLength(7, 3) == 3);
+
+	std::vector<uint8_t> image(7 * 3, 100);
+	std::vector<uint8_t> data;
+	std::vector<MipLevelLayout> layout;
+	CHECK(MipGenerator::GenerateMipChain(image.data(), 7, 3, 7, nvrhi::Format::R8_UNORM, MipGenerationParams(), data, layout));
+
+	CHECK(layout.size() == 3);
+	CHECK(layout[1].width == 3 && layout[1].height == 1);
+	CHECK(layout[2].width == 1 && layout[2].height == 1);
+	CHECK(layout[2].dataOffset == 7 * 3 + 3);
+	CHECK(data.size() == 7 * 3 + 3 + 1);
+	for (uint8_t value : data)
+		CHECK(value == 100);
+
+	MipGenerationParams params;
+	params.maxMipLevels = 2;
+	CHECK(MipGenerator::GenerateMipChain(image.data(), 7, 3, 7, nvrhi::Format::R8_UNORM, params, data, layout));
+	CHECK(layout.size() == 2);
+
+	CHECK(!MipGenerator::IsFormatSupported(nvrhi::Format::BC1_UNORM));
+	CHECK(!MipGenerator::GenerateMipChain(image.data(), 7, 3, 7, nvrhi::Format::BC1_UNORM, params, data, layout));
+}
+
+void test_box_filter()
+{
+	// 4x2 RG8 image, the 2x1 result must be the average of each 2x2 block
+	const uint8_t image[] = {
+		0, 10,   40, 50,   100, 0,   200, 0,
+		20, 30,  60, 70,   100, 0,   0, 0
+	};
+
+	uint8_t result[4] = {};
+	CHECK(MipGenerator::ResizeImage(image, 4, 2, 8, result, 2, 1, 4, nvrhi::Format::RG8_UNORM, MipGenerationParams()));
+	CHECK(result[0] == 30 && result[1] == 40);
+	CHECK(result[2] == 100 && result[3] == 0);
+
+	// Odd sizes: 5 -> 2 gives weights of 0.4, 0.4, 0.2 and 0.2, 0.4, 0.4
+	const uint8_t row[] = { 0, 0, 250, 0, 0 };
+	CHECK(MipGenerator::ResizeImage(row, 5, 1, 5, result, 2, 1, 2, nvrhi::Format::R8_UNORM, MipGenerationParams()));
+	CHECK(result[0] == 50 && result[1] == 50);
+}
+
+void test_srgb()
+{
+	// Black and white checkerboard, the average is 0.5 in linear space, which is 188 in sRGB
+	const uint8_t image[] = {
+		0, 0, 0, 0,         255, 255, 255, 255,
+		255, 255, 255, 255, 0, 0, 0, 0
+	};
+
+	uint8_t result[4] = {};
+	CHECK(MipGenerator::ResizeImage(image, 2, 2, 8, result, 1, 1, 4, nvrhi::Format::SRGBA8_UNORM, MipGenerationParams()));
+	CHECK(result[0] == 188 && result[1] == 188 && result[2] == 188);
+	CHECK(result[3] == 128); // alpha is linear
+
+	CHECK(MipGenerator::ResizeImage(image, 2, 2, 8, result, 1, 1, 4, nvrhi::Format::RGBA8_UNORM, MipGenerationParams()));
+	CHECK(result[0] == 128);
+
+	MipGenerationParams params;
+	params.sRGB = true;
+	CHECK(MipGenerator::ResizeImage(image, 2, 2, 8, result, 1, 1, 4, nvrhi::Format::RGBA8_UNORM, params));
+	CHECK(result[0] == 188);
+
+	// sRGB codes must survive a decode-encode round trip
+	uint8_t ramp[256 * 4];
+	for (int i = 0; i < 256; i++)
+		memset(ramp + i * 4, i, 4);
+	uint8_t copy[256 * 4];
+	CHECK(MipGenerator::ResizeImage(ramp, 256, 1, sizeof(ramp), copy, 256, 1, sizeof(copy), nvrhi::Format::SRGBA8_UNORM, MipGenerationParams()));
+	CHECK(memcmp(ramp, copy, sizeof(ramp)) == 0);
+}
+
+void test_hdr()
+{
+	// Values above 1 must not be clamped
+	const float image[] = { 1000.f, 0.f, 3.f, 5.f };
+	float result = 0.f;
+	CHECK(MipGenerator::ResizeImage(image, 2, 2, 8, &result, 1, 1, 4, nvrhi::Format::R32_FLOAT, MipGenerationParams()));
+	CHECK(std::abs(result - 252.f) < 1e-3f);
+
+	std::vector<float> rgba(64 * 64 * 4, 16.f);
+	std::vector<uint8_t> data;
+	std::vector<MipLevelLayout> layout;
+	MipGenerationParams params;
+	params.filter = MipFilter::Kaiser;
+	CHECK(MipGenerator::GenerateMipChain(rgba.data(), 64, 64, 64 * 16, nvrhi::Format::RGBA32_FLOAT, params, data, layout));
+	CHECK(layout.size() == 7);
+
+	// The filter weights are normalized, so a constant image stays constant in every level
+	const float* values = reinterpret_cast<const float*>(data.data());
+	for (size_t i = 0; i < data.size() / sizeof(float); i++)
+		CHECK(std::abs(values[i] - 16.f) < 1e-3f);
+}
+
+void test_kaiser()
+{
+	// A bright 2-texel line must produce a symmetric, normalized response with the sinc's negative lobes
+	std::vector<float> row(16, 0.f);
+	row[7] = row[8] = 1.f;
+
+	MipGenerationParams params;
+	params.filter = MipFilter::Kaiser;
+	float result[8] = {};
+	CHECK(MipGenerator::ResizeImage(row.data(), 16, 1, 16 * 4, result, 8, 1, 8 * 4, nvrhi::Format::R32_FLOAT, params));
+
+	float sum = 0.f;
+	for (int i = 0; i < 8; i++)
+		sum += result[i];
+	CHECK(std::abs(sum - 1.f) < 1e-3f);
+	CHECK(std::abs(result[3] - result[4]) < 1e-5f);
+	CHECK(result[3] > 0.5f && result[2] < 0.f && result[1] > 0.f);
+}
+
+void test_threading()
+{
+#ifdef DONUT_WITH_TASKFLOW
+	const uint32_t width = 301;
+	const uint32_t height = 203;
+	std::vector<uint8_t> image(width * height * 4);
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = uint8_t((i * 7919) >> 3);
+
+	MipGenerationParams params;
+	params.filter = MipFilter::Kaiser;
+	params.sRGB = true;
+
+	std::vector<uint8_t> serialData, parallelData;
+	std::vector<MipLevelLayout> serialLayout, parallelLayout;
+	CHECK(MipGenerator::GenerateMipChain(image.data(), width, height, width * 4, nvrhi::Format::RGBA8_UNORM, params, serialData, serialLayout));
+
+	tf::Executor executor(4);
+	params.executor = &executor;
+	CHECK(MipGenerator::GenerateMipChain(image.data(), width, height, width * 4, nvrhi::Format::RGBA8_UNORM, params, parallelData, parallelLayout));
+
+	CHECK(serialLayout.size() == parallelLayout.size());
+	CHECK(serialData == parallelData);
+#endif
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_chain_layout();
+		test_box_filter();
+		test_srgb();
+		test_hdr();
+		test_kaiser();
+		test_threading();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
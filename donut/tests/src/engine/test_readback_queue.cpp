@@ -0,0 +1,168 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <donut/engine/ReadbackQueue.h>
+#include <donut/tests/null_device.h>
+#include <donut/tests/utils.h>
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+using namespace donut;
+using namespace donut::engine;
+
+// The worker thread doesn't touch the device, so these tests run without one.
+
+void test_worker_order()
+{
+	std::vector<int> results;
+
+	{
+		ReadbackQueue queue(nullptr);
+		CHECK(queue.GetNumPendingRequests() == 0);
+
+		for (int i = 0; i < 100; i++)
+			queue.RunOnWorkerThread([&results, i]() { results.push_back(i); });
+
+		// The destructor finishes the queued tasks
+	}
+
+	CHECK(results.size() == 100);
+	for (int i = 0; i < 100; i++)
+	{
+		CHECK(results[i] == i);
+	}
+}
+
+void test_worker_enqueue_from_task()
+{
+	std::atomic<int> counter = 0;
+
+	{
+		ReadbackQueue queue(nullptr);
+		queue.RunOnWorkerThread([&queue, &counter]()
+		{
+			counter++;
+			queue.RunOnWorkerThread([&counter]() { counter++; });
+		});
+	}
+
+	CHECK(counter == 2);
+}
+
+// Counts the event queries, and lets the test decide when the GPU work is finished
+class QueryCountingDevice : public tests::NullDevice
+{
+public:
+	int numQueriesCreated = 0;
+	int numQueriesSet = 0;
+	bool gpuIdle = true;
+
+	nvrhi::EventQueryHandle createEventQuery() override { ++numQueriesCreated; return tests::NullDevice::createEventQuery(); }
+	void setEventQuery(nvrhi::IEventQuery*, nvrhi::CommandQueue) override { ++numQueriesSet; }
+	bool pollEventQuery(nvrhi::IEventQuery*) override { return gpuIdle; }
+};
+
+void test_fence_submitted_requests()
+{
+	nvrhi::RefCountPtr<QueryCountingDevice> device = nvrhi::RefCountPtr<QueryCountingDevice>::Create(new QueryCountingDevice());
+
+	nvrhi::BufferHandle source = device->createBuffer(nvrhi::BufferDesc().setByteSize(16));
+	const uint32_t sourceData[4] = { 1, 2, 3, 4 };
+
+	nvrhi::CommandListHandle executedList = device->createCommandList(nvrhi::CommandListParameters());
+	nvrhi::CommandListHandle laterList = device->createCommandList(nvrhi::CommandListParameters());
+	executedList->open();
+	executedList->writeBuffer(source, sourceData, sizeof(sourceData));
+
+	std::vector<uint32_t> results;
+	auto readValue = [&results](const void* data, size_t size)
+	{
+		CHECK(data && size == sizeof(uint32_t));
+		results.push_back(*static_cast<const uint32_t*>(data));
+	};
+
+	{
+		ReadbackQueue queue(device);
+
+		queue.RequestBuffer(executedList, source, 0, 4, readValue);
+		queue.RequestBuffer(laterList, source, 8, 4, readValue);
+		queue.RequestBuffer(executedList, source, 4, 4, readValue);
+		CHECK(queue.GetNumPendingRequests() == 3);
+
+		// Nothing has been executed yet, so nothing is fenced
+		queue.Update();
+		CHECK(device->numQueriesSet == 0);
+		CHECK(results.empty());
+
+		// The requests of the executed list are fenced together, with one query
+		executedList->close();
+		device->executeCommandList(executedList);
+		queue.OnCommandListExecuted(executedList);
+		device->gpuIdle = false;
+		queue.Update();
+		CHECK(device->numQueriesCreated == 1);
+		CHECK(device->numQueriesSet == 1);
+		CHECK(results.empty());
+		CHECK(queue.GetNumPendingRequests() == 3);
+
+		// They complete in order once the query is signaled, and the other request keeps waiting
+		device->gpuIdle = true;
+		queue.Update();
+		CHECK(results.size() == 2);
+		CHECK(results[0] == 1 && results[1] == 2);
+		CHECK(queue.GetNumPendingRequests() == 1);
+		CHECK(queue.GetNumPooledBuffers() == 2);
+		CHECK(device->numQueriesSet == 1);
+
+		// The query is reused for the next batch
+		laterList->open();
+		laterList->close();
+		device->executeCommandList(laterList);
+		queue.OnCommandListExecuted(laterList);
+		queue.Flush();
+		CHECK(results.size() == 3);
+		CHECK(results[2] == 3);
+		CHECK(queue.GetNumPendingRequests() == 0);
+		CHECK(queue.GetNumPooledBuffers() == 3);
+		CHECK(device->numQueriesCreated == 1);
+		CHECK(device->numQueriesSet == 2);
+	}
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_worker_order();
+		test_worker_enqueue_from_task();
+		test_fence_submitted_requests();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
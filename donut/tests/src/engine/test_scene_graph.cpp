@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/SceneGraph.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+static double3 WorldPosition(const SceneGraphNode& node)
+{
+	return node.GetLocalToWorldTransform().m_translation;
+}
+
+static double3 PrevWorldPosition(const SceneGraphNode& node)
+{
+	return node.GetPrevLocalToWorldTransform().m_translation;
+}
+
+void test_publish_transforms()
+{
+	auto graph = std::make_shared<SceneGraph>();
+	auto root = std::make_shared<SceneGraphNode>();
+	graph->SetRootNode(root);
+
+	auto parent = std::make_shared<SceneGraphNode>();
+	parent->SetTranslation(double3(1.0, 0.0, 0.0));
+	graph->Attach(root, parent);
+
+	auto child = std::make_shared<SceneGraphNode>();
+	child->SetTranslation(double3(0.0, 1.0, 0.0));
+	graph->Attach(parent, child);
+
+	// Structure changes are left to Refresh
+	CHECK(!graph->RefreshTransforms());
+	graph->Refresh(0);
+	CHECK(all(WorldPosition(*child) == double3(1.0, 1.0, 0.0)));
+
+	// The simulation refreshes the next frame while the renderer still sees the published one
+	parent->SetTranslation(double3(2.0, 0.0, 0.0));
+	CHECK(graph->RefreshTransforms());
+	CHECK(all(WorldPosition(*parent) == double3(1.0, 0.0, 0.0)));
+	CHECK(all(WorldPosition(*child) == double3(1.0, 1.0, 0.0)));
+
+	graph->PublishTransforms(1);
+	CHECK(all(WorldPosition(*parent) == double3(2.0, 0.0, 0.0)));
+	CHECK(all(WorldPosition(*child) == double3(2.0, 1.0, 0.0)));
+	CHECK(all(PrevWorldPosition(*child) == double3(1.0, 1.0, 0.0)));
+	CHECK((child->GetDirtyFlags() & SceneGraphNode::DirtyFlags::PrevTransform) != 0);
+	CHECK(graph->GetRootNode()->GetGlobalBoundingBox().isempty());
+
+	// A frame without changes catches up the previous transforms
+	CHECK(graph->RefreshTransforms());
+	graph->PublishTransforms(2);
+	CHECK(all(PrevWorldPosition(*child) == double3(2.0, 1.0, 0.0)));
+	CHECK(child->GetDirtyFlags() == 0);
+
+	// Refresh is both halves at once
+	child->SetTranslation(double3(0.0, 0.0, 3.0));
+	graph->Refresh(3);
+	CHECK(all(WorldPosition(*child) == double3(2.0, 0.0, 3.0)));
+	CHECK(all(PrevWorldPosition(*child) == double3(2.0, 1.0, 0.0)));
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_publish_transforms();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
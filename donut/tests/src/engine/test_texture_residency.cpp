@@ -0,0 +1,201 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/TextureResidency.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::engine;
+
+// 256x256 RGBA8 texture with 9 levels: 256, 128, ... 1
+static std::vector<uint64_t> MakeMipSizes(uint32_t size)
+{
+	std::vector<uint64_t> sizes;
+	while (true)
+	{
+		sizes.push_back(uint64_t(size) * size * 4);
+		if (size == 1)
+			break;
+		size /= 2;
+	}
+	return sizes;
+}
+
+static void ApplyRequests(TextureResidencyPolicy& policy, const std::vector<TextureResidencyPolicy::Request>& requests)
+{
+	for (const auto& request : requests)
+		policy.SetResidentMip(request.texture, request.requestedMip);
+}
+
+void test_registration()
+{
+	TextureResidencyPolicy policy;
+	auto sizes = MakeMipSizes(256);
+
+	auto a = policy.RegisterTexture(sizes, 3);
+	CHECK(policy.GetTailMip(a) == 6);
+	CHECK(policy.GetResidentMip(a) == 6);
+	CHECK(policy.GetResidentMemory() == policy.GetTextureMemory(a, 6));
+	CHECK(policy.GetTextureMemory(a, 8) == 4);
+
+	auto b = policy.RegisterTexture(sizes, 100);
+	CHECK(policy.GetTailMip(b) == 0);
+	CHECK(policy.GetNumTextures() == 2);
+
+	policy.UnregisterTexture(a);
+	CHECK(policy.GetNumTextures() == 1);
+	CHECK(!policy.IsTextureRegistered(a));
+	CHECK(policy.GetResidentMemory() == policy.GetTextureMemory(b, 0));
+
+	// Ids are recycled
+	auto c = policy.RegisterTexture(sizes, 1);
+	CHECK(c == a);
+	CHECK(policy.GetResidentMip(c) == 8);
+}
+
+void test_feedback_and_promotion()
+{
+	TextureResidencyPolicy policy;
+	std::vector<TextureResidencyPolicy::Request> requests;
+
+	auto a = policy.RegisterTexture(MakeMipSizes(256), 3);
+
+	// No feedback: nothing happens
+	policy.Update(0, requests);
+	CHECK(requests.empty());
+
+	// Multiple reports in the same frame combine into the finest level
+	policy.ReportRequiredMip(a, 4, 1);
+	policy.ReportRequiredMip(a, 2, 1);
+	policy.ReportRequiredMip(a, 5, 1);
+	policy.Update(1, requests);
+	CHECK(requests.size() == 1);
+	CHECK(requests[0].texture == a);
+	CHECK(requests[0].currentMip == 6);
+	CHECK(requests[0].requestedMip == 2);
+	CHECK(!requests[0].IsEviction());
+	ApplyRequests(policy, requests);
+	CHECK(policy.GetResidentMip(a) == 2);
+
+	// Requests finer than the tail are clamped, and a new frame replaces the old feedback
+	policy.ReportRequiredMip(a, 7, 2);
+	policy.Update(2, requests);
+	CHECK(requests.size() == 1);
+	CHECK(requests[0].requestedMip == 6);
+	CHECK(requests[0].IsEviction());
+	ApplyRequests(policy, requests);
+
+	// Stale feedback falls back to the tail
+	policy.ReportRequiredMip(a, 0, 3);
+	policy.Update(3, requests);
+	ApplyRequests(policy, requests);
+	CHECK(policy.GetResidentMip(a) == 0);
+
+	policy.SetFeedbackLifetime(10);
+	policy.Update(10, requests);
+	CHECK(requests.empty());
+	policy.Update(14, requests);
+	CHECK(requests.size() == 1);
+	CHECK(requests[0].requestedMip == 6);
+}
+
+void test_budget()
+{
+	TextureResidencyPolicy policy;
+	std::vector<TextureResidencyPolicy::Request> requests;
+	auto sizes = MakeMipSizes(256);
+
+	auto recent = policy.RegisterTexture(sizes, 3);
+	auto old = policy.RegisterTexture(sizes, 3);
+
+	uint64_t full = policy.GetTextureMemory(recent, 0);
+	uint64_t withoutTop = policy.GetTextureMemory(recent, 1);
+
+	// Enough room for one full texture and one texture without its top level
+	policy.SetMemoryBudget(full + withoutTop);
+
+	policy.ReportRequiredMip(old, 0, 5);
+	policy.ReportRequiredMip(recent, 0, 6);
+	policy.Update(6, requests);
+	ApplyRequests(policy, requests);
+
+	CHECK(policy.GetResidentMip(recent) == 0);
+	CHECK(policy.GetResidentMip(old) == 1);
+	CHECK(policy.GetResidentMemory() <= policy.GetMemoryBudget());
+
+	// Shrinking the budget evicts from the least recently used texture first, but never the tails
+	policy.SetMemoryBudget(1);
+	policy.ReportRequiredMip(old, 0, 7);
+	policy.ReportRequiredMip(recent, 0, 8);
+	policy.Update(8, requests);
+	CHECK(requests.size() == 2);
+	CHECK(requests[0].IsEviction() && requests[1].IsEviction());
+	ApplyRequests(policy, requests);
+	CHECK(policy.GetResidentMip(recent) == 6);
+	CHECK(policy.GetResidentMip(old) == 6);
+}
+
+void test_promotion_limit()
+{
+	TextureResidencyPolicy policy;
+	std::vector<TextureResidencyPolicy::Request> requests;
+	auto sizes = MakeMipSizes(64);
+
+	std::vector<TextureResidencyPolicy::TextureId> textures;
+	for (int i = 0; i < 10; i++)
+		textures.push_back(policy.RegisterTexture(sizes, 1));
+
+	policy.SetMaxPromotionsPerUpdate(4);
+	for (uint32_t i = 0; i < 10; i++)
+		policy.ReportRequiredMip(textures[i], i < 5 ? 0 : 3, 1);
+
+	policy.Update(1, requests);
+	CHECK(requests.size() == 4);
+	for (const auto& request : requests)
+		CHECK(request.requestedMip == 0); // the most blurry textures go first
+	ApplyRequests(policy, requests);
+
+	for (uint32_t i = 0; i < 10; i++)
+		policy.ReportRequiredMip(textures[i], i < 5 ? 0 : 3, 2);
+	policy.Update(2, requests);
+	CHECK(requests.size() == 4);
+	ApplyRequests(policy, requests);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_registration();
+		test_feedback_and_promotion();
+		test_budget();
+		test_promotion_limit();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
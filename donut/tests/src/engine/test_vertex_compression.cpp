@@ -0,0 +1,138 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/engine/VertexCompression.h>
+#include <donut/tests/utils.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+
+void test_half_conversion()
+{
+	CHECK(FloatToHalf(0.f) == 0x0000);
+	CHECK(FloatToHalf(-0.f) == 0x8000);
+	CHECK(FloatToHalf(1.f) == 0x3c00);
+	CHECK(FloatToHalf(-2.f) == 0xc000);
+	CHECK(FloatToHalf(65504.f) == 0x7bff);
+	CHECK(FloatToHalf(1e6f) == 0x7c00);
+	CHECK(FloatToHalf(5.9604645e-8f) == 0x0001); // smallest subnormal
+	CHECK(FloatToHalf(1e-9f) == 0x0000);
+	CHECK((FloatToHalf(NAN) & 0x7fff) > 0x7c00);
+
+	// 1 + 2^-11 is exactly halfway between 1 and the next half, and rounds to even
+	CHECK(FloatToHalf(1.f + 1.f / 2048.f) == 0x3c00);
+	CHECK(FloatToHalf(1.f + 3.f / 2048.f) == 0x3c02);
+
+	// All finite halfs survive a round trip
+	for (uint32_t bits = 0; bits < 0x10000; bits++)
+	{
+		uint16_t half = uint16_t(bits);
+		if ((half & 0x7c00) == 0x7c00)
+			continue;
+
+		CHECK(FloatToHalf(HalfToFloat(half)) == half);
+	}
+
+	CHECK(CanUseCompactTexCoords(nullptr, 0));
+	std::vector<float2> texCoords = { float2(0.f, 1.f), float2(-2.f, 2.f) };
+	CHECK(CanUseCompactTexCoords(texCoords.data(), texCoords.size()));
+	texCoords.push_back(float2(0.5f, 2.5f));
+	CHECK(!CanUseCompactTexCoords(texCoords.data(), texCoords.size()));
+}
+
+void test_position_quantization()
+{
+	box3 bounds(float3(-1.f, 2.f, 10.f), float3(3.f, 2.f, 110.f));
+
+	float3 scale, bias;
+	GetPositionDequantization(bounds, scale, bias);
+	CHECK(all(bias == bounds.m_mins));
+
+	float3 maxError = scale * 0.5f + 1e-5f;
+
+	for (int i = 0; i <= 100; i++)
+	{
+		float t = float(i) / 100.f;
+		float3 position = lerp(bounds.m_mins, bounds.m_maxs, t);
+
+		vector<uint16_t, 4> quantized = QuantizePosition(position, scale, bias);
+		float3 decoded = float3(float(quantized.x), float(quantized.y), float(quantized.z)) * scale + bias;
+
+		CHECK(all(abs(decoded - position) <= maxError));
+	}
+
+	// The flat axis decodes to the exact bias
+	CHECK(QuantizePosition(float3(0.f, 2.f, 10.f), scale, bias).y == 0);
+
+	// Corners map to the ends of the range
+	CHECK(QuantizePosition(bounds.m_mins, scale, bias).x == 0);
+	CHECK(QuantizePosition(bounds.m_maxs, scale, bias).z == 65535);
+}
+
+void test_joint_weights()
+{
+	auto sumWeights = [](uint32_t packed)
+	{
+		return (packed & 0xff) + ((packed >> 8) & 0xff) + ((packed >> 16) & 0xff) + (packed >> 24);
+	};
+
+	CHECK(PackJointWeightsUnorm8(float4(1.f, 0.f, 0.f, 0.f)) == 0x000000ff);
+	CHECK(PackJointWeightsUnorm8(float4(0.f)) == 0);
+
+	// Three equal weights can't be represented exactly, but they still have to sum up to 1
+	CHECK(sumWeights(PackJointWeightsUnorm8(float4(1.f, 1.f, 1.f, 0.f))) == 255);
+	CHECK(sumWeights(PackJointWeightsUnorm8(float4(0.1f, 0.2f, 0.3f, 0.4f))) == 255);
+
+	// Unnormalized inputs are normalized
+	CHECK(PackJointWeightsUnorm8(float4(0.f, 0.f, 2.f, 2.f)) == PackJointWeightsUnorm8(float4(0.f, 0.f, 0.5f, 0.5f)));
+}
+
+void test_index_format()
+{
+	std::vector<uint32_t> indices = { 0, 1, 2, 65535 };
+	CHECK(CanUse16BitIndices(indices.data(), indices.size()));
+
+	indices.push_back(65536);
+	CHECK(!CanUse16BitIndices(indices.data(), indices.size()));
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_half_conversion();
+		test_position_quantization();
+		test_joint_weights();
+		test_index_format();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
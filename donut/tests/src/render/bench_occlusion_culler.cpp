@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+// Measures the software rasterizer and the box tests of OcclusionCuller on a synthetic city-like scene.
+// This is a benchmark, not a test: it is built with the tests but not registered with CTest.
+// Usage: bench_occlusion_culler [number of boxes] [iterations]
+
+#include <donut/render/OcclusionCuller.h>
+#include <donut/engine/View.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+static double MeasureMilliseconds(int iterations, const std::function<void()>& func)
+{
+	func(); // warm up
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+		func();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count() / double(iterations);
+}
+
+// A unit cube made of 12 triangles
+static const float3 c_CubePositions[] = {
+	float3(0.f, 0.f, 0.f), float3(1.f, 0.f, 0.f), float3(1.f, 1.f, 0.f), float3(0.f, 1.f, 0.f),
+	float3(0.f, 0.f, 1.f), float3(1.f, 0.f, 1.f), float3(1.f, 1.f, 1.f), float3(0.f, 1.f, 1.f)
+};
+static const uint32_t c_CubeIndices[] = {
+	0, 1, 2, 0, 2, 3,  4, 6, 5, 4, 7, 6,  0, 4, 5, 0, 5, 1,
+	3, 2, 6, 3, 6, 7,  0, 3, 7, 0, 7, 4,  1, 5, 6, 1, 6, 2
+};
+
+int main(int argc, char** argv)
+{
+	int numBoxes = argc > 1 ? atoi(argv[1]) : 100000;
+	int iterations = argc > 2 ? atoi(argv[2]) : 20;
+
+	PlanarView view;
+	view.SetViewport(nvrhi::Viewport(1920.f, 1080.f));
+	view.SetMatrices(inverse(translation(float3(0.f, 2.f, -5.f))), perspProjD3DStyleReverse(radians(60.f), 1920.f / 1080.f, 0.1f));
+	view.UpdateCache();
+
+	// Buildings on a grid in front of the camera, and small objects scattered among them
+	std::vector<affine3> buildings;
+	for (int row = 0; row < 8; row++)
+	{
+		for (int column = -4; column < 4; column++)
+		{
+			float height = 5.f + float((row * 7 + column * 13) & 15);
+			buildings.push_back(scaling(float3(8.f, height, 8.f)) * translation(float3(float(column) * 12.f, 0.f, 10.f + float(row) * 12.f)));
+		}
+	}
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> distX(-60.f, 60.f);
+	std::uniform_real_distribution<float> distY(0.f, 4.f);
+	std::uniform_real_distribution<float> distZ(5.f, 110.f);
+	std::vector<box3> boxes;
+	for (int i = 0; i < numBoxes; i++)
+	{
+		float3 position(distX(rng), distY(rng), distZ(rng));
+		boxes.push_back(box3(position, position + 0.5f));
+	}
+
+	OcclusionCuller culler(256, 128);
+	uint32_t numVisible = 0;
+
+	auto rasterize = [&]()
+	{
+		culler.BeginView(view.GetViewProjectionMatrix(true), view.IsReverseDepth());
+		for (const affine3& building : buildings)
+			culler.RasterizeOccluder(c_CubePositions, c_CubeIndices, std::size(c_CubeIndices), building);
+	};
+
+	auto test = [&]()
+	{
+		numVisible = 0;
+		for (const box3& box : boxes)
+			numVisible += culler.IsBoxVisible(box) ? 1 : 0;
+	};
+
+	printf("%zu occluders, %d boxes, %ux%u culling buffer, average of %d iterations:\n",
+		buildings.size(), numBoxes, culler.GetWidth(), culler.GetHeight(), iterations);
+
+	printf("  Rasterize occluders:  %8.3f ms\n", MeasureMilliseconds(iterations, rasterize));
+	printf("  Test boxes:           %8.3f ms\n", MeasureMilliseconds(iterations, test));
+
+	const OcclusionCuller::Statistics& stats = culler.GetStatistics();
+	printf("  %u of %u occluder triangles rasterized, %u of %d boxes visible\n",
+		stats.numRasterizedTriangles, uint32_t(buildings.size() * std::size(c_CubeIndices) / 3), numVisible, numBoxes);
+
+	return 0;
+}
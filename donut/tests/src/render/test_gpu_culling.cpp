@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/GpuCullingPass.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+static std::shared_ptr<MeshGeometry> CreateGeometry(const std::shared_ptr<Material>& material, uint32_t indexOffset, uint32_t vertexOffset, uint32_t numIndices)
+{
+	auto geometry = std::make_shared<MeshGeometry>();
+	geometry->material = material;
+	geometry->indexOffsetInMesh = indexOffset;
+	geometry->vertexOffsetInMesh = vertexOffset;
+	geometry->numIndices = numIndices;
+	geometry->objectSpaceBounds = box3(float3(-1.f), float3(float(numIndices)));
+	return geometry;
+}
+
+void test_draw_list_buckets()
+{
+	auto opaque = std::make_shared<Material>();
+	auto alphaTested = std::make_shared<Material>();
+	alphaTested->domain = MaterialDomain::AlphaTested;
+	alphaTested->doubleSided = true;
+	auto blended = std::make_shared<Material>();
+	blended->domain = MaterialDomain::AlphaBlended;
+
+	auto buffersA = std::make_shared<BufferGroup>();
+	auto buffersB = std::make_shared<BufferGroup>();
+
+	auto meshA = std::make_shared<MeshInfo>();
+	meshA->buffers = buffersA;
+	meshA->indexOffset = 1000;
+	meshA->vertexOffset = 500;
+	meshA->geometries.push_back(CreateGeometry(opaque, 0, 0, 30));
+	meshA->geometries.push_back(CreateGeometry(alphaTested, 30, 20, 60));
+	meshA->geometries.push_back(CreateGeometry(blended, 90, 50, 12));
+
+	auto meshB = std::make_shared<MeshInfo>();
+	meshB->buffers = buffersB;
+	meshB->geometries.push_back(CreateGeometry(opaque, 0, 0, 36));
+
+	auto meshC = std::make_shared<MeshInfo>();
+	meshC->buffers = buffersB;
+	meshC->indexOffset = 36;
+	meshC->vertexOffset = 24;
+	meshC->geometries.push_back(CreateGeometry(blended, 0, 0, 6));
+
+	auto sceneGraph = std::make_shared<SceneGraph>();
+	auto root = std::make_shared<SceneGraphNode>();
+	sceneGraph->SetRootNode(root);
+
+	for (const auto& mesh : { meshA, meshB, meshA, meshC, meshB, meshA })
+		sceneGraph->AttachLeafNode(root, std::make_shared<MeshInstance>(mesh));
+	sceneGraph->Refresh(0);
+
+	IndirectDrawList drawList;
+	drawList.Build(sceneGraph->GetMeshInstances());
+
+	const std::vector<IndirectDrawBucket>& buckets = drawList.GetBuckets();
+	const std::vector<IndirectDrawCandidate>& candidates = drawList.GetCandidates();
+
+	// Blended geometries are not drawn by the G-buffer pass
+	CHECK(buckets.size() == 3);
+	CHECK(candidates.size() == 3 * 2 + 2);
+
+	uint32_t nextDraw = 0;
+	for (uint32_t bucketIndex = 0; bucketIndex < buckets.size(); bucketIndex++)
+	{
+		const IndirectDrawBucket& bucket = buckets[bucketIndex];
+		CHECK(bucket.firstDraw == nextDraw);
+		nextDraw += bucket.maxDraws;
+
+		for (uint32_t draw = bucket.firstDraw; draw < bucket.firstDraw + bucket.maxDraws; draw++)
+		{
+			CHECK(candidates[draw].bucket == bucketIndex);
+		}
+
+		CHECK(bucket.cullMode == (bucket.material->doubleSided ? nvrhi::RasterCullMode::None : nvrhi::RasterCullMode::Back));
+
+		if (bucket.buffers == buffersA.get())
+		{
+			CHECK(bucket.maxDraws == 3);
+		}
+		else
+		{
+			CHECK(bucket.maxDraws == 2 && bucket.material == opaque.get());
+		}
+
+		if (bucketIndex > 0)
+		{
+			CHECK(buckets[bucketIndex - 1].buffers != bucket.buffers || buckets[bucketIndex - 1].material != bucket.material);
+		}
+	}
+	CHECK(nextDraw == candidates.size());
+
+	for (const IndirectDrawCandidate& candidate : candidates)
+	{
+		const MeshInstance* instance = sceneGraph->GetMeshInstances()[candidate.instanceIndex].get();
+		const MeshInfo* mesh = instance->GetMesh().get();
+		const IndirectDrawBucket& bucket = buckets[candidate.bucket];
+		CHECK(bucket.buffers == mesh->buffers.get());
+
+		const MeshGeometry* geometry = bucket.material == opaque.get() ? mesh->geometries[0].get() : mesh->geometries[1].get();
+		CHECK(candidate.indexCount == geometry->numIndices);
+		CHECK(candidate.startIndexLocation == mesh->indexOffset + geometry->indexOffsetInMesh);
+		CHECK(candidate.vertexOffset == mesh->vertexOffset + geometry->vertexOffsetInMesh);
+		CHECK(all(candidate.objectSpaceBounds.m_maxs == geometry->objectSpaceBounds.m_maxs));
+	}
+
+	drawList.Build({});
+	CHECK(drawList.GetBuckets().empty());
+	CHECK(drawList.GetCandidates().empty());
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_draw_list_buckets();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
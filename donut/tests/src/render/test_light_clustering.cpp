@@ -0,0 +1,237 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/LightClusteringPass.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+#include <donut/tests/utils.h>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::render;
+
+static const nvrhi::Viewport c_Viewport(100.f, 1380.f, 50.f, 770.f, 0.f, 1.f);
+static const float c_MinDepth = 0.5f;
+static const float c_MaxDepth = 500.f;
+
+static engine::PlanarView MakeView()
+{
+	affine3 cameraToWorld = rotation(normalize(float3(0.2f, 1.f, 0.1f)), 0.7f) * translation(float3(10.f, 2.f, -5.f));
+
+	engine::PlanarView view;
+	view.SetViewport(c_Viewport);
+	view.SetMatrices(inverse(cameraToWorld), perspProjD3DStyleReverse(radians(60.f), c_Viewport.width() / c_Viewport.height(), 0.1f));
+	view.UpdateCache();
+	return view;
+}
+
+// Returns the view space point seen through the given pixel at the given depth
+static float3 GetViewPoint(const engine::IView& view, float2 pixelPosition, float viewDepth)
+{
+	float2 clip = float2(
+		(pixelPosition.x - c_Viewport.minX) / c_Viewport.width() * 2.f - 1.f,
+		1.f - (pixelPosition.y - c_Viewport.minY) / c_Viewport.height() * 2.f);
+
+	float4 point = float4(clip, 0.5f, 1.f) * view.GetInverseProjectionMatrix();
+	float3 direction = point.xyz() / point.z;
+	return direction * viewDepth;
+}
+
+void test_depth_slices()
+{
+	engine::PlanarView view = MakeView();
+	LightClusterGrid grid;
+	grid.Init(view, c_MinDepth, c_MaxDepth);
+
+	CHECK(grid.GetSlice(0.01f) == 0);
+	CHECK(grid.GetSlice(c_MinDepth * 1.01f) == 0);
+	CHECK(grid.GetSlice(c_MaxDepth * 0.99f) == LightClusterGrid::SizeZ - 1);
+	CHECK(grid.GetSlice(1e10f) == LightClusterGrid::SizeZ - 1);
+	CHECK(grid.GetSliceStart(0) == 0.f);
+
+	for (uint32_t slice = 1; slice < LightClusterGrid::SizeZ; slice++)
+	{
+		float start = grid.GetSliceStart(slice);
+		CHECK(fabsf(start - grid.GetSliceEnd(slice - 1)) <= start * 1e-5f);
+		CHECK(grid.GetSlice(start * 1.001f) == slice);
+		CHECK(grid.GetSlice(start * 0.999f) == slice - 1);
+	}
+}
+
+void test_cluster_bounds()
+{
+	engine::PlanarView view = MakeView();
+	LightClusterGrid grid;
+	grid.Init(view, c_MinDepth, c_MaxDepth);
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> pixelX(c_Viewport.minX, c_Viewport.maxX);
+	std::uniform_real_distribution<float> pixelY(c_Viewport.minY, c_Viewport.maxY);
+	std::uniform_real_distribution<float> logDepth(std::log2(0.2f), std::log2(2000.f));
+
+	for (int i = 0; i < 10000; i++)
+	{
+		float2 pixel = float2(pixelX(rng), pixelY(rng));
+		float depth = std::exp2(logDepth(rng));
+		float3 point = GetViewPoint(view, pixel, depth);
+
+		uint32_t index = grid.GetClusterIndex(pixel, depth);
+		uint3 cluster = uint3(index % LightClusterGrid::SizeX, (index / LightClusterGrid::SizeX) % LightClusterGrid::SizeY, index / (LightClusterGrid::SizeX * LightClusterGrid::SizeY));
+		CHECK(cluster.x == uint32_t((pixel.x - c_Viewport.minX) / c_Viewport.width() * LightClusterGrid::SizeX));
+		CHECK(cluster.z == grid.GetSlice(depth));
+
+		box3 bounds = grid.GetClusterBounds(cluster).grow(depth * 1e-4f);
+		CHECK(bounds.contains(point));
+	}
+}
+
+void test_binning()
+{
+	engine::PlanarView view = MakeView();
+	LightClusterGrid grid;
+	grid.Init(view, c_MinDepth, c_MaxDepth);
+
+	const affine3 viewToWorld = view.GetInverseViewMatrix();
+
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	// Lights scattered around the view frustum, including behind the camera
+	std::vector<float4> worldSpheres;
+	for (int i = 0; i < 500; i++)
+	{
+		float3 viewPosition = float3(unit(rng) * 200.f - 100.f, unit(rng) * 100.f - 50.f, unit(rng) * 220.f - 20.f);
+		float range = 0.5f + unit(rng) * 10.f;
+		worldSpheres.push_back(float4(viewToWorld.transformPoint(viewPosition), range));
+	}
+
+	std::vector<float4> viewSpheres;
+	for (const float4& sphere : worldSpheres)
+		viewSpheres.push_back(float4(grid.GetWorldToView().transformPoint(sphere.xyz()), sphere.w));
+
+	std::vector<uint32_t> clusters;
+	grid.BinLights(viewSpheres, clusters);
+	CHECK(clusters.size() == LightClusterGrid::NumClusters * LightClusterGrid::ClusterStride);
+
+	size_t totalLights = 0;
+	for (uint32_t index = 0; index < LightClusterGrid::NumClusters; index++)
+	{
+		const uint32_t* cluster = clusters.data() + index * LightClusterGrid::ClusterStride;
+		CHECK(cluster[0] <= LightClusterGrid::MaxLightsPerCluster);
+		for (uint32_t i = 1; i < cluster[0]; i++)
+			CHECK(cluster[i] < cluster[i + 1]);
+		totalLights += cluster[0];
+	}
+
+	// Culling must be effective: on average, a cluster should see a small fraction of the lights
+	CHECK(totalLights < LightClusterGrid::NumClusters * worldSpheres.size() / 20);
+
+	// Binning must be conservative: every light reaching a visible surface point must be listed in its cluster
+	std::uniform_real_distribution<float> logDepth(std::log2(0.2f), std::log2(250.f));
+	int numLitPoints = 0;
+
+	for (int i = 0; i < 20000; i++)
+	{
+		float2 pixel = float2(
+			c_Viewport.minX + unit(rng) * c_Viewport.width(),
+			c_Viewport.minY + unit(rng) * c_Viewport.height());
+		float depth = std::exp2(logDepth(rng));
+		float3 worldPoint = viewToWorld.transformPoint(GetViewPoint(view, pixel, depth));
+
+		const uint32_t* cluster = clusters.data() + grid.GetClusterIndex(pixel, depth) * LightClusterGrid::ClusterStride;
+		if (cluster[0] == LightClusterGrid::MaxLightsPerCluster)
+			continue;
+
+		for (uint32_t light = 0; light < worldSpheres.size(); light++)
+		{
+			const float4& sphere = worldSpheres[light];
+			if (length(worldPoint - sphere.xyz()) >= sphere.w * 0.999f)
+				continue;
+
+			bool found = false;
+			for (uint32_t i = 1; i <= cluster[0]; i++)
+				found |= cluster[i] == light;
+			CHECK(found);
+			++numLitPoints;
+		}
+	}
+
+	CHECK(numLitPoints > 100);
+}
+
+void test_unbounded_lights()
+{
+	engine::PlanarView view = MakeView();
+	LightClusterGrid grid;
+	grid.Init(view, c_MinDepth, c_MaxDepth);
+
+	engine::DirectionalLight sun;
+	engine::PointLight infinitePoint;
+	engine::PointLight point;
+	point.range = 4.f;
+
+	CHECK(LightClusteringPass::IsClusteredLight(point));
+	point.shadowChannel = 0;
+	CHECK(!LightClusteringPass::IsClusteredLight(point));
+
+	CHECK(LightClusteringPass::GetLightCullingSphere(sun).w < 0.f);
+	CHECK(LightClusteringPass::GetLightCullingSphere(infinitePoint).w < 0.f);
+	CHECK(fabsf(LightClusteringPass::GetLightCullingSphere(point).w - 4.f) < 1e-5f);
+
+	// Every cluster receives the unbounded lights, up to the per-cluster limit
+	std::vector<float4> spheres;
+	spheres.push_back(float4(0.f, 0.f, -1000.f, 0.1f)); // behind the camera
+	for (uint32_t i = 0; i < LightClusterGrid::MaxLightsPerCluster + 10; i++)
+		spheres.push_back(LightClusteringPass::GetLightCullingSphere(sun));
+
+	std::vector<uint32_t> clusters;
+	grid.BinLights(spheres, clusters);
+
+	for (uint32_t index = 0; index < LightClusterGrid::NumClusters; index++)
+	{
+		const uint32_t* cluster = clusters.data() + index * LightClusterGrid::ClusterStride;
+		CHECK(cluster[0] == LightClusterGrid::MaxLightsPerCluster);
+		CHECK(cluster[1] == 1);
+		CHECK(cluster[LightClusterGrid::MaxLightsPerCluster] == LightClusterGrid::MaxLightsPerCluster);
+	}
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_depth_slices();
+		test_cluster_bounds();
+		test_binning();
+		test_unbounded_lights();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
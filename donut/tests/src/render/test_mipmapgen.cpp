@@ -0,0 +1,178 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/MipMapGenPass.h>
+#include <donut/render/GBuffer.h>
+#include <donut/tests/utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::render;
+
+// Builds the reference levels of the single-pass mode, where level 0 is the source
+static std::vector<std::vector<float>> BuildReferenceLevels(MipMapGenPass::Mode mode, const std::vector<float>& source,
+	uint2 sourceSize, uint2 firstLevelSize, uint32_t numLevels, std::vector<uint2>& sizes)
+{
+	std::vector<std::vector<float>> levels = { source };
+	sizes = { sourceSize };
+
+	uint32_t channels = MipMapGenPass::GetNumChannels(mode);
+	uint2 size = firstLevelSize;
+	for (uint32_t level = 0; level < numLevels; ++level)
+	{
+		std::vector<float> destination(size.x * size.y * channels);
+		MipMapGenPass::ReduceReference(mode, levels.back().data(), sizes.back(), destination.data(), size);
+		levels.push_back(std::move(destination));
+		sizes.push_back(size);
+		size = uint2(std::max(size.x / 2, 1u), std::max(size.y / 2, 1u));
+	}
+	return levels;
+}
+
+void test_reduce_modes()
+{
+	CHECK(MipMapGenPass::GetNumChannels(MipMapGenPass::MODE_COLOR) == 4);
+	CHECK(MipMapGenPass::GetNumChannels(MipMapGenPass::MODE_MIN) == 1);
+	CHECK(MipMapGenPass::GetNumChannels(MipMapGenPass::MODE_MAX) == 1);
+	CHECK(MipMapGenPass::GetNumChannels(MipMapGenPass::MODE_MINMAX) == 2);
+
+	const float values[] = { 1.f, 2.f, 3.f, 6.f };
+	float result[2];
+
+	MipMapGenPass::ReduceReference(MipMapGenPass::MODE_MIN, values, uint2(2, 2), result, uint2(1, 1));
+	CHECK(result[0] == 1.f);
+
+	MipMapGenPass::ReduceReference(MipMapGenPass::MODE_MAX, values, uint2(2, 2), result, uint2(1, 1));
+	CHECK(result[0] == 6.f);
+
+	const float colors[] = {
+		1.f, 0.f, 0.f, 1.f,   0.f, 1.f, 0.f, 1.f,
+		0.f, 0.f, 1.f, 1.f,   1.f, 1.f, 1.f, 0.f };
+	float color[4];
+	MipMapGenPass::ReduceReference(MipMapGenPass::MODE_COLOR, colors, uint2(2, 2), color, uint2(1, 1));
+	CHECK(color[0] == 0.5f);
+	CHECK(color[1] == 0.5f);
+	CHECK(color[2] == 0.5f);
+	CHECK(color[3] == 0.75f);
+
+	// Texels past the end of an odd-sized source are clamped to the last row and column
+	const float row[] = { 5.f, 3.f, 1.f };
+	MipMapGenPass::ReduceReference(MipMapGenPass::MODE_MIN, row, uint2(3, 1), result, uint2(2, 1));
+	CHECK(result[0] == 3.f);
+	CHECK(result[1] == 1.f);
+
+	const float pairs[] = { 2.f, 2.f,   4.f, 4.f,   -1.f, -1.f,   3.f, 3.f };
+	MipMapGenPass::ReduceReference(MipMapGenPass::MODE_MINMAX, pairs, uint2(2, 2), result, uint2(1, 1));
+	CHECK(result[0] == -1.f);
+	CHECK(result[1] == 4.f);
+}
+
+void test_single_pass_levels()
+{
+	CHECK(MipMapGenPass::GetMaxSinglePassLevels(uint2(1, 1)) == 1);
+	CHECK(MipMapGenPass::GetMaxSinglePassLevels(uint2(32, 8)) == 6);
+	CHECK(MipMapGenPass::GetMaxSinglePassLevels(uint2(1024, 512)) == 11);
+	CHECK(MipMapGenPass::GetMaxSinglePassLevels(uint2(2048, 2048)) == 12);
+	CHECK(MipMapGenPass::GetMaxSinglePassLevels(uint2(4096, 16)) == 6);
+	CHECK(MipMapGenPass::GetMaxSinglePassLevels(uint2(2047, 1)) == 11);
+}
+
+void test_hiz_pyramid()
+{
+	CHECK(all(GBufferRenderTargets::GetHiZSize(uint2(1920, 1080)) == uint2(1024, 1024)));
+	CHECK(all(GBufferRenderTargets::GetHiZSize(uint2(64, 33)) == uint2(32, 32)));
+	CHECK(all(GBufferRenderTargets::GetHiZSize(uint2(1, 2)) == uint2(1, 1)));
+
+	const uint2 depthSize = uint2(75, 37);
+	const uint2 hiZSize = GBufferRenderTargets::GetHiZSize(depthSize);
+	const uint32_t numLevels = MipMapGenPass::GetMaxSinglePassLevels(hiZSize);
+	CHECK(numLevels == 7);
+
+	// MODE_MINMAX reads R from the depth buffer into both channels
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> distribution(0.f, 1.f);
+	std::vector<float> depth(depthSize.x * depthSize.y * 2);
+	for (size_t pixel = 0; pixel < depth.size(); pixel += 2)
+		depth[pixel] = depth[pixel + 1] = distribution(random);
+
+	std::vector<uint2> sizes;
+	std::vector<std::vector<float>> levels = BuildReferenceLevels(MipMapGenPass::MODE_MINMAX, depth, depthSize, hiZSize, numLevels, sizes);
+
+	// Every texel of level L of the pyramid must contain the exact min and max of its footprint
+	// of 2^(L+1) pixels in the depth buffer, so that HiZ tests are conservative
+	for (uint32_t level = 0; level < numLevels; ++level)
+	{
+		const uint2 size = sizes[level + 1];
+		const uint footprint = 2u << level;
+
+		for (uint y = 0; y < size.y; ++y)
+		{
+			for (uint x = 0; x < size.x; ++x)
+			{
+				// Texels that are entirely outside of the depth buffer replicate the edge
+				if (x * footprint >= depthSize.x || y * footprint >= depthSize.y)
+					continue;
+
+				float minDepth = 1.f;
+				float maxDepth = 0.f;
+				for (uint py = y * footprint; py < std::min((y + 1) * footprint, depthSize.y); ++py)
+				{
+					for (uint px = x * footprint; px < std::min((x + 1) * footprint, depthSize.x); ++px)
+					{
+						minDepth = std::min(minDepth, depth[(py * depthSize.x + px) * 2]);
+						maxDepth = std::max(maxDepth, depth[(py * depthSize.x + px) * 2]);
+					}
+				}
+
+				const float* texel = &levels[level + 1][(y * size.x + x) * 2];
+				CHECK(texel[0] == minDepth);
+				CHECK(texel[1] == maxDepth);
+			}
+		}
+	}
+
+	const float* top = levels.back().data();
+	CHECK(all(sizes.back() == uint2(1, 1)));
+	CHECK(top[0] == *std::min_element(depth.begin(), depth.end()));
+	CHECK(top[1] == *std::max_element(depth.begin(), depth.end()));
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_reduce_modes();
+		test_single_pass_levels();
+		test_hiz_pyramid();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,294 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/OcclusionCuller.h>
+#include <donut/render/DrawStrategy.h>
+#include <donut/render/GeometryPasses.h>
+#include <donut/engine/Scene.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/ShaderFactory.h>
+#include <donut/engine/TextureCache.h>
+#include <donut/engine/View.h>
+#include <donut/core/vfs/VFS.h>
+#include <donut/tests/null_device.h>
+#include <donut/tests/utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+// A 10x10 square facing the camera at the origin, in the XY plane
+static const float3 c_WallPositions[] = {
+	float3(-5.f, -5.f, 0.f), float3(5.f, -5.f, 0.f), float3(5.f, 5.f, 0.f), float3(-5.f, 5.f, 0.f)
+};
+static const uint32_t c_WallIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+// The camera is at the origin looking down +Z
+static PlanarView MakeView(bool reverseDepth)
+{
+	float4x4 projection = reverseDepth
+		? perspProjD3DStyleReverse(radians(60.f), 2.f, 0.1f)
+		: perspProjD3DStyle(radians(60.f), 2.f, 0.1f, 1000.f);
+
+	PlanarView view;
+	view.SetViewport(nvrhi::Viewport(1024.f, 512.f));
+	view.SetMatrices(affine3::identity(), projection);
+	view.UpdateCache();
+	return view;
+}
+
+void test_box_visibility(bool reverseDepth)
+{
+	PlanarView view = MakeView(reverseDepth);
+
+	OcclusionCuller culler;
+	culler.BeginView(view.GetViewProjectionMatrix(true), view.IsReverseDepth());
+
+	// Nothing is occluded before the occluders are rasterized
+	CHECK(culler.IsBoxVisible(box3(float3(-1.f, -1.f, 20.f), float3(1.f, 1.f, 22.f))));
+
+	culler.RasterizeOccluder(c_WallPositions, c_WallIndices, 6, translation(float3(0.f, 0.f, 10.f)));
+	CHECK(culler.GetStatistics().numOccluderTriangles == 2);
+	CHECK(culler.GetStatistics().numRasterizedTriangles == 2);
+
+	// Behind the wall
+	CHECK(!culler.IsBoxVisible(box3(float3(-1.f, -1.f, 20.f), float3(1.f, 1.f, 22.f))));
+	CHECK(!culler.IsBoxVisible(box3(float3(-0.1f, -0.1f, 500.f), float3(0.1f, 0.1f, 501.f))));
+
+	// In front of the wall
+	CHECK(culler.IsBoxVisible(box3(float3(-1.f, -1.f, 5.f), float3(1.f, 1.f, 6.f))));
+
+	// Intersecting the wall
+	CHECK(culler.IsBoxVisible(box3(float3(-1.f, -1.f, 9.f), float3(1.f, 1.f, 11.f))));
+
+	// Behind the wall but sticking out of it on the screen
+	CHECK(culler.IsBoxVisible(box3(float3(8.f, -1.f, 20.f), float3(12.f, 1.f, 22.f))));
+
+	// Crossing the near plane
+	CHECK(culler.IsBoxVisible(box3(float3(-1.f, -1.f, -1.f), float3(1.f, 1.f, 22.f))));
+
+	// Outside of the viewport
+	CHECK(!culler.IsBoxVisible(box3(float3(100.f, -1.f, 20.f), float3(102.f, 1.f, 22.f))));
+
+	CHECK(culler.GetStatistics().numTests == 8);
+	CHECK(culler.GetStatistics().numOccluded == 2);
+
+	// Occluders are double sided
+	culler.BeginView(view.GetViewProjectionMatrix(true), view.IsReverseDepth());
+	culler.RasterizeOccluder(c_WallPositions, c_WallIndices, 6, rotation(float3(0.f, 1.f, 0.f), PI_f) * translation(float3(0.f, 0.f, 10.f)));
+	CHECK(!culler.IsBoxVisible(box3(float3(-1.f, -1.f, 20.f), float3(1.f, 1.f, 22.f))));
+}
+
+void test_near_plane_clipping()
+{
+	PlanarView view = MakeView(true);
+
+	OcclusionCuller culler;
+	culler.BeginView(view.GetViewProjectionMatrix(true), view.IsReverseDepth());
+
+	// A floor that starts behind the camera and extends far in front of it
+	affine3 floorTransform = rotation(float3(1.f, 0.f, 0.f), radians(90.f)) * scaling(float3(20.f)) * translation(float3(0.f, -1.f, 90.f));
+	culler.RasterizeOccluder(c_WallPositions, c_WallIndices, 6, floorTransform);
+	CHECK(culler.GetStatistics().numRasterizedTriangles >= 2);
+
+	// Under the floor
+	CHECK(!culler.IsBoxVisible(box3(float3(-1.f, -5.f, 20.f), float3(1.f, -3.f, 22.f))));
+
+	// Above the floor
+	CHECK(culler.IsBoxVisible(box3(float3(-1.f, 3.f, 20.f), float3(1.f, 5.f, 22.f))));
+}
+
+static std::shared_ptr<MeshInfo> CreateWallMesh(const std::shared_ptr<Material>& material)
+{
+	auto buffers = std::make_shared<BufferGroup>();
+	buffers->positionData.assign(std::begin(c_WallPositions), std::end(c_WallPositions));
+	buffers->indexData.assign(std::begin(c_WallIndices), std::end(c_WallIndices));
+
+	auto geometry = std::make_shared<MeshGeometry>();
+	geometry->material = material;
+	geometry->numIndices = 6;
+	geometry->numVertices = 4;
+	geometry->objectSpaceBounds = box3(c_WallPositions[0], c_WallPositions[2]);
+
+	auto mesh = std::make_shared<MeshInfo>();
+	mesh->buffers = buffers;
+	mesh->geometries.push_back(geometry);
+	mesh->objectSpaceBounds = geometry->objectSpaceBounds;
+	mesh->totalIndices = 6;
+	mesh->totalVertices = 4;
+	return mesh;
+}
+
+void test_draw_strategy()
+{
+	PlanarView view = MakeView(true);
+
+	auto material = std::make_shared<Material>();
+	auto mesh = CreateWallMesh(material);
+
+	auto sceneGraph = std::make_shared<SceneGraph>();
+	auto root = std::make_shared<SceneGraphNode>();
+	sceneGraph->SetRootNode(root);
+
+	auto addInstance = [&](const double3& position)
+	{
+		auto instance = std::make_shared<MeshInstance>(mesh);
+		sceneGraph->AttachLeafNode(root, instance)->SetTranslation(position);
+		return instance.get();
+	};
+
+	MeshInstance* wall = addInstance(double3(0.0, 0.0, 10.0));
+	MeshInstance* hidden = addInstance(double3(0.0, 0.0, 30.0));
+	MeshInstance* visible = addInstance(double3(20.0, 0.0, 30.0));
+	sceneGraph->Refresh(0);
+
+	auto collectInstances = [&](InstancedOpaqueDrawStrategy& strategy)
+	{
+		std::vector<const MeshInstance*> instances;
+		strategy.PrepareForView(root, view);
+		while (const DrawItem* item = strategy.GetNextItem())
+			instances.push_back(item->instance);
+		return instances;
+	};
+
+	auto contains = [](const std::vector<const MeshInstance*>& instances, const MeshInstance* instance)
+	{
+		return std::find(instances.begin(), instances.end(), instance) != instances.end();
+	};
+
+	InstancedOpaqueDrawStrategy strategy;
+	std::vector<const MeshInstance*> instances = collectInstances(strategy);
+	CHECK(instances.size() == 3);
+
+	auto culler = std::make_shared<OcclusionCuller>();
+	strategy.SetOcclusionCuller(culler);
+	instances = collectInstances(strategy);
+	CHECK(instances.size() == 2);
+	CHECK(contains(instances, wall));
+	CHECK(contains(instances, visible));
+	CHECK(!contains(instances, hidden));
+	CHECK(culler->GetStatistics().numOccluders >= 1);
+	CHECK(culler->GetStatistics().numOccluded >= 1);
+
+	// Alpha tested geometry is not used as an occluder
+	material->domain = MaterialDomain::AlphaTested;
+	sceneGraph->Refresh(1);
+	instances = collectInstances(strategy);
+	CHECK(instances.size() == 3);
+	CHECK(culler->GetStatistics().numOccluders == 0);
+}
+
+// The wall mesh with one instance in front of the camera and one hidden behind it
+static const char* c_WallSceneGltf = R"({
+	"asset": { "version": "2.0" },
+	"scene": 0,
+	"scenes": [ { "nodes": [ 0, 1 ] } ],
+	"nodes": [
+		{ "mesh": 0, "translation": [ 0, 0, 10 ] },
+		{ "mesh": 0, "translation": [ 0, 0, 30 ] }
+	],
+	"materials": [ { "pbrMetallicRoughness": { "baseColorFactor": [ 1, 1, 1, 1 ] } } ],
+	"meshes": [ { "primitives": [ { "attributes": { "POSITION": 0 }, "indices": 1, "material": 0 } ] } ],
+	"buffers": [ { "uri": "donut_test_occluder_scene.bin", "byteLength": 72 } ],
+	"bufferViews": [
+		{ "buffer": 0, "byteOffset": 0, "byteLength": 48 },
+		{ "buffer": 0, "byteOffset": 48, "byteLength": 24 }
+	],
+	"accessors": [
+		{ "bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3", "min": [ -5, -5, 0 ], "max": [ 5, 5, 0 ] },
+		{ "bufferView": 1, "componentType": 5125, "count": 6, "type": "SCALAR" }
+	]
+})";
+
+// Occluders picked by PrepareForView need the CPU copies of the geometry that a loaded Scene releases by default
+void test_scene_occluders(bool retainCpuGeometry)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	auto fs = std::make_shared<vfs::NativeFileSystem>();
+
+	std::vector<uint8_t> bufferData(sizeof(c_WallPositions) + sizeof(c_WallIndices));
+	memcpy(bufferData.data(), c_WallPositions, sizeof(c_WallPositions));
+	memcpy(bufferData.data() + sizeof(c_WallPositions), c_WallIndices, sizeof(c_WallIndices));
+	CHECK(fs->writeFile(directory / "donut_test_occluder_scene.bin", bufferData.data(), bufferData.size()));
+	CHECK(fs->writeFile(directory / "donut_test_occluder_scene.gltf", c_WallSceneGltf, strlen(c_WallSceneGltf)));
+
+	nvrhi::RefCountPtr<tests::NullDevice> device = nvrhi::RefCountPtr<tests::NullDevice>::Create(new tests::NullDevice());
+	ShaderFactory shaderFactory(device, nullptr, "");
+	auto textureCache = std::make_shared<TextureCache>(device, fs, nullptr);
+
+	Scene scene(device, shaderFactory, fs, textureCache, nullptr, nullptr);
+	scene.SetCpuGeometryRetained(retainCpuGeometry);
+	CHECK(scene.Load(directory / "donut_test_occluder_scene.gltf"));
+	scene.FinishedLoading(0);
+
+	const auto& meshes = scene.GetSceneGraph()->GetMeshes();
+	CHECK(meshes.size() == 1);
+	{
+		const BufferGroup& buffers = *(*meshes.begin())->buffers;
+		CHECK(buffers.indexBuffer && buffers.vertexBuffer);
+		CHECK(buffers.positionData.size() == (retainCpuGeometry ? 4 : 0));
+		CHECK(buffers.indexData.size() == (retainCpuGeometry ? 6 : 0));
+	}
+
+	PlanarView view = MakeView(true);
+	OcclusionCuller culler;
+	culler.PrepareForView(scene.GetSceneGraph()->GetRootNode(), view);
+
+	const box3 hiddenBounds = box3(float3(-1.f, -1.f, 20.f), float3(1.f, 1.f, 22.f));
+	if (retainCpuGeometry)
+	{
+		CHECK(culler.GetStatistics().numOccluders >= 1);
+		CHECK(!culler.IsBoxVisible(hiddenBounds));
+	}
+	else
+	{
+		CHECK(culler.GetStatistics().numOccluders == 0);
+		CHECK(culler.IsBoxVisible(hiddenBounds));
+	}
+
+	std::filesystem::remove(directory / "donut_test_occluder_scene.gltf");
+	std::filesystem::remove(directory / "donut_test_occluder_scene.bin");
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_box_visibility(true);
+		test_box_visibility(false);
+		test_near_plane_clipping();
+		test_draw_strategy();
+		test_scene_occluders(false);
+		test_scene_occluders(true);
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
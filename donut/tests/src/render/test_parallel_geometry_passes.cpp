@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <donut/render/ParallelGeometryPasses.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::render;
+
+// Checks that the slices cover every item of every view exactly once, in order
+static void CheckCoverage(const std::vector<size_t>& itemCounts, const std::vector<DrawListSlice>& slices)
+{
+	std::vector<size_t> covered(itemCounts.size(), 0);
+	for (const DrawListSlice& slice : slices)
+	{
+		CHECK(slice.viewIndex < itemCounts.size());
+		CHECK(slice.numItems > 0);
+		CHECK(slice.firstItem == covered[slice.viewIndex]);
+		covered[slice.viewIndex] += slice.numItems;
+	}
+
+	for (size_t viewIndex = 0; viewIndex < itemCounts.size(); viewIndex++)
+		CHECK(covered[viewIndex] == itemCounts[viewIndex]);
+
+	for (size_t index = 1; index < slices.size(); index++)
+		CHECK(slices[index - 1].viewIndex <= slices[index].viewIndex);
+}
+
+void test_single_view()
+{
+	std::vector<DrawListSlice> slices;
+
+	std::vector<size_t> counts = { 1000 };
+	SplitDrawLists(counts, 4, 100, slices);
+	CHECK(slices.size() == 4);
+	CheckCoverage(counts, slices);
+	CHECK(slices[0].numItems == 250 && slices[3].numItems == 250);
+
+	// Slices are never shorter than the minimum
+	SplitDrawLists(counts, 16, 300, slices);
+	CHECK(slices.size() == 3);
+	CheckCoverage(counts, slices);
+
+	// A short list still gets one slice
+	counts = { 10 };
+	SplitDrawLists(counts, 8, 100, slices);
+	CHECK(slices.size() == 1);
+	CheckCoverage(counts, slices);
+
+	// Uneven split
+	counts = { 1001 };
+	SplitDrawLists(counts, 3, 1, slices);
+	CHECK(slices.size() == 3);
+	CheckCoverage(counts, slices);
+}
+
+void test_multiple_views()
+{
+	std::vector<DrawListSlice> slices;
+
+	// Shadow cascades: the extra slices go to the views with the most items
+	std::vector<size_t> counts = { 4000, 2000, 1000, 1000 };
+	SplitDrawLists(counts, 8, 100, slices);
+	CHECK(slices.size() == 8);
+	CheckCoverage(counts, slices);
+
+	uint32_t slicesPerView[4] = {};
+	for (const DrawListSlice& slice : slices)
+		++slicesPerView[slice.viewIndex];
+	CHECK(slicesPerView[0] == 4 && slicesPerView[1] == 2 && slicesPerView[2] == 1 && slicesPerView[3] == 1);
+
+	// Empty views produce no slices, and every non-empty view gets one even if that exceeds the limit
+	counts = { 0, 50, 0, 50, 50 };
+	SplitDrawLists(counts, 2, 10, slices);
+	CHECK(slices.size() == 3);
+	CheckCoverage(counts, slices);
+	CHECK(slices[0].viewIndex == 1 && slices[1].viewIndex == 3 && slices[2].viewIndex == 4);
+
+	counts = { 0, 0 };
+	SplitDrawLists(counts, 4, 10, slices);
+	CHECK(slices.empty());
+
+	counts.clear();
+	SplitDrawLists(counts, 4, 10, slices);
+	CHECK(slices.empty());
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_single_view();
+		test_multiple_views();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
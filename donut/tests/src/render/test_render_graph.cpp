@@ -0,0 +1,293 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/RenderGraph.h>
+#include <donut/tests/null_device.h>
+#include <donut/tests/utils.h>
+#include <nvrhi/common/misc.h>
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::render;
+
+static nvrhi::TextureDesc MakeDesc(const char* name, uint32_t width, uint32_t height, nvrhi::Format format)
+{
+	nvrhi::TextureDesc desc;
+	desc.width = width;
+	desc.height = height;
+	desc.format = format;
+	desc.isRenderTarget = true;
+	desc.debugName = name;
+	return desc;
+}
+
+static bool AllocationsOverlap(const RenderGraphAllocation& a, const RenderGraphAllocation& b)
+{
+	bool timeOverlap = a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+	bool memoryOverlap = a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+	return timeOverlap && memoryOverlap;
+}
+
+void test_memory_estimate()
+{
+	auto requirements = RenderGraph::EstimateTextureMemoryRequirements(MakeDesc("", 256, 256, nvrhi::Format::RGBA8_UNORM));
+	CHECK(requirements.size == 256 * 256 * 4);
+	CHECK(requirements.alignment == 64 * 1024);
+
+	// Sizes are rounded up to the alignment
+	requirements = RenderGraph::EstimateTextureMemoryRequirements(MakeDesc("", 10, 10, nvrhi::Format::R8_UNORM));
+	CHECK(requirements.size == 64 * 1024);
+
+	auto desc = MakeDesc("", 512, 512, nvrhi::Format::BC1_UNORM);
+	desc.mipLevels = 2;
+	requirements = RenderGraph::EstimateTextureMemoryRequirements(desc);
+	CHECK(requirements.size == nvrhi::align<uint64_t>(128 * 128 * 8 + 64 * 64 * 8, 64 * 1024));
+}
+
+void test_culling()
+{
+	RenderGraph graph;
+
+	auto a = graph.CreateTexture(MakeDesc("A", 64, 64, nvrhi::Format::RGBA8_UNORM));
+	auto b = graph.CreateTexture(MakeDesc("B", 64, 64, nvrhi::Format::RGBA8_UNORM));
+	auto unused = graph.CreateTexture(MakeDesc("Unused", 64, 64, nvrhi::Format::RGBA8_UNORM));
+
+	auto output = graph.CreateTexture(MakeDesc("Output", 64, 64, nvrhi::Format::RGBA8_UNORM));
+
+	uint32_t writeA = graph.AddPass("WriteA", nullptr).Write(a).GetPassIndex();
+	uint32_t overwriteA = graph.AddPass("OverwriteA", nullptr).Write(a).GetPassIndex();
+	uint32_t blendA = graph.AddPass("BlendA", nullptr).Modify(a).GetPassIndex();
+	uint32_t writeUnused = graph.AddPass("WriteUnused", nullptr).Read(a).Write(unused).GetPassIndex();
+	uint32_t writeB = graph.AddPass("WriteB", nullptr).Read(a).Write(b).GetPassIndex();
+	uint32_t present = graph.AddPass("Present", nullptr).Read(b).Write(output).SetSideEffects().GetPassIndex();
+	uint32_t sideEffect = graph.AddPass("Readback", nullptr).Read(b, nvrhi::ResourceStates::CopySource).SetSideEffects().GetPassIndex();
+
+	CHECK(graph.Compile(nullptr));
+
+	// WriteA is overwritten by OverwriteA before anyone reads it
+	CHECK(graph.IsPassCulled(writeA));
+	CHECK(!graph.IsPassCulled(overwriteA));
+	CHECK(!graph.IsPassCulled(blendA));
+	CHECK(graph.IsPassCulled(writeUnused));
+	CHECK(!graph.IsPassCulled(writeB));
+	CHECK(!graph.IsPassCulled(present));
+	CHECK(!graph.IsPassCulled(sideEffect));
+
+	const RenderGraphStats& stats = graph.GetStats();
+	CHECK(stats.numPasses == 7);
+	CHECK(stats.numCulledPasses == 2);
+	CHECK(stats.numTransientTextures == 3);
+	CHECK(graph.GetTransientAllocation(unused) == nullptr);
+
+	const RenderGraphAllocation* allocA = graph.GetTransientAllocation(a);
+	CHECK(allocA && allocA->firstPass == overwriteA && allocA->lastPass == writeB);
+}
+
+void test_barriers()
+{
+	RenderGraph graph;
+
+	auto color = graph.CreateTexture(MakeDesc("Color", 64, 64, nvrhi::Format::RGBA16_FLOAT));
+	auto depth = graph.CreateTexture(MakeDesc("Depth", 64, 64, nvrhi::Format::D32));
+	auto result = graph.CreateTexture(MakeDesc("Result", 64, 64, nvrhi::Format::RGBA8_UNORM));
+
+	uint32_t gbuffer = graph.AddPass("GBuffer", nullptr)
+		.Write(color)
+		.Write(depth, nvrhi::ResourceStates::DepthWrite)
+		.GetPassIndex();
+	uint32_t lighting = graph.AddPass("Lighting", nullptr)
+		.Read(color)
+		.Read(depth)
+		.Write(result, nvrhi::ResourceStates::UnorderedAccess)
+		.GetPassIndex();
+	uint32_t post = graph.AddPass("Post", nullptr)
+		.Modify(result, nvrhi::ResourceStates::UnorderedAccess)
+		.SetSideEffects()
+		.GetPassIndex();
+
+	CHECK(graph.Compile(nullptr));
+
+	// Transient textures start in the state of their first use
+	CHECK(graph.GetPassBarriers(gbuffer).empty());
+	CHECK(graph.GetPassBarriers(post).empty());
+
+	const auto& barriers = graph.GetPassBarriers(lighting);
+	CHECK(barriers.size() == 2);
+	CHECK(barriers[0].texture == color);
+	CHECK(barriers[0].stateBefore == nvrhi::ResourceStates::RenderTarget);
+	CHECK(barriers[0].stateAfter == nvrhi::ResourceStates::ShaderResource);
+	CHECK(barriers[1].texture == depth);
+	CHECK(barriers[1].stateBefore == nvrhi::ResourceStates::DepthWrite);
+
+	CHECK(graph.GetStats().numBarrierBatches == 1);
+	CHECK(graph.GetStats().numBarriers == 2);
+}
+
+void test_aliasing()
+{
+	RenderGraph graph;
+
+	// A typical deferred frame at 1920x1080
+	auto albedo = graph.CreateTexture(MakeDesc("Albedo", 1920, 1080, nvrhi::Format::SRGBA8_UNORM));
+	auto normals = graph.CreateTexture(MakeDesc("Normals", 1920, 1080, nvrhi::Format::RGBA16_FLOAT));
+	auto depth = graph.CreateTexture(MakeDesc("Depth", 1920, 1080, nvrhi::Format::D32));
+	auto ao = graph.CreateTexture(MakeDesc("AO", 1920, 1080, nvrhi::Format::R8_UNORM));
+	auto hdr = graph.CreateTexture(MakeDesc("HDR", 1920, 1080, nvrhi::Format::RGBA16_FLOAT));
+	auto bloom = graph.CreateTexture(MakeDesc("Bloom", 960, 540, nvrhi::Format::RGBA16_FLOAT));
+	auto ldr = graph.CreateTexture(MakeDesc("LDR", 1920, 1080, nvrhi::Format::RGBA8_UNORM));
+
+	graph.AddPass("GBuffer", nullptr).Write(albedo).Write(normals).Write(depth, nvrhi::ResourceStates::DepthWrite);
+	graph.AddPass("SSAO", nullptr).Read(normals).Read(depth).Write(ao, nvrhi::ResourceStates::UnorderedAccess);
+	graph.AddPass("Lighting", nullptr).Read(albedo).Read(normals).Read(ao).Write(hdr);
+	graph.AddPass("Sky", nullptr).Read(depth).Modify(hdr);
+	graph.AddPass("Bloom", nullptr).Read(hdr).Write(bloom);
+	graph.AddPass("ToneMapping", nullptr).Read(hdr).Read(bloom).Write(ldr);
+	graph.AddPass("Present", nullptr).Read(ldr).SetSideEffects();
+
+	CHECK(graph.Compile(nullptr));
+
+	const RenderGraphStats& stats = graph.GetStats();
+	CHECK(stats.numCulledPasses == 0);
+	CHECK(stats.numTransientTextures == 7);
+	CHECK(stats.transientMemoryWithAliasing < stats.transientMemoryWithoutAliasing);
+	CHECK(stats.GetTransientMemorySaved() > 0);
+
+	printf("Transient memory: %llu bytes without aliasing, %llu bytes with aliasing\n",
+		(unsigned long long)stats.transientMemoryWithoutAliasing, (unsigned long long)stats.transientMemoryWithAliasing);
+
+	// LDR is only alive after the G-buffer is dead, so it must share memory with one of the G-buffer textures
+	const RenderGraphAllocation* ldrAlloc = graph.GetTransientAllocation(ldr);
+	CHECK(ldrAlloc);
+	bool ldrAliased = false;
+	for (auto texture : { albedo, normals, depth, ao })
+	{
+		const RenderGraphAllocation* other = graph.GetTransientAllocation(texture);
+		if (ldrAlloc->offset < other->offset + other->size && other->offset < ldrAlloc->offset + ldrAlloc->size)
+			ldrAliased = true;
+	}
+	CHECK(ldrAliased);
+
+	// No two textures with overlapping lifetimes may overlap in memory
+	const RenderGraphTexture textures[] = { albedo, normals, depth, ao, hdr, bloom, ldr };
+	for (auto first : textures)
+	{
+		for (auto second : textures)
+		{
+			if (first == second)
+				continue;
+			CHECK(!AllocationsOverlap(*graph.GetTransientAllocation(first), *graph.GetTransientAllocation(second)));
+		}
+		CHECK(graph.GetTransientAllocation(first)->offset + graph.GetTransientAllocation(first)->size <= stats.transientMemoryWithAliasing);
+	}
+
+	// Rebuilding the graph after Reset produces the same layout
+	uint64_t heapSize = stats.transientMemoryWithAliasing;
+	graph.Reset();
+	CHECK(graph.GetNumPasses() == 0);
+	CHECK(graph.GetStats().transientMemoryWithAliasing == 0);
+	auto single = graph.CreateTexture(MakeDesc("Single", 1920, 1080, nvrhi::Format::RGBA16_FLOAT));
+	graph.AddPass("Single", nullptr).Write(single).SetSideEffects();
+	CHECK(graph.Compile(nullptr));
+	CHECK(graph.GetStats().transientMemoryWithAliasing < heapSize);
+	CHECK(graph.GetStats().GetTransientMemorySaved() == 0);
+}
+
+class ClearRecordingCommandList : public tests::NullCommandList
+{
+public:
+	std::vector<nvrhi::ITexture*> clearedTextures;
+
+	ClearRecordingCommandList() : NullCommandList(nullptr, nvrhi::CommandListParameters()) { }
+
+	void clearTextureFloat(nvrhi::ITexture* t, nvrhi::TextureSubresourceSet, const nvrhi::Color&) override { clearedTextures.push_back(t); }
+	void clearDepthStencilTexture(nvrhi::ITexture* t, nvrhi::TextureSubresourceSet, bool, float, bool, uint8_t) override { clearedTextures.push_back(t); }
+};
+
+void test_clears(bool aliasingSupported)
+{
+	nvrhi::RefCountPtr<tests::NullDevice> device = nvrhi::RefCountPtr<tests::NullDevice>::Create(new tests::NullDevice());
+	if (aliasingSupported)
+		device->supportedFeatures.push_back(nvrhi::Feature::VirtualResources);
+
+	RenderGraph graph;
+
+	auto color = graph.CreateTexture(MakeDesc("Color", 64, 64, nvrhi::Format::RGBA8_UNORM));
+	auto depth = graph.CreateTexture(MakeDesc("Depth", 64, 64, nvrhi::Format::D32));
+	auto clearDesc = MakeDesc("Cleared", 64, 64, nvrhi::Format::RGBA8_UNORM);
+	clearDesc.setClearValue(nvrhi::Color(1.f));
+	auto cleared = graph.CreateTexture(clearDesc);
+	auto storageDesc = MakeDesc("Storage", 64, 64, nvrhi::Format::R32_FLOAT);
+	storageDesc.isRenderTarget = false;
+	storageDesc.isUAV = true;
+	auto storage = graph.CreateTexture(storageDesc);
+
+	graph.AddPass("Draw", nullptr).Write(color).Write(depth, nvrhi::ResourceStates::DepthWrite).Write(cleared);
+	graph.AddPass("Compute", nullptr).Read(color).Read(depth).Read(cleared).Write(storage, nvrhi::ResourceStates::UnorderedAccess);
+	graph.AddPass("Present", nullptr).Read(storage).SetSideEffects();
+
+	CHECK(graph.Compile(device));
+
+	// Render targets placed in the shared heap must be initialized even without a clear value,
+	// storage textures only need the first write
+	ClearRecordingCommandList commandList;
+	graph.Execute(&commandList);
+
+	auto isCleared = [&graph, &commandList](RenderGraphTexture texture)
+	{
+		return std::find(commandList.clearedTextures.begin(), commandList.clearedTextures.end(), graph.GetTexture(texture)) != commandList.clearedTextures.end();
+	};
+
+	CHECK(isCleared(cleared));
+	CHECK(isCleared(color) == aliasingSupported);
+	CHECK(isCleared(depth) == aliasingSupported);
+	CHECK(!isCleared(storage));
+	CHECK(graph.GetStats().numClears == commandList.clearedTextures.size());
+
+	// Executing the passes one by one clears the same textures, each before its first pass
+	ClearRecordingCommandList perPassCommandList;
+	graph.ExecutePass(&perPassCommandList, 0);
+	CHECK(perPassCommandList.clearedTextures.size() == (aliasingSupported ? 3u : 1u));
+	graph.ExecutePass(&perPassCommandList, 1);
+	graph.ExecutePass(&perPassCommandList, 2);
+	CHECK(perPassCommandList.clearedTextures == commandList.clearedTextures);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_memory_estimate();
+		test_culling();
+		test_barriers();
+		test_aliasing();
+		test_clears(false);
+		test_clears(true);
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
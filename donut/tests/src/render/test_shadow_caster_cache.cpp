@@ -0,0 +1,163 @@
+/*
+* Copyright (c) 2014-2024, NVIDIA CORPORATION. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+* DEALINGS IN THE SOFTWARE.
+*/
+
+#include <donut/render/ShadowCasterCache.h>
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+#include <donut/tests/utils.h>
+
+#include <cstdio>
+
+using namespace donut;
+using namespace donut::math;
+using namespace donut::engine;
+using namespace donut::render;
+
+static std::shared_ptr<PlanarView> CreateShadowView(float3 center)
+{
+	// Looking down the Z axis from above the center, covering 10x10 units
+	auto view = std::make_shared<PlanarView>();
+	view->SetViewport(nvrhi::Viewport(256.f, 256.f));
+	view->SetMatrices(translation(-center), orthoProjD3DStyle(-5.f, 5.f, -5.f, 5.f, -10.f, 10.f));
+	view->UpdateCache();
+	return view;
+}
+
+void test_caster_classification()
+{
+	auto material = std::make_shared<Material>();
+
+	auto mesh = std::make_shared<MeshInfo>();
+	mesh->objectSpaceBounds = box3(float3(-0.5f), float3(0.5f));
+	auto geometry = std::make_shared<MeshGeometry>();
+	geometry->material = material;
+	geometry->numIndices = 36;
+	mesh->geometries.push_back(geometry);
+
+	auto sceneGraph = std::make_shared<SceneGraph>();
+	auto root = std::make_shared<SceneGraphNode>();
+	sceneGraph->SetRootNode(root);
+
+	auto staticInstance = std::make_shared<MeshInstance>(mesh);
+	auto movingInstance = std::make_shared<MeshInstance>(mesh);
+	sceneGraph->AttachLeafNode(root, staticInstance);
+	std::shared_ptr<SceneGraphNode> movingNode = sceneGraph->AttachLeafNode(root, movingInstance);
+	movingNode->SetTranslation(double3(2.0, 0.0, 0.0));
+
+	std::shared_ptr<PlanarView> nearView = CreateShadowView(float3(0.f));
+	std::shared_ptr<PlanarView> farView = CreateShadowView(float3(100.f, 0.f, 0.f));
+	const std::vector<const IView*> views = { nearView.get(), farView.get() };
+
+	ShadowCasterCache cache;
+	cache.SetDynamicFrames(3);
+
+	uint32_t frameIndex = 0;
+	auto update = [&]()
+	{
+		sceneGraph->Refresh(frameIndex);
+		cache.Update(*sceneGraph, views, frameIndex);
+		++frameIndex;
+	};
+
+	// The first frame renders everything, and newly added instances are static
+	update();
+	CHECK(cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(0).renderDynamic);
+	CHECK(!cache.GetViewUpdate(0).hasDynamicCasters);
+	CHECK(cache.GetViewUpdate(1).renderStatic);
+	CHECK(!cache.IsInstanceDynamic(*movingInstance));
+
+	// Nothing changes
+	update();
+	CHECK(!cache.GetViewUpdate(0).renderStatic);
+	CHECK(!cache.GetViewUpdate(0).renderDynamic);
+	CHECK(!cache.GetViewUpdate(1).renderStatic);
+	CHECK(!cache.GetViewUpdate(1).renderDynamic);
+
+	// A caster starts moving: it's removed from the static layer of the view that covers it
+	movingNode->SetTranslation(double3(2.0, 1.0, 0.0));
+	update();
+	CHECK(cache.IsInstanceDynamic(*movingInstance));
+	CHECK(!cache.IsInstanceDynamic(*staticInstance));
+	CHECK(cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(0).hasDynamicCasters);
+	CHECK(!cache.GetViewUpdate(1).renderStatic);
+	CHECK(!cache.GetViewUpdate(1).renderDynamic);
+
+	// It keeps moving: only the dynamic casters are drawn
+	movingNode->SetTranslation(double3(2.0, 2.0, 0.0));
+	update();
+	CHECK(!cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(0).renderDynamic);
+	CHECK(cache.GetViewUpdate(0).hasDynamicCasters);
+
+	// Once it has stopped for long enough, it's baked into the static layer again
+	update();
+	update();
+	CHECK(cache.IsInstanceDynamic(*movingInstance));
+	CHECK(!cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(0).renderDynamic);
+
+	update();
+	CHECK(!cache.IsInstanceDynamic(*movingInstance));
+	CHECK(cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(0).renderDynamic);
+	CHECK(!cache.GetViewUpdate(0).hasDynamicCasters);
+
+	update();
+	CHECK(!cache.GetViewUpdate(0).renderStatic);
+	CHECK(!cache.GetViewUpdate(0).renderDynamic);
+
+	// Moving the view invalidates its static layer
+	nearView->SetMatrices(translation(float3(-0.5f, 0.f, 0.f)), nearView->GetProjectionMatrix(false));
+	nearView->UpdateCache();
+	update();
+	CHECK(cache.GetViewUpdate(0).renderStatic);
+	CHECK(!cache.GetViewUpdate(1).renderStatic);
+
+	// Adding a caster in the far view only updates that view
+	std::shared_ptr<SceneGraphNode> newNode = sceneGraph->AttachLeafNode(root, std::make_shared<MeshInstance>(mesh));
+	newNode->SetTranslation(double3(101.0, 0.0, 0.0));
+	update();
+	CHECK(!cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(1).renderStatic);
+	CHECK(!cache.GetViewUpdate(1).hasDynamicCasters);
+
+	cache.Invalidate();
+	update();
+	CHECK(cache.GetViewUpdate(0).renderStatic);
+	CHECK(cache.GetViewUpdate(1).renderStatic);
+}
+
+int main(int, char** argv)
+{
+	try
+	{
+		test_caster_classification();
+	}
+	catch (const std::runtime_error & err)
+	{
+		fprintf(stderr, "%s", err.what());
+		return 1;
+	}
+	return 0;
+}
@@ -38,3 +38,21 @@ foreach(test_src ${donut_engine_tests})
 
 endforeach()
 
+
+
+# Benchmarks are built along with the tests but not registered with CTest
+
+file(GLOB donut_engine_benchmarks src/engine/bench_*.cpp)
+
+foreach(bench_src ${donut_engine_benchmarks})
+
+    get_filename_component(bench_name "${bench_src}" NAME_WE)
+
+    add_executable("${bench_name}" "${bench_src}")
+    target_link_libraries("${bench_name}" donut_engine donut_core)
+
+    add_dependencies(donut_all_tests "${bench_name}")
+
+    set_property(TARGET "${bench_name}" PROPERTY FOLDER "Donut/donut_tests/donut_engine_benchmarks")
+
+endforeach()
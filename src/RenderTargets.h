@@ -34,9 +34,11 @@
 
 #pragma once
 
+#include <donut/core/log.h>
 #include <donut/core/math/math.h>
 #include <donut/engine/FramebufferFactory.h>
 #include <donut/render/GBuffer.h>
+#include <donut/render/RenderGraph.h>
 #include <nvrhi/nvrhi.h>
 #include <nvrhi/common/misc.h>
 
@@ -47,6 +49,20 @@
 class RenderTargets : public donut::render::GBufferRenderTargets
 {
 public:
+    // Stages of the frame that use the transient render targets, in the order they run.
+    enum class Stage : uint32_t
+    {
+        Ssao,
+        DeferredLighting,
+        AntiAliasing,
+        ToneMapping,
+        PreUI,
+        Nis,
+        Present,
+
+        Count
+    };
+
     nvrhi::TextureHandle HdrColor;
     nvrhi::TextureHandle LdrColor;
     nvrhi::TextureHandle ColorspaceCorrectionColor;
@@ -57,8 +73,6 @@ public:
     nvrhi::TextureHandle NisColor;
     nvrhi::TextureHandle PreUIColor;
 
-    nvrhi::HeapHandle Heap;
-
     std::shared_ptr<donut::engine::FramebufferFactory> ForwardFramebuffer;
     std::shared_ptr<donut::engine::FramebufferFactory> HdrFramebuffer;
     std::shared_ptr<donut::engine::FramebufferFactory> LdrFramebuffer;
@@ -67,6 +81,11 @@ public:
 
     donut::math::int2 m_RenderSize;// size of render targets pre-DLSS
     donut::math::int2 m_DisplaySize; // size of render targets post-DLSS
+    donut::math::int2 m_ActiveRenderSize; // size of the region of the pre-DLSS targets that is rendered into, <= m_RenderSize
+
+    // Places all targets except the temporal feedback, which carries history between frames,
+    // and aliases those whose stages don't overlap.
+    donut::render::RenderGraph m_Graph;
 
     void Init(
         nvrhi::IDevice* device,
@@ -81,25 +100,23 @@ public:
 
         m_RenderSize = renderSize;
         m_DisplaySize = displaySize;
+        m_ActiveRenderSize = renderSize;
 
         nvrhi::TextureDesc desc;
         desc.width = renderSize.x;
         desc.height = renderSize.y;
         desc.isRenderTarget = true;
         desc.useClearValue = true;
-        desc.clearValue = nvrhi::Color(1.f);
+        desc.clearValue = nvrhi::Color(0.f);
         desc.sampleCount = sampleCount;
         desc.dimension = sampleCount > 1 ? nvrhi::TextureDimension::Texture2DMS : nvrhi::TextureDimension::Texture2D;
-        desc.keepInitialState = true;
-        desc.isVirtual = device->queryFeatureSupport(nvrhi::Feature::VirtualResources);
 
-        desc.clearValue = nvrhi::Color(0.f);
-        desc.isTypeless = false;
+        m_Graph.Reset();
+
         desc.isUAV = sampleCount == 1;
         desc.format = nvrhi::Format::RGBA16_FLOAT;
-        desc.initialState = nvrhi::ResourceStates::RenderTarget;
         desc.debugName = "HdrColor";
-        HdrColor = device->createTexture(desc);
+        const donut::render::RenderGraphTexture hdrColor = m_Graph.CreateTexture(desc);
 
         // The render targets below this point are non-MSAA
         desc.sampleCount = 1;
@@ -107,84 +124,90 @@ public:
         desc.format = nvrhi::Format::R8_UNORM;
         desc.isUAV = true;
         desc.debugName = "AmbientOcclusion";
-        AmbientOcclusion = device->createTexture(desc);
+        const donut::render::RenderGraphTexture ambientOcclusion = m_Graph.CreateTexture(desc);
 
         desc.format = nvrhi::Format::RGBA16_FLOAT;
         desc.width = displaySize.x;
         desc.height = displaySize.y;
         desc.isUAV = true;
         desc.debugName = "AAResolvedColor";
-        AAResolvedColor = device->createTexture(desc);
+        const donut::render::RenderGraphTexture aaResolvedColor = m_Graph.CreateTexture(desc);
 
-        desc.format = nvrhi::Format::RGBA16_SNORM;
-        desc.isUAV = true;
-        desc.debugName = "TemporalFeedback1";
-        TemporalFeedback1 = device->createTexture(desc);
-        desc.debugName = "TemporalFeedback2";
-        TemporalFeedback2 = device->createTexture(desc);
+        nvrhi::TextureDesc feedbackDesc = desc;
+        feedbackDesc.format = nvrhi::Format::RGBA16_SNORM;
+        feedbackDesc.initialState = nvrhi::ResourceStates::RenderTarget;
+        feedbackDesc.keepInitialState = true;
+        feedbackDesc.debugName = "TemporalFeedback1";
+        TemporalFeedback1 = device->createTexture(feedbackDesc);
+        feedbackDesc.debugName = "TemporalFeedback2";
+        TemporalFeedback2 = device->createTexture(feedbackDesc);
 
         desc.format = nvrhi::Format::SRGBA8_UNORM;
         desc.isUAV = false;
         desc.debugName = "LdrColor";
-        LdrColor = device->createTexture(desc);
+        const donut::render::RenderGraphTexture ldrColor = m_Graph.CreateTexture(desc);
 
         desc.format = nvrhi::Format::RGBA8_UNORM;
         desc.isUAV = true;
         desc.debugName = "ColorspaceCorrectionColor";
-        ColorspaceCorrectionColor = device->createTexture(desc);
+        const donut::render::RenderGraphTexture colorspaceCorrectionColor = m_Graph.CreateTexture(desc);
 
         desc.format = backbufferFormat;
         desc.isUAV = true;
         desc.debugName = "NisColor";
-        NisColor = device->createTexture(desc);
+        const donut::render::RenderGraphTexture nisColor = m_Graph.CreateTexture(desc);
 
         desc.format = backbufferFormat;
         desc.isUAV = true;
         desc.debugName = "PreUIColor";
-        PreUIColor = device->createTexture(desc);
-
-
-
-        if (desc.isVirtual)
-        {
-            uint64_t heapSize = 0;
-            nvrhi::ITexture* const textures[] = {
-                HdrColor,
-                AAResolvedColor,
-                TemporalFeedback1,
-                TemporalFeedback2,
-                LdrColor,
-                ColorspaceCorrectionColor,
-                PreUIColor,
-                NisColor,
-                AmbientOcclusion
-            };
-
-            for (auto texture : textures)
-            {
-                nvrhi::MemoryRequirements memReq = device->getTextureMemoryRequirements(texture);
-                heapSize = nvrhi::align(heapSize, memReq.alignment);
-                heapSize += memReq.size;
-            }
-
-            nvrhi::HeapDesc heapDesc;
-            heapDesc.type = nvrhi::HeapType::DeviceLocal;
-            heapDesc.capacity = heapSize;
-            heapDesc.debugName = "RenderTargetHeap";
-
-            Heap = device->createHeap(heapDesc);
-
-            uint64_t offset = 0;
-            for (auto texture : textures)
-            {
-                nvrhi::MemoryRequirements memReq = device->getTextureMemoryRequirements(texture);
-                offset = nvrhi::align(offset, memReq.alignment);
-
-                device->bindTextureMemory(texture, Heap, offset);
-
-                offset += memReq.size;
-            }
-        }
+        const donut::render::RenderGraphTexture preUIColor = m_Graph.CreateTexture(desc);
+
+        // The graph makes the state of the first use the initial state of a texture, and Streamline reports
+        // the initial state for tagged resources, so every access is declared in the RenderTarget state.
+        // The passes transition the targets as they need.
+        const nvrhi::ResourceStates state = nvrhi::ResourceStates::RenderTarget;
+
+        m_Graph.AddPass("Ssao", nullptr)
+            .Write(ambientOcclusion, state);
+        m_Graph.AddPass("DeferredLighting", nullptr)
+            .Read(ambientOcclusion, state)
+            .Write(hdrColor, state);
+        m_Graph.AddPass("AntiAliasing", nullptr)
+            .Read(hdrColor, state)
+            .Write(aaResolvedColor, state);
+        m_Graph.AddPass("ToneMapping", nullptr)
+            .Read(aaResolvedColor, state)
+            .Write(ldrColor, state)
+            .Write(colorspaceCorrectionColor, state);
+        m_Graph.AddPass("PreUI", nullptr)
+            .Read(aaResolvedColor, state)
+            .Read(colorspaceCorrectionColor, state)
+            .Write(preUIColor, state);
+        m_Graph.AddPass("Nis", nullptr)
+            .Read(preUIColor, state)
+            .Write(nisColor, state);
+
+        // Tagged resources are valid until present, where frame generation and latewarp can still read them
+        m_Graph.AddPass("Present", nullptr)
+            .Read(hdrColor, state)
+            .Read(aaResolvedColor, state)
+            .Read(colorspaceCorrectionColor, state)
+            .Read(preUIColor, state)
+            .Read(nisColor, state)
+            .SetSideEffects();
+
+        assert(m_Graph.GetNumPasses() == uint32_t(Stage::Count));
+
+        if (!m_Graph.Compile(device))
+            donut::log::fatal("Failed to allocate the render targets");
+
+        HdrColor = m_Graph.GetTexture(hdrColor);
+        AmbientOcclusion = m_Graph.GetTexture(ambientOcclusion);
+        AAResolvedColor = m_Graph.GetTexture(aaResolvedColor);
+        LdrColor = m_Graph.GetTexture(ldrColor);
+        ColorspaceCorrectionColor = m_Graph.GetTexture(colorspaceCorrectionColor);
+        NisColor = m_Graph.GetTexture(nisColor);
+        PreUIColor = m_Graph.GetTexture(preUIColor);
 
         ForwardFramebuffer = std::make_shared<donut::engine::FramebufferFactory>(device);
         ForwardFramebuffer->RenderTargets = { HdrColor };
@@ -209,14 +232,29 @@ public:
         return false;
     }
 
-    void Clear(nvrhi::ICommandList* commandList) override
+    // Pooled allocation: the pre-DLSS targets are allocated for the largest render size that can be used,
+    // and views render into their top-left (renderSize) region. Any render size within that envelope can be
+    // used without recreating the targets or the passes that reference them.
+    bool CanRenderAt(donut::math::int2 renderSize, donut::math::int2 displaySize, donut::math::uint sampleCount = 1) const
+    {
+        return all(renderSize <= m_RenderSize) && all(m_DisplaySize == displaySize) && m_SampleCount == sampleCount;
+    }
+
+    void SetActiveRenderSize(donut::math::int2 renderSize)
     {
-        GBufferRenderTargets::Clear(commandList);
+        assert(all(renderSize <= m_RenderSize));
+        m_ActiveRenderSize = renderSize;
+    }
+
+    donut::math::int2 GetActiveRenderSize() const { return m_ActiveRenderSize; }
 
-        commandList->clearTextureFloat(HdrColor, nvrhi::AllSubresources, nvrhi::Color(0.f));
-        commandList->clearTextureFloat(LdrColor, nvrhi::AllSubresources, nvrhi::Color(0.f));
-        commandList->clearTextureFloat(NisColor, nvrhi::AllSubresources, nvrhi::Color(0.f));
-        commandList->clearTextureFloat(PreUIColor, nvrhi::AllSubresources, nvrhi::Color(0.f));
-        commandList->clearTextureFloat(AAResolvedColor, nvrhi::AllSubresources, nvrhi::Color(0.f));
+    // Must be called for every stage, in order, before the work of that stage is recorded.
+    // The transient targets are cleared before their first use, since aliased targets have undefined contents.
+    void BeginStage(nvrhi::ICommandList* commandList, Stage stage)
+    {
+        m_Graph.ExecutePass(commandList, uint32_t(stage));
     }
+
+    // Memory used by the transient targets, with the aliased targets sharing it.
+    uint64_t GetTransientMemorySize() const { return m_Graph.GetStats().transientMemoryWithAliasing; }
 };
\ No newline at end of file
@@ -34,6 +34,7 @@
 #include "SLWrapper.h" 
 
 #include <donut/core/log.h>
+#include <donut/core/profiler.h>
 #include <filesystem>
 #include <dxgi.h>
 #include <dxgi1_5.h>
@@ -433,6 +434,13 @@ void SLWrapper::UpdateFeatureAvailable(donut::app::DeviceManager* deviceManager)
     else log::warning("Latewarp is not fully functional on this system.");
 #endif
 
+    // Frame generation and latewarp work on the presented frames, and a headless device has no swap chain
+    if (deviceManager->GetDeviceParams().headlessDevice)
+    {
+        m_dlssg_available = false;
+        m_latewarp_available = false;
+    }
+
     // We do not leverage the outcome of in the sample, however this is how it would be implemented.
     // sl::FeatureRequirements dlss_requirements;
     // slGetFeatureRequirements(sl::kFeatureDLSS, dlss_requirements);
@@ -939,14 +947,16 @@ void SLWrapper::TagResources_General(
     const donut::engine::IView* view,
     nvrhi::ITexture* motionVectors,
     nvrhi::ITexture* depth,
-    nvrhi::ITexture* finalColorHudless)
+    nvrhi::ITexture* finalColorHudless,
+    sl::Extent renderExtent)
 {
     if (!m_sl_initialised) {
         log::warning("Streamline not initialised.");
         return;
     }
 
-    sl::Extent renderExtent{ 0, 0, depth->getDesc().width, depth->getDesc().height };
+    if (renderExtent.width == 0 || renderExtent.height == 0)
+        renderExtent = sl::Extent{ 0, 0, depth->getDesc().width, depth->getDesc().height };
     sl::Extent fullExtent{ 0, 0, finalColorHudless->getDesc().width, finalColorHudless->getDesc().height };
     void* cmdbuffer = GetNativeCommandList(commandList);
     sl::Resource motionVectorsResource{}, depthResource{}, finalColorHudlessResource{};
@@ -968,14 +978,15 @@ void SLWrapper::TagResources_DLSS_NIS(
     nvrhi::ICommandList * commandList,
     const donut::engine::IView * view,
     nvrhi::ITexture * Output,
-    nvrhi::ITexture * Input)
+    nvrhi::ITexture * Input,
+    sl::Extent inputExtent)
 {
     if (!m_sl_initialised) {
         log::warning("Streamline not initialised.");
         return;
     }
 
-    sl::Extent renderExtent{ 0, 0, Input->getDesc().width, Input->getDesc().height };
+    sl::Extent renderExtent = (inputExtent.width == 0 || inputExtent.height == 0) ? sl::Extent{ 0, 0, Input->getDesc().width, Input->getDesc().height } : inputExtent;
     sl::Extent fullExtent{ 0, 0, Output->getDesc().width, Output->getDesc().height };
     void* cmdbuffer = GetNativeCommandList(commandList);
     sl::Resource outputResource{}, inputResource{};
@@ -1084,6 +1095,7 @@ void SLWrapper::UnTagResources_DeepDVC()
 }
 
 void SLWrapper::EvaluateDLSS(nvrhi::ICommandList* commandList) {
+    DONUT_PROFILE_SCOPE("SLWrapper::EvaluateDLSS");
 
     void* nativeCommandList = nullptr;
 
@@ -1117,6 +1129,7 @@ void SLWrapper::EvaluateDLSS(nvrhi::ICommandList* commandList) {
 }
 
 void SLWrapper::EvaluateNIS(nvrhi::ICommandList* commandList) {
+    DONUT_PROFILE_SCOPE("SLWrapper::EvaluateNIS");
 
     void* nativeCommandList = nullptr;
 
@@ -1150,6 +1163,7 @@ void SLWrapper::EvaluateNIS(nvrhi::ICommandList* commandList) {
 }
 
 void SLWrapper::EvaluateDeepDVC(nvrhi::ICommandList* commandList) {
+    DONUT_PROFILE_SCOPE("SLWrapper::EvaluateDeepDVC");
 
     void* nativeCommandList = nullptr;
 
@@ -1208,6 +1222,7 @@ void SLWrapper::SetReflexConsts(const sl::ReflexOptions options)
 }
 
 void SLWrapper::ReflexCallback_Sleep(donut::app::DeviceManager& manager, uint32_t frameID) {
+    DONUT_PROFILE_SCOPE("SLWrapper::ReflexSleep");
     if (SLWrapper::Get().GetReflexAvailable()) {
         successCheck(slGetNewFrameToken(SLWrapper::Get().m_currentFrame, &frameID), "SL_GetFrameToken");
         successCheck(slReflexSleep(*SLWrapper::Get().m_currentFrame), "Reflex_Sleep");
@@ -1278,7 +1293,10 @@ void SLWrapper::ReflexTriggerPcPing() {
     }
 }
 
-void SLWrapper::QueryReflexStats(bool& reflex_lowLatencyAvailable, bool& reflex_flashAvailable, std::string& stats) {
+void SLWrapper::QueryReflexStats(bool& reflex_lowLatencyAvailable, bool& reflex_flashAvailable, std::string& stats, ReflexLatencyReport* report) {
+    if (report)
+        report->valid = false;
+
     if (SLWrapper::GetReflexAvailable()) {
         sl::ReflexState state;
         successCheck(slReflexGetState(state), "Reflex_State");
@@ -1306,6 +1324,18 @@ void SLWrapper::QueryReflexStats(bool& reflex_lowLatencyAvailable, bool& reflex_
             stats += "\ndriverDeltaUs: " + std::to_string(driverDeltaUs);
             stats += "\nosRenderQueueDeltaUs: " + std::to_string(osRenderQueueDeltaUs);
             stats += "\ngpuRenderDeltaUs: " + std::to_string(gpuRenderDeltaUs);
+
+            if (report) {
+                report->valid = true;
+                report->frameID = frameID;
+                report->totalGameToRenderLatencyUs = totalGameToRenderLatencyUs;
+                report->simDeltaUs = simDeltaUs;
+                report->renderDeltaUs = renderDeltaUs;
+                report->presentDeltaUs = presentDeltaUs;
+                report->driverDeltaUs = driverDeltaUs;
+                report->osRenderQueueDeltaUs = osRenderQueueDeltaUs;
+                report->gpuRenderDeltaUs = gpuRenderDeltaUs;
+            }
         }
         else {
             stats = "Latency Report Unavailable";
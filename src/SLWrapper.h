@@ -92,6 +92,19 @@ void logFunctionCallback(sl::LogType type, const char* msg);
 
 bool successCheck(sl::Result result, char* location = nullptr);
 
+// Latency values of the most recent frame reported by Reflex, in microseconds
+struct ReflexLatencyReport {
+    bool valid = false;
+    uint64_t frameID = 0;
+    uint64_t totalGameToRenderLatencyUs = 0;
+    uint64_t simDeltaUs = 0;
+    uint64_t renderDeltaUs = 0;
+    uint64_t presentDeltaUs = 0;
+    uint64_t driverDeltaUs = 0;
+    uint64_t osRenderQueueDeltaUs = 0;
+    uint64_t gpuRenderDeltaUs = 0;
+};
+
 
 // This is a wrapper around SL functionality for DLSS. It is seperated to provide focus to the calls specific to NGX for code sample purposes.
 class SLWrapper
@@ -217,18 +230,22 @@ public:
 
     void SetSLConsts(const sl::Constants& consts);
     void FeatureLoad(sl::Feature feature, const bool turn_on);
+    // renderExtent is the region of the motion vectors and depth that is rendered into.
+    // An empty extent means the full texture, like for the input extent of TagResources_DLSS_NIS.
     void TagResources_General(
         nvrhi::ICommandList* commandList,
         const donut::engine::IView* view,
         nvrhi::ITexture* motionVectors,
         nvrhi::ITexture* depth,
-        nvrhi::ITexture* finalColorHudless);
+        nvrhi::ITexture* finalColorHudless,
+        sl::Extent renderExtent = {});
 
     void TagResources_DLSS_NIS(
         nvrhi::ICommandList* commandList,
         const donut::engine::IView* view,
         nvrhi::ITexture* output,
-        nvrhi::ITexture* input);
+        nvrhi::ITexture* input,
+        sl::Extent inputExtent = {});
 
     void TagResources_DLSS_FG(
         nvrhi::ICommandList* commandList,
@@ -283,7 +300,7 @@ public:
 
     void ReflexTriggerFlash();
     void ReflexTriggerPcPing();
-    void QueryReflexStats(bool& reflex_lowLatencyAvailable, bool& reflex_flashAvailable, std::string& stats);
+    void QueryReflexStats(bool& reflex_lowLatencyAvailable, bool& reflex_flashAvailable, std::string& stats, ReflexLatencyReport* report = nullptr);
     void SetReflexFlashIndicator(bool enabled) {m_reflex_driverFlashIndicatorEnable = enabled; }
     bool GetReflexFlashIndicatorEnable() { return m_reflex_driverFlashIndicatorEnable; }
 
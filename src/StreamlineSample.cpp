@@ -36,6 +36,10 @@
 #include <sstream>
 #include <thread>
 
+#ifdef DONUT_WITH_TASKFLOW
+#include <taskflow/taskflow.hpp>
+#endif
+
 #if DONUT_WITH_DX12
 #include <d3d12.h>
 #include <nvrhi/d3d12.h>
@@ -90,6 +94,14 @@ StreamlineSample::StreamlineSample(
     m_CommonPasses = std::make_shared<CommonRenderPasses>(GetDevice(), m_ShaderFactory);
 
     m_OpaqueDrawStrategy = std::make_shared<InstancedOpaqueDrawStrategy>();
+    m_OcclusionCuller = std::make_shared<OcclusionCuller>();
+
+    if (m_ScriptingConfig.MeshLod_on != -1)
+    {
+        // Shared by all opaque draw strategies to keep the hysteresis state across frames
+        m_LodSelector = std::make_shared<MeshLodSelector>();
+        m_OpaqueDrawStrategy->SetLodSelector(m_LodSelector);
+    }
 
     const nvrhi::Format shadowMapFormats[] = {
         nvrhi::Format::D24S8,
@@ -118,6 +130,13 @@ StreamlineSample::StreamlineSample(
 
     m_CommandList = GetDevice()->createCommandList();
 
+#ifdef DONUT_WITH_TASKFLOW
+    m_RecordingExecutor = std::make_unique<tf::Executor>();
+#endif
+    m_ParallelRecorder = std::make_unique<ParallelViewRecorder>(GetDevice(), m_RecordingExecutor.get());
+
+    m_GpuProfiler = std::make_unique<GpuProfiler>(GetDevice());
+
     m_FirstPersonCamera.SetMoveSpeed(3.0f);
 
     SetAsynchronousLoadingEnabled(false);
@@ -175,10 +194,40 @@ StreamlineSample::StreamlineSample(
         m_ui.GpuLoad = m_ScriptingConfig.GpuLoad;
     }
 
+    if (m_ScriptingConfig.ParallelRecording_on != -1 && m_ParallelRecorder->IsParallelRecordingSupported())
+    {
+        m_ui.ParallelRecording = true;
+    }
+
+    if (m_ScriptingConfig.PipelinedSimulation_on != -1)
+    {
+        m_ui.PipelinedSimulation = true;
+    }
+
+    if (!m_ScriptingConfig.benchmarkCameraPath.empty())
+    {
+        m_CameraPathPlayback = m_CameraPath.Load(*nativeFS, m_ScriptingConfig.benchmarkCameraPath);
+
+        if (m_CameraPathPlayback)
+        {
+            // Warm up at the start of the path, then play it once. The frames are counted from the first one that
+            // shows the loaded scene, so the splash screen and loading time don't change what is measured.
+            int pathFrames = int(std::ceil(m_CameraPath.GetDuration() / m_ScriptingConfig.benchmarkTimestep)) + 1;
+            m_BenchmarkFrameCount = (m_ScriptingConfig.maxFrames != -1)
+                ? m_ScriptingConfig.maxFrames
+                : m_ScriptingConfig.warmupFrames + pathFrames;
+        }
+    }
+
 };
 
 StreamlineSample::~StreamlineSample()
 {
+    WriteFrameStatistics();
+
+    if (!m_ScriptingConfig.recordCameraPath.empty() && m_viewport == 0 && m_CameraPath.Save(m_ScriptingConfig.recordCameraPath))
+        log::info("Camera path written to %s", m_ScriptingConfig.recordCameraPath.c_str());
+
     SLWrapper::Get().SetViewportHandle(m_viewport);
     SLWrapper::Get().CleanupDLSS(true);
     SLWrapper::Get().CleanupDLSSG(false);
@@ -199,7 +248,7 @@ void StreamlineSample::SetLatewarpOptions()
 
     sl::ReflexCameraData cameraData{};
     std::shared_ptr<PlanarView> planarView = std::dynamic_pointer_cast<PlanarView, IView>(m_View);
-    dm::affine3 viewMatrix = m_FirstPersonCamera.GetWorldToViewMatrix();
+    dm::affine3 viewMatrix = m_RenderCamera.worldToView;
     
     float verticalFov = dm::radians(m_CameraVerticalFov);
     float2 pixelOffset = m_ui.AAMode != AntiAliasingMode::NONE && m_TemporalAntiAliasingPass ? m_TemporalAntiAliasingPass->GetCurrentPixelOffset() : float2(0.f);
@@ -221,6 +270,94 @@ void StreamlineSample::SetLatewarpOptions()
     SLWrapper::Get().SetReflexCameraData(*frameToken, cameraData);
 }
 
+void StreamlineSample::SubmitParallelRecording()
+{
+    // The worker command lists must run after everything recorded so far, and before the rest of the frame.
+    // All render targets use keepInitialState, so they are in the same state when the main list is reopened.
+    m_CommandList->close();
+    m_ParallelRecorder->Submit(m_CommandList);
+    m_CommandList->open();
+}
+
+std::unique_ptr<InstancedOpaqueDrawStrategy> StreamlineSample::CreateOpaqueDrawStrategy() const
+{
+    // Parallel recording creates a strategy per view and frame, the LOD selector carries the state between them
+    auto drawStrategy = std::make_unique<InstancedOpaqueDrawStrategy>();
+    drawStrategy->SetLodSelector(m_LodSelector);
+    return drawStrategy;
+}
+
+void StreamlineSample::RunRecordingBenchmark()
+{
+    // Measures the CPU time to record the GBuffer pass on one command list, and then in parallel
+    // with 1, 2, 4... threads up to the number of hardware threads. The GPU work is submitted but not timed.
+    if (!m_ParallelRecorder->IsParallelRecordingSupported())
+    {
+        log::warning("Recording benchmark: parallel recording is not supported with %s", nvrhi::utils::GraphicsAPIToString(GetDevice()->getGraphicsAPI()));
+        return;
+    }
+
+    constexpr int iterations = 32;
+    auto rootNode = m_Scene->GetSceneGraph()->GetRootNode();
+    auto drawStrategyFactory = []() { return std::make_unique<InstancedOpaqueDrawStrategy>(); };
+    auto passContextFactory = []() { return std::make_unique<GBufferFillPass::Context>(); };
+
+    using Clock = std::chrono::high_resolution_clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    nvrhi::CommandListHandle commandList = GetDevice()->createCommandList(nvrhi::CommandListParameters().setEnableImmediateExecution(false));
+    InstancedOpaqueDrawStrategy drawStrategy;
+    double serialTime = 0.0;
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        Clock::time_point start = Clock::now();
+        GBufferFillPass::Context context;
+        commandList->open();
+        RenderCompositeView(commandList, m_View.get(), m_ViewPrevious.get(), *m_RenderTargets->GBufferFramebuffer,
+            rootNode, drawStrategy, *m_GBufferPass, context, "GBufferFill");
+        commandList->close();
+        serialTime += elapsedMs(start);
+
+        GetDevice()->executeCommandList(commandList);
+    }
+    GetDevice()->waitForIdle();
+    serialTime /= iterations;
+
+    log::info("Recording benchmark (GBuffer, %d iterations): single command list %.3f ms", iterations, serialTime);
+
+#ifdef DONUT_WITH_TASKFLOW
+    const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        tf::Executor executor(threads);
+        ParallelViewRecorder recorder(GetDevice(), &executor);
+        double parallelTime = 0.0;
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            recorder.RenderCompositeView(m_View.get(), m_ViewPrevious.get(), *m_RenderTargets->GBufferFramebuffer,
+                rootNode, drawStrategyFactory, *m_GBufferPass, passContextFactory, "GBufferFill");
+            parallelTime += elapsedMs(start);
+
+            recorder.Submit();
+        }
+        GetDevice()->waitForIdle();
+        parallelTime /= iterations;
+
+        const ParallelViewRecorder::Stats& stats = recorder.GetStats();
+        log::info("Recording benchmark: %2u threads, %u command lists, %zu draw items: %.3f ms (%.2fx)",
+            threads, stats.numCommandLists, stats.numDrawItems, parallelTime, serialTime / std::max(parallelTime, 1e-6));
+
+        if (threads == maxThreads)
+            break;
+    }
+#else
+    log::info("Recording benchmark: donut was built without taskflow, parallel recording is not available");
+#endif
+}
+
 bool StreamlineSample::SetupView()
 {
 
@@ -233,7 +370,7 @@ bool StreamlineSample::SetupView()
     dm::affine3 viewMatrix;
     float verticalFov = dm::radians(m_CameraVerticalFov);
     float zNear = 0.01f;
-    viewMatrix = m_FirstPersonCamera.GetWorldToViewMatrix();
+    viewMatrix = m_RenderCamera.worldToView;
 
     bool topologyChanged = false;
 
@@ -305,12 +442,21 @@ void StreamlineSample::CreateRenderPasses(bool& exposureResetRequired, float lod
     GBufferFillPass::CreateParameters GBufferParams;
     GBufferParams.enableMotionVectors = true;
     GBufferParams.stencilWriteMask = motionVectorStencilMask;
+    GBufferParams.useMeshShaders = m_ScriptingConfig.Meshlets_on != -1;
+    GBufferParams.enableIndirectDraws = true;
     m_GBufferPass = std::make_unique<GBufferFillPass>(GetDevice(), m_CommonPasses);
     m_GBufferPass->Init(*m_ShaderFactory, GBufferParams);
 
     m_DeferredLightingPass = std::make_unique<DeferredLightingPass>(GetDevice(), m_CommonPasses);
     m_DeferredLightingPass->Init(m_ShaderFactory);
 
+    m_LightClusteringPass = std::make_unique<LightClusteringPass>(GetDevice());
+    m_LightClusteringPass->Init(*m_ShaderFactory);
+
+    m_GpuCullingPass = std::make_unique<GpuCullingPass>(GetDevice(), m_CommonPasses);
+    m_GpuCullingPass->Init(*m_ShaderFactory);
+    m_GpuCullingDrawListValid = false;
+
     m_SkyPass = std::make_unique<SkyPass>(GetDevice(), m_ShaderFactory, m_CommonPasses, m_RenderTargets->ForwardFramebuffer, *m_View);
 
     {
@@ -343,13 +489,35 @@ void StreamlineSample::CreateRenderPasses(bool& exposureResetRequired, float lod
     m_PreviousViewsValid = false;
 }
 
+void MultiViewportApp::CommitSimulation(uint32_t frameIndex)
+{
+    // Viewports are created and destroyed here rather than in RenderScene because
+    // their samples are animated on the simulation thread, which is idle at this point.
+    uint32_t nViewports = m_ui.getNViewports();
+    nViewports = std::max(1u, nViewports); // can't have 0 viewports
+
+    while (m_pViewports.size() < nViewports)
+    {
+        m_pViewports.push_back(this->createViewport());
+    }
+    // erase all unused viewports
+    if (nViewports < m_pViewports.size())
+    {
+        m_pViewports.resize(nViewports);
+    }
+
+    for (uint32_t uV = 0; uV < m_pViewports.size(); ++uV)
+    {
+        m_pViewports[uV]->m_pSample->CommitSimulation(frameIndex);
+    }
+}
+
 void MultiViewportApp::RenderScene(nvrhi::IFramebuffer* framebuffer)
 {
     int windowWidth = 0, windowHeight = 0;
     GetDeviceManager()->GetWindowDimensions(windowWidth, windowHeight);
 
-    uint32_t nViewports = m_ui.getNViewports();
-    nViewports = std::max(1u, nViewports); // can't have 0 viewports
+    uint32_t nViewports = std::min(std::max(1u, m_ui.getNViewports()), uint32_t(m_pViewports.size()));
 
     for (uint32_t uV = 0; uV < nViewports; ++uV)
     {
@@ -370,12 +538,6 @@ void MultiViewportApp::RenderScene(nvrhi::IFramebuffer* framebuffer)
             }
         }
 
-        // if we don't have this viewport - create it
-        if (uV >= m_pViewports.size())
-        {
-            m_pViewports.push_back(this->createViewport());
-        }
-
         // the extent shouldn't go beyond the window boundary
         e.width = std::min(e.width, windowWidth - e.left);
         e.height = std::min(e.height, windowHeight - e.top);
@@ -383,22 +545,19 @@ void MultiViewportApp::RenderScene(nvrhi::IFramebuffer* framebuffer)
         m_pViewports[uV]->m_pSample->SetBackBufferExtent(e);
         m_pViewports[uV]->m_pSample->RenderScene(framebuffer);
     }
-    // erase all unused viewports
-    if (nViewports < m_pViewports.size())
-    {
-        m_pViewports.resize(nViewports);
-    }
 }
 
 void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
 {
+    DONUT_PROFILE_SCOPE("StreamlineSample::RenderScene");
+
     // INITIALISE
 
     int windowWidth, windowHeight;
     GetDeviceManager()->GetWindowDimensions(windowWidth, windowHeight);
     nvrhi::Viewport windowViewport = nvrhi::Viewport((float)windowWidth, (float)windowHeight);
 
-    m_Scene->RefreshSceneGraph(GetFrameIndex());
+    // The scene graph has been refreshed in CommitSimulation
 
     bool exposureResetRequired = false;
     bool needNewPasses = false;
@@ -614,8 +773,11 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
     SLWrapper::Get().SetReflexConsts(reflexConst);
 
     bool flashIndicatorDriverAvailable;
-    SLWrapper::Get().QueryReflexStats(m_ui.REFLEX_LowLatencyAvailable, flashIndicatorDriverAvailable, m_ui.REFLEX_Stats);
+    ReflexLatencyReport reflexReport;
+    SLWrapper::Get().QueryReflexStats(m_ui.REFLEX_LowLatencyAvailable, flashIndicatorDriverAvailable, m_ui.REFLEX_Stats, &reflexReport);
     SLWrapper::Get().SetReflexFlashIndicator(flashIndicatorDriverAvailable);
+    if (m_viewport == 0)
+        RecordReflexLatency(reflexReport);
 
     // DLSS SETUP
 
@@ -696,7 +858,24 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
             // Even if we request dynamic res, it is possible that the DLSS mode has max==min
             if (any(maxSize != minSize))
             {
-                if (m_ui.DLSS_Dynamic_Res_change)
+                if (m_ui.DLSS_Dynamic_Res_Auto)
+                {
+                    // Scale the render size within the DLSS bounds to hold the GPU frame time target
+                    DynamicResolutionController::Parameters params = m_DynamicResolution.GetParameters();
+                    params.targetFrameTimeMs = m_ui.DLSS_Dynamic_Res_TargetMs;
+                    m_DynamicResolution.SetParameters(params);
+                    m_DynamicResolution.SetBounds(minSize, maxSize);
+
+                    // Only feed the frames that the profiler has resolved since the last update
+                    if (m_GpuProfiler->GetNumResolvedFrames() != m_DynamicResolutionFrames)
+                    {
+                        m_DynamicResolutionFrames = m_GpuProfiler->GetNumResolvedFrames();
+                        m_DynamicResolution.Update(m_GpuProfiler->GetLastFrameTimeMs());
+                    }
+
+                    m_RenderingRectSize = m_DynamicResolution.GetRenderSize();
+                }
+                else if (m_ui.DLSS_Dynamic_Res_change)
                 {
                     m_ui.DLSS_Dynamic_Res_change = false;
                     std::uniform_int_distribution<int> distributionWidth(minSize.x, maxSize.x);
@@ -753,7 +932,16 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
 
         donut::math::int2 renderSize = useFullSizeRenderingBuffers ? m_DisplaySize : m_RenderingRectSize;
 
-        if (!m_RenderTargets || m_RenderTargets->IsUpdateRequired(renderSize, m_DisplaySize))
+        // In pooled mode, the targets are allocated once for the largest render size - DLAA renders at display size -
+        // and DLSS mode or render size changes only move the viewport within them.
+        bool renderTargetsValid = m_RenderTargets && (m_ui.PooledRenderTargets
+            ? m_RenderTargets->CanRenderAt(m_RenderingRectSize, m_DisplaySize)
+            : !m_RenderTargets->IsUpdateRequired(renderSize, m_DisplaySize));
+
+        if (m_ui.PooledRenderTargets)
+            renderSize = m_DisplaySize;
+
+        if (!renderTargetsValid)
         {
             m_BindingCache.Clear();
 
@@ -764,6 +952,8 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
             needNewPasses = true;
         }
 
+        m_RenderTargets->SetActiveRenderSize(m_RenderingRectSize);
+
         // Render scene, change bias
         if (m_ui.DLSS_lodbias_useoveride) lodBias = m_ui.DLSS_lodbias_overide;
         if (m_PreviousLodBias != lodBias)
@@ -784,9 +974,42 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
 
     }
 
+    // The recording benchmark waits for the GPU to go idle, so it runs between frames,
+    // once the views and passes for this frame exist but before the frame's command list is opened
+    if (m_ScriptingConfig.benchmarkRecording && !m_RecordingBenchmarkDone)
+    {
+        RunRecordingBenchmark();
+        m_RecordingBenchmarkDone = true;
+    }
+
     // BEGIN COMMAND LIST
     m_CommandList->open();
 
+    // Scopes may span SubmitParallelRecording: the lists run back-to-back on the same queue
+    // The dynamic resolution controller and the benchmark need the GPU frame times even when the profiler UI is off
+    m_GpuProfiler->SetEnabled(m_ui.EnableGpuProfiler || m_ui.DLSS_Dynamic_Res_Auto || m_CameraPathPlayback);
+    m_GpuProfiler->BeginFrame();
+
+    if (m_viewport == 0)
+    {
+        FrameStatistics& stats = GetDeviceManager()->GetFrameStatistics();
+
+        // Drop the warm-up frames: shader compilation, texture streaming, caches
+        if (m_CameraPathPlayback && !m_BenchmarkStatsReset && m_RenderBenchmarkFrame >= m_ScriptingConfig.warmupFrames)
+        {
+            m_BenchmarkStatsReset = true;
+            stats.Reset();
+            m_GpuProfiler->ResetStats();
+        }
+
+        if (m_GpuProfiler->GetNumResolvedFrames() != m_GpuFrameStatsFrames)
+        {
+            m_GpuFrameStatsFrames = m_GpuProfiler->GetNumResolvedFrames();
+            stats.RecordValue(stats.GetOrCreateChannel("GPUFrame"), m_GpuProfiler->GetLastFrameTimeMs());
+        }
+    }
+    m_GpuProfiler->BeginScope(m_CommandList, "Frame");
+
     // DO RESETS
     m_Scene->RefreshBuffers(m_CommandList, GetFrameIndex());
 
@@ -808,6 +1031,8 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
     // SHADOW PASS
     if (m_ui.EnableShadows)
     {
+        GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "ShadowMap");
+
         m_SunLight->shadowMap = m_ShadowMap;
         box3 sceneBounds = m_Scene->GetSceneGraph()->GetRootNode()->GetGlobalBoundingBox();
 
@@ -820,18 +1045,48 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         float zRange = length(sceneBounds.diagonal()) * 0.5f;
         m_ShadowMap->SetupForPlanarViewStable(*m_SunLight, projectionFrustum, viewMatrixInv, maxShadowDistance, zRange, zRange, m_ui.CsmExponent);
 
-        m_ShadowMap->Clear(m_CommandList);
+        m_ShadowMap->EnableStaticCaching(m_ui.ShadowCaching);
+
+        if (m_ShadowMap->IsStaticCachingEnabled())
+        {
+            // Static casters are only re-rendered when a cascade moves or its static caster set changes
+            DepthPass::Context context;
 
-        DepthPass::Context context;
+            m_CommandList->beginMarker("ShadowMap");
+            m_ShadowMap->Render(m_CommandList, *m_Scene->GetSceneGraph(), GetFrameIndex(), *m_OpaqueDrawStrategy, *m_ShadowDepthPass, context);
+            m_CommandList->endMarker();
+        }
+        else if (m_ui.ParallelRecording && m_ParallelRecorder->IsParallelRecordingSupported())
+        {
+            m_ShadowMap->Clear(m_CommandList);
 
-        RenderCompositeView(m_CommandList,
-            &m_ShadowMap->GetView(), nullptr,
-            *m_ShadowFramebuffer,
-            m_Scene->GetSceneGraph()->GetRootNode(),
-            *m_OpaqueDrawStrategy,
-            *m_ShadowDepthPass,
-            context,
-            "ShadowMap");
+            // Every cascade, or a slice of one, is recorded into its own command list
+            m_ParallelRecorder->RenderCompositeView(
+                &m_ShadowMap->GetView(), nullptr,
+                *m_ShadowFramebuffer,
+                m_Scene->GetSceneGraph()->GetRootNode(),
+                [this]() { return CreateOpaqueDrawStrategy(); },
+                *m_ShadowDepthPass,
+                []() { return std::make_unique<DepthPass::Context>(); },
+                "ShadowMap");
+
+            SubmitParallelRecording();
+        }
+        else
+        {
+            m_ShadowMap->Clear(m_CommandList);
+
+            DepthPass::Context context;
+
+            RenderCompositeView(m_CommandList,
+                &m_ShadowMap->GetView(), nullptr,
+                *m_ShadowFramebuffer,
+                m_Scene->GetSceneGraph()->GetRootNode(),
+                *m_OpaqueDrawStrategy,
+                *m_ShadowDepthPass,
+                context,
+                "ShadowMap");
+        }
     }
     else
     {
@@ -849,7 +1104,56 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         // DO GBUFFER
         GBufferFillPass::Context gbufferContext;
 
+        if (m_ui.GpuCulling)
+        {
+            GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "GpuCulling");
+
+            if (!m_GpuCullingDrawListValid)
+            {
+                m_GpuCullingPass->BuildDrawList(m_CommandList, m_Scene->GetSceneGraph()->GetMeshInstances());
+                m_GpuCullingDrawListValid = true;
+            }
+
+            // The HiZ was built from the depth rendered with the previous view
+            bool useHiZ = m_HiZValid && m_PreviousViewsValid && m_RenderTargets->HiZ;
+            m_GpuCullingPass->Render(m_CommandList, m_Scene->GetInstanceBuffer(), *m_View,
+                useHiZ ? m_RenderTargets->HiZ.Get() : nullptr, useHiZ ? m_ViewPrevious.get() : nullptr);
+        }
+
+        // The shadow views draw with the same strategy, so the culler is only set for the Gbuffer
+        m_OpaqueDrawStrategy->SetOcclusionCuller(m_ui.OcclusionCulling ? m_OcclusionCuller : nullptr);
+
+        m_GpuProfiler->BeginScope(m_CommandList, "GBufferFill");
         for (auto i = 0; i <= m_ui.GpuLoad; ++i) {
+            if (m_ui.GpuCulling)
+            {
+                m_GBufferPass->RenderIndirect(m_CommandList, m_View.get(), m_ViewPrevious.get(),
+                    m_RenderTargets->GBufferFramebuffer->GetFramebuffer(*m_View), *m_GpuCullingPass, gbufferContext);
+                continue;
+            }
+
+            if (m_ui.ParallelRecording && m_ParallelRecorder->IsParallelRecordingSupported())
+            {
+                // A culler holds the state of one view, so every strategy recorded in parallel needs its own
+                m_ParallelRecorder->RenderCompositeView(
+                    m_View.get(), m_ViewPrevious.get(),
+                    *m_RenderTargets->GBufferFramebuffer,
+                    m_Scene->GetSceneGraph()->GetRootNode(),
+                    [this]()
+                    {
+                        auto drawStrategy = CreateOpaqueDrawStrategy();
+                        if (m_ui.OcclusionCulling)
+                            drawStrategy->SetOcclusionCuller(std::make_shared<OcclusionCuller>());
+                        return drawStrategy;
+                    },
+                    *m_GBufferPass,
+                    []() { return std::make_unique<GBufferFillPass::Context>(); },
+                    "GBufferFill");
+
+                SubmitParallelRecording();
+                continue;
+            }
+
             RenderCompositeView(m_CommandList,
                 m_View.get(), m_ViewPrevious.get(),
                 *m_RenderTargets->GBufferFramebuffer,
@@ -859,19 +1163,34 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
                 gbufferContext,
                 "GBufferFill");
         }
+        m_GpuProfiler->EndScope(m_CommandList);
+
+        m_OpaqueDrawStrategy->SetOcclusionCuller(nullptr);
+
+        // Culling of the next frame tests against this frame's depth
+        if (m_ui.GpuCulling)
+            m_RenderTargets->BuildHiZ(m_CommandList, m_ShaderFactory);
+        m_HiZValid = m_ui.GpuCulling;
 
         // DO MOTION VECTORS
-        if (m_PreviousViewsValid) m_TemporalAntiAliasingPass->RenderMotionVectors(m_CommandList, *m_View, *m_ViewPrevious);
+        if (m_PreviousViewsValid)
+        {
+            GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "MotionVectors");
+            m_TemporalAntiAliasingPass->RenderMotionVectors(m_CommandList, *m_View, *m_ViewPrevious);
+        }
 
         // DO SSAO
+        m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::Ssao);
         nvrhi::ITexture* ambientOcclusionTarget = nullptr;
         if (m_ui.EnableSsao && m_SsaoPass)
         {
+            GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "SSAO");
             m_SsaoPass->Render(m_CommandList, m_ui.SsaoParams, *m_View);
             ambientOcclusionTarget = m_RenderTargets->AmbientOcclusion;
         }
 
         // DO DEFFERED
+        m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::DeferredLighting);
         DeferredLightingPass::Inputs deferredInputs;
         deferredInputs.SetGBuffer(*m_RenderTargets);
         deferredInputs.ambientOcclusion = m_ui.EnableSsao ? m_RenderTargets->AmbientOcclusion : nullptr;
@@ -880,14 +1199,30 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         deferredInputs.lights = &m_Scene->GetSceneGraph()->GetLights();
         deferredInputs.output = m_RenderTargets->HdrColor;
 
+        if (m_ui.ClusteredLighting)
+        {
+            GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "LightClustering");
+            m_LightClusteringPass->Render(m_CommandList, *m_View, m_Scene->GetSceneGraph()->GetLights());
+            deferredInputs.lightClusters = m_LightClusteringPass.get();
+        }
+
+        m_GpuProfiler->BeginScope(m_CommandList, "DeferredLighting");
         m_DeferredLightingPass->Render(m_CommandList, *m_View, deferredInputs);
+        m_GpuProfiler->EndScope(m_CommandList);
     }
 
     if (m_ui.EnableProceduralSky)
+    {
+        GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "Sky");
         m_SkyPass->Render(m_CommandList, *m_View, *m_SunLight, m_ui.SkyParams);
+    }
 
     // DO BLOOM
-    if (m_ui.EnableBloom) m_BloomPass->Render(m_CommandList, m_RenderTargets->HdrFramebuffer, *m_View, m_RenderTargets->HdrColor, m_ui.BloomSigma, m_ui.BloomAlpha);
+    if (m_ui.EnableBloom)
+    {
+        GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "Bloom");
+        m_BloomPass->Render(m_CommandList, m_RenderTargets->HdrFramebuffer, *m_View, m_RenderTargets->HdrColor, m_ui.BloomSigma, m_ui.BloomAlpha);
+    }
 
     // SET STREAMLINE CONSTANTS
     {
@@ -910,10 +1245,10 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         slConstants.cameraMotionIncluded = sl::Boolean::eTrue;
         slConstants.cameraNear = zNear;
         slConstants.cameraPinholeOffset = { 0.f, 0.f };
-        slConstants.cameraPos = make_sl_float3(m_FirstPersonCamera.GetPosition());
-        slConstants.cameraFwd = make_sl_float3(m_FirstPersonCamera.GetDir());
-        slConstants.cameraUp = make_sl_float3(m_FirstPersonCamera.GetUp());
-        slConstants.cameraRight = make_sl_float3(normalize(cross(m_FirstPersonCamera.GetDir(), m_FirstPersonCamera.GetUp())));
+        slConstants.cameraPos = make_sl_float3(m_RenderCamera.position);
+        slConstants.cameraFwd = make_sl_float3(m_RenderCamera.dir);
+        slConstants.cameraUp = make_sl_float3(m_RenderCamera.up);
+        slConstants.cameraRight = make_sl_float3(normalize(cross(m_RenderCamera.dir, m_RenderCamera.up)));
         slConstants.cameraViewToClip = make_sl_float4x4(projection);
         slConstants.clipToCameraView = make_sl_float4x4(inverse(projection));
         slConstants.clipToPrevClip = make_sl_float4x4(reprojectionMatrix);
@@ -929,19 +1264,26 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
     }
 
     // TAG STREAMLINE RESOURCES
+    // Pooled render targets can be larger than the region rendered this frame
+    const int2 activeRenderSize = m_RenderTargets->GetActiveRenderSize();
+    const sl::Extent activeRenderExtent{ 0, 0, uint32_t(activeRenderSize.x), uint32_t(activeRenderSize.y) };
+
     SLWrapper::Get().TagResources_General(m_CommandList,
         m_View->GetChildView(ViewType::PLANAR, 0),
         m_RenderTargets->MotionVectors,
         m_RenderTargets->Depth,
-        m_RenderTargets->PreUIColor);
+        m_RenderTargets->PreUIColor,
+        activeRenderExtent);
 
     // ANTI-ALIASING
+    m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::AntiAliasing);
 
     // TAG STREAMLINE RESOURCES
     SLWrapper::Get().TagResources_DLSS_NIS(m_CommandList,
         m_View->GetChildView(ViewType::PLANAR, 0),
         m_RenderTargets->AAResolvedColor,
-        m_RenderTargets->HdrColor);
+        m_RenderTargets->HdrColor,
+        activeRenderExtent);
 
     if (m_ui.AAMode != AntiAliasingMode::NONE) {
 
@@ -949,6 +1291,7 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
 
         if (m_ui.AAMode == AntiAliasingMode::DLSS && !m_ui.DLSS_DebugShowFullRenderingBuffer)
         {
+            GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "DLSS");
             SLWrapper::Get().EvaluateDLSS(m_CommandList);
         }
 
@@ -960,6 +1303,7 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         // DO TAA
         if (m_ui.AAMode == AntiAliasingMode::TEMPORAL)
         {
+            GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "TAA");
             m_TemporalAntiAliasingPass->TemporalResolve(m_CommandList, m_ui.TemporalAntiAliasingParams, m_PreviousViewsValid, *m_View, m_PreviousViewsValid ? *m_ViewPrevious : *m_View);
         }
 
@@ -973,9 +1317,12 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
     }
 
     //DO TONEMAPPING
+    m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::ToneMapping);
     nvrhi::ITexture* texToDisplay;
     if (m_ui.EnableToneMapping)
     {
+        GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "ToneMapping");
+
         auto toneMappingParams = m_ui.ToneMappingParams;
         if (exposureResetRequired)
         {
@@ -991,12 +1338,13 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         texToDisplay = m_RenderTargets->AAResolvedColor;
     }
 
-
+    m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::PreUI);
     m_CommonPasses->BlitTexture(m_CommandList, m_RenderTargets->PreUIFramebuffer->GetFramebuffer(*m_View), texToDisplay, &m_BindingCache);
 
     //
     // DO NIS
     //
+    m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::Nis);
     if (m_ui.NIS_Mode != sl::NISMode::eOff) {
 
         // NIS SETUP
@@ -1019,10 +1367,11 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
             m_RenderTargets->PreUIColor,
             m_RenderTargets->NisColor);
 
+        GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "NIS");
         SLWrapper::Get().EvaluateNIS(m_CommandList);
     }
 
-
+    m_RenderTargets->BeginStage(m_CommandList, RenderTargets::Stage::Present);
     SLWrapper::Get().TagResources_DLSS_FG(m_CommandList, validViewportExtent, m_backbufferViewportExtent);
 
     //
@@ -1040,6 +1389,7 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         SLWrapper::Get().TagResources_DeepDVC(m_CommandList,
             m_View->GetChildView(ViewType::PLANAR, 0),
             m_RenderTargets->PreUIColor);
+        GpuProfilerScope profilerScope(m_GpuProfiler.get(), m_CommandList, "DeepDVC");
         SLWrapper::Get().EvaluateDeepDVC(m_CommandList);
     }
 
@@ -1110,6 +1460,8 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
         displayDebugPiP(m_RenderTargets->Depth, int2(counter % SubWindowNumber, counter++ / SubWindowNumber), 1 / float(SubWindowNumber));
     }
 
+    m_GpuProfiler->EndScope(m_CommandList);
+
     // CLOSE COMMANDLIST
     m_CommandList->close();
     GetDevice()->executeCommandList(m_CommandList);
@@ -1121,14 +1473,108 @@ void StreamlineSample::RenderScene(nvrhi::IFramebuffer* framebuffer)
 
         std::swap(m_View, m_ViewPrevious);
 
-        m_CameraPreviousMatrix = m_FirstPersonCamera.GetWorldToViewMatrix();
+        m_CameraPreviousMatrix = m_RenderCamera.worldToView;
 
         GetDeviceManager()->SetVsyncEnabled(m_ui.EnableVsync);
+        GetDeviceManager()->SetPipelinedSimulationEnabled(m_ui.PipelinedSimulation);
     }
 
     // CLOSE: 
-    if (GetFrameIndex() == m_ScriptingConfig.maxFrames)
-        glfwSetWindowShouldClose(GetDeviceManager()->GetWindow(), GLFW_TRUE);
+    bool lastFrame = m_CameraPathPlayback
+        ? (m_RenderBenchmarkFrame >= 0 && m_RenderBenchmarkFrame + 1 >= m_BenchmarkFrameCount)
+        : GetFrameIndex() == m_ScriptingConfig.maxFrames;
+    if (lastFrame)
+    {
+        WriteFrameStatistics();
+        GetDeviceManager()->RequestExit();
+    }
+}
+
+void StreamlineSample::RecordReflexLatency(const ReflexLatencyReport& report)
+{
+    // The report only changes when the driver has finished another frame
+    if (!report.valid || report.frameID == m_LastReflexFrameID)
+        return;
+
+    m_LastReflexFrameID = report.frameID;
+
+    FrameStatistics& stats = GetDeviceManager()->GetFrameStatistics();
+    auto record = [&stats](const char* name, uint64_t us) { stats.RecordValue(stats.GetOrCreateChannel(name), double(us) * 1e-3); };
+
+    record("Reflex_GameToRender", report.totalGameToRenderLatencyUs);
+    record("Reflex_Sim", report.simDeltaUs);
+    record("Reflex_RenderSubmit", report.renderDeltaUs);
+    record("Reflex_Present", report.presentDeltaUs);
+    record("Reflex_Driver", report.driverDeltaUs);
+    record("Reflex_OSRenderQueue", report.osRenderQueueDeltaUs);
+    record("Reflex_GPURender", report.gpuRenderDeltaUs);
+}
+
+void StreamlineSample::WriteFrameStatistics()
+{
+    if (m_FrameStatisticsWritten || m_viewport != 0 || (m_ScriptingConfig.frameStatsFile.empty() && m_ScriptingConfig.benchmarkReportFile.empty()))
+        return;
+
+    m_FrameStatisticsWritten = true;
+
+    const FrameStatistics& stats = GetDeviceManager()->GetFrameStatistics();
+    for (FrameStatistics::ChannelId channel = 0; channel < stats.GetNumChannels(); channel++)
+    {
+        FrameStatistics::Summary s = stats.GetSummary(channel);
+        if (s.count == 0)
+            continue;
+        log::info("%-20s n=%llu p50=%.3f p90=%.3f p99=%.3f p99.9=%.3f max=%.3f pacing=%.3f ms", s.name.c_str(),
+            (unsigned long long)s.count, s.p50Ms, s.p90Ms, s.p99Ms, s.p999Ms, s.maxMs, s.pacingMs);
+    }
+
+    if (!m_ScriptingConfig.frameStatsFile.empty())
+    {
+        std::filesystem::path summaryFile = m_ScriptingConfig.frameStatsFile;
+        std::filesystem::path histogramFile = summaryFile;
+        histogramFile.replace_filename(summaryFile.stem().string() + "_histogram" + summaryFile.extension().string());
+
+        if (stats.WriteSummaryCsv(summaryFile) && stats.WriteHistogramCsv(histogramFile))
+            log::info("Frame statistics written to %s and %s", summaryFile.generic_string().c_str(), histogramFile.generic_string().c_str());
+    }
+
+    if (!m_ScriptingConfig.benchmarkReportFile.empty())
+    {
+        auto sizeToString = [](int2 size) { return std::to_string(size.x) + "x" + std::to_string(size.y); };
+
+        std::vector<std::pair<std::string, std::string>> info = {
+            { "scene", m_CurrentSceneName },
+            { "cameraPath", m_ScriptingConfig.benchmarkCameraPath },
+            { "graphicsAPI", nvrhi::utils::GraphicsAPIToString(GetDevice()->getGraphicsAPI()) },
+            { "renderer", GetDeviceManager()->GetRendererString() },
+            { "renderSize", sizeToString(m_RenderingRectSize) },
+            { "displaySize", sizeToString(m_DisplaySize) },
+            { "aaMode", std::to_string(int(m_ui.AAMode)) },
+            { "dlssMode", std::to_string(int(m_ui.DLSS_Mode)) },
+        };
+
+        std::vector<std::pair<std::string, double>> metrics = {
+            { "warmupFrames", double(m_ScriptingConfig.warmupFrames) },
+            { "timestepMs", double(m_ScriptingConfig.benchmarkTimestep) * 1e3 },
+            { "cameraPathDuration", double(m_CameraPath.GetDuration()) },
+            { "loadedTextures", double(m_TextureCache->GetNumberOfLoadedTextures()) },
+            { "streamedTextureBytes", double(m_TextureCache->GetResidencyPolicy().GetResidentMemory()) },
+            { "renderTargetHeapBytes", m_RenderTargets ? double(m_RenderTargets->GetTransientMemorySize()) : 0.0 },
+        };
+
+        // Per-pass GPU times over the profiler's window, i.e. the last frames of the run
+        std::vector<GpuProfiler::PassStats> passStats;
+        m_GpuProfiler->GetPassStats(passStats);
+        for (const GpuProfiler::PassStats& pass : passStats)
+        {
+            if (pass.numSamples == 0)
+                continue;
+            metrics.push_back({ "gpu." + pass.name + ".avgMs", double(pass.avgMs) });
+            metrics.push_back({ "gpu." + pass.name + ".p99Ms", double(pass.p99Ms) });
+        }
+
+        if (stats.WriteReportJson(m_ScriptingConfig.benchmarkReportFile, info, metrics))
+            log::info("Benchmark report written to %s", m_ScriptingConfig.benchmarkReportFile.c_str());
+    }
 }
 
 // Logistic functions 
@@ -1155,6 +1601,13 @@ void StreamlineSample::SetCurrentSceneName(const std::string& sceneName)
 
     m_CurrentSceneName = sceneName;
 
+    // The scene is animated on the simulation thread, so it can only be replaced once that is idle
+    if (GetDeviceManager()->IsPipelinedSimulationEnabled())
+    {
+        m_SceneReloadPending = true;
+        return;
+    }
+
     BeginLoadingScene(m_RootFs, m_CurrentSceneName);
 }
 
@@ -1200,23 +1653,115 @@ bool StreamlineSample::MouseScrollUpdate(double xoffset, double yoffset)
 
 void StreamlineSample::Animate(float fElapsedTimeSeconds)
 {
-    m_FirstPersonCamera.Animate(fElapsedTimeSeconds);
+    DONUT_PROFILE_SCOPE("StreamlineSample::Animate");
+
+    // This may run on the simulation thread while the previous frame is rendered. The scene graph transforms are
+    // refreshed here and published to the renderer in CommitSimulation. Animated material and light properties
+    // are read by the renderer directly, so those channels are applied in CommitSimulation.
+    if (m_CameraPathPlayback)
+    {
+        // Every run sees the same frames: fixed timestep, and the camera holds at the start of the path during the warm-up
+        fElapsedTimeSeconds = m_ScriptingConfig.benchmarkTimestep;
+        if (m_SimSceneReady)
+            ++m_BenchmarkFrame;
+        m_CameraPathTime = float(std::max(m_BenchmarkFrame - m_ScriptingConfig.warmupFrames, 0)) * fElapsedTimeSeconds;
+
+        CameraPath::Keyframe pose = m_CameraPath.Sample(m_CameraPathTime);
+        m_FirstPersonCamera.LookTo(pose.position, pose.direction, pose.up);
+    }
+    else
+    {
+        m_FirstPersonCamera.Animate(fElapsedTimeSeconds);
+
+        if (!m_ScriptingConfig.recordCameraPath.empty() && m_SimSceneReady)
+        {
+            CameraPath::Keyframe pose;
+            pose.time = m_CameraPathTime;
+            pose.position = m_FirstPersonCamera.GetPosition();
+            pose.direction = m_FirstPersonCamera.GetDir();
+            pose.up = m_FirstPersonCamera.GetUp();
+            m_CameraPath.AddKeyframe(pose);
+            m_CameraPathTime += fElapsedTimeSeconds;
+        }
+    }
+
+    m_SimElapsedTime = fElapsedTimeSeconds;
+
+    if (m_SimSceneReady)
+    {
+        if (m_SimEnableAnimations)
+        {
+            m_WallclockTime += fElapsedTimeSeconds*m_SimAnimationSpeed;
+            ApplySceneAnimations(false);
+        }
+
+        m_Scene->RefreshSceneGraphTransforms();
+    }
+}
+
+void StreamlineSample::ApplySceneAnimations(bool leafProperties)
+{
+    for (const auto& anim : m_Scene->GetSceneGraph()->GetAnimations())
+    {
+        float duration = anim->GetDuration();
+        float integral;
+        float animationTime = std::modf(m_WallclockTime / duration, &integral) * duration;
+        if (leafProperties)
+            (void)anim->ApplyLeafProperties(animationTime);
+        else
+            (void)anim->ApplyTransforms(animationTime);
+    }
+}
+
+void StreamlineSample::CommitSimulation(uint32_t frameIndex)
+{
+    DONUT_PROFILE_SCOPE("StreamlineSample::CommitSimulation");
+
+    if (m_SceneReloadPending)
+    {
+        m_SceneReloadPending = false;
+        m_SimSceneReady = false;
+        BeginLoadingScene(m_RootFs, m_CurrentSceneName);
+    }
 
     if (m_ToneMappingPass)
-        m_ToneMappingPass->AdvanceFrame(fElapsedTimeSeconds);
+        m_ToneMappingPass->AdvanceFrame(m_SimElapsedTime);
 
-    if (IsSceneLoaded() && m_ui.EnableAnimations)
+    // A newly loaded scene is handed to the simulation once SceneLoaded has finished setting it up
+    if (m_SimulationResetPending)
     {
-        m_WallclockTime += fElapsedTimeSeconds*m_ui.AnimationSpeed;
+        m_SimulationResetPending = false;
+        m_SimSceneReady = true;
+        m_WallclockTime = 0.f;
+        m_FirstPersonCamera.LookAt(float3(0.f, 1.8f, 0.f), float3(1.f, 1.8f, 0.f));
 
-        for (const auto& anim : m_Scene->GetSceneGraph()->GetAnimations())
+        if (m_CameraPathPlayback)
         {
-            float duration = anim->GetDuration();
-            float integral;
-            float animationTime = std::modf(m_WallclockTime / duration, &integral) * duration;
-            (void)anim->Apply(animationTime);
+            // This is benchmark frame 0, the first one that renders the loaded scene
+            m_BenchmarkFrame = 0;
+            m_CameraPathTime = 0.f;
+            CameraPath::Keyframe pose = m_CameraPath.Sample(m_CameraPathTime);
+            m_FirstPersonCamera.LookTo(pose.position, pose.direction, pose.up);
         }
     }
+    m_RenderBenchmarkFrame = m_SimSceneReady ? m_BenchmarkFrame : -1;
+
+    // Publish the simulated transforms and views to the renderer
+    if (m_SimSceneReady)
+    {
+        if (m_SimEnableAnimations)
+            ApplySceneAnimations(true);
+
+        m_Scene->CommitSceneGraph(frameIndex);
+    }
+
+    m_RenderCamera.worldToView = m_FirstPersonCamera.GetWorldToViewMatrix();
+    m_RenderCamera.position = m_FirstPersonCamera.GetPosition();
+    m_RenderCamera.dir = m_FirstPersonCamera.GetDir();
+    m_RenderCamera.up = m_FirstPersonCamera.GetUp();
+
+    m_SimEnableAnimations = m_ui.EnableAnimations;
+    m_SimAnimationSpeed = m_ui.AnimationSpeed;
 }
 
 void StreamlineSample::SceneUnloading()
@@ -1226,6 +1771,8 @@ void StreamlineSample::SceneUnloading()
     if (m_ShadowDepthPass) m_ShadowDepthPass->ResetBindingCache();
     m_BindingCache.Clear();
     m_SunLight.reset();
+    m_SimSceneReady = false;
+    m_GpuCullingDrawListValid = false;
 }
 
 bool StreamlineSample::LoadScene(std::shared_ptr<IFileSystem> fs, const std::filesystem::path& fileName)
@@ -1233,6 +1780,15 @@ bool StreamlineSample::LoadScene(std::shared_ptr<IFileSystem> fs, const std::fil
     using namespace std::chrono;
 
     Scene* scene = new Scene(GetDevice(), *m_ShaderFactory, fs, m_TextureCache, nullptr, nullptr);
+    scene->SetCompactVertexFormatEnabled(m_ScriptingConfig.CompactVertices_on != -1);
+    scene->SetMeshletsEnabled(m_ScriptingConfig.Meshlets_on != -1);
+    scene->SetMeshOptimizationEnabled(m_ScriptingConfig.OptimizeMeshes_on != -1);
+    scene->SetLodGenerationEnabled(m_ScriptingConfig.MeshLod_on != -1);
+    scene->SetExecutor(m_RecordingExecutor.get());
+    // The occluders of the CPU occlusion culling are rasterized from the CPU copies of the meshes
+    scene->SetCpuGeometryRetained(true);
+    if (m_LodSelector)
+        m_LodSelector->Reset();
 
     auto startTime = high_resolution_clock::now();
 
@@ -1256,7 +1812,8 @@ void StreamlineSample::SceneLoaded()
 
     m_Scene->FinishedLoading(GetFrameIndex());
 
-    m_WallclockTime = 0.f;
+    // The simulation may be animating the camera right now, reset it and the clock at the next handoff
+    m_SimulationResetPending = true;
     m_PreviousViewsValid = false;
 
     for (auto light : m_Scene->GetSceneGraph()->GetLights())
@@ -1281,7 +1838,6 @@ void StreamlineSample::SceneLoaded()
         m_Scene->GetSceneGraph()->Attach(m_Scene->GetSceneGraph()->GetRootNode(), node);
     }
 
-    m_FirstPersonCamera.LookAt(float3(0.f, 1.8f, 0.f), float3(1.f, 1.8f, 0.f));
     m_CameraVerticalFov = 60.f;
 
 }
@@ -43,8 +43,12 @@
 // From Donut
 #include <donut/core/vfs/VFS.h>
 #include <donut/core/log.h>
+#include <donut/core/profiler.h>
+#include <donut/engine/CameraPath.h>
 #include <donut/engine/CommonRenderPasses.h>
+#include <donut/engine/DynamicResolution.h>
 #include <donut/engine/FramebufferFactory.h>
+#include <donut/engine/GpuProfiler.h>
 #include <donut/engine/Scene.h>
 #include <donut/engine/ShaderFactory.h>
 #include <donut/engine/TextureCache.h>
@@ -55,8 +59,12 @@
 #include <donut/render/DrawStrategy.h>
 #include <donut/render/ForwardShadingPass.h>
 #include <donut/render/GBufferFillPass.h>
+#include <donut/render/GpuCullingPass.h>
+#include <donut/render/LightClusteringPass.h>
 #include <donut/render/LightProbeProcessingPass.h>
+#include <donut/render/OcclusionCuller.h>
 #include <donut/render/PixelReadbackPass.h>
+#include <donut/render/ParallelGeometryPasses.h>
 #include <donut/render/SkyPass.h>
 #include <donut/render/SsaoPass.h>
 #include <donut/render/TemporalAntiAliasingPass.h>
@@ -83,6 +91,19 @@ struct ScriptingConfig {
     int DeepDVC_on = -1;
     int Latewarp_on = -1;
     int GpuLoad = -1;
+    int ParallelRecording_on = -1;
+    int PipelinedSimulation_on = -1;
+    int CompactVertices_on = -1;
+    int Meshlets_on = -1;
+    int OptimizeMeshes_on = -1;
+    int MeshLod_on = -1;
+    bool benchmarkRecording = false;
+    std::string frameStatsFile;
+    std::string benchmarkCameraPath;
+    std::string benchmarkReportFile;
+    std::string recordCameraPath;
+    int warmupFrames = 60;
+    float benchmarkTimestep = 1.f / 60.f;
     sl::Extent viewportExtent{};
 
     ScriptingConfig(int argc, const char* const* argv)
@@ -130,12 +151,86 @@ struct ScriptingConfig {
                 Latewarp_on = 1;
             }
 
+            // Multi-threaded command list recording
+            else if (!strcmp(argv[i], "-ParallelRecording_on"))
+            {
+                ParallelRecording_on = 1;
+            }
+
+            // Animation on a simulation thread, overlapping the rendering of the previous frame
+            else if (!strcmp(argv[i], "-PipelinedSimulation_on"))
+            {
+                PipelinedSimulation_on = 1;
+            }
+
+            // 16-bit indices and quantized vertex streams
+            else if (!strcmp(argv[i], "-CompactVertices_on"))
+            {
+                CompactVertices_on = 1;
+            }
+
+            // Meshlets with task shader culling in the G-buffer pass
+            else if (!strcmp(argv[i], "-Meshlets_on"))
+            {
+                Meshlets_on = 1;
+            }
+
+            // Vertex cache, overdraw and vertex fetch optimization when loading glTF models
+            else if (!strcmp(argv[i], "-OptimizeMeshes_on"))
+            {
+                OptimizeMeshes_on = 1;
+            }
+
+            // Simplified levels of detail for loaded meshes, selected by projected error
+            else if (!strcmp(argv[i], "-MeshLod_on"))
+            {
+                MeshLod_on = 1;
+            }
+            else if (!strcmp(argv[i], "-benchmarkRecording"))
+            {
+                benchmarkRecording = true;
+            }
+
+            // Frame time and latency percentiles, written at -maxFrames or at exit
+            else if (!strcmp(argv[i], "-frameStats"))
+            {
+                frameStatsFile = argv[++i];
+            }
+
+            // Benchmark: camera path playback with a fixed timestep, warm-up frames and a JSON report
+            else if (!strcmp(argv[i], "-benchmark"))
+            {
+                benchmarkCameraPath = argv[++i];
+            }
+            else if (!strcmp(argv[i], "-benchmarkReport"))
+            {
+                benchmarkReportFile = argv[++i];
+            }
+            else if (!strcmp(argv[i], "-benchmarkFps"))
+            {
+                benchmarkTimestep = 1.f / std::max(std::stof(argv[++i]), 1.f);
+            }
+            else if (!strcmp(argv[i], "-warmupFrames"))
+            {
+                warmupFrames = std::max(std::stoi(argv[++i]), 0);
+            }
+            else if (!strcmp(argv[i], "-recordCameraPath"))
+            {
+                recordCameraPath = argv[++i];
+            }
+
             else if (!strcmp(argv[i], "-viewport"))
             {
                 int ret = sscanf(argv[++i], "(%d,%d,%dx%d)", &viewportExtent.left, &viewportExtent.top, &viewportExtent.width, &viewportExtent.height);
                 assert(ret == 4);
             }
         }
+
+        if (frameStatsFile.empty() && maxFrames != -1)
+            frameStatsFile = "frame_stats.csv";
+
+        if (benchmarkReportFile.empty() && !benchmarkCameraPath.empty())
+            benchmarkReportFile = "benchmark_report.json";
     }
 };
 
@@ -154,6 +249,14 @@ private:
     std::string                                     m_CurrentSceneName;
     std::shared_ptr<Scene>				            m_Scene;
     float                                           m_WallclockTime = 0.f;
+    bool                                            m_SceneReloadPending = false;
+
+    // Simulation inputs, copied from the UI in CommitSimulation so that Animate can run on the simulation thread
+    bool                                            m_SimEnableAnimations = true;
+    float                                           m_SimAnimationSpeed = 1.f;
+    float                                           m_SimElapsedTime = 0.f;
+    bool                                            m_SimSceneReady = false; // m_Scene can be animated by Animate
+    bool                                            m_SimulationResetPending = false; // set by SceneLoaded, applied in CommitSimulation
                                                     
     // Render Passes                                
     std::shared_ptr<ShaderFactory>                  m_ShaderFactory;
@@ -162,14 +265,42 @@ private:
     std::shared_ptr<FramebufferFactory>             m_ShadowFramebuffer;
     std::shared_ptr<DepthPass>                      m_ShadowDepthPass;
     std::shared_ptr<InstancedOpaqueDrawStrategy>    m_OpaqueDrawStrategy;
+    std::shared_ptr<MeshLodSelector>                m_LodSelector;
     std::unique_ptr<GBufferFillPass>                m_GBufferPass;
     std::unique_ptr<DeferredLightingPass>           m_DeferredLightingPass;
+    std::unique_ptr<LightClusteringPass>            m_LightClusteringPass;
+    std::shared_ptr<OcclusionCuller>                m_OcclusionCuller; // used by m_OpaqueDrawStrategy for the Gbuffer only
+    std::unique_ptr<GpuCullingPass>                 m_GpuCullingPass;
+    bool                                            m_GpuCullingDrawListValid = false; // cleared when the scene or the pass changes
+    bool                                            m_HiZValid = false; // the HiZ of m_RenderTargets holds the depth of the previous frame
     std::unique_ptr<SkyPass>                        m_SkyPass;
     std::unique_ptr<TemporalAntiAliasingPass>       m_TemporalAntiAliasingPass;
     std::unique_ptr<BloomPass>                      m_BloomPass;
     std::unique_ptr<ToneMappingPass>                m_ToneMappingPass;
     std::unique_ptr<SsaoPass>                       m_SsaoPass;
 
+    // Multi-threaded recording of the shadow and GBuffer passes
+    std::unique_ptr<tf::Executor>                   m_RecordingExecutor;
+    std::unique_ptr<ParallelViewRecorder>           m_ParallelRecorder;
+    bool                                            m_RecordingBenchmarkDone = false;
+
+    // Per-pass GPU timings
+    std::unique_ptr<GpuProfiler>                    m_GpuProfiler;
+
+    // Benchmark mode: the camera follows m_CameraPath with a fixed timestep, or the camera is recorded into it
+    CameraPath                                      m_CameraPath;
+    bool                                            m_CameraPathPlayback = false;
+    float                                           m_CameraPathTime = 0.f;
+    int                                             m_BenchmarkFrame = 0; // frames simulated since the loaded scene was handed to the simulation
+    int                                             m_BenchmarkFrameCount = 0; // warm-up and measured frames of a playback run
+    int                                             m_RenderBenchmarkFrame = -1; // m_BenchmarkFrame of the frame being rendered, -1 before the scene is loaded
+    bool                                            m_BenchmarkStatsReset = false;
+    uint64_t                                        m_GpuFrameStatsFrames = 0; // GPU profiler frames already recorded into the frame statistics
+
+    // Reflex latency telemetry, recorded into the device manager's frame statistics
+    uint64_t                                        m_LastReflexFrameID = 0;
+    bool                                            m_FrameStatisticsWritten = false;
+
     // RenderTargets
     std::unique_ptr<RenderTargets>                  m_RenderTargets;
 
@@ -183,6 +314,17 @@ private:
     FirstPersonCamera                               m_FirstPersonCamera;
     float                                           m_CameraVerticalFov = 60.f;
 
+    // Camera state of the simulated frame being rendered, published in CommitSimulation.
+    // m_FirstPersonCamera belongs to the simulation and may already be animating the next frame.
+    struct CameraSnapshot
+    {
+        affine3 worldToView = affine3::identity();
+        float3 position = 0.f;
+        float3 dir = float3(0.f, 0.f, 1.f);
+        float3 up = float3(0.f, 1.f, 0.f);
+    };
+    CameraSnapshot                                  m_RenderCamera;
+
     // UI
     UIData& m_ui;
     donut::math::int2                               m_DLSS_Last_DisplaySize = { 0,0 };
@@ -194,6 +336,8 @@ private:
     int2                                            m_DisplaySize;
     SLWrapper::DLSSSettings                         m_RecommendedDLSSSettings;
     std::default_random_engine                      m_Generator;
+    DynamicResolutionController                     m_DynamicResolution;
+    uint64_t                                        m_DynamicResolutionFrames = 0; // GPU profiler frames already fed to the controller
     float                                           m_PreviousLodBias;
     affine3                                         m_CameraPreviousMatrix;
 
@@ -214,6 +358,12 @@ public:
     // Functions of interest
     bool SetupView();
     void CreateRenderPasses(bool& exposureResetRequired, float lodBias);
+    void SubmitParallelRecording();
+    std::unique_ptr<InstancedOpaqueDrawStrategy> CreateOpaqueDrawStrategy() const;
+    void RunRecordingBenchmark();
+    void ApplySceneAnimations(bool leafProperties);
+    void RecordReflexLatency(const ReflexLatencyReport& report);
+    void WriteFrameStatistics();
     virtual void RenderScene(nvrhi::IFramebuffer* framebuffer) override;
 
     void SetBackBufferExtent(sl::Extent &backBufferExtent)
@@ -228,6 +378,7 @@ public:
     void SetCurrentSceneName(const std::string& sceneName);
     std::shared_ptr<ShaderFactory> GetShaderFactory() const { return m_ShaderFactory; };
     std::shared_ptr<donut::vfs::IFileSystem> GetRootFs() const { return m_RootFs; };
+    GpuProfiler* GetGpuProfiler() const { return m_GpuProfiler.get(); };
 
     virtual bool KeyboardUpdate(int key, int scancode, int action, int mods) override;
     virtual bool MousePosUpdate(double xpos, double ypos) override;
@@ -236,6 +387,8 @@ public:
     virtual void SetLatewarpOptions() override;
     virtual void Render(nvrhi::IFramebuffer* backBufferFramebuffer) override { RenderScene(backBufferFramebuffer); };
     virtual void Animate(float fElapsedTimeSeconds) override;
+    virtual bool AnimateOnSimulationThread() override { return true; }
+    virtual void CommitSimulation(uint32_t frameIndex) override;
     virtual void SceneUnloading() override;
     virtual bool LoadScene(std::shared_ptr<IFileSystem> fs, const std::filesystem::path& fileName) override;
     virtual void SceneLoaded() override;
@@ -290,6 +443,8 @@ struct MultiViewportApp : public ApplicationBase
             m_pViewports[uV]->m_pSample->Animate(fElapsedTimeSeconds);
         }
     }
+    virtual bool AnimateOnSimulationThread() override { return true; }
+    virtual void CommitSimulation(uint32_t frameIndex) override;
     virtual void SceneUnloading() override
     {
         m_pViewports[0]->m_pSample->SceneUnloading();
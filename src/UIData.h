@@ -69,6 +69,9 @@ struct UIData
     bool                                VisualiseBuffers = false;
     float                               CpuLoad = 0;
     int                                 GpuLoad = 0;
+    bool                                ParallelRecording = false;
+    bool                                PipelinedSimulation = false;
+    bool                                EnableGpuProfiler = true;
     donut::math::int2                   Resolution = { 0,0 };
     bool                                Resolution_changed = false;
     bool                                MouseOverUI = false;
@@ -106,6 +109,12 @@ public:
     // Shadows
     bool                                EnableShadows = true;
     float                               CsmExponent = 4.f;
+    bool                                ShadowCaching = true;
+
+    // Lighting and culling
+    bool                                ClusteredLighting = false;
+    bool                                OcclusionCulling = false;
+    bool                                GpuCulling = false;
 
     // DLSS specific parameters
     float                               DLSS_Sharpness = 0.f;
@@ -113,11 +122,14 @@ public:
     sl::DLSSMode                        DLSS_Mode = sl::DLSSMode::eOff;
     RenderingResolutionMode             DLSS_Resolution_Mode = RenderingResolutionMode::FIXED;
     bool                                DLSS_Dynamic_Res_change = true;
+    bool                                DLSS_Dynamic_Res_Auto = false;
+    float                               DLSS_Dynamic_Res_TargetMs = 16.6f;
     AntiAliasingMode                    DLSS_Last_AA = AntiAliasingMode::NONE;
     bool                                DLSS_DebugShowFullRenderingBuffer = false;
     bool                                DLSS_lodbias_useoveride = false;
     float                               DLSS_lodbias_overide = 0.f;
     bool                                DLSS_always_use_extents = false;
+    bool                                PooledRenderTargets = false;
     sl::DLSSPreset                      DLSS_presets[static_cast<int>(sl::DLSSMode::eCount)] = {};
     sl::DLSSPreset                      DLSS_last_presets[static_cast<int>(sl::DLSSMode::eCount)] = {};
     bool UIData::DLSSPresetsChanged()
@@ -520,7 +520,12 @@ protected:
 
                 if (m_ui.DLSS_Resolution_Mode == RenderingResolutionMode::DYNAMIC)
                 {
-                    if (ImGui::Button("Change Res"))
+                    ImGui::Checkbox("Auto: GPU Time Target", &m_ui.DLSS_Dynamic_Res_Auto);
+                    if (m_ui.DLSS_Dynamic_Res_Auto)
+                    {
+                        ImGui::SliderFloat("Target GPU Time (ms)", &m_ui.DLSS_Dynamic_Res_TargetMs, 2.f, 50.f);
+                    }
+                    else if (ImGui::Button("Change Res"))
                     {
                         m_ui.DLSS_Dynamic_Res_change = true;
                     }
@@ -528,6 +533,7 @@ protected:
 
                 ImGui::Checkbox("Debug: Show full input buffer", &m_ui.DLSS_DebugShowFullRenderingBuffer);
                 ImGui::Checkbox("Debug: Force Extent use", &m_ui.DLSS_always_use_extents);
+                ImGui::Checkbox("Pooled Render Targets", &m_ui.PooledRenderTargets);
 
                 ImGui::Checkbox("Overide LOD Bias", &m_ui.DLSS_lodbias_useoveride);
                 if (m_ui.DLSS_lodbias_useoveride) {
@@ -709,6 +715,75 @@ protected:
                 }
                 if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Repeats the Gbuffer pass an additional number of times");
 
+                // Parallel recording
+                if (GetDevice()->getGraphicsAPI() != nvrhi::GraphicsAPI::D3D11)
+                {
+                    ImGui::Checkbox("Parallel Command Recording", &m_ui.ParallelRecording);
+                    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Records the shadow and Gbuffer passes into multiple command lists on worker threads");
+                }
+
+                // Simulation thread
+                ImGui::Checkbox("Pipelined Simulation", &m_ui.PipelinedSimulation);
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Animates the next frame on a simulation thread while the current frame is rendered");
+
+                // GPU pass timings
+                ImGui::Checkbox("GPU Profiler", &m_ui.EnableGpuProfiler);
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Measures every render pass with timer queries, read back a few frames later");
+                if (m_ui.EnableGpuProfiler)
+                {
+                    GpuProfiler* profiler = m_app->GetGpuProfiler();
+
+                    std::vector<GpuProfiler::PassStats> passStats;
+                    profiler->GetPassStats(passStats);
+
+                    if (ImGui::BeginTable("##GpuPasses", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp))
+                    {
+                        ImGui::TableSetupColumn("Pass");
+                        ImGui::TableSetupColumn("Last");
+                        ImGui::TableSetupColumn("Avg");
+                        ImGui::TableSetupColumn("Min");
+                        ImGui::TableSetupColumn("P99");
+                        ImGui::TableHeadersRow();
+
+                        for (const auto& pass : passStats)
+                        {
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%*s%s", int(pass.depth) * 2, "", pass.name.c_str());
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%.3f", pass.lastMs);
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%.3f", pass.avgMs);
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%.3f", pass.minMs);
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%.3f", pass.p99Ms);
+                        }
+                        ImGui::EndTable();
+                    }
+
+                    ImGui::Text("Times in ms, dropped frames: %llu", (unsigned long long)profiler->GetNumDroppedFrames());
+
+                    if (ImGui::Button("Reset##GpuProfiler"))
+                        profiler->ResetStats();
+                    ImGui::SameLine();
+                    if (ImGui::Button("Save GPU Trace"))
+                    {
+                        if (profiler->WriteChromeTrace("gpu_trace.json"))
+                            donut::log::info("GPU trace saved to gpu_trace.json");
+                    }
+                    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Writes the recent frames in the Chrome trace format, open with chrome://tracing or Perfetto");
+                }
+
+#ifdef DONUT_WITH_CPU_PROFILER
+                if (ImGui::Button("Save CPU Trace"))
+                {
+                    if (donut::profiler::WriteChromeTrace("cpu_trace.json"))
+                        donut::log::info("CPU trace saved to cpu_trace.json");
+                }
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Writes the recent CPU profiler scopes of all threads in the Chrome trace format");
+#endif
+
                 ImGui::Separator();
                 ImGui::PushStyleColor(ImGuiCol_Text, TITLE_COL);
                 ImGui::Text("Debug visualisation");
@@ -735,6 +810,18 @@ protected:
                 }
 
                 ImGui::Checkbox("Enable Shadows", &m_ui.EnableShadows);
+                if (m_ui.EnableShadows)
+                {
+                    ImGui::Indent();
+                    ImGui::Checkbox("Cache Static Shadows", &m_ui.ShadowCaching);
+                    ImGui::Unindent();
+                }
+                ImGui::Checkbox("Clustered Lighting", &m_ui.ClusteredLighting);
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Shades every pixel with only the unshadowed lights that reach its cluster");
+                ImGui::Checkbox("CPU Occlusion Culling", &m_ui.OcclusionCulling);
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Skips the Gbuffer draws hidden behind the largest meshes, rasterized on the CPU");
+                ImGui::Checkbox("GPU Culling", &m_ui.GpuCulling);
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) ImGui::SetTooltip("Culls the Gbuffer draws on the GPU against the frustum and the depth of the previous frame,\nand draws them with one indirect call per material");
                 ImGui::Checkbox("Enable Tonemapping", &m_ui.EnableToneMapping);
                 if (m_ui.EnableToneMapping && ImGui::CollapsingHeader("ToneMapping Params"))
                 {
@@ -168,6 +168,10 @@ bool ProcessCommandLine(int argc, const char* const* argv, donut::app::DeviceCre
         {
             deviceParams.vsyncEnabled = true;
         }
+        else if (!_stricmp(argv[i], "-headless"))
+        {
+            deviceParams.headlessDevice = true;
+        }
         else if (!_stricmp(argv[i], "-sllog"))
         {
             enableSLlog = true;
@@ -276,7 +280,22 @@ int main(int __argc, const char* const* __argv)
 
     std::string windowTitle = "Streamline Sample (" + std::string(apiString) + ")";
 
-    if (!deviceManager->CreateWindowDeviceAndSwapChain(deviceParams, windowTitle.c_str()))
+    if (deviceParams.headlessDevice)
+    {
+        // Only the Vulkan device manager can run without a swap chain
+        if (api != nvrhi::GraphicsAPI::VULKAN)
+        {
+            donut::log::error("-headless requires Vulkan");
+            return 1;
+        }
+
+        if (!deviceManager->CreateHeadlessDevice(deviceParams))
+        {
+            donut::log::error("Cannot initialize a headless %s graphics device with the requested parameters", apiString);
+            return 1;
+        }
+    }
+    else if (!deviceManager->CreateWindowDeviceAndSwapChain(deviceParams, windowTitle.c_str()))
     {
         donut::log::error("Cannot initialize a %s graphics device with the requested parameters", apiString);
         return 1;
@@ -295,12 +314,16 @@ int main(int __argc, const char* const* __argv)
         uiData.Resolution = donut::math::int2{ (int)deviceParams.backBufferWidth, (int)deviceParams.backBufferHeight };
 
         std::shared_ptr<MultiViewportApp> pApp = std::make_shared<MultiViewportApp>(deviceManager, uiData, sceneName, scripting);
-        std::shared_ptr<UIRenderer> gui = std::make_shared<UIRenderer>(deviceManager, pApp->getASample(), uiData);
-
-        gui->Init(pApp->GetShaderFactory());
-
         deviceManager->AddRenderPassToBack(pApp.get());
-        deviceManager->AddRenderPassToBack(gui.get());
+
+        // Nobody sees the UI of a headless run, and it needs a window for its input
+        std::shared_ptr<UIRenderer> gui;
+        if (!deviceParams.headlessDevice)
+        {
+            gui = std::make_shared<UIRenderer>(deviceManager, pApp->getASample(), uiData);
+            gui->Init(pApp->GetShaderFactory());
+            deviceManager->AddRenderPassToBack(gui.get());
+        }
 
         deviceManager->RunMessageLoop();
     }